@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <list>
 #include <vector>
 #include <string.h>
 #include <stdio.h>
@@ -11,8 +13,10 @@
 #include "app_coco_detect.h"
 
 #include "app_camera_pipeline.hpp"
+#include "app_detect_tracker.h"
 
 #include "app_drawing_utils.h"
+#include "app_overlay.h"
 
 #include "app_ai_detect.h"
 
@@ -24,12 +28,11 @@ static const char *TAG = "app_ai_detect";
 
 #define DETECT_HEIGHT    240
 #define DETECT_WIDTH     240
-#define AI_BUFFER_COUNT  5            // Number of AI detection buffers
+#define FEED_ELEM_NUM    1            // Frames handed to the detector at once, it only gets the newest when idle
+#define DETECT_ELEM_NUM  3            // Result sets on their way from the detector to the tracker
 
 #define ALIGN_UP(num, align)    (((num) + ((align) - 1)) & ~((align) - 1))
 
-static esp_painter_handle_t painter = NULL;
-
 static pipeline_handle_t feed_pipeline;
 static pipeline_handle_t detect_pipeline;
 
@@ -39,30 +42,18 @@ static PedestrianDetect *ped_detect = NULL;
 static HumanFaceDetect *hum_detect = NULL;
 static COCODetect *coco_od_detect = NULL;
 
-static std::list<dl::detect::result_t> detect_results;
-
-/**
- * @brief Structure for managing AI detection buffers
- */
-typedef struct {
-    void *ai_buffers[AI_BUFFER_COUNT];        // Buffers for AI detection
-    size_t ai_buffer_size;                    // Size of each AI buffer
-    int current_ai_buffer_index;              // Index of the current buffer being used
-    bool ai_buffers_initialized;              // Flag to check if buffers are initialized
-} ai_detection_buffers_t;
-
-// Static instance of AI detection buffers
-static ai_detection_buffers_t ai_buffers = {
-    .ai_buffers = {nullptr},              // Initialize all buffer pointers to null
-    .ai_buffer_size = 0,                  // Initialize buffer size to 0
-    .current_ai_buffer_index = 0,         // Initialize current index to 0
-    .ai_buffers_initialized = false       // Initialize flag to false
-};
+// Frames seen by app_ai_detection_process_frame() and the objects tracked on them, owned by the UI task
+static uint32_t frame_sequence = 0;
+static app_detect_tracker_t tracker;
+static int tracker_mode = -1;
+static uint32_t tracker_mode_sequence = 0;
 
 void camera_dectect_task(void);
 
 esp_err_t app_ai_detect_init(void)
 {
+    size_t cache_line_size = 0;
+
     ESP_LOGI(TAG, "Initialize the AI detect");
     ped_detect = get_pedestrian_detect();
     assert(ped_detect != NULL);
@@ -73,86 +64,33 @@ esp_err_t app_ai_detect_init(void)
     coco_od_detect = get_coco_detect();
     assert(coco_od_detect != NULL);
 
-    // Initialize esp_painter
-    esp_painter_config_t painter_config = {
-        .canvas = {
-            .width = BSP_LCD_H_RES,
-            .height = BSP_LCD_V_RES
-        },
-        .color_format = ESP_PAINTER_COLOR_FORMAT_RGB565,
-        .default_font = &esp_painter_basic_font_20,
-        .swap_rgb565 = true
-        
-    };
-    ESP_ERROR_CHECK(esp_painter_init(&painter_config, &painter));
+    ESP_ERROR_CHECK(esp_cache_get_alignment(MALLOC_CAP_SPIRAM, &cache_line_size));
 
+    // The detector reads its own copy of a frame, the canvas is annotated and byte swapped for LVGL meanwhile
     camera_pipeline_cfg_t feed_cfg = {
-        .elem_num = 5,
+        .elem_num = FEED_ELEM_NUM,
         .elements = NULL,
-        .align_size = 1,
+        .align_size = (uint32_t)cache_line_size,
         .caps = MALLOC_CAP_SPIRAM,
-        .buffer_size = DETECT_WIDTH * DETECT_HEIGHT / 8,
+        .buffer_size = (uint32_t)ALIGN_UP(DETECT_WIDTH * DETECT_HEIGHT * 2, cache_line_size),
     };
+    ESP_ERROR_CHECK(camera_element_pipeline_new(&feed_cfg, &feed_pipeline));
 
-    camera_element_pipeline_new(&feed_cfg, &feed_pipeline);
-
+    // Results are stored in the elements, no buffer needed
     camera_pipeline_cfg_t detect_cfg = {
-        .elem_num = 5,
+        .elem_num = DETECT_ELEM_NUM,
         .elements = NULL,
         .align_size = 1,
-        .caps = MALLOC_CAP_SPIRAM,
-        .buffer_size = 20 * sizeof(int),
+        .caps = MALLOC_CAP_DEFAULT,
+        .buffer_size = 0,
     };
-    camera_element_pipeline_new(&detect_cfg, &detect_pipeline);
+    ESP_ERROR_CHECK(camera_element_pipeline_new(&detect_cfg, &detect_pipeline));
 
     xTaskCreatePinnedToCore((TaskFunction_t)camera_dectect_task, "Camera Detect", 1024 * 8, NULL, 5, &detect_task_handle, 1);
 
     return ESP_OK;
 }
 
-/**
- * @brief Initialize AI detection buffers
- * 
- * @param cache_line_size Size of cache line for alignment
- * @return ESP_OK on success, error code otherwise
- */
-esp_err_t app_ai_detection_init_buffers(size_t cache_line_size)
-{
-    esp_err_t ret = ESP_OK;
-    
-    // Calculate buffer size with alignment
-    ai_buffers.ai_buffer_size = ALIGN_UP(BSP_LCD_H_RES * BSP_LCD_V_RES * 2, cache_line_size);
-    
-    // Allocate buffers for AI detection
-    for (int i = 0; i < AI_BUFFER_COUNT; i++) {
-        ai_buffers.ai_buffers[i] = heap_caps_aligned_calloc(
-            cache_line_size, 1,
-            ai_buffers.ai_buffer_size,
-            MALLOC_CAP_SPIRAM
-        );
-        
-        if (ai_buffers.ai_buffers[i] == NULL) {
-            ESP_LOGE(TAG, "Failed to allocate AI detection buffer %d", i);
-            
-            // Clean up already allocated buffers
-            for (int j = 0; j < i; j++) {
-                if (ai_buffers.ai_buffers[j]) {
-                    heap_caps_free(ai_buffers.ai_buffers[j]);
-                    ai_buffers.ai_buffers[j] = NULL;
-                }
-            }
-            
-            return ESP_ERR_NO_MEM;
-        }
-    }
-    
-    ai_buffers.ai_buffers_initialized = true;
-    ai_buffers.current_ai_buffer_index = 0;
-    
-    ESP_LOGI(TAG, "AI detection buffers initialized successfully");
-    return ret;
-}
-
 /**
  * @brief Process frame for AI detection
  * 
@@ -164,94 +102,157 @@ esp_err_t app_ai_detection_init_buffers(size_t cache_line_size)
  */
 esp_err_t app_ai_detection_process_frame(uint8_t *detect_buf, uint32_t width, uint32_t height, int ai_detect_mode)
 {
-    if (!ai_buffers.ai_buffers_initialized) {
-        return ESP_ERR_INVALID_STATE;
-    }
-    
     esp_err_t ret = ESP_OK;
-    
-    // Get current AI buffer
-    void *current_ai_buffer = ai_buffers.ai_buffers[ai_buffers.current_ai_buffer_index];
-    
-    // First make a copy of the camera buffer as it may be released after this function returns
-    memcpy(current_ai_buffer, detect_buf, width * height * 2);
-    
+
+    frame_sequence++;
+
+    // Objects of the previous mode don't belong to this one
+    if (tracker_mode != ai_detect_mode) {
+        app_detect_tracker_reset(&tracker);
+        tracker_mode = ai_detect_mode;
+        tracker_mode_sequence = frame_sequence;
+    }
+
     // Submit buffer for AI detection
     if(ai_detect_mode == AI_DETECT_FACE) {
-        ret = app_humanface_ai_detect((uint16_t*)current_ai_buffer, (uint16_t*)detect_buf, width, height);
+        ret = app_humanface_ai_detect((uint16_t*)detect_buf, (uint16_t*)detect_buf, width, height);
         if (ret != ESP_OK) {
             ESP_LOGW(TAG, "Human face detection failed: 0x%x", ret);
         }
     } else if(ai_detect_mode == AI_DETECT_PEDESTRIAN) {
-        ret = app_pedestrian_ai_detect((uint16_t*)current_ai_buffer, (uint16_t*)detect_buf, width, height);
+        ret = app_pedestrian_ai_detect((uint16_t*)detect_buf, (uint16_t*)detect_buf, width, height);
         if (ret != ESP_OK) {
             ESP_LOGW(TAG, "Pedestrian detection failed: 0x%x", ret);
         }
     }
-    
-    // Move to next buffer in circular fashion
-    ai_buffers.current_ai_buffer_index = (ai_buffers.current_ai_buffer_index + 1) % AI_BUFFER_COUNT;
-    
+
     return ret;
 }
 
 /**
- * @brief Free AI detection buffers and resources
- * 
- * @return ESP_OK on success, error code otherwise
+ * @brief Keep the best results of a detection in an element, highest score first
  */
-esp_err_t app_ai_detection_deinit(void)
+static void camera_detect_store_results(camera_pipeline_buffer_element *element, const std::list<dl::detect::result_t> &results)
 {
-    if (!ai_buffers.ai_buffers_initialized) {
-        return ESP_OK; // Nothing to clean up
-    }
-    
-    // Free all allocated buffers
-    for (int i = 0; i < AI_BUFFER_COUNT; i++) {
-        if (ai_buffers.ai_buffers[i] != NULL) {
-            heap_caps_free(ai_buffers.ai_buffers[i]);
-            ai_buffers.ai_buffers[i] = NULL;
+    element->result_num = 0;
+
+    for (const auto& res : results) {
+        int pos = element->result_num;
+        while (pos > 0 && element->results[pos - 1].score < res.score) {
+            pos--;
+        }
+        if (pos >= CAMERA_PIPELINE_RESULT_MAX_NUM) {
+            continue;
+        }
+
+        int last = (element->result_num < CAMERA_PIPELINE_RESULT_MAX_NUM) ? element->result_num : CAMERA_PIPELINE_RESULT_MAX_NUM - 1;
+        memmove(&element->results[pos + 1], &element->results[pos], (last - pos) * sizeof(camera_pipeline_result_t));
+        if (element->result_num < CAMERA_PIPELINE_RESULT_MAX_NUM) {
+            element->result_num++;
+        }
+
+        camera_pipeline_result_t *dst = &element->results[pos];
+        dst->category = res.category;
+        dst->score = res.score;
+        memset(dst->box, 0, sizeof(dst->box));
+        for (int i = 0; i < 4 && i < (int)res.box.size(); i++) {
+            dst->box[i] = res.box[i];
+        }
+        dst->keypoint_num = (res.keypoint.size() < CAMERA_PIPELINE_KEYPOINT_MAX_NUM) ? res.keypoint.size() : CAMERA_PIPELINE_KEYPOINT_MAX_NUM;
+        for (int i = 0; i < dst->keypoint_num; i++) {
+            dst->keypoint[i] = res.keypoint[i];
         }
     }
-    
-    ai_buffers.ai_buffers_initialized = false;
-    
-    ESP_LOGI(TAG, "AI detection buffers freed successfully");
-    return ESP_OK;
 }
 
 void camera_dectect_task(void)
 {
     while (1) {        
         camera_pipeline_buffer_element *p = camera_pipeline_recv_element(feed_pipeline, portMAX_DELAY);
-        if (p && ui_extra_get_current_page() == UI_PAGE_AI_DETECT && ui_extra_is_ui_init()) {
-            if (ui_extra_get_ai_detect_mode() == AI_DETECT_PEDESTRIAN) {
-                detect_results = app_pedestrian_detect((uint16_t *)p->buffer, DETECT_WIDTH, DETECT_HEIGHT);
-            } else if (ui_extra_get_ai_detect_mode() == AI_DETECT_FACE) {
-                detect_results = app_humanface_detect((uint16_t *)p->buffer, DETECT_WIDTH, DETECT_HEIGHT);
-            }
+        if (!p) {
+            continue;
+        }
 
-            camera_pipeline_queue_element_index(feed_pipeline, p->index);
+        if (ui_extra_get_current_page() == UI_PAGE_AI_DETECT && ui_extra_is_ui_init()) {
+            std::list<dl::detect::result_t> results;
+            int mode = ui_extra_get_ai_detect_mode();
+
+            if (mode == AI_DETECT_PEDESTRIAN) {
+                results = app_pedestrian_detect((uint16_t *)p->buffer, DETECT_WIDTH, DETECT_HEIGHT);
+            } else if (mode == AI_DETECT_FACE) {
+                results = app_humanface_detect((uint16_t *)p->buffer, DETECT_WIDTH, DETECT_HEIGHT);
+            }
 
+            // The UI may still be reading older results, these go to another element
             camera_pipeline_buffer_element *element = camera_pipeline_get_queued_element(detect_pipeline);
             if (element) {
-                element->detect_results = &detect_results;
-
+                camera_detect_store_results(element, results);
+                element->sequence = p->sequence;
                 camera_pipeline_done_element(detect_pipeline, element);
             }
+
+            camera_pipeline_queue_element_index(feed_pipeline, p->index);
         } else {
+            camera_pipeline_queue_element_index(feed_pipeline, p->index);
             vTaskDelay(pdMS_TO_TICKS(50));
         }
-        vTaskDelay(pdMS_TO_TICKS(5));
     }
 }
 
+/**
+ * @brief Hand a frame to the detector when the tracker asks for one, and get the tracked objects on this frame
+ *
+ * The frame is only copied when the detector is idle. Detections update the tracker in the order of their frames,
+ * the boxes drawn are the tracks moved to the current frame, so they follow the objects between detections.
+ */
+static int camera_detect_exchange(const uint16_t *frame, int width, int height, camera_pipeline_result_t *results)
+{
+    if (app_detect_tracker_need_detect(&tracker, frame_sequence)) {
+        camera_pipeline_buffer_element *input_element = camera_pipeline_get_queued_element(feed_pipeline);
+        if (input_element) {
+            size_t size = width * height * sizeof(uint16_t);
+
+            if (size <= input_element->valid_size) {
+                memcpy(input_element->buffer, frame, size);
+                input_element->sequence = frame_sequence;
+                camera_pipeline_done_element(feed_pipeline, input_element);
+                app_detect_tracker_detect_started(&tracker, frame_sequence);
+            } else {
+                ESP_LOGW(TAG, "Frame %dx%d too large for the detector", width, height);
+                camera_pipeline_queue_element_index(feed_pipeline, input_element->index);
+            }
+        }
+    }
+
+    camera_pipeline_buffer_element *detect_element;
+    while ((detect_element = camera_pipeline_recv_element(detect_pipeline, 0)) != NULL) {
+        if ((int32_t)(detect_element->sequence - tracker_mode_sequence) >= 0) {
+            app_detect_tracker_update(&tracker, detect_element->results, detect_element->result_num, detect_element->sequence);
+        }
+        camera_pipeline_queue_element_index(detect_pipeline, detect_element->index);
+    }
+
+    return app_detect_tracker_predict(&tracker, frame_sequence, results, DETECT_TRACKER_MAX_NUM);
+}
+
 esp_err_t app_coco_od_detect(uint16_t *data, int width, int height)
 {
     ESP_LOGI(TAG, "Detecting COCO objects");
-    detect_results = app_coco_detect(data, width, height);
+    std::list<dl::detect::result_t> detect_results = app_coco_detect(data, width, height);
     if (detect_results.size() > 0) {
         uint16_t *rgb_buf = data;
+        // The album canvas is already byte swapped for LVGL
+        app_overlay_canvas_t canvas = {
+            .buffer = rgb_buf,
+            .width = width,
+            .height = height,
+            .swap = true,
+        };
+        const app_overlay_font_t font = {
+            .bitmap = esp_painter_basic_font_20.bitmap,
+            .width = esp_painter_basic_font_20.width,
+            .height = esp_painter_basic_font_20.height,
+        };
         for (const auto& res : detect_results) {
             const auto& box = res.box;
             
@@ -280,12 +281,10 @@ esp_err_t app_coco_od_detect(uint16_t *data, int width, int height)
                 int text_x = box[0] + 5;  // 5 pixels offset from left edge
                 int text_y = box[1] + 15; // 15 pixels offset from top edge
                 
-                // Use esp_painter to draw text
-                esp_painter_draw_string(painter, (uint8_t*)rgb_buf, 
-                                        width * height * 2,
-                                        text_x, text_y, NULL, 
-                                        ESP_PAINTER_COLOR_YELLOW, 
-                                        label);
+                // Yellow text over a half transparent black background, readable on any photo
+                app_overlay_draw_label(&canvas, text_x, text_y, &font, label,
+                                       app_overlay_color(&canvas, 255, 255, 0),
+                                       app_overlay_color(&canvas, 0, 0, 0), 128);
             }
         }
     }
@@ -294,38 +293,26 @@ esp_err_t app_coco_od_detect(uint16_t *data, int width, int height)
 
 esp_err_t app_humanface_ai_detect(uint16_t *detect_buf, uint16_t *draw_buf, int width, int height)
 {
-    // Process input frame
-    camera_pipeline_buffer_element *input_element = camera_pipeline_get_queued_element(feed_pipeline);
-    if (input_element) {
-        input_element->buffer = reinterpret_cast<uint16_t*>(detect_buf);
-        camera_pipeline_done_element(feed_pipeline, input_element);
-    }
-
-    // Get detection results
-    camera_pipeline_buffer_element *detect_element = camera_pipeline_recv_element(detect_pipeline, 0);
-    if (detect_element && detect_element->detect_results) {
+    camera_pipeline_result_t results[DETECT_TRACKER_MAX_NUM];
+    int result_num = camera_detect_exchange(detect_buf, width, height, results);
+    if (result_num > 0) {
         uint16_t *rgb_buf = draw_buf;
-        
-        // Add safety check for detect_results pointer
-        std::list<dl::detect::result_t> *results = detect_element->detect_results;
-        if (results && !results->empty()) {
-            for (const auto& res : *results) {
-                const auto& box = res.box;
-                // Add additional safety checks
-                if (box.size() >= 4 && std::any_of(box.begin(), box.end(), [](int v) { return v != 0; })) {
-                    draw_rectangle_rgb(rgb_buf, width, height,
-                                    box[0], box[1], box[2], box[3],
-                                    0, 0, 255, 0, 0, 5, false);
-
-                    if(res.keypoint.size() >= 10 && 
-                            std::any_of(res.keypoint.begin(), res.keypoint.end(), [](int v) { return v != 0; })) {
-                        draw_green_points(rgb_buf, res.keypoint, false);
-                    }
+
+        for (int i = 0; i < result_num; i++) {
+            const camera_pipeline_result_t &res = results[i];
+            const int *box = res.box;
+            if (std::any_of(box, box + 4, [](int v) { return v != 0; })) {
+                draw_rectangle_rgb(rgb_buf, width, height,
+                                box[0], box[1], box[2], box[3],
+                                0, 0, 255, 0, 0, 5, false);
+
+                if (res.keypoint_num >= 10 &&
+                        std::any_of(res.keypoint, res.keypoint + res.keypoint_num, [](int v) { return v != 0; })) {
+                    std::vector<int> keypoint(res.keypoint, res.keypoint + res.keypoint_num);
+                    draw_green_points(rgb_buf, keypoint, false);
                 }
             }
         }
-
-        camera_pipeline_queue_element_index(detect_pipeline, detect_element->index);
     }
 
     return ESP_OK;
@@ -333,34 +320,20 @@ esp_err_t app_humanface_ai_detect(uint16_t *detect_buf, uint16_t *draw_buf, int
 
 esp_err_t app_pedestrian_ai_detect(uint16_t *detect_buf, uint16_t *draw_buf, int width, int height)
 {
-    // Process input frame
-    camera_pipeline_buffer_element *input_element = camera_pipeline_get_queued_element(feed_pipeline);
-    if (input_element) {
-        input_element->buffer = reinterpret_cast<uint16_t*>(detect_buf);
-        camera_pipeline_done_element(feed_pipeline, input_element);
-    }
-
-    // Get detection results
-    camera_pipeline_buffer_element *detect_element = camera_pipeline_recv_element(detect_pipeline, 0);
-    if (detect_element && detect_element->detect_results) {
+    camera_pipeline_result_t results[DETECT_TRACKER_MAX_NUM];
+    int result_num = camera_detect_exchange(detect_buf, width, height, results);
+    if (result_num > 0) {
         uint16_t *rgb_buf = draw_buf;
-        
-        // Add safety check for detect_results pointer
-        std::list<dl::detect::result_t> *results = detect_element->detect_results;
-        if (results && !results->empty()) {
-            for (const auto& res : *results) {
-                const auto& box = res.box;
-                // Add additional safety checks
-                if (box.size() >= 4 && std::any_of(box.begin(), box.end(), [](int v) { return v != 0; })) {
-                    draw_rectangle_rgb(rgb_buf, width, height,
-                                    box[0], box[1], box[2], box[3],
-                                    0, 0, 255, 0, 0, 5, false);
-                }
+
+        for (int i = 0; i < result_num; i++) {
+            const int *box = results[i].box;
+            if (std::any_of(box, box + 4, [](int v) { return v != 0; })) {
+                draw_rectangle_rgb(rgb_buf, width, height,
+                                box[0], box[1], box[2], box[3],
+                                0, 0, 255, 0, 0, 5, false);
             }
         }
-    
-        camera_pipeline_queue_element_index(detect_pipeline, detect_element->index);
     }
 
     return ESP_OK;
-}
\ No newline at end of file
+}
@@ -13,16 +13,10 @@ extern "C" {
  */
 esp_err_t app_ai_detect_init(void);
 
-/**
- * @brief Initialize AI detection buffers
- * 
- * @param cache_line_size Size of cache line for alignment
- * @return ESP_OK on success, error code otherwise
- */
-esp_err_t app_ai_detection_init_buffers(size_t cache_line_size);
-
 /**
  * @brief Process frame for AI detection
+ *
+ * The frame is copied for the detector only when it is idle, the newest results are drawn on every frame.
  * 
  * @param detect_buf Buffer containing the frame to detect
  * @param width Frame width
@@ -32,13 +26,6 @@ esp_err_t app_ai_detection_init_buffers(size_t cache_line_size);
  */
 esp_err_t app_ai_detection_process_frame(uint8_t *detect_buf, uint32_t width, uint32_t height, int ai_detect_mode);
 
-/**
- * @brief Free AI detection buffers and resources
- * 
- * @return ESP_OK on success, error code otherwise
- */
-esp_err_t app_ai_detection_deinit(void);
-
 /**
  * @brief Run COCO object detection on input data
  * 
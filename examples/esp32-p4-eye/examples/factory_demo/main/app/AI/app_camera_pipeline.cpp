@@ -26,41 +26,80 @@
 
 static const char *TAG = "app_camera_pipeline";
 
+/**
+ * Ring of element indexes with one producer and one consumer. `head` is only written by the producer and
+ * `tail` only by the consumer, both count up without wrapping the index, so the ring is empty when they are equal.
+ */
+typedef struct {
+    uint32_t head;                          /*!< Number of indexes pushed */
+    uint32_t tail;                          /*!< Number of indexes popped */
+    uint32_t size;                          /*!< Number of slots */
+    uint16_t *slots;                        /*!< Element indexes */
+} camera_pipeline_ring_t;
+
 struct camera_pipeline_stream {
     bool started;                           /*!< Indicates whether the video stream has been started. */
     int elem_num;                           /*!< The number of element available for the stream. */
 
-    camera_pipeline_buffer_list_t queued_list; /*!< List of buffer elements that are currently queued for processing. */
-    camera_pipeline_buffer_list_t done_list;   /*!< List of buffer elements that have been processed and are done. */
+    camera_pipeline_ring_t queued_ring;     /*!< Buffer elements that are currently queued for processing, in order. */
+    camera_pipeline_ring_t done_ring;       /*!< Buffer elements that have been processed and are done, in order. */
 
     struct camera_pipeline_buffer_element *element; /*!< Pointer to the array of buffer elements used for storing image data. */
 
-    portMUX_TYPE stream_lock;              /*!< Mutex used for synchronizing access to the video stream's data structures. */
     SemaphoreHandle_t ready_sem;           /*!< Semaphore used for signaling when buffer elements are ready for processing. */
 };
 
+static bool IRAM_ATTR camera_pipeline_ring_push(camera_pipeline_ring_t *ring, uint16_t index)
+{
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail >= ring->size) {
+        return false;
+    }
+    ring->slots[head % ring->size] = index;
+    /* Publish the slot before the new head */
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static bool camera_pipeline_ring_pop(camera_pipeline_ring_t *ring, uint16_t *index)
+{
+    uint32_t tail = ring->tail;
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    if (head == tail) {
+        return false;
+    }
+    *index = ring->slots[tail % ring->size];
+    /* The slot may be written again once the new tail is seen */
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
 esp_err_t camera_element_pipeline_new(camera_pipeline_cfg_t *cfg, pipeline_handle_t *ret_item)
 {
     esp_err_t ret = ESP_OK;
     struct camera_pipeline_stream *stream = NULL;
 
-    ESP_GOTO_ON_FALSE(cfg && cfg->elem_num > 0, ESP_ERR_INVALID_ARG, err, TAG, "Invalid configuration: elem_num must be greater than 0.");
+    ESP_RETURN_ON_FALSE(cfg && cfg->elem_num > 0 && cfg->elem_num <= UINT16_MAX && ret_item, ESP_ERR_INVALID_ARG, TAG,
+                        "Invalid configuration: elem_num must be greater than 0.");
 
-    // stream = heap_caps_calloc(1, sizeof(struct camera_pipeline_stream), cfg->caps);
     stream = static_cast<camera_pipeline_stream*>(heap_caps_calloc(1, sizeof(camera_pipeline_stream), cfg->caps));
-    ESP_GOTO_ON_FALSE(stream, ESP_ERR_NO_MEM, err, TAG, "Failed to allocate memory for camera_pipeline_stream.");
-    memset(stream, 0, sizeof(struct camera_pipeline_stream));
+    ESP_RETURN_ON_FALSE(stream, ESP_ERR_NO_MEM, TAG, "Failed to allocate memory for camera_pipeline_stream.");
 
-    // stream->element = heap_caps_calloc(cfg->elem_num, sizeof(struct camera_pipeline_buffer_element), cfg->caps);
     stream->element = static_cast<camera_pipeline_buffer_element*>(
         heap_caps_calloc(cfg->elem_num, sizeof(camera_pipeline_buffer_element), cfg->caps)
     );
     ESP_GOTO_ON_FALSE(stream->element, ESP_ERR_NO_MEM, err, TAG, "Failed to allocate memory for camera_pipeline_buffer_element.");
 
-    SLIST_INIT(&stream->queued_list);
-    SLIST_INIT(&stream->done_list);
-
-    portMUX_INITIALIZE(&stream->stream_lock);
+    // Every element is in at most one ring at a time, so a ring never holds more than elem_num indexes
+    stream->queued_ring.size = cfg->elem_num;
+    stream->queued_ring.slots = static_cast<uint16_t*>(heap_caps_calloc(cfg->elem_num, sizeof(uint16_t), MALLOC_CAP_INTERNAL));
+    stream->done_ring.size = cfg->elem_num;
+    stream->done_ring.slots = static_cast<uint16_t*>(heap_caps_calloc(cfg->elem_num, sizeof(uint16_t), MALLOC_CAP_INTERNAL));
+    ESP_GOTO_ON_FALSE(stream->queued_ring.slots && stream->done_ring.slots, ESP_ERR_NO_MEM, err, TAG,
+                      "Failed to allocate memory for the rings.");
 
     stream->ready_sem = xSemaphoreCreateCounting(cfg->elem_num, 0);
     ESP_GOTO_ON_FALSE(stream->ready_sem, ESP_ERR_NO_MEM, err, TAG, "Failed to create done_sem for stream");
@@ -68,23 +107,23 @@ esp_err_t camera_element_pipeline_new(camera_pipeline_cfg_t *cfg, pipeline_handl
     for (int i = 0; i < cfg->elem_num; i++) {
         struct camera_pipeline_buffer_element *element = &stream->element[i];
 
-        if (!cfg->elements || !cfg->elements[i]) {
+        if (cfg->elements && cfg->elements[i]) {
+            element->buffer = static_cast<uint16_t*>(cfg->elements[i]);
+            element->internal = false;
+        } else if (cfg->buffer_size) {
             uint16_t* elements = static_cast<uint16_t*>(
                 heap_caps_aligned_calloc(cfg->align_size, 1, cfg->buffer_size, cfg->caps)
             );
             ESP_GOTO_ON_FALSE(elements, ESP_ERR_NO_MEM, err, TAG, "Failed to allocate memory for elements buffer %d.", i);
             element->buffer = elements;
             element->internal = true;
-        } else {
-            element->buffer = static_cast<uint16_t*>(cfg->elements[i]);
-            element->internal = false;
         }
 
         element->index = i;
         element->valid_size = cfg->buffer_size;
         ELEMENT_SET_FREE(element);
-        camera_pipeline_queue_element_index(stream, i);
         stream->elem_num++;
+        camera_pipeline_queue_element_index(stream, i);
         ESP_LOGI(TAG, "new elements[%d]:%p, internal:%d", i, element->buffer, element->internal);
     }
     ESP_LOGI(TAG, "new pipeline %p, elem_num:%d", stream, stream->elem_num);
@@ -93,23 +132,7 @@ esp_err_t camera_element_pipeline_new(camera_pipeline_cfg_t *cfg, pipeline_handl
     return ESP_OK;
 
 err:
-    for (int i = 0; i < stream->elem_num; i++) {
-        if (stream->element[i].internal) {
-            free(stream->element[i].buffer);
-        }
-    }
-
-    if (stream->ready_sem) {
-        vSemaphoreDelete(stream->ready_sem);
-    }
-    portEXIT_CRITICAL(&stream->stream_lock);
-
-    if (stream->element) {
-        free(stream->element);
-    }
-    if (stream) {
-        free(stream);
-    }
+    camera_element_pipeline_delete(stream);
     return ret;
 }
 
@@ -118,7 +141,7 @@ esp_err_t camera_element_pipeline_delete(pipeline_handle_t pipeline)
     struct camera_pipeline_stream *stream = (struct camera_pipeline_stream *)pipeline;
     ESP_RETURN_ON_FALSE(stream, ESP_ERR_INVALID_ARG, TAG, "Invalid pipeline handle");
 
-    for (int i = 0; i < stream->elem_num; i++) {
+    for (int i = 0; stream->element && i < stream->elem_num; i++) {
         if (stream->element[i].buffer && stream->element[i].internal) {
             free(stream->element[i].buffer);
         }
@@ -127,8 +150,9 @@ esp_err_t camera_element_pipeline_delete(pipeline_handle_t pipeline)
     if (stream->ready_sem) {
         vSemaphoreDelete(stream->ready_sem);
     }
-    portEXIT_CRITICAL(&stream->stream_lock);
 
+    free(stream->queued_ring.slots);
+    free(stream->done_ring.slots);
     free(stream->element);
     free(stream);
 
@@ -138,19 +162,19 @@ esp_err_t camera_element_pipeline_delete(pipeline_handle_t pipeline)
 esp_err_t camera_pipeline_queue_element(pipeline_handle_t pipline, struct camera_pipeline_buffer_element *element)
 {
     struct camera_pipeline_stream *stream = (struct camera_pipeline_stream *)pipline;
-    if (!stream) {
+    if (!stream || !element) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    portENTER_CRITICAL_SAFE(&stream->stream_lock);
     if (!ELEMENT_IS_FREE(element)) {
-        portEXIT_CRITICAL_SAFE(&stream->stream_lock);
         return ESP_ERR_INVALID_ARG;
     }
 
     ELEMENT_SET_ALLOCATED(element);
-    SLIST_INSERT_HEAD(&stream->queued_list, element, node);
-    portEXIT_CRITICAL_SAFE(&stream->stream_lock);
+    if (!camera_pipeline_ring_push(&stream->queued_ring, element->index)) {
+        ELEMENT_SET_FREE(element);
+        return ESP_ERR_INVALID_STATE;
+    }
 
     return ESP_OK;
 }
@@ -161,7 +185,7 @@ esp_err_t camera_pipeline_queue_element_index(pipeline_handle_t pipline, int ind
     struct camera_pipeline_buffer_element *element;
 
     struct camera_pipeline_stream *stream = (struct camera_pipeline_stream *)pipline;
-    if (!stream) {
+    if (!stream || index < 0 || index >= stream->elem_num) {
         return ESP_ERR_INVALID_ARG;
     }
 
@@ -174,19 +198,17 @@ esp_err_t camera_pipeline_queue_element_index(pipeline_handle_t pipline, int ind
 struct camera_pipeline_buffer_element *camera_pipeline_get_queued_element(pipeline_handle_t pipline)
 {
     struct camera_pipeline_buffer_element *element = NULL;
+    uint16_t index;
 
     struct camera_pipeline_stream *stream = (struct camera_pipeline_stream *)pipline;
     if (!stream) {
         return NULL;
     }
 
-    portENTER_CRITICAL_SAFE(&stream->stream_lock);
-    if (!SLIST_EMPTY(&stream->queued_list)) {
-        element = SLIST_FIRST(&stream->queued_list);
-        SLIST_REMOVE(&stream->queued_list, element, camera_pipeline_buffer_element, node);
+    if (camera_pipeline_ring_pop(&stream->queued_ring, &index)) {
+        element = ELEMENT_GET_BY_INDEX(stream, index);
         ELEMENT_SET_FREE(element);
     }
-    portEXIT_CRITICAL_SAFE(&stream->stream_lock);
 
     return element;
 }
@@ -194,19 +216,17 @@ struct camera_pipeline_buffer_element *camera_pipeline_get_queued_element(pipeli
 struct camera_pipeline_buffer_element *camera_pipeline_get_done_element(pipeline_handle_t pipline)
 {
     struct camera_pipeline_buffer_element *element = NULL;
+    uint16_t index;
 
     struct camera_pipeline_stream *stream = (struct camera_pipeline_stream *)pipline;
     if (!stream) {
         return NULL;
     }
 
-    portENTER_CRITICAL_SAFE(&stream->stream_lock);
-    if (!SLIST_EMPTY(&stream->done_list)) {
-        element = SLIST_FIRST(&stream->done_list);
-        SLIST_REMOVE(&stream->done_list, element, camera_pipeline_buffer_element, node);
+    if (camera_pipeline_ring_pop(&stream->done_ring, &index)) {
+        element = ELEMENT_GET_BY_INDEX(stream, index);
         ELEMENT_SET_FREE(element);
     }
-    portEXIT_CRITICAL_SAFE(&stream->stream_lock);
 
     return element;
 }
@@ -214,19 +234,19 @@ struct camera_pipeline_buffer_element *camera_pipeline_get_done_element(pipeline
 esp_err_t IRAM_ATTR camera_pipeline_done_element(pipeline_handle_t pipline, struct camera_pipeline_buffer_element *element)
 {
     struct camera_pipeline_stream *stream = (struct camera_pipeline_stream *)pipline;
-    if (!stream) {
+    if (!stream || !element) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    portENTER_CRITICAL_SAFE(&stream->stream_lock);
     if (!ELEMENT_IS_FREE(element)) {
-        portEXIT_CRITICAL_SAFE(&stream->stream_lock);
         return ESP_ERR_INVALID_ARG;
     }
 
     ELEMENT_SET_ALLOCATED(element);
-    SLIST_INSERT_HEAD(&stream->done_list, element, node);
-    portEXIT_CRITICAL_SAFE(&stream->stream_lock);
+    if (!camera_pipeline_ring_push(&stream->done_ring, element->index)) {
+        ELEMENT_SET_FREE(element);
+        return ESP_ERR_INVALID_STATE;
+    }
 
     if (xPortInIsrContext()) {
         BaseType_t wakeup = pdFALSE;
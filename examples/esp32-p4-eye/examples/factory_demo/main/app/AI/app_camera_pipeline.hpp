@@ -1,26 +1,12 @@
 #include <stdint.h>
 #include <stddef.h>
-#include <sys/queue.h>
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "pedestrian_detect.hpp"
-#include "esp_err.h"
 #include "linux/videodev2.h"
 
-/**
- * @brief Camera Image Recognition (IR) buffer element node type.
- *
- * Represents a single node in the singly linked list used for managing video buffer elements.
- */
-typedef SLIST_ENTRY(camera_pipeline_buffer_element) camera_pipeline_buffer_node_t;
-
-/**
- * @brief Camera Image Recognition (IR) buffer list type.
- *
- * A singly linked list that contains all the video buffer elements.
- */
-typedef SLIST_HEAD(camera_pipeline_buffer_list, camera_pipeline_buffer_element) camera_pipeline_buffer_list_t;
+#define CAMERA_PIPELINE_RESULT_MAX_NUM      (10)    /*!< Detection results kept by an element, the best scores first */
+#define CAMERA_PIPELINE_KEYPOINT_MAX_NUM    (10)    /*!< Keypoint coordinates kept by a result (x1, y1, ..., x5, y5) */
 
 /**
  * @brief Camera Image Recognition (IR) configuration structure.
@@ -32,30 +18,50 @@ typedef struct {
     void **elements;                                  /*!< Pointer to an array of elements buffers. */
     uint32_t align_size;                              /*!< Buffer align size in byte */
     uint32_t caps;                                    /*!< Memory allocation capabilities (e.g., SPIRAM, DRAM). */
-    uint32_t buffer_size;                             /*!< Size of each buffer in pixels. */
+    uint32_t buffer_size;                             /*!< Size of each buffer in bytes, 0 for elements without buffer. */
 } camera_pipeline_cfg_t;
 
+/**
+ * @brief Detection result stored in a buffer element.
+ *
+ * A copy of `dl::detect::result_t` with fixed capacity, so that the element owns its results.
+ */
+typedef struct {
+    int category;                                     /*!< Category of the object */
+    float score;                                      /*!< Confidence score */
+    int box[4];                                       /*!< Bounding box: x1, y1, x2, y2 */
+    int keypoint_num;                                 /*!< Number of valid values in keypoint */
+    int keypoint[CAMERA_PIPELINE_KEYPOINT_MAX_NUM];   /*!< Keypoint coordinates */
+} camera_pipeline_result_t;
+
 /**
  * @brief Camera Image Recognition (IR) buffer element object.
  *
  * This structure represents a video buffer element, which contains the buffer data and metadata
- * used for image recognition tasks.
+ * used for image recognition tasks. An element belongs to one side of the pipeline at a time,
+ * the side which got it is the only one to access it until it queues it or marks it done.
  */
 struct camera_pipeline_buffer_element {
     bool free;                                        /*!< Indicates if this element is currently free and available for use. */
     bool internal;                                    /*!< Indicates if this element is malloced by internal. */
-    camera_pipeline_buffer_node_t node;               /*!< List node used to link elements in the buffer list. */
     uint32_t index;                                   /*!< The index of this buffer element in the list. */
     uint16_t *buffer;                                  /*!< Pointer to the buffer space used to store data. */
 
     uint32_t valid_size;                              /*!< Valid data size */
-    std::list<dl::detect::result_t> *detect_results;   /*!< List of detection results */
+    uint32_t sequence;                                /*!< Number of the frame the element was filled from */
+    int result_num;                                   /*!< Number of valid results */
+    camera_pipeline_result_t results[CAMERA_PIPELINE_RESULT_MAX_NUM]; /*!< Detection results owned by this element */
 };
 
 /**
  * @brief Handle type for Camera Image Recognition (IR) pipeline.
  *
  * This type represents a handle to the camera IR pipeline, which is used to manage image recognition tasks.
+ *
+ * A pipeline has two queues of elements, both first in first out: the queued elements, free for the producer to
+ * fill, and the done elements, filled and waiting for the consumer. Each queue is a lock-free ring with a single
+ * task on each end: the producer task gets queued elements and marks them done, the consumer task receives the done
+ * elements and queues them back.
  */
 typedef void *pipeline_handle_t;
 
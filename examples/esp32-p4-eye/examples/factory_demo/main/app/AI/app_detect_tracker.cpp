@@ -0,0 +1,234 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "app_detect_tracker.h"
+
+#define TRACKER_IOU_MIN         (0.3f)      // Overlap for a detection to belong to a track
+#define TRACKER_ALPHA           (0.6f)      // Share of the position error corrected by a detection
+#define TRACKER_BETA            (0.2f)      // Share of the position error turned into velocity
+#define TRACKER_MAX_MISSES      (2)         // Detections missing a track before it is dropped
+#define TRACKER_PREDICT_MAX     (15)        // Frames a box may move past its last detection
+#define TRACKER_INTERVAL_MAX    (6)         // Frames between detections while the tracks are steady
+#define TRACKER_ERROR_LOW       (0.08f)     // Prediction error, relative to the box size, to detect less often
+#define TRACKER_ERROR_HIGH      (0.25f)     // Prediction error to detect every frame again
+
+static void track_box_at(const app_detect_track_t *track, uint32_t sequence, float *x, float *y)
+{
+    int32_t dt = (int32_t)(sequence - track->sequence);
+
+    if (dt < 0) {
+        dt = 0;
+    } else if (dt > TRACKER_PREDICT_MAX) {
+        dt = TRACKER_PREDICT_MAX;
+    }
+    *x = track->x + track->vx * dt;
+    *y = track->y + track->vy * dt;
+}
+
+static float box_iou(float ax, float ay, float aw, float ah, const int *box)
+{
+    float ix1 = fmaxf(ax - aw / 2, box[0]);
+    float iy1 = fmaxf(ay - ah / 2, box[1]);
+    float ix2 = fminf(ax + aw / 2, box[2]);
+    float iy2 = fminf(ay + ah / 2, box[3]);
+
+    if (ix2 <= ix1 || iy2 <= iy1) {
+        return 0;
+    }
+    float inter = (ix2 - ix1) * (iy2 - iy1);
+    float area = aw * ah + (float)(box[2] - box[0]) * (box[3] - box[1]);
+    return inter / (area - inter);
+}
+
+static void track_set_result(app_detect_track_t *track, const camera_pipeline_result_t *result, float cx, float cy)
+{
+    track->result = *result;
+    for (int i = 0; i + 1 < result->keypoint_num; i += 2) {
+        track->result.keypoint[i] = result->keypoint[i] - (int)lroundf(cx);
+        track->result.keypoint[i + 1] = result->keypoint[i + 1] - (int)lroundf(cy);
+    }
+}
+
+void app_detect_tracker_reset(app_detect_tracker_t *tracker)
+{
+    memset(tracker, 0, sizeof(*tracker));
+    tracker->interval = 1;
+}
+
+void app_detect_tracker_update(app_detect_tracker_t *tracker, const camera_pipeline_result_t *results, int result_num,
+                               uint32_t sequence)
+{
+    float pred_x[DETECT_TRACKER_MAX_NUM];
+    float pred_y[DETECT_TRACKER_MAX_NUM];
+    int track_match[DETECT_TRACKER_MAX_NUM];
+    int result_match[CAMERA_PIPELINE_RESULT_MAX_NUM];
+    bool changed = false;
+    float error = 0;
+
+    if (tracker->sequence && (int32_t)(sequence - tracker->sequence) <= 0) {
+        return;
+    }
+    tracker->sequence = sequence;
+    if (result_num > CAMERA_PIPELINE_RESULT_MAX_NUM) {
+        result_num = CAMERA_PIPELINE_RESULT_MAX_NUM;
+    }
+
+    for (int t = 0; t < tracker->track_num; t++) {
+        track_box_at(&tracker->tracks[t], sequence, &pred_x[t], &pred_y[t]);
+        track_match[t] = -1;
+    }
+    // Empty boxes are never tracked
+    for (int r = 0; r < result_num; r++) {
+        const int *box = results[r].box;
+        result_match[r] = (box[0] || box[1] || box[2] || box[3]) ? -1 : DETECT_TRACKER_MAX_NUM;
+    }
+
+    // Greedy association, the pair overlapping the most first
+    while (1) {
+        float best_iou = TRACKER_IOU_MIN;
+        int best_t = -1;
+        int best_r = -1;
+
+        for (int t = 0; t < tracker->track_num; t++) {
+            const app_detect_track_t *track = &tracker->tracks[t];
+            if (track_match[t] >= 0) {
+                continue;
+            }
+            for (int r = 0; r < result_num; r++) {
+                if (result_match[r] != -1 || results[r].category != track->result.category) {
+                    continue;
+                }
+                float iou = box_iou(pred_x[t], pred_y[t], track->w, track->h, results[r].box);
+                if (iou > best_iou) {
+                    best_iou = iou;
+                    best_t = t;
+                    best_r = r;
+                }
+            }
+        }
+        if (best_t < 0) {
+            break;
+        }
+        track_match[best_t] = best_r;
+        result_match[best_r] = best_t;
+    }
+
+    for (int t = 0; t < tracker->track_num; t++) {
+        app_detect_track_t *track = &tracker->tracks[t];
+        int r = track_match[t];
+
+        if (r < 0) {
+            track->misses++;
+            changed = true;
+            continue;
+        }
+
+        const int *box = results[r].box;
+        float mx = (box[0] + box[2]) / 2.0f;
+        float my = (box[1] + box[3]) / 2.0f;
+        float ex = mx - pred_x[t];
+        float ey = my - pred_y[t];
+        float dt = (float)(int32_t)(sequence - track->sequence);
+
+        if (dt < 1) {
+            dt = 1;
+        }
+        error = fmaxf(error, fmaxf(fabsf(ex) / fmaxf(track->w, 1), fabsf(ey) / fmaxf(track->h, 1)));
+
+        if (track->hits == 1) {
+            // First motion seen, take it as is
+            track->vx = (mx - track->x) / dt;
+            track->vy = (my - track->y) / dt;
+            track->x = mx;
+            track->y = my;
+        } else {
+            track->x = pred_x[t] + TRACKER_ALPHA * ex;
+            track->y = pred_y[t] + TRACKER_ALPHA * ey;
+            track->vx += TRACKER_BETA * ex / dt;
+            track->vy += TRACKER_BETA * ey / dt;
+        }
+        track->w += TRACKER_ALPHA * ((box[2] - box[0]) - track->w);
+        track->h += TRACKER_ALPHA * ((box[3] - box[1]) - track->h);
+        track->sequence = sequence;
+        track->hits++;
+        track->misses = 0;
+        track_set_result(track, &results[r], mx, my);
+    }
+
+    // Drop the tracks lost for too long
+    int kept = 0;
+    for (int t = 0; t < tracker->track_num; t++) {
+        if (tracker->tracks[t].misses <= TRACKER_MAX_MISSES) {
+            tracker->tracks[kept++] = tracker->tracks[t];
+        }
+    }
+    tracker->track_num = kept;
+
+    // New objects
+    for (int r = 0; r < result_num && tracker->track_num < DETECT_TRACKER_MAX_NUM; r++) {
+        if (result_match[r] != -1) {
+            continue;
+        }
+
+        app_detect_track_t *track = &tracker->tracks[tracker->track_num++];
+        const int *box = results[r].box;
+
+        memset(track, 0, sizeof(*track));
+        track->id = tracker->next_id++;
+        track->x = (box[0] + box[2]) / 2.0f;
+        track->y = (box[1] + box[3]) / 2.0f;
+        track->w = box[2] - box[0];
+        track->h = box[3] - box[1];
+        track->sequence = sequence;
+        track->hits = 1;
+        track_set_result(track, &results[r], track->x, track->y);
+        changed = true;
+    }
+
+    if (changed || error > TRACKER_ERROR_HIGH) {
+        tracker->interval = 1;
+    } else if (error < TRACKER_ERROR_LOW && tracker->interval < TRACKER_INTERVAL_MAX) {
+        tracker->interval++;
+    }
+}
+
+int app_detect_tracker_predict(const app_detect_tracker_t *tracker, uint32_t sequence, camera_pipeline_result_t *results,
+                               int max_num)
+{
+    int num = 0;
+
+    for (int t = 0; t < tracker->track_num && num < max_num; t++) {
+        const app_detect_track_t *track = &tracker->tracks[t];
+        camera_pipeline_result_t *res = &results[num++];
+        float x, y;
+
+        track_box_at(track, sequence, &x, &y);
+        *res = track->result;
+        res->box[0] = (int)lroundf(x - track->w / 2);
+        res->box[1] = (int)lroundf(y - track->h / 2);
+        res->box[2] = (int)lroundf(x + track->w / 2);
+        res->box[3] = (int)lroundf(y + track->h / 2);
+        for (int i = 0; i + 1 < res->keypoint_num; i += 2) {
+            res->keypoint[i] += (int)lroundf(x);
+            res->keypoint[i + 1] += (int)lroundf(y);
+        }
+    }
+
+    return num;
+}
+
+bool app_detect_tracker_need_detect(const app_detect_tracker_t *tracker, uint32_t sequence)
+{
+    return (int32_t)(sequence - tracker->feed_sequence) >= tracker->interval;
+}
+
+void app_detect_tracker_detect_started(app_detect_tracker_t *tracker, uint32_t sequence)
+{
+    tracker->feed_sequence = sequence;
+}
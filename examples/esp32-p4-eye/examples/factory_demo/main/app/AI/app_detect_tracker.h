@@ -0,0 +1,97 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "app_camera_pipeline.hpp"
+
+#define DETECT_TRACKER_MAX_NUM      (CAMERA_PIPELINE_RESULT_MAX_NUM)   /*!< Objects tracked at once */
+
+/**
+ * @brief An object followed across frames
+ *
+ * Positions are in pixels and velocities in pixels per frame, times are frame sequence numbers.
+ */
+typedef struct {
+    int id;                                 /*!< Identifier, kept while the object is tracked */
+    float x;                                /*!< Center X, filtered, at `sequence` */
+    float y;                                /*!< Center Y, filtered, at `sequence` */
+    float w;                                /*!< Width, filtered */
+    float h;                                /*!< Height, filtered */
+    float vx;                               /*!< Velocity along X */
+    float vy;                               /*!< Velocity along Y */
+    uint32_t sequence;                      /*!< Frame of the last detection matched */
+    int hits;                               /*!< Detections matched */
+    int misses;                             /*!< Detections in a row that missed the object */
+    camera_pipeline_result_t result;        /*!< Last detection, keypoints relative to the center */
+} app_detect_track_t;
+
+/**
+ * @brief Boxes of a detector followed across frames
+ *
+ * Detections are associated with the tracks by IoU against the positions predicted for their frame, then a constant
+ * velocity (alpha-beta) filter smooths each track. Between detections, boxes are extrapolated to the frame drawn.
+ * While the predictions match the detections, frames are handed to the detector less often.
+ */
+typedef struct {
+    int track_num;                                      /*!< Number of valid tracks */
+    app_detect_track_t tracks[DETECT_TRACKER_MAX_NUM];  /*!< Tracks */
+    int next_id;                                        /*!< Identifier of the next track */
+    uint32_t sequence;                                  /*!< Frame of the last update */
+    uint32_t feed_sequence;                             /*!< Frame last handed to the detector */
+    int interval;                                       /*!< Frames between two frames handed to the detector */
+} app_detect_tracker_t;
+
+/**
+ * @brief Forget all tracks, e.g. when the detector changes
+ *
+ * @param tracker Tracker
+ */
+void app_detect_tracker_reset(app_detect_tracker_t *tracker);
+
+/**
+ * @brief Update the tracks with the results of a detection
+ *
+ * @param tracker Tracker
+ * @param results Detection results
+ * @param result_num Number of results
+ * @param sequence Frame the detection ran on, results older than the last update are ignored
+ */
+void app_detect_tracker_update(app_detect_tracker_t *tracker, const camera_pipeline_result_t *results, int result_num,
+                               uint32_t sequence);
+
+/**
+ * @brief Get the boxes of the tracks at a frame
+ *
+ * @param tracker Tracker
+ * @param sequence Frame to draw
+ * @param results Boxes and keypoints at that frame
+ * @param max_num Size of `results`
+ *
+ * @return Number of results
+ */
+int app_detect_tracker_predict(const app_detect_tracker_t *tracker, uint32_t sequence, camera_pipeline_result_t *results,
+                               int max_num);
+
+/**
+ * @brief Check if a frame should be handed to the detector
+ *
+ * @param tracker Tracker
+ * @param sequence Frame
+ *
+ * @return true if enough frames went by since the last one handed to the detector
+ */
+bool app_detect_tracker_need_detect(const app_detect_tracker_t *tracker, uint32_t sequence);
+
+/**
+ * @brief Record that a frame was handed to the detector
+ *
+ * @param tracker Tracker
+ * @param sequence Frame
+ */
+void app_detect_tracker_detect_started(app_detect_tracker_t *tracker, uint32_t sequence);
@@ -0,0 +1,208 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include "app_overlay.h"
+
+#define MIN(a, b)   ((a) < (b) ? (a) : (b))
+#define MAX(a, b)   ((a) > (b) ? (a) : (b))
+
+#define LABEL_PADDING       (2)
+#define BLEND_ROUND         (0x02008010)    /* Half of the last bit of each component, once multiplied by 32 */
+
+typedef uint32_t __attribute__((__may_alias__)) overlay_pair_t;
+
+static inline uint16_t swap16(uint16_t color)
+{
+    return (color >> 8) | (color << 8);
+}
+
+/* Clip a rectangle to the canvas, false if nothing is left */
+static inline bool overlay_clip(const app_overlay_canvas_t *canvas, int *x1, int *y1, int *x2, int *y2)
+{
+    *x1 = MAX(*x1, 0);
+    *y1 = MAX(*y1, 0);
+    *x2 = MIN(*x2, canvas->width - 1);
+    *y2 = MIN(*y2, canvas->height - 1);
+    return *x1 <= *x2 && *y1 <= *y2;
+}
+
+uint16_t app_overlay_color(const app_overlay_canvas_t *canvas, uint8_t r, uint8_t g, uint8_t b)
+{
+    uint16_t color = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+    return canvas->swap ? swap16(color) : color;
+}
+
+static inline void overlay_fill_span(uint16_t *dst, int num, uint16_t color)
+{
+    if (num <= 0) {
+        return;
+    }
+    if ((uintptr_t)dst & 2) {
+        *dst++ = color;
+        num--;
+    }
+
+    overlay_pair_t pair = color | ((uint32_t)color << 16);
+    overlay_pair_t *words = (overlay_pair_t *)dst;
+    for (int i = 0; i < num / 2; i++) {
+        words[i] = pair;
+    }
+    if (num & 1) {
+        dst[num - 1] = color;
+    }
+}
+
+/* Rectangle already clipped */
+static inline void overlay_fill(const app_overlay_canvas_t *canvas, int x1, int y1, int x2, int y2, uint16_t color)
+{
+    uint16_t *row = canvas->buffer + y1 * canvas->width + x1;
+    for (int y = y1; y <= y2; y++, row += canvas->width) {
+        overlay_fill_span(row, x2 - x1 + 1, color);
+    }
+}
+
+void app_overlay_fill_span(uint16_t *dst, int num, uint16_t color)
+{
+    overlay_fill_span(dst, num, color);
+}
+
+void app_overlay_fill_rect(const app_overlay_canvas_t *canvas, int x1, int y1, int x2, int y2, uint16_t color)
+{
+    if (overlay_clip(canvas, &x1, &y1, &x2, &y2)) {
+        overlay_fill(canvas, x1, y1, x2, y2, color);
+    }
+}
+
+void app_overlay_draw_rect(const app_overlay_canvas_t *canvas, int x1, int y1, int x2, int y2, int thickness,
+                           uint16_t color)
+{
+    if (thickness <= 0 || !overlay_clip(canvas, &x1, &y1, &x2, &y2)) {
+        return;
+    }
+
+    /* Top and bottom borders are whole spans, a flat box is all border */
+    int top = MIN(y1 + thickness, y2 + 1);
+    int bottom = MAX(y2 - thickness, top - 1);
+    overlay_fill(canvas, x1, y1, x2, top - 1, color);
+    overlay_fill(canvas, x1, bottom + 1, x2, y2, color);
+    if (top > bottom) {
+        return;
+    }
+    if (2 * thickness >= x2 - x1 + 1) {
+        overlay_fill(canvas, x1, top, x2, bottom, color);
+        return;
+    }
+
+    /* Left and right borders, between them, a few pixels of each row */
+    uint16_t *row = canvas->buffer + top * canvas->width;
+    for (int y = top; y <= bottom; y++, row += canvas->width) {
+        for (int t = 0; t < thickness; t++) {
+            row[x1 + t] = color;
+            row[x2 - t] = color;
+        }
+    }
+}
+
+void app_overlay_blend_rect(const app_overlay_canvas_t *canvas, int x1, int y1, int x2, int y2, uint16_t color,
+                            uint8_t alpha)
+{
+    if (alpha == 0 || !overlay_clip(canvas, &x1, &y1, &x2, &y2)) {
+        return;
+    }
+    if (alpha == 255) {
+        app_overlay_fill_rect(canvas, x1, y1, x2, y2, color);
+        return;
+    }
+
+    /* With green moved to the upper half, the three components are blended by one multiply, 5 bit alpha */
+    uint32_t a = (alpha + 4) >> 3;
+    uint16_t native = canvas->swap ? swap16(color) : color;
+    uint32_t fg = ((native | ((uint32_t)native << 16)) & 0x07E0F81F) * a;
+
+    for (int y = y1; y <= y2; y++) {
+        uint16_t *row = canvas->buffer + y * canvas->width;
+        for (int x = x1; x <= x2; x++) {
+            uint16_t pixel = canvas->swap ? swap16(row[x]) : row[x];
+            uint32_t bg = (pixel | ((uint32_t)pixel << 16)) & 0x07E0F81F;
+            uint32_t mix = ((bg * (32 - a) + fg + BLEND_ROUND) >> 5) & 0x07E0F81F;
+            pixel = (uint16_t)(mix | (mix >> 16));
+            row[x] = canvas->swap ? swap16(pixel) : pixel;
+        }
+    }
+}
+
+int app_overlay_draw_text(const app_overlay_canvas_t *canvas, int x, int y, const app_overlay_font_t *font,
+                          const char *text, uint16_t color)
+{
+    int row_bytes = (font->width + 7) / 8;
+
+    for (; *text; text++, x += font->width) {
+        unsigned char c = *text;
+        if (c < 32 || c > 126) {
+            continue;
+        }
+        if (x >= canvas->width) {
+            break;
+        }
+        if (x + font->width <= 0) {
+            continue;
+        }
+
+        const uint8_t *glyph = font->bitmap + (c - 32) * font->height * row_bytes;
+        int dx_min = MAX(0, -x);
+        int dx_max = MIN(font->width, canvas->width - x);
+        for (int dy = MAX(0, -y); dy < font->height && y + dy < canvas->height; dy++) {
+            const uint8_t *bits = glyph + dy * row_bytes;
+            uint16_t *row = canvas->buffer + (y + dy) * canvas->width + x;
+
+            /* Runs of set bits are filled as spans */
+            int dx = dx_min;
+            while (dx < dx_max) {
+                if (!(bits[dx / 8] & (0x80 >> (dx % 8)))) {
+                    dx++;
+                    continue;
+                }
+                int start = dx;
+                while (dx < dx_max && (bits[dx / 8] & (0x80 >> (dx % 8)))) {
+                    dx++;
+                }
+                app_overlay_fill_span(row + start, dx - start, color);
+            }
+        }
+    }
+
+    return x;
+}
+
+void app_overlay_draw_label(const app_overlay_canvas_t *canvas, int x, int y, const app_overlay_font_t *font,
+                            const char *text, uint16_t color, uint16_t bg_color, uint8_t bg_alpha)
+{
+    int width = strlen(text) * font->width;
+
+    app_overlay_blend_rect(canvas, x - LABEL_PADDING, y - LABEL_PADDING, x + width + LABEL_PADDING - 1,
+                           y + font->height + LABEL_PADDING - 1, bg_color, bg_alpha);
+    app_overlay_draw_text(canvas, x, y, font, text, color);
+}
+
+void app_overlay_swap_bytes(uint16_t *buffer, size_t pixel_count)
+{
+    if (pixel_count && ((uintptr_t)buffer & 2)) {
+        *buffer = swap16(*buffer);
+        buffer++;
+        pixel_count--;
+    }
+
+    overlay_pair_t *words = (overlay_pair_t *)buffer;
+    for (size_t i = 0; i < pixel_count / 2; i++) {
+        uint32_t w = words[i];
+        words[i] = ((w & 0x00FF00FF) << 8) | ((w >> 8) & 0x00FF00FF);
+    }
+    if (pixel_count & 1) {
+        buffer[pixel_count - 1] = swap16(buffer[pixel_count - 1]);
+    }
+}
@@ -0,0 +1,107 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief RGB565 buffer drawn on
+ *
+ * Coordinates are inclusive and clipped to the buffer. With `swap`, the buffer holds byte swapped RGB565, as LVGL
+ * with `LV_COLOR_16_SWAP`, and colors are given in that order too.
+ */
+typedef struct {
+    uint16_t *buffer;                   /*!< Pixels */
+    int width;                          /*!< Width in pixels, also the stride */
+    int height;                         /*!< Height in pixels */
+    bool swap;                          /*!< Buffer is byte swapped */
+} app_overlay_canvas_t;
+
+/**
+ * @brief 1 bit per pixel font, laid out as `esp_painter_basic_font_t`: ASCII 32 to 126, rows of whole bytes
+ */
+typedef struct {
+    const uint8_t *bitmap;              /*!< Glyphs, MSB first */
+    uint16_t width;                     /*!< Glyph width */
+    uint16_t height;                    /*!< Glyph height */
+} app_overlay_font_t;
+
+/**
+ * @brief Get a color in the byte order of a canvas
+ *
+ * @param canvas Canvas
+ * @param r Red component (0-255)
+ * @param g Green component (0-255)
+ * @param b Blue component (0-255)
+ *
+ * @return Color to pass to the other functions
+ */
+uint16_t app_overlay_color(const app_overlay_canvas_t *canvas, uint8_t r, uint8_t g, uint8_t b);
+
+/**
+ * @brief Fill pixels of a row, two at a time
+ *
+ * @param dst First pixel
+ * @param num Number of pixels
+ * @param color Color in the byte order of the buffer
+ */
+void app_overlay_fill_span(uint16_t *dst, int num, uint16_t color);
+
+/**
+ * @brief Fill a rectangle
+ */
+void app_overlay_fill_rect(const app_overlay_canvas_t *canvas, int x1, int y1, int x2, int y2, uint16_t color);
+
+/**
+ * @brief Draw the outline of a rectangle
+ *
+ * The rectangle is clipped first, so a box partly out of the canvas is closed by its edge. The borders are
+ * `thickness` pixels wide, inside of the rectangle.
+ */
+void app_overlay_draw_rect(const app_overlay_canvas_t *canvas, int x1, int y1, int x2, int y2, int thickness,
+                           uint16_t color);
+
+/**
+ * @brief Blend a color over a rectangle
+ *
+ * @param alpha Opacity of `color`, 0 to 255
+ */
+void app_overlay_blend_rect(const app_overlay_canvas_t *canvas, int x1, int y1, int x2, int y2, uint16_t color,
+                            uint8_t alpha);
+
+/**
+ * @brief Draw text on one line, characters out of the font are skipped
+ *
+ * @return X coordinate after the text
+ */
+int app_overlay_draw_text(const app_overlay_canvas_t *canvas, int x, int y, const app_overlay_font_t *font,
+                          const char *text, uint16_t color);
+
+/**
+ * @brief Draw text over a blended background, 2 pixels larger on each side
+ *
+ * @param bg_alpha Opacity of the background, 0 to 255
+ */
+void app_overlay_draw_label(const app_overlay_canvas_t *canvas, int x, int y, const app_overlay_font_t *font,
+                            const char *text, uint16_t color, uint16_t bg_color, uint8_t bg_alpha);
+
+/**
+ * @brief Swap the bytes of RGB565 pixels, two at a time
+ *
+ * @param buffer Pixels
+ * @param pixel_count Number of pixels
+ */
+void app_overlay_swap_bytes(uint16_t *buffer, size_t pixel_count);
+
+#ifdef __cplusplus
+}
+#endif
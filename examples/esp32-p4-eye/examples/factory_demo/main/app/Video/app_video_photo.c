@@ -4,6 +4,7 @@
 #include "esp_log.h"
 #include "esp_sleep.h"
 #include "esp_timer.h"
+#include "esp_heap_caps.h"
 #include "esp_private/esp_cache_private.h"
 #include "driver/ppa.h"
 #include "driver/jpeg_encode.h"
@@ -16,6 +17,7 @@
 #include "app_album.h"
 #include "app_video_utils.h"
 #include "app_video_photo.h"
+#include "app_thumbnail.h"
 
 static const char *TAG = "app_video_photo";
 
@@ -25,6 +27,7 @@ static const char *TAG = "app_video_photo";
 #define CROP_PHOTO_WIDTH        1280
 #define CROP_PHOTO_HEIGHT       960
 #define JPEG_PHOTO_QUALITY      90            // JPEG quality setting
+#define JPEG_THUMB_QUALITY      80            // JPEG quality of the album thumbnail
 
 /* Static variables */
 static size_t data_cache_line_size = 0;
@@ -39,6 +42,9 @@ static uint32_t photo_buf_size = 0;             // Size of shared buffer
 static uint8_t *jpg_buf = NULL;
 static uint32_t rx_buffer_size = 0;
 static uint32_t jpg_size = 0;
+static uint8_t *thumb_buf = NULL;               // Album thumbnail, RGB565 at the size of the LCD
+static uint8_t *thumb_jpg_buf = NULL;
+static size_t thumb_jpg_buf_size = 0;
 
 static int video_fd = -1;
 static TaskHandle_t interval_sleep_task_handle = NULL;
@@ -47,6 +53,7 @@ static TaskHandle_t interval_sleep_task_handle = NULL;
 static void enter_deep_sleep(uint16_t sleep_minutes);
 static void interval_sleep_task(void *pvParameters);
 static void interval_photo_complete_callback(void);
+static uint32_t encode_thumbnail(uint8_t *pic_buf, uint32_t width, uint32_t height);
 
 /* Public function implementations */
 
@@ -76,6 +83,22 @@ esp_err_t app_video_photo_init(void)
     }
     ESP_LOGI(TAG, "Using shared photo buffer: %lu bytes", photo_buf_size);
 
+    // Thumbnail buffers, a picture is saved without thumbnail if they are missing
+    if (thumb_buf == NULL) {
+        thumb_buf = heap_caps_aligned_calloc(data_cache_line_size, 1,
+                                             ALIGN_UP(BSP_LCD_H_RES * BSP_LCD_V_RES * 2, data_cache_line_size),
+                                             MALLOC_CAP_SPIRAM);
+    }
+    if (thumb_jpg_buf == NULL) {
+        jpeg_encode_memory_alloc_cfg_t thumb_mem_cfg = {
+            .buffer_direction = JPEG_DEC_ALLOC_OUTPUT_BUFFER,
+        };
+        thumb_jpg_buf = jpeg_alloc_encoder_mem(APP_THUMBNAIL_MAX_SIZE, &thumb_mem_cfg, &thumb_jpg_buf_size);
+    }
+    if (thumb_buf == NULL || thumb_jpg_buf == NULL) {
+        ESP_LOGW(TAG, "Failed to allocate thumbnail buffers, pictures are saved without thumbnail");
+    }
+
     return ESP_OK;
 }
 
@@ -202,8 +225,9 @@ esp_err_t take_and_save_photo(uint8_t *camera_buf, uint32_t width, uint32_t heig
         goto cleanup;
     }
 
-    // Save the picture
-    ret = app_storage_save_picture(jpg_buf, jpg_size);
+    // Save the picture with the thumbnail shown by the album
+    uint32_t thumb_size = encode_thumbnail(pic_buf, photo_width, photo_height);
+    ret = app_storage_save_picture(jpg_buf, jpg_size, thumb_size ? thumb_jpg_buf : NULL, thumb_size);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to save picture: 0x%x", ret);
     } else {
@@ -240,12 +264,60 @@ esp_err_t app_video_photo_deinit(void)
     photo_buf = NULL;
     photo_buf_size = 0;
 
+    if (thumb_buf) {
+        free(thumb_buf);
+        thumb_buf = NULL;
+    }
+    if (thumb_jpg_buf) {
+        free(thumb_jpg_buf);
+        thumb_jpg_buf = NULL;
+        thumb_jpg_buf_size = 0;
+    }
+
     ESP_LOGI(TAG, "Photo module deinitialized");
     return ESP_OK;
 }
 
 /* Private function implementations */
 
+/**
+ * @brief Encode the album thumbnail of a photo
+ *
+ * The thumbnail is the square the album crops from the photo, scaled to the size of the LCD.
+ *
+ * @param pic_buf Photo in RGB565 format
+ * @param width Photo width
+ * @param height Photo height
+ * @return Size of the thumbnail JPEG in thumb_jpg_buf, 0 if there is none
+ */
+static uint32_t encode_thumbnail(uint8_t *pic_buf, uint32_t width, uint32_t height)
+{
+    uint32_t crop_size = app_album_get_crop_size(width, height);
+    uint32_t thumb_size = 0;
+
+    if (thumb_buf == NULL || thumb_jpg_buf == NULL || crop_size == 0) {
+        return 0;
+    }
+
+    esp_err_t ret = app_image_process_scale_crop(
+        pic_buf, width, height,
+        crop_size, crop_size,
+        thumb_buf, BSP_LCD_H_RES, BSP_LCD_V_RES,
+        ALIGN_UP(BSP_LCD_H_RES * BSP_LCD_V_RES * 2, data_cache_line_size),
+        PPA_SRM_ROTATION_ANGLE_0
+    );
+    if (ret == ESP_OK) {
+        ret = app_image_encode_jpeg(thumb_buf, BSP_LCD_H_RES, BSP_LCD_V_RES, JPEG_THUMB_QUALITY,
+                                    thumb_jpg_buf, thumb_jpg_buf_size, &thumb_size);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to make the thumbnail: 0x%x", ret);
+        return 0;
+    }
+
+    return thumb_size;
+}
+
 /**
  * @brief Enter deep sleep mode for interval photography
  * 
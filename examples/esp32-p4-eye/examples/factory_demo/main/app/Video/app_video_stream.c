@@ -425,13 +425,6 @@ esp_err_t app_video_stream_init(i2c_master_bus_handle_t i2c_handle)
     }
     ESP_LOGI(TAG, "Allocated shared photo buffer: %lu bytes (%dx%d)", shared_photo_buf_size, SHARED_PHOTO_BUF_WIDTH, SHARED_PHOTO_BUF_HEIGHT);
 
-    // Initialize AI detection buffers
-    ret = app_ai_detection_init_buffers(data_cache_line_size);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize AI detection buffers: 0x%x", ret);
-        goto cleanup;
-    }
-
     // Allocate JPEG buffer
     jpeg_encode_memory_alloc_cfg_t rx_mem_cfg = {
         .buffer_direction = JPEG_DEC_ALLOC_OUTPUT_BUFFER,
@@ -525,9 +518,6 @@ cleanup:
             }
         }
         
-        // Clean up AI detection resources
-        app_ai_detection_deinit();
-        
         if (camera_buffer.video_cam_fd >= 0) {
             app_video_close(camera_buffer.video_cam_fd);
         }
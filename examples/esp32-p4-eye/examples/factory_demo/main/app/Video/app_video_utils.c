@@ -8,6 +8,7 @@
 #include "bsp/esp-bsp.h"
 
 #include "app_video_utils.h"
+#include "app_overlay.h"
 
 #define SCALE_LEVELS            4                         // Resolution scale levels
 
@@ -231,10 +232,6 @@ esp_err_t app_image_encode_jpeg(
  */
 void swap_rgb565_bytes(uint16_t *buffer, int pixel_count)
 {
-    for (int i = 0; i < pixel_count; i++) {
-        uint16_t swap16 = *(buffer + i);
-        swap16 = (swap16 >> 8) | (swap16 << 8);
-        *(buffer + i) = swap16;
-    }
+    app_overlay_swap_bytes(buffer, pixel_count);
 }
 
@@ -11,10 +11,15 @@
 #include "driver/jpeg_decode.h"
 #include "driver/ppa.h"
 #include "esp_private/esp_cache_private.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
 
 #include "ui_extra.h"
 
 #include "app_storage.h"
+#include "app_catalog.h"
+#include "app_thumbnail.h"
 #include "app_video.h"
 #include "app_video_stream.h"
 #include "app_video_utils.h"
@@ -25,29 +30,51 @@ static const char *TAG = "app_album";
 
 #define ALIGN_UP(num, align)    (((num) + ((align) - 1)) & ~((align) - 1))
 
-#define MAX_PATH_LEN 300
-#define PIC_FOLDER_NAME "esp32_p4_pic_save"
+#define MAX_PATH_LEN 64
+
+#define ALBUM_CACHE_NUM                 5   // Decoded pictures kept, the current one and its neighbours
+#define ALBUM_PREFETCH_NUM              2   // Neighbours decoded in advance on each side of the current picture
+#define ALBUM_PREFETCH_TASK_PRIORITY    2
+#define ALBUM_PREFETCH_TASK_STACK_SIZE  4096
+
+typedef struct {
+    uint32_t number;        // Picture number, 0 if the entry is free
+    uint32_t used;          // Last use, the least recently used entry is replaced first
+    void *buffer;           // Picture at the size of the LCD, ready for the canvas
+} album_cache_entry_t;
 
 typedef struct {
-    char **filenames; 
     int count;
-    int current_index;
+    int current_index;      // 0 for the newest picture
+    uint32_t current_slot;  // Catalogue slot of the current picture
+    app_catalog_record_t current;
     lv_obj_t *canvas;
-    void *img_buffer;       // Buffer for JPEG file
+    void *img_buffer;       // Buffer for JPEG file, only grows
+    size_t img_buffer_size;
+    void *exif_buffer;      // Buffer for the EXIF segment holding the thumbnail
+    size_t exif_buffer_size;
     void *ppa_buffer;
-    size_t buffer_size;
     void *canvas_buffer;    // Buffer for decoded RGB565 image
     int canvas_width;
     int canvas_height;
     jpeg_decoder_handle_t jpeg_handle;
     ppa_client_handle_t ppa_handle;
-    int max_images;         // Dynamically adjusted maximum image count
+    album_cache_entry_t cache[ALBUM_CACHE_NUM];
+    size_t cache_buffer_size;
+    uint32_t cache_clock;
+    SemaphoreHandle_t lock; // Decoder, PPA, buffers and cache, shared with the prefetch task
+    TaskHandle_t prefetch_task;
 } album_context_t;
 
 static album_context_t album_ctx;
 static size_t data_cache_line_size = 0;
 static size_t tx_buffer_size = 0;
 
+static const jpeg_decode_cfg_t decode_cfg_rgb = {
+    .output_format = JPEG_DECODE_OUT_FORMAT_RGB565,
+    .rgb_order = JPEG_DEC_RGB_ELEMENT_ORDER_BGR,
+};
+
 static uint64_t last_free_space_check_time = 0;
 static uint64_t last_known_free_space = 0;
 static uint32_t photos_taken_since_check = 0;
@@ -56,33 +83,9 @@ static const uint32_t ESTIMATED_PHOTO_SIZE = 500 * 1024; // 500KB
 static const uint32_t MIN_FREE_SPACE = 5 * 1024 * 1024; // 5MB
 
 static const uint32_t album_res[PHOTO_RESOLUTION_MAX] = {480, 640, 960};
-static photo_resolution_t current_album_resolution = PHOTO_RESOLUTION_1080P; // default 1080P
 
 static bool enable_coco_od = false;
 
-static bool is_valid_image_file(const char *filename) {
-    // check file extension
-    const char *ext = strrchr(filename, '.');
-    if (!ext || (strcasecmp(ext, ".jpg") != 0 && strcasecmp(ext, ".jpeg") != 0)) {
-        return false;
-    }
-    
-    // check if it is a temporary file or system file
-    if (filename[0] == '.' || filename[0] == '#' || 
-        filename[strlen(filename)-1] == '~' ||
-        strncmp(filename, "____~", 5) == 0 ||
-        strstr(filename, ".swp") != NULL) {
-        return false;
-    }
-    
-    return true;
-}
-
-// Comparison function for sorting filenames in descending order
-static int compare_filenames_desc(const void *a, const void *b) {
-    return strcmp(*(const char **)b, *(const char **)a);
-}
-
 // get sd card free space
 static float app_album_get_sd_free_space(void)
 {
@@ -139,38 +142,6 @@ static float app_album_get_sd_total_space(void)
     return total_mb;
 }
 
-// Calculate and set the maximum number of images based on SD card capacity
-static void app_album_calculate_max_images(void)
-{
-    // Local constants for this function only
-    const int DEFAULT_MAX_IMAGES = 20000;    // Default maximum number of images
-    const int AVG_IMAGE_SIZE_KB = 100;       // Assume average image size is 100KB
-    const int SD_STORAGE_PERCENT = 50;       // Percentage of SD card capacity used for storing images
-    
-    float total_mb = app_album_get_sd_total_space();
-    if (total_mb <= 0) {
-        // If failed to get total capacity, use default value
-        album_ctx.max_images = DEFAULT_MAX_IMAGES;
-        ESP_LOGW(TAG, "Failed to get SD card total space, using default MAX_IMAGES: %d", DEFAULT_MAX_IMAGES);
-        return;
-    }
-    
-    // Calculate space available for storing images (MB)
-    float storage_mb = total_mb * SD_STORAGE_PERCENT / 100.0f;
-    
-    // Calculate number of images that can be stored (assuming 100KB per image)
-    int max_images = (int)(storage_mb * 1024 / AVG_IMAGE_SIZE_KB);
-    
-    // Limit maximum value to DEFAULT_MAX_IMAGES
-    if (max_images > DEFAULT_MAX_IMAGES) {
-        max_images = DEFAULT_MAX_IMAGES;
-    }
-    
-    album_ctx.max_images = max_images;
-    ESP_LOGI(TAG, "Calculated MAX_IMAGES: %d (based on %.2f MB total, %.2f MB allocated for storage)", 
-             max_images, total_mb, storage_mb);
-}
-
 // Check if SD card has enough space to store a new image
 bool app_album_can_store_new_image(void) 
 {
@@ -309,261 +280,358 @@ bool app_video_stream_can_store_new_mp4(float estimated_size_mb)
     return true;
 }
 
-// Scan images from SD card
-static esp_err_t app_album_scan_images(void) {
-    DIR *dir = opendir(BSP_SD_MOUNT_POINT"/"PIC_FOLDER_NAME);
-    if (!dir) {
-        ESP_LOGE(TAG, "Failed to open directory %s/%s", BSP_SD_MOUNT_POINT, PIC_FOLDER_NAME);
-        return ESP_FAIL;
+uint32_t app_album_get_crop_size(uint32_t width, uint32_t height)
+{
+    if (width == 1920 && height == 1080) {
+        return album_res[PHOTO_RESOLUTION_1080P];
+    } else if (width == 1280 && height == 720) {
+        return album_res[PHOTO_RESOLUTION_720P];
+    } else if (width == 640 && height == 480) {
+        return album_res[PHOTO_RESOLUTION_480P];
+    }
+    return 0;
+}
+
+// Select the picture found from a catalogue slot
+static esp_err_t app_album_select(int32_t start, int direction) {
+    uint32_t slot;
+    app_catalog_record_t record;
+    esp_err_t ret = app_catalog_find(start, direction, &slot, &record);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to find a picture in the catalogue (error %d)", ret);
+        return ret;
     }
 
-    struct dirent *entry;
-    char **filenames_temp = NULL;
-    int count = 0;
-    int capacity = 32;  
+    // The prefetch task reads the slot under the lock
+    if (album_ctx.lock) {
+        xSemaphoreTake(album_ctx.lock, portMAX_DELAY);
+    }
+    album_ctx.current_slot = slot;
+    album_ctx.current = record;
+    if (album_ctx.lock) {
+        xSemaphoreGive(album_ctx.lock);
+    }
+    return ESP_OK;
+}
 
-    // Free previous filenames array
-    if (album_ctx.filenames) {
-        for (int i = 0; i < album_ctx.count; i++) {
-            if (album_ctx.filenames[i]) {
-                free(album_ctx.filenames[i]);
-            }
+// Forget a decoded picture, all of them for 0
+static void app_album_cache_drop(uint32_t number) {
+    if (!album_ctx.lock) {
+        return;
+    }
+    xSemaphoreTake(album_ctx.lock, portMAX_DELAY);
+    for (int i = 0; i < ALBUM_CACHE_NUM; i++) {
+        if (number == 0 || album_ctx.cache[i].number == number) {
+            album_ctx.cache[i].number = 0;
+            album_ctx.cache[i].used = 0;
         }
-        free(album_ctx.filenames);
-        album_ctx.filenames = NULL;
     }
-    album_ctx.count = 0;
+    xSemaphoreGive(album_ctx.lock);
+}
 
-    // Allocate initial capacity for filenames array
-    filenames_temp = heap_caps_malloc(capacity * sizeof(char*), MALLOC_CAP_SPIRAM);
-    if (!filenames_temp) {
-        ESP_LOGE(TAG, "Failed to allocate memory for filenames array");
-        closedir(dir);
+// Remove the current picture, the next older one becomes the current one, or the newest if it was the oldest
+static esp_err_t app_album_remove_current_image(void) {
+    if (app_storage_delete_picture(album_ctx.current_slot, album_ctx.current.number) != ESP_OK) {
         return ESP_FAIL;
     }
+    app_album_cache_drop(album_ctx.current.number);
 
-    // Scan all jpg files in the directory
-    while ((entry = readdir(dir)) != NULL && count < album_ctx.max_images) {
-        if (is_valid_image_file(entry->d_name)) {
-            // If we need to expand the array capacity
-            if (count >= capacity) {
-                capacity *= 2;
-                char **new_array = heap_caps_realloc(filenames_temp, capacity * sizeof(char*), MALLOC_CAP_SPIRAM);
-                if (!new_array) {
-                    ESP_LOGE(TAG, "Failed to reallocate memory for filenames array");
-                    for (int i = 0; i < count; i++) {
-                        free(filenames_temp[i]);
-                    }
-                    free(filenames_temp);
-                    closedir(dir);
-                    return ESP_FAIL;
-                }
-                filenames_temp = new_array;
-            }
-            
-            // Allocate memory for filename
-            filenames_temp[count] = heap_caps_malloc(MAX_PATH_LEN, MALLOC_CAP_SPIRAM);
-            if (filenames_temp[count] == NULL) {
-                ESP_LOGE(TAG, "Failed to allocate memory for filename");
-                for (int i = 0; i < count; i++) {
-                    free(filenames_temp[i]);
-                }
-                free(filenames_temp);
-                closedir(dir);
-                return ESP_FAIL;
-            }
-            
-            snprintf(filenames_temp[count], MAX_PATH_LEN, 
-                    "%s/%s/%s", BSP_SD_MOUNT_POINT, PIC_FOLDER_NAME, entry->d_name);
-            count++;
-        }
+    album_ctx.count = app_catalog_count();
+    if (album_ctx.count == 0) {
+        return ESP_FAIL;
+    }
+    if (album_ctx.current_index >= album_ctx.count) {
+        album_ctx.current_index = 0;
+        return app_album_select(-1, -1);
     }
+    return app_album_select((int32_t)album_ctx.current_slot - 1, -1);
+}
 
-    closedir(dir);
-    
-    if (count == 0) {
-        ESP_LOGW(TAG, "No images found in %s/%s", BSP_SD_MOUNT_POINT, PIC_FOLDER_NAME);
-        free(filenames_temp);
-        return ESP_FAIL;
+// Scan images from SD card, only the catalogue is read whatever the number of pictures
+static esp_err_t app_album_scan_images(void) {
+    if (app_catalog_sync() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to rebuild the picture catalogue");
     }
-    
-    // Sort filenames in descending order (newest first, assuming sequential numbering)
-    qsort(filenames_temp, count, sizeof(char *), compare_filenames_desc);
-    
-    // Save sorted filenames array
-    album_ctx.filenames = filenames_temp;
-    album_ctx.count = count;
+
+    album_ctx.count = app_catalog_count();
     album_ctx.current_index = 0;
-    
-    ESP_LOGI(TAG, "Found %d images in %s/%s (sorted by filename in descending order)", 
-             count, BSP_SD_MOUNT_POINT, PIC_FOLDER_NAME);
+    if (album_ctx.count == 0) {
+        ESP_LOGW(TAG, "No images found in the catalogue");
+        return ESP_FAIL;
+    }
+
+    // Newest first
+    if (app_album_select(-1, -1) != ESP_OK) {
+        album_ctx.count = 0;
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Found %d images in the catalogue", album_ctx.count);
     
     return ESP_OK;
 }
 
-// Load current image into buffer and decode it
-static esp_err_t app_album_load_current_image(void) {
-    if (album_ctx.count == 0) {
-        ESP_LOGE(TAG, "No images available");
-        return ESP_FAIL;
+// Decode the EXIF thumbnail of a picture into buffer, if it has one at the size of the LCD
+static bool app_album_decode_thumbnail(FILE *f, void *buffer) {
+    uint8_t *exif = album_ctx.exif_buffer;
+    uint32_t offset, size, out_size = 0;
+    jpeg_decode_picture_info_t header_info;
+
+    // Only the segment at the start of the file is read
+    if (fread(exif, 1, 6, f) != 6) {
+        return false;
     }
-    
-    // Free previous image buffer
-    if (album_ctx.img_buffer) {
-        free(album_ctx.img_buffer);
-        album_ctx.img_buffer = NULL;
+    size_t len = app_thumbnail_exif_length(exif);
+    if (len <= 6 || len > album_ctx.exif_buffer_size || fread(exif + 6, 1, len - 6, f) != len - 6 ||
+        !app_thumbnail_find(exif, len, &offset, &size)) {
+        return false;
     }
-    
-    // Open file
-    FILE *f = fopen(album_ctx.filenames[album_ctx.current_index], "rb");
-    if (!f) {
-        ESP_LOGE(TAG, "Failed to open file: %s", album_ctx.filenames[album_ctx.current_index]);
-        return ESP_FAIL;
+
+    if (jpeg_decoder_get_info(exif + offset, size, &header_info) != ESP_OK ||
+        header_info.width != BSP_LCD_H_RES || header_info.height != BSP_LCD_V_RES) {
+        return false;
     }
-    
-    // Get file size
+    return jpeg_decoder_process(album_ctx.jpeg_handle, &decode_cfg_rgb, exif + offset, size,
+                                buffer, album_ctx.cache_buffer_size, &out_size) == ESP_OK;
+}
+
+// Read a whole picture file into the image buffer
+static esp_err_t app_album_read_file(FILE *f, size_t *len) {
     fseek(f, 0, SEEK_END);
     size_t file_size = ftell(f);
     fseek(f, 0, SEEK_SET);
-    
-    // Allocate memory for JPEG data
-    album_ctx.img_buffer = heap_caps_malloc(file_size, MALLOC_CAP_SPIRAM);
-    if (!album_ctx.img_buffer) {
-        ESP_LOGE(TAG, "Failed to allocate memory for image");
-        fclose(f);
+
+    // Reused from picture to picture, pictures of the same resolution mostly fit in it
+    if (file_size > album_ctx.img_buffer_size) {
+        free(album_ctx.img_buffer);
+        album_ctx.img_buffer_size = 0;
+        album_ctx.img_buffer = heap_caps_malloc(file_size, MALLOC_CAP_SPIRAM);
+        if (!album_ctx.img_buffer) {
+            ESP_LOGE(TAG, "Failed to allocate memory for image");
+            return ESP_ERR_NO_MEM;
+        }
+        album_ctx.img_buffer_size = file_size;
+    }
+
+    if (fread(album_ctx.img_buffer, 1, file_size, f) != file_size) {
         return ESP_FAIL;
     }
-    
-    // Read file content
-    size_t bytes_read = fread(album_ctx.img_buffer, 1, file_size, f);
+    *len = file_size;
+    return ESP_OK;
+}
+
+/*
+ * Decode a picture at the size of the LCD, the caller holds the lock.
+ * ESP_ERR_NOT_FOUND if the file is missing, ESP_ERR_INVALID_STATE if it is corrupted.
+ */
+static esp_err_t app_album_decode(uint32_t number, void *buffer) {
+    char filename[MAX_PATH_LEN];
+    app_catalog_get_path(number, filename, sizeof(filename));
+    FILE *f = fopen(filename, "rb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open file: %s", filename);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (app_album_decode_thumbnail(f, buffer)) {
+        fclose(f);
+        ESP_LOGD(TAG, "Decoded thumbnail of %s", filename);
+        swap_rgb565_bytes(buffer, BSP_LCD_H_RES * BSP_LCD_V_RES);
+        return ESP_OK;
+    }
+
+    // No thumbnail, as in pictures of older firmware: decode the whole picture and scale it down
+    size_t file_size = 0;
+    esp_err_t ret = app_album_read_file(f, &file_size);
     fclose(f);
-    
-    if (bytes_read != file_size) {
-        ESP_LOGE(TAG, "Failed to read file: %s", album_ctx.filenames[album_ctx.current_index]);
-        free(album_ctx.img_buffer);
-        album_ctx.img_buffer = NULL;
-        return ESP_FAIL;
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read file: %s", filename);
+        return ret;
     }
-    
-    album_ctx.buffer_size = file_size;
-    ESP_LOGI(TAG, "Loaded image: %s (%u bytes)", album_ctx.filenames[album_ctx.current_index], file_size);
+    ESP_LOGI(TAG, "Loaded image: %s (%u bytes)", filename, file_size);
     
     uint32_t out_size = 0;
     jpeg_decode_picture_info_t header_info;
 
-    jpeg_decode_cfg_t decode_cfg_rgb = {
-        .output_format = JPEG_DECODE_OUT_FORMAT_RGB565,
-        .rgb_order = JPEG_DEC_RGB_ELEMENT_ORDER_BGR,
-    };
-    esp_err_t ret = jpeg_decoder_get_info(album_ctx.img_buffer, album_ctx.buffer_size, &header_info);
+    ret = jpeg_decoder_get_info(album_ctx.img_buffer, file_size, &header_info);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to parse JPEG header: %s (error %d)", album_ctx.filenames[album_ctx.current_index], ret);
-        free(album_ctx.img_buffer);
-        album_ctx.img_buffer = NULL;
-        
-        // Delete corrupted image
-        char current_file[MAX_PATH_LEN];
-        strncpy(current_file, album_ctx.filenames[album_ctx.current_index], MAX_PATH_LEN - 1);
-        ESP_LOGW(TAG, "Deleting corrupted image: %s", current_file);
-        unlink(current_file);
-        
-        // Update album data
-        free(album_ctx.filenames[album_ctx.current_index]);
-        for (int i = album_ctx.current_index; i < album_ctx.count - 1; i++) {
-            album_ctx.filenames[i] = album_ctx.filenames[i + 1];
-        }
-        album_ctx.count--;
-        
-        // Return failure if no images left
-        if (album_ctx.count == 0) {
-            return ESP_FAIL;
-        }
-        
-        // Adjust index if out of range
-        if (album_ctx.current_index >= album_ctx.count) {
-            album_ctx.current_index = 0;
-        }
-        
-        // Recursively try to load next image
-        return app_album_load_current_image();
+        ESP_LOGE(TAG, "Failed to parse JPEG header: %s (error %d)", filename, ret);
+        return ESP_ERR_INVALID_STATE;
     }
     
     ESP_LOGD(TAG, "header parsed, width is %" PRId32 ", height is %" PRId32, header_info.width, header_info.height);
-        
-    ret = jpeg_decoder_process(album_ctx.jpeg_handle, &decode_cfg_rgb, album_ctx.img_buffer, album_ctx.buffer_size, album_ctx.ppa_buffer, tx_buffer_size, &out_size);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to decode JPEG: %s (error %d)", album_ctx.filenames[album_ctx.current_index], ret);
-        free(album_ctx.img_buffer);
-        album_ctx.img_buffer = NULL;
-        
-        // Delete corrupted image
-        char current_file[MAX_PATH_LEN];
-        strncpy(current_file, album_ctx.filenames[album_ctx.current_index], MAX_PATH_LEN - 1);
-        ESP_LOGW(TAG, "Deleting corrupted image: %s", current_file);
-        unlink(current_file);
-        
-        // Update album data
-        free(album_ctx.filenames[album_ctx.current_index]);
-        for (int i = album_ctx.current_index; i < album_ctx.count - 1; i++) {
-            album_ctx.filenames[i] = album_ctx.filenames[i + 1];
-        }
-        album_ctx.count--;
-        
-        // Return failure if no images left
-        if (album_ctx.count == 0) {
-            return ESP_FAIL;
-        }
-        
-        // Adjust index if out of range
-        if (album_ctx.current_index >= album_ctx.count) {
-            album_ctx.current_index = 0;
-        }
-        
-        // Recursively try to load next image
-        return app_album_load_current_image();
-    }
-    
-    if(header_info.width == 1920 && header_info.height == 1080) {
-        current_album_resolution = PHOTO_RESOLUTION_1080P;
-    } else if(header_info.width == 1280 && header_info.height == 720) {
-        current_album_resolution = PHOTO_RESOLUTION_720P;
-    } else if(header_info.width == 640 && header_info.height == 480) {
-        current_album_resolution = PHOTO_RESOLUTION_480P;
-    } else {
+
+    uint32_t crop_size = app_album_get_crop_size(header_info.width, header_info.height);
+    if (crop_size == 0) {
         ESP_LOGE(TAG, "Not supported image resolution: %"PRId32"x%"PRId32", skip this image", 
                  header_info.width, header_info.height);
-        free(album_ctx.img_buffer);
-        album_ctx.img_buffer = NULL;
         return ESP_ERR_NOT_SUPPORTED;
     }
+        
+    ret = jpeg_decoder_process(album_ctx.jpeg_handle, &decode_cfg_rgb, album_ctx.img_buffer, file_size, album_ctx.ppa_buffer, tx_buffer_size, &out_size);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to decode JPEG: %s (error %d)", filename, ret);
+        return ESP_ERR_INVALID_STATE;
+    }
 
     ppa_srm_oper_config_t srm_config = {
         .in.buffer = album_ctx.ppa_buffer,
         .in.pic_w = header_info.width,
         .in.pic_h = header_info.height,
-        .in.block_w = album_res[current_album_resolution],
-        .in.block_h = album_res[current_album_resolution],
-        .in.block_offset_x = (header_info.width - album_res[current_album_resolution]) / 2,
-        .in.block_offset_y = (header_info.height - album_res[current_album_resolution]) / 2,
+        .in.block_w = crop_size,
+        .in.block_h = crop_size,
+        .in.block_offset_x = (header_info.width - crop_size) / 2,
+        .in.block_offset_y = (header_info.height - crop_size) / 2,
         .in.srm_cm = PPA_SRM_COLOR_MODE_RGB565,
-        .out.buffer = album_ctx.canvas_buffer,
-        .out.buffer_size = ALIGN_UP(BSP_LCD_H_RES * BSP_LCD_V_RES * 2, data_cache_line_size),
+        .out.buffer = buffer,
+        .out.buffer_size = album_ctx.cache_buffer_size,
         .out.pic_w = BSP_LCD_H_RES,
         .out.pic_h = BSP_LCD_V_RES,
         .out.block_offset_x = 0,
         .out.block_offset_y = 0,
         .out.srm_cm = PPA_SRM_COLOR_MODE_RGB565,
         .rotation_angle = PPA_SRM_ROTATION_ANGLE_0,
-        .scale_x = (float)BSP_LCD_H_RES / album_res[current_album_resolution],
-        .scale_y = (float)BSP_LCD_V_RES / album_res[current_album_resolution],
+        .scale_x = (float)BSP_LCD_H_RES / crop_size,
+        .scale_y = (float)BSP_LCD_V_RES / crop_size,
         .rgb_swap = 0,
         .byte_swap = 0,
         .mode = PPA_TRANS_MODE_BLOCKING,
     };
 
-    ESP_ERROR_CHECK(ppa_do_scale_rotate_mirror(album_ctx.ppa_handle, &srm_config));
+    ret = ppa_do_scale_rotate_mirror(album_ctx.ppa_handle, &srm_config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to scale image: %s (error %d)", filename, ret);
+        return ret;
+    }
+
+    swap_rgb565_bytes(buffer, BSP_LCD_H_RES * BSP_LCD_V_RES);
+
+    return ESP_OK;
+}
+
+// Find a decoded picture and mark it as used, the caller holds the lock
+static album_cache_entry_t *app_album_cache_find(uint32_t number) {
+    for (int i = 0; i < ALBUM_CACHE_NUM; i++) {
+        if (album_ctx.cache[i].number == number) {
+            album_ctx.cache[i].used = ++album_ctx.cache_clock;
+            return &album_ctx.cache[i];
+        }
+    }
+    return NULL;
+}
+
+// Get a decoded picture, decoding it in place of the least recently used one if needed, the caller holds the lock
+static esp_err_t app_album_cache_get(uint32_t number, album_cache_entry_t **entry) {
+    *entry = app_album_cache_find(number);
+    if (*entry) {
+        return ESP_OK;
+    }
 
-    swap_rgb565_bytes(album_ctx.canvas_buffer, BSP_LCD_H_RES * BSP_LCD_V_RES);
+    album_cache_entry_t *victim = &album_ctx.cache[0];
+    for (int i = 1; i < ALBUM_CACHE_NUM; i++) {
+        if (album_ctx.cache[i].used < victim->used) {
+            victim = &album_ctx.cache[i];
+        }
+    }
+
+    victim->number = 0;
+    victim->used = 0;
+    esp_err_t ret = app_album_decode(number, victim->buffer);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    victim->number = number;
+    victim->used = ++album_ctx.cache_clock;
+    *entry = victim;
+    return ESP_OK;
+}
+
+/*
+ * Decode the neighbours of the current picture while it is shown, closest first, so that next and prev only
+ * copy a decoded picture. Woken after each picture loaded, it starts over if the user moves on meanwhile.
+ */
+static void app_album_prefetch_task(void *arg) {
+    bool restart = false;
+
+    while (1) {
+        if (!restart) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+        restart = false;
+
+        uint32_t numbers[ALBUM_PREFETCH_NUM * 2];
+        int num = 0;
+        app_catalog_record_t record;
+
+        // Held whenever the task holds anything else, deinit deletes the task while holding it
+        xSemaphoreTake(album_ctx.lock, portMAX_DELAY);
+        uint32_t older = album_ctx.current_slot;
+        uint32_t newer = album_ctx.current_slot;
+        for (int i = 0; i < ALBUM_PREFETCH_NUM; i++) {
+            if (app_catalog_find((int32_t)older - 1, -1, &older, &record) == ESP_OK) {
+                numbers[num++] = record.number;
+            }
+            if (app_catalog_find((int32_t)newer + 1, 1, &newer, &record) == ESP_OK) {
+                numbers[num++] = record.number;
+            }
+        }
+
+        // Mark the neighbours already decoded first, the pictures left behind are then the ones replaced
+        for (int i = 0; i < num; i++) {
+            if (app_album_cache_find(numbers[i])) {
+                numbers[i] = 0;
+            }
+        }
+        xSemaphoreGive(album_ctx.lock);
+
+        for (int i = 0; i < num; i++) {
+            if (ulTaskNotifyTake(pdTRUE, 0)) {
+                restart = true;
+                break;
+            }
+            if (numbers[i] == 0) {
+                continue;
+            }
+
+            // Failures are left to the foreground, which removes missing and corrupted pictures
+            album_cache_entry_t *entry;
+            xSemaphoreTake(album_ctx.lock, portMAX_DELAY);
+            app_album_cache_get(numbers[i], &entry);
+            xSemaphoreGive(album_ctx.lock);
+        }
+    }
+}
+
+// Load current image into the canvas buffer, from the cache if it was prefetched
+static esp_err_t app_album_load_current_image(void) {
+    if (album_ctx.count == 0) {
+        ESP_LOGE(TAG, "No images available");
+        return ESP_FAIL;
+    }
+
+    album_cache_entry_t *entry;
+    xSemaphoreTake(album_ctx.lock, portMAX_DELAY);
+    esp_err_t ret = app_album_cache_get(album_ctx.current.number, &entry);
+    if (ret == ESP_OK) {
+        memcpy(album_ctx.canvas_buffer, entry->buffer, album_ctx.canvas_width * album_ctx.canvas_height * 2);
+    }
+    xSemaphoreGive(album_ctx.lock);
+
+    if (ret == ESP_ERR_NOT_FOUND || ret == ESP_ERR_INVALID_STATE) {
+        // Deleted behind the catalogue or corrupted, drop it and the next one becomes the current one
+        ESP_LOGW(TAG, "Removing missing or corrupted image %"PRIu32, album_ctx.current.number);
+        if (app_album_remove_current_image() != ESP_OK) {
+            return ESP_FAIL;
+        }
+        
+        // Recursively try to load next image
+        return app_album_load_current_image();
+    }
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    xTaskNotifyGive(album_ctx.prefetch_task);
 
     return ESP_OK;
 }
@@ -645,7 +713,9 @@ esp_err_t app_album_next_image(void) {
     album_ctx.current_index = (album_ctx.current_index + 1) % album_ctx.count;
     ESP_LOGI(TAG, "Switching to next image: %d/%d", album_ctx.current_index + 1, album_ctx.count);
     
-    if (app_album_load_current_image() != ESP_OK) {
+    // Next is older, from the newest after the oldest
+    if (app_album_select((int32_t)album_ctx.current_slot - 1, -1) != ESP_OK ||
+        app_album_load_current_image() != ESP_OK) {
         return ESP_FAIL;
     }
     
@@ -662,7 +732,8 @@ esp_err_t app_album_prev_image(void) {
     album_ctx.current_index = (album_ctx.current_index + album_ctx.count - 1) % album_ctx.count;
     ESP_LOGI(TAG, "Switching to previous image: %d/%d", album_ctx.current_index + 1, album_ctx.count);
     
-    if (app_album_load_current_image() != ESP_OK) {
+    if (app_album_select((int32_t)album_ctx.current_slot + 1, 1) != ESP_OK ||
+        app_album_load_current_image() != ESP_OK) {
         return ESP_FAIL;
     }
     
@@ -722,28 +793,16 @@ esp_err_t app_album_delete_current_image(void) {
         return ESP_FAIL;
     }
     
-    // Get current filename
-    char current_file[MAX_PATH_LEN];
-    strncpy(current_file, album_ctx.filenames[album_ctx.current_index], MAX_PATH_LEN - 1);
-    
-    ESP_LOGI(TAG, "Deleting image: %s", current_file);
+    uint32_t slot = album_ctx.current_slot;
+    ESP_LOGI(TAG, "Deleting image %"PRIu32, album_ctx.current.number);
     
-    // Delete the file
-    if (unlink(current_file) != 0) {
-        ESP_LOGE(TAG, "Failed to delete file: %s", current_file);
+    // Delete the file and its record
+    if (app_storage_delete_picture(slot, album_ctx.current.number) != ESP_OK) {
         return ESP_FAIL;
     }
+    app_album_cache_drop(album_ctx.current.number);
     
-    // free the memory of the filename
-    free(album_ctx.filenames[album_ctx.current_index]);
-    
-    // Update filenames array by shifting elements
-    for (int i = album_ctx.current_index; i < album_ctx.count - 1; i++) {
-        album_ctx.filenames[i] = album_ctx.filenames[i + 1];
-    }
-    
-    // Decrease count
-    album_ctx.count--;
+    album_ctx.count = app_catalog_count();
     
     ESP_LOGI(TAG, "Image deleted successfully, remaining images: %d", album_ctx.count);
     
@@ -762,19 +821,20 @@ esp_err_t app_album_delete_current_image(void) {
         
         // Show "No data found" message
         app_album_show_no_data_message();
-
-        // Free image buffer
-        if (album_ctx.img_buffer) {
-            free(album_ctx.img_buffer);
-            album_ctx.img_buffer = NULL;
-        }
         
         return ESP_OK;
     }
     
-    // Adjust current index if needed
+    // The next older image takes the place of the deleted one, the newer one if it was the oldest
+    esp_err_t ret;
     if (album_ctx.current_index >= album_ctx.count) {
         album_ctx.current_index = album_ctx.count - 1;
+        ret = app_album_select(slot, 1);
+    } else {
+        ret = app_album_select(slot, -1);
+    }
+    if (ret != ESP_OK) {
+        return ESP_FAIL;
     }
     
     // Load and display next image
@@ -782,6 +842,9 @@ esp_err_t app_album_delete_current_image(void) {
         // If failed to load current image, try next one
         if (album_ctx.count > 1) {
             album_ctx.current_index = (album_ctx.current_index + 1) % album_ctx.count;
+            if (app_album_select((int32_t)album_ctx.current_slot - 1, -1) != ESP_OK) {
+                return ESP_FAIL;
+            }
             return app_album_load_current_image() && app_album_display_current_image();
         }
         return ESP_FAIL;
@@ -800,9 +863,6 @@ esp_err_t app_album_init(lv_obj_t *parent) {
     // Initialize context
     memset(&album_ctx, 0, sizeof(album_ctx));
     
-    // Calculate and set maximum image count
-    app_album_calculate_max_images();
-
     // Set canvas dimensions
     album_ctx.canvas_width = BSP_LCD_H_RES;
     album_ctx.canvas_height = BSP_LCD_V_RES;
@@ -845,6 +905,37 @@ esp_err_t app_album_init(lv_obj_t *parent) {
         .timeout_ms = 40,
     };
     ESP_ERROR_CHECK(jpeg_new_decoder_engine(&decode_eng_cfg, &album_ctx.jpeg_handle));
+
+    // The EXIF segment is read whole, its thumbnail is then decoded from it
+    jpeg_decode_memory_alloc_cfg_t rx_mem_cfg = {
+        .buffer_direction = JPEG_DEC_ALLOC_INPUT_BUFFER,
+    };
+    album_ctx.exif_buffer = jpeg_alloc_decoder_mem(APP_THUMBNAIL_HEADER_SIZE + APP_THUMBNAIL_MAX_SIZE, &rx_mem_cfg,
+                                                   &album_ctx.exif_buffer_size);
+    if (!album_ctx.exif_buffer) {
+        ESP_LOGE(TAG, "Failed to allocate EXIF buffer");
+        return ESP_FAIL;
+    }
+
+    // Decoded pictures, the decoder and the PPA write them directly
+    for (int i = 0; i < ALBUM_CACHE_NUM; i++) {
+        album_ctx.cache[i].buffer = jpeg_alloc_decoder_mem(canvas_buf_size, &tx_mem_cfg, &album_ctx.cache_buffer_size);
+        if (!album_ctx.cache[i].buffer) {
+            ESP_LOGE(TAG, "Failed to allocate cache buffer");
+            return ESP_FAIL;
+        }
+    }
+
+    album_ctx.lock = xSemaphoreCreateMutex();
+    if (!album_ctx.lock) {
+        ESP_LOGE(TAG, "Failed to create album lock");
+        return ESP_FAIL;
+    }
+    if (xTaskCreate(app_album_prefetch_task, "album_prefetch", ALBUM_PREFETCH_TASK_STACK_SIZE, NULL,
+                    ALBUM_PREFETCH_TASK_PRIORITY, &album_ctx.prefetch_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create album prefetch task");
+        return ESP_FAIL;
+    }
     
     // Set initial canvas buffer (black screen)
     bsp_display_lock(0);
@@ -871,11 +962,8 @@ esp_err_t app_album_init(lv_obj_t *parent) {
 }
 
 esp_err_t app_album_refresh(void) {
-    // Free previous image buffer
-    if (album_ctx.img_buffer) {
-        free(album_ctx.img_buffer);
-        album_ctx.img_buffer = NULL;
-    }
+    // Pictures may have been replaced from the computer
+    app_album_cache_drop(0);
     
     // Rescan images from SD card
     esp_err_t ret = app_album_scan_images();
@@ -900,21 +988,33 @@ esp_err_t app_album_refresh(void) {
 
 // Clean up album resources
 void app_album_deinit(void) {
+    // The prefetch task is stopped out of any decoding
+    if (album_ctx.prefetch_task) {
+        xSemaphoreTake(album_ctx.lock, portMAX_DELAY);
+        vTaskDelete(album_ctx.prefetch_task);
+        album_ctx.prefetch_task = NULL;
+        xSemaphoreGive(album_ctx.lock);
+    }
+    if (album_ctx.lock) {
+        vSemaphoreDelete(album_ctx.lock);
+        album_ctx.lock = NULL;
+    }
+
     if (album_ctx.img_buffer) {
         free(album_ctx.img_buffer);
         album_ctx.img_buffer = NULL;
+        album_ctx.img_buffer_size = 0;
     }
-    
-    // free the memory of the filenames array
-    if (album_ctx.filenames) {
-        for (int i = 0; i < album_ctx.count; i++) {
-            if (album_ctx.filenames[i]) {
-                free(album_ctx.filenames[i]);
-            }
-        }
-        free(album_ctx.filenames);
-        album_ctx.filenames = NULL;
+    if (album_ctx.exif_buffer) {
+        free(album_ctx.exif_buffer);
+        album_ctx.exif_buffer = NULL;
+    }
+    for (int i = 0; i < ALBUM_CACHE_NUM; i++) {
+        free(album_ctx.cache[i].buffer);
+        album_ctx.cache[i].buffer = NULL;
+        album_ctx.cache[i].number = 0;
     }
+    
     album_ctx.count = 0;
 
     if (album_ctx.canvas_buffer) {
@@ -99,6 +99,18 @@ void app_album_photo_saved(void);
  */
 bool app_video_stream_can_store_new_mp4(float estimated_size_mb);
 
+/**
+ * @brief Get the side of the square the album shows from a picture
+ *
+ * The album shows the centered square of this side scaled to the size of the LCD, the thumbnail saved with a
+ * picture is made from the same square.
+ *
+ * @param width Picture width
+ * @param height Picture height
+ * @return Side of the square in pixels, 0 if the resolution is not supported
+ */
+uint32_t app_album_get_crop_size(uint32_t width, uint32_t height);
+
 /**
  * @brief Enable or disable COCO OD detection
  * 
@@ -0,0 +1,547 @@
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+
+#include "app_catalog.h"
+#include "app_thumbnail.h"
+
+static const char *TAG = "app_catalog";
+
+#define CATALOG_MAGIC           (0x54414350)    // "PCAT"
+#define CATALOG_VERSION         (1)
+#define CATALOG_PATH_LEN        (64)
+#define CATALOG_NUMBER_MAX      (9999999)       // Higher numbers in file names are not pictures of the camera
+#define CATALOG_COMPACT_MIN     (64)            // Deleted slots kept before the catalogue is compacted
+#define CATALOG_BATCH           (32)            // Records moved at once when compacting
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t slot_num;          // Records in the file, deleted pictures included
+    uint32_t live_num;          // Records of pictures
+    uint32_t next_number;
+    uint32_t reserved[3];
+} catalog_header_t;
+
+typedef struct {
+    char folder[CATALOG_PATH_LEN];
+    FILE *file;                 // Kept open, a lookup in a folder of thousands of pictures is slow on FAT
+    catalog_header_t header;
+    SemaphoreHandle_t lock;
+    volatile bool stale;
+} catalog_t;
+
+static catalog_t catalog;
+
+static void catalog_path(uint32_t number, char *path, size_t len)
+{
+    snprintf(path, len, "%s/pic_%04"PRIu32".jpg", catalog.folder, number);
+}
+
+static long catalog_slot_offset(uint32_t slot)
+{
+    return sizeof(catalog_header_t) + (long)slot * sizeof(app_catalog_record_t);
+}
+
+static esp_err_t catalog_read_slot(uint32_t slot, app_catalog_record_t *record)
+{
+    if (fseek(catalog.file, catalog_slot_offset(slot), SEEK_SET) != 0 ||
+        fread(record, sizeof(*record), 1, catalog.file) != 1) {
+        ESP_LOGE(TAG, "Failed to read slot %"PRIu32, slot);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t catalog_write_slot(uint32_t slot, const app_catalog_record_t *record)
+{
+    if (fseek(catalog.file, catalog_slot_offset(slot), SEEK_SET) != 0 ||
+        fwrite(record, sizeof(*record), 1, catalog.file) != 1) {
+        ESP_LOGE(TAG, "Failed to write slot %"PRIu32, slot);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t catalog_write_header(void)
+{
+    if (fseek(catalog.file, 0, SEEK_SET) != 0 ||
+        fwrite(&catalog.header, sizeof(catalog.header), 1, catalog.file) != 1 ||
+        fflush(catalog.file) != 0) {
+        ESP_LOGE(TAG, "Failed to write header");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static void catalog_close_file(void)
+{
+    if (catalog.file) {
+        fclose(catalog.file);
+        catalog.file = NULL;
+    }
+}
+
+/* Width and height from the frame header, the segments before it are skipped without being read */
+static bool catalog_read_jpeg_size(FILE *file, uint16_t *width, uint16_t *height)
+{
+    uint8_t buf[5];
+
+    if (fread(buf, 1, 2, file) != 2 || buf[0] != 0xFF || buf[1] != 0xD8) {
+        return false;
+    }
+    while (fread(buf, 1, 4, file) == 4) {
+        uint8_t marker = buf[1];
+        uint16_t len = (buf[2] << 8) | buf[3];
+
+        if (buf[0] != 0xFF || marker == 0xDA || len < 2) {
+            return false;
+        }
+        // SOF0 to SOF15, except DHT, JPG and DAC
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            if (fread(buf, 1, 5, file) != 5) {
+                return false;
+            }
+            *height = (buf[1] << 8) | buf[2];
+            *width = (buf[3] << 8) | buf[4];
+            return true;
+        }
+        if (fseek(file, len - 2, SEEK_CUR) != 0) {
+            return false;
+        }
+    }
+    return false;
+}
+
+/* Offset of the thumbnail in the EXIF segment at the start of the file, segment holds the largest one */
+static uint32_t catalog_read_thumb_offset(FILE *file, uint8_t *segment)
+{
+    uint32_t offset, size;
+
+    if (fread(segment, 1, 6, file) != 6) {
+        return APP_CATALOG_NO_THUMB;
+    }
+    size_t len = app_thumbnail_exif_length(segment);
+    if (len == 0 || len > APP_THUMBNAIL_HEADER_SIZE + APP_THUMBNAIL_MAX_SIZE ||
+        fread(segment + 6, 1, len - 6, file) != len - 6 || !app_thumbnail_find(segment, len, &offset, &size)) {
+        return APP_CATALOG_NO_THUMB;
+    }
+    return offset;
+}
+
+/* Record of a picture from its file, false if it is missing */
+static bool catalog_stat_picture(uint32_t number, uint8_t *segment, app_catalog_record_t *record)
+{
+    char path[CATALOG_PATH_LEN + 32];
+    struct stat st;
+
+    catalog_path(number, path, sizeof(path));
+    if (stat(path, &st) != 0) {
+        return false;
+    }
+
+    memset(record, 0, sizeof(*record));
+    record->number = number;
+    record->size = st.st_size;
+    record->timestamp = st.st_mtime;
+    record->thumb_offset = APP_CATALOG_NO_THUMB;
+
+    FILE *file = fopen(path, "rb");
+    if (file) {
+        record->thumb_offset = catalog_read_thumb_offset(file, segment);
+        if (fseek(file, 0, SEEK_SET) != 0 || !catalog_read_jpeg_size(file, &record->width, &record->height)) {
+            record->width = 0;
+            record->height = 0;
+        }
+        fclose(file);
+    }
+    return true;
+}
+
+/* Whether the catalogue opened still matches the folder, checked without listing it */
+static bool catalog_check(void)
+{
+    catalog_header_t *header = &catalog.header;
+    app_catalog_record_t record;
+    struct stat st;
+
+    if (fread(header, sizeof(*header), 1, catalog.file) != 1 || header->magic != CATALOG_MAGIC ||
+        header->version != CATALOG_VERSION || header->record_size != sizeof(app_catalog_record_t) ||
+        header->live_num > header->slot_num || header->next_number == 0) {
+        ESP_LOGW(TAG, "Invalid header");
+        return false;
+    }
+    if (fstat(fileno(catalog.file), &st) != 0 || st.st_size != catalog_slot_offset(header->slot_num)) {
+        ESP_LOGW(TAG, "Length does not match the header");
+        return false;
+    }
+
+    // A picture saved without its record, or copied to the card
+    char path[CATALOG_PATH_LEN + 32];
+    catalog_path(header->next_number, path, sizeof(path));
+    if (stat(path, &st) == 0) {
+        ESP_LOGW(TAG, "Picture %"PRIu32" is not in the catalogue", header->next_number);
+        return false;
+    }
+
+    // The newest picture, deleted or rewritten behind the catalogue
+    for (int32_t slot = (int32_t)header->slot_num - 1; slot >= 0; slot--) {
+        if (catalog_read_slot(slot, &record) != ESP_OK) {
+            return false;
+        }
+        if (record.number == 0) {
+            continue;
+        }
+        catalog_path(record.number, path, sizeof(path));
+        if (stat(path, &st) != 0 || st.st_size != record.size) {
+            ESP_LOGW(TAG, "Picture %"PRIu32" does not match the catalogue", record.number);
+            return false;
+        }
+        break;
+    }
+    return true;
+}
+
+/* Record every picture of the folder, in the order of their numbers, with what its file tells */
+static esp_err_t catalog_rebuild(void)
+{
+    char path[CATALOG_PATH_LEN + 32];
+    uint8_t *bits = NULL;
+    uint8_t *segment = NULL;
+    size_t bits_size = 0;
+    uint32_t max_number = 0;
+    esp_err_t ret = ESP_OK;
+
+    ESP_LOGI(TAG, "Rebuilding the catalogue of %s", catalog.folder);
+    catalog_close_file();
+
+    DIR *dir = opendir(catalog.folder);
+    if (!dir) {
+        ESP_LOGE(TAG, "Failed to open directory %s", catalog.folder);
+        return ESP_FAIL;
+    }
+
+    // One bit per picture number, the folder is listed once whatever its order
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        unsigned int number;
+        int end = 0;
+
+        if (sscanf(entry->d_name, "pic_%u.jpg%n", &number, &end) != 1 || end == 0 || entry->d_name[end] != '\0' ||
+            number == 0 || number > CATALOG_NUMBER_MAX) {
+            continue;
+        }
+        if (number / 8 >= bits_size) {
+            size_t size = (number / 8 + 1024) & ~(size_t)1023;
+            uint8_t *new_bits = heap_caps_realloc(bits, size, MALLOC_CAP_SPIRAM);
+            if (!new_bits) {
+                ESP_LOGE(TAG, "Failed to allocate memory for picture numbers");
+                ret = ESP_ERR_NO_MEM;
+                break;
+            }
+            memset(new_bits + bits_size, 0, size - bits_size);
+            bits = new_bits;
+            bits_size = size;
+        }
+        bits[number / 8] |= 1 << (number % 8);
+        if (number > max_number) {
+            max_number = number;
+        }
+    }
+    closedir(dir);
+
+    memset(&catalog.header, 0, sizeof(catalog.header));
+    catalog.header.magic = CATALOG_MAGIC;
+    catalog.header.version = CATALOG_VERSION;
+    catalog.header.record_size = sizeof(app_catalog_record_t);
+    catalog.header.next_number = max_number + 1;
+    if (ret != ESP_OK) {
+        goto cleanup;
+    }
+
+    if (max_number) {
+        segment = heap_caps_malloc(APP_THUMBNAIL_HEADER_SIZE + APP_THUMBNAIL_MAX_SIZE, MALLOC_CAP_SPIRAM);
+    }
+    if (max_number && !segment) {
+        ESP_LOGE(TAG, "Failed to allocate memory for the EXIF segments");
+        ret = ESP_ERR_NO_MEM;
+        goto cleanup;
+    }
+
+    snprintf(path, sizeof(path), "%s/%s", catalog.folder, APP_CATALOG_FILE_NAME);
+    catalog.file = fopen(path, "w+b");
+    if (!catalog.file) {
+        ESP_LOGE(TAG, "Failed to create %s", path);
+        ret = ESP_FAIL;
+        goto cleanup;
+    }
+
+    // Header written last, a rebuild cut short leaves a catalogue that does not match its length
+    if (fseek(catalog.file, sizeof(catalog_header_t), SEEK_SET) != 0) {
+        ret = ESP_FAIL;
+        goto cleanup;
+    }
+    for (uint32_t number = 1; number <= max_number; number++) {
+        app_catalog_record_t record;
+
+        if (!(bits[number / 8] & (1 << (number % 8))) || !catalog_stat_picture(number, segment, &record)) {
+            continue;
+        }
+        if (fwrite(&record, sizeof(record), 1, catalog.file) != 1) {
+            ESP_LOGE(TAG, "Failed to write the record of picture %"PRIu32, number);
+            ret = ESP_FAIL;
+            goto cleanup;
+        }
+        catalog.header.slot_num++;
+    }
+    catalog.header.live_num = catalog.header.slot_num;
+    ret = catalog_write_header();
+    ESP_LOGI(TAG, "Catalogue rebuilt, %"PRIu32" pictures", catalog.header.live_num);
+
+cleanup:
+    free(segment);
+    free(bits);
+    if (ret != ESP_OK) {
+        catalog_close_file();
+        catalog.header.slot_num = 0;
+        catalog.header.live_num = 0;
+    }
+    return ret;
+}
+
+/* Move the records of pictures over the deleted ones, in place */
+static esp_err_t catalog_compact(void)
+{
+    app_catalog_record_t records[CATALOG_BATCH];
+    uint32_t read_slot = 0;
+    uint32_t write_slot = 0;
+
+    ESP_LOGI(TAG, "Compacting the catalogue, %"PRIu32" of %"PRIu32" slots deleted",
+             catalog.header.slot_num - catalog.header.live_num, catalog.header.slot_num);
+
+    while (read_slot < catalog.header.slot_num) {
+        uint32_t num = catalog.header.slot_num - read_slot;
+        if (num > CATALOG_BATCH) {
+            num = CATALOG_BATCH;
+        }
+        if (fseek(catalog.file, catalog_slot_offset(read_slot), SEEK_SET) != 0 ||
+            fread(records, sizeof(records[0]), num, catalog.file) != num) {
+            return ESP_FAIL;
+        }
+        read_slot += num;
+
+        uint32_t live = 0;
+        for (uint32_t i = 0; i < num; i++) {
+            if (records[i].number) {
+                records[live++] = records[i];
+            }
+        }
+        if (live && (fseek(catalog.file, catalog_slot_offset(write_slot), SEEK_SET) != 0 ||
+                     fwrite(records, sizeof(records[0]), live, catalog.file) != live)) {
+            return ESP_FAIL;
+        }
+        write_slot += live;
+    }
+
+    catalog.header.slot_num = write_slot;
+    catalog.header.live_num = write_slot;
+    if (fflush(catalog.file) != 0 || ftruncate(fileno(catalog.file), catalog_slot_offset(write_slot)) != 0) {
+        return ESP_FAIL;
+    }
+    return catalog_write_header();
+}
+
+esp_err_t app_catalog_open(const char *folder)
+{
+    char path[CATALOG_PATH_LEN + 32];
+    esp_err_t ret = ESP_OK;
+
+    if (!catalog.lock) {
+        catalog.lock = xSemaphoreCreateMutex();
+        if (!catalog.lock) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    xSemaphoreTake(catalog.lock, portMAX_DELAY);
+    catalog_close_file();
+    snprintf(catalog.folder, sizeof(catalog.folder), "%s", folder);
+    catalog.stale = false;
+
+    snprintf(path, sizeof(path), "%s/%s", catalog.folder, APP_CATALOG_FILE_NAME);
+    catalog.file = fopen(path, "r+b");
+    if (!catalog.file || !catalog_check()) {
+        ret = catalog_rebuild();
+    } else if (catalog.header.slot_num - catalog.header.live_num > CATALOG_COMPACT_MIN &&
+               catalog.header.slot_num - catalog.header.live_num > catalog.header.live_num / 4) {
+        if (catalog_compact() != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to compact the catalogue");
+            ret = catalog_rebuild();
+        }
+    }
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "%"PRIu32" pictures, next picture number will be: %"PRIu32,
+                 catalog.header.live_num, catalog.header.next_number);
+    }
+    xSemaphoreGive(catalog.lock);
+
+    return ret;
+}
+
+void app_catalog_close(void)
+{
+    if (!catalog.lock) {
+        return;
+    }
+
+    xSemaphoreTake(catalog.lock, portMAX_DELAY);
+    catalog_close_file();
+    catalog.folder[0] = '\0';
+    memset(&catalog.header, 0, sizeof(catalog.header));
+    xSemaphoreGive(catalog.lock);
+}
+
+void app_catalog_invalidate(void)
+{
+    catalog.stale = true;
+}
+
+esp_err_t app_catalog_sync(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    if (!catalog.stale || !catalog.lock) {
+        return ESP_OK;
+    }
+
+    xSemaphoreTake(catalog.lock, portMAX_DELAY);
+    if (catalog.stale && catalog.folder[0]) {
+        catalog.stale = false;
+        ret = catalog_rebuild();
+    }
+    xSemaphoreGive(catalog.lock);
+
+    return ret;
+}
+
+uint32_t app_catalog_next_number(void)
+{
+    return catalog.header.next_number ? catalog.header.next_number : 1;
+}
+
+int app_catalog_count(void)
+{
+    return catalog.header.live_num;
+}
+
+esp_err_t app_catalog_add(const app_catalog_record_t *record)
+{
+    esp_err_t ret = ESP_ERR_INVALID_STATE;
+
+    if (!record || record->number == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!catalog.lock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(catalog.lock, portMAX_DELAY);
+    // The number is taken even if the record is not written, the next check of the catalogue finds the picture
+    if (record->number >= catalog.header.next_number) {
+        catalog.header.next_number = record->number + 1;
+    }
+    if (catalog.file) {
+        ret = catalog_write_slot(catalog.header.slot_num, record);
+        if (ret == ESP_OK) {
+            catalog.header.slot_num++;
+            catalog.header.live_num++;
+            ret = catalog_write_header();
+        }
+        if (ret != ESP_OK) {
+            catalog.stale = true;
+        }
+    }
+    xSemaphoreGive(catalog.lock);
+
+    return ret;
+}
+
+esp_err_t app_catalog_remove(uint32_t slot)
+{
+    app_catalog_record_t record;
+    esp_err_t ret = ESP_ERR_INVALID_STATE;
+
+    if (!catalog.lock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(catalog.lock, portMAX_DELAY);
+    if (catalog.file) {
+        ret = ESP_ERR_INVALID_ARG;
+        if (slot < catalog.header.slot_num) {
+            ret = catalog_read_slot(slot, &record);
+        }
+        if (ret == ESP_OK && record.number) {
+            record.number = 0;
+            ret = catalog_write_slot(slot, &record);
+            if (ret == ESP_OK) {
+                catalog.header.live_num--;
+                ret = catalog_write_header();
+            }
+            if (ret != ESP_OK) {
+                catalog.stale = true;
+            }
+        }
+    }
+    xSemaphoreGive(catalog.lock);
+
+    return ret;
+}
+
+esp_err_t app_catalog_find(int32_t start, int direction, uint32_t *slot, app_catalog_record_t *record)
+{
+    esp_err_t ret = ESP_ERR_INVALID_STATE;
+
+    if (!catalog.lock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(catalog.lock, portMAX_DELAY);
+    if (catalog.file) {
+        int32_t num = catalog.header.slot_num;
+        int32_t s = num ? start % num : 0;
+
+        ret = ESP_ERR_NOT_FOUND;
+        if (s < 0) {
+            s += num;
+        }
+        for (int32_t i = 0; i < num && catalog.header.live_num; i++) {
+            if (catalog_read_slot(s, record) != ESP_OK) {
+                ret = ESP_FAIL;
+                break;
+            }
+            if (record->number) {
+                *slot = s;
+                ret = ESP_OK;
+                break;
+            }
+            s = (s + (direction < 0 ? num - 1 : 1)) % num;
+        }
+    }
+    xSemaphoreGive(catalog.lock);
+
+    return ret;
+}
+
+void app_catalog_get_path(uint32_t number, char *path, size_t len)
+{
+    catalog_path(number, path, len);
+}
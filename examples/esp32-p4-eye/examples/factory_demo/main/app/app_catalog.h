@@ -0,0 +1,120 @@
+/**
+ * @file app_catalog.h
+ * @brief Catalogue of the pictures saved on the SD card
+ *
+ * The catalogue is a file in the picture folder holding one fixed-size record per picture, in the order the
+ * pictures were saved. It is updated when a picture is saved or deleted, so the album and the picture numbering
+ * never have to walk the folder. It is rebuilt from the folder only when it does not match the card.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_CATALOG_FILE_NAME   "catalog.bin"
+#define APP_CATALOG_NO_THUMB    (0xFFFFFFFF)
+
+/**
+ * @brief Record of one picture, `pic_<number>.jpg` in the picture folder
+ */
+typedef struct {
+    uint32_t number;                    /*!< Picture number, 0 once the picture is deleted */
+    uint32_t size;                      /*!< File size in bytes */
+    uint16_t width;                     /*!< Width in pixels, 0 if unknown */
+    uint16_t height;                    /*!< Height in pixels, 0 if unknown */
+    uint32_t timestamp;                 /*!< Time of the save, or modification time of the file if rebuilt */
+    uint32_t thumb_offset;              /*!< Offset of the thumbnail, APP_CATALOG_NO_THUMB if none */
+} app_catalog_record_t;
+
+/**
+ * @brief Open the catalogue of a picture folder
+ *
+ * The catalogue is checked against the folder without listing it: its header, its length, the oldest and newest
+ * pictures, and the absence of a picture after the last one. It is rebuilt from the folder if any of them does not
+ * match, and compacted if many pictures were deleted. A rebuild reads the size, the resolution, the modification
+ * time and the thumbnail of every picture from its file.
+ *
+ * @param folder Picture folder, must exist
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t app_catalog_open(const char *folder);
+
+/**
+ * @brief Close the catalogue, before the SD card is unmounted
+ */
+void app_catalog_close(void);
+
+/**
+ * @brief Mark the catalogue as out of date, the pictures were changed behind it (USB disk)
+ *
+ * Only sets a flag, can be called from any task. The catalogue is rebuilt by the next `app_catalog_sync()`.
+ */
+void app_catalog_invalidate(void);
+
+/**
+ * @brief Rebuild the catalogue if it was marked as out of date
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t app_catalog_sync(void);
+
+/**
+ * @brief Get the number to give to the next picture saved
+ *
+ * @return Picture number, 1 for an empty folder
+ */
+uint32_t app_catalog_next_number(void);
+
+/**
+ * @brief Get the number of pictures
+ */
+int app_catalog_count(void);
+
+/**
+ * @brief Add a picture after the file is written
+ *
+ * @param record Record of the picture, its number at least `app_catalog_next_number()`
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t app_catalog_add(const app_catalog_record_t *record);
+
+/**
+ * @brief Remove a picture after the file is deleted
+ *
+ * @param slot Slot of the picture, as given by `app_catalog_find()`
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t app_catalog_remove(uint32_t slot);
+
+/**
+ * @brief Find a picture from a slot, skipping the deleted ones
+ *
+ * Slots are in the order of the saves, the newest picture in the last one. The search wraps around at both ends.
+ *
+ * @param start First slot to look at, taken modulo the number of slots, -1 for the newest picture
+ * @param direction 1 towards newer pictures, -1 towards older pictures
+ * @param slot Slot of the picture found
+ * @param record Record of the picture found
+ * @return ESP_OK if found, ESP_ERR_NOT_FOUND if there are no pictures, error code otherwise
+ */
+esp_err_t app_catalog_find(int32_t start, int direction, uint32_t *slot, app_catalog_record_t *record);
+
+/**
+ * @brief Get the path of a picture
+ *
+ * @param number Picture number
+ * @param path Buffer of the path
+ * @param len Size of the buffer
+ */
+void app_catalog_get_path(uint32_t number, char *path, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
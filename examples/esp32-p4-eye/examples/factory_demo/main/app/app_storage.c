@@ -2,6 +2,8 @@
 #include <dirent.h> 
 #include <fcntl.h>
 #include <string.h>
+#include <errno.h>
+#include <time.h>
 #include <sys/stat.h>
 #include "esp_log.h"
 #include "esp_sleep.h"
@@ -21,6 +23,8 @@
 #include "app_album.h"
 #include "app_video_stream.h"
 #include "app_storage.h"
+#include "app_catalog.h"
+#include "app_thumbnail.h"
 
 /* Constants and definitions */
 #define PIC_FOLDER_NAME "esp32_p4_pic_save"
@@ -42,13 +46,11 @@
 
 /* Static variables */
 static const char *TAG = "app_storage";
-static uint32_t pic_num = 0;
 static uint8_t s_pdrv = 0;
 static int s_disk_block_size = 0;
 static bool ejected[LOGICAL_DISK_NUM] = {true};
 
 /* Forward declarations for static functions */
-static void app_storage_find_max_pic_num(void);
 static void app_storage_check_sd_card_task(void *pvParameters);
 static bool _logical_disk_ejected(void);
 
@@ -576,42 +578,12 @@ esp_err_t app_storage_load_gyroscope_setting(bool *enabled)
 
 /* SD Card and file operations */
 
-/**
- * @brief Find the highest picture number in the directory
- */
-static void app_storage_find_max_pic_num(void) 
-{
-    DIR *dir = opendir(BSP_SD_MOUNT_POINT"/"PIC_FOLDER_NAME);
-    if (!dir) {
-        ESP_LOGE(TAG, "Failed to open directory %s/%s", BSP_SD_MOUNT_POINT, PIC_FOLDER_NAME);
-        return;
-    }
-
-    struct dirent *entry;
-    uint32_t max_num = 0;  
-
-    while ((entry = readdir(dir)) != NULL) {
-        if (strstr(entry->d_name, "pic_") && strstr(entry->d_name, ".jpg")) {
-            unsigned int index;
-            if (sscanf(entry->d_name, "pic_%u.jpg", &index) == 1) {
-                if (index > max_num) {
-                    max_num = index;  
-                }
-            }
-        }
-    }
-
-    closedir(dir);
-    pic_num = max_num + 1;  
-    ESP_LOGI(TAG, "Next picture number will be: %lu", pic_num);
-}
-
 /**
  * @brief Save picture to SD card
  */
-esp_err_t app_storage_save_picture(const uint8_t *data, size_t len) 
+esp_err_t app_storage_save_picture(const uint8_t *data, size_t len, const uint8_t *thumb, size_t thumb_len) 
 {
-    if (data == NULL || len == 0) {
+    if (data == NULL || len < 2) {
         return ESP_ERR_INVALID_ARG;
     }
     
@@ -625,8 +597,9 @@ esp_err_t app_storage_save_picture(const uint8_t *data, size_t len)
     
     ESP_LOGI(TAG, "JPEG verified: %"PRId32"x%"PRId32, header_info.width, header_info.height);
     
+    uint32_t number = app_catalog_next_number();
     char filename[64];
-    sprintf(filename, "%s/%s/pic_%04lu.jpg", BSP_SD_MOUNT_POINT, PIC_FOLDER_NAME, pic_num);
+    sprintf(filename, "%s/%s/pic_%04"PRIu32".jpg", BSP_SD_MOUNT_POINT, PIC_FOLDER_NAME, number);
     
     FILE *file = fopen(filename, "wb");
     if (!file) {
@@ -656,6 +629,23 @@ esp_err_t app_storage_save_picture(const uint8_t *data, size_t len)
         }
     }
     
+    // With a thumbnail the file starts with its EXIF header, the picture then follows without its own SOI
+    uint8_t header[APP_THUMBNAIL_HEADER_SIZE];
+    size_t thumb_offset = thumb ? app_thumbnail_build_header(header, thumb_len) : 0;
+    if (thumb && thumb_offset == 0) {
+        ESP_LOGW(TAG, "Thumbnail too large (%u bytes), saving without it", thumb_len);
+    }
+    if (thumb_offset) {
+        if (fwrite(header, 1, sizeof(header), file) != sizeof(header) ||
+            fwrite(thumb, 1, thumb_len, file) != thumb_len) {
+            ESP_LOGE(TAG, "Failed to write thumbnail to file: %s", filename);
+            fclose(file);
+            return ESP_FAIL;
+        }
+        data += 2;
+        len -= 2;
+    }
+
     size_t bytes_written = fwrite(data, 1, len, file);
     if (bytes_written != len) {
         ESP_LOGE(TAG, "Failed to write to file: %s (written: %u/%u)", 
@@ -665,21 +655,49 @@ esp_err_t app_storage_save_picture(const uint8_t *data, size_t len)
     }
     
     fclose(file);
+    len += thumb_offset ? thumb_offset + thumb_len : 0;
     ESP_LOGI(TAG, "Picture saved as %s (%u bytes)", filename, len);
     
-    // Increment picture number for next image
-    pic_num++;
+    // Record the picture, this also moves to the next picture number
+    app_catalog_record_t record = {
+        .number = number,
+        .size = len,
+        .width = header_info.width,
+        .height = header_info.height,
+        .timestamp = time(NULL),
+        .thumb_offset = thumb_offset ? thumb_offset : APP_CATALOG_NO_THUMB,
+    };
+    if (app_catalog_add(&record) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to add %s to the catalogue", filename);
+    }
     
     return ESP_OK;
 }
 
+/**
+ * @brief Delete picture from SD card
+ */
+esp_err_t app_storage_delete_picture(uint32_t slot, uint32_t number)
+{
+    char filename[64];
+    app_catalog_get_path(number, filename, sizeof(filename));
+
+    // A picture already deleted behind the catalogue is only removed from it
+    if (unlink(filename) != 0 && errno != ENOENT) {
+        ESP_LOGE(TAG, "Failed to delete file: %s", filename);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Picture %s deleted", filename);
+
+    return app_catalog_remove(slot);
+}
+
 static void app_storage_check_sd_card_task(void *pvParameters)
 {
     bsp_sdcard_detect_init();
     bool is_sd_card_mounted = false;
     bool usb_msc_initialized = false;
     bool album_initialized = false;
-    bool directory_checked = false;
 
     while(1) {
         bool current_is_sd_card_mounted = bsp_sdcard_is_present();
@@ -693,6 +711,26 @@ static void app_storage_check_sd_card_task(void *pvParameters)
                 ui_extra_set_sd_card_mounted(true);
                 bsp_display_unlock();
 
+                // Create directory for saving pictures if it doesn't exist, on every card inserted
+                char folder_path[64];
+                sprintf(folder_path, "%s/%s", BSP_SD_MOUNT_POINT, PIC_FOLDER_NAME);
+                
+                DIR *dir = opendir(folder_path);
+                if (dir) {
+                    // Directory exists
+                    closedir(dir);
+                    ESP_LOGI(TAG, "Directory %s already exists", folder_path);
+                } else if (mkdir(folder_path, 0755) != 0) {
+                    ESP_LOGE(TAG, "Failed to create directory %s", folder_path);
+                } else {
+                    ESP_LOGI(TAG, "Created directory: %s", folder_path);
+                }
+
+                // Check the catalogue of the card, it gives the next picture number and the album pictures
+                if (app_catalog_open(folder_path) != ESP_OK) {
+                    ESP_LOGE(TAG, "Failed to open the picture catalogue");
+                }
+
                 if (!album_initialized) {
                     app_album_init(ui_ImageScreenAlbum);
                     album_initialized = true;
@@ -701,34 +739,6 @@ static void app_storage_check_sd_card_task(void *pvParameters)
                     ESP_LOGI(TAG, "Album already initialized");
                 }
 
-                if (!directory_checked) {
-                    // Create directory for saving pictures if it doesn't exist
-                    char folder_path[64];
-                    sprintf(folder_path, "%s/%s", BSP_SD_MOUNT_POINT, PIC_FOLDER_NAME);
-                    
-                    DIR *dir = opendir(folder_path);
-                    if (dir) {
-                        // Directory exists
-                        closedir(dir);
-                        ESP_LOGI(TAG, "Directory %s already exists", folder_path);
-                        
-                        // Find the highest picture number to continue incrementing
-                        app_storage_find_max_pic_num();
-                    } else {
-                        // Directory doesn't exist, create it
-                        if (mkdir(folder_path, 0755) != 0) {
-                            ESP_LOGE(TAG, "Failed to create directory %s", folder_path);
-                        } else {
-                            ESP_LOGI(TAG, "Created directory: %s", folder_path);
-                            pic_num = 1;  // Start with 1 for a new directory
-                        }
-                    }
-                    directory_checked = true;
-                    ESP_LOGI(TAG, "Directory check completed");
-                } else {
-                    ESP_LOGI(TAG, "Directory already checked");
-                }
-
                 if (!usb_msc_initialized) {
                     ESP_LOGI(TAG, "USB MSC initialization");
                     
@@ -742,6 +752,7 @@ static void app_storage_check_sd_card_task(void *pvParameters)
                 }
             } else {
                 ESP_LOGI(TAG, "SD card unmounted");
+                app_catalog_close();
                 bsp_sdcard_unmount();
 
                 bsp_display_lock(0);
@@ -1009,6 +1020,9 @@ int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t *
         return 0;
     }
 
+    // The host may change the pictures, the catalogue is rebuilt when the album is opened again
+    app_catalog_invalidate();
+
     const uint32_t block_count = bufsize / s_disk_block_size;
     disk_write(s_pdrv, buffer, lba, block_count);
     return block_count * s_disk_block_size;
@@ -14,11 +14,24 @@ esp_err_t app_storage_init(void);
 /**
  * @brief Save picture data to SD card
  * 
+ * The thumbnail, if any, is stored as the EXIF thumbnail of the picture, see `app_thumbnail.h`.
+ * 
  * @param data Pointer to image data
  * @param len Length of image data in bytes
+ * @param thumb Pointer to the JPEG thumbnail at the size of the LCD, NULL for none
+ * @param thumb_len Length of the thumbnail in bytes
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t app_storage_save_picture(const uint8_t *data, size_t len, const uint8_t *thumb, size_t thumb_len);
+
+/**
+ * @brief Delete picture from SD card and from the picture catalogue
+ * 
+ * @param slot Catalogue slot of the picture
+ * @param number Picture number
  * @return ESP_OK on success, error code otherwise
  */
-esp_err_t app_storage_save_picture(const uint8_t *data, size_t len);
+esp_err_t app_storage_delete_picture(uint32_t slot, uint32_t number);
 
 /**
  * @brief Save application settings to NVS
@@ -0,0 +1,173 @@
+#include <string.h>
+
+#include "app_thumbnail.h"
+
+#define EXIF_TIFF_START     (12)        // SOI, APP1 marker and length, "Exif\0\0"
+#define EXIF_IFD0           (8)         // IFD offsets are from the start of the TIFF header
+#define EXIF_IFD1           (EXIF_IFD0 + 2 + 12 + 4)
+#define EXIF_THUMB          (EXIF_IFD1 + 2 + 3 * 12 + 4)
+
+#define TAG_ORIENTATION     (0x0112)
+#define TAG_COMPRESSION     (0x0103)
+#define TAG_THUMB_OFFSET    (0x0201)    // JPEGInterchangeFormat
+#define TAG_THUMB_LENGTH    (0x0202)    // JPEGInterchangeFormatLength
+#define TYPE_SHORT          (3)
+#define TYPE_LONG           (4)
+
+static void put16(uint8_t *p, uint16_t value)
+{
+    p[0] = value >> 8;
+    p[1] = value;
+}
+
+static void put32(uint8_t *p, uint32_t value)
+{
+    put16(p, value >> 16);
+    put16(p + 2, value);
+}
+
+/* IFD entry of one value, big endian as the TIFF header written */
+static uint8_t *put_entry(uint8_t *p, uint16_t tag, uint16_t type, uint32_t value)
+{
+    put16(p, tag);
+    put16(p + 2, type);
+    put32(p + 4, 1);
+    if (type == TYPE_SHORT) {
+        put16(p + 8, value);
+        put16(p + 10, 0);
+    } else {
+        put32(p + 8, value);
+    }
+    return p + 12;
+}
+
+size_t app_thumbnail_build_header(uint8_t *header, size_t thumb_len)
+{
+    if (thumb_len == 0 || thumb_len > APP_THUMBNAIL_MAX_SIZE) {
+        return 0;
+    }
+
+    uint8_t *tiff = header + EXIF_TIFF_START;
+    uint8_t *p;
+
+    memset(header, 0, APP_THUMBNAIL_HEADER_SIZE);
+    put16(header, 0xFFD8);
+    put16(header + 2, 0xFFE1);
+    put16(header + 4, APP_THUMBNAIL_HEADER_SIZE - 4 + thumb_len);
+    memcpy(header + 6, "Exif\0\0", 6);
+
+    memcpy(tiff, "MM", 2);
+    put16(tiff + 2, 0x002A);
+    put32(tiff + 4, EXIF_IFD0);
+
+    // IFD0, the picture: upright
+    p = tiff + EXIF_IFD0;
+    put16(p, 1);
+    p = put_entry(p + 2, TAG_ORIENTATION, TYPE_SHORT, 1);
+    put32(p, EXIF_IFD1);
+
+    // IFD1, the thumbnail: a JPEG right after it
+    p = tiff + EXIF_IFD1;
+    put16(p, 3);
+    p = put_entry(p + 2, TAG_COMPRESSION, TYPE_SHORT, 6);
+    p = put_entry(p, TAG_THUMB_OFFSET, TYPE_LONG, EXIF_THUMB);
+    p = put_entry(p, TAG_THUMB_LENGTH, TYPE_LONG, thumb_len);
+    put32(p, 0);
+
+    return EXIF_TIFF_START + EXIF_THUMB;
+}
+
+size_t app_thumbnail_exif_length(const uint8_t *head)
+{
+    if (head[0] != 0xFF || head[1] != 0xD8 || head[2] != 0xFF || head[3] != 0xE1) {
+        return 0;
+    }
+    return 4 + ((head[4] << 8) | head[5]);
+}
+
+typedef struct {
+    const uint8_t *data;
+    uint32_t len;
+    bool little;
+} exif_tiff_t;
+
+static bool tiff_get16(const exif_tiff_t *tiff, uint32_t pos, uint32_t *value)
+{
+    if (pos > tiff->len || tiff->len - pos < 2) {
+        return false;
+    }
+    const uint8_t *p = tiff->data + pos;
+    *value = tiff->little ? (p[0] | p[1] << 8) : (p[0] << 8 | p[1]);
+    return true;
+}
+
+static bool tiff_get32(const exif_tiff_t *tiff, uint32_t pos, uint32_t *value)
+{
+    uint32_t hi, lo;
+
+    if (!tiff_get16(tiff, pos, tiff->little ? &lo : &hi) || !tiff_get16(tiff, pos + 2, tiff->little ? &hi : &lo)) {
+        return false;
+    }
+    *value = hi << 16 | lo;
+    return true;
+}
+
+/* Offset of IFD1, the IFD of the thumbnail, 0 if none */
+static uint32_t tiff_ifd1(const exif_tiff_t *tiff)
+{
+    uint32_t ifd0, num, ifd1;
+
+    if (!tiff_get32(tiff, 4, &ifd0) || !tiff_get16(tiff, ifd0, &num) || !tiff_get32(tiff, ifd0 + 2 + 12 * num, &ifd1)) {
+        return 0;
+    }
+    return ifd1;
+}
+
+bool app_thumbnail_find(const uint8_t *data, size_t len, uint32_t *offset, uint32_t *size)
+{
+    if (len < 6 || app_thumbnail_exif_length(data) == 0 || app_thumbnail_exif_length(data) > len ||
+        app_thumbnail_exif_length(data) < EXIF_TIFF_START + 8 || memcmp(data + 6, "Exif\0\0", 6) != 0 ||
+        (memcmp(data + EXIF_TIFF_START, "II*\0", 4) != 0 && memcmp(data + EXIF_TIFF_START, "MM\0*", 4) != 0)) {
+        return false;
+    }
+
+    exif_tiff_t tiff = {
+        .data = data + EXIF_TIFF_START,
+        .len = app_thumbnail_exif_length(data) - EXIF_TIFF_START,
+        .little = data[EXIF_TIFF_START] == 'I',
+    };
+    uint32_t ifd1 = tiff_ifd1(&tiff);
+    uint32_t num, thumb_offset = 0, thumb_len = 0;
+
+    if (ifd1 == 0 || !tiff_get16(&tiff, ifd1, &num)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < num; i++) {
+        uint32_t entry = ifd1 + 2 + 12 * i;
+        uint32_t tag, type, value;
+
+        if (!tiff_get16(&tiff, entry, &tag) || !tiff_get16(&tiff, entry + 2, &type)) {
+            return false;
+        }
+        if (tag != TAG_THUMB_OFFSET && tag != TAG_THUMB_LENGTH) {
+            continue;
+        }
+        if (!(type == TYPE_SHORT ? tiff_get16(&tiff, entry + 8, &value) : tiff_get32(&tiff, entry + 8, &value))) {
+            return false;
+        }
+        if (tag == TAG_THUMB_OFFSET) {
+            thumb_offset = value;
+        } else {
+            thumb_len = value;
+        }
+    }
+
+    // Entirely in the segment, and a JPEG
+    if (thumb_offset == 0 || thumb_len < 4 || thumb_offset > tiff.len || tiff.len - thumb_offset < thumb_len ||
+        tiff.data[thumb_offset] != 0xFF || tiff.data[thumb_offset + 1] != 0xD8) {
+        return false;
+    }
+    *offset = EXIF_TIFF_START + thumb_offset;
+    *size = thumb_len;
+    return true;
+}
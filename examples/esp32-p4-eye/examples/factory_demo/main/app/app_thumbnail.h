@@ -0,0 +1,58 @@
+/**
+ * @file app_thumbnail.h
+ * @brief EXIF thumbnails of the pictures saved on the SD card
+ *
+ * A picture is saved as the start of an EXIF file, the thumbnail, then the picture without its SOI marker:
+ *
+ *     SOI | APP1 "Exif" header (APP_THUMBNAIL_HEADER_SIZE) | thumbnail JPEG | picture JPEG after SOI
+ *
+ * The album only reads the APP1 segment at the start of the file and decodes the thumbnail, at the size of the LCD,
+ * instead of the whole picture. Computers show the same thumbnail in their file browsers.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_THUMBNAIL_HEADER_SIZE   (80)                                    // SOI, APP1 and the TIFF header
+#define APP_THUMBNAIL_MAX_SIZE      (65535 + 4 - APP_THUMBNAIL_HEADER_SIZE) // Largest thumbnail in an APP1 segment
+
+/**
+ * @brief Build the start of a picture file holding a thumbnail
+ *
+ * @param header Buffer of APP_THUMBNAIL_HEADER_SIZE bytes
+ * @param thumb_len Length of the thumbnail JPEG, written right after the header
+ * @return Offset of the thumbnail in the file, 0 if it is too large
+ */
+size_t app_thumbnail_build_header(uint8_t *header, size_t thumb_len);
+
+/**
+ * @brief Get the length of the EXIF segment at the start of a picture file
+ *
+ * @param head First 6 bytes of the file
+ * @return Bytes to read from the start of the file to hold the segment, 0 if the file does not start with one
+ */
+size_t app_thumbnail_exif_length(const uint8_t *head);
+
+/**
+ * @brief Find the thumbnail in the EXIF segment at the start of a picture file
+ *
+ * Any EXIF thumbnail in JPEG format is found, not only those written by `app_thumbnail_build_header()`.
+ *
+ * @param data Start of the file, up to the end of the EXIF segment
+ * @param len Length of `data`
+ * @param offset Offset of the thumbnail in `data`
+ * @param size Length of the thumbnail
+ * @return true if a thumbnail was found, entirely in `data`
+ */
+bool app_thumbnail_find(const uint8_t *data, size_t len, uint32_t *offset, uint32_t *size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,496 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Picture catalogue of the album (app_catalog.c) in a temporary folder, against the folder scan
+ * it replaced: app_album_scan_images() and app_storage_find_max_pic_num() as they were, kept
+ * below as scan_ref().
+ *
+ * - a rebuild must record every picture of the camera, in the order of their numbers, with its
+ *   size, resolution and thumbnail, and skip the other files;
+ * - pictures added and removed must be found in order, the search wrapping at both ends, and
+ *   the catalogue must be opened again without a rebuild;
+ * - a picture after the last one, the newest picture deleted or rewritten, a broken header or
+ *   length, and a catalogue marked as out of date must each rebuild it;
+ * - many deleted pictures must be compacted away;
+ * - prints the time and the memory to open the album with 50 and with n pictures, next to the
+ *   folder scan.
+ *
+ * The times are of the host file system. On the SD card, FAT looks names up by walking the
+ * folder, so the scan and the rebuild cost much more there, and the open a few lookups.
+ *
+ * Usage:
+ *     catalog_bench [-n pictures]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "app_catalog.h"
+#include "app_thumbnail.h"
+
+#define SMALL_NUM   50
+#define MAX_PATH_LEN 512
+
+size_t host_heap_caps_allocated;
+
+static int s_failures;
+static char s_folder[64];
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            s_failures++; \
+        } \
+    } while (0)
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static uint32_t picture_size(uint32_t number)
+{
+    return 300 + number % 97;
+}
+
+/* A JPEG header with an application segment before the frame header, and padding */
+static void write_picture(uint32_t number, uint32_t size)
+{
+    char path[MAX_PATH_LEN];
+    uint16_t width = 1920 - number % 4;
+    uint16_t height = 1080 + number % 3;
+    uint8_t data[512] = {
+        0xFF, 0xD8,
+        0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0,
+        0xFF, 0xC0, 0x00, 0x11, 8, height >> 8, height & 0xFF, width >> 8, width & 0xFF, 3,
+    };
+
+    snprintf(path, sizeof(path), "%s/pic_%04u.jpg", s_folder, (unsigned)number);
+    FILE *f = fopen(path, "wb");
+    fwrite(data, 1, size < sizeof(data) ? size : sizeof(data), f);
+    fclose(f);
+}
+
+/* A picture as app_storage_save_picture() writes it, EXIF header, thumbnail, then the picture without its SOI */
+static uint32_t write_picture_thumb(uint32_t number, uint32_t thumb_len)
+{
+    char path[MAX_PATH_LEN];
+    uint8_t header[APP_THUMBNAIL_HEADER_SIZE];
+    uint8_t thumb[256] = { 0xFF, 0xD8 };
+    uint16_t width = 1920 - number % 4;
+    uint16_t height = 1080 + number % 3;
+    uint8_t pic[] = {
+        0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0,
+        0xFF, 0xC0, 0x00, 0x11, 8, height >> 8, height & 0xFF, width >> 8, width & 0xFF, 3,
+    };
+    size_t offset = app_thumbnail_build_header(header, thumb_len);
+
+    thumb[thumb_len - 2] = 0xFF;
+    thumb[thumb_len - 1] = 0xD9;
+    snprintf(path, sizeof(path), "%s/pic_%04u.jpg", s_folder, (unsigned)number);
+    FILE *f = fopen(path, "wb");
+    fwrite(header, 1, offset, f);
+    fwrite(thumb, 1, thumb_len, f);
+    fwrite(pic, 1, sizeof(pic), f);
+    fclose(f);
+    return offset;
+}
+
+static void write_file(const char *name)
+{
+    char path[MAX_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/%s", s_folder, name);
+    FILE *f = fopen(path, "wb");
+    fputs("not a picture", f);
+    fclose(f);
+}
+
+static void remove_picture(uint32_t number)
+{
+    char path[MAX_PATH_LEN];
+    app_catalog_get_path(number, path, sizeof(path));
+    unlink(path);
+}
+
+static void clear_folder(void)
+{
+    DIR *dir = opendir(s_folder);
+    struct dirent *entry;
+    char path[MAX_PATH_LEN];
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') {
+            snprintf(path, sizeof(path), "%s/%s", s_folder, entry->d_name);
+            unlink(path);
+        }
+    }
+    closedir(dir);
+}
+
+static long catalog_length(void)
+{
+    char path[MAX_PATH_LEN];
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/%s", s_folder, APP_CATALOG_FILE_NAME);
+    return stat(path, &st) == 0 ? st.st_size : -1;
+}
+
+/* Open, a rebuild allocates the bitmap of the picture numbers, a check allocates nothing */
+static bool open_rebuilds(void)
+{
+    host_heap_caps_allocated = 0;
+    CHECK(app_catalog_open(s_folder) == ESP_OK, "open");
+    return host_heap_caps_allocated != 0;
+}
+
+/* Numbers of the pictures from the newest, by the catalogue */
+static int list_pictures(uint32_t *numbers, int max)
+{
+    app_catalog_record_t record;
+    uint32_t slot;
+    int num = 0;
+
+    if (app_catalog_find(-1, -1, &slot, &record) != ESP_OK) {
+        return 0;
+    }
+    uint32_t first = slot;
+    do {
+        if (num < max) {
+            numbers[num] = record.number;
+        }
+        num++;
+        CHECK(app_catalog_find((int32_t)slot - 1, -1, &slot, &record) == ESP_OK, "find");
+    } while (slot != first && num <= max);
+    return num;
+}
+
+/* app_album_scan_images() and app_storage_find_max_pic_num() before the catalogue */
+static int compare_filenames_desc(const void *a, const void *b)
+{
+    return strcmp(*(const char **)b, *(const char **)a);
+}
+
+static int scan_ref(size_t *allocated, uint32_t *next_number)
+{
+    DIR *dir = opendir(s_folder);
+    struct dirent *entry;
+    int capacity = 32;
+    int count = 0;
+    char **filenames = malloc(capacity * sizeof(char *));
+    *allocated = capacity * sizeof(char *);
+
+    while ((entry = readdir(dir)) != NULL) {
+        const char *ext = strrchr(entry->d_name, '.');
+        if (!ext || strcasecmp(ext, ".jpg") != 0 || entry->d_name[0] == '.') {
+            continue;
+        }
+        if (count >= capacity) {
+            capacity *= 2;
+            filenames = realloc(filenames, capacity * sizeof(char *));
+            *allocated += capacity * sizeof(char *);
+        }
+        filenames[count] = malloc(MAX_PATH_LEN);
+        *allocated += MAX_PATH_LEN;
+        snprintf(filenames[count], MAX_PATH_LEN, "%s/%s", s_folder, entry->d_name);
+        count++;
+    }
+    closedir(dir);
+    qsort(filenames, count, sizeof(char *), compare_filenames_desc);
+
+    // The boot scan, again over the folder
+    uint32_t max_num = 0;
+    dir = opendir(s_folder);
+    while ((entry = readdir(dir)) != NULL) {
+        unsigned int index;
+        if (strstr(entry->d_name, "pic_") && strstr(entry->d_name, ".jpg") &&
+            sscanf(entry->d_name, "pic_%u.jpg", &index) == 1 && index > max_num) {
+            max_num = index;
+        }
+    }
+    closedir(dir);
+    *next_number = max_num + 1;
+
+    for (int i = 0; i < count; i++) {
+        free(filenames[i]);
+    }
+    free(filenames);
+    return count;
+}
+
+static void test_rebuild(void)
+{
+    app_catalog_record_t record;
+    uint32_t slot;
+    uint32_t numbers[SMALL_NUM];
+
+    clear_folder();
+    CHECK(open_rebuilds() == false, "an empty folder has nothing to allocate");
+    CHECK(app_catalog_count() == 0 && app_catalog_next_number() == 1, "empty: %d, next %u",
+          app_catalog_count(), (unsigned)app_catalog_next_number());
+    CHECK(app_catalog_find(-1, -1, &slot, &record) == ESP_ERR_NOT_FOUND, "empty find");
+
+    // Every third number, more than 4 digits for the last ones, and files of other names
+    for (uint32_t n = 3; n <= 3 * SMALL_NUM; n += 3) {
+        write_picture(n * 100, picture_size(n));
+    }
+    write_file("IMG_0001.jpg");
+    write_file("pic_0002.jpg.tmp");
+    write_file("pic_x.jpg");
+    write_file("pic_0000.jpg");
+
+    // A card of the firmware before the catalogue
+    char path[MAX_PATH_LEN];
+    app_catalog_close();
+    snprintf(path, sizeof(path), "%s/%s", s_folder, APP_CATALOG_FILE_NAME);
+    unlink(path);
+    CHECK(open_rebuilds(), "no catalogue");
+
+    CHECK(app_catalog_count() == SMALL_NUM, "rebuilt %d pictures", app_catalog_count());
+    CHECK(app_catalog_next_number() == 3 * SMALL_NUM * 100 + 1, "next %u", (unsigned)app_catalog_next_number());
+    for (uint32_t s = 0; s < SMALL_NUM; s++) {
+        uint32_t n = 3 * (s + 1);
+        CHECK(app_catalog_find(s, 1, &slot, &record) == ESP_OK && slot == s, "slot %u", (unsigned)s);
+        CHECK(record.number == n * 100 && record.size == picture_size(n), "slot %u: picture %u of %u bytes",
+              (unsigned)s, (unsigned)record.number, (unsigned)record.size);
+        CHECK(record.width == 1920 - record.number % 4 && record.height == 1080 + record.number % 3,
+              "picture %u: %ux%u", (unsigned)record.number, record.width, record.height);
+        CHECK(record.thumb_offset == APP_CATALOG_NO_THUMB, "thumbnail");
+    }
+    CHECK(list_pictures(numbers, SMALL_NUM) == SMALL_NUM && numbers[0] == 3 * SMALL_NUM * 100 &&
+          numbers[SMALL_NUM - 1] == 300, "newest first");
+
+    app_catalog_close();
+    CHECK(open_rebuilds() == false, "a rebuilt catalogue must match");
+
+    // The newest picture rewritten with a thumbnail, its offset and the resolution of the picture after it are found
+    uint32_t newest = 3 * SMALL_NUM * 100;
+    uint32_t thumb_offset = write_picture_thumb(newest, 200);
+    app_catalog_close();
+    CHECK(open_rebuilds(), "newest picture rewritten with a thumbnail");
+    CHECK(app_catalog_find(-1, -1, &slot, &record) == ESP_OK && record.number == newest, "newest");
+    CHECK(record.thumb_offset == thumb_offset && thumb_offset == APP_THUMBNAIL_HEADER_SIZE, "thumbnail at %u",
+          (unsigned)record.thumb_offset);
+    CHECK(record.size == APP_THUMBNAIL_HEADER_SIZE + 200 + 28 && record.width == 1920 - newest % 4 &&
+          record.height == 1080 + newest % 3, "picture %u of %u bytes, %ux%u", (unsigned)record.number,
+          (unsigned)record.size, record.width, record.height);
+    CHECK(record.timestamp != 0, "modification time");
+    app_catalog_close();
+    CHECK(open_rebuilds() == false, "a rebuilt catalogue with a thumbnail must match");
+}
+
+static void test_updates(void)
+{
+    app_catalog_record_t record;
+    uint32_t slot;
+    uint32_t numbers[SMALL_NUM + 1];
+
+    // Saved as app_storage_save_picture() does
+    uint32_t number = app_catalog_next_number();
+    write_picture(number, picture_size(number));
+    record = (app_catalog_record_t) {
+        .number = number, .size = picture_size(number), .width = 1280, .height = 720,
+        .timestamp = 1, .thumb_offset = APP_CATALOG_NO_THUMB,
+    };
+    CHECK(app_catalog_add(&record) == ESP_OK, "add");
+    CHECK(app_catalog_count() == SMALL_NUM + 1 && app_catalog_next_number() == number + 1, "added");
+    CHECK(app_catalog_find(-1, -1, &slot, &record) == ESP_OK && record.number == number && record.width == 1280,
+          "added picture is the newest");
+
+    // Wrapping: before the oldest comes the newest, after the newest the oldest
+    CHECK(app_catalog_find(-1 - SMALL_NUM - 1, -1, &slot, &record) == ESP_OK && record.number == number,
+          "wrap down");
+    CHECK(app_catalog_find(SMALL_NUM + 1, 1, &slot, &record) == ESP_OK && slot == 0, "wrap up");
+
+    // Deleted as app_storage_delete_picture() does, the oldest, one in the middle and the newest
+    uint32_t removed[] = {0, SMALL_NUM / 2, SMALL_NUM};
+    for (int i = 0; i < 3; i++) {
+        CHECK(app_catalog_find(removed[i], 1, &slot, &record) == ESP_OK, "find");
+        remove_picture(record.number);
+        CHECK(app_catalog_remove(slot) == ESP_OK, "remove");
+        CHECK(app_catalog_remove(slot) == ESP_OK, "removed twice");
+    }
+    CHECK(app_catalog_remove(SMALL_NUM + 1) == ESP_ERR_INVALID_ARG, "remove past the end");
+    CHECK(app_catalog_count() == SMALL_NUM - 2, "%d left", app_catalog_count());
+    CHECK(app_catalog_find(SMALL_NUM / 2, 1, &slot, &record) == ESP_OK && slot == SMALL_NUM / 2 + 1,
+          "deleted skipped up");
+    CHECK(app_catalog_find(SMALL_NUM / 2, -1, &slot, &record) == ESP_OK && slot == SMALL_NUM / 2 - 1,
+          "deleted skipped down");
+    CHECK(app_catalog_find(0, -1, &slot, &record) == ESP_OK && slot == SMALL_NUM - 1, "deleted skipped, wrapped");
+    CHECK(app_catalog_next_number() == number + 1, "numbers are not given twice");
+    CHECK(list_pictures(numbers, SMALL_NUM + 1) == SMALL_NUM - 2, "listed");
+
+    app_catalog_close();
+    CHECK(open_rebuilds() == false, "an updated catalogue must match");
+    CHECK(app_catalog_count() == SMALL_NUM - 2, "%d after open", app_catalog_count());
+}
+
+static void test_mismatch(void)
+{
+    app_catalog_record_t record;
+    uint32_t slot;
+    char path[MAX_PATH_LEN];
+
+    // Saved without its record, power lost
+    uint32_t number = app_catalog_next_number();
+    write_picture(number, picture_size(number));
+    app_catalog_close();
+    CHECK(open_rebuilds(), "picture after the last one");
+    CHECK(app_catalog_find(-1, -1, &slot, &record) == ESP_OK && record.number == number, "found");
+
+    // Newest deleted, then rewritten behind the catalogue
+    remove_picture(number);
+    app_catalog_close();
+    CHECK(open_rebuilds(), "newest picture deleted");
+    CHECK(app_catalog_find(-1, -1, &slot, &record) == ESP_OK && record.number != number, "newest gone");
+    write_picture(record.number, record.size + 1);
+    app_catalog_close();
+    CHECK(open_rebuilds(), "newest picture rewritten");
+
+    // Broken header, broken length
+    app_catalog_close();
+    snprintf(path, sizeof(path), "%s/%s", s_folder, APP_CATALOG_FILE_NAME);
+    FILE *f = fopen(path, "r+b");
+    fputc('X', f);
+    fclose(f);
+    CHECK(open_rebuilds(), "header");
+    app_catalog_close();
+    CHECK(truncate(path, catalog_length() - 3) == 0, "truncate");
+    CHECK(open_rebuilds(), "length");
+
+    // Pictures changed from the USB disk
+    host_heap_caps_allocated = 0;
+    CHECK(app_catalog_sync() == ESP_OK && host_heap_caps_allocated == 0, "not out of date");
+    app_catalog_invalidate();
+    CHECK(app_catalog_sync() == ESP_OK && host_heap_caps_allocated != 0, "out of date");
+    CHECK(app_catalog_count() == SMALL_NUM - 2, "%d after the rebuilds", app_catalog_count());
+
+    app_catalog_close();
+    CHECK(open_rebuilds() == false, "matches again");
+}
+
+static void test_compact(void)
+{
+    app_catalog_record_t record;
+    uint32_t slot;
+    int count = app_catalog_count();
+    int removed = 0;
+
+    for (int i = 0; i < 200; i++) {
+        uint32_t number = app_catalog_next_number();
+        write_picture(number, picture_size(number));
+        record = (app_catalog_record_t) {
+            .number = number, .size = picture_size(number), .thumb_offset = APP_CATALOG_NO_THUMB,
+        };
+        app_catalog_add(&record);
+    }
+    // Every other one
+    for (int32_t s = 0; app_catalog_find(s, 1, &slot, &record) == ESP_OK && (int32_t)slot >= s; s = slot + 2) {
+        remove_picture(record.number);
+        app_catalog_remove(slot);
+        removed++;
+    }
+    count += 200 - removed;
+    CHECK(app_catalog_count() == count, "%d left", app_catalog_count());
+    app_catalog_close();
+
+    CHECK(open_rebuilds() == false, "compacted, not rebuilt");
+    CHECK(app_catalog_count() == count, "%d after compaction", app_catalog_count());
+    CHECK(catalog_length() == 32 + count * (long)sizeof(app_catalog_record_t), "length %ld", catalog_length());
+    CHECK(app_catalog_find(count, 1, &slot, &record) == ESP_OK && slot == 0, "no slot past the pictures");
+    app_catalog_close();
+    CHECK(open_rebuilds() == false, "compacted catalogue must match");
+}
+
+/* Open of the album page: the catalogue checked, its newest picture and the count */
+static void bench_open(int num)
+{
+    app_catalog_record_t record;
+    uint32_t slot;
+    uint32_t next_number;
+    size_t allocated;
+
+    app_catalog_close();
+    clear_folder();
+    for (int n = 1; n <= num; n++) {
+        write_picture(n, picture_size(n));
+    }
+
+    double t0 = now_ms();
+    CHECK(open_rebuilds(), "rebuild of %d", num);
+    double t1 = now_ms();
+    size_t rebuild_allocated = host_heap_caps_allocated;
+    app_catalog_close();
+
+    int runs = 20;
+    double t2 = now_ms();
+    for (int i = 0; i < runs; i++) {
+        CHECK(open_rebuilds() == false, "open of %d", num);
+        CHECK(app_catalog_find(-1, -1, &slot, &record) == ESP_OK && record.number == (uint32_t)num, "newest");
+        CHECK(app_catalog_count() == num, "count");
+        app_catalog_close();
+    }
+    double t3 = now_ms();
+    int ref_count = 0;
+    for (int i = 0; i < runs; i++) {
+        ref_count = scan_ref(&allocated, &next_number);
+    }
+    double t4 = now_ms();
+    CHECK(ref_count == num && next_number == (uint32_t)num + 1, "scan_ref");
+
+    printf("%6d pictures: open %7.3f ms, 0 bytes | scan %8.3f ms, %8zu bytes | rebuild %8.3f ms, %6zu bytes\n",
+           num, (t3 - t2) / runs, (t4 - t3) / runs, allocated, t1 - t0, rebuild_allocated);
+}
+
+int main(int argc, char **argv)
+{
+    int num = 50000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        if (opt == 'n') {
+            num = atoi(optarg);
+        }
+    }
+
+    char base[] = "/tmp/catalog_bench.XXXXXX";
+    if (!mkdtemp(base)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    snprintf(s_folder, sizeof(s_folder), "%s/pic", base);
+    mkdir(s_folder, 0755);
+
+    test_rebuild();
+    test_updates();
+    test_mismatch();
+    test_compact();
+    bench_open(SMALL_NUM);
+    if (num > SMALL_NUM) {
+        bench_open(num);
+    }
+
+    app_catalog_close();
+    clear_folder();
+    rmdir(s_folder);
+    rmdir(base);
+
+    if (s_failures) {
+        printf("%d failures\n", s_failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
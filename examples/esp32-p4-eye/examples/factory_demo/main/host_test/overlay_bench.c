@@ -0,0 +1,435 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Overlay drawing of the AI pages (app_overlay.c) against the per-pixel drawing it replaced:
+ * draw_rectangle_rgb() and swap_rgb565_bytes() as they were, and the glyph loop of esp_painter,
+ * kept below as *_ref().
+ *
+ * - boxes, clipped or not, byte swapped or not, must give the same pixels as the reference;
+ *   boxes thinner than two borders must be filled, and nothing outside of a box may be written;
+ * - spans and byte swaps of every alignment and length must match a plain loop;
+ * - blending must be within one step of each component of an exact blend;
+ * - text, clipped at every edge, must match the reference glyph loop;
+ * - prints the time of a dozen COCO boxes and labels on a 1080p frame and on the 240x240
+ *   screen, and of the byte swap of a frame.
+ *
+ * The times are of the host. The ESP32-P4 writes a 32 bit word per store, as here, but its
+ * frame buffers are in PSRAM.
+ *
+ * Usage:
+ *     overlay_bench [-n frames]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "app_overlay.h"
+#include "esp_painter_font.h"
+
+#define FRAME_W     1920
+#define FRAME_H     1080
+#define SCREEN_W    240
+#define SCREEN_H    240
+#define BOX_NUM     12
+#define THICKNESS   5
+
+static int s_failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            s_failures++; \
+        } \
+    } while (0)
+
+/* app_drawing_utils.cpp before the overlay library */
+static inline uint16_t maybe_swap_rgb565(uint16_t color, int swap)
+{
+    if (swap) {
+        return ((color & 0xFF) << 8) | ((color >> 8) & 0xFF);
+    }
+    return color;
+}
+
+static void draw_rectangle_rgb_ref(uint16_t *buffer, int width, int height, int x1, int y1, int x2, int y2,
+                                   uint8_t r, uint8_t g, uint8_t b, int thickness, int swap_rgb565)
+{
+    if (x1 < 0) x1 = 0;
+    if (y1 < 0) y1 = 0;
+    if (x2 >= width) x2 = width - 1;
+    if (y2 >= height) y2 = height - 1;
+
+    uint16_t color = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+    color = maybe_swap_rgb565(color, swap_rgb565);
+
+    for (int t = 0; t < thickness; ++t) {
+        for (int x = x1; x <= x2; ++x) {
+            if (y1 + t >= 0 && y1 + t < height && x >= 0 && x < width) {
+                buffer[(y1 + t) * width + x] = color;
+            }
+            if (y2 - t >= 0 && y2 - t < height && x >= 0 && x < width) {
+                buffer[(y2 - t) * width + x] = color;
+            }
+        }
+    }
+    for (int t = 0; t < thickness; ++t) {
+        for (int y = y1; y <= y2; ++y) {
+            if (x1 + t >= 0 && x1 + t < width && y >= 0 && y < height) {
+                buffer[y * width + (x1 + t)] = color;
+            }
+            if (x2 - t >= 0 && x2 - t < width && y >= 0 && y < height) {
+                buffer[y * width + (x2 - t)] = color;
+            }
+        }
+    }
+}
+
+/* app_video_utils.c before the overlay library, in its own translation unit there too */
+__attribute__((noinline)) static void swap_rgb565_bytes_ref(uint16_t *buffer, int pixel_count)
+{
+    for (int i = 0; i < pixel_count; i++) {
+        uint16_t swap16 = *(buffer + i);
+        swap16 = (swap16 >> 8) | (swap16 << 8);
+        *(buffer + i) = swap16;
+    }
+}
+
+/*
+ * esp_painter_draw_char() without its logs and per pixel calls, clipped to the buffer. Bytes are unsigned as on the
+ * ESP32-P4, and the fonts end at '~'.
+ */
+static void draw_text_ref(uint16_t *buffer, int width, int height, int x, int y,
+                          const esp_painter_basic_font_t *font, const char *text, uint16_t color)
+{
+    for (; *text; text++, x += font->width) {
+        unsigned char c = *text;
+        if (c < 32 || c > 126) {
+            continue;
+        }
+        const uint8_t *glyph = font->bitmap + (c - 32) * font->height * ((font->width + 7) / 8);
+        for (int dy = 0; dy < font->height; dy++) {
+            for (int dx = 0; dx < font->width; dx++) {
+                uint8_t byte = glyph[dy * ((font->width + 7) / 8) + (dx / 8)];
+                int px = x + dx;
+                int py = y + dy;
+                if ((byte & (0x80 >> (dx % 8))) && px >= 0 && px < width && py >= 0 && py < height) {
+                    buffer[py * width + px] = color;
+                }
+            }
+        }
+    }
+}
+
+static uint16_t *s_noise;
+static uint16_t *s_ref;
+static uint16_t *s_out;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void fill_noise(uint16_t *buf, int n)
+{
+    for (int i = 0; i < n; i++) {
+        buf[i] = rand() & 0xffff;
+    }
+}
+
+static int rand_range(int lo, int hi)
+{
+    return lo + rand() % (hi - lo + 1);
+}
+
+static const app_overlay_font_t *overlay_font(void)
+{
+    static app_overlay_font_t font;
+    font.bitmap = esp_painter_basic_font_20.bitmap;
+    font.width = esp_painter_basic_font_20.width;
+    font.height = esp_painter_basic_font_20.height;
+    return &font;
+}
+
+static void check_box(int w, int h, int x1, int y1, int x2, int y2, int thickness, int swap)
+{
+    app_overlay_canvas_t canvas = { s_out, w, h, swap };
+    int n = w * h;
+    int cx1 = x1 < 0 ? 0 : x1, cy1 = y1 < 0 ? 0 : y1;
+    int cx2 = x2 >= w ? w - 1 : x2, cy2 = y2 >= h ? h - 1 : y2;
+    uint16_t color = app_overlay_color(&canvas, 30, 200, 90);
+
+    memcpy(s_out, s_noise, n * sizeof(uint16_t));
+    app_overlay_draw_rect(&canvas, x1, y1, x2, y2, thickness, color);
+
+    if (cx1 > cx2 || cy1 > cy2) {
+        CHECK(memcmp(s_out, s_noise, n * sizeof(uint16_t)) == 0, "box (%d,%d)-(%d,%d) out of the canvas was drawn", x1, y1, x2, y2);
+        return;
+    }
+    if (cx2 - cx1 + 1 >= 2 * thickness && cy2 - cy1 + 1 >= 2 * thickness) {
+        memcpy(s_ref, s_noise, n * sizeof(uint16_t));
+        draw_rectangle_rgb_ref(s_ref, w, h, x1, y1, x2, y2, 30, 200, 90, thickness, swap);
+        CHECK(memcmp(s_ref, s_out, n * sizeof(uint16_t)) == 0, "box (%d,%d)-(%d,%d) t%d swap %d: differs from the reference",
+              x1, y1, x2, y2, thickness, swap);
+        return;
+    }
+    /* Thinner than two borders: filled, and only inside of the box */
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            int in = x >= cx1 && x <= cx2 && y >= cy1 && y <= cy2;
+            uint16_t expect = in ? color : s_noise[y * w + x];
+            if (s_out[y * w + x] != expect) {
+                CHECK(0, "thin box (%d,%d)-(%d,%d) t%d: pixel (%d,%d) is wrong", x1, y1, x2, y2, thickness, x, y);
+                return;
+            }
+        }
+    }
+}
+
+static void check_boxes(void)
+{
+    check_box(SCREEN_W, SCREEN_H, 0, 0, SCREEN_W - 1, SCREEN_H - 1, THICKNESS, 0);
+    check_box(SCREEN_W, SCREEN_H, -20, -20, 50, 60, THICKNESS, 1);
+    check_box(SCREEN_W, SCREEN_H, 200, 210, 300, 300, THICKNESS, 0);
+    check_box(SCREEN_W, SCREEN_H, 300, 10, 400, 50, THICKNESS, 0);
+    check_box(SCREEN_W, SCREEN_H, 10, 10, 12, 100, THICKNESS, 0);
+    check_box(SCREEN_W, SCREEN_H, 10, 10, 100, 14, THICKNESS, 1);
+    check_box(SCREEN_W, SCREEN_H, 7, 9, 7, 9, 1, 0);
+    for (int i = 0; i < 2000; i++) {
+        int x1 = rand_range(-60, SCREEN_W + 20), y1 = rand_range(-60, SCREEN_H + 20);
+        int x2 = x1 + rand_range(0, 150), y2 = y1 + rand_range(0, 150);
+        check_box(SCREEN_W, SCREEN_H, x1, y1, x2, y2, rand_range(1, 8), rand() & 1);
+    }
+}
+
+static void check_spans(void)
+{
+    uint16_t ref[80], out[80];
+
+    for (int offset = 0; offset < 4; offset++) {
+        for (int n = 0; n < 70; n++) {
+            for (int i = 0; i < 80; i++) {
+                ref[i] = out[i] = i * 7;
+            }
+            for (int i = 0; i < n; i++) {
+                ref[offset + i] = 0xA55A;
+            }
+            app_overlay_fill_span(out + offset, n, 0xA55A);
+            CHECK(memcmp(ref, out, sizeof(ref)) == 0, "span of %d at offset %d differs", n, offset);
+
+            for (int i = 0; i < 80; i++) {
+                ref[i] = out[i] = rand();
+            }
+            swap_rgb565_bytes_ref(ref + offset, n);
+            app_overlay_swap_bytes(out + offset, n);
+            CHECK(memcmp(ref, out, sizeof(ref)) == 0, "swap of %d at offset %d differs", n, offset);
+        }
+    }
+}
+
+static int blend_ok(uint16_t bg, uint16_t fg, uint16_t out, int alpha)
+{
+    static const int shift[3] = { 11, 5, 0 };
+    static const int mask[3] = { 0x1f, 0x3f, 0x1f };
+    for (int c = 0; c < 3; c++) {
+        double b = (bg >> shift[c]) & mask[c];
+        double f = (fg >> shift[c]) & mask[c];
+        double o = (out >> shift[c]) & mask[c];
+        double exact = b + (f - b) * alpha / 255.0;
+        if (o < exact - 1.5 || o > exact + 1.5) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void check_blend(void)
+{
+    int w = 64, h = 16;
+
+    for (int swap = 0; swap < 2; swap++) {
+        for (int alpha = 0; alpha < 256; alpha += 15) {
+            app_overlay_canvas_t canvas = { s_out, w, h, swap };
+            uint16_t native = rand() & 0xffff;
+            uint16_t color = swap ? (uint16_t)((native >> 8) | (native << 8)) : native;
+            memcpy(s_out, s_noise, w * h * sizeof(uint16_t));
+            app_overlay_blend_rect(&canvas, 3, 2, 50, 12, color, alpha);
+            for (int y = 0; y < h; y++) {
+                for (int x = 0; x < w; x++) {
+                    uint16_t in = s_noise[y * w + x], out = s_out[y * w + x];
+                    int inside = x >= 3 && x <= 50 && y >= 2 && y <= 12;
+                    if (swap) {
+                        in = (in >> 8) | (in << 8);
+                        out = (out >> 8) | (out << 8);
+                    }
+                    if (!inside) {
+                        CHECK(in == out, "blend wrote (%d,%d) outside of its rectangle", x, y);
+                    } else if (!blend_ok(in, native, out, alpha)) {
+                        CHECK(0, "blend of %04x over %04x at alpha %d swap %d gives %04x", native, in, alpha, swap, out);
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void check_text(void)
+{
+    const char *text = "person 0.93 ~{|}\x7f\x80\xff\x1f!";
+    int w = SCREEN_W, h = SCREEN_H;
+    app_overlay_canvas_t canvas = { s_out, w, h, 0 };
+    int pos[][2] = { { 5, 5 }, { -7, 3 }, { 120, -9 }, { 100, 230 }, { -200, 100 }, { 230, 100 } };
+
+    for (size_t i = 0; i < sizeof(pos) / sizeof(pos[0]); i++) {
+        memcpy(s_ref, s_noise, w * h * sizeof(uint16_t));
+        memcpy(s_out, s_noise, w * h * sizeof(uint16_t));
+        draw_text_ref(s_ref, w, h, pos[i][0], pos[i][1], &esp_painter_basic_font_20, text, 0xFFE0);
+        app_overlay_draw_text(&canvas, pos[i][0], pos[i][1], overlay_font(), text, 0xFFE0);
+        CHECK(memcmp(s_ref, s_out, w * h * sizeof(uint16_t)) == 0, "text at (%d,%d) differs from the reference", pos[i][0], pos[i][1]);
+    }
+}
+
+/* A dozen COCO boxes with their labels, the way app_coco_od_detect() draws them */
+static void bench_frame(const char *name, int w, int h, int frames)
+{
+    int boxes[BOX_NUM][4];
+    double t0, t_ref, t_new, t_ref_text, t_new_text, t_new_label;
+    app_overlay_canvas_t canvas = { s_out, w, h, 1 };
+    uint16_t yellow = app_overlay_color(&canvas, 255, 255, 0);
+    uint16_t black = app_overlay_color(&canvas, 0, 0, 0);
+
+    for (int i = 0; i < BOX_NUM; i++) {
+        boxes[i][0] = rand_range(0, w * 3 / 4);
+        boxes[i][1] = rand_range(0, h * 3 / 4);
+        boxes[i][2] = boxes[i][0] + rand_range(w / 16, w / 4);
+        boxes[i][3] = boxes[i][1] + rand_range(h / 16, h / 4);
+    }
+
+    t0 = now_s();
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < BOX_NUM; i++) {
+            draw_rectangle_rgb_ref(s_ref, w, h, boxes[i][0], boxes[i][1], boxes[i][2], boxes[i][3], 0, 0, 255, THICKNESS, 1);
+        }
+    }
+    t_ref = now_s() - t0;
+
+    t0 = now_s();
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < BOX_NUM; i++) {
+            app_overlay_draw_rect(&canvas, boxes[i][0], boxes[i][1], boxes[i][2], boxes[i][3], THICKNESS,
+                                  app_overlay_color(&canvas, 0, 0, 255));
+        }
+    }
+    t_new = now_s() - t0;
+
+    t0 = now_s();
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < BOX_NUM; i++) {
+            draw_text_ref(s_ref, w, h, boxes[i][0] + 5, boxes[i][1] + 15, &esp_painter_basic_font_20, "person", yellow);
+        }
+    }
+    t_ref_text = now_s() - t0;
+
+    t0 = now_s();
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < BOX_NUM; i++) {
+            app_overlay_draw_text(&canvas, boxes[i][0] + 5, boxes[i][1] + 15, overlay_font(), "person", yellow);
+        }
+    }
+    t_new_text = now_s() - t0;
+
+    t0 = now_s();
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < BOX_NUM; i++) {
+            app_overlay_draw_label(&canvas, boxes[i][0] + 5, boxes[i][1] + 15, overlay_font(), "person", yellow, black, 128);
+        }
+    }
+    t_new_label = now_s() - t0;
+
+    printf("%-10s %9.1f %9.1f %6.1fx   %9.1f %9.1f %6.1fx %9.1f\n", name,
+           t_ref / frames * 1e6, t_new / frames * 1e6, t_ref / t_new,
+           t_ref_text / frames * 1e6, t_new_text / frames * 1e6, t_ref_text / t_new_text, t_new_label / frames * 1e6);
+}
+
+static void bench_swap(const char *name, int pixels, int frames)
+{
+    double t0 = now_s();
+    for (int f = 0; f < frames; f++) {
+        swap_rgb565_bytes_ref(s_ref, pixels);
+    }
+    double t_ref = now_s() - t0;
+
+    t0 = now_s();
+    for (int f = 0; f < frames; f++) {
+        app_overlay_swap_bytes(s_out, pixels);
+    }
+    double t_new = now_s() - t0;
+
+    printf("%-10s %9.1f %9.1f %6.1fx\n", name, t_ref / frames * 1e6, t_new / frames * 1e6, t_ref / t_new);
+}
+
+int main(int argc, char **argv)
+{
+    int frames = 200;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+        case 'n':
+            frames = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n frames]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (frames < 1) {
+        frames = 1;
+    }
+
+    s_noise = malloc(FRAME_W * FRAME_H * sizeof(uint16_t));
+    s_ref = malloc(FRAME_W * FRAME_H * sizeof(uint16_t));
+    s_out = malloc(FRAME_W * FRAME_H * sizeof(uint16_t));
+    if (!s_noise || !s_ref || !s_out) {
+        printf("FAIL: out of memory\n");
+        return 1;
+    }
+    srand(1);
+    fill_noise(s_noise, FRAME_W * FRAME_H);
+    memcpy(s_ref, s_noise, FRAME_W * FRAME_H * sizeof(uint16_t));
+    memcpy(s_out, s_noise, FRAME_W * FRAME_H * sizeof(uint16_t));
+
+    check_boxes();
+    check_spans();
+    check_blend();
+    check_text();
+
+    printf("%d frames, us per frame   %d boxes, %d px borders          %d labels\n", frames, BOX_NUM, THICKNESS, BOX_NUM);
+    printf("frame            ref   overlay  speedup        ref   overlay  speedup  +blended bg\n");
+    bench_frame("1920x1080", FRAME_W, FRAME_H, frames);
+    bench_frame("240x240", SCREEN_W, SCREEN_H, frames * 10);
+    printf("\nbyte swap        ref   overlay  speedup\n");
+    bench_swap("1920x1080", FRAME_W * FRAME_H, frames / 10 + 1);
+    bench_swap("240x240", SCREEN_W * SCREEN_H, frames);
+
+    free(s_noise);
+    free(s_ref);
+    free(s_out);
+
+    if (s_failures) {
+        printf("%d failure(s)\n", s_failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,26 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host build: PSRAM is the heap, the benchmark counts what is allocated through it */
+#pragma once
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+
+extern size_t host_heap_caps_allocated;
+
+static inline void *heap_caps_realloc(void *ptr, size_t size, int caps)
+{
+    (void)caps;
+    host_heap_caps_allocated += size;
+    return realloc(ptr, size);
+}
+
+static inline void *heap_caps_malloc(size_t size, int caps)
+{
+    return heap_caps_realloc(NULL, size, caps);
+}
@@ -0,0 +1,12 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host build: single-threaded, only what app_catalog.c uses */
+#pragma once
+
+#include <stdint.h>
+
+#define portMAX_DELAY   (0xFFFFFFFF)
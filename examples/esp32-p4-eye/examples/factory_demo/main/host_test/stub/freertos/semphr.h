@@ -0,0 +1,32 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host build: single-threaded, a mutex always taken at once */
+#pragma once
+
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+
+typedef int *SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    static int mutex;
+    return &mutex;
+}
+
+static inline bool xSemaphoreTake(SemaphoreHandle_t mutex, uint32_t ticks)
+{
+    (void)mutex;
+    (void)ticks;
+    return true;
+}
+
+static inline bool xSemaphoreGive(SemaphoreHandle_t mutex)
+{
+    (void)mutex;
+    return true;
+}
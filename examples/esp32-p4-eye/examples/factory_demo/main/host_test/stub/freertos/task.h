@@ -0,0 +1,10 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host build: nothing of it is used, app_camera_pipeline.hpp only includes it */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
@@ -0,0 +1,10 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host build: only the font the COCO labels use */
+#pragma once
+
+#define CONFIG_ESP_PAINTER_BASIC_FONT_20    1
@@ -0,0 +1,369 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * EXIF thumbnails of the saved pictures (app_thumbnail.c), as app_storage_save_picture() writes
+ * them and as the album reads them back.
+ *
+ * - a file written as header, thumbnail, then picture without its SOI must give back the
+ *   thumbnail, keep the JPEG markers in sequence, and the largest thumbnail must fit in APP1;
+ * - thumbnails of other cameras, little endian with more IFD entries, must be found too;
+ * - a truncated segment, offsets out of the segment, a broken TIFF header, and files without
+ *   EXIF must be rejected, and random corruptions must never give a thumbnail out of the data;
+ * - prints the time to read the thumbnail of n pictures, next to the whole picture the album
+ *   read before.
+ *
+ * Usage:
+ *     thumbnail_bench [-n pictures]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "app_thumbnail.h"
+
+#define THUMB_LEN       (14 * 1024)     // 240x240 at quality 80
+#define PICTURE_LEN     (600 * 1024)    // 1080p at quality 90
+#define MAX_PATH_LEN    512
+
+static int s_failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            s_failures++; \
+        } \
+    } while (0)
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* Stand-in of a JPEG of at least 4 bytes, SOI, an APP0 segment when it fits before the EOI, filling, EOI */
+static void fill_jpeg(uint8_t *data, size_t len, uint8_t seed)
+{
+    static const uint8_t head[] = {0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0};
+
+    if (len < 4) {
+        return;
+    }
+    for (size_t i = 0; i < len; i++) {
+        data[i] = (uint8_t)(i * 7 + seed);
+    }
+    memcpy(data, head, len >= sizeof(head) + 2 ? sizeof(head) : 2);
+    data[len - 2] = 0xFF;
+    data[len - 1] = 0xD9;
+}
+
+/* The file app_storage_save_picture() writes, returns its length */
+static size_t build_file(uint8_t *file, const uint8_t *thumb, size_t thumb_len, const uint8_t *pic, size_t pic_len)
+{
+    size_t offset = app_thumbnail_build_header(file, thumb_len);
+
+    if (offset == 0) {
+        return 0;
+    }
+    memcpy(file + offset, thumb, thumb_len);
+    memcpy(file + offset + thumb_len, pic + 2, pic_len - 2);
+    return offset + thumb_len + pic_len - 2;
+}
+
+static void test_round_trip(void)
+{
+    uint8_t *thumb = malloc(APP_THUMBNAIL_MAX_SIZE + 1);
+    uint8_t pic[4096];
+    uint8_t *file = malloc(APP_THUMBNAIL_HEADER_SIZE + APP_THUMBNAIL_MAX_SIZE + 1 + sizeof(pic));
+    static const size_t lens[] = {4, 100, THUMB_LEN, APP_THUMBNAIL_MAX_SIZE};
+    uint32_t offset, size;
+
+    fill_jpeg(pic, sizeof(pic), 3);
+    for (size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+        size_t len = lens[i];
+
+        fill_jpeg(thumb, len, (uint8_t)i);
+        size_t file_len = build_file(file, thumb, len, pic, sizeof(pic));
+        CHECK(file_len == APP_THUMBNAIL_HEADER_SIZE + len + sizeof(pic) - 2, "file of %zu bytes for thumbnail of %zu", file_len, len);
+
+        // The segment ends right at the picture, which goes on with its own markers
+        size_t exif_len = app_thumbnail_exif_length(file);
+        CHECK(exif_len == APP_THUMBNAIL_HEADER_SIZE + len, "segment of %zu bytes for thumbnail of %zu", exif_len, len);
+        CHECK(file[exif_len] == 0xFF && file[exif_len + 1] == 0xE0, "no marker after the segment for thumbnail of %zu", len);
+        CHECK(memcmp(file + exif_len, pic + 2, sizeof(pic) - 2) == 0, "picture changed for thumbnail of %zu", len);
+
+        CHECK(app_thumbnail_find(file, exif_len, &offset, &size), "thumbnail of %zu not found", len);
+        CHECK(offset == APP_THUMBNAIL_HEADER_SIZE && size == len, "thumbnail of %zu found at %u, %u bytes",
+              len, (unsigned)offset, (unsigned)size);
+        CHECK(memcmp(file + offset, thumb, len) == 0, "thumbnail of %zu changed", len);
+
+        // Each byte short of the segment
+        for (size_t cut = 0; cut < exif_len && cut < APP_THUMBNAIL_HEADER_SIZE + 8; cut++) {
+            CHECK(!app_thumbnail_find(file, cut, &offset, &size), "found in %zu bytes for thumbnail of %zu", cut, len);
+        }
+        CHECK(!app_thumbnail_find(file, exif_len - 1, &offset, &size), "found in a segment short of a byte");
+    }
+
+    CHECK(app_thumbnail_build_header(file, APP_THUMBNAIL_MAX_SIZE + 1) == 0, "thumbnail larger than APP1 accepted");
+    CHECK(app_thumbnail_build_header(file, 0) == 0, "empty thumbnail accepted");
+
+    free(thumb);
+    free(file);
+}
+
+static void put16le(uint8_t *p, uint16_t value)
+{
+    p[0] = value;
+    p[1] = value >> 8;
+}
+
+static void put32le(uint8_t *p, uint32_t value)
+{
+    put16le(p, value);
+    put16le(p + 2, value >> 16);
+}
+
+static uint8_t *put_entry_le(uint8_t *p, uint16_t tag, uint16_t type, uint32_t value)
+{
+    put16le(p, tag);
+    put16le(p + 2, type);
+    put32le(p + 4, 1);
+    put32le(p + 8, value);
+    return p + 12;
+}
+
+/*
+ * The EXIF segment of another camera: little endian, make and Exif sub-IFD in IFD0, the thumbnail
+ * length before its offset in IFD1, some data between the IFDs and the thumbnail. Returns the
+ * segment length, the thumbnail at *thumb_offset.
+ */
+static size_t build_other_exif(uint8_t *file, size_t thumb_len, uint32_t *thumb_offset)
+{
+    uint8_t *tiff = file + 12;
+    uint8_t *p;
+    uint32_t ifd1 = 8 + 2 + 3 * 12 + 4 + 64;
+    uint32_t thumb = ifd1 + 2 + 4 * 12 + 4 + 32;
+
+    memset(file, 0, 12 + thumb);
+    memcpy(file, "\xFF\xD8\xFF\xE1", 4);
+    file[4] = (8 + thumb + thumb_len) >> 8;
+    file[5] = (8 + thumb + thumb_len) & 0xFF;
+    memcpy(file + 6, "Exif\0\0", 6);
+    memcpy(tiff, "II*\0", 4);
+    put32le(tiff + 4, 8);
+
+    p = tiff + 8;
+    put16le(p, 3);
+    p = put_entry_le(p + 2, 0x010F, 2, 4);              // Make, 4 characters in place
+    memcpy(p - 4, "ACME", 4);
+    p = put_entry_le(p, 0x0112, 3, 6);                  // Orientation
+    p = put_entry_le(p, 0x8769, 4, 8 + 2 + 3 * 12 + 4); // Exif sub-IFD, right after, not followed
+    put32le(p, ifd1);
+
+    p = tiff + ifd1;
+    put16le(p, 4);
+    p = put_entry_le(p + 2, 0x0103, 3, 6);
+    p = put_entry_le(p, 0x011A, 5, 0);                  // XResolution, a rational elsewhere
+    p = put_entry_le(p, 0x0202, 4, thumb_len);
+    p = put_entry_le(p, 0x0201, 4, thumb);
+    put32le(p, 0);
+
+    fill_jpeg(tiff + thumb, thumb_len, 9);
+    *thumb_offset = 12 + thumb;
+    return 12 + thumb + thumb_len;
+}
+
+static void test_other_cameras(void)
+{
+    uint8_t file[4096];
+    uint32_t expected, offset, size;
+    size_t len = build_other_exif(file, 1000, &expected);
+
+    CHECK(app_thumbnail_exif_length(file) == len, "segment of %zu bytes, expected %zu", app_thumbnail_exif_length(file), len);
+    CHECK(app_thumbnail_find(file, len, &offset, &size), "little endian thumbnail not found");
+    CHECK(offset == expected && size == 1000, "little endian thumbnail found at %u, %u bytes", (unsigned)offset, (unsigned)size);
+
+    // No thumbnail: IFD0 is the last IFD
+    uint8_t *next = file + 12 + 8 + 2 + 3 * 12;
+    uint8_t saved[4];
+    memcpy(saved, next, 4);
+    put32le(next, 0);
+    CHECK(!app_thumbnail_find(file, len, &offset, &size), "found without IFD1");
+    memcpy(next, saved, 4);
+
+    // A JFIF file without EXIF
+    uint8_t jfif[256];
+    fill_jpeg(jfif, sizeof(jfif), 1);
+    CHECK(app_thumbnail_exif_length(jfif) == 0, "segment length for JFIF");
+    CHECK(!app_thumbnail_find(jfif, sizeof(jfif), &offset, &size), "found in JFIF");
+}
+
+static void test_broken(void)
+{
+    uint8_t thumb[1000];
+    uint8_t pic[256];
+    uint8_t file[APP_THUMBNAIL_HEADER_SIZE + sizeof(thumb) + sizeof(pic)];
+    uint8_t copy[sizeof(file)];
+    uint32_t offset, size;
+
+    fill_jpeg(thumb, sizeof(thumb), 5);
+    fill_jpeg(pic, sizeof(pic), 6);
+    size_t file_len = build_file(file, thumb, sizeof(thumb), pic, sizeof(pic));
+
+    // Segment length short of the thumbnail
+    memcpy(copy, file, file_len);
+    copy[5] -= 1;
+    CHECK(!app_thumbnail_find(copy, file_len, &offset, &size), "thumbnail past the segment found");
+
+    // TIFF header
+    memcpy(copy, file, file_len);
+    copy[12] = 'X';
+    copy[13] = 'X';
+    CHECK(!app_thumbnail_find(copy, file_len, &offset, &size), "found with a broken byte order");
+    memcpy(copy, file, file_len);
+    copy[15] = 0x2B;
+    CHECK(!app_thumbnail_find(copy, file_len, &offset, &size), "found with a broken TIFF magic");
+    memcpy(copy, file, file_len);
+    memcpy(copy + 6, "Exig", 4);
+    CHECK(!app_thumbnail_find(copy, file_len, &offset, &size), "found without the Exif identifier");
+
+    // IFD0 offset out of the segment, and entry count running past it
+    memcpy(copy, file, file_len);
+    copy[16] = 0x7F;
+    CHECK(!app_thumbnail_find(copy, file_len, &offset, &size), "found with IFD0 out of the segment");
+    memcpy(copy, file, file_len);
+    copy[20] = 0xFF;
+    copy[21] = 0xFF;
+    CHECK(!app_thumbnail_find(copy, file_len, &offset, &size), "found with IFD0 running past the segment");
+
+    // Thumbnail offset past the segment, and not a JPEG
+    memcpy(copy, file, file_len);
+    copy[12 + 26 + 2 + 12 + 8 + 2] = 0x7F;
+    CHECK(!app_thumbnail_find(copy, file_len, &offset, &size), "found with the thumbnail out of the segment");
+    memcpy(copy, file, file_len);
+    copy[APP_THUMBNAIL_HEADER_SIZE + 1] = 0xD9;
+    CHECK(!app_thumbnail_find(copy, file_len, &offset, &size), "found a thumbnail which is not a JPEG");
+
+    // Any byte of the header changed, the thumbnail found must stay in the segment
+    srand(1);
+    for (int i = 0; i < 200000; i++) {
+        memcpy(copy, file, file_len);
+        for (int j = 0, n = 1 + rand() % 3; j < n; j++) {
+            copy[rand() % APP_THUMBNAIL_HEADER_SIZE] = rand();
+        }
+        size_t len = app_thumbnail_exif_length(copy);
+        if (len == 0 || len > file_len || !app_thumbnail_find(copy, len, &offset, &size)) {
+            continue;
+        }
+        CHECK(offset >= 12 && offset + size <= len && copy[offset] == 0xFF && copy[offset + 1] == 0xD8,
+              "thumbnail at %u, %u bytes, out of a segment of %zu", (unsigned)offset, (unsigned)size, len);
+    }
+}
+
+/* The album reads the EXIF segment, it read the whole picture before */
+static void bench_read(int n)
+{
+    char path[MAX_PATH_LEN];
+    uint8_t *thumb = malloc(THUMB_LEN);
+    uint8_t *pic = malloc(PICTURE_LEN);
+    uint8_t *file = malloc(APP_THUMBNAIL_HEADER_SIZE + THUMB_LEN + PICTURE_LEN);
+    uint8_t *buffer = malloc(APP_THUMBNAIL_HEADER_SIZE + APP_THUMBNAIL_MAX_SIZE);
+    uint32_t offset, size;
+    int found = 0;
+
+    fill_jpeg(thumb, THUMB_LEN, 1);
+    fill_jpeg(pic, PICTURE_LEN, 2);
+    size_t file_len = build_file(file, thumb, THUMB_LEN, pic, PICTURE_LEN);
+
+    snprintf(path, sizeof(path), "/tmp/thumbnail_bench_%d.jpg", (int)getpid());
+    FILE *f = fopen(path, "wb");
+    CHECK(f && fwrite(file, 1, file_len, f) == file_len, "failed to write %s", path);
+    if (f) {
+        fclose(f);
+    }
+
+    double start = now_ms();
+    for (int i = 0; i < n; i++) {
+        f = fopen(path, "rb");
+        if (!f) {
+            break;
+        }
+        size_t len = 0;
+        if (fread(buffer, 1, 6, f) == 6) {
+            len = app_thumbnail_exif_length(buffer);
+        }
+        if (len > 6 && len <= APP_THUMBNAIL_HEADER_SIZE + APP_THUMBNAIL_MAX_SIZE &&
+            fread(buffer + 6, 1, len - 6, f) == len - 6 && app_thumbnail_find(buffer, len, &offset, &size)) {
+            found++;
+        }
+        fclose(f);
+    }
+    double thumb_ms = now_ms() - start;
+    CHECK(found == n, "thumbnail found in %d of %d reads", found, n);
+
+    start = now_ms();
+    for (int i = 0; i < n; i++) {
+        f = fopen(path, "rb");
+        if (!f) {
+            break;
+        }
+        fseek(f, 0, SEEK_END);
+        size_t len = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        uint8_t *whole = malloc(len);
+        if (whole && fread(whole, 1, len, f) != len) {
+            CHECK(0, "failed to read %s", path);
+        }
+        free(whole);
+        fclose(f);
+    }
+    double whole_ms = now_ms() - start;
+
+    printf("read %d pictures: thumbnail %.3f ms each (%u bytes), whole picture %.3f ms each (%zu bytes)\n",
+           n, thumb_ms / n, (unsigned)(APP_THUMBNAIL_HEADER_SIZE + THUMB_LEN), whole_ms / n, file_len);
+
+    unlink(path);
+    free(thumb);
+    free(pic);
+    free(file);
+    free(buffer);
+}
+
+int main(int argc, char **argv)
+{
+    int n = 200;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        if (opt == 'n') {
+            n = atoi(optarg);
+        } else {
+            fprintf(stderr, "Usage: %s [-n pictures]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (n < 1) {
+        n = 1;
+    }
+
+    test_round_trip();
+    test_other_cameras();
+    test_broken();
+    bench_read(n);
+
+    if (s_failures) {
+        printf("%d failure(s)\n", s_failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
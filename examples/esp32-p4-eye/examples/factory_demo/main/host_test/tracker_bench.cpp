@@ -0,0 +1,458 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Tracker of the AI pages (app_detect_tracker.cpp) on synthetic detections.
+ *
+ * - match: a box moving at constant speed keeps its track and id, the velocity converges
+ *   and the boxes between detections are extrapolated onto the object, keypoints included;
+ *   two objects crossing keep their ids, other categories and empty boxes are not matched;
+ * - miss: a track missing from up to two detections is kept and extrapolated, and picks
+ *   the object up again where it went;
+ * - expire: a track missing from a third detection is dropped, a new object gets a new
+ *   id, boxes stop moving 15 frames past their last detection, older results are ignored;
+ * - interval: steady tracks make the tracker ask for a detection every 6 frames at most,
+ *   a new object, a lost one or a prediction off by more than a quarter of the box makes
+ *   it ask for every frame again;
+ * - prints, for objects moving in several ways with a detector several frames late, the
+ *   detections run and the error of the boxes drawn, next to drawing the last detection
+ *   as the AI pages did before.
+ *
+ * Usage:
+ *     tracker_bench [-n frames]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "app_detect_tracker.h"
+
+// As in app_detect_tracker.cpp
+#define MAX_MISSES      (2)
+#define PREDICT_MAX     (15)
+#define INTERVAL_MAX    (6)
+
+#define BOX_W           (60)
+#define BOX_H           (80)
+#define CAT_PERSON      (0)
+#define CAT_CAR         (2)
+
+static int s_failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            s_failures++; \
+        } \
+    } while (0)
+
+/* A detection of a BOX_W x BOX_H box centered on (x, y), with a keypoint 10 px above the center */
+static camera_pipeline_result_t detection(float x, float y, int category = CAT_PERSON)
+{
+    camera_pipeline_result_t r;
+
+    memset(&r, 0, sizeof(r));
+    r.category = category;
+    r.score = 0.9f;
+    r.box[0] = (int)lroundf(x - BOX_W / 2.0f);
+    r.box[1] = (int)lroundf(y - BOX_H / 2.0f);
+    r.box[2] = (int)lroundf(x + BOX_W / 2.0f);
+    r.box[3] = (int)lroundf(y + BOX_H / 2.0f);
+    r.keypoint_num = 2;
+    r.keypoint[0] = (int)lroundf(x);
+    r.keypoint[1] = (int)lroundf(y) - 10;
+    return r;
+}
+
+static float center_x(const camera_pipeline_result_t *r)
+{
+    return (r->box[0] + r->box[2]) / 2.0f;
+}
+
+static float center_y(const camera_pipeline_result_t *r)
+{
+    return (r->box[1] + r->box[3]) / 2.0f;
+}
+
+static const app_detect_track_t *find_track(const app_detect_tracker_t *tracker, int id)
+{
+    for (int t = 0; t < tracker->track_num; t++) {
+        if (tracker->tracks[t].id == id) {
+            return &tracker->tracks[t];
+        }
+    }
+    return NULL;
+}
+
+static void test_match(void)
+{
+    app_detect_tracker_t tracker;
+    camera_pipeline_result_t out[DETECT_TRACKER_MAX_NUM];
+    int before = s_failures;
+
+    // One box moving by (4, 2) per frame, detected every other frame
+    app_detect_tracker_reset(&tracker);
+    for (uint32_t seq = 1; seq <= 41; seq += 2) {
+        camera_pipeline_result_t r = detection(100 + 4.0f * seq, 100 + 2.0f * seq);
+        app_detect_tracker_update(&tracker, &r, 1, seq);
+        CHECK(tracker.track_num == 1 && tracker.tracks[0].id == 0, "frame %u: %d tracks, id %d", (unsigned)seq,
+              tracker.track_num, tracker.tracks[0].id);
+    }
+    const app_detect_track_t *track = &tracker.tracks[0];
+    CHECK(fabsf(track->vx - 4) < 0.05f && fabsf(track->vy - 2) < 0.05f, "velocity (%.3f, %.3f)", track->vx, track->vy);
+    CHECK(track->hits == 21 && track->misses == 0, "%d hits, %d misses", track->hits, track->misses);
+
+    // Between and after detections, the box is where the object is
+    for (uint32_t seq = 41; seq <= 47; seq++) {
+        int num = app_detect_tracker_predict(&tracker, seq, out, DETECT_TRACKER_MAX_NUM);
+        CHECK(num == 1, "frame %u: %d boxes", (unsigned)seq, num);
+        CHECK(fabsf(center_x(&out[0]) - (100 + 4.0f * seq)) <= 1 && fabsf(center_y(&out[0]) - (100 + 2.0f * seq)) <= 1,
+              "frame %u: box at (%.1f, %.1f), object at (%.1f, %.1f)", (unsigned)seq, center_x(&out[0]),
+              center_y(&out[0]), 100 + 4.0f * seq, 100 + 2.0f * seq);
+        CHECK(out[0].box[2] - out[0].box[0] == BOX_W && out[0].box[3] - out[0].box[1] == BOX_H, "frame %u: box %dx%d",
+              (unsigned)seq, out[0].box[2] - out[0].box[0], out[0].box[3] - out[0].box[1]);
+        CHECK(out[0].keypoint_num == 2 && abs(out[0].keypoint[0] - (int)lroundf(center_x(&out[0]))) <= 1 &&
+              abs(out[0].keypoint[1] + 10 - (int)lroundf(center_y(&out[0]))) <= 1,
+              "frame %u: keypoint (%d, %d) not with the box", (unsigned)seq, out[0].keypoint[0], out[0].keypoint[1]);
+        CHECK(out[0].category == CAT_PERSON && out[0].score == 0.9f, "frame %u: category or score lost", (unsigned)seq);
+    }
+    CHECK(app_detect_tracker_predict(&tracker, 45, out, 0) == 0, "boxes past max_num");
+
+    // Two people crossing, and a car on the path of one of them: each keeps its id
+    app_detect_tracker_reset(&tracker);
+    int id_a = -1, id_b = -1, id_car = -1;
+    for (uint32_t seq = 1; seq <= 40; seq++) {
+        camera_pipeline_result_t r[4] = {
+            detection(100 + 5.0f * seq, 200),
+            detection(300 - 5.0f * seq, 210),
+            detection(300 - 5.0f * seq, 205, CAT_CAR),
+            {},         // empty box, as detectors leave in unused results
+        };
+        app_detect_tracker_update(&tracker, r, 4, seq);
+        CHECK(tracker.track_num == 3, "frame %u: %d tracks", (unsigned)seq, tracker.track_num);
+        if (seq == 1) {
+            id_a = tracker.tracks[0].id;
+            id_b = tracker.tracks[1].id;
+            id_car = tracker.tracks[2].id;
+            continue;
+        }
+        const app_detect_track_t *a = find_track(&tracker, id_a);
+        const app_detect_track_t *b = find_track(&tracker, id_b);
+        const app_detect_track_t *car = find_track(&tracker, id_car);
+        CHECK(a && b && car, "frame %u: an id changed", (unsigned)seq);
+        if (a && b && car) {
+            CHECK(fabsf(a->x - (100 + 5.0f * seq)) < 3 && fabsf(b->x - (300 - 5.0f * seq)) < 3 &&
+                  car->result.category == CAT_CAR, "frame %u: tracks swapped, a at %.1f, b at %.1f", (unsigned)seq,
+                  a->x, b->x);
+        }
+    }
+    CHECK(tracker.next_id == 3, "%d ids handed out", tracker.next_id);
+
+    // Results past the size of a detection are ignored
+    app_detect_tracker_reset(&tracker);
+    camera_pipeline_result_t many[CAMERA_PIPELINE_RESULT_MAX_NUM + 2];
+    for (int i = 0; i < CAMERA_PIPELINE_RESULT_MAX_NUM + 2; i++) {
+        many[i] = detection(40 + 100.0f * i, 100);
+    }
+    app_detect_tracker_update(&tracker, many, CAMERA_PIPELINE_RESULT_MAX_NUM + 2, 1);
+    CHECK(tracker.track_num == CAMERA_PIPELINE_RESULT_MAX_NUM, "%d tracks from too many results", tracker.track_num);
+
+    printf("%-46s %s\n", "match", s_failures > before ? "FAIL" : "PASS");
+}
+
+static void test_miss_expire(void)
+{
+    app_detect_tracker_t tracker;
+    camera_pipeline_result_t out[DETECT_TRACKER_MAX_NUM];
+    int before = s_failures;
+
+    app_detect_tracker_reset(&tracker);
+    for (uint32_t seq = 1; seq <= 10; seq++) {
+        camera_pipeline_result_t r = detection(100 + 3.0f * seq, 150);
+        app_detect_tracker_update(&tracker, &r, 1, seq);
+    }
+    int id = tracker.tracks[0].id;
+
+    // Missed by two detections: kept, and still moving
+    for (uint32_t seq = 11; seq <= 10 + MAX_MISSES; seq++) {
+        app_detect_tracker_update(&tracker, NULL, 0, seq);
+        CHECK(tracker.track_num == 1 && tracker.tracks[0].misses == (int)(seq - 10), "frame %u: %d tracks",
+              (unsigned)seq, tracker.track_num);
+        CHECK(app_detect_tracker_predict(&tracker, seq, out, DETECT_TRACKER_MAX_NUM) == 1 &&
+              fabsf(center_x(&out[0]) - (100 + 3.0f * seq)) <= 1, "frame %u: box at %.1f, object at %.1f",
+              (unsigned)seq, center_x(&out[0]), 100 + 3.0f * seq);
+    }
+    // Found again where it went, with the same id
+    camera_pipeline_result_t r = detection(100 + 3.0f * 13, 150);
+    app_detect_tracker_update(&tracker, &r, 1, 13);
+    CHECK(tracker.track_num == 1 && tracker.tracks[0].id == id && tracker.tracks[0].misses == 0,
+          "the object found again has id %d, expected %d", tracker.tracks[0].id, id);
+
+    // Missed by a third detection: dropped
+    for (uint32_t seq = 14; seq <= 14 + MAX_MISSES; seq++) {
+        app_detect_tracker_update(&tracker, NULL, 0, seq);
+    }
+    CHECK(tracker.track_num == 0, "%d tracks after %d misses", tracker.track_num, MAX_MISSES + 1);
+    CHECK(app_detect_tracker_predict(&tracker, 17, out, DETECT_TRACKER_MAX_NUM) == 0, "boxes of a dropped track");
+    r = detection(100 + 3.0f * 17, 150);
+    app_detect_tracker_update(&tracker, &r, 1, 17);
+    CHECK(tracker.track_num == 1 && tracker.tracks[0].id == id + 1, "the object after expiry has id %d, expected %d",
+          tracker.tracks[0].id, id + 1);
+
+    // Results of a frame older than the last update change nothing
+    app_detect_tracker_t copy = tracker;
+    r = detection(400, 400);
+    app_detect_tracker_update(&tracker, &r, 1, 16);
+    app_detect_tracker_update(&tracker, &r, 1, 17);
+    CHECK(memcmp(&copy, &tracker, sizeof(tracker)) == 0, "older results were used");
+
+    // A box stops PREDICT_MAX frames past its last detection, and never moves back in time
+    app_detect_tracker_reset(&tracker);
+    for (uint32_t seq = 1; seq <= 5; seq++) {
+        r = detection(100 + 2.0f * seq, 150);
+        app_detect_tracker_update(&tracker, &r, 1, seq);
+    }
+    app_detect_tracker_predict(&tracker, 5 + PREDICT_MAX, out, DETECT_TRACKER_MAX_NUM);
+    float at_max = center_x(&out[0]);
+    app_detect_tracker_predict(&tracker, 5 + PREDICT_MAX + 30, out, DETECT_TRACKER_MAX_NUM);
+    CHECK(center_x(&out[0]) == at_max && fabsf(at_max - (100 + 2.0f * (5 + PREDICT_MAX))) <= 1,
+          "box at %.1f long after the detection, %.1f at the limit", center_x(&out[0]), at_max);
+    app_detect_tracker_predict(&tracker, 3, out, DETECT_TRACKER_MAX_NUM);
+    CHECK(fabsf(center_x(&out[0]) - 110) <= 1, "box at %.1f before its detection", center_x(&out[0]));
+
+    // Sequence numbers wrapping around
+    app_detect_tracker_reset(&tracker);
+    for (uint32_t seq = UINT32_MAX - 4; seq != 5; seq++) {
+        r = detection(200 + 2.0f * (int32_t)seq, 150);
+        app_detect_tracker_update(&tracker, &r, 1, seq);
+    }
+    CHECK(tracker.track_num == 1 && tracker.tracks[0].id == 0 && fabsf(tracker.tracks[0].vx - 2) < 0.1f,
+          "%d tracks, velocity %.2f across the wrap", tracker.track_num, tracker.tracks[0].vx);
+
+    printf("%-46s %s\n", "miss and expire", s_failures > before ? "FAIL" : "PASS");
+}
+
+static void test_interval(void)
+{
+    app_detect_tracker_t tracker;
+    int before = s_failures;
+
+    app_detect_tracker_reset(&tracker);
+    CHECK(tracker.interval == 1, "interval %d after reset", tracker.interval);
+
+    // A steady object: the interval grows by one per detection up to the maximum
+    uint32_t seq = 1;
+    int interval = 1;
+    for (int i = 0; i < 12; i++, seq++) {
+        camera_pipeline_result_t r = detection(100 + 2.0f * seq, 150);
+        app_detect_tracker_update(&tracker, &r, 1, seq);
+        if (i > 0 && interval < INTERVAL_MAX) {
+            interval++;
+        }
+        CHECK(tracker.interval == interval, "update %d: interval %d, expected %d", i, tracker.interval, interval);
+    }
+
+    // need_detect counts from the frame last handed to the detector
+    app_detect_tracker_detect_started(&tracker, 100);
+    for (uint32_t f = 100; f < 100 + INTERVAL_MAX; f++) {
+        CHECK(!app_detect_tracker_need_detect(&tracker, f), "detection asked at frame %u", (unsigned)f);
+    }
+    CHECK(app_detect_tracker_need_detect(&tracker, 100 + INTERVAL_MAX), "no detection asked after %d frames",
+          INTERVAL_MAX);
+
+    // A new object: every frame again
+    camera_pipeline_result_t two[2] = {detection(100 + 2.0f * seq, 150), detection(400, 300)};
+    app_detect_tracker_update(&tracker, two, 2, seq++);
+    CHECK(tracker.interval == 1, "interval %d after a new object", tracker.interval);
+
+    // Steady again, then one object is lost
+    for (int i = 0; i < 8; i++, seq++) {
+        two[0] = detection(100 + 2.0f * seq, 150);
+        app_detect_tracker_update(&tracker, two, 2, seq);
+    }
+    CHECK(tracker.interval == INTERVAL_MAX, "interval %d with two steady objects", tracker.interval);
+    two[0] = detection(100 + 2.0f * seq, 150);
+    app_detect_tracker_update(&tracker, two, 1, seq++);
+    CHECK(tracker.interval == 1, "interval %d after an object was lost", tracker.interval);
+
+    // Steady again, then the prediction is off by 0.28 box widths: still matched, every frame again
+    app_detect_tracker_reset(&tracker);
+    camera_pipeline_result_t r;
+    for (seq = 1; seq <= 10; seq++) {
+        r = detection(200, 150);
+        app_detect_tracker_update(&tracker, &r, 1, seq);
+    }
+    CHECK(tracker.interval == INTERVAL_MAX, "interval %d with a still object", tracker.interval);
+    r = detection(200 + 0.28f * BOX_W, 150);
+    app_detect_tracker_update(&tracker, &r, 1, seq++);
+    CHECK(tracker.track_num == 1 && tracker.tracks[0].id == 0, "the object was not matched after a jump");
+    CHECK(tracker.interval == 1, "interval %d after a prediction error of 0.28", tracker.interval);
+
+    // An error between the two thresholds keeps the interval
+    for (int i = 0; i < 12; i++, seq++) {
+        r = detection(200 + 0.28f * BOX_W, 150);
+        app_detect_tracker_update(&tracker, &r, 1, seq);
+    }
+    interval = tracker.interval;
+    r = detection(200 + 0.28f * BOX_W + 0.15f * BOX_W, 150);
+    app_detect_tracker_update(&tracker, &r, 1, seq++);
+    CHECK(tracker.interval == interval, "interval %d after an error of 0.15, was %d", tracker.interval, interval);
+
+    printf("%-46s %s\n", "interval", s_failures > before ? "FAIL" : "PASS");
+}
+
+/* Motion of an object at a frame */
+typedef struct {
+    const char *name;
+    void (*at)(uint32_t frame, float *x, float *y);
+} motion_t;
+
+/* From 0 to length and back, at speed pixels per frame */
+static float bounce(uint32_t frame, float speed, float length)
+{
+    float d = fmodf(speed * frame, 2 * length);
+    return d < length ? d : 2 * length - d;
+}
+
+static void still(uint32_t frame, float *x, float *y)
+{
+    (void)frame;
+    *x = 400;
+    *y = 300;
+}
+
+static void walk(uint32_t frame, float *x, float *y)
+{
+    *x = 100 + bounce(frame, 3, 600);
+    *y = 300;
+}
+
+static void run(uint32_t frame, float *x, float *y)
+{
+    *x = 100 + bounce(frame, 8, 600);
+    *y = 200 + bounce(frame, 2, 200);
+}
+
+static void circle(uint32_t frame, float *x, float *y)
+{
+    float a = 2 * (float)M_PI * frame / 90;
+    *x = 400 + 120 * cosf(a);
+    *y = 300 + 120 * sinf(a);
+}
+
+/*
+ * A detector taking `latency` frames per detection, fed when the tracker asks and it is idle. The box drawn nearest
+ * to the object on each frame is compared with it, once from the tracker and once as the last detection. Frames
+ * without a box and boxes beside the object's are counted.
+ */
+static void simulate(const motion_t *m, uint32_t frames, uint32_t latency, bool check)
+{
+    app_detect_tracker_t tracker;
+    camera_pipeline_result_t pending, last, out[DETECT_TRACKER_MAX_NUM];
+    uint32_t pending_seq = 0, due = 0, detections = 0, drawn = 0, empty = 0, extra = 0;
+    bool busy = false, have_last = false;
+    double err_track = 0, err_last = 0;
+    float max_track = 0;
+    uint32_t noise = 1;
+
+    app_detect_tracker_reset(&tracker);
+    for (uint32_t f = 1; f <= frames; f++) {
+        float x, y;
+        m->at(f, &x, &y);
+
+        if (busy && f == due) {
+            app_detect_tracker_update(&tracker, &pending, 1, pending_seq);
+            last = pending;
+            have_last = true;
+            busy = false;
+        }
+        if (!busy && app_detect_tracker_need_detect(&tracker, f)) {
+            // A detection off by up to a pixel
+            noise = noise * 1103515245u + 12345u;
+            pending = detection(x + (int)((noise >> 16) % 3) - 1, y + (int)((noise >> 20) % 3) - 1);
+            pending_seq = f;
+            due = f + latency;
+            busy = true;
+            detections++;
+            app_detect_tracker_detect_started(&tracker, f);
+        }
+        if (!have_last) {
+            continue;
+        }
+
+        int num = app_detect_tracker_predict(&tracker, f, out, DETECT_TRACKER_MAX_NUM);
+        if (num == 0) {
+            empty++;
+            continue;
+        }
+        float e = INFINITY;
+        for (int i = 0; i < num; i++) {
+            e = fminf(e, hypotf(center_x(&out[i]) - x, center_y(&out[i]) - y));
+        }
+        extra += num - 1;
+        err_track += e;
+        max_track = fmaxf(max_track, e);
+        err_last += hypotf(center_x(&last) - x, center_y(&last) - y);
+        drawn++;
+    }
+
+    double mean_track = drawn ? err_track / drawn : 0, mean_last = drawn ? err_last / drawn : 0;
+    printf("%-8s %u late %8.1f %10.2f %10.2f %8.1f %8u %8u\n", m->name, latency, 100.0 * detections / frames,
+           mean_track, mean_last, max_track, empty, extra);
+    if (check) {
+        CHECK(empty == 0, "%s: no box on %u frames", m->name, empty);
+        CHECK(mean_track < mean_last || mean_track <= 1.5, "%s: the tracked boxes are further off than the last "
+              "detection (%.2f, %.2f)", m->name, mean_track, mean_last);
+        if (m->at == still) {
+            CHECK(detections * 4 <= frames, "%s: %u detections in %u frames", m->name, detections, frames);
+            CHECK(extra == 0, "%s: %u boxes beside the object", m->name, extra);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int frames = 3000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+        case 'n':
+            frames = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n frames]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (frames < 200) {
+        frames = 200;
+    }
+
+    test_match();
+    test_miss_expire();
+    test_interval();
+
+    static const motion_t motions[] = {
+        {"still", still},
+        {"walk", walk},
+        {"run", run},
+        {"circle", circle},
+    };
+    printf("\n%-15s %8s %10s %10s %8s %8s %8s\n", "", "detect %", "tracked", "last", "max", "no box", "extra");
+    for (size_t m = 0; m < sizeof(motions) / sizeof(motions[0]); m++) {
+        for (uint32_t latency = 1; latency <= 4; latency += 3) {
+            simulate(&motions[m], frames, latency, true);
+        }
+    }
+
+    printf("%s\n", s_failures ? "FAIL" : "PASS");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,392 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "audio_resample.h"
+
+#define RESAMPLE_CHUNK_FRAMES   (256)       /*!< input frames buffered per refill, besides the filter history */
+#define RESAMPLE_MAX_RATE       (192000)
+#define RESAMPLE_MAX_DOWN       (4)         /*!< filter length grows with the downsampling factor up to this */
+#define RESAMPLE_MAX_RATIO      (8)         /*!< largest downsampling factor */
+
+typedef struct {
+    int taps;               /*!< even, per output frame when downsampling */
+    int phases_shift;       /*!< log2 of the number of table phases */
+    int interpolate;        /*!< interpolate between the two nearest phases */
+    float rolloff;          /*!< cutoff relative to the lower Nyquist frequency */
+    float beta;             /*!< Kaiser window, higher is more stopband attenuation and a wider transition */
+} resample_tier_t;
+
+static const resample_tier_t s_tiers[AUDIO_RESAMPLE_QUALITY_MAX] = {
+    [AUDIO_RESAMPLE_QUALITY_LOW]    = {  8, 5, 0, 0.80f, 5.0f },
+    [AUDIO_RESAMPLE_QUALITY_MEDIUM] = { 16, 6, 1, 0.88f, 7.0f },
+    [AUDIO_RESAMPLE_QUALITY_HIGH]   = { 32, 7, 1, 0.92f, 9.0f },
+};
+
+struct audio_resample {
+    const resample_tier_t *tier;
+    int in_rate;
+    int in_channels;
+    int out_rate;
+    int out_channels;
+
+    int taps;               /*!< filter length in input frames */
+    int16_t *coefs;         /*!< (phases + 1) rows of taps Q15 coefficients, row p is for a fraction of p / phases */
+    int coefs_taps;         /*!< taps the table has been allocated for */
+    float cutoff;           /*!< of the table in coefs, relative to the input Nyquist frequency, 0 if not built */
+    int up;                 /*!< output rate / gcd */
+    int down;               /*!< input rate / gcd */
+    int step_phase;         /*!< advance per output frame in whole phases ... */
+    int step_rem;           /*!< ... and in 1 / up of a phase */
+    uint64_t rem_to_q15;    /*!< (rem * rem_to_q15) >> 32 is rem / up in Q15 */
+
+    int16_t *buf;           /*!< interleaved input, the filter history followed by new frames */
+    int buf_size;           /*!< in frames refilled up to, taps + RESAMPLE_CHUNK_FRAMES, taps / 2 more are allocated */
+    int buf_frames;
+    int pos;                /*!< first frame of the window of the next output frame */
+    int phase;              /*!< fraction of its position, phase + rem / up in 1 / phases of a frame */
+    int rem;
+    int flushing;
+    int flush_end;          /*!< buffer frame after the last real input frame while flushing */
+};
+
+static int gcd(int a, int b)
+{
+    while (b) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+
+    return a;
+}
+
+/*!< zeroth order modified Bessel function of the first kind, for the Kaiser window */
+static float bessel_i0(float x)
+{
+    float sum = 1.0f;
+    float term = 1.0f;
+
+    for (int k = 1; k < 32 && term > sum * 1e-8f; k++) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+    }
+
+    return sum;
+}
+
+/*!< windowed sinc table, only depends on the tier, the filter length and the cutoff so it is kept when possible */
+static void resample_make_table(audio_resample_handle_t s, float cutoff)
+{
+    const resample_tier_t *tier = s->tier;
+    int taps = s->taps;
+    int phases = 1 << tier->phases_shift;
+    float half = taps / 2;
+    float i0_beta = bessel_i0(tier->beta);
+    float row[RESAMPLE_MAX_DOWN * 32];
+
+    for (int p = 0; p <= phases; p++) {
+        float sum = 0.0f;
+
+        for (int j = 0; j < taps; j++) {
+            /*!< distance of tap j from the output position */
+            float x = j - (half - 1) - (float)p / phases;
+            float r = x / half;
+            float w = r * r < 1.0f ? bessel_i0(tier->beta * sqrtf(1.0f - r * r)) / i0_beta : 0.0f;
+            float t = (float)M_PI * cutoff * x;
+            row[j] = w * (x == 0.0f ? 1.0f : sinf(t) / t);
+            sum += row[j];
+        }
+
+        /*!< unity gain at DC for every phase, the rounding error goes to the largest tap */
+        int16_t *c = s->coefs + p * taps;
+        int total = 0;
+        int peak = 0;
+
+        for (int j = 0; j < taps; j++) {
+            c[j] = (int16_t)lrintf(row[j] * 32768.0f / sum);
+            total += c[j];
+            peak = c[j] > c[peak] ? j : peak;
+        }
+
+        c[peak] += 32768 - total;
+    }
+
+    s->cutoff = cutoff;
+}
+
+static int resample_configure(audio_resample_handle_t s, int in_rate, int in_channels)
+{
+    /*!< one output frame must not step over a whole window, or the buffer would run dry under it */
+    if (in_rate <= 0 || in_rate > RESAMPLE_MAX_RATE || in_rate > (int64_t)s->out_rate * RESAMPLE_MAX_RATIO
+            || in_channels < 1 || in_channels > 2) {
+        return -1;
+    }
+
+    /*!< below the lower of the two Nyquist frequencies, so downsampling does not alias, with a filter that
+     *   is proportionally longer so the transition band stays as narrow relative to the output rate */
+    int phases_shift = s->tier->phases_shift;
+    int factor = (in_rate + s->out_rate - 1) / s->out_rate;
+    int taps = s->tier->taps * (factor > RESAMPLE_MAX_DOWN ? RESAMPLE_MAX_DOWN : factor);
+    float cutoff = s->tier->rolloff * (in_rate > s->out_rate ? (float)s->out_rate / in_rate : 1.0f);
+
+    if (taps > s->coefs_taps) {
+        int16_t *coefs = realloc(s->coefs, ((1 << phases_shift) + 1) * taps * sizeof(int16_t));
+
+        if (coefs == NULL) {
+            return -1;
+        }
+        s->coefs = coefs;
+        s->cutoff = 0.0f;
+
+        /*!< refills stop at buf_size, the half window of silence of audio_resample_flush goes behind it */
+        int16_t *buf = realloc(s->buf, (taps + RESAMPLE_CHUNK_FRAMES + taps / 2) * 2 * sizeof(int16_t));
+
+        if (buf == NULL) {
+            return -1;
+        }
+        s->buf = buf;
+        s->coefs_taps = taps;
+        s->buf_size = taps + RESAMPLE_CHUNK_FRAMES;
+    }
+
+    if (cutoff != s->cutoff || taps != s->taps) {
+        s->taps = taps;
+        resample_make_table(s, cutoff);
+    }
+
+    int g = gcd(in_rate, s->out_rate);
+
+    s->in_rate = in_rate;
+    s->in_channels = in_channels;
+    s->up = s->out_rate / g;
+    s->down = in_rate / g;
+    /*!< one output frame is down / up input frames, i.e. (down << phases_shift) / up phases */
+    s->step_phase = (int)(((int64_t)s->down << phases_shift) / s->up);
+    s->step_rem = (int)(((int64_t)s->down << phases_shift) % s->up);
+    s->rem_to_q15 = ((uint64_t)1 << 47) / s->up;
+
+    audio_resample_reset(s);
+
+    return 0;
+}
+
+audio_resample_handle_t audio_resample_create(int in_rate, int in_channels, int out_rate, int out_channels,
+                                              audio_resample_quality_t quality)
+{
+    if (out_rate <= 0 || out_rate > RESAMPLE_MAX_RATE || out_channels < 1 || out_channels > 2
+            || quality < 0 || quality >= AUDIO_RESAMPLE_QUALITY_MAX) {
+        return NULL;
+    }
+
+    audio_resample_handle_t s = calloc(1, sizeof(struct audio_resample));
+
+    if (s == NULL) {
+        return NULL;
+    }
+
+    s->tier = &s_tiers[quality];
+    s->out_rate = out_rate;
+    s->out_channels = out_channels;
+
+    if (resample_configure(s, in_rate, in_channels) != 0) {
+        audio_resample_delete(s);
+        return NULL;
+    }
+
+    return s;
+}
+
+void audio_resample_delete(audio_resample_handle_t handle)
+{
+    if (handle) {
+        free(handle->coefs);
+        free(handle->buf);
+        free(handle);
+    }
+}
+
+int audio_resample_set_input(audio_resample_handle_t handle, int in_rate, int in_channels)
+{
+    return resample_configure(handle, in_rate, in_channels);
+}
+
+void audio_resample_reset(audio_resample_handle_t handle)
+{
+    /*!< history of zeros, so the first output frame is centered on the first input frame */
+    handle->buf_frames = handle->taps / 2 - 1;
+    memset(handle->buf, 0, handle->buf_frames * handle->in_channels * sizeof(int16_t));
+    handle->pos = 0;
+    handle->phase = 0;
+    handle->rem = 0;
+    handle->flushing = 0;
+    handle->flush_end = 0;
+}
+
+static inline int16_t resample_clip(int32_t x)
+{
+    return x > INT16_MAX ? INT16_MAX : (x < INT16_MIN ? INT16_MIN : (int16_t)x);
+}
+
+static inline void resample_store(audio_resample_handle_t s, int16_t *out, int32_t l, int32_t r)
+{
+    if (s->out_channels == 2) {
+        out[0] = resample_clip(l);
+        out[1] = resample_clip(r);
+    } else {
+        out[0] = resample_clip((l + r) >> 1);
+    }
+}
+
+/*!< produce output frames from the buffered input, stops where the window would run past the end */
+static int resample_run(audio_resample_handle_t s, int16_t *out, int out_frames, int last_center)
+{
+    const int taps = s->taps;
+    const int shift = s->tier->phases_shift;
+    const int mask = (1 << shift) - 1;
+    const int center = taps / 2 - 1;
+    int n = 0;
+
+    while (n < out_frames && s->pos + taps <= s->buf_frames && s->pos + center < last_center) {
+        const int16_t *c0 = s->coefs + s->phase * taps;
+        const int16_t *x = s->buf + s->pos * s->in_channels;
+        int32_t l0 = 0, r0 = 0;
+
+        /*!< |sum| stays below 2^31: the taps of a phase add up to 1.0 in Q15 and the largest negative lobes to less than 0.5 */
+        if (s->in_channels == 2) {
+            for (int j = 0; j < taps; j++) {
+                l0 += x[2 * j] * c0[j];
+                r0 += x[2 * j + 1] * c0[j];
+            }
+        } else {
+            for (int j = 0; j < taps; j++) {
+                l0 += x[j] * c0[j];
+            }
+            r0 = l0;
+        }
+
+        if (s->tier->interpolate && s->rem) {
+            const int16_t *c1 = c0 + taps;
+            int32_t l1 = 0, r1 = 0;
+            int32_t w = (int32_t)(((uint64_t)s->rem * s->rem_to_q15) >> 32);
+
+            if (s->in_channels == 2) {
+                for (int j = 0; j < taps; j++) {
+                    l1 += x[2 * j] * c1[j];
+                    r1 += x[2 * j + 1] * c1[j];
+                }
+            } else {
+                for (int j = 0; j < taps; j++) {
+                    l1 += x[j] * c1[j];
+                }
+                r1 = l1;
+            }
+
+            l0 += (int32_t)((((int64_t)l1 - l0) * w) >> 15);
+            r0 += (int32_t)((((int64_t)r1 - r0) * w) >> 15);
+        }
+
+        resample_store(s, out + n * s->out_channels, (l0 + (1 << 14)) >> 15, (r0 + (1 << 14)) >> 15);
+        n++;
+
+        /*!< exact rational step, no drift */
+        s->rem += s->step_rem;
+        if (s->rem >= s->up) {
+            s->rem -= s->up;
+            s->phase++;
+        }
+        s->phase += s->step_phase;
+        s->pos += s->phase >> shift;
+        s->phase &= mask;
+    }
+
+    return n;
+}
+
+/*!< same rate: only the channel count may change, no filter and no delay */
+static int resample_copy(audio_resample_handle_t s, const int16_t *in, int frames, int16_t *out)
+{
+    if (s->in_channels == s->out_channels) {
+        memcpy(out, in, frames * s->in_channels * sizeof(int16_t));
+    } else {
+        for (int i = 0; i < frames; i++) {
+            int32_t l = in[i * s->in_channels];
+            int32_t r = in[i * s->in_channels + s->in_channels - 1];
+            resample_store(s, out + i * s->out_channels, l, r);
+        }
+    }
+
+    return frames;
+}
+
+int audio_resample_process(audio_resample_handle_t handle, const int16_t *in, int in_frames, int *in_used,
+                           int16_t *out, int out_frames)
+{
+    audio_resample_handle_t s = handle;
+    int used = 0;
+    int produced = 0;
+
+    if (s->in_rate == s->out_rate) {
+        produced = resample_copy(s, in, in_frames < out_frames ? in_frames : out_frames, out);
+        *in_used = produced;
+        return produced;
+    }
+
+    while (1) {
+        produced += resample_run(s, out + produced * s->out_channels, out_frames - produced, INT32_MAX);
+
+        if (produced == out_frames || used == in_frames) {
+            break;
+        }
+
+        /*!< keep the frames the next window still needs, then refill behind them */
+        int keep = s->buf_frames - s->pos;
+        memmove(s->buf, s->buf + s->pos * s->in_channels, keep * s->in_channels * sizeof(int16_t));
+        s->buf_frames = keep;
+        s->pos = 0;
+
+        int n = s->buf_size - s->buf_frames;
+        n = n < in_frames - used ? n : in_frames - used;
+        memcpy(s->buf + s->buf_frames * s->in_channels, in + used * s->in_channels, n * s->in_channels * sizeof(int16_t));
+        s->buf_frames += n;
+        used += n;
+    }
+
+    *in_used = used;
+    return produced;
+}
+
+int audio_resample_flush(audio_resample_handle_t handle, int16_t *out, int out_frames)
+{
+    audio_resample_handle_t s = handle;
+
+    if (s->in_rate == s->out_rate) {
+        return 0;
+    }
+
+    if (!s->flushing) {
+        /*!< half a window of silence behind the last frame, in the room allocated behind buf_size */
+        int keep = s->buf_frames - s->pos;
+        int pad = s->taps / 2;
+        memmove(s->buf, s->buf + s->pos * s->in_channels, keep * s->in_channels * sizeof(int16_t));
+        memset(s->buf + keep * s->in_channels, 0, pad * s->in_channels * sizeof(int16_t));
+        s->pos = 0;
+        s->flush_end = keep;
+        s->buf_frames = keep + pad;
+        s->flushing = 1;
+    }
+
+    /*!< output frames up to the time of the last input frame */
+    int n = resample_run(s, out, out_frames, s->flush_end);
+
+    if (n < out_frames) {
+        audio_resample_reset(s);
+    }
+
+    return n;
+}
@@ -0,0 +1,269 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Quality and cycle benchmark for the sample rate converter (audio_resample.h).
+ *
+ * For every quality tier and every rate pair the players use, a two tone sine (a
+ * different tone per channel) is converted in random sized pieces and compared with
+ * the ideal sine at the output rate: the output must have exactly the expected length
+ * after audio_resample_flush, no channel may be swapped, and the SNR must reach the
+ * minimum of the tier. Downsampling cases also convert a tone that would alias into the
+ * top of the output band, which must be attenuated. Each case is also converted into output
+ * pieces of a few frames, so the converter often stops right after a refill of its buffer,
+ * and flushed from there: the output must be the same. The time per output frame is printed
+ * for each case.
+ *
+ * Usage:
+ *     resample_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "audio_resample.h"
+
+#define SECONDS         2
+#define AMPLITUDE       16000.0
+#define EDGE_FRAMES     64          /*!< not compared, the filter starts and ends on silence */
+#define BENCH_REPEAT    5
+
+typedef struct {
+    int in_rate;
+    int in_channels;
+    int out_rate;
+    int out_channels;
+    double tone_hz;
+} resample_case_t;
+
+static const resample_case_t s_cases[] = {
+    {  8000, 2, 44100, 2,  1000.0 },    /*!< lemon_tree_8k.mp3 */
+    { 16000, 1, 44100, 2,  1000.0 },    /*!< esp_tts */
+    { 22050, 2, 44100, 2,  3000.0 },
+    { 32000, 2, 44100, 2,  3000.0 },
+    { 48000, 2, 44100, 2,  3000.0 },
+    { 44100, 2, 44100, 2,  3000.0 },    /*!< passthrough */
+    { 44100, 2, 16000, 1,  1000.0 },
+    { 48000, 1, 16000, 1,  1000.0 },
+    { 11025, 1, 48000, 1,  1000.0 },
+};
+
+static const char *const s_tier_names[AUDIO_RESAMPLE_QUALITY_MAX] = { "low", "medium", "high" };
+static const double s_min_snr_db[AUDIO_RESAMPLE_QUALITY_MAX] = { 30.0, 50.0, 70.0 };
+static const double s_min_alias_db[AUDIO_RESAMPLE_QUALITY_MAX] = { 40.0, 60.0, 70.0 };
+
+static uint32_t s_seed = 1;
+
+static uint32_t rnd(void)
+{
+    s_seed = s_seed * 1103515245u + 12345u;
+    return s_seed >> 8;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double tone(int ch, double hz, int64_t n, int rate)
+{
+    /*!< second channel a bit higher, so a channel swap shows */
+    double f = ch ? hz * 1.25 : hz;
+    return AMPLITUDE * sin(2.0 * M_PI * f * (double)n / rate);
+}
+
+/*!< spread 0 gives the same tone on both channels */
+static int16_t *make_input(const resample_case_t *c, double hz, int spread, int frames)
+{
+    int16_t *in = malloc(frames * c->in_channels * sizeof(int16_t));
+
+    for (int i = 0; i < frames; i++) {
+        for (int ch = 0; ch < c->in_channels; ch++) {
+            in[i * c->in_channels + ch] = (int16_t)lrint(tone(spread ? ch : 0, hz, i, c->in_rate));
+        }
+    }
+    return in;
+}
+
+/* convert in random pieces, returns the number of output frames */
+static int convert(audio_resample_handle_t rs, const resample_case_t *c, const int16_t *in, int in_frames,
+                   int16_t *out, int out_size)
+{
+    int pos = 0, produced = 0;
+
+    while (pos < in_frames) {
+        int n = 1 + (int)(rnd() % 1500);
+        int room = 1 + (int)(rnd() % 1200);
+        int used;
+        n = n < in_frames - pos ? n : in_frames - pos;
+        room = room < out_size - produced ? room : out_size - produced;
+        produced += audio_resample_process(rs, in + pos * c->in_channels, n, &used, out + produced * c->out_channels, room);
+        pos += used;
+    }
+    for (int n; (n = audio_resample_flush(rs, out + produced * c->out_channels, 1 + (int)(rnd() % 16))) > 0;) {
+        produced += n;
+    }
+    return produced;
+}
+
+/* SNR of the output against the ideal tone, per output channel */
+static double snr_db(const resample_case_t *c, const int16_t *out, int frames, int ch)
+{
+    double sig = 0.0, err = 0.0;
+
+    for (int i = EDGE_FRAMES; i < frames - EDGE_FRAMES; i++) {
+        double ref;
+        if (c->out_channels == c->in_channels || c->in_channels == 1) {
+            ref = tone(c->in_channels == 1 ? 0 : ch, c->tone_hz, i, c->out_rate);
+        } else {
+            ref = (tone(0, c->tone_hz, i, c->out_rate) + tone(1, c->tone_hz, i, c->out_rate)) / 2;
+        }
+        double e = out[i * c->out_channels + ch] - ref;
+        sig += ref * ref;
+        err += e * e;
+    }
+    return err > 0.0 ? 10.0 * log10(sig / err) : 200.0;
+}
+
+static double rms(const int16_t *pcm, int frames, int channels)
+{
+    double sum = 0.0;
+
+    for (int i = EDGE_FRAMES * channels; i < (frames - EDGE_FRAMES) * channels; i++) {
+        sum += (double)pcm[i] * pcm[i];
+    }
+    return sqrt(sum / ((frames - 2 * EDGE_FRAMES) * channels));
+}
+
+/* convert into pieces of a few output frames, as a player filling a nearly full block, returns the number of output frames */
+static int convert_small(audio_resample_handle_t rs, const resample_case_t *c, const int16_t *in, int in_frames,
+                         int16_t *out, int out_size)
+{
+    int pos = 0, produced = 0;
+
+    while (pos < in_frames) {
+        int n = 256 + (int)(rnd() % 1500);
+        int room = 1 + (int)(rnd() % 4);
+        int used;
+        n = n < in_frames - pos ? n : in_frames - pos;
+        room = room < out_size - produced ? room : out_size - produced;
+        produced += audio_resample_process(rs, in + pos * c->in_channels, n, &used, out + produced * c->out_channels, room);
+        pos += used;
+    }
+    for (int n; (n = audio_resample_flush(rs, out + produced * c->out_channels, 1 + (int)(rnd() % 4))) > 0;) {
+        produced += n;
+    }
+    return produced;
+}
+
+static int run_case(const resample_case_t *c, audio_resample_quality_t q)
+{
+    int in_frames = c->in_rate * SECONDS;
+    int64_t expected = ((int64_t)in_frames * c->out_rate + c->in_rate - 1) / c->in_rate;
+    int out_size = (int)expected + 64;
+    int16_t *in = make_input(c, c->tone_hz, 1, in_frames);
+    int16_t *out = malloc(out_size * c->out_channels * sizeof(int16_t));
+    audio_resample_handle_t rs = audio_resample_create(c->in_rate, c->in_channels, c->out_rate, c->out_channels, q);
+    int fail = 0;
+
+    int frames = convert(rs, c, in, in_frames, out, out_size);
+    if (frames != expected) {
+        printf("    %d output frames, expected %lld\n", frames, (long long)expected);
+        fail++;
+    }
+
+    double snr = 200.0;
+    for (int ch = 0; ch < c->out_channels; ch++) {
+        double s = snr_db(c, out, frames, ch);
+        snr = s < snr ? s : snr;
+    }
+    if (snr < s_min_snr_db[q]) {
+        fail++;
+    }
+
+    /*!< the same conversion, flushed from a buffer left nearly full by small output pieces */
+    int16_t *small = malloc(out_size * c->out_channels * sizeof(int16_t));
+    audio_resample_reset(rs);
+    int small_frames = convert_small(rs, c, in, in_frames, small, out_size);
+    if (small_frames != frames || memcmp(small, out, frames * c->out_channels * sizeof(int16_t)) != 0) {
+        printf("    %d output frames in small pieces differ from %d in random pieces\n", small_frames, frames);
+        fail++;
+    }
+    free(small);
+
+    /*!< downsampling: a tone that would alias to 80% of the output Nyquist frequency must be filtered out */
+    double alias = 0.0;
+    double alias_hz = c->out_rate - 0.4 * c->out_rate;
+    int alias_test = c->in_rate > c->out_rate && alias_hz < c->in_rate / 2.0;
+    if (alias_test) {
+        double hz = alias_hz;
+        int16_t *high = make_input(c, hz, 0, in_frames);
+        audio_resample_reset(rs);
+        int n = convert(rs, c, high, in_frames, out, out_size);
+        double level = rms(out, n, c->out_channels);
+        alias = level > 0.0 ? 20.0 * log10(AMPLITUDE / sqrt(2.0) / level) : 200.0;
+        if (alias < s_min_alias_db[q]) {
+            fail++;
+        }
+        free(high);
+    }
+
+    /*!< cycles: the same input converted in large pieces */
+    double best = 1e30;
+    for (int r = 0; r < BENCH_REPEAT; r++) {
+        int used, pos = 0, produced = 0;
+        audio_resample_reset(rs);
+        double t = now_ns();
+        while (pos < in_frames) {
+            produced += audio_resample_process(rs, in + pos * c->in_channels, in_frames - pos, &used,
+                                               out + produced * c->out_channels, out_size - produced);
+            pos += used;
+        }
+        t = now_ns() - t;
+        best = t < best ? t : best;
+    }
+
+    printf("%-6s %5d Hz x%d -> %5d Hz x%d  %6lld frames  SNR %6.1f dB", s_tier_names[q], c->in_rate,
+           c->in_channels, c->out_rate, c->out_channels, (long long)expected, snr);
+    if (alias_test) {
+        printf("  alias %5.1f dB", alias);
+    } else {
+        printf("                ");
+    }
+    printf("  %6.1f ns/frame  %s\n", best / expected, fail ? "FAIL" : "PASS");
+
+    audio_resample_delete(rs);
+    free(in);
+    free(out);
+    return fail;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    for (int q = 0; q < AUDIO_RESAMPLE_QUALITY_MAX; q++) {
+        for (size_t i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++) {
+            failures += run_case(&s_cases[i], (audio_resample_quality_t)q);
+        }
+    }
+
+    /*!< invalid parameters */
+    if (audio_resample_create(0, 2, 44100, 2, AUDIO_RESAMPLE_QUALITY_LOW) != NULL ||
+            audio_resample_create(44100, 3, 44100, 2, AUDIO_RESAMPLE_QUALITY_LOW) != NULL ||
+            audio_resample_create(96000, 2, 8000, 2, AUDIO_RESAMPLE_QUALITY_LOW) != NULL ||
+            audio_resample_create(44100, 2, 44100, 2, AUDIO_RESAMPLE_QUALITY_MAX) != NULL) {
+        printf("invalid parameters accepted\n");
+        failures++;
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+/*
+ * Fixed-point polyphase sample rate converter.
+ *
+ * Converts 16-bit PCM of any input rate and channel count (1 or 2) to a fixed output
+ * rate and channel count, so every source (MP3 decoder, TTS, ...) can be played and
+ * mixed on an I2S bus and codec that are configured once. The filter is a Kaiser
+ * windowed sinc, stored as a table of Q15 phases; the phase between two table entries
+ * is interpolated linearly (except for AUDIO_RESAMPLE_QUALITY_LOW). When downsampling,
+ * the filter is made longer by the ratio (up to 4x), so the attenuation of what would
+ * alias is about the same as the stopband when upsampling. Positions are
+ * tracked as exact fractions of the two rates, so there is no drift however long the
+ * stream.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    AUDIO_RESAMPLE_QUALITY_LOW = 0,     /*!< 8 taps, nearest of 32 phases, for speech */
+    AUDIO_RESAMPLE_QUALITY_MEDIUM,      /*!< 16 taps, 64 interpolated phases */
+    AUDIO_RESAMPLE_QUALITY_HIGH,        /*!< 32 taps, 128 interpolated phases, for music */
+    AUDIO_RESAMPLE_QUALITY_MAX,
+} audio_resample_quality_t;
+
+typedef struct audio_resample *audio_resample_handle_t;
+
+/**
+ * @brief Create a converter, the input format can be changed later with audio_resample_set_input
+ *
+ * @param in_rate Input sample rate in Hz
+ * @param in_channels Input channels, 1 or 2
+ * @param out_rate Output sample rate in Hz
+ * @param out_channels Output channels, 1 or 2 (mono is duplicated, stereo is averaged)
+ * @param quality Filter length and phase resolution
+ *
+ * @return Handle, NULL on invalid parameters (also for downsampling by more than 8) or out of memory
+ */
+audio_resample_handle_t audio_resample_create(int in_rate, int in_channels, int out_rate, int out_channels,
+                                              audio_resample_quality_t quality);
+
+/**
+ * @brief Free a converter
+ */
+void audio_resample_delete(audio_resample_handle_t handle);
+
+/**
+ * @brief Change the input format, drops all buffered input (like audio_resample_reset)
+ *
+ * @return 0 on success, -1 on invalid parameters or out of memory, the converter then keeps its old input format
+ */
+int audio_resample_set_input(audio_resample_handle_t handle, int in_rate, int in_channels);
+
+/**
+ * @brief Drop all buffered input, e.g. before a new stream
+ */
+void audio_resample_reset(audio_resample_handle_t handle);
+
+/**
+ * @brief Convert interleaved samples
+ *
+ * Consumes as much input as fits and produces as much output as the input allows. The
+ * filter looks ahead by half its length, so the last few output frames of a stream only
+ * come with more input or from audio_resample_flush.
+ *
+ * @param handle Converter
+ * @param in Input frames
+ * @param in_frames Number of input frames (samples per channel)
+ * @param[out] in_used Number of input frames consumed
+ * @param out Output buffer
+ * @param out_frames Room in the output buffer in frames
+ *
+ * @return Number of output frames written
+ */
+int audio_resample_process(audio_resample_handle_t handle, const int16_t *in, int in_frames, int *in_used,
+                           int16_t *out, int out_frames);
+
+/**
+ * @brief Output the frames still held back at the end of a stream
+ *
+ * Call until it returns 0, then the output is exactly as long as the input, converted to
+ * the output rate. Afterwards the converter starts over as after audio_resample_reset.
+ *
+ * @return Number of output frames written
+ */
+int audio_resample_flush(audio_resample_handle_t handle, int16_t *out, int out_frames);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,181 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "corpus.h"
+
+#define FREE_FORMAT_PREFIX      "free:"
+
+static uint32_t s_crc_table[256];
+
+uint32_t corpus_crc32(uint32_t crc, const short *pcm, int nsamples)
+{
+    if (s_crc_table[1] == 0) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            s_crc_table[i] = c;
+        }
+    }
+
+    crc = ~crc;
+    for (int i = 0; i < nsamples; i++) {
+        uint16_t s = (uint16_t)pcm[i];
+        crc = s_crc_table[(crc ^ s) & 0xff] ^ (crc >> 8);
+        crc = s_crc_table[(crc ^ (s >> 8)) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+int corpus_id3v2_size(const unsigned char *buf, int size)
+{
+    if (size >= 10 && memcmp(buf, "ID3", 3) == 0) {
+        int tag_len = ((buf[6] & 0x7F) << 21) | ((buf[7] & 0x7F) << 14) | ((buf[8] & 0x7F) << 7) | (buf[9] & 0x7F);
+        tag_len += (buf[5] & 0x10) ? 20 : 10;   /*!< header plus optional footer */
+        return tag_len < size ? tag_len : size;
+    }
+    return 0;
+}
+
+static void make_free_format(unsigned char *data, int size)
+{
+    static short pcm[CORPUS_PCM_MAX_SAMPLES];
+    HMP3Decoder dec = MP3InitDecoder();
+    if (dec == NULL) {
+        return;
+    }
+
+    /* let the decoder walk the frames so padding and reservoir handling match exactly */
+    unsigned char *ptr = data + corpus_id3v2_size(data, size);
+    int left = size - (int)(ptr - data);
+    while (left > 0) {
+        int offset = MP3FindSyncWord(ptr, left);
+        if (offset < 0) {
+            break;
+        }
+        ptr += offset;
+        left -= offset;
+
+        unsigned char *frame = ptr;
+        int err = MP3Decode(dec, &ptr, &left, pcm, 0);
+        if (err == ERR_MP3_INDATA_UNDERFLOW) {
+            break;
+        }
+        if (ptr == frame) {
+            ptr++;
+            left--;
+            continue;
+        }
+        frame[2] &= 0x0f;   /*!< bitrate index 0 = free format */
+    }
+    MP3FreeDecoder(dec);
+}
+
+unsigned char *corpus_read_stream(const corpus_entry_t *entry, int *size)
+{
+    FILE *f = fopen(entry->path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char *buf = malloc(len > 0 ? len : 1);
+    if (buf != NULL && fread(buf, 1, len, f) != (size_t)len) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *size = (int)len;
+
+    if (buf != NULL && entry->free_format) {
+        make_free_format(buf, *size);
+    }
+    return buf;
+}
+
+int corpus_load(const char *manifest, corpus_entry_t *entries, int max_entries)
+{
+    FILE *f = fopen(manifest, "r");
+    if (f == NULL) {
+        return -1;
+    }
+
+    const char *slash = strrchr(manifest, '/');
+    int dir_len = slash ? (int)(slash - manifest) : 1;
+    const char *dir = slash ? manifest : ".";
+
+    char line[CORPUS_MAX_PATH + 64];
+    int n = 0;
+    while (n < max_entries && fgets(line, sizeof(line), f) != NULL) {
+        char *hash = strchr(line, '#');
+        if (hash) {
+            *hash = '\0';
+        }
+        corpus_entry_t *e = &entries[n];
+        memset(e, 0, sizeof(*e));
+        unsigned int crc = 0;
+        int fields = sscanf(line, "%511s %d %x", e->entry, &e->frames, &crc);
+        if (fields <= 0) {
+            continue;
+        }
+        e->crc = crc;
+        if (fields < 3) {
+            e->frames = -1;     /*!< no golden value yet */
+        }
+
+        const char *rel = e->entry;
+        if (strncmp(rel, FREE_FORMAT_PREFIX, strlen(FREE_FORMAT_PREFIX)) == 0) {
+            e->free_format = 1;
+            rel += strlen(FREE_FORMAT_PREFIX);
+        }
+        if (snprintf(e->path, sizeof(e->path), "%.*s/%s", dir_len, dir, rel) >= (int)sizeof(e->path)) {
+            fprintf(stderr, "%s: path of %s too long\n", manifest, e->entry);
+            continue;
+        }
+        const char *name = strrchr(rel, '/') ? strrchr(rel, '/') + 1 : rel;
+        snprintf(e->label, sizeof(e->label), "%s%s", e->free_format ? FREE_FORMAT_PREFIX : "", name);
+        n++;
+    }
+    fclose(f);
+    return n;
+}
+
+int corpus_save(const char *manifest, const corpus_entry_t *entries, int n)
+{
+    FILE *f = fopen(manifest, "w");
+    if (f == NULL) {
+        return -1;
+    }
+    fprintf(f, "# Helix MP3 decoder conformance corpus\n");
+    fprintf(f, "# [free:]<path relative to this file> <frames> <crc32 of 16-bit LE PCM>\n");
+    for (int i = 0; i < n; i++) {
+        fprintf(f, "%s %d %08x\n", entries[i].entry, entries[i].frames, (unsigned int)entries[i].crc);
+    }
+    fclose(f);
+    return 0;
+}
+
+const char *corpus_check(corpus_entry_t *entry, int frames, uint32_t crc, int update)
+{
+    if (update) {
+        entry->frames = frames;
+        entry->crc = crc;
+        return "UPDATED";
+    }
+    if (entry->frames < 0) {
+        return "NO-GOLDEN";
+    }
+    if (entry->frames != frames || entry->crc != crc) {
+        return "FAIL";
+    }
+    return "PASS";
+}
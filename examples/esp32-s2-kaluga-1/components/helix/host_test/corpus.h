@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+/*
+ * Corpus manifest shared by the host tests.
+ *
+ * One stream per line, '#' starts a comment:
+ *     [free:]<path relative to manifest> <frames> <crc32 hex>
+ *
+ * The "free:" prefix rewrites every frame header of a CBR stream to bitrate index 0
+ * when the stream is loaded, which turns it into a free-format stream that must
+ * decode to exactly the same PCM as the original.
+ */
+
+#include <stdint.h>
+
+#include "mp3dec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CORPUS_MAX_STREAMS      64
+#define CORPUS_MAX_PATH         512
+#define CORPUS_PCM_MAX_SAMPLES  (MAX_NCHAN * MAX_NGRAN * MAX_NSAMP)
+
+typedef struct {
+    char entry[CORPUS_MAX_PATH];        /*!< path as written in the manifest */
+    char path[2 * CORPUS_MAX_PATH];     /*!< resolved file path, manifest directory and entry */
+    char label[CORPUS_MAX_PATH + 8];    /*!< short name for reports, with the "free:" prefix */
+    int free_format;
+    int frames;                         /*!< golden frame count, -1 if not recorded yet */
+    uint32_t crc;                       /*!< golden CRC-32 of the 16-bit LE PCM */
+} corpus_entry_t;
+
+/**
+ * @brief Load a manifest, returns number of entries or -1
+ */
+int corpus_load(const char *manifest, corpus_entry_t *entries, int max_entries);
+
+/**
+ * @brief Write entries (with updated golden values) back to the manifest
+ */
+int corpus_save(const char *manifest, const corpus_entry_t *entries, int n);
+
+/**
+ * @brief Read the stream of an entry into a malloc'ed buffer, applying "free:" if set
+ */
+unsigned char *corpus_read_stream(const corpus_entry_t *entry, int *size);
+
+/**
+ * @brief Length of an ID3v2 tag at the start of buf (0 if none)
+ */
+int corpus_id3v2_size(const unsigned char *buf, int size);
+
+/**
+ * @brief CRC-32 over 16-bit samples in little-endian byte order, start with crc = 0
+ */
+uint32_t corpus_crc32(uint32_t crc, const short *pcm, int nsamples);
+
+/**
+ * @brief Compare result with the golden values, or record it if update is set
+ *
+ * @return "PASS", "FAIL", "NO-GOLDEN" or "UPDATED"
+ */
+const char *corpus_check(corpus_entry_t *entry, int frames, uint32_t crc, int update);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,188 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Test for decoders in caller memory (MP3InitDecoderArena, MP3InitStreamArena).
+ *
+ * Blocks that are too small or misaligned must be rejected, and resilient mode must
+ * only be available in a block sized for it. Then two streams are placed side by side
+ * in one static block (so any attempt to free or realloc it trips the sanitizer) and
+ * decode two corpus streams with their frames interleaved. Both must match the golden
+ * values. The streams are then reset and swapped, as on a track change, and must match
+ * again.
+ *
+ * Usage:
+ *     mp3_arena_test corpus.txt
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mp3stream.h"
+#include "corpus.h"
+
+#define ARENA_BYTES     (64 * 1024)
+#define RING_SIZE       MP3STREAM_MIN_RING_SIZE
+#define ARENA_FLAGS     MP3_ARENA_RESILIENT
+
+typedef struct {
+    HMP3Stream stream;
+    corpus_entry_t *entry;
+    unsigned char *data;
+    int size;
+    int pos;
+    int frames;
+    uint32_t crc;
+    int done;
+} player_t;
+
+static unsigned char s_arena[2][ARENA_BYTES] __attribute__((aligned(MP3_ARENA_ALIGN)));
+
+static int test_init(void)
+{
+    int fail = 0;
+    int plain = MP3GetDecoderArenaSize(0), resilient = MP3GetDecoderArenaSize(MP3_ARENA_RESILIENT);
+    int stream = MP3GetStreamArenaSize(RING_SIZE, ARENA_FLAGS);
+    HMP3Decoder dec;
+
+    printf("decoder %d bytes, with concealment %d bytes, stream with %d byte ring %d bytes\n",
+           plain, resilient, RING_SIZE, stream);
+    if (plain <= 0 || resilient <= plain || stream > ARENA_BYTES || (plain & (MP3_ARENA_ALIGN - 1))) {
+        printf("    bad sizes\n");
+        fail++;
+    }
+
+    /* rejected: no block, too small, misaligned */
+    if (MP3InitDecoderArena(NULL, plain, 0) || MP3InitDecoderArena(s_arena[0], plain - 1, 0) ||
+            MP3InitDecoderArena(s_arena[0] + 4, plain, 0) ||
+            MP3InitStreamArena(s_arena[0], stream - 1, RING_SIZE, ARENA_FLAGS) ||
+            MP3InitStreamArena(s_arena[0] + 1, stream, RING_SIZE, ARENA_FLAGS)) {
+        printf("    bad block accepted\n");
+        fail++;
+    }
+
+    /* resilient mode only with room for the concealment state */
+    dec = MP3InitDecoderArena(s_arena[0], plain, 0);
+    if (dec == NULL || MP3SetResilientMode(dec, 1) != ERR_MP3_OUT_OF_MEMORY) {
+        printf("    resilient mode without MP3_ARENA_RESILIENT\n");
+        fail++;
+    }
+    MP3FreeDecoder(dec);
+    dec = MP3InitDecoderArena(s_arena[0], resilient, MP3_ARENA_RESILIENT);
+    if (dec == NULL || MP3SetResilientMode(dec, 1) != ERR_MP3_NONE || MP3SetResilientMode(dec, 0) != ERR_MP3_NONE ||
+            MP3SetResilientMode(dec, 1) != ERR_MP3_NONE) {
+        printf("    resilient mode with MP3_ARENA_RESILIENT\n");
+        fail++;
+    }
+    MP3FreeDecoder(dec);
+
+    return fail;
+}
+
+static void start(player_t *p, corpus_entry_t *entry, unsigned char *data, int size)
+{
+    MP3StreamReset(p->stream);
+    p->entry = entry;
+    p->data = data;
+    p->size = size;
+    p->pos = 0;
+    p->frames = 0;
+    p->crc = 0;
+    p->done = 0;
+}
+
+/* decode one frame, returns 0 once the stream has ended */
+static int step(player_t *p)
+{
+    static short pcm[CORPUS_PCM_MAX_SAMPLES];
+    MP3FrameInfo info;
+
+    while (!p->done) {
+        int err = MP3StreamDecode(p->stream, pcm, &info);
+        if (err == ERR_MP3_END_OF_STREAM) {
+            p->done = 1;
+        } else if (err == ERR_MP3_INDATA_UNDERFLOW) {
+            p->pos += MP3StreamWrite(p->stream, p->data + p->pos, p->size - p->pos);
+            if (p->pos == p->size) {
+                MP3StreamSetEOF(p->stream);
+            }
+        } else {
+            p->crc = corpus_crc32(p->crc, pcm, info.outputSamps);
+            p->frames++;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int play_pair(player_t *a, player_t *b)
+{
+    int fail = 0;
+
+    while (step(a) | step(b))
+        ;
+    for (player_t *p = a; p; p = (p == a ? b : NULL)) {
+        const char *result = corpus_check(p->entry, p->frames, p->crc, 0);
+        printf("%-36s %6d frames  %s\n", p->entry->label, p->frames, result);
+        fail += strcmp(result, "PASS") != 0;
+    }
+    return fail;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s corpus.txt\n", argv[0]);
+        return 2;
+    }
+
+    static corpus_entry_t entries[CORPUS_MAX_STREAMS];
+    int n = corpus_load(argv[1], entries, CORPUS_MAX_STREAMS);
+    if (n <= 0) {
+        fprintf(stderr, "no streams in %s\n", argv[1]);
+        return 2;
+    }
+
+    int failures = test_init();
+
+    player_t players[2];
+    for (int k = 0; k < 2; k++) {
+        players[k].stream = MP3InitStreamArena(s_arena[k], ARENA_BYTES, RING_SIZE, ARENA_FLAGS);
+        if (players[k].stream == NULL) {
+            printf("stream %d rejected its block\n", k);
+            return 1;
+        }
+        MP3StreamSetResilientMode(players[k].stream, 1);
+    }
+
+    for (int i = 0; i < n; i++) {
+        int j = (i + 1) % n;
+        int size_i = 0, size_j = 0;
+        unsigned char *data_i = corpus_read_stream(&entries[i], &size_i);
+        unsigned char *data_j = corpus_read_stream(&entries[j], &size_j);
+        if (data_i == NULL || data_j == NULL) {
+            printf("%-36s cannot read\n", data_i ? entries[j].label : entries[i].label);
+            failures++;
+        } else {
+            /* two instances at once, then the same instances again after a track change */
+            start(&players[0], &entries[i], data_i, size_i);
+            start(&players[1], &entries[j], data_j, size_j);
+            failures += play_pair(&players[0], &players[1]);
+            start(&players[0], &entries[j], data_j, size_j);
+            start(&players[1], &entries[i], data_i, size_i);
+            failures += play_pair(&players[0], &players[1]);
+        }
+        free(data_i);
+        free(data_j);
+    }
+
+    /* optional, must not touch the static blocks */
+    MP3FreeStream(players[0].stream);
+    MP3FreeStream(players[1].stream);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,212 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Host benchmark and conformance check for the Helix MP3 decoder.
+ *
+ * Every stream listed in the corpus manifest is decoded frame by frame, the PCM
+ * output is checksummed (CRC-32 over little-endian 16-bit samples) and compared
+ * with the golden value stored in the manifest. The per-stage cycle counters
+ * collected by MP3Decode (HELIX_PROFILE) are reported as cycles per frame.
+ *
+ * See corpus.h for the manifest format.
+ *
+ * Usage:
+ *     mp3_bench [--update] [--repeat N] [--kernels N] corpus.txt
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "mp3dec.h"
+#include "corpus.h"
+
+typedef struct {
+    int frames;
+    int errors;
+    uint32_t crc;
+    int samprate;
+    int nchans;
+    int version;
+    int min_bitrate;
+    int max_bitrate;
+    MP3ProfileInfo profile;
+} decode_result_t;
+
+static const char *const s_stage_names[MP3_NUM_STAGES] = {
+    "header", "scalefact", "huffman", "dequant", "imdct", "subband",
+};
+
+static int decode_stream(const unsigned char *data, int size, int kernels, decode_result_t *res)
+{
+    static short pcm[CORPUS_PCM_MAX_SAMPLES];
+    MP3FrameInfo info;
+    HMP3Decoder dec = MP3InitDecoder();
+    if (dec == NULL) {
+        return -1;
+    }
+    if (kernels >= 0) {
+        MP3SetKernels(dec, kernels);
+    }
+
+    memset(res, 0, sizeof(*res));
+    res->min_bitrate = 0x7fffffff;
+
+    unsigned char *ptr = (unsigned char *)data + corpus_id3v2_size(data, size);
+    int left = size - (int)(ptr - data);
+
+    while (left > 0) {
+        int offset = MP3FindSyncWord(ptr, left);
+        if (offset < 0) {
+            break;
+        }
+        ptr += offset;
+        left -= offset;
+
+        unsigned char *frame = ptr;
+        int err = MP3Decode(dec, &ptr, &left, pcm, 0);
+        if (err == ERR_MP3_INDATA_UNDERFLOW) {
+            break;
+        } else if (err == ERR_MP3_MAINDATA_UNDERFLOW) {
+            continue;   /*!< reservoir still filling, normal at stream start */
+        } else if (err != ERR_MP3_NONE) {
+            res->errors++;
+            if (ptr == frame) {
+                ptr++;
+                left--;
+            }
+            continue;
+        }
+
+        MP3GetLastFrameInfo(dec, &info);
+        res->crc = corpus_crc32(res->crc, pcm, info.outputSamps);
+        res->frames++;
+        res->samprate = info.samprate;
+        res->nchans = info.nChans;
+        res->version = info.version;
+        if (info.bitrate < res->min_bitrate) {
+            res->min_bitrate = info.bitrate;
+        }
+        if (info.bitrate > res->max_bitrate) {
+            res->max_bitrate = info.bitrate;
+        }
+    }
+
+    MP3GetProfileInfo(dec, &res->profile);
+    MP3FreeDecoder(dec);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *manifest = NULL;
+    int update = 0;
+    int repeat = 1;
+    int kernels = -1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--update") == 0) {
+            update = 1;
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--kernels") == 0 && i + 1 < argc) {
+            kernels = atoi(argv[++i]);
+        } else {
+            manifest = argv[i];
+        }
+    }
+    if (manifest == NULL || repeat < 1 || kernels >= MP3_NUM_KERNELS) {
+        fprintf(stderr, "usage: %s [--update] [--repeat N] [--kernels N] corpus.txt\n", argv[0]);
+        return 2;
+    }
+
+    static corpus_entry_t entries[CORPUS_MAX_STREAMS];
+    int n = corpus_load(manifest, entries, CORPUS_MAX_STREAMS);
+    if (n <= 0) {
+        fprintf(stderr, "no streams in %s\n", manifest);
+        return 2;
+    }
+
+    int failures = 0;
+    unsigned long long total[MP3_NUM_STAGES] = {0};
+    long long total_frames = 0;
+
+    printf("%-36s %4s %6s %2s %9s %6s %8s", "stream", "ver", "rate", "ch", "kbps", "frames", "crc32");
+    for (int s = 0; s < MP3_NUM_STAGES; s++) {
+        printf(" %9s", s_stage_names[s]);
+    }
+    printf(" %9s  result\n", "cyc/frame");
+
+    for (int i = 0; i < n; i++) {
+        const char *label = entries[i].label;
+        int size = 0;
+        unsigned char *data = corpus_read_stream(&entries[i], &size);
+        if (data == NULL) {
+            printf("%-36s cannot read %s\n", label, entries[i].path);
+            failures++;
+            continue;
+        }
+
+        decode_result_t res;
+        unsigned long long best[MP3_NUM_STAGES];
+        for (int r = 0; r < repeat; r++) {
+            decode_stream(data, size, kernels, &res);
+            for (int s = 0; s < MP3_NUM_STAGES; s++) {
+                if (r == 0 || res.profile.cycles[s] < best[s]) {
+                    best[s] = res.profile.cycles[s];
+                }
+            }
+        }
+        free(data);
+
+        const char *result = corpus_check(&entries[i], res.frames, res.crc, update);
+        if (strcmp(result, "FAIL") == 0 || strcmp(result, "NO-GOLDEN") == 0) {
+            failures++;
+        }
+
+        static const char *const versions[] = {"1", "2", "2.5"};
+        char kbps[24];
+        if (res.min_bitrate == res.max_bitrate) {
+            snprintf(kbps, sizeof(kbps), "%d", res.max_bitrate / 1000);
+        } else {
+            snprintf(kbps, sizeof(kbps), "%d-%d", res.min_bitrate / 1000, res.max_bitrate / 1000);
+        }
+        printf("%-36s %4s %6d %2d %9s %6d %08x", label, versions[res.version % 3], res.samprate,
+               res.nchans, kbps, res.frames, (unsigned int)res.crc);
+
+        unsigned long long sum = 0;
+        for (int s = 0; s < MP3_NUM_STAGES; s++) {
+            unsigned long long per_frame = res.frames ? best[s] / res.frames : 0;
+            printf(" %9llu", per_frame);
+            sum += per_frame;
+            total[s] += best[s];
+        }
+        total_frames += res.frames;
+        printf(" %9llu  %s", sum, result);
+        if (res.errors) {
+            printf(" (%d bad frames)", res.errors);
+        }
+        printf("\n");
+    }
+
+    if (total_frames > 0) {
+        unsigned long long sum = 0;
+        printf("%-36s %4s %6s %2s %9s %6lld %8s", "total", "", "", "", "", total_frames, "");
+        for (int s = 0; s < MP3_NUM_STAGES; s++) {
+            printf(" %9llu", total[s] / total_frames);
+            sum += total[s] / total_frames;
+        }
+        printf(" %9llu\n", sum);
+    }
+
+    if (update && corpus_save(manifest, entries, n) != 0) {
+        fprintf(stderr, "failed to write %s\n", manifest);
+        return 2;
+    }
+    return failures ? 1 : 0;
+}
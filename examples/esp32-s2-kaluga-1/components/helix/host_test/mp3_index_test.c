@@ -0,0 +1,205 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Test for the frame index and seek (mp3index.h, MP3StreamFlush).
+ *
+ * Every corpus stream is decoded once from the start to get the CRC of each frame.
+ * The index is then built from random sized chunks, with a small table so it has to
+ * coarsen its step, and must count exactly the decoded frames. Finally the stream is
+ * seeked to several positions, both from an idle stream and in the middle of playback,
+ * and the frames following each seek target must match the continuous decode bit for bit.
+ * Streams with an Info header must also yield the encoder delay and padding of the
+ * LAME tag.
+ *
+ * Usage:
+ *     mp3_index_test corpus.txt
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mp3stream.h"
+#include "mp3index.h"
+#include "corpus.h"
+
+#define INDEX_POINTS    64      /*!< small on purpose, the corpus streams have >2000 frames */
+#define CHECK_FRAMES    8
+
+typedef struct {
+    const unsigned char *data;
+    int size;
+    int pos;
+    uint32_t seed;
+    HMP3Index index;
+} source_t;
+
+static int source_read(void *arg, unsigned char *buf, int nbytes)
+{
+    source_t *src = (source_t *)arg;
+    src->seed = src->seed * 1103515245u + 12345u;
+    int n = 1 + (int)((src->seed >> 8) % 1500);
+    n = n < nbytes ? n : nbytes;
+    n = n < src->size - src->pos ? n : src->size - src->pos;
+    memcpy(buf, src->data + src->pos, n);
+    if (src->index != NULL) {
+        MP3IndexFeed(src->index, buf, n, (unsigned int)src->pos);
+    }
+    src->pos += n;
+    return n;
+}
+
+/* CRC of every frame of a continuous decode, returns number of frames */
+static int decode_all(const unsigned char *data, int size, uint32_t *crcs, int max)
+{
+    static short pcm[CORPUS_PCM_MAX_SAMPLES];
+    MP3FrameInfo info;
+    source_t src = { data, size, 0, 1, NULL };
+    HMP3Stream stream = MP3InitStream(0);
+    int n = 0;
+
+    MP3StreamSetReader(stream, source_read, &src);
+    for (;;) {
+        int err = MP3StreamDecode(stream, pcm, &info);
+        if (err == ERR_MP3_END_OF_STREAM) {
+            break;
+        }
+        if (n < max) {
+            crcs[n] = err == ERR_MP3_NONE ? corpus_crc32(0, pcm, info.outputSamps) : 0;
+        }
+        n++;
+    }
+    MP3FreeStream(stream);
+    return n;
+}
+
+/* seek to time_ms and compare the following frames with the continuous decode */
+static int check_seek(HMP3Stream stream, HMP3Index index, source_t *src, int time_ms,
+                      const uint32_t *crcs, int nframes)
+{
+    static short pcm[CORPUS_PCM_MAX_SAMPLES];
+    MP3FrameInfo info;
+    MP3SeekInfo seek;
+
+    if (MP3IndexSeek(index, time_ms, &seek) != 0 || !seek.exact) {
+        printf("    seek %d ms: no exact position\n", time_ms);
+        return 1;
+    }
+    src->pos = (int)seek.offset;
+    MP3StreamFlush(stream, seek.primeFrames);
+
+    for (int i = 0; i < CHECK_FRAMES && seek.targetFrame + i < nframes; i++) {
+        int err = MP3StreamDecode(stream, pcm, &info);
+        uint32_t crc = err == ERR_MP3_NONE ? corpus_crc32(0, pcm, info.outputSamps) : 0;
+        if (err != ERR_MP3_NONE || crc != crcs[seek.targetFrame + i]) {
+            printf("    seek %d ms: frame %d (offset %u, %d primed) differs, err %d\n", time_ms,
+                   seek.targetFrame + i, seek.offset, seek.primeFrames, err);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int test_stream(const corpus_entry_t *entry, const unsigned char *data, int size)
+{
+    static uint32_t crcs[1 << 16];
+    static short pcm[CORPUS_PCM_MAX_SAMPLES];
+    MP3FrameInfo info;
+    MP3IndexInfo ii;
+    int failures = 0;
+
+    int nframes = decode_all(data, size, crcs, sizeof(crcs) / sizeof(crcs[0]));
+
+    /* index built while playing: every read of the decoder is fed to the scanner */
+    HMP3Index index = MP3InitIndex(INDEX_POINTS);
+    HMP3Stream stream = MP3InitStream(MP3STREAM_MIN_RING_SIZE);
+    source_t src = { data, size, 0, 7, index };
+    MP3IndexSetFileSize(index, (unsigned int)size);
+    MP3StreamSetReader(stream, source_read, &src);
+
+    /* partial index: positions beyond the scan are estimates */
+    for (int i = 0; i < nframes / 4; i++) {
+        MP3StreamDecode(stream, pcm, &info);
+    }
+    MP3GetIndexInfo(index, &ii);
+    int duration_ms = ii.durationMs;
+    MP3SeekInfo seek;
+    if (MP3IndexSeek(index, duration_ms * 3 / 4, &seek) != 0 || seek.exact) {
+        printf("    seek beyond the scan should be an estimate\n");
+        failures++;
+    }
+
+    while (MP3StreamDecode(stream, pcm, &info) != ERR_MP3_END_OF_STREAM) {
+    }
+    MP3GetIndexInfo(index, &ii);
+    if (!ii.complete || ii.nIndexed != nframes || ii.nFrames + ii.firstAudioFrame != nframes || !ii.exact) {
+        printf("    index: complete %d, %d frames indexed, %d audio frames, decoded %d\n",
+               ii.complete, ii.nIndexed, ii.nFrames, nframes);
+        failures++;
+    }
+    if (ii.vbrHeader != MP3INDEX_VBR_NONE && ii.durationMs != duration_ms) {
+        printf("    duration from VBR header %d ms, from scan %d ms\n", duration_ms, ii.durationMs);
+        failures++;
+    }
+    /* all corpus streams with an Info header carry a LAME tag (LAME or FFmpeg) */
+    if (ii.vbrHeader == MP3INDEX_VBR_XING) {
+        int total = nframes * ii.samplesPerFrame;
+        if (!ii.gapless || ii.startSkip != ii.samplesPerFrame + ii.encDelay + MP3_DECODER_DELAY ||
+                ii.nSamples != total - ii.samplesPerFrame - ii.encDelay - ii.encPadding ||
+                ii.startSkip + ii.nSamples > total) {
+            printf("    gapless %d: delay %d, padding %d, skip %d, %d of %d samples\n", ii.gapless,
+                   ii.encDelay, ii.encPadding, ii.startSkip, ii.nSamples, total);
+            failures++;
+        }
+    }
+
+    /* seek forward and backward in the middle of playback, then to the very start and end */
+    const int times[] = { ii.durationMs / 2, ii.durationMs / 3, 1000, ii.durationMs * 9 / 10,
+                          0, ii.durationMs - 10, ii.durationMs + 1000
+                        };
+    for (size_t i = 0; i < sizeof(times) / sizeof(times[0]); i++) {
+        failures += check_seek(stream, index, &src, times[i], crcs, nframes);
+    }
+
+    printf("%-36s %6d frames %7d ms  vbr header %d  delay %4d  padding %4d  step %d  %s\n", entry->label,
+           ii.nIndexed, ii.durationMs, ii.vbrHeader, ii.encDelay, ii.encPadding, ii.stepFrames,
+           failures ? "FAIL" : "PASS");
+
+    MP3FreeStream(stream);
+    MP3FreeIndex(index);
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s corpus.txt\n", argv[0]);
+        return 2;
+    }
+
+    static corpus_entry_t entries[CORPUS_MAX_STREAMS];
+    int n = corpus_load(argv[1], entries, CORPUS_MAX_STREAMS);
+    if (n <= 0) {
+        fprintf(stderr, "no streams in %s\n", argv[1]);
+        return 2;
+    }
+
+    int failures = 0;
+    for (int i = 0; i < n; i++) {
+        int size = 0;
+        unsigned char *data = corpus_read_stream(&entries[i], &size);
+        if (data == NULL) {
+            printf("%-36s cannot read %s\n", entries[i].label, entries[i].path);
+            failures++;
+            continue;
+        }
+        failures += test_stream(&entries[i], data, size) ? 1 : 0;
+        free(data);
+    }
+
+    return failures ? 1 : 0;
+}
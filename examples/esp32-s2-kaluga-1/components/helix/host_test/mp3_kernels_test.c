@@ -0,0 +1,255 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Test for the DSP kernel sets (kernels.c, MP3SetKernels).
+ *
+ * Every kernel of every set is run on random input next to the reference kernel and
+ * must produce bit-identical output, including the state it updates in place (DCT
+ * work buffer, IMDCT overlap). The random cases cover all window type combinations,
+ * window switch points of mixed blocks and inputs with too few guard bits. Then every
+ * corpus stream is decoded with each set and must match the golden values. The time
+ * per call of each kernel is printed for comparison.
+ *
+ * Usage:
+ *     mp3_kernels_test corpus.txt
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "coder.h"
+#include "mp3stream.h"
+#include "corpus.h"
+
+#define RANDOM_CASES    20000
+#define BENCH_CALLS     200000
+
+static const char *const s_kernel_names[MP3_NUM_KERNELS] = { "reference", "blocked" };
+
+static uint32_t s_seed = 1;
+
+static uint32_t rnd(void)
+{
+    s_seed = s_seed * 1103515245u + 12345u;
+    return s_seed >> 8;
+}
+
+/* random value with at least gb guard bits */
+static int rnd_gb(int gb)
+{
+    int bits = 31 - gb;
+    int x = (int)(((rnd() << 8) ^ rnd()) & ((1u << bits) - 1));
+    return x - (1 << (bits - 1));
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int test_fdct32(const MP3Kernels *k)
+{
+    static int vbuf[2][MAX_NCHAN * VBUF_LENGTH];
+    int buf[2][32];
+
+    for (int n = 0; n < RANDOM_CASES; n++) {
+        int gb = 2 + (int)(rnd() % 10);
+        int offset = (int)(rnd() % 8), odd = (int)(rnd() & 1);
+        for (int i = 0; i < 32; i++) {
+            buf[0][i] = buf[1][i] = rnd_gb(gb);
+        }
+        mp3Kernels[MP3_KERNELS_REFERENCE].fdct32(buf[0], vbuf[0], offset, odd, gb);
+        k->fdct32(buf[1], vbuf[1], offset, odd, gb);
+        if (memcmp(buf[0], buf[1], sizeof(buf[0])) || memcmp(vbuf[0], vbuf[1], sizeof(vbuf[0]))) {
+            printf("    fdct32 differs (gb %d, offset %d, odd %d)\n", gb, offset, odd);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int test_polyphase(const MP3Kernels *k)
+{
+    static int vbuf[MAX_NCHAN * VBUF_LENGTH];
+    short pcm[2][2 * NBANDS];
+
+    for (int n = 0; n < RANDOM_CASES / 10; n++) {
+        /* mostly in range, sometimes loud enough to clip */
+        int gb = 1 + (int)(rnd() % 8);
+        for (int i = 0; i < MAX_NCHAN * VBUF_LENGTH; i++) {
+            vbuf[i] = rnd_gb(gb);
+        }
+        int *vb = vbuf + (rnd() % 8) + ((rnd() & 1) ? VBUF_LENGTH : 0);
+        mp3Kernels[MP3_KERNELS_REFERENCE].polyphaseMono(pcm[0], vb, polyCoef);
+        k->polyphaseMono(pcm[1], vb, polyCoef);
+        if (memcmp(pcm[0], pcm[1], NBANDS * sizeof(short))) {
+            printf("    polyphaseMono differs (gb %d)\n", gb);
+            return 1;
+        }
+        mp3Kernels[MP3_KERNELS_REFERENCE].polyphaseStereo(pcm[0], vb, polyCoef);
+        k->polyphaseStereo(pcm[1], vb, polyCoef);
+        if (memcmp(pcm[0], pcm[1], sizeof(pcm[0]))) {
+            printf("    polyphaseStereo differs (gb %d)\n", gb);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void random_block_count(BlockCount *bc, int *bt_curr)
+{
+    static const int long_types[] = { 0, 0, 0, 1, 3, 2 };
+
+    memset(bc, 0, sizeof(*bc));
+    bc->nBlocksLong = 1 + (int)(rnd() % NBANDS);
+    bc->prevType = (int)(rnd() % 4);
+    bc->prevWinSwitch = (rnd() & 1) ? (int)(rnd() % (NBANDS + 1)) : 0;
+    *bt_curr = long_types[rnd() % 6];
+    if (*bt_curr == 2) {
+        /* long part of a mixed block */
+        bc->nBlocksLong = 1 + (int)(rnd() % 4);
+        bc->currWinSwitch = bc->nBlocksLong;
+    } else if (rnd() & 1) {
+        bc->currWinSwitch = (int)(rnd() % (NBANDS + 1));
+    }
+    bc->gbIn = 1 + (int)(rnd() % 12);
+}
+
+static int test_imdct_long(const MP3Kernels *k)
+{
+    int x[2][NBANDS * 18], prev[2][NBANDS * 9], y[2][BLOCK_SIZE][NBANDS];
+    BlockCount bc[2];
+    int bt_curr;
+
+    for (int n = 0; n < RANDOM_CASES; n++) {
+        random_block_count(&bc[0], &bt_curr);
+        bc[1] = bc[0];
+        for (int i = 0; i < NBANDS * 18; i++) {
+            x[0][i] = x[1][i] = rnd_gb(bc[0].gbIn);
+        }
+        for (int i = 0; i < NBANDS * 9; i++) {
+            prev[0][i] = prev[1][i] = rnd_gb(3);
+        }
+        memset(y, 0, sizeof(y));
+        int m0 = mp3Kernels[MP3_KERNELS_REFERENCE].imdctLong(x[0], prev[0], &y[0][0][0], &bc[0], bt_curr);
+        int m1 = k->imdctLong(x[1], prev[1], &y[1][0][0], &bc[1], bt_curr);
+        if (m0 != m1 || memcmp(y[0], y[1], sizeof(y[0])) || memcmp(prev[0], prev[1], sizeof(prev[0]))) {
+            printf("    imdctLong differs (%d blocks, type %d/%d, switch %d/%d, gb %d)\n", bc[0].nBlocksLong,
+                   bt_curr, bc[0].prevType, bc[0].currWinSwitch, bc[0].prevWinSwitch, bc[0].gbIn);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* time per call of each kernel, on decoder-like input */
+static void bench(const MP3Kernels *k)
+{
+    static int vbuf[MAX_NCHAN * VBUF_LENGTH];
+    int x[NBANDS * 18], prev[NBANDS * 9], y[BLOCK_SIZE][NBANDS], buf[32];
+    short pcm[2 * NBANDS];
+    BlockCount bc = { NBANDS, NBANDS, NBANDS, 0, 0, 0, 8, 0 };
+    double t;
+
+    for (int i = 0; i < NBANDS * 18; i++) {
+        x[i] = rnd_gb(8);
+    }
+    for (int i = 0; i < MAX_NCHAN * VBUF_LENGTH; i++) {
+        vbuf[i] = rnd_gb(8);
+    }
+    memset(prev, 0, sizeof(prev));
+
+    t = now_ns();
+    for (int n = 0; n < BENCH_CALLS / 32; n++) {
+        k->imdctLong(x, prev, &y[0][0], &bc, 0);
+    }
+    printf("    imdctLong (32 blocks) %8.1f ns", (now_ns() - t) / (BENCH_CALLS / 32));
+
+    t = now_ns();
+    for (int n = 0; n < BENCH_CALLS; n++) {
+        for (int i = 0; i < 32; i++) {
+            buf[i] = x[i];
+        }
+        k->fdct32(buf, vbuf, n & 7, n & 1, 8);
+    }
+    printf("  fdct32 %6.1f ns", (now_ns() - t) / BENCH_CALLS);
+
+    t = now_ns();
+    for (int n = 0; n < BENCH_CALLS; n++) {
+        k->polyphaseStereo(pcm, vbuf + (n & 7), polyCoef);
+    }
+    printf("  polyphaseStereo %6.1f ns\n", (now_ns() - t) / BENCH_CALLS);
+}
+
+static int decode(corpus_entry_t *entry, const unsigned char *data, int size, int kernels)
+{
+    static short pcm[CORPUS_PCM_MAX_SAMPLES];
+    MP3FrameInfo info;
+    HMP3Stream stream = MP3InitStream(0);
+    uint32_t crc = 0;
+    int frames = 0;
+
+    MP3StreamSetKernels(stream, kernels);
+    for (int pos = 0;;) {
+        int err = MP3StreamDecode(stream, pcm, &info);
+        if (err == ERR_MP3_END_OF_STREAM) {
+            break;
+        } else if (err == ERR_MP3_INDATA_UNDERFLOW) {
+            pos += MP3StreamWrite(stream, data + pos, size - pos);
+            if (pos == size) {
+                MP3StreamSetEOF(stream);
+            }
+        } else if (err == ERR_MP3_NONE) {
+            crc = corpus_crc32(crc, pcm, info.outputSamps);
+            frames++;
+        }
+    }
+    MP3FreeStream(stream);
+
+    return strcmp(corpus_check(entry, frames, crc, 0), "PASS") != 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s corpus.txt\n", argv[0]);
+        return 2;
+    }
+
+    static corpus_entry_t entries[CORPUS_MAX_STREAMS];
+    int n = corpus_load(argv[1], entries, CORPUS_MAX_STREAMS);
+    if (n <= 0) {
+        fprintf(stderr, "no streams in %s\n", argv[1]);
+        return 2;
+    }
+
+    int failures = 0;
+    for (int kernels = 0; kernels < MP3_NUM_KERNELS; kernels++) {
+        const MP3Kernels *k = &mp3Kernels[kernels];
+        int fail = test_fdct32(k) + test_polyphase(k) + test_imdct_long(k);
+
+        for (int i = 0; i < n; i++) {
+            int size = 0;
+            unsigned char *data = corpus_read_stream(&entries[i], &size);
+            if (data == NULL || decode(&entries[i], data, size, kernels)) {
+                printf("    %s differs from the golden values\n", entries[i].label);
+                fail++;
+            }
+            free(data);
+        }
+
+        printf("%-10s %s\n", s_kernel_names[kernels], fail ? "FAIL" : "PASS");
+        bench(k);
+        failures += fail;
+    }
+
+    return failures ? 1 : 0;
+}
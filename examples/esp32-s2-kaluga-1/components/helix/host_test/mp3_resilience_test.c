@@ -0,0 +1,184 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Test for resilient mode (MP3StreamSetResilientMode).
+ *
+ * Every corpus stream is first decoded in resilient mode as is and must match the
+ * golden values, so concealment never kicks in on a clean stream. Then bit errors,
+ * zeroed blocks and cut-out blocks (lost packets) are applied throughout the stream.
+ * The damaged stream must play to the end, keep its length within a few frames of
+ * the clean stream minus the frames cut out, report the damage in the error counters
+ * and decode the tail after the last damage bit-identical to the clean stream.
+ *
+ * Usage:
+ *     mp3_resilience_test corpus.txt
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mp3stream.h"
+#include "corpus.h"
+
+#define DAMAGE_SPACING      40000   /*!< bytes between two damaged spots */
+#define TAIL_FRAMES         50      /*!< frames at the end that must be bit-exact */
+#define MAX_LENGTH_DIFF     4       /*!< frames the damaged stream may be off, besides one per damaged spot */
+
+typedef struct {
+    int frames;
+    uint32_t crc;
+    uint32_t *frame_crcs;
+    int max_frames;
+    MP3ErrorStats stats;
+} decode_result_t;
+
+static uint32_t s_seed = 1;
+
+static uint32_t rnd(void)
+{
+    s_seed = s_seed * 1103515245u + 12345u;
+    return s_seed >> 8;
+}
+
+static void decode(const unsigned char *data, int size, decode_result_t *res)
+{
+    static short pcm[CORPUS_PCM_MAX_SAMPLES];
+    MP3FrameInfo info;
+    HMP3Stream stream = MP3InitStream(0);
+    int pos = 0;
+
+    MP3StreamSetResilientMode(stream, 1);
+    res->frames = 0;
+    res->crc = 0;
+    for (;;) {
+        int err = MP3StreamDecode(stream, pcm, &info);
+        if (err == ERR_MP3_END_OF_STREAM) {
+            break;
+        } else if (err == ERR_MP3_INDATA_UNDERFLOW) {
+            int n = MP3StreamWrite(stream, data + pos, size - pos);
+            pos += n;
+            if (pos == size) {
+                MP3StreamSetEOF(stream);
+            }
+            continue;
+        }
+
+        /* every other result carries a frame of audio, decoded or concealed */
+        uint32_t crc = corpus_crc32(0, pcm, info.outputSamps);
+        res->crc = corpus_crc32(res->crc, pcm, info.outputSamps);
+        if (res->frames < res->max_frames) {
+            res->frame_crcs[res->frames] = crc;
+        }
+        res->frames++;
+    }
+
+    MP3StreamGetErrorStats(stream, &res->stats);
+    MP3FreeStream(stream);
+}
+
+/* damage the stream, returns the new size (cut-outs make it shorter) */
+static int damage(unsigned char *data, int size, int *spots, int *cut_bytes)
+{
+    int start = corpus_id3v2_size(data, size) + 5000;
+
+    *spots = 0;
+    *cut_bytes = 0;
+    for (int pos = start; pos + DAMAGE_SPACING < size; pos += DAMAGE_SPACING) {
+        int at = pos + (int)(rnd() % 1000);
+        (*spots)++;
+        switch (rnd() % 3) {
+        case 0:     /* bit errors */
+            for (int i = 0; i < 16; i++) {
+                data[at + (int)(rnd() % 256)] ^= (unsigned char)(1 << (rnd() % 8));
+            }
+            break;
+        case 1:     /* block of zeros */
+            memset(data + at, 0, 600);
+            break;
+        default:    /* lost packet */
+            memmove(data + at, data + at + 1400, size - at - 1400);
+            size -= 1400;
+            *cut_bytes += 1400;
+            break;
+        }
+    }
+    return size;
+}
+
+static void print_stats(const char *label, const char *mode, const decode_result_t *res, const char *result)
+{
+    int errors = 0;
+    for (int i = 0; i < MP3_NUM_ERROR_CODES; i++) {
+        errors += res->stats.errors[i];
+    }
+    printf("%-36s %-8s %6d frames %5d errors (sideinfo %d, huff %d, scalefact %d, underflow %d) "
+           "%5d concealed %3d resyncs %6d skipped  %s\n", label, mode, res->frames, errors,
+           res->stats.errors[-ERR_MP3_INVALID_SIDEINFO], res->stats.errors[-ERR_MP3_INVALID_HUFFCODES],
+           res->stats.errors[-ERR_MP3_INVALID_SCALEFACT], res->stats.errors[-ERR_MP3_MAINDATA_UNDERFLOW],
+           res->stats.nConcealed, res->stats.nResyncs, res->stats.nSkippedBytes, result);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s corpus.txt\n", argv[0]);
+        return 2;
+    }
+
+    static corpus_entry_t entries[CORPUS_MAX_STREAMS];
+    int n = corpus_load(argv[1], entries, CORPUS_MAX_STREAMS);
+    if (n <= 0) {
+        fprintf(stderr, "no streams in %s\n", argv[1]);
+        return 2;
+    }
+
+    static uint32_t clean_crcs[1 << 16], damaged_crcs[1 << 16];
+    int failures = 0;
+    for (int i = 0; i < n; i++) {
+        int size = 0;
+        unsigned char *data = corpus_read_stream(&entries[i], &size);
+        if (data == NULL) {
+            printf("%-36s cannot read %s\n", entries[i].label, entries[i].path);
+            failures++;
+            continue;
+        }
+
+        decode_result_t clean = { 0, 0, clean_crcs, 1 << 16, { 0 } };
+        decode(data, size, &clean);
+        const char *result = corpus_check(&entries[i], clean.frames, clean.crc, 0);
+        if (strcmp(result, "PASS") != 0 || clean.stats.nConcealed != 0) {
+            result = "FAIL";
+            failures++;
+        }
+        print_stats(entries[i].label, "clean", &clean, result);
+
+        int spots, cut_bytes;
+        int audio_bytes = size - corpus_id3v2_size(data, size);
+        int damaged_size = damage(data, size, &spots, &cut_bytes);
+        decode_result_t damaged = { 0, 0, damaged_crcs, 1 << 16, { 0 } };
+        decode(data, damaged_size, &damaged);
+
+        /* the tail behind the last damage must have recovered completely */
+        int tail_ok = damaged.frames >= TAIL_FRAMES && clean.frames >= TAIL_FRAMES;
+        for (int f = 1; tail_ok && f <= TAIL_FRAMES; f++) {
+            tail_ok = clean_crcs[clean.frames - f] == damaged_crcs[damaged.frames - f];
+        }
+        /* cut-out frames are gone for good, each damaged spot may lose or add one more */
+        int cut_frames = (int)((long long)cut_bytes * clean.frames / audio_bytes);
+        int diff = damaged.frames - (clean.frames - cut_frames);
+        int max_diff = MAX_LENGTH_DIFF + spots;
+        int ok = tail_ok && diff >= -max_diff && diff <= max_diff && damaged.stats.nConcealed > 0;
+        if (!ok) {
+            failures++;
+        }
+        print_stats(entries[i].label, "damaged", &damaged, ok ? "PASS" : "FAIL");
+        free(data);
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,180 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Conformance test for the streaming decoder (mp3stream.h).
+ *
+ * Every corpus stream is fed through MP3StreamDecode in push mode and in pull mode
+ * with random chunk sizes and the smallest ring, so frames regularly straddle the
+ * end of the ring, and once more behind a fake ID3v2 tag full of false sync words.
+ * All runs must reproduce the golden frame count and PCM CRC of the manifest.
+ *
+ * Usage:
+ *     mp3_stream_test corpus.txt
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mp3stream.h"
+#include "corpus.h"
+
+#define FAKE_TAG_BYTES  3000
+
+typedef struct {
+    const unsigned char *data;
+    int size;
+    int pos;
+    uint32_t seed;
+} source_t;
+
+typedef struct {
+    int frames;
+    uint32_t crc;
+} stream_result_t;
+
+static int next_chunk(source_t *src, int max)
+{
+    src->seed = src->seed * 1103515245u + 12345u;
+    int n = 1 + (int)((src->seed >> 8) % 1500);
+    n = n < max ? n : max;
+    return n < src->size - src->pos ? n : src->size - src->pos;
+}
+
+static int source_read(void *arg, unsigned char *buf, int nbytes)
+{
+    source_t *src = (source_t *)arg;
+    int n = next_chunk(src, nbytes);
+    memcpy(buf, src->data + src->pos, n);
+    src->pos += n;
+    return n;
+}
+
+static int run_stream(const unsigned char *data, int size, int pull, int ring_size, stream_result_t *res)
+{
+    static short pcm[CORPUS_PCM_MAX_SAMPLES];
+    MP3FrameInfo info;
+    source_t src = { data, size, 0, 1 };
+
+    memset(res, 0, sizeof(*res));
+    HMP3Stream stream = MP3InitStream(ring_size);
+    if (stream == NULL) {
+        return -1;
+    }
+    if (pull) {
+        MP3StreamSetReader(stream, source_read, &src);
+    }
+
+    for (;;) {
+        int err = MP3StreamDecode(stream, pcm, &info);
+        if (err == ERR_MP3_END_OF_STREAM) {
+            break;
+        } else if (err == ERR_MP3_INDATA_UNDERFLOW) {
+            /* push mode: hand over as much as fits, in random pieces */
+            unsigned char *buf;
+            int space = MP3StreamGetWriteBuffer(stream, &buf);
+            int n = next_chunk(&src, space);
+            if (n == 0 && src.pos == size) {
+                MP3StreamSetEOF(stream);
+            }
+            if (MP3StreamWrite(stream, data + src.pos, n) != n) {
+                break;
+            }
+            src.pos += n;
+        } else if (err == ERR_MP3_NONE) {
+            res->crc = corpus_crc32(res->crc, pcm, info.outputSamps);
+            res->frames++;
+        }
+    }
+
+    MP3FreeStream(stream);
+    return 0;
+}
+
+static unsigned char *with_fake_tag(const unsigned char *data, int size, int *out_size)
+{
+    int skip = corpus_id3v2_size(data, size);
+    unsigned char *buf = malloc(FAKE_TAG_BYTES + size - skip);
+    if (buf == NULL) {
+        return NULL;
+    }
+
+    /* ID3v2.3 header, then frame-header-like junk that must not be decoded */
+    int tag_body = FAKE_TAG_BYTES - 10;
+    memcpy(buf, "ID3\x03\x00\x00", 6);
+    buf[6] = (tag_body >> 21) & 0x7f;
+    buf[7] = (tag_body >> 14) & 0x7f;
+    buf[8] = (tag_body >> 7) & 0x7f;
+    buf[9] = tag_body & 0x7f;
+    for (int i = 10; i < FAKE_TAG_BYTES; i += 4) {
+        static const unsigned char fake[4] = { 0xff, 0xfb, 0x90, 0x64 };
+        memcpy(buf + i, fake, FAKE_TAG_BYTES - i < 4 ? FAKE_TAG_BYTES - i : 4);
+    }
+    memcpy(buf + FAKE_TAG_BYTES, data + skip, size - skip);
+    *out_size = FAKE_TAG_BYTES + size - skip;
+    return buf;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s corpus.txt\n", argv[0]);
+        return 2;
+    }
+
+    static corpus_entry_t entries[CORPUS_MAX_STREAMS];
+    int n = corpus_load(argv[1], entries, CORPUS_MAX_STREAMS);
+    if (n <= 0) {
+        fprintf(stderr, "no streams in %s\n", argv[1]);
+        return 2;
+    }
+
+    static const struct {
+        const char *name;
+        int pull;
+        int ring_size;
+        int fake_tag;
+    } s_modes[] = {
+        { "push",     0, MP3STREAM_MIN_RING_SIZE, 0 },
+        { "pull",     1, MP3STREAM_MIN_RING_SIZE, 0 },
+        { "pull-id3", 1, MP3STREAM_DEF_RING_SIZE, 1 },
+    };
+
+    int failures = 0;
+    for (int i = 0; i < n; i++) {
+        int size = 0;
+        unsigned char *data = corpus_read_stream(&entries[i], &size);
+        if (data == NULL) {
+            printf("%-36s cannot read %s\n", entries[i].label, entries[i].path);
+            failures++;
+            continue;
+        }
+
+        for (size_t m = 0; m < sizeof(s_modes) / sizeof(s_modes[0]); m++) {
+            const unsigned char *input = data;
+            int input_size = size;
+            unsigned char *tagged = NULL;
+            if (s_modes[m].fake_tag) {
+                tagged = with_fake_tag(data, size, &input_size);
+                input = tagged;
+            }
+
+            stream_result_t res;
+            run_stream(input, input_size, s_modes[m].pull, s_modes[m].ring_size, &res);
+            const char *result = corpus_check(&entries[i], res.frames, res.crc, 0);
+            if (strcmp(result, "PASS") != 0) {
+                failures++;
+            }
+            printf("%-36s %-8s %6d %08x  %s\n", entries[i].label, s_modes[m].name, res.frames,
+                   (unsigned int)res.crc, result);
+            free(tagged);
+        }
+        free(data);
+    }
+
+    return failures ? 1 : 0;
+}
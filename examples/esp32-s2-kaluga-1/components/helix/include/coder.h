@@ -91,6 +91,7 @@
 
 /* additional external symbols to name-mangle for static linking */
 #define	SetBitstreamPointer	STATNAME(SetBitstreamPointer)
+#define	SetBitstreamWrap	STATNAME(SetBitstreamWrap)
 #define	GetBits				STATNAME(GetBits)
 #define	CalcBitsUsed		STATNAME(CalcBitsUsed)
 #define	DequantChannel		STATNAME(DequantChannel)
@@ -100,6 +101,12 @@
 #define PolyphaseMono		STATNAME(PolyphaseMono)
 #define PolyphaseStereo		STATNAME(PolyphaseStereo)
 #define FDCT32				STATNAME(FDCT32)
+#define IMDCTLong			STATNAME(IMDCTLong)
+#define PolyphaseMonoBlocked	STATNAME(PolyphaseMonoBlocked)
+#define PolyphaseStereoBlocked	STATNAME(PolyphaseStereoBlocked)
+#define FDCT32Blocked		STATNAME(FDCT32Blocked)
+#define IMDCTLongBlocked	STATNAME(IMDCTLongBlocked)
+#define	mp3Kernels			STATNAME(mp3Kernels)
 
 #define	ISFMpeg1			STATNAME(ISFMpeg1)
 #define	ISFMpeg2			STATNAME(ISFMpeg2)
@@ -130,6 +137,7 @@ typedef struct _BitStreamInfo {
 	unsigned int iCache;
 	int cachedBits;
 	int nBytes;
+	unsigned char *wrapPtr;	/* bytePtr moves back by MAINBUF_RING_SIZE when it reaches this, 0 = never */
 } BitStreamInfo;
 
 typedef struct _FrameHeader {
@@ -255,8 +263,31 @@ typedef struct _SubbandInfo {
 	int vindex;								/* internal index for tracking position in vbuf */
 } SubbandInfo;
 
+typedef struct _ConcealInfo {
+	int spec[MAX_NCHAN][MAX_NSAMP];			/* dequantized spectrum of the last good granule */
+	int nonZeroBound[MAX_NCHAN];
+	int gb[MAX_NCHAN];
+	int blockType[MAX_NCHAN];
+	int nChans;
+	int valid;								/* spec holds a granule */
+	int nConcealed;							/* granules concealed in a row */
+	int gain;								/* Q31 gain of the next concealed granule */
+	unsigned int seed;						/* for sign scrambling */
+} ConcealInfo;
+
+/* one implementation of each DSP stage that dominates decode time (see kernels.c)
+ *   all kernel sets must produce bit-identical output
+ */
+typedef struct _MP3Kernels {
+	int  (*imdctLong)(int *xCurr, int *xPrev, int *y, BlockCount *bc, int btCurr);
+	void (*fdct32)(int *x, int *d, int offset, int oddBlock, int gb);
+	void (*polyphaseMono)(short *pcm, int *vbuf, const int *coefBase);
+	void (*polyphaseStereo)(short *pcm, int *vbuf, const int *coefBase);
+} MP3Kernels;
+
 /* bitstream.c */
 void SetBitstreamPointer(BitStreamInfo *bsi, int nBytes, unsigned char *buf);
+void SetBitstreamWrap(BitStreamInfo *bsi, unsigned char *wrapPtr);
 unsigned int GetBits(BitStreamInfo *bsi, int nBits);
 int CalcBitsUsed(BitStreamInfo *bsi, unsigned char *startBuf, int startOffset);
 
@@ -271,6 +302,14 @@ void IntensityProcMPEG2(int x[MAX_NCHAN][MAX_NSAMP], int nSamps, FrameHeader *fh
 
 /* dct32.c */
 void FDCT32(int *x, int *d, int offset, int oddBlock, int gb);
+void FDCT32Blocked(int *x, int *d, int offset, int oddBlock, int gb);
+
+/* imdct.c */
+int IMDCTLong(int *xCurr, int *xPrev, int *y, BlockCount *bc, int btCurr);
+int IMDCTLongBlocked(int *xCurr, int *xPrev, int *y, BlockCount *bc, int btCurr);
+
+/* kernels.c */
+extern const MP3Kernels mp3Kernels[MP3_NUM_KERNELS];
 
 /* hufftabs.c */
 extern const HuffTabLookup huffTabLookup[HUFF_PAIRTABS];
@@ -290,6 +329,8 @@ extern "C" {
 #endif
 void PolyphaseMono(short *pcm, int *vbuf, const int *coefBase);
 void PolyphaseStereo(short *pcm, int *vbuf, const int *coefBase);
+void PolyphaseMonoBlocked(short *pcm, int *vbuf, const int *coefBase);
+void PolyphaseStereoBlocked(short *pcm, int *vbuf, const int *coefBase);
 #ifdef __cplusplus
 }
 #endif
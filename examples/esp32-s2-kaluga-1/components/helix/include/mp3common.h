@@ -48,6 +48,17 @@
 #include "statname.h"	/* do name-mangling for static linking */
 
 #define MAX_SCFBD		4		/* max scalefactor bands per channel */
+
+/* mainBuf is used as a ring so the bit reservoir never has to be moved:
+ *   new main data is appended at mainWrite, the reservoir is simply the mainDataBegin
+ *   bytes in front of it, and bitstream readers wrap back to mainBuf at mainWrap.
+ *   Must be >= MAINBUF_SIZE so that one frame's main data never overlaps itself.
+ */
+#define MAINBUF_RING_SIZE	2048
+
+/* byte reads from main data, which may wrap around the end of the mainBuf ring */
+#define GetMainByte(p, wrap)	((((p) == (wrap)) ? ((p) -= MAINBUF_RING_SIZE) : 0), *(p)++)
+#define WrapMainPtr(p, wrap)	{ if ((wrap) && (p) >= (wrap)) (p) -= MAINBUF_RING_SIZE; }
 #define NGRANS_MPEG1	2
 #define NGRANS_MPEG2	1
 
@@ -69,9 +80,13 @@ typedef struct _MP3DecInfo {
 	void *DequantInfoPS;
 	void *IMDCTInfoPS;
 	void *SubbandInfoPS;
+	void *ConcealInfoPS;	/* only allocated in resilient mode */
+	const void *KernelsPS;	/* DSP kernel set used by IMDCT and Subband */
 
-	/* buffer which must be large enough to hold largest possible main_data section */
-	unsigned char mainBuf[MAINBUF_SIZE];
+	/* ring buffer which must be large enough to hold largest possible main_data section */
+	unsigned char mainBuf[MAINBUF_RING_SIZE];
+	int mainWrite;			/* write index into mainBuf */
+	unsigned char *mainWrap;	/* mainBuf + MAINBUF_RING_SIZE, or 0 if main data is linear (useSize) */
 
 	/* special info for "free" bitrate files */
 	int freeBitrateFlag;
@@ -92,6 +107,15 @@ typedef struct _MP3DecInfo {
 
 	int part23Length[MAX_NGRAN][MAX_NCHAN];
 
+	MP3ErrorStats errStats;
+
+	int inArena;			/* decoder lives in caller memory (MP3InitDecoderArena), never freed */
+	int arenaFlags;			/* MP3_ARENA_xxx flags of that memory */
+
+#ifdef HELIX_PROFILE
+	MP3ProfileInfo profile;
+#endif
+
 } MP3DecInfo;
 
 typedef struct _SFBandTable {
@@ -101,7 +125,12 @@ typedef struct _SFBandTable {
 
 /* decoder functions which must be implemented for each platform */
 MP3DecInfo *AllocateBuffers(void);
+int GetArenaSize(int flags);
+MP3DecInfo *AllocateArenaBuffers(void *arena, int arenaSize, int flags);
 void FreeBuffers(MP3DecInfo *mp3DecInfo);
+int SelectKernels(MP3DecInfo *mp3DecInfo, int kernels);
+int AllocateConcealInfo(MP3DecInfo *mp3DecInfo);
+void FreeConcealInfo(MP3DecInfo *mp3DecInfo);
 int CheckPadBit(MP3DecInfo *mp3DecInfo);
 int UnpackFrameHeader(MP3DecInfo *mp3DecInfo, unsigned char *buf);
 int UnpackSideInfo(MP3DecInfo *mp3DecInfo, unsigned char *buf);
@@ -111,6 +140,14 @@ int IMDCT(MP3DecInfo *mp3DecInfo, int gr, int ch);
 int UnpackScaleFactors(MP3DecInfo *mp3DecInfo, unsigned char *buf, int *bitOffset, int bitsAvail, int gr, int ch);
 int Subband(MP3DecInfo *mp3DecInfo, short *pcmBuf);
 
+/* mp3dec.c - shared by MP3Decode and the streaming decoder (mp3stream.c) */
+unsigned char *FillMainBuf(MP3DecInfo *mp3DecInfo, unsigned char *buf0, int len0, unsigned char *buf1, int len1);
+int DecodeMainData(MP3DecInfo *mp3DecInfo, unsigned char *mainPtr, short *outbuf);
+void ClearBadFrame(MP3DecInfo *mp3DecInfo, short *outbuf, int gr);
+void SaveConcealGranule(MP3DecInfo *mp3DecInfo, int gr);
+void ConcealGranules(MP3DecInfo *mp3DecInfo, short *outbuf, int gr);
+void UpdateErrorStats(MP3DecInfo *mp3DecInfo, int err);
+
 /* mp3tabs.c - global ROM tables */
 extern const int samplerateTab[3][3];
 extern const short bitrateTab[3][3][15];
@@ -105,10 +105,39 @@ enum {
 	ERR_MP3_INVALID_DEQUANTIZE =   -10,
 	ERR_MP3_INVALID_IMDCT =        -11,
 	ERR_MP3_INVALID_SUBBAND =      -12,
+	ERR_MP3_END_OF_STREAM =        -13,
 
 	ERR_UNKNOWN =                  -9999
 };
 
+/* DSP kernel sets for MP3SetKernels, all of them produce bit-identical PCM */
+enum {
+	MP3_KERNELS_REFERENCE =         0,	/* straight C, one block at a time (original Helix code) */
+	MP3_KERNELS_BLOCKED =           1,	/* independent blocks/taps in short fixed-length loops, for vectorizing compilers */
+
+	MP3_NUM_KERNELS
+};
+
+/* kernel set of a new decoder, may be overridden at build time */
+#ifndef HELIX_DEFAULT_KERNELS
+#define HELIX_DEFAULT_KERNELS	MP3_KERNELS_REFERENCE
+#endif
+
+/* decoder in caller memory (MP3InitDecoderArena) */
+#define MP3_ARENA_ALIGN			8		/* required alignment of the memory block */
+#define MP3_ARENA_RESILIENT		0x01	/* also reserve the concealment state for MP3SetResilientMode */
+
+#define MP3_NUM_ERROR_CODES		14	/* MP3ErrorStats.errors is indexed by -ERR_MP3_xxx */
+
+/* stream health, counted by MP3Decode and MP3StreamDecode whether or not resilient mode is on */
+typedef struct _MP3ErrorStats {
+	int nFrames;							/* frames decoded without error */
+	int nConcealed;							/* granules synthesized by concealment (resilient mode) */
+	int nResyncs;							/* sync lost and found again (stream API) */
+	int nSkippedBytes;						/* bytes dropped while searching for sync (stream API) */
+	int errors[MP3_NUM_ERROR_CODES];		/* frames that returned each error code */
+} MP3ErrorStats;
+
 typedef struct _MP3FrameInfo {
 	int bitrate;
 	int nChans;
@@ -119,8 +148,29 @@ typedef struct _MP3FrameInfo {
 	int version;
 } MP3FrameInfo;
 
+#ifdef HELIX_PROFILE
+/* decode stages timed by MP3Decode when built with -DHELIX_PROFILE */
+enum {
+	MP3_STAGE_HEADER =      0,	/* frame header, side info, bit reservoir */
+	MP3_STAGE_SCALEFACT =   1,
+	MP3_STAGE_HUFFMAN =     2,
+	MP3_STAGE_DEQUANT =     3,
+	MP3_STAGE_IMDCT =       4,
+	MP3_STAGE_SUBBAND =     5,
+
+	MP3_NUM_STAGES
+};
+
+typedef struct _MP3ProfileInfo {
+	unsigned long long cycles[MP3_NUM_STAGES];	/* accumulated cycles per stage */
+	int nFrames;								/* frames decoded without error */
+} MP3ProfileInfo;
+#endif
+
 /* public API */
 HMP3Decoder MP3InitDecoder(void);
+int MP3GetDecoderArenaSize(int flags);
+HMP3Decoder MP3InitDecoderArena(void *arena, int arenaSize, int flags);
 void MP3FreeDecoder(HMP3Decoder hMP3Decoder);
 int MP3Decode(HMP3Decoder hMP3Decoder, unsigned char **inbuf, int *bytesLeft, short *outbuf, int useSize);
 
@@ -128,6 +178,16 @@ void MP3GetLastFrameInfo(HMP3Decoder hMP3Decoder, MP3FrameInfo *mp3FrameInfo);
 int MP3GetNextFrameInfo(HMP3Decoder hMP3Decoder, MP3FrameInfo *mp3FrameInfo, unsigned char *buf);
 int MP3FindSyncWord(unsigned char *buf, int nBytes);
 
+int MP3SetResilientMode(HMP3Decoder hMP3Decoder, int enable);
+void MP3GetErrorStats(HMP3Decoder hMP3Decoder, MP3ErrorStats *mp3ErrorStats);
+void MP3ResetErrorStats(HMP3Decoder hMP3Decoder);
+int MP3SetKernels(HMP3Decoder hMP3Decoder, int kernels);
+
+#ifdef HELIX_PROFILE
+void MP3GetProfileInfo(HMP3Decoder hMP3Decoder, MP3ProfileInfo *mp3ProfileInfo);
+void MP3ResetProfileInfo(HMP3Decoder hMP3Decoder);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,89 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**************************************************************************************
+ * mp3index.h - frame index, duration and time based seek for MP3 files
+ *
+ * The scanner only looks at frame headers. It is fed the file in arbitrary sequential
+ *   chunks (typically the same data that goes to the decoder, so indexing costs no extra
+ *   I/O) and keeps the file offset of every stepFrames-th frame in a fixed size table.
+ *   When the table fills up, every other entry is dropped and stepFrames doubles, so
+ *   memory stays bounded for any file length.
+ *
+ * A Xing/Info or VBRI header in the first frame gives the exact frame count (and so the
+ *   duration of VBR files) before anything is scanned, and its TOC is used to estimate
+ *   the position of frames the scan has not reached yet. A LAME tag behind the Xing/Info
+ *   header gives the encoder delay and padding, so a player can cut the silence the
+ *   encoder added and play consecutive tracks without a gap.
+ **************************************************************************************/
+
+#ifndef _MP3INDEX_H
+#define _MP3INDEX_H
+
+#include "mp3dec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MP3INDEX_DEF_POINTS		1024
+#define MP3_DECODER_DELAY		529		/* output delay of the synthesis filterbank in samples (LAME convention) */
+
+enum {
+	MP3INDEX_VBR_NONE =	0,
+	MP3INDEX_VBR_XING =	1,		/* Xing or Info (LAME CBR) header */
+	MP3INDEX_VBR_VBRI =	2		/* Fraunhofer VBRI header */
+};
+
+typedef void *HMP3Index;
+
+typedef struct _MP3IndexInfo {
+	int samprate;
+	int nChans;
+	int version;
+	int samplesPerFrame;
+	int vbrHeader;				/* MP3INDEX_VBR_xxx found in the first frame */
+	int firstAudioFrame;		/* 1 if frame 0 only carries the VBR header */
+	int nFrames;				/* audio frames (not counting a VBR header frame) */
+	int durationMs;
+	int exact;					/* nFrames/durationMs are exact (VBR header or complete scan) */
+	int complete;				/* the whole file has been scanned */
+	int nIndexed;				/* frames found by the scan so far */
+	int stepFrames;				/* frames between index points */
+	unsigned int dataStart;		/* file offset of frame 0 */
+	unsigned int scanPos;		/* file offset the scanner has to be fed next */
+
+	/* from a LAME tag, all 0 if gapless is 0 */
+	int gapless;
+	int encDelay;				/* samples of silence the encoder put in front */
+	int encPadding;				/* samples the encoder appended to fill the last frame */
+	int startSkip;				/* samples to drop from the decoder output of frame 0 (VBR header frame, encDelay, MP3_DECODER_DELAY) */
+	int nSamples;				/* samples to play after that, the length of the original audio */
+} MP3IndexInfo;
+
+typedef struct _MP3SeekInfo {
+	unsigned int offset;		/* file offset to continue reading at */
+	int frame;					/* number of the frame at offset */
+	int targetFrame;			/* frame containing the requested time */
+	int primeFrames;			/* frames to decode and drop before targetFrame, see MP3StreamFlush */
+	int exact;					/* 0 if offset and frame are estimates (not scanned yet) */
+} MP3SeekInfo;
+
+/* maxPoints bounds the size of the offset table (4 bytes per point), 0 selects MP3INDEX_DEF_POINTS */
+HMP3Index MP3InitIndex(int maxPoints);
+void MP3FreeIndex(HMP3Index hMP3Index);
+void MP3IndexReset(HMP3Index hMP3Index);
+void MP3IndexSetFileSize(HMP3Index hMP3Index, unsigned int fileBytes);
+unsigned int MP3IndexFeed(HMP3Index hMP3Index, const unsigned char *buf, int nBytes, unsigned int fileOffset);
+void MP3GetIndexInfo(HMP3Index hMP3Index, MP3IndexInfo *mp3IndexInfo);
+int MP3IndexSeek(HMP3Index hMP3Index, int timeMs, MP3SeekInfo *mp3SeekInfo);
+int MP3IndexFrameToMs(HMP3Index hMP3Index, int frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* _MP3INDEX_H */
@@ -0,0 +1,60 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**************************************************************************************
+ * mp3profile.h - per-stage cycle accounting for MP3Decode
+ *
+ * Compiled out completely unless HELIX_PROFILE is defined. The cycle source can be
+ *   overridden by defining HELIX_PROFILE_CYCLES() to an expression returning an
+ *   unsigned int counter (only differences between two readings are used, so a
+ *   wrapping 32-bit counter is fine)
+ **************************************************************************************/
+
+#ifndef _MP3PROFILE_H
+#define _MP3PROFILE_H
+
+#ifdef HELIX_PROFILE
+
+#ifndef HELIX_PROFILE_CYCLES
+#if defined(ESP_PLATFORM)
+#include "xtensa/hal.h"
+#define HELIX_PROFILE_CYCLES()	((unsigned int)xthal_get_ccount())
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define HELIX_PROFILE_CYCLES()	((unsigned int)__rdtsc())
+#else
+#include <time.h>
+static __inline unsigned int MP3ProfileNanos(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned int)(ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+#define HELIX_PROFILE_CYCLES()	MP3ProfileNanos()
+#endif
+#endif	/* HELIX_PROFILE_CYCLES */
+
+/* MP3_PROFILE_BEGIN starts the clock, each MP3_PROFILE_MARK charges the time since the
+ *   previous mark to one stage, so stages are measured back to back without gaps
+ */
+#define MP3_PROFILE_BEGIN()				unsigned int profMark = HELIX_PROFILE_CYCLES()
+#define MP3_PROFILE_MARK(di, stage)		do { \
+		unsigned int profNow = HELIX_PROFILE_CYCLES(); \
+		(di)->profile.cycles[(stage)] += profNow - profMark; \
+		profMark = profNow; \
+	} while (0)
+#define MP3_PROFILE_FRAME_DONE(di)		((di)->profile.nFrames++)
+
+#else
+
+#define MP3_PROFILE_BEGIN()
+#define MP3_PROFILE_MARK(di, stage)
+#define MP3_PROFILE_FRAME_DONE(di)
+
+#endif	/* HELIX_PROFILE */
+
+#endif	/* _MP3PROFILE_H */
@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**************************************************************************************
+ * mp3stream.h - streaming C API on top of the Helix MP3 decoder
+ *
+ * Input goes through a ring buffer owned by the stream, either pushed by the caller
+ *   (MP3StreamGetWriteBuffer/MP3StreamCommitWrite or MP3StreamWrite) or pulled from a
+ *   read callback (MP3StreamSetReader). MP3StreamDecode then returns one frame of PCM
+ *   per call. Frames that straddle the end of the ring are decoded in place, so the
+ *   input never has to be moved, and ID3v2 tags, junk between frames and lost sync
+ *   are handled internally.
+ **************************************************************************************/
+
+#ifndef _MP3STREAM_H
+#define _MP3STREAM_H
+
+#include "mp3dec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MP3STREAM_MIN_RING_SIZE		2048	/* holds the largest standard frame plus the next header */
+#define MP3STREAM_DEF_RING_SIZE		4096
+
+typedef void *HMP3Stream;
+
+/* read callback for pull mode: fill up to nBytes into buf,
+ *   return number of bytes read, 0 at end of stream, < 0 on error (treated as end of stream)
+ */
+typedef int (*MP3StreamReadFunc)(void *arg, unsigned char *buf, int nBytes);
+
+/* ringSize is rounded up to a power of 2, 0 selects MP3STREAM_DEF_RING_SIZE */
+HMP3Stream MP3InitStream(int ringSize);
+/* same in one caller-supplied block (MP3_ARENA_ALIGN aligned), no malloc at all */
+int MP3GetStreamArenaSize(int ringSize, int flags);
+HMP3Stream MP3InitStreamArena(void *arena, int arenaSize, int ringSize, int flags);
+void MP3FreeStream(HMP3Stream hMP3Stream);
+void MP3StreamReset(HMP3Stream hMP3Stream);
+void MP3StreamFlush(HMP3Stream hMP3Stream, int primeFrames);
+int MP3StreamSetResilientMode(HMP3Stream hMP3Stream, int enable);
+int MP3StreamSetKernels(HMP3Stream hMP3Stream, int kernels);
+void MP3StreamGetErrorStats(HMP3Stream hMP3Stream, MP3ErrorStats *mp3ErrorStats);
+void MP3StreamResetErrorStats(HMP3Stream hMP3Stream);
+
+/* pull mode */
+void MP3StreamSetReader(HMP3Stream hMP3Stream, MP3StreamReadFunc readFunc, void *readArg);
+
+/* push mode */
+int MP3StreamGetWriteBuffer(HMP3Stream hMP3Stream, unsigned char **buf);
+void MP3StreamCommitWrite(HMP3Stream hMP3Stream, int nBytes);
+int MP3StreamWrite(HMP3Stream hMP3Stream, const unsigned char *buf, int nBytes);
+void MP3StreamSetEOF(HMP3Stream hMP3Stream);
+int MP3StreamBytesBuffered(HMP3Stream hMP3Stream);
+
+int MP3StreamDecode(HMP3Stream hMP3Stream, short *outbuf, MP3FrameInfo *mp3FrameInfo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* _MP3STREAM_H */
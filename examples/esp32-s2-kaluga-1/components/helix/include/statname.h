@@ -65,11 +65,22 @@
 #define	UnpackSideInfo		STATNAME(UnpackSideInfo)
 #define	AllocateBuffers		STATNAME(AllocateBuffers)
 #define	FreeBuffers			STATNAME(FreeBuffers)
+#define	GetArenaSize		STATNAME(GetArenaSize)
+#define	AllocateArenaBuffers	STATNAME(AllocateArenaBuffers)
+#define	AllocateConcealInfo	STATNAME(AllocateConcealInfo)
+#define	FreeConcealInfo		STATNAME(FreeConcealInfo)
+#define	SelectKernels		STATNAME(SelectKernels)
 #define	DecodeHuffman		STATNAME(DecodeHuffman)
 #define	Dequantize			STATNAME(Dequantize)
 #define	IMDCT				STATNAME(IMDCT)
 #define	UnpackScaleFactors	STATNAME(UnpackScaleFactors)
 #define	Subband				STATNAME(Subband)
+#define	FillMainBuf			STATNAME(FillMainBuf)
+#define	DecodeMainData		STATNAME(DecodeMainData)
+#define	ClearBadFrame		STATNAME(ClearBadFrame)
+#define	UpdateErrorStats	STATNAME(UpdateErrorStats)
+#define	SaveConcealGranule	STATNAME(SaveConcealGranule)
+#define	ConcealGranules		STATNAME(ConcealGranules)
 
 #define	samplerateTab		STATNAME(samplerateTab)
 #define	bitrateTab			STATNAME(bitrateTab)
@@ -80,6 +80,24 @@ void SetBitstreamPointer(BitStreamInfo *bsi, int nBytes, unsigned char *buf)
 	bsi->iCache = 0;		/* 4-byte unsigned int */
 	bsi->cachedBits = 0;	/* i.e. zero bits in cache */
 	bsi->nBytes = nBytes;
+	bsi->wrapPtr = 0;		/* linear buffer */
+}
+
+/**************************************************************************************
+ * Function:    SetBitstreamWrap
+ *
+ * Description: make bitstream reader wrap around the end of the main data ring
+ *
+ * Inputs:      pointer to BitStreamInfo struct initialized by SetBitstreamPointer
+ *              end of the ring (mainBuf + MAINBUF_RING_SIZE), or 0 for a linear buffer
+ *
+ * Outputs:     updated bitstream info struct
+ *
+ * Return:      none
+ **************************************************************************************/
+void SetBitstreamWrap(BitStreamInfo *bsi, unsigned char *wrapPtr)
+{
+	bsi->wrapPtr = wrapPtr;
 }
 
 /**************************************************************************************
@@ -106,16 +124,16 @@ static __inline void RefillBitstreamCache(BitStreamInfo *bsi)
 
 	/* optimize for common case, independent of machine endian-ness */
 	if (nBytes >= 4) {
-		bsi->iCache  = (*bsi->bytePtr++) << 24;
-		bsi->iCache |= (*bsi->bytePtr++) << 16;
-		bsi->iCache |= (*bsi->bytePtr++) <<  8;
-		bsi->iCache |= (*bsi->bytePtr++);
+		bsi->iCache  = GetMainByte(bsi->bytePtr, bsi->wrapPtr) << 24;
+		bsi->iCache |= GetMainByte(bsi->bytePtr, bsi->wrapPtr) << 16;
+		bsi->iCache |= GetMainByte(bsi->bytePtr, bsi->wrapPtr) <<  8;
+		bsi->iCache |= GetMainByte(bsi->bytePtr, bsi->wrapPtr);
 		bsi->cachedBits = 32;
 		bsi->nBytes -= 4;
 	} else {
 		bsi->iCache = 0;
 		while (nBytes--) {
-			bsi->iCache |= (*bsi->bytePtr++);
+			bsi->iCache |= GetMainByte(bsi->bytePtr, bsi->wrapPtr);
 			bsi->iCache <<= 8;
 		}
 		bsi->iCache <<= ((3 - bsi->nBytes)*8);
@@ -177,12 +195,17 @@ unsigned int GetBits(BitStreamInfo *bsi, int nBits)
  * Outputs:     none
  *
  * Return:      number of bits read from bitstream, as offset from startBuf:startOffset
+ *
+ * Notes:       if the reader wrapped around the main data ring, bytePtr is below startBuf
  **************************************************************************************/
 int CalcBitsUsed(BitStreamInfo *bsi, unsigned char *startBuf, int startOffset)
 {
-	int bitsUsed;
+	int bitsUsed, nBytes;
 
-	bitsUsed  = (bsi->bytePtr - startBuf) * 8;
+	nBytes = bsi->bytePtr - startBuf;
+	if (nBytes < 0)
+		nBytes += MAINBUF_RING_SIZE;
+	bitsUsed  = nBytes * 8;
 	bitsUsed -= bsi->cachedBits;
 	bitsUsed -= startOffset;
 
@@ -136,6 +136,83 @@ MP3DecInfo *AllocateBuffers(void)
 	ClearBuffer(mi,  sizeof(IMDCTInfo));
 	ClearBuffer(sbi, sizeof(SubbandInfo));
 
+	SelectKernels(mp3DecInfo, HELIX_DEFAULT_KERNELS);
+
+	return mp3DecInfo;
+}
+
+#define ARENA_ROUND(n)	(((int)(n) + MP3_ARENA_ALIGN - 1) & ~(MP3_ARENA_ALIGN - 1))
+
+/* layout of a decoder in caller memory: the parts allocated by AllocateBuffers, in the
+ *   same order, each rounded to MP3_ARENA_ALIGN, then the optional concealment state
+ */
+#define ARENA_BASE_SIZE	(ARENA_ROUND(sizeof(MP3DecInfo)) + ARENA_ROUND(sizeof(FrameHeader)) + \
+						 ARENA_ROUND(sizeof(SideInfo)) + ARENA_ROUND(sizeof(ScaleFactorInfo)) + \
+						 ARENA_ROUND(sizeof(HuffmanInfo)) + ARENA_ROUND(sizeof(DequantInfo)) + \
+						 ARENA_ROUND(sizeof(IMDCTInfo)) + ARENA_ROUND(sizeof(SubbandInfo)))
+
+/**************************************************************************************
+ * Function:    GetArenaSize
+ *
+ * Description: size of the memory block AllocateArenaBuffers needs
+ *
+ * Inputs:      MP3_ARENA_xxx flags
+ *
+ * Outputs:     none
+ *
+ * Return:      size in bytes
+ **************************************************************************************/
+int GetArenaSize(int flags)
+{
+	int size = ARENA_BASE_SIZE;
+
+	if (flags & MP3_ARENA_RESILIENT)
+		size += ARENA_ROUND(sizeof(ConcealInfo));
+
+	return size;
+}
+
+/**************************************************************************************
+ * Function:    AllocateArenaBuffers
+ *
+ * Description: place all the memory needed for the MP3 decoder in a caller-supplied
+ *                block, without any heap allocation
+ *
+ * Inputs:      pointer to the block, MP3_ARENA_ALIGN aligned
+ *              size of the block in bytes (at least GetArenaSize(flags))
+ *              MP3_ARENA_xxx flags
+ *
+ * Outputs:     cleared block
+ *
+ * Return:      pointer to MP3DecInfo structure (at the start of the block), initialized
+ *                like AllocateBuffers, 0 if the block is too small or misaligned
+ *
+ * Notes:       FreeBuffers leaves such a decoder alone, the caller owns the memory
+ **************************************************************************************/
+MP3DecInfo *AllocateArenaBuffers(void *arena, int arenaSize, int flags)
+{
+	MP3DecInfo *mp3DecInfo;
+	unsigned char *p = (unsigned char *)arena;
+
+	if (!p || ((unsigned long)p & (MP3_ARENA_ALIGN - 1)) || arenaSize < GetArenaSize(flags))
+		return 0;
+
+	/* important to do this - DSP primitives assume a bunch of state variables are 0 on first use */
+	ClearBuffer(p, ARENA_BASE_SIZE);
+
+	mp3DecInfo = (MP3DecInfo *)p;					p += ARENA_ROUND(sizeof(MP3DecInfo));
+	mp3DecInfo->FrameHeaderPS =     (void *)p;		p += ARENA_ROUND(sizeof(FrameHeader));
+	mp3DecInfo->SideInfoPS =        (void *)p;		p += ARENA_ROUND(sizeof(SideInfo));
+	mp3DecInfo->ScaleFactorInfoPS = (void *)p;		p += ARENA_ROUND(sizeof(ScaleFactorInfo));
+	mp3DecInfo->HuffmanInfoPS =     (void *)p;		p += ARENA_ROUND(sizeof(HuffmanInfo));
+	mp3DecInfo->DequantInfoPS =     (void *)p;		p += ARENA_ROUND(sizeof(DequantInfo));
+	mp3DecInfo->IMDCTInfoPS =       (void *)p;		p += ARENA_ROUND(sizeof(IMDCTInfo));
+	mp3DecInfo->SubbandInfoPS =     (void *)p;
+
+	mp3DecInfo->inArena = 1;
+	mp3DecInfo->arenaFlags = flags;
+	SelectKernels(mp3DecInfo, HELIX_DEFAULT_KERNELS);
+
 	return mp3DecInfo;
 }
 
@@ -153,10 +230,11 @@ MP3DecInfo *AllocateBuffers(void)
  * Return:      none
  *
  * Notes:       safe to call even if some buffers were not allocated (uses SAFE_FREE)
+ *              does nothing for a decoder in caller memory (AllocateArenaBuffers)
  **************************************************************************************/
 void FreeBuffers(MP3DecInfo *mp3DecInfo)
 {
-	if (!mp3DecInfo)
+	if (!mp3DecInfo || mp3DecInfo->inArena)
 		return;
 
 	SAFE_FREE(mp3DecInfo->FrameHeaderPS);
@@ -166,6 +244,58 @@ void FreeBuffers(MP3DecInfo *mp3DecInfo)
 	SAFE_FREE(mp3DecInfo->DequantInfoPS);
 	SAFE_FREE(mp3DecInfo->IMDCTInfoPS);
 	SAFE_FREE(mp3DecInfo->SubbandInfoPS);
+	SAFE_FREE(mp3DecInfo->ConcealInfoPS);
 
 	SAFE_FREE(mp3DecInfo);
 }
+
+/**************************************************************************************
+ * Function:    AllocateConcealInfo
+ *
+ * Description: allocate the concealment state used in resilient mode
+ *
+ * Inputs:      mp3DecInfo struct
+ *
+ * Outputs:     mp3DecInfo->ConcealInfoPS points to a cleared ConcealInfo struct
+ *
+ * Return:      0 if successful, -1 if malloc fails (or the arena of a decoder in
+ *                caller memory has no room for it, see MP3_ARENA_RESILIENT)
+ **************************************************************************************/
+int AllocateConcealInfo(MP3DecInfo *mp3DecInfo)
+{
+	ConcealInfo *ci;
+
+	if (mp3DecInfo->inArena) {
+		if (!(mp3DecInfo->arenaFlags & MP3_ARENA_RESILIENT))
+			return -1;
+		ci = (ConcealInfo *)((unsigned char *)mp3DecInfo + ARENA_BASE_SIZE);
+	} else {
+		ci = (ConcealInfo *)malloc(sizeof(ConcealInfo));
+	}
+	if (!ci)
+		return -1;
+	ClearBuffer(ci, sizeof(ConcealInfo));
+	ci->seed = 1;
+
+	mp3DecInfo->ConcealInfoPS = (void *)ci;
+	return 0;
+}
+
+/**************************************************************************************
+ * Function:    FreeConcealInfo
+ *
+ * Description: free the concealment state allocated by AllocateConcealInfo
+ *
+ * Inputs:      mp3DecInfo struct
+ *
+ * Outputs:     mp3DecInfo->ConcealInfoPS = 0
+ *
+ * Return:      none
+ **************************************************************************************/
+void FreeConcealInfo(MP3DecInfo *mp3DecInfo)
+{
+	if (mp3DecInfo->inArena)
+		mp3DecInfo->ConcealInfoPS = 0;
+	else
+		SAFE_FREE(mp3DecInfo->ConcealInfoPS);
+}
@@ -0,0 +1,123 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**************************************************************************************
+ * conceal.c - frame loss concealment for resilient mode
+ *
+ * After every good granule the dequantized spectrum is kept. A damaged or missing
+ *   granule is synthesized from it instead of being muted: the first one repeats the
+ *   spectrum as is, following ones scramble the signs (so a held spectrum turns into
+ *   noise of the same color instead of a buzz) and fade out by 3 dB per granule until
+ *   the output is silent. Short block spectra are not repeated since that would repeat
+ *   a transient, such granules fade out through the IMDCT overlap only.
+ *
+ * Concealed granules run through the normal IMDCT and polyphase filter, so the overlap
+ *   state stays continuous and the first good frame afterwards blends in.
+ **************************************************************************************/
+
+#include "coder.h"
+#include "assembly.h"
+
+#define CONCEAL_FADE			0x5a82799a	/* Q31, -3 dB per concealed granule */
+#define MAX_CONCEAL_GRANULES	16			/* then output silence */
+
+/**************************************************************************************
+ * Function:    SaveConcealGranule
+ *
+ * Description: keep the dequantized spectrum of a good granule for concealment
+ *
+ * Inputs:      mp3DecInfo struct with dequantized spectrum of granule gr in huffDecBuf
+ *
+ * Outputs:     updated ConcealInfo (if resilient mode is on)
+ *
+ * Return:      none
+ *
+ * Notes:       must be called after Dequantize and before IMDCT, which modifies
+ *                huffDecBuf in place (anti-aliasing)
+ **************************************************************************************/
+void SaveConcealGranule(MP3DecInfo *mp3DecInfo, int gr)
+{
+	ConcealInfo *ci = (ConcealInfo *)mp3DecInfo->ConcealInfoPS;
+	HuffmanInfo *hi = (HuffmanInfo *)mp3DecInfo->HuffmanInfoPS;
+	SideInfo *si = (SideInfo *)mp3DecInfo->SideInfoPS;
+	int ch, i;
+
+	if (!ci)
+		return;
+
+	for (ch = 0; ch < mp3DecInfo->nChans; ch++) {
+		for (i = 0; i < hi->nonZeroBound[ch]; i++)
+			ci->spec[ch][i] = hi->huffDecBuf[ch][i];
+		ci->nonZeroBound[ch] = hi->nonZeroBound[ch];
+		ci->gb[ch] = hi->gb[ch];
+		ci->blockType[ch] = si->sis[gr][ch].blockType;
+	}
+	ci->nChans = mp3DecInfo->nChans;
+	ci->valid = 1;
+	ci->nConcealed = 0;
+	ci->gain = 0x7fffffff;
+}
+
+/**************************************************************************************
+ * Function:    ConcealGranules
+ *
+ * Description: synthesize granules gr ... nGrans-1 of a damaged frame from the last
+ *                good spectrum
+ *
+ * Inputs:      mp3DecInfo struct with frame header of the damaged frame unpacked
+ *                (nChans, nGrans, nGranSamps)
+ *              pointer to outbuf
+ *              first granule to conceal (earlier granules of the frame decoded fine)
+ *
+ * Outputs:     PCM data of the concealed granules in outbuf
+ *
+ * Return:      none
+ **************************************************************************************/
+void ConcealGranules(MP3DecInfo *mp3DecInfo, short *outbuf, int gr)
+{
+	ConcealInfo *ci = (ConcealInfo *)mp3DecInfo->ConcealInfoPS;
+	HuffmanInfo *hi = (HuffmanInfo *)mp3DecInfo->HuffmanInfoPS;
+	SideInfo *si = (SideInfo *)mp3DecInfo->SideInfoPS;
+	int ch, src, i, x, nzb, gain, scramble;
+
+	for (; gr < mp3DecInfo->nGrans; gr++) {
+		for (ch = 0; ch < mp3DecInfo->nChans; ch++) {
+			src = MIN(ch, ci->nChans - 1);
+			nzb = 0;
+			if (ci->valid && src >= 0 && ci->blockType[src] != 2 && ci->nConcealed < MAX_CONCEAL_GRANULES) {
+				nzb = ci->nonZeroBound[src];
+				gain = ci->gain;
+				scramble = (ci->nConcealed > 0);
+				for (i = 0; i < nzb; i++) {
+					x = MULSHIFT32(ci->spec[src][i], gain) << 1;
+					if (scramble) {
+						ci->seed = ci->seed * 1664525 + 1013904223;
+						if (ci->seed & 0x80000000)
+							x = -x;
+					}
+					hi->huffDecBuf[ch][i] = x;
+				}
+				hi->gb[ch] = ci->gb[src];
+			} else {
+				hi->gb[ch] = 31;
+			}
+			for (i = nzb; i < MAX_NSAMP; i++)
+				hi->huffDecBuf[ch][i] = 0;
+			hi->nonZeroBound[ch] = nzb;
+
+			/* plain long block, the side info of the damaged frame can't be trusted */
+			si->sis[gr][ch].blockType = 0;
+			si->sis[gr][ch].mixedBlock = 0;
+			si->sis[gr][ch].winSwitchFlag = 0;
+			IMDCT(mp3DecInfo, gr, ch);
+		}
+		Subband(mp3DecInfo, outbuf + gr*mp3DecInfo->nGranSamps*mp3DecInfo->nChans);
+
+		ci->nConcealed++;
+		ci->gain = MULSHIFT32(ci->gain, CONCEAL_FADE) << 1;
+		mp3DecInfo->errStats.nConcealed++;
+	}
+}
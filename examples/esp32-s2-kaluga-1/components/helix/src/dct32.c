@@ -102,6 +102,29 @@ static const int dcttab[48] = {
 	-COS2_1, -COS2_2, COS3_1, 	/* 31, 31, 30 */
 };
 
+/* dcttab rearranged for FDCT32Blocked, one row per coefficient, one column per lane
+ *   first pass: lane = butterfly 0-7, second pass: lane = group of 8 outputs 0-3
+ */
+static const int dctFP[3][8] = {
+	{ COS0_0,  COS0_1,  COS0_2,  COS0_3,  COS0_4,  COS0_5,  COS0_6,  COS0_7  },
+	{ COS0_15, COS0_14, COS0_13, COS0_12, COS0_11, COS0_10, COS0_9,  COS0_8  },
+	{ COS1_0,  COS1_1,  COS1_2,  COS1_3,  COS1_4,  COS1_5,  COS1_6,  COS1_7  },
+};
+
+static const int dctFPShift[2][8] = {
+	{ 5, 3, 3, 2, 2, 1, 1, 1 },
+	{ 1, 1, 1, 1, 1, 2, 2, 4 },
+};
+
+static const int dctSP[6][4] = {
+	{ COS2_0, -COS2_0, COS2_0, -COS2_0 },
+	{ COS2_3, -COS2_3, COS2_3, -COS2_3 },
+	{ COS3_0,  COS3_0, COS3_0,  COS3_0 },
+	{ COS2_1, -COS2_1, COS2_1, -COS2_1 },
+	{ COS2_2, -COS2_2, COS2_2, -COS2_2 },
+	{ COS3_1,  COS3_1, COS3_1,  COS3_1 },
+};
+
 #define D32FP(i, s0, s1, s2) { \
     a0 = buf[i];			a3 = buf[31-i]; \
 	a1 = buf[15-i];			a2 = buf[16+i]; \
@@ -112,91 +135,23 @@ static const int dcttab[48] = {
 }
 
 /**************************************************************************************
- * Function:    FDCT32
+ * Function:    DCT32Output
  *
- * Description: Ken's highly-optimized 32-point DCT (radix-4 + radix-8) 
+ * Description: final stage of FDCT32, hardcoded shuffle into the polyphase filter input
  *
- * Inputs:      input buffer, length = 32 samples
- *              require at least 6 guard bits in input vector x to avoid possibility
- *                of overflow in internal calculations (see bbtest_imdct test app)
+ * Inputs:      32 DCT outputs after the second pass
  *              buffer offset and oddblock flag for polyphase filter input buffer
- *              number of guard bits in input
+ *              number of extra shifts applied to the DCT input (usually 0)
  *
  * Outputs:     output buffer, data copied and interleaved for polyphase filter
- *              no guarantees about number of guard bits in output
  *
  * Return:      none
- *
- * Notes:       number of muls = 4*8 + 12*4 = 80
- *              final stage of DCT is hardcoded to shuffle data into the proper order
- *                for the polyphase filterbank
- *              fully unrolled stage 1, for max precision (scale the 1/cos() factors
- *                differently, depending on magnitude)
- *              guard bit analysis verified by exhaustive testing of all 2^32 
- *                combinations of max pos/max neg values in x[]
- *
- * TODO:        code organization and optimization for ARM
- *              possibly interleave stereo (cut # of coef loads in half - may not have
- *                enough registers)
  **************************************************************************************/
-void FDCT32(int *buf, int *dest, int offset, int oddBlock, int gb)
+static __inline void DCT32Output(int *buf, int *dest, int offset, int oddBlock, int es)
 {
-    int i, s, tmp, es;
-    const int *cptr = dcttab;
-    int a0, a1, a2, a3, a4, a5, a6, a7;
-    int b0, b1, b2, b3, b4, b5, b6, b7;
+	int i, s, tmp;
 	int *d;
 
-	/* scaling - ensure at least 6 guard bits for DCT 
-	 * (in practice this is already true 99% of time, so this code is
-	 *  almost never triggered)
-	 */
-	es = 0;
-	if (gb < 6) {
-		es = 6 - gb;
-		for (i = 0; i < 32; i++)
-			buf[i] >>= es;
-	}
-
-	/* first pass */    
-	D32FP(0, 1, 5, 1);
-	D32FP(1, 1, 3, 1);
-	D32FP(2, 1, 3, 1);
-	D32FP(3, 1, 2, 1);
-	D32FP(4, 1, 2, 1);
-	D32FP(5, 1, 1, 2);
-	D32FP(6, 1, 1, 2);
-	D32FP(7, 1, 1, 4);
-
-	/* second pass */
-	for (i = 4; i > 0; i--) {
-		a0 = buf[0]; 	    a7 = buf[7];		a3 = buf[3];	    a4 = buf[4];
-		b0 = a0 + a7;	    b7 = MULSHIFT32(*cptr++, a0 - a7) << 1;
-		b3 = a3 + a4;	    b4 = MULSHIFT32(*cptr++, a3 - a4) << 3;
-		a0 = b0 + b3;	    a3 = MULSHIFT32(*cptr,   b0 - b3) << 1;
-		a4 = b4 + b7;		a7 = MULSHIFT32(*cptr++, b7 - b4) << 1;
-
-		a1 = buf[1];	    a6 = buf[6];	    a2 = buf[2];	    a5 = buf[5];
-		b1 = a1 + a6;	    b6 = MULSHIFT32(*cptr++, a1 - a6) << 1;
-		b2 = a2 + a5;	    b5 = MULSHIFT32(*cptr++, a2 - a5) << 1;
-		a1 = b1 + b2;		a2 = MULSHIFT32(*cptr,   b1 - b2) << 2;
-		a5 = b5 + b6;	    a6 = MULSHIFT32(*cptr++, b6 - b5) << 2;
-
-		b0 = a0 + a1;	    b1 = MULSHIFT32(COS4_0, a0 - a1) << 1;
-		b2 = a2 + a3;	    b3 = MULSHIFT32(COS4_0, a3 - a2) << 1;
-		buf[0] = b0;	    buf[1] = b1;
-		buf[2] = b2 + b3;	buf[3] = b3;
-
-		b4 = a4 + a5;	    b5 = MULSHIFT32(COS4_0, a4 - a5) << 1;
-		b6 = a6 + a7;	    b7 = MULSHIFT32(COS4_0, a7 - a6) << 1;
-		b6 += b7;
-		buf[4] = b4 + b6;	buf[5] = b5 + b7;
-		buf[6] = b5 + b6;	buf[7] = b7;
-
-		buf += 8;
-	}
-	buf -= 32;	/* reset */
-
 	/* sample 0 - always delayed one block */
 	d = dest + 64*16 + ((offset - oddBlock) & 7) + (oddBlock ? 0 : VBUF_LENGTH);
 	s = buf[ 0];				d[0] = d[8] = s;
@@ -277,3 +232,160 @@ void FDCT32(int *buf, int *dest, int offset, int oddBlock, int gb)
 	}
 }
 
+/**************************************************************************************
+ * Function:    FDCT32
+ *
+ * Description: Ken's highly-optimized 32-point DCT (radix-4 + radix-8) 
+ *
+ * Inputs:      input buffer, length = 32 samples
+ *              require at least 6 guard bits in input vector x to avoid possibility
+ *                of overflow in internal calculations (see bbtest_imdct test app)
+ *              buffer offset and oddblock flag for polyphase filter input buffer
+ *              number of guard bits in input
+ *
+ * Outputs:     output buffer, data copied and interleaved for polyphase filter
+ *              no guarantees about number of guard bits in output
+ *
+ * Return:      none
+ *
+ * Notes:       number of muls = 4*8 + 12*4 = 80
+ *              final stage of DCT is hardcoded to shuffle data into the proper order
+ *                for the polyphase filterbank
+ *              fully unrolled stage 1, for max precision (scale the 1/cos() factors
+ *                differently, depending on magnitude)
+ *              guard bit analysis verified by exhaustive testing of all 2^32 
+ *                combinations of max pos/max neg values in x[]
+ *
+ * TODO:        code organization and optimization for ARM
+ *              possibly interleave stereo (cut # of coef loads in half - may not have
+ *                enough registers)
+ **************************************************************************************/
+void FDCT32(int *buf, int *dest, int offset, int oddBlock, int gb)
+{
+    int i, es;
+    const int *cptr = dcttab;
+    int a0, a1, a2, a3, a4, a5, a6, a7;
+    int b0, b1, b2, b3, b4, b5, b6, b7;
+
+	/* scaling - ensure at least 6 guard bits for DCT 
+	 * (in practice this is already true 99% of time, so this code is
+	 *  almost never triggered)
+	 */
+	es = 0;
+	if (gb < 6) {
+		es = 6 - gb;
+		for (i = 0; i < 32; i++)
+			buf[i] >>= es;
+	}
+
+	/* first pass */    
+	D32FP(0, 1, 5, 1);
+	D32FP(1, 1, 3, 1);
+	D32FP(2, 1, 3, 1);
+	D32FP(3, 1, 2, 1);
+	D32FP(4, 1, 2, 1);
+	D32FP(5, 1, 1, 2);
+	D32FP(6, 1, 1, 2);
+	D32FP(7, 1, 1, 4);
+
+	/* second pass */
+	for (i = 4; i > 0; i--) {
+		a0 = buf[0]; 	    a7 = buf[7];		a3 = buf[3];	    a4 = buf[4];
+		b0 = a0 + a7;	    b7 = MULSHIFT32(*cptr++, a0 - a7) << 1;
+		b3 = a3 + a4;	    b4 = MULSHIFT32(*cptr++, a3 - a4) << 3;
+		a0 = b0 + b3;	    a3 = MULSHIFT32(*cptr,   b0 - b3) << 1;
+		a4 = b4 + b7;		a7 = MULSHIFT32(*cptr++, b7 - b4) << 1;
+
+		a1 = buf[1];	    a6 = buf[6];	    a2 = buf[2];	    a5 = buf[5];
+		b1 = a1 + a6;	    b6 = MULSHIFT32(*cptr++, a1 - a6) << 1;
+		b2 = a2 + a5;	    b5 = MULSHIFT32(*cptr++, a2 - a5) << 1;
+		a1 = b1 + b2;		a2 = MULSHIFT32(*cptr,   b1 - b2) << 2;
+		a5 = b5 + b6;	    a6 = MULSHIFT32(*cptr++, b6 - b5) << 2;
+
+		b0 = a0 + a1;	    b1 = MULSHIFT32(COS4_0, a0 - a1) << 1;
+		b2 = a2 + a3;	    b3 = MULSHIFT32(COS4_0, a3 - a2) << 1;
+		buf[0] = b0;	    buf[1] = b1;
+		buf[2] = b2 + b3;	buf[3] = b3;
+
+		b4 = a4 + a5;	    b5 = MULSHIFT32(COS4_0, a4 - a5) << 1;
+		b6 = a6 + a7;	    b7 = MULSHIFT32(COS4_0, a7 - a6) << 1;
+		b6 += b7;
+		buf[4] = b4 + b6;	buf[5] = b5 + b7;
+		buf[6] = b5 + b6;	buf[7] = b7;
+
+		buf += 8;
+	}
+	buf -= 32;	/* reset */
+
+	DCT32Output(buf, dest, offset, oddBlock, es);
+}
+
+
+/**************************************************************************************
+ * Function:    FDCT32Blocked
+ *
+ * Description: same as FDCT32, with each pass written as one loop over independent lanes
+ *
+ * Inputs:      see FDCT32
+ *
+ * Outputs:     output buffer, bit-identical to FDCT32
+ *
+ * Return:      none
+ *
+ * Notes:       first pass: 8 butterflies, per-lane coefficients and shifts (dctFP)
+ *              second pass: the 4 radix-8 groups, with the input kept transposed
+ *                (x[sample][group]) so every operation is a 4-lane vector operation
+ *              results go back to buf like in FDCT32, final shuffle shared with FDCT32
+ **************************************************************************************/
+void FDCT32Blocked(int *buf, int *dest, int offset, int oddBlock, int gb)
+{
+	int i, g, es;
+	int a0, a1, a2, a3, a4, a5, a6, a7;
+	int b0, b1, b2, b3, b4, b5, b6, b7;
+	int x[8][4];
+
+	es = 0;
+	if (gb < 6) {
+		es = 6 - gb;
+		for (i = 0; i < 32; i++)
+			buf[i] >>= es;
+	}
+
+	/* first pass, output i of group g goes to x[i][g] */
+	for (i = 0; i < 8; i++) {
+		a0 = buf[i];		a3 = buf[31-i];
+		a1 = buf[15-i];		a2 = buf[16+i];
+		b0 = a0 + a3;		b3 = MULSHIFT32(dctFP[0][i], a0 - a3) << 1;
+		b1 = a1 + a2;		b2 = MULSHIFT32(dctFP[1][i], a1 - a2) << dctFPShift[0][i];
+		x[i][0] = b0 + b1;	x[7-i][1] = MULSHIFT32(dctFP[2][i], b0 - b1) << dctFPShift[1][i];
+		x[i][2] = b2 + b3;	x[7-i][3] = MULSHIFT32(dctFP[2][i], b3 - b2) << dctFPShift[1][i];
+	}
+
+	/* second pass */
+	for (g = 0; g < 4; g++) {
+		a0 = x[0][g];		a7 = x[7][g];		a3 = x[3][g];		a4 = x[4][g];
+		b0 = a0 + a7;		b7 = MULSHIFT32(dctSP[0][g], a0 - a7) << 1;
+		b3 = a3 + a4;		b4 = MULSHIFT32(dctSP[1][g], a3 - a4) << 3;
+		a0 = b0 + b3;		a3 = MULSHIFT32(dctSP[2][g], b0 - b3) << 1;
+		a4 = b4 + b7;		a7 = MULSHIFT32(dctSP[2][g], b7 - b4) << 1;
+
+		a1 = x[1][g];		a6 = x[6][g];		a2 = x[2][g];		a5 = x[5][g];
+		b1 = a1 + a6;		b6 = MULSHIFT32(dctSP[3][g], a1 - a6) << 1;
+		b2 = a2 + a5;		b5 = MULSHIFT32(dctSP[4][g], a2 - a5) << 1;
+		a1 = b1 + b2;		a2 = MULSHIFT32(dctSP[5][g], b1 - b2) << 2;
+		a5 = b5 + b6;		a6 = MULSHIFT32(dctSP[5][g], b6 - b5) << 2;
+
+		b0 = a0 + a1;		b1 = MULSHIFT32(COS4_0, a0 - a1) << 1;
+		b2 = a2 + a3;		b3 = MULSHIFT32(COS4_0, a3 - a2) << 1;
+		buf[8*g+0] = b0;	buf[8*g+1] = b1;
+		buf[8*g+2] = b2 + b3;	buf[8*g+3] = b3;
+
+		b4 = a4 + a5;		b5 = MULSHIFT32(COS4_0, a4 - a5) << 1;
+		b6 = a6 + a7;		b7 = MULSHIFT32(COS4_0, a7 - a6) << 1;
+		b6 += b7;
+		buf[8*g+4] = b4 + b6;	buf[8*g+5] = b5 + b7;
+		buf[8*g+6] = b5 + b6;	buf[8*g+7] = b7;
+	}
+
+	DCT32Output(buf, dest, offset, oddBlock, es);
+}
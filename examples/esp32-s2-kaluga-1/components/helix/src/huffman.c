@@ -70,6 +70,7 @@
  *              number of codewords to decode
  *              index of Huffman table to use
  *              number of bits remaining in bitstream
+ *              wrap point of the main data ring (0 if buf is linear)
  *
  * Outputs:     pairs of decoded coefficients in vwxy
  *              updated BitStreamInfo struct
@@ -80,7 +81,7 @@
  *              si_huff.bit tests every Huffman codeword in every table (though not
  *                necessarily all linBits outputs for x,y > 15)
  **************************************************************************************/
-static int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset)
+static int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset, unsigned char *wrap)
 {
 	int i, x, y;
 	int cachedBits, padBits, len, startBits, linBits, maxBits, minBits;
@@ -108,7 +109,7 @@ static int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsi
 	cache = 0;
 	cachedBits = (8 - bitOffset) & 0x07;
 	if (cachedBits)
-		cache = (unsigned int)(*buf++) << (32 - cachedBits);
+		cache = (unsigned int)GetMainByte(buf, wrap) << (32 - cachedBits);
 	bitsLeft -= cachedBits;
 
 	if (tabType == noBits) {
@@ -127,15 +128,15 @@ static int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsi
 			/* refill cache - assumes cachedBits <= 16 */
 			if (bitsLeft >= 16) {
 				/* load 2 new bytes into left-justified cache */
-				cache |= (unsigned int)(*buf++) << (24 - cachedBits);
-				cache |= (unsigned int)(*buf++) << (16 - cachedBits);
+				cache |= (unsigned int)GetMainByte(buf, wrap) << (24 - cachedBits);
+				cache |= (unsigned int)GetMainByte(buf, wrap) << (16 - cachedBits);
 				cachedBits += 16;
 				bitsLeft -= 16;
 			} else {
 				/* last time through, pad cache with zeros and drain cache */
 				if (cachedBits + bitsLeft <= 0)	return -1;
-				if (bitsLeft > 0)	cache |= (unsigned int)(*buf++) << (24 - cachedBits);
-				if (bitsLeft > 8)	cache |= (unsigned int)(*buf++) << (16 - cachedBits);
+				if (bitsLeft > 0)	cache |= (unsigned int)GetMainByte(buf, wrap) << (24 - cachedBits);
+				if (bitsLeft > 8)	cache |= (unsigned int)GetMainByte(buf, wrap) << (16 - cachedBits);
 				cachedBits += bitsLeft;
 				bitsLeft = 0;
 
@@ -172,15 +173,15 @@ static int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsi
 			/* refill cache - assumes cachedBits <= 16 */
 			if (bitsLeft >= 16) {
 				/* load 2 new bytes into left-justified cache */
-				cache |= (unsigned int)(*buf++) << (24 - cachedBits);
-				cache |= (unsigned int)(*buf++) << (16 - cachedBits);
+				cache |= (unsigned int)GetMainByte(buf, wrap) << (24 - cachedBits);
+				cache |= (unsigned int)GetMainByte(buf, wrap) << (16 - cachedBits);
 				cachedBits += 16;
 				bitsLeft -= 16;
 			} else {
 				/* last time through, pad cache with zeros and drain cache */
 				if (cachedBits + bitsLeft <= 0)	return -1;
-				if (bitsLeft > 0)	cache |= (unsigned int)(*buf++) << (24 - cachedBits);
-				if (bitsLeft > 8)	cache |= (unsigned int)(*buf++) << (16 - cachedBits);
+				if (bitsLeft > 0)	cache |= (unsigned int)GetMainByte(buf, wrap) << (24 - cachedBits);
+				if (bitsLeft > 8)	cache |= (unsigned int)GetMainByte(buf, wrap) << (16 - cachedBits);
 				cachedBits += bitsLeft;
 				bitsLeft = 0;
 
@@ -211,7 +212,7 @@ static int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsi
 					if (cachedBits + bitsLeft < minBits)
 						return -1;
 					while (cachedBits < minBits) {
-						cache |= (unsigned int)(*buf++) << (24 - cachedBits);
+						cache |= (unsigned int)GetMainByte(buf, wrap) << (24 - cachedBits);
 						cachedBits += 8;
 						bitsLeft -= 8;
 					}
@@ -231,7 +232,7 @@ static int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsi
 					if (cachedBits + bitsLeft < minBits)
 						return -1;
 					while (cachedBits < minBits) {
-						cache |= (unsigned int)(*buf++) << (24 - cachedBits);
+						cache |= (unsigned int)GetMainByte(buf, wrap) << (24 - cachedBits);
 						cachedBits += 8;
 						bitsLeft -= 8;
 					}
@@ -274,6 +275,7 @@ static int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsi
  *              maximum number of codewords to decode
  *              index of quadword table (0 = table A, 1 = table B)
  *              number of bits remaining in bitstream
+ *              wrap point of the main data ring (0 if buf is linear)
  *
  * Outputs:     quadruples of decoded coefficients in vwxy
  *              updated BitStreamInfo struct
@@ -283,7 +285,7 @@ static int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsi
  * 
  * Notes:        si_huff.bit tests every vwxy output in both quad tables
  **************************************************************************************/
-static int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset)
+static int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset, unsigned char *wrap)
 {
 	int i, v, w, x, y;
 	int len, maxBits, cachedBits, padBits;
@@ -300,7 +302,7 @@ static int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, un
 	cache = 0;
 	cachedBits = (8 - bitOffset) & 0x07;
 	if (cachedBits)
-		cache = (unsigned int)(*buf++) << (32 - cachedBits);
+		cache = (unsigned int)GetMainByte(buf, wrap) << (32 - cachedBits);
 	bitsLeft -= cachedBits;
 
 	i = padBits = 0;
@@ -308,15 +310,15 @@ static int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, un
 		/* refill cache - assumes cachedBits <= 16 */
 		if (bitsLeft >= 16) {
 			/* load 2 new bytes into left-justified cache */
-			cache |= (unsigned int)(*buf++) << (24 - cachedBits);
-			cache |= (unsigned int)(*buf++) << (16 - cachedBits);
+			cache |= (unsigned int)GetMainByte(buf, wrap) << (24 - cachedBits);
+			cache |= (unsigned int)GetMainByte(buf, wrap) << (16 - cachedBits);
 			cachedBits += 16;
 			bitsLeft -= 16;
 		} else {
 			/* last time through, pad cache with zeros and drain cache */
 			if (cachedBits + bitsLeft <= 0) return i;
-			if (bitsLeft > 0)	cache |= (unsigned int)(*buf++) << (24 - cachedBits);
-			if (bitsLeft > 8)	cache |= (unsigned int)(*buf++) << (16 - cachedBits);
+			if (bitsLeft > 0)	cache |= (unsigned int)GetMainByte(buf, wrap) << (24 - cachedBits);
+			if (bitsLeft > 8)	cache |= (unsigned int)GetMainByte(buf, wrap) << (16 - cachedBits);
 			cachedBits += bitsLeft;
 			bitsLeft = 0;
 
@@ -378,8 +380,8 @@ static int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, un
 int DecodeHuffman(MP3DecInfo *mp3DecInfo, unsigned char *buf, int *bitOffset, int huffBlockBits, int gr, int ch)
 {
 	int r1Start, r2Start, rEnd[4];	/* region boundaries */
-	int i, w, bitsUsed, bitsLeft;
-	unsigned char *startBuf = buf;
+	int i, w, bitsUsed, bitsLeft, nBytes;
+	unsigned char *wrap;
 
 	FrameHeader *fh;
 	SideInfo *si;
@@ -399,6 +401,8 @@ int DecodeHuffman(MP3DecInfo *mp3DecInfo, unsigned char *buf, int *bitOffset, in
 
 	if (huffBlockBits < 0)
 		return -1;
+	wrap = mp3DecInfo->mainWrap;
+	nBytes = 0;
 
 	/* figure out region boundaries (the first 2*bigVals coefficients divided into 3 regions) */
 	if (sis->winSwitchFlag && sis->blockType == 2) {
@@ -431,18 +435,20 @@ int DecodeHuffman(MP3DecInfo *mp3DecInfo, unsigned char *buf, int *bitOffset, in
 	/* decode Huffman pairs (rEnd[i] are always even numbers) */
 	bitsLeft = huffBlockBits;
 	for (i = 0; i < 3; i++) {
-		bitsUsed = DecodeHuffmanPairs(hi->huffDecBuf[ch] + rEnd[i], rEnd[i+1] - rEnd[i], sis->tableSelect[i], bitsLeft, buf, *bitOffset);
+		bitsUsed = DecodeHuffmanPairs(hi->huffDecBuf[ch] + rEnd[i], rEnd[i+1] - rEnd[i], sis->tableSelect[i], bitsLeft, buf, *bitOffset, wrap);
 		if (bitsUsed < 0 || bitsUsed > bitsLeft)	/* error - overran end of bitstream */
 			return -1;
 
 		/* update bitstream position */
+		nBytes += (bitsUsed + *bitOffset) >> 3;
 		buf += (bitsUsed + *bitOffset) >> 3;
+		WrapMainPtr(buf, wrap);
 		*bitOffset = (bitsUsed + *bitOffset) & 0x07;
 		bitsLeft -= bitsUsed;
 	}
 
 	/* decode Huffman quads (if any) */
-	hi->nonZeroBound[ch] += DecodeHuffmanQuads(hi->huffDecBuf[ch] + rEnd[3], MAX_NSAMP - rEnd[3], sis->count1TableSelect, bitsLeft, buf, *bitOffset);
+	hi->nonZeroBound[ch] += DecodeHuffmanQuads(hi->huffDecBuf[ch] + rEnd[3], MAX_NSAMP - rEnd[3], sis->count1TableSelect, bitsLeft, buf, *bitOffset, wrap);
 
 	ASSERT(hi->nonZeroBound[ch] <= MAX_NSAMP);
 	for (i = hi->nonZeroBound[ch]; i < MAX_NSAMP; i++)
@@ -451,8 +457,8 @@ int DecodeHuffman(MP3DecInfo *mp3DecInfo, unsigned char *buf, int *bitOffset, in
 	/* If bits used for 576 samples < huffBlockBits, then the extras are considered
 	 *  to be stuffing bits (throw away, but need to return correct bitstream position) 
 	 */
-	buf += (bitsLeft + *bitOffset) >> 3;
+	nBytes += (bitsLeft + *bitOffset) >> 3;
 	*bitOffset = (bitsLeft + *bitOffset) & 0x07;
 	
-	return (buf - startBuf);
+	return nBytes;
 }
@@ -463,6 +463,231 @@ static int IMDCT36(int *xCurr, int *xPrev, int *y, int btCurr, int btPrev, int b
 	return mOut;
 }
 
+/**************************************************************************************
+ * Function:    IMDCTLong
+ *
+ * Description: 36-point IMDCT, windowing and overlap-add for all long blocks of a granule
+ *
+ * Inputs:      vector of input coefficients, length = bc->nBlocksLong * 18
+ *              vector of overlap samples from last time, length = bc->nBlocksLong * 9
+ *              output buffer (&y[0][0] of HybridTransform)
+ *              BlockCount struct (nBlocksLong, window switch points, prevType, gbIn)
+ *              window type of the current granule (long blocks of mixed blocks use 0
+ *                up to bc->currWinSwitch)
+ *
+ * Outputs:     bc->nBlocksLong blocks of 18 output samples, spaced NBANDS apart
+ *              updated overlap samples
+ *
+ * Return:      mOut (OR of abs(y) for all y calculated here)
+ *
+ * Notes:       reference kernel, one IMDCT36 per block
+ **************************************************************************************/
+int IMDCTLong(int *xCurr, int *xPrev, int *y, BlockCount *bc, int btCurr)
+{
+	int i, currWinIdx, prevWinIdx, mOut;
+
+	mOut = 0;
+	for (i = 0; i < bc->nBlocksLong; i++) {
+		currWinIdx = (i < bc->currWinSwitch ? 0 : btCurr);
+		prevWinIdx = (i < bc->prevWinSwitch ? 0 : bc->prevType);
+		mOut |= IMDCT36(xCurr, xPrev, y + i, currWinIdx, prevWinIdx, i, bc->gbIn);
+		xCurr += 18;
+		xPrev += 9;
+	}
+
+	return mOut;
+}
+
+#define IMDCT_LANES		8	/* long blocks transformed together by IMDCTLongBlocked */
+
+/* idct9 on IMDCT_LANES independent vectors, x[k][lane] (same arithmetic as idct9) */
+static __inline void idct9Lanes(int x[9][IMDCT_LANES], int n)
+{
+	int j;
+	int a1, a2, a3, a4, a5, a6, a7, a8, a9;
+	int a10, a11, a12, a13, a14, a15, a16, a17, a18;
+	int a19, a20, a21, a22, a23, a24, a25, a26, a27;
+	int m1, m3, m5, m6, m7, m8, m9, m10, m11, m12;
+	int x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+	for (j = 0; j < n; j++) {
+		x0 = x[0][j]; x1 = x[1][j]; x2 = x[2][j]; x3 = x[3][j]; x4 = x[4][j];
+		x5 = x[5][j]; x6 = x[6][j]; x7 = x[7][j]; x8 = x[8][j];
+
+		a1 = x0 - x6;
+		a2 = x1 - x5;
+		a3 = x1 + x5;
+		a4 = x2 - x4;
+		a5 = x2 + x4;
+		a6 = x2 + x8;
+		a7 = x1 + x7;
+
+		a8 = a6 - a5;
+		a9 = a3 - a7;
+		a10 = a2 - x7;
+		a11 = a4 - x8;
+
+		m1 =  MULSHIFT32(c9_0, x3);
+		m3 =  MULSHIFT32(c9_0, a10);
+		m5 =  MULSHIFT32(c9_1, a5);
+		m6 =  MULSHIFT32(c9_2, a6);
+		m7 =  MULSHIFT32(c9_1, a8);
+		m8 =  MULSHIFT32(c9_2, a5);
+		m9 =  MULSHIFT32(c9_3, a9);
+		m10 = MULSHIFT32(c9_4, a7);
+		m11 = MULSHIFT32(c9_3, a3);
+		m12 = MULSHIFT32(c9_4, a9);
+
+		a12 = x0   +  (x6 >> 1);
+		a13 = a12  +  (  m1 << 1);
+		a14 = a12  -  (  m1 << 1);
+		a15 = a1   +  ( a11 >> 1);
+		a16 = ( m5 << 1) + (m6 << 1);
+		a17 = ( m7 << 1) - (m8 << 1);
+		a18 = a16 + a17;
+		a19 = ( m9 << 1) + (m10 << 1);
+		a20 = (m11 << 1) - (m12 << 1);
+
+		a21 = a20 - a19;
+		a22 = a13 + a16;
+		a23 = a14 + a16;
+		a24 = a14 + a17;
+		a25 = a13 + a17;
+		a26 = a14 - a18;
+		a27 = a13 - a18;
+
+		x[0][j] = a22 + a19;
+		x[1][j] = a15 + (m3 << 1);
+		x[2][j] = a24 + a20;
+		x[3][j] = a26 - a21;
+		x[4][j] = a1 - a11;
+		x[5][j] = a27 + a21;
+		x[6][j] = a25 - a20;
+		x[7][j] = a15 - (m3 << 1);
+		x[8][j] = a23 - a19;
+	}
+}
+
+/**************************************************************************************
+ * Function:    IMDCTLongBlocked
+ *
+ * Description: same as IMDCTLong, transforming up to IMDCT_LANES blocks side by side
+ *
+ * Inputs:      see IMDCTLong
+ *
+ * Outputs:     see IMDCTLong, bit-identical
+ *
+ * Return:      mOut (OR of abs(y) for all y calculated here)
+ *
+ * Notes:       the data is kept transposed (xBuf[sample][block]), so the input
+ *                accumulation, both idct9's and the sine window (the common case, window
+ *                type 0 now and before) are loops over independent blocks, and the
+ *                windowed output rows are contiguous in y (y[sample][block])
+ *              which blocks need the full window is a prefix/suffix split, since the
+ *                window switch points apply to the first blocks of a granule
+ **************************************************************************************/
+int IMDCTLongBlocked(int *xCurr, int *xPrev, int *y, BlockCount *bc, int btCurr)
+{
+	int i, j, b0, n, nFast, es, mOut;
+	int acc1[IMDCT_LANES], acc2[IMDCT_LANES], xBuf[18][IMDCT_LANES], xPrevWin[18];
+	int c, xo, xe, s, d, t, yLo, yHi, btPrev, *xc, *xp;
+	const int *wp;
+
+	es = (bc->gbIn < 7 ? 7 - bc->gbIn : 0);
+	mOut = 0;
+
+	for (b0 = 0; b0 < bc->nBlocksLong; b0 += IMDCT_LANES) {
+		n = MIN(bc->nBlocksLong - b0, IMDCT_LANES);
+
+		/* blocks b0 ... b0+nFast-1 use window type 0 now and before (fast path of IMDCT36) */
+		nFast = n;
+		if (btCurr)
+			nFast = MIN(nFast, MAX(bc->currWinSwitch - b0, 0));
+		if (bc->prevType)
+			nFast = MIN(nFast, MAX(bc->prevWinSwitch - b0, 0));
+
+		/* accumulate, split into even and odd halves (max gain = 18) */
+		for (j = 0; j < n; j++)
+			acc1[j] = acc2[j] = 0;
+		for (i = 8; i >= 0; i--) {
+			for (j = 0; j < n; j++) {
+				xc = xCurr + 18*j;
+				acc1[j] = (xc[2*i+1] >> es) - acc1[j];
+				acc2[j] = acc1[j] - acc2[j];
+				acc1[j] = (xc[2*i+0] >> es) - acc1[j];
+				xBuf[i+9][j] = acc2[j];
+				xBuf[i+0][j] = acc1[j];
+			}
+		}
+		if (es) {
+			for (j = 0; j < n; j++) {
+				for (i = 0; i < 9; i++)
+					xPrev[9*j + i] >>= es;
+			}
+		}
+		for (j = 0; j < n; j++) {
+			xBuf[9][j] >>= 1;
+			xBuf[0][j] >>= 1;
+		}
+
+		idct9Lanes(xBuf + 0, n);
+		idct9Lanes(xBuf + 9, n);
+
+		/* window and overlap-add, fast path */
+		for (i = 0; i < 9; i++) {
+			c = c18[8-i];
+			for (j = 0; j < nFast; j++) {
+				xo = MULSHIFT32(c, xBuf[17-i][j]);
+				xe = xBuf[8-i][j] >> 2;
+
+				s = -xPrev[9*j + i];
+				d = -(xe - xo);
+				xPrev[9*j + i] = xe + xo;
+				t = s - d;
+
+				yLo = (d + (MULSHIFT32(t, fastWin36[2*i+0]) << 2));
+				yHi = (s + (MULSHIFT32(t, fastWin36[2*i+1]) << 2));
+				y[(i)*NBANDS + j]    = yLo;
+				y[(17-i)*NBANDS + j] = yHi;
+				mOut |= FASTABS(yLo);
+				mOut |= FASTABS(yHi);
+			}
+		}
+
+		/* full window for the rest */
+		for (j = nFast; j < n; j++) {
+			btPrev = (b0 + j < bc->prevWinSwitch ? 0 : bc->prevType);
+			xp = xPrev + 9*j;
+			WinPrevious(xp, xPrevWin, btPrev);
+
+			wp = imdctWin[b0 + j < bc->currWinSwitch ? 0 : btCurr];
+			for (i = 0; i < 9; i++) {
+				xo = MULSHIFT32(c18[8-i], xBuf[17-i][j]);
+				xe = xBuf[8-i][j] >> 2;
+
+				d = xe - xo;
+				xp[i] = xe + xo;
+
+				yLo = (xPrevWin[i]    + MULSHIFT32(d, wp[i])) << 2;
+				yHi = (xPrevWin[17-i] + MULSHIFT32(d, wp[17-i])) << 2;
+				y[(i)*NBANDS + j]    = yLo;
+				y[(17-i)*NBANDS + j] = yHi;
+				mOut |= FASTABS(yLo);
+				mOut |= FASTABS(yHi);
+			}
+		}
+
+		for (j = 0; j < n; j++)
+			mOut |= FreqInvertRescale(y + j, xPrev + 9*j, b0 + j, es);
+
+		xCurr += 18*n;
+		xPrev += 9*n;
+		y += n;
+	}
+
+	return mOut;
+}
+
 static const int c3_0 = 0x6ed9eba1;	/* format = Q31, cos(pi/6) */
 static const int c6[3] = { 0x7ba3751d, 0x5a82799a, 0x2120fb83 };	/* format = Q31, cos(((0:2) + 0.5) * (pi/6)) */
 
@@ -606,6 +831,7 @@ static int IMDCT12x3(int *xCurr, int *xPrev, int *y, int btPrev, int blockIdx, i
  *                number of long blocks in input vector (rest assumed to be short blocks)
  *                number of blocks which use long window (type) 0 in case of mixed block
  *                  (bc->currWinSwitch, 0 for non-mixed blocks)
+ *              DSP kernel set (long block IMDCT)
  *
  * Outputs:     transformed, windowed, and overlapped sample buffer
  *              does frequency inversion on odd blocks
@@ -616,9 +842,9 @@ static int IMDCT12x3(int *xCurr, int *xPrev, int *y, int btPrev, int blockIdx, i
  *
  * TODO:        examine mixedBlock/winSwitch logic carefully (test he_mode.bit)
  **************************************************************************************/
-static int HybridTransform(int *xCurr, int *xPrev, int y[BLOCK_SIZE][NBANDS], SideInfoSub *sis, BlockCount *bc)
+static int HybridTransform(int *xCurr, int *xPrev, int y[BLOCK_SIZE][NBANDS], SideInfoSub *sis, BlockCount *bc, const MP3Kernels *k)
 {
-	int xPrevWin[18], currWinIdx, prevWinIdx;
+	int xPrevWin[18], prevWinIdx;
 	int i, j, nBlocksOut, nonZero, mOut;
 	int fiBit, xp;
 
@@ -626,24 +852,13 @@ static int HybridTransform(int *xCurr, int *xPrev, int y[BLOCK_SIZE][NBANDS], Si
 	ASSERT(bc->nBlocksTotal <= NBANDS);
 	ASSERT(bc->nBlocksPrev  <= NBANDS);
 
-	mOut = 0;
-
-	/* do long blocks, if any */
-	for(i = 0; i < bc->nBlocksLong; i++) {
-		/* currWinIdx picks the right window for long blocks (if mixed, long blocks use window type 0) */
-		currWinIdx = sis->blockType;
-		if (sis->mixedBlock && i < bc->currWinSwitch) 
-			currWinIdx = 0;
-
-		prevWinIdx = bc->prevType;
-		if (i < bc->prevWinSwitch)
-			 prevWinIdx = 0;
-
-		/* do 36-point IMDCT, including windowing and overlap-add */
-		mOut |= IMDCT36(xCurr, xPrev, &(y[0][i]), currWinIdx, prevWinIdx, i, bc->gbIn);
-		xCurr += 18;
-		xPrev += 9;
-	}
+	/* do long blocks, if any: 36-point IMDCT, including windowing and overlap-add
+	 *   (if mixed, long blocks use window type 0 - currWinSwitch is only set for mixed blocks)
+	 */
+	mOut = k->imdctLong(xCurr, xPrev, &(y[0][0]), bc, sis->blockType);
+	i = bc->nBlocksLong;
+	xCurr += 18 * i;
+	xPrev += 9 * i;
 
 	/* do short blocks (if any) */
 	for (   ; i < bc->nBlocksTotal; i++) {
@@ -726,7 +941,7 @@ int IMDCT(MP3DecInfo *mp3DecInfo, int gr, int ch)
 
 	/* validate pointers */
 	if (!mp3DecInfo || !mp3DecInfo->FrameHeaderPS || !mp3DecInfo->SideInfoPS || 
-		!mp3DecInfo->HuffmanInfoPS || !mp3DecInfo->IMDCTInfoPS)
+		!mp3DecInfo->HuffmanInfoPS || !mp3DecInfo->IMDCTInfoPS || !mp3DecInfo->KernelsPS)
 		return -1;
 
 	/* si is an array of up to 4 structs, stored as gr0ch0, gr0ch1, gr1ch0, gr1ch1 */
@@ -768,7 +983,8 @@ int IMDCT(MP3DecInfo *mp3DecInfo, int gr, int ch)
 	bc.currWinSwitch = (si->sis[gr][ch].mixedBlock ? blockCutoff : 0);	/* where WINDOW switches (not nec. transform) */
 	bc.gbIn = hi->gb[ch];
 
-	mi->numPrevIMDCT[ch] = HybridTransform(hi->huffDecBuf[ch], mi->overBuf[ch], mi->outBuf[ch], &si->sis[gr][ch], &bc);
+	mi->numPrevIMDCT[ch] = HybridTransform(hi->huffDecBuf[ch], mi->overBuf[ch], mi->outBuf[ch], &si->sis[gr][ch], &bc,
+										   (const MP3Kernels *)mp3DecInfo->KernelsPS);
 	mi->prevType[ch] = si->sis[gr][ch].blockType;
 	mi->prevWinSwitch[ch] = bc.currWinSwitch;		/* 0 means not a mixed block (either all short or all long) */
 	mi->gb[ch] = bc.gbOut;
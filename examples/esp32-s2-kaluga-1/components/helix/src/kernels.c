@@ -0,0 +1,51 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**************************************************************************************
+ * kernels.c - selectable implementations of the DSP stages that dominate decode time
+ *
+ * MP3_KERNELS_REFERENCE is the original Helix C code, it processes one block (IMDCT)
+ *   or one output sample pair (polyphase) at a time with fully unrolled macros.
+ * MP3_KERNELS_BLOCKED does the same arithmetic in short fixed-length loops over
+ *   independent lanes: all long blocks of a granule at once for the IMDCT, all 8 taps of
+ *   a polyphase row, the 8 butterflies of a DCT pass. Compilers can vectorize these, and
+ *   they are the natural unit for a hand-written SIMD port of a stage.
+ *
+ * Only integer adds, shifts and 32x32 multiplies are used, in the same order per lane, so
+ *   every kernel set must decode bit-identical PCM (host_test/mp3_kernels_test checks this).
+ **************************************************************************************/
+
+#include "coder.h"
+
+const MP3Kernels mp3Kernels[MP3_NUM_KERNELS] = {
+	/* MP3_KERNELS_REFERENCE */
+	{ IMDCTLong,        FDCT32,        PolyphaseMono,        PolyphaseStereo },
+	/* MP3_KERNELS_BLOCKED */
+	{ IMDCTLongBlocked, FDCT32Blocked, PolyphaseMonoBlocked, PolyphaseStereoBlocked },
+};
+
+/**************************************************************************************
+ * Function:    SelectKernels
+ *
+ * Description: choose the DSP kernel set used by IMDCT and Subband
+ *
+ * Inputs:      valid MP3DecInfo struct
+ *              kernel set (MP3_KERNELS_xxx)
+ *
+ * Outputs:     updated KernelsPS
+ *
+ * Return:      0 on success, -1 if the kernel set doesn't exist
+ *
+ * Notes:       safe to call between any two frames, the kernels share all state
+ **************************************************************************************/
+int SelectKernels(MP3DecInfo *mp3DecInfo, int kernels)
+{
+	if (kernels < 0 || kernels >= MP3_NUM_KERNELS)
+		return -1;
+
+	mp3DecInfo->KernelsPS = &mp3Kernels[kernels];
+	return 0;
+}
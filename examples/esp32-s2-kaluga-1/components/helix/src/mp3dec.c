@@ -44,6 +44,7 @@
 
 #include "string.h"		/* for memmove, memcpy (can replace with different implementations if desired) */
 #include "mp3common.h"	/* includes mp3dec.h (public API) and internal, platform-independent API */
+#include "mp3profile.h"	/* per-stage cycle counters, no-ops unless HELIX_PROFILE is defined */
 //#include "hxthreadyield.h"
 
 /**************************************************************************************
@@ -68,6 +69,48 @@ HMP3Decoder MP3InitDecoder(void)
 	return (HMP3Decoder)mp3DecInfo;
 }
 
+/**************************************************************************************
+ * Function:    MP3GetDecoderArenaSize
+ *
+ * Description: size of the memory block MP3InitDecoderArena needs
+ *
+ * Inputs:      MP3_ARENA_xxx flags (MP3_ARENA_RESILIENT if MP3SetResilientMode will be
+ *                used on the decoder)
+ *
+ * Outputs:     none
+ *
+ * Return:      size in bytes
+ **************************************************************************************/
+int MP3GetDecoderArenaSize(int flags)
+{
+	return GetArenaSize(flags);
+}
+
+/**************************************************************************************
+ * Function:    MP3InitDecoderArena
+ *
+ * Description: set up a decoder entirely inside caller memory, without any malloc
+ *              clear all the user-accessible fields
+ *
+ * Inputs:      pointer to the memory block, aligned to MP3_ARENA_ALIGN bytes
+ *              size of the block in bytes, at least MP3GetDecoderArenaSize(flags)
+ *              MP3_ARENA_xxx flags
+ *
+ * Outputs:     none
+ *
+ * Return:      handle to mp3 decoder instance (same as the block address), 0 if the
+ *                block is too small or misaligned
+ *
+ * Notes:       the block may be reused for a new decoder at any time, MP3FreeDecoder
+ *                is optional and never frees it
+ *              without MP3_ARENA_RESILIENT, MP3SetResilientMode(1) fails with
+ *                ERR_MP3_OUT_OF_MEMORY
+ **************************************************************************************/
+HMP3Decoder MP3InitDecoderArena(void *arena, int arenaSize, int flags)
+{
+	return (HMP3Decoder)AllocateArenaBuffers(arena, arenaSize, flags);
+}
+
 /**************************************************************************************
  * Function:    MP3FreeDecoder
  *
@@ -236,58 +279,210 @@ int MP3GetNextFrameInfo(HMP3Decoder hMP3Decoder, MP3FrameInfo *mp3FrameInfo, uns
 }
 
 /**************************************************************************************
- * Function:    MP3ClearBadFrame
+ * Function:    ClearBadFrame
  *
- * Description: zero out pcm buffer if error decoding MP3 frame
+ * Description: zero out pcm buffer if error decoding MP3 frame, or conceal the
+ *                damaged granules in resilient mode
  *
  * Inputs:      mp3DecInfo struct with correct frame size parameters filled in
  *              pointer pcm output buffer
+ *              first damaged granule (0 if the whole frame is bad)
  *
- * Outputs:     zeroed out pcm buffer
+ * Outputs:     zeroed out or concealed pcm buffer
  *
  * Return:      none
  **************************************************************************************/
-static void MP3ClearBadFrame(MP3DecInfo *mp3DecInfo, short *outbuf)
+void ClearBadFrame(MP3DecInfo *mp3DecInfo, short *outbuf, int gr)
 {
 	int i;
 
 	if (!mp3DecInfo)
 		return;
 
+	if (mp3DecInfo->ConcealInfoPS) {
+		ConcealGranules(mp3DecInfo, outbuf, gr);
+		return;
+	}
+
 	for (i = 0; i < mp3DecInfo->nGrans * mp3DecInfo->nGranSamps * mp3DecInfo->nChans; i++)
 		outbuf[i] = 0;
 }
 
 /**************************************************************************************
- * Function:    MP3Decode
+ * Function:    UpdateErrorStats
  *
- * Description: decode one frame of MP3 data
+ * Description: count the result of decoding one frame
  *
- * Inputs:      valid MP3 decoder instance pointer (HMP3Decoder)
- *              double pointer to buffer of MP3 data (containing headers + mainData)
- *              number of valid bytes remaining in inbuf
+ * Inputs:      mp3DecInfo struct, error code returned for the frame
+ *
+ * Outputs:     updated errStats
+ *
+ * Return:      none
+ **************************************************************************************/
+void UpdateErrorStats(MP3DecInfo *mp3DecInfo, int err)
+{
+	if (err == ERR_MP3_NONE)
+		mp3DecInfo->errStats.nFrames++;
+	else if (err < 0 && -err < MP3_NUM_ERROR_CODES)
+		mp3DecInfo->errStats.errors[-err]++;
+}
+
+/**************************************************************************************
+ * Function:    FillMainBuf
+ *
+ * Description: append the main data of the current frame to the bit reservoir
+ *
+ * Inputs:      mp3DecInfo struct with side info for the current frame unpacked
+ *              main data of the current frame (nSlots bytes), given as up to two
+ *                segments so callers reading from a ring buffer don't have to
+ *                linearize it first (len1 = 0 if there is only one segment)
+ *
+ * Outputs:     updated mainBuf ring, mainWrite and mainDataBytes
+ *
+ * Return:      pointer to the first byte of main data for this frame (inside mainBuf,
+ *                reads must wrap at mainWrap), or 0 if the bit reservoir does not
+ *                hold mainDataBegin bytes yet (e.g. starting in middle of file)
+ *
+ * Notes:       the reservoir is never moved, the new bytes are copied once straight
+ *                into the ring behind it
+ **************************************************************************************/
+unsigned char *FillMainBuf(MP3DecInfo *mp3DecInfo, unsigned char *buf0, int len0, unsigned char *buf1, int len1)
+{
+	int i, n, haveReservoir;
+	unsigned char *seg[2];
+	int segLen[2];
+
+	haveReservoir = (mp3DecInfo->mainDataBytes >= mp3DecInfo->mainDataBegin);
+	seg[0] = buf0;	segLen[0] = len0;
+	seg[1] = buf1;	segLen[1] = len1;
+
+	for (i = 0; i < 2; i++) {
+		while (segLen[i] > 0) {
+			n = MAINBUF_RING_SIZE - mp3DecInfo->mainWrite;
+			if (n > segLen[i])
+				n = segLen[i];
+			memcpy(mp3DecInfo->mainBuf + mp3DecInfo->mainWrite, seg[i], n);
+			mp3DecInfo->mainWrite += n;
+			if (mp3DecInfo->mainWrite == MAINBUF_RING_SIZE)
+				mp3DecInfo->mainWrite = 0;
+			seg[i] += n;
+			segLen[i] -= n;
+		}
+	}
+	mp3DecInfo->mainWrap = mp3DecInfo->mainBuf + MAINBUF_RING_SIZE;
+
+	if (!haveReservoir) {
+		/* not enough data in bit reservoir from previous frames */
+		mp3DecInfo->mainDataBytes += len0 + len1;
+		if (mp3DecInfo->mainDataBytes > MAINBUF_RING_SIZE)
+			mp3DecInfo->mainDataBytes = MAINBUF_RING_SIZE;
+		return 0;
+	}
+
+	/* adequate "old" main data available (i.e. bit reservoir) */
+	mp3DecInfo->mainDataBytes = mp3DecInfo->mainDataBegin + len0 + len1;
+	i = mp3DecInfo->mainWrite - mp3DecInfo->mainDataBytes;
+	if (i < 0)
+		i += MAINBUF_RING_SIZE;
+
+	return mp3DecInfo->mainBuf + i;
+}
+
+/**************************************************************************************
+ * Function:    DecodeMainData
+ *
+ * Description: decode scale factors, Huffman codes and run the synthesis for all
+ *                granules and channels of one frame
+ *
+ * Inputs:      mp3DecInfo struct with frame header and side info unpacked
+ *              pointer to start of main data (returned by FillMainBuf, or a linear
+ *                self-contained frame if mainWrap = 0)
  *              pointer to outbuf, big enough to hold one frame of decoded PCM samples
- *              flag indicating whether MP3 data is normal MPEG format (useSize = 0)
- *                or reformatted as "self-contained" frames (useSize = 1)
  *
  * Outputs:     PCM data in outbuf, interleaved LRLRLR... if stereo
- *                number of output samples = nGrans * nGranSamps * nChans
- *              updated inbuf pointer, updated bytesLeft
  *
  * Return:      error code, defined in mp3dec.h (0 means no error, < 0 means error)
- *
- * Notes:       switching useSize on and off between frames in the same stream 
- *                is not supported (bit reservoir is not maintained if useSize on)
  **************************************************************************************/
-int MP3Decode(HMP3Decoder hMP3Decoder, unsigned char **inbuf, int *bytesLeft, short *outbuf, int useSize)
+int DecodeMainData(MP3DecInfo *mp3DecInfo, unsigned char *mainPtr, short *outbuf)
 {
-	int offset, bitOffset, mainBits, gr, ch, fhBytes, siBytes, freeFrameBytes;
+	int offset, bitOffset, mainBits, gr, ch;
 	int prevBitOffset, sfBlockBits, huffBlockBits;
+	unsigned char *wrap = mp3DecInfo->mainWrap;
+	MP3_PROFILE_BEGIN();
+
+	bitOffset = 0;
+	mainBits = mp3DecInfo->mainDataBytes * 8;
+
+	/* decode one complete frame */
+	for (gr = 0; gr < mp3DecInfo->nGrans; gr++) {
+		for (ch = 0; ch < mp3DecInfo->nChans; ch++) {
+			/* unpack scale factors and compute size of scale factor block */
+			prevBitOffset = bitOffset;
+			offset = UnpackScaleFactors(mp3DecInfo, mainPtr, &bitOffset, mainBits, gr, ch);
+
+			sfBlockBits = 8*offset - prevBitOffset + bitOffset;
+			huffBlockBits = mp3DecInfo->part23Length[gr][ch] - sfBlockBits;
+			mainPtr += offset;
+			WrapMainPtr(mainPtr, wrap);
+			mainBits -= sfBlockBits;
+
+			if (offset < 0 || mainBits < huffBlockBits) {
+				ClearBadFrame(mp3DecInfo, outbuf, gr);
+				return ERR_MP3_INVALID_SCALEFACT;
+			}
+			MP3_PROFILE_MARK(mp3DecInfo, MP3_STAGE_SCALEFACT);
+
+			/* decode Huffman code words */
+			prevBitOffset = bitOffset;
+			offset = DecodeHuffman(mp3DecInfo, mainPtr, &bitOffset, huffBlockBits, gr, ch);
+			if (offset < 0) {
+				ClearBadFrame(mp3DecInfo, outbuf, gr);
+				return ERR_MP3_INVALID_HUFFCODES;
+			}
+
+			mainPtr += offset;
+			WrapMainPtr(mainPtr, wrap);
+			mainBits -= (8*offset - prevBitOffset + bitOffset);
+			MP3_PROFILE_MARK(mp3DecInfo, MP3_STAGE_HUFFMAN);
+		}
+	
+		/* dequantize coefficients, decode stereo, reorder short blocks */
+		if (Dequantize(mp3DecInfo, gr) < 0) {
+			ClearBadFrame(mp3DecInfo, outbuf, gr);
+			return ERR_MP3_INVALID_DEQUANTIZE;			
+		}
+		SaveConcealGranule(mp3DecInfo, gr);
+		MP3_PROFILE_MARK(mp3DecInfo, MP3_STAGE_DEQUANT);
+
+		/* alias reduction, inverse MDCT, overlap-add, frequency inversion */
+		for (ch = 0; ch < mp3DecInfo->nChans; ch++)
+			if (IMDCT(mp3DecInfo, gr, ch) < 0) {
+				ClearBadFrame(mp3DecInfo, outbuf, gr);
+				return ERR_MP3_INVALID_IMDCT;			
+			}
+		MP3_PROFILE_MARK(mp3DecInfo, MP3_STAGE_IMDCT);
+
+		/* subband transform - if stereo, interleaves pcm LRLRLR */
+		if (Subband(mp3DecInfo, outbuf + gr*mp3DecInfo->nGranSamps*mp3DecInfo->nChans) < 0) {
+			ClearBadFrame(mp3DecInfo, outbuf, gr);
+			return ERR_MP3_INVALID_SUBBAND;			
+		}
+		MP3_PROFILE_MARK(mp3DecInfo, MP3_STAGE_SUBBAND);
+	}
+	MP3_PROFILE_FRAME_DONE(mp3DecInfo);
+	return ERR_MP3_NONE;
+}
+
+/**************************************************************************************
+ * Function:    DecodeFrame
+ *
+ * Description: decode one frame of MP3 data (see MP3Decode)
+ **************************************************************************************/
+static int DecodeFrame(MP3DecInfo *mp3DecInfo, unsigned char **inbuf, int *bytesLeft, short *outbuf, int useSize)
+{
+	int fhBytes, siBytes, freeFrameBytes;
 	unsigned char *mainPtr;
-	MP3DecInfo *mp3DecInfo = (MP3DecInfo *)hMP3Decoder;
-	 
-	if (!mp3DecInfo)
-		return ERR_MP3_NULL_POINTER;
+	MP3_PROFILE_BEGIN();
 
 	/* unpack frame header */
 	fhBytes = UnpackFrameHeader(mp3DecInfo, *inbuf);
@@ -298,7 +493,7 @@ int MP3Decode(HMP3Decoder hMP3Decoder, unsigned char **inbuf, int *bytesLeft, sh
 	/* unpack side info */
 	siBytes = UnpackSideInfo(mp3DecInfo, *inbuf);
 	if (siBytes < 0) {
-		MP3ClearBadFrame(mp3DecInfo, outbuf);
+		ClearBadFrame(mp3DecInfo, outbuf, 0);
 		return ERR_MP3_INVALID_SIDEINFO;
 	}
 	*inbuf += siBytes;
@@ -311,7 +506,7 @@ int MP3Decode(HMP3Decoder hMP3Decoder, unsigned char **inbuf, int *bytesLeft, sh
 			mp3DecInfo->freeBitrateFlag = 1;
 			mp3DecInfo->freeBitrateSlots = MP3FindFreeSync(*inbuf, *inbuf - fhBytes - siBytes, *bytesLeft);
 			if (mp3DecInfo->freeBitrateSlots < 0) {
-				MP3ClearBadFrame(mp3DecInfo, outbuf);
+				ClearBadFrame(mp3DecInfo, outbuf, 0);
 				return ERR_MP3_FREE_BITRATE_SYNC;
 			}
 			freeFrameBytes = mp3DecInfo->freeBitrateSlots + fhBytes + siBytes;
@@ -330,92 +525,238 @@ int MP3Decode(HMP3Decoder hMP3Decoder, unsigned char **inbuf, int *bytesLeft, sh
 		mp3DecInfo->nSlots = *bytesLeft;
 		if (mp3DecInfo->mainDataBegin != 0 || mp3DecInfo->nSlots <= 0) {
 			/* error - non self-contained frame, or missing frame (size <= 0), could do loss concealment here */
-			MP3ClearBadFrame(mp3DecInfo, outbuf);
+			ClearBadFrame(mp3DecInfo, outbuf, 0);
 			return ERR_MP3_INVALID_FRAMEHEADER;
 		}
 
 		/* can operate in-place on reformatted frames */
 		mp3DecInfo->mainDataBytes = mp3DecInfo->nSlots;
+		mp3DecInfo->mainWrap = 0;
 		mainPtr = *inbuf;
 		*inbuf += mp3DecInfo->nSlots;
 		*bytesLeft -= (mp3DecInfo->nSlots);
 	} else {
 		/* out of data - assume last or truncated frame */
 		if (mp3DecInfo->nSlots > *bytesLeft) {
-			MP3ClearBadFrame(mp3DecInfo, outbuf);
+			ClearBadFrame(mp3DecInfo, outbuf, 0);
 			return ERR_MP3_INDATA_UNDERFLOW;	
 		}
-		/* fill main data buffer with enough new data for this frame */
-		if (mp3DecInfo->mainDataBytes >= mp3DecInfo->mainDataBegin) {
-			/* adequate "old" main data available (i.e. bit reservoir) */
-			memmove(mp3DecInfo->mainBuf, mp3DecInfo->mainBuf + mp3DecInfo->mainDataBytes - mp3DecInfo->mainDataBegin, mp3DecInfo->mainDataBegin);
-			memcpy(mp3DecInfo->mainBuf + mp3DecInfo->mainDataBegin, *inbuf, mp3DecInfo->nSlots);
-
-			mp3DecInfo->mainDataBytes = mp3DecInfo->mainDataBegin + mp3DecInfo->nSlots;
+		/* reservoir plus this frame's main data must fit in the ring (only free format can violate this) */
+		if (mp3DecInfo->mainDataBegin + mp3DecInfo->nSlots > MAINBUF_SIZE) {
 			*inbuf += mp3DecInfo->nSlots;
 			*bytesLeft -= (mp3DecInfo->nSlots);
-			mainPtr = mp3DecInfo->mainBuf;
-		} else {
+			ClearBadFrame(mp3DecInfo, outbuf, 0);
+			return ERR_MP3_INVALID_FRAMEHEADER;
+		}
+		/* append main data behind the bit reservoir */
+		mainPtr = FillMainBuf(mp3DecInfo, *inbuf, mp3DecInfo->nSlots, 0, 0);
+		*inbuf += mp3DecInfo->nSlots;
+		*bytesLeft -= (mp3DecInfo->nSlots);
+		if (!mainPtr) {
 			/* not enough data in bit reservoir from previous frames (perhaps starting in middle of file) */
-			memcpy(mp3DecInfo->mainBuf + mp3DecInfo->mainDataBytes, *inbuf, mp3DecInfo->nSlots);
-			mp3DecInfo->mainDataBytes += mp3DecInfo->nSlots;
-			*inbuf += mp3DecInfo->nSlots;
-			*bytesLeft -= (mp3DecInfo->nSlots);
-			MP3ClearBadFrame(mp3DecInfo, outbuf);
+			ClearBadFrame(mp3DecInfo, outbuf, 0);
 			return ERR_MP3_MAINDATA_UNDERFLOW;
 		}
 	}
-	bitOffset = 0;
-	mainBits = mp3DecInfo->mainDataBytes * 8;
+	MP3_PROFILE_MARK(mp3DecInfo, MP3_STAGE_HEADER);
 
-	/* decode one complete frame */
-	for (gr = 0; gr < mp3DecInfo->nGrans; gr++) {
-		for (ch = 0; ch < mp3DecInfo->nChans; ch++) {
-			/* unpack scale factors and compute size of scale factor block */
-			prevBitOffset = bitOffset;
-			offset = UnpackScaleFactors(mp3DecInfo, mainPtr, &bitOffset, mainBits, gr, ch);
+	return DecodeMainData(mp3DecInfo, mainPtr, outbuf);
+}
 
-			sfBlockBits = 8*offset - prevBitOffset + bitOffset;
-			huffBlockBits = mp3DecInfo->part23Length[gr][ch] - sfBlockBits;
-			mainPtr += offset;
-			mainBits -= sfBlockBits;
+/**************************************************************************************
+ * Function:    MP3Decode
+ *
+ * Description: decode one frame of MP3 data
+ *
+ * Inputs:      valid MP3 decoder instance pointer (HMP3Decoder)
+ *              double pointer to buffer of MP3 data (containing headers + mainData)
+ *              number of valid bytes remaining in inbuf
+ *              pointer to outbuf, big enough to hold one frame of decoded PCM samples
+ *              flag indicating whether MP3 data is normal MPEG format (useSize = 0)
+ *                or reformatted as "self-contained" frames (useSize = 1)
+ *
+ * Outputs:     PCM data in outbuf, interleaved LRLRLR... if stereo
+ *                number of output samples = nGrans * nGranSamps * nChans
+ *              updated inbuf pointer, updated bytesLeft
+ *
+ * Return:      error code, defined in mp3dec.h (0 means no error, < 0 means error)
+ *
+ * Notes:       switching useSize on and off between frames in the same stream 
+ *                is not supported (bit reservoir is not maintained if useSize on)
+ *              in resilient mode outbuf holds concealed audio instead of silence when
+ *                a frame is damaged (any error except INVALID_FRAMEHEADER with an
+ *                unparseable header and INDATA_UNDERFLOW), the caller then just
+ *                skips to the next sync word and carries on
+ **************************************************************************************/
+int MP3Decode(HMP3Decoder hMP3Decoder, unsigned char **inbuf, int *bytesLeft, short *outbuf, int useSize)
+{
+	MP3DecInfo *mp3DecInfo = (MP3DecInfo *)hMP3Decoder;
+	int err;
 
-			if (offset < 0 || mainBits < huffBlockBits) {
-				MP3ClearBadFrame(mp3DecInfo, outbuf);
-				return ERR_MP3_INVALID_SCALEFACT;
-			}
+	if (!mp3DecInfo)
+		return ERR_MP3_NULL_POINTER;
 
-			/* decode Huffman code words */
-			prevBitOffset = bitOffset;
-			offset = DecodeHuffman(mp3DecInfo, mainPtr, &bitOffset, huffBlockBits, gr, ch);
-			if (offset < 0) {
-				MP3ClearBadFrame(mp3DecInfo, outbuf);
-				return ERR_MP3_INVALID_HUFFCODES;
-			}
+	err = DecodeFrame(mp3DecInfo, inbuf, bytesLeft, outbuf, useSize);
+	UpdateErrorStats(mp3DecInfo, err);
 
-			mainPtr += offset;
-			mainBits -= (8*offset - prevBitOffset + bitOffset);
-		}
-	
-		/* dequantize coefficients, decode stereo, reorder short blocks */
-		if (Dequantize(mp3DecInfo, gr) < 0) {
-			MP3ClearBadFrame(mp3DecInfo, outbuf);
-			return ERR_MP3_INVALID_DEQUANTIZE;			
-		}
+	return err;
+}
 
-		/* alias reduction, inverse MDCT, overlap-add, frequency inversion */
-		for (ch = 0; ch < mp3DecInfo->nChans; ch++)
-			if (IMDCT(mp3DecInfo, gr, ch) < 0) {
-				MP3ClearBadFrame(mp3DecInfo, outbuf);
-				return ERR_MP3_INVALID_IMDCT;			
-			}
+/**************************************************************************************
+ * Function:    MP3SetResilientMode
+ *
+ * Description: switch concealment of damaged frames on or off
+ *
+ * Inputs:      valid MP3 decoder instance pointer (HMP3Decoder)
+ *              1 to enable, 0 to disable
+ *
+ * Outputs:     none
+ *
+ * Return:      error code, defined in mp3dec.h (ERR_MP3_OUT_OF_MEMORY if the
+ *                concealment state (~5 KB) can't be allocated)
+ *
+ * Notes:       off by default, damaged frames then decode to silence as before
+ **************************************************************************************/
+int MP3SetResilientMode(HMP3Decoder hMP3Decoder, int enable)
+{
+	MP3DecInfo *mp3DecInfo = (MP3DecInfo *)hMP3Decoder;
 
-		/* subband transform - if stereo, interleaves pcm LRLRLR */
-		if (Subband(mp3DecInfo, outbuf + gr*mp3DecInfo->nGranSamps*mp3DecInfo->nChans) < 0) {
-			MP3ClearBadFrame(mp3DecInfo, outbuf);
-			return ERR_MP3_INVALID_SUBBAND;			
-		}
+	if (!mp3DecInfo)
+		return ERR_MP3_NULL_POINTER;
+
+	if (!enable) {
+		FreeConcealInfo(mp3DecInfo);
+		return ERR_MP3_NONE;
 	}
+
+	if (!mp3DecInfo->ConcealInfoPS && AllocateConcealInfo(mp3DecInfo) < 0)
+		return ERR_MP3_OUT_OF_MEMORY;
+
 	return ERR_MP3_NONE;
 }
 
+/**************************************************************************************
+ * Function:    MP3SetKernels
+ *
+ * Description: choose the implementation of the IMDCT, DCT and polyphase stages
+ *
+ * Inputs:      valid MP3 decoder instance pointer (HMP3Decoder)
+ *              kernel set (MP3_KERNELS_xxx)
+ *
+ * Outputs:     none
+ *
+ * Return:      error code, defined in mp3dec.h (ERR_UNKNOWN if the kernel set is not
+ *                known)
+ *
+ * Notes:       new decoders use HELIX_DEFAULT_KERNELS
+ *              all kernel sets decode bit-identical PCM, so this only changes speed and
+ *                may be called between any two frames
+ **************************************************************************************/
+int MP3SetKernels(HMP3Decoder hMP3Decoder, int kernels)
+{
+	MP3DecInfo *mp3DecInfo = (MP3DecInfo *)hMP3Decoder;
+
+	if (!mp3DecInfo)
+		return ERR_MP3_NULL_POINTER;
+
+	if (SelectKernels(mp3DecInfo, kernels) < 0)
+		return ERR_UNKNOWN;
+
+	return ERR_MP3_NONE;
+}
+
+/**************************************************************************************
+ * Function:    MP3GetErrorStats
+ *
+ * Description: get the per-error counters since the decoder was created (or since the
+ *                last call to MP3ResetErrorStats)
+ *
+ * Inputs:      valid MP3 decoder instance pointer (HMP3Decoder)
+ *              pointer to MP3ErrorStats struct
+ *
+ * Outputs:     filled-in MP3ErrorStats struct
+ *
+ * Return:      none
+ **************************************************************************************/
+void MP3GetErrorStats(HMP3Decoder hMP3Decoder, MP3ErrorStats *mp3ErrorStats)
+{
+	MP3DecInfo *mp3DecInfo = (MP3DecInfo *)hMP3Decoder;
+
+	if (!mp3ErrorStats)
+		return;
+
+	if (!mp3DecInfo) {
+		memset(mp3ErrorStats, 0, sizeof(MP3ErrorStats));
+		return;
+	}
+	*mp3ErrorStats = mp3DecInfo->errStats;
+}
+
+/**************************************************************************************
+ * Function:    MP3ResetErrorStats
+ *
+ * Description: clear the per-error counters
+ *
+ * Inputs:      valid MP3 decoder instance pointer (HMP3Decoder)
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ **************************************************************************************/
+void MP3ResetErrorStats(HMP3Decoder hMP3Decoder)
+{
+	MP3DecInfo *mp3DecInfo = (MP3DecInfo *)hMP3Decoder;
+
+	if (mp3DecInfo)
+		memset(&mp3DecInfo->errStats, 0, sizeof(MP3ErrorStats));
+}
+
+#ifdef HELIX_PROFILE
+/**************************************************************************************
+ * Function:    MP3GetProfileInfo
+ *
+ * Description: get cycles spent in each decode stage since the decoder was created
+ *                (or since the last call to MP3ResetProfileInfo)
+ *
+ * Inputs:      valid MP3 decoder instance pointer (HMP3Decoder)
+ *              pointer to MP3ProfileInfo struct
+ *
+ * Outputs:     filled-in MP3ProfileInfo struct
+ *
+ * Return:      none
+ *
+ * Notes:       only available when the decoder is built with -DHELIX_PROFILE
+ *              cycles of frames that fail part-way through are still charged to the
+ *                stages they reached, but such frames are not counted in nFrames
+ **************************************************************************************/
+void MP3GetProfileInfo(HMP3Decoder hMP3Decoder, MP3ProfileInfo *mp3ProfileInfo)
+{
+	MP3DecInfo *mp3DecInfo = (MP3DecInfo *)hMP3Decoder;
+
+	if (!mp3DecInfo) {
+		memset(mp3ProfileInfo, 0, sizeof(MP3ProfileInfo));
+		return;
+	}
+	*mp3ProfileInfo = mp3DecInfo->profile;
+}
+
+/**************************************************************************************
+ * Function:    MP3ResetProfileInfo
+ *
+ * Description: clear the per-stage cycle counters
+ *
+ * Inputs:      valid MP3 decoder instance pointer (HMP3Decoder)
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ **************************************************************************************/
+void MP3ResetProfileInfo(HMP3Decoder hMP3Decoder)
+{
+	MP3DecInfo *mp3DecInfo = (MP3DecInfo *)hMP3Decoder;
+
+	if (mp3DecInfo)
+		memset(&mp3DecInfo->profile, 0, sizeof(MP3ProfileInfo));
+}
+#endif
+
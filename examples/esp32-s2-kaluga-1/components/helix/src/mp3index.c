@@ -0,0 +1,858 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**************************************************************************************
+ * mp3index.c - header-only scan of an MP3 file into a table of frame offsets
+ *
+ * The scanner is a small state machine driven by MP3IndexFeed. Bytes that belong to an
+ *   item which straddles two chunks (ID3v2 header, frame header, VBR header) are gathered
+ *   in a scratch buffer, everything else is read in place. Headers are parsed with the
+ *   same tables as UnpackFrameHeader, so no decoder instance is needed.
+ *
+ * Like the stream decoder, a frame found after losing sync is only accepted once the
+ *   header following it matches.
+ **************************************************************************************/
+
+#include "string.h"
+#include "stdlib.h"
+#include "coder.h"
+#include "mp3index.h"
+
+#define ID3V2_HEADER_BYTES		10
+#define TAG_MAX_BYTES			512		/* enough for Xing + LAME tag and VBRI tables up to ~230 entries */
+#define TOC_ENTRIES				100
+#define MAX_FREE_FRAME_BYTES	2880	/* 640 kbps at 8 kHz, larger is not a frame */
+
+enum {
+	SCAN_ID3 = 0,
+	SCAN_SYNC,
+	SCAN_HEADER,
+	SCAN_FREE,
+	SCAN_TAG
+};
+
+typedef struct _IndexFrameHeader {
+	int version;
+	int srIdx;
+	int brIdx;
+	int nChans;
+	int sideBytes;
+	int hdrBytes;				/* 4, or 6 with CRC */
+	int padBit;
+} IndexFrameHeader;
+
+typedef struct _MP3IndexState {
+	unsigned int *points;		/* points[i] = offset of frame (i << stepShift) */
+	int maxPoints;
+	int nPoints;
+	int stepShift;
+	int nScanned;
+
+	/* scanner */
+	int state;
+	unsigned int scanPos;		/* start of the item being parsed */
+	unsigned int fedTo;			/* end of the data fed without gaps so far */
+	unsigned int fileBytes;
+	int complete;
+	int fill;					/* bytes of the item at scanPos held in pend */
+	unsigned char pend[TAG_MAX_BYTES];
+	IndexFrameHeader fh;
+	int curBytes;				/* size of the frame at scanPos */
+	unsigned int freePos;		/* search position for the next header of a free format frame */
+	int freeBytes;				/* free format frame size without pad byte, 0 if unknown */
+
+	int locked;
+	int pendValid;				/* candidate frame waiting for a matching next header */
+	unsigned int pendPos;
+	int pendSlots;
+	int pendBytes;
+	unsigned char pendHdr[4];
+	unsigned int lastEnd;		/* end of the last accepted frame */
+	int lastStored;				/* its offset is the last point */
+
+	/* stream parameters, from the first accepted frame */
+	int haveFirst;
+	unsigned char firstHdr[4];
+	unsigned int dataStart;
+	int samprate;
+	int nChans;
+	int version;
+	int samplesPerFrame;
+	int minSlots;
+	int maxMainDataBegin;
+
+	/* VBR header of frame 0 */
+	int vbrHeader;
+	int vbrFrames;
+	unsigned int vbrBytes;
+	int haveToc;
+	unsigned int toc[TOC_ENTRIES];	/* byte offset from dataStart at each percent of the duration */
+
+	/* LAME tag behind the Xing/Info header */
+	int haveGapless;
+	int encDelay;
+	int encPadding;
+} MP3IndexState;
+
+static unsigned int GetBE32(const unsigned char *p)
+{
+	return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | p[3];
+}
+
+static int GetBE16(const unsigned char *p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+/**************************************************************************************
+ * Function:    ParseIndexHeader
+ *
+ * Description: validate a layer 3 frame header and extract the fields the index needs
+ *
+ * Inputs:      4 header bytes
+ *
+ * Outputs:     filled IndexFrameHeader
+ *
+ * Return:      frame size in bytes (including pad byte), 0 for free format,
+ *                -1 if not a valid layer 3 header
+ **************************************************************************************/
+static int ParseIndexHeader(const unsigned char *buf, IndexFrameHeader *fh)
+{
+	int verIdx;
+
+	if (buf[0] != SYNCWORDH || (buf[1] & SYNCWORDL) != SYNCWORDL)
+		return -1;
+
+	verIdx = (buf[1] >> 3) & 0x03;
+	fh->version = (verIdx == 0 ? MPEG25 : ((verIdx & 0x01) ? MPEG1 : MPEG2));
+	fh->brIdx = (buf[2] >> 4) & 0x0f;
+	fh->srIdx = (buf[2] >> 2) & 0x03;
+	fh->padBit = (buf[2] >> 1) & 0x01;
+	fh->nChans = (((buf[3] >> 6) & 0x03) == Mono ? 1 : 2);
+	fh->hdrBytes = (buf[1] & 0x01) ? 4 : 6;
+
+	if (verIdx == 1 || ((buf[1] >> 1) & 0x03) != 1 || fh->srIdx == 3 || fh->brIdx == 15)
+		return -1;
+
+	fh->sideBytes = sideBytesTab[fh->version][fh->nChans == 1 ? 0 : 1];
+	if (fh->brIdx == 0)
+		return 0;
+
+	return slotTab[fh->version][fh->srIdx][fh->brIdx] + fh->padBit;
+}
+
+/**************************************************************************************
+ * Function:    ParseVBRHeader
+ *
+ * Description: look for a Xing/Info or VBRI header in the first frame
+ *
+ * Inputs:      index state, start of the frame, number of bytes of it available
+ *
+ * Outputs:     vbrHeader, vbrFrames, vbrBytes and the TOC in the index state, encoder
+ *                delay and padding if a LAME tag follows the Xing/Info header
+ *
+ * Return:      none
+ *
+ * Notes:       both TOC formats are converted to byte offsets from the start of the
+ *                frame at 0%, 1%, ... 99% of the duration
+ *              the LAME tag is also written by FFmpeg (Lavc/Lavf), delay and padding
+ *                are 12 bits each at byte 21 of the tag
+ **************************************************************************************/
+static void ParseVBRHeader(MP3IndexState *ix, const unsigned char *buf, int nBytes)
+{
+	const unsigned char *p;
+	unsigned int flags, sum, size;
+	int i, j, nEntries, scale, entrySize, framesPerEntry, entry, frame;
+
+	ix->vbrHeader = MP3INDEX_VBR_NONE;
+	ix->vbrFrames = 0;
+	ix->vbrBytes = 0;
+	ix->haveToc = 0;
+	ix->haveGapless = 0;
+	ix->encDelay = 0;
+	ix->encPadding = 0;
+
+	/* Xing/Info directly after the side info */
+	p = buf + 4 + ix->fh.sideBytes;
+	if (p + 8 <= buf + nBytes && (memcmp(p, "Xing", 4) == 0 || memcmp(p, "Info", 4) == 0)) {
+		ix->vbrHeader = MP3INDEX_VBR_XING;
+		flags = GetBE32(p + 4);
+		p += 8;
+		if ((flags & 0x01) && p + 4 <= buf + nBytes) {
+			ix->vbrFrames = (int)GetBE32(p);
+			p += 4;
+		}
+		if ((flags & 0x02) && p + 4 <= buf + nBytes) {
+			ix->vbrBytes = GetBE32(p);
+			p += 4;
+		}
+		if ((flags & 0x04) && p + TOC_ENTRIES <= buf + nBytes) {
+			if (ix->vbrBytes) {
+				for (i = 0; i < TOC_ENTRIES; i++)
+					ix->toc[i] = (unsigned int)(((unsigned long long)p[i] * ix->vbrBytes) >> 8);
+				ix->haveToc = 1;
+			}
+			p += TOC_ENTRIES;
+		}
+		if (flags & 0x08)
+			p += 4;		/* quality */
+		if (p + 24 <= buf + nBytes && (memcmp(p, "LAME", 4) == 0 || memcmp(p, "Lavc", 4) == 0 ||
+			memcmp(p, "Lavf", 4) == 0 || memcmp(p, "L3.99", 5) == 0)) {
+			ix->encDelay = (p[21] << 4) | (p[22] >> 4);
+			ix->encPadding = ((p[22] & 0x0f) << 8) | p[23];
+			ix->haveGapless = 1;
+		}
+		return;
+	}
+
+	/* VBRI at a fixed offset of 32 bytes after the header */
+	p = buf + 4 + 32;
+	if (p + 26 <= buf + nBytes && memcmp(p, "VBRI", 4) == 0) {
+		ix->vbrHeader = MP3INDEX_VBR_VBRI;
+		ix->vbrBytes = GetBE32(p + 10);
+		ix->vbrFrames = (int)GetBE32(p + 14);
+		nEntries = GetBE16(p + 18);
+		scale = GetBE16(p + 20);
+		entrySize = GetBE16(p + 22);
+		framesPerEntry = GetBE16(p + 24);
+		p += 26;
+		if (nEntries <= 0 || entrySize < 1 || entrySize > 4 || framesPerEntry <= 0 || ix->vbrFrames <= 0 ||
+			p + nEntries * entrySize > buf + nBytes)
+			return;
+
+		/* entries are byte counts of framesPerEntry frames each, counted from the VBRI frame */
+		sum = 0;
+		entry = 0;
+		for (i = 0; i < TOC_ENTRIES; i++) {
+			frame = (int)(((long long)i * ix->vbrFrames) / TOC_ENTRIES);
+			while (entry < nEntries && (entry + 1) * framesPerEntry <= frame) {
+				size = 0;
+				for (j = 0; j < entrySize; j++)
+					size = (size << 8) | p[entry * entrySize + j];
+				sum += size * scale;
+				entry++;
+			}
+			ix->toc[i] = sum;
+		}
+		ix->haveToc = 1;
+	}
+}
+
+/**************************************************************************************
+ * Function:    AddFrame
+ *
+ * Description: count one frame and store its offset if it starts a step
+ *
+ * Inputs:      index state, file offset and main data size of the frame
+ *
+ * Outputs:     updated offset table
+ *
+ * Return:      1 if the offset was stored, 0 if not
+ **************************************************************************************/
+static int AddFrame(MP3IndexState *ix, unsigned int pos, int slots)
+{
+	int i, stored = 0;
+
+	if ((ix->nScanned & ((1 << ix->stepShift) - 1)) == 0) {
+		if (ix->nPoints == ix->maxPoints) {
+			/* table full: keep every other point and double the step */
+			for (i = 0; i < ix->nPoints / 2; i++)
+				ix->points[i] = ix->points[2 * i];
+			ix->nPoints = (ix->nPoints + 1) / 2;
+			ix->stepShift++;
+		}
+		if ((ix->nScanned & ((1 << ix->stepShift) - 1)) == 0) {
+			ix->points[ix->nPoints++] = pos;
+			stored = 1;
+		}
+	}
+	ix->nScanned++;
+
+	if (slots < ix->minSlots)
+		ix->minSlots = slots;
+
+	return stored;
+}
+
+static void SetFirstFrame(MP3IndexState *ix)
+{
+	IndexFrameHeader fh;
+
+	ParseIndexHeader(ix->pendHdr, &fh);
+	memcpy(ix->firstHdr, ix->pendHdr, 4);
+	ix->haveFirst = 1;
+	ix->dataStart = ix->pendPos;
+	ix->samprate = samplerateTab[fh.version][fh.srIdx];
+	ix->nChans = fh.nChans;
+	ix->version = fh.version;
+	ix->samplesPerFrame = samplesPerFrameTab[fh.version][2];
+	ix->maxMainDataBegin = (fh.version == MPEG1 ? 511 : 255);
+}
+
+/**************************************************************************************
+ * Function:    AcceptFrame
+ *
+ * Description: record the frame at scanPos and move on to the next header
+ *
+ * Inputs:      index state with fh and curBytes describing the frame at scanPos
+ *
+ * Outputs:     updated index state
+ *
+ * Return:      none
+ **************************************************************************************/
+static void AcceptFrame(MP3IndexState *ix)
+{
+	int slots = ix->curBytes - ix->fh.hdrBytes - ix->fh.sideBytes;
+
+	if (!ix->locked && !ix->pendValid) {
+		ix->pendValid = 1;
+		ix->pendPos = ix->scanPos;
+		ix->pendSlots = slots;
+		ix->pendBytes = ix->curBytes;
+		memcpy(ix->pendHdr, ix->pend, 4);
+	} else {
+		if (ix->pendValid) {
+			/* this header confirms the pending frame */
+			if (!ix->haveFirst)
+				SetFirstFrame(ix);
+			AddFrame(ix, ix->pendPos, ix->pendSlots);
+			ix->pendValid = 0;
+			ix->locked = 1;
+		}
+		ix->lastStored = AddFrame(ix, ix->scanPos, slots);
+		ix->lastEnd = ix->scanPos + ix->curBytes;
+	}
+
+	ix->scanPos += ix->curBytes;
+	ix->fill = 0;
+	ix->state = SCAN_HEADER;
+}
+
+/**************************************************************************************
+ * Function:    LoseSync
+ *
+ * Description: drop the current candidate and search for a sync word again
+ *
+ * Inputs:      index state, file offset of the chunk being fed
+ *
+ * Outputs:     updated index state
+ *
+ * Return:      none
+ *
+ * Notes:       the search restarts one byte after the rejected candidate, but not
+ *                before the current chunk since earlier data is no longer available
+ **************************************************************************************/
+static void LoseSync(MP3IndexState *ix, unsigned int chunkStart)
+{
+	unsigned int pos;
+
+	if (ix->pendValid) {
+		pos = ix->pendPos + 1;
+		ix->pendValid = 0;
+		if (!ix->haveFirst)
+			ix->vbrHeader = MP3INDEX_VBR_NONE;
+	} else {
+		pos = ix->scanPos + 1;
+	}
+	if (pos < chunkStart)
+		pos = chunkStart;
+
+	ix->scanPos = pos;
+	ix->fill = 0;
+	ix->locked = 0;
+	ix->freeBytes = 0;
+	ix->state = SCAN_SYNC;
+}
+
+static int HeaderMatches(MP3IndexState *ix, const unsigned char *hdr)
+{
+	const unsigned char *ref;
+
+	if (ix->haveFirst)
+		ref = ix->firstHdr;
+	else if (ix->pendValid)
+		ref = ix->pendHdr;
+	else
+		return 1;
+
+	return hdr[1] == ref[1] && (hdr[2] & 0x0c) == (ref[2] & 0x0c) && ((hdr[2] & 0xf0) == 0) == ((ref[2] & 0xf0) == 0);
+}
+
+/* gather the bytes at scanPos into pend until want bytes are held, returns 1 when complete */
+static int Gather(MP3IndexState *ix, const unsigned char *buf, unsigned int chunkStart, unsigned int chunkEnd, int want)
+{
+	unsigned int pos = ix->scanPos + ix->fill;
+	int n;
+
+	if (ix->fill >= want)
+		return 1;
+	if (pos < chunkStart || pos >= chunkEnd)
+		return 0;
+
+	n = MIN(want - ix->fill, (int)(chunkEnd - pos));
+	memcpy(ix->pend + ix->fill, buf + (pos - chunkStart), n);
+	ix->fill += n;
+
+	return ix->fill >= want;
+}
+
+/**************************************************************************************
+ * Function:    HeaderDone
+ *
+ * Description: the size of the frame at scanPos is known, parse the VBR header of the
+ *                very first candidate or accept the frame
+ **************************************************************************************/
+static void HeaderDone(MP3IndexState *ix)
+{
+	if (!ix->haveFirst && !ix->pendValid && ix->fh.brIdx != 0)
+		ix->state = SCAN_TAG;
+	else
+		AcceptFrame(ix);
+}
+
+static void FinishScan(MP3IndexState *ix)
+{
+	/* a candidate at the very end has nothing left to be confirmed by */
+	if (ix->pendValid && ix->pendPos + ix->pendBytes <= ix->fileBytes) {
+		if (!ix->haveFirst)
+			SetFirstFrame(ix);
+		AddFrame(ix, ix->pendPos, ix->pendSlots);
+	}
+	ix->pendValid = 0;
+
+	/* a truncated last frame is not decoded, so it is not counted either */
+	if (ix->nScanned > 0 && ix->lastEnd > ix->fileBytes) {
+		ix->nScanned--;
+		if (ix->lastStored)
+			ix->nPoints--;
+	}
+	ix->complete = 1;
+}
+
+/* offset of the first byte the scanner has not seen yet */
+static unsigned int NeedPos(MP3IndexState *ix)
+{
+	return MAX(ix->fedTo, ix->scanPos + ix->fill);
+}
+
+/**************************************************************************************
+ * Function:    MP3InitIndex
+ *
+ * Description: allocate an empty frame index
+ *
+ * Inputs:      maximum number of offsets kept (0 for MP3INDEX_DEF_POINTS)
+ *
+ * Outputs:     none
+ *
+ * Return:      handle to index instance, 0 if malloc fails
+ **************************************************************************************/
+HMP3Index MP3InitIndex(int maxPoints)
+{
+	MP3IndexState *ix;
+
+	if (maxPoints <= 0)
+		maxPoints = MP3INDEX_DEF_POINTS;
+	if (maxPoints < 2)
+		maxPoints = 2;
+
+	ix = (MP3IndexState *)malloc(sizeof(MP3IndexState));
+	if (!ix)
+		return 0;
+	memset(ix, 0, sizeof(MP3IndexState));
+
+	ix->points = (unsigned int *)malloc(maxPoints * sizeof(unsigned int));
+	if (!ix->points) {
+		free(ix);
+		return 0;
+	}
+	ix->maxPoints = maxPoints;
+	ix->minSlots = MAINBUF_SIZE;
+	ix->state = SCAN_ID3;
+
+	return (HMP3Index)ix;
+}
+
+/**************************************************************************************
+ * Function:    MP3FreeIndex
+ *
+ * Description: free an index allocated by MP3InitIndex
+ *
+ * Inputs:      index handle (may be 0)
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ **************************************************************************************/
+void MP3FreeIndex(HMP3Index hMP3Index)
+{
+	MP3IndexState *ix = (MP3IndexState *)hMP3Index;
+
+	if (!ix)
+		return;
+
+	free(ix->points);
+	free(ix);
+}
+
+/**************************************************************************************
+ * Function:    MP3IndexReset
+ *
+ * Description: empty the index for the next file, keeping its offset table
+ *
+ * Inputs:      index handle
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ *
+ * Notes:       same state as a fresh MP3InitIndex with the same maxPoints, without
+ *                any malloc
+ **************************************************************************************/
+void MP3IndexReset(HMP3Index hMP3Index)
+{
+	MP3IndexState *ix = (MP3IndexState *)hMP3Index;
+	unsigned int *points;
+	int maxPoints;
+
+	if (!ix)
+		return;
+
+	points = ix->points;
+	maxPoints = ix->maxPoints;
+	memset(ix, 0, sizeof(MP3IndexState));
+	ix->points = points;
+	ix->maxPoints = maxPoints;
+	ix->minSlots = MAINBUF_SIZE;
+	ix->state = SCAN_ID3;
+}
+
+/**************************************************************************************
+ * Function:    MP3IndexSetFileSize
+ *
+ * Description: tell the index where the file ends
+ *
+ * Inputs:      index handle, file size in bytes
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ *
+ * Notes:       the scan is marked complete once it has been fed up to this offset,
+ *                without a file size the duration of files without a VBR header is
+ *                only known from a complete scan
+ **************************************************************************************/
+void MP3IndexSetFileSize(HMP3Index hMP3Index, unsigned int fileBytes)
+{
+	MP3IndexState *ix = (MP3IndexState *)hMP3Index;
+
+	if (!ix)
+		return;
+
+	ix->fileBytes = fileBytes;
+	if (!ix->complete && ix->fedTo >= fileBytes && fileBytes > 0)
+		FinishScan(ix);
+}
+
+/**************************************************************************************
+ * Function:    MP3IndexFeed
+ *
+ * Description: scan a chunk of the file
+ *
+ * Inputs:      index handle
+ *              chunk of file data and its size
+ *              file offset of the first byte of the chunk
+ *
+ * Outputs:     updated index
+ *
+ * Return:      file offset the scanner needs next
+ *
+ * Notes:       chunks may be fed in any size, chunks that end before the returned
+ *                offset are ignored and a chunk that starts after it is ignored too
+ *                (the data in between is needed first), so it is safe to feed every
+ *                read made for the decoder, including reads after a seek
+ **************************************************************************************/
+unsigned int MP3IndexFeed(HMP3Index hMP3Index, const unsigned char *buf, int nBytes, unsigned int fileOffset)
+{
+	MP3IndexState *ix = (MP3IndexState *)hMP3Index;
+	unsigned int end, pos;
+	const unsigned char *p;
+	int found, size;
+
+	if (!ix)
+		return 0;
+	end = fileOffset + nBytes;
+	if (!buf || nBytes <= 0 || ix->complete || end <= ix->fedTo || fileOffset > NeedPos(ix))
+		return NeedPos(ix);
+
+	for (;;) {
+		switch (ix->state) {
+		case SCAN_ID3:
+			if (!Gather(ix, buf, fileOffset, end, ID3V2_HEADER_BYTES))
+				goto done;
+			ix->fill = 0;
+			ix->state = SCAN_SYNC;
+			if (memcmp(ix->pend, "ID3", 3) == 0) {
+				size = ((ix->pend[6] & 0x7f) << 21) | ((ix->pend[7] & 0x7f) << 14) |
+					((ix->pend[8] & 0x7f) << 7) | (ix->pend[9] & 0x7f);
+				ix->scanPos += size + ID3V2_HEADER_BYTES * ((ix->pend[5] & 0x10) ? 2 : 1);
+			}
+			break;
+
+		case SCAN_SYNC:
+			if (ix->scanPos < fileOffset)
+				ix->scanPos = fileOffset;	/* only after an ID3v2 tag ending in a skipped chunk */
+			if (ix->scanPos >= end)
+				goto done;
+			found = MP3FindSyncWord((unsigned char *)buf + (ix->scanPos - fileOffset), (int)(end - ix->scanPos));
+			if (found < 0) {
+				if (buf[nBytes - 1] == SYNCWORDH) {
+					ix->scanPos = end - 1;	/* might be the first half of a sync word */
+					ix->state = SCAN_HEADER;
+				} else {
+					ix->scanPos = end;
+				}
+				goto done;
+			}
+			ix->scanPos += found;
+			ix->state = SCAN_HEADER;
+			break;
+
+		case SCAN_HEADER:
+			if (!Gather(ix, buf, fileOffset, end, 4))
+				goto done;
+			ix->curBytes = ParseIndexHeader(ix->pend, &ix->fh);
+			if (ix->curBytes < 0 || !HeaderMatches(ix, ix->pend)) {
+				LoseSync(ix, fileOffset);
+				break;
+			}
+			if (ix->curBytes == 0) {
+				if (ix->freeBytes == 0) {
+					ix->freePos = ix->scanPos + ix->fh.hdrBytes + ix->fh.sideBytes;
+					ix->state = SCAN_FREE;
+					break;
+				}
+				ix->curBytes = ix->freeBytes + ix->fh.padBit;
+			}
+			HeaderDone(ix);
+			break;
+
+		case SCAN_FREE:
+			/* free format, frame size is the distance to the next matching header */
+			pos = MAX(ix->freePos, fileOffset);
+			if (pos >= end)
+				goto done;
+			found = MP3FindSyncWord((unsigned char *)buf + (pos - fileOffset), (int)(end - pos));
+			if (found < 0) {
+				ix->freePos = end;
+				goto done;
+			}
+			pos += found;
+			if (pos - ix->scanPos > MAX_FREE_FRAME_BYTES) {
+				LoseSync(ix, fileOffset);
+				break;
+			}
+			ix->freePos = pos + 1;
+			if (pos + 3 > end)
+				break;				/* header split across chunks, keep searching */
+			p = buf + (pos - fileOffset);
+			if (p[0] == ix->pend[0] && p[1] == ix->pend[1] && (p[2] & 0xfc) == (ix->pend[2] & 0xfc)) {
+				ix->freeBytes = (int)(pos - ix->scanPos) - ix->fh.padBit;
+				ix->curBytes = (int)(pos - ix->scanPos);
+				HeaderDone(ix);
+			}
+			break;
+
+		case SCAN_TAG:
+			size = MIN(ix->curBytes, TAG_MAX_BYTES);
+			if (!Gather(ix, buf, fileOffset, end, size))
+				goto done;
+			ParseVBRHeader(ix, ix->pend, size);
+			AcceptFrame(ix);
+			break;
+		}
+	}
+
+done:
+	ix->fedTo = end;
+	if (ix->fileBytes && ix->fedTo >= ix->fileBytes)
+		FinishScan(ix);
+
+	return NeedPos(ix);
+}
+
+static int TotalFrames(MP3IndexState *ix, int *exact)
+{
+	int avgBytes;
+
+	*exact = 1;
+	if (ix->complete)
+		return ix->nScanned;
+	if (ix->vbrHeader != MP3INDEX_VBR_NONE && ix->vbrFrames > 0)
+		return ix->vbrFrames + 1;
+
+	/* extrapolate from what has been scanned */
+	*exact = 0;
+	if (!ix->fileBytes || ix->nScanned == 0 || ix->scanPos <= ix->dataStart)
+		return ix->nScanned;
+	avgBytes = (int)((ix->scanPos - ix->dataStart) / ix->nScanned);
+	if (avgBytes <= 0)
+		return ix->nScanned;
+
+	return (int)((ix->fileBytes - ix->dataStart) / avgBytes);
+}
+
+/**************************************************************************************
+ * Function:    MP3GetIndexInfo
+ *
+ * Description: get stream parameters, duration and progress of the scan
+ *
+ * Inputs:      index handle
+ *
+ * Outputs:     filled MP3IndexInfo struct (all zero until the first frame is found)
+ *
+ * Return:      none
+ **************************************************************************************/
+void MP3GetIndexInfo(HMP3Index hMP3Index, MP3IndexInfo *mp3IndexInfo)
+{
+	MP3IndexState *ix = (MP3IndexState *)hMP3Index;
+	int total, exact;
+
+	if (!mp3IndexInfo)
+		return;
+	memset(mp3IndexInfo, 0, sizeof(MP3IndexInfo));
+	if (!ix)
+		return;
+
+	mp3IndexInfo->complete = ix->complete;
+	mp3IndexInfo->nIndexed = ix->nScanned;
+	mp3IndexInfo->stepFrames = 1 << ix->stepShift;
+	mp3IndexInfo->scanPos = NeedPos(ix);
+	if (!ix->haveFirst)
+		return;
+
+	mp3IndexInfo->samprate = ix->samprate;
+	mp3IndexInfo->nChans = ix->nChans;
+	mp3IndexInfo->version = ix->version;
+	mp3IndexInfo->samplesPerFrame = ix->samplesPerFrame;
+	mp3IndexInfo->vbrHeader = ix->vbrHeader;
+	mp3IndexInfo->firstAudioFrame = (ix->vbrHeader != MP3INDEX_VBR_NONE ? 1 : 0);
+	mp3IndexInfo->dataStart = ix->dataStart;
+
+	total = TotalFrames(ix, &exact);
+	mp3IndexInfo->nFrames = MAX(total - mp3IndexInfo->firstAudioFrame, 0);
+	mp3IndexInfo->durationMs = (int)(((long long)mp3IndexInfo->nFrames * ix->samplesPerFrame * 1000) / ix->samprate);
+	mp3IndexInfo->exact = exact;
+
+	if (ix->haveGapless) {
+		mp3IndexInfo->gapless = 1;
+		mp3IndexInfo->encDelay = ix->encDelay;
+		mp3IndexInfo->encPadding = ix->encPadding;
+		mp3IndexInfo->startSkip = mp3IndexInfo->firstAudioFrame * ix->samplesPerFrame + ix->encDelay + MP3_DECODER_DELAY;
+		mp3IndexInfo->nSamples = MAX(mp3IndexInfo->nFrames * ix->samplesPerFrame - ix->encDelay - ix->encPadding, 0);
+	}
+}
+
+/**************************************************************************************
+ * Function:    MP3IndexFrameToMs
+ *
+ * Description: convert a frame number (counted from frame 0 of the file) to play time
+ *
+ * Inputs:      index handle, frame number
+ *
+ * Outputs:     none
+ *
+ * Return:      start time of the frame in ms, 0 if the stream parameters are not known yet
+ **************************************************************************************/
+int MP3IndexFrameToMs(HMP3Index hMP3Index, int frame)
+{
+	MP3IndexState *ix = (MP3IndexState *)hMP3Index;
+
+	if (!ix || !ix->haveFirst)
+		return 0;
+
+	frame -= (ix->vbrHeader != MP3INDEX_VBR_NONE ? 1 : 0);
+	if (frame < 0)
+		frame = 0;
+
+	return (int)(((long long)frame * ix->samplesPerFrame * 1000) / ix->samprate);
+}
+
+/**************************************************************************************
+ * Function:    MP3IndexSeek
+ *
+ * Description: find where to continue reading to play from a given time
+ *
+ * Inputs:      index handle, time in ms from the start of the audio
+ *
+ * Outputs:     filled MP3SeekInfo struct
+ *
+ * Return:      0 on success, -1 if no frame has been found yet
+ *
+ * Notes:       the returned position lies primeFrames frames before the target, enough
+ *                to refill the largest possible bit reservoir (main_data_begin) and the
+ *                overlap state of the synthesis filters, so the target frame decodes
+ *                exactly as in a continuous decode. The lookup is O(1), at most
+ *                stepFrames - 1 extra frames are primed because of the index step.
+ *              if the target lies beyond the scanned part of the file the position is
+ *                estimated from the VBR header TOC or the average frame size and
+ *                exact is 0 - scan further from MP3IndexInfo.scanPos and seek again
+ *                to get an exact position
+ **************************************************************************************/
+int MP3IndexSeek(HMP3Index hMP3Index, int timeMs, MP3SeekInfo *mp3SeekInfo)
+{
+	MP3IndexState *ix = (MP3IndexState *)hMP3Index;
+	int first, total, exact, target, prime, start, pct, avgBytes;
+	unsigned int off0, off1;
+	long long t;
+
+	if (!ix || !mp3SeekInfo || !ix->haveFirst)
+		return -1;
+
+	first = (ix->vbrHeader != MP3INDEX_VBR_NONE ? 1 : 0);
+	target = first + (int)(((long long)MAX(timeMs, 0) * ix->samprate) / (1000LL * ix->samplesPerFrame));
+	total = TotalFrames(ix, &exact);
+	if (exact && target >= total)
+		target = MAX(total - 1, first);
+
+	/* frames whose main data can hold a full reservoir, plus one for the overlap */
+	prime = 1 + (ix->maxMainDataBegin + ix->minSlots - 1) / MAX(ix->minSlots, 1);
+	start = MAX(target - prime, 0);
+
+	mp3SeekInfo->targetFrame = target;
+	if (start < ix->nScanned) {
+		mp3SeekInfo->frame = start & ~((1 << ix->stepShift) - 1);
+		mp3SeekInfo->offset = ix->points[start >> ix->stepShift];
+		mp3SeekInfo->primeFrames = target - mp3SeekInfo->frame;
+		mp3SeekInfo->exact = 1;
+		return 0;
+	}
+
+	/* not scanned yet, estimate */
+	mp3SeekInfo->frame = start;
+	mp3SeekInfo->primeFrames = target - start;
+	mp3SeekInfo->exact = 0;
+	if (ix->haveToc && total > first) {
+		t = ((long long)(start - first) * TOC_ENTRIES * 256) / (total - first);
+		pct = (int)(t >> 8);
+		if (pct >= TOC_ENTRIES - 1) {
+			mp3SeekInfo->offset = ix->dataStart + ix->toc[TOC_ENTRIES - 1];
+		} else {
+			off0 = ix->toc[MAX(pct, 0)];
+			off1 = ix->toc[MAX(pct, 0) + 1];
+			mp3SeekInfo->offset = ix->dataStart + off0 + (unsigned int)(((long long)(off1 - off0) * (t & 0xff)) >> 8);
+		}
+	} else {
+		if (ix->nScanned > 0 && ix->scanPos > ix->dataStart)
+			avgBytes = (int)((ix->scanPos - ix->dataStart) / ix->nScanned);
+		else
+			avgBytes = ix->minSlots;
+		mp3SeekInfo->offset = ix->dataStart + (unsigned int)start * avgBytes;
+	}
+	if (mp3SeekInfo->offset < ix->scanPos)
+		mp3SeekInfo->offset = ix->scanPos;
+
+	return 0;
+}
@@ -0,0 +1,850 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**************************************************************************************
+ * mp3stream.c - ring buffer input, ID3v2 skipping and resync on top of the decoder
+ *
+ * The input ring is read with free-running positions (readPos, writePos) masked by
+ *   ringMask, so bytes are never moved once written. Per frame only the header and
+ *   side info (at most 38 bytes) are gathered into a small scratch buffer, the main
+ *   data is appended to the decoder's bit reservoir straight from the ring (in two
+ *   pieces if it wraps).
+ **************************************************************************************/
+
+#include "string.h"
+#include "stdlib.h"
+#include "coder.h"
+#include "mp3stream.h"
+#include "mp3profile.h"
+
+#define ID3V2_HEADER_BYTES		10
+#define FRAME_HDR_MAX_BYTES		(6 + SIBYTES_MPEG1_STEREO)	/* header + CRC + largest side info */
+#define MAX_LOST_FRAMES			8		/* longer gaps are not filled in */
+
+typedef struct _MP3StreamInfo {
+	MP3DecInfo *mp3DecInfo;
+
+	unsigned char *ring;
+	int inArena;				/* stream, decoder and ring live in caller memory */
+	int ringSize;				/* power of 2 */
+	unsigned int ringMask;
+	unsigned int readPos;		/* free-running, masked by ringMask on access */
+	unsigned int writePos;
+
+	MP3StreamReadFunc readFunc;
+	void *readArg;
+	int eof;
+
+	int id3Checked;				/* start of stream has been checked for an ID3v2 tag */
+	int skipBytes;				/* bytes of ID3v2 tag still to be dropped */
+	int locked;					/* last frame was followed by a valid header */
+	int primeFrames;			/* frames still to be decoded without output after a seek */
+
+	int resilient;				/* conceal damaged and lost frames instead of skipping them */
+	int started;				/* a frame has been decoded since the start or the last flush */
+	int skipped;				/* bytes dropped since the last frame */
+	int lostFrames;				/* concealed frames still to be output for a gap in the input */
+
+	unsigned char hdr[FRAME_HDR_MAX_BYTES];
+} MP3StreamInfo;
+
+/**************************************************************************************
+ * Function:    RingCopy
+ *
+ * Description: copy bytes out of the input ring, handling wrap-around
+ *
+ * Inputs:      stream, free-running ring position, destination, number of bytes
+ *
+ * Outputs:     nBytes copied to dst
+ *
+ * Return:      none
+ **************************************************************************************/
+static void RingCopy(MP3StreamInfo *s, unsigned int pos, unsigned char *dst, int nBytes)
+{
+	int idx = pos & s->ringMask;
+	int n = s->ringSize - idx;
+
+	if (n > nBytes)
+		n = nBytes;
+	memcpy(dst, s->ring + idx, n);
+	memcpy(dst + n, s->ring, nBytes - n);
+}
+
+/**************************************************************************************
+ * Function:    RingFindSync
+ *
+ * Description: wrap-aware version of MP3FindSyncWord
+ *
+ * Inputs:      stream, free-running ring position to start at, number of bytes to search
+ *
+ * Outputs:     none
+ *
+ * Return:      offset of first sync word from pos, -1 if not found
+ **************************************************************************************/
+static int RingFindSync(MP3StreamInfo *s, unsigned int pos, int nBytes)
+{
+	int idx, seg, offset, found;
+
+	offset = 0;
+	while (nBytes - offset >= 2) {
+		idx = (pos + offset) & s->ringMask;
+		seg = s->ringSize - idx;
+		if (seg > nBytes - offset)
+			seg = nBytes - offset;
+
+		if (seg >= 2) {
+			found = MP3FindSyncWord(s->ring + idx, seg);
+			if (found >= 0)
+				return offset + found;
+			offset += seg - 1;		/* last byte may start a sync word that wraps */
+		} else {
+			if (s->ring[idx] == SYNCWORDH && (s->ring[0] & SYNCWORDL) == SYNCWORDL)
+				return offset;
+			offset++;
+		}
+	}
+
+	return -1;
+}
+
+/**************************************************************************************
+ * Function:    RingFindFreeSync
+ *
+ * Description: wrap-aware version of MP3FindFreeSync
+ *
+ * Inputs:      stream, free-running ring position of the first byte after side info,
+ *                number of bytes available from there, header of the current frame
+ *
+ * Outputs:     none
+ *
+ * Return:      nSlots of the free format frame (not counting the pad byte), -1 if
+ *                the next matching header is not in the buffered data
+ **************************************************************************************/
+static int RingFindFreeSync(MP3StreamInfo *s, unsigned int pos, int nBytes, unsigned char *firstFH)
+{
+	int offset, found;
+	unsigned char fh[3];
+
+	offset = 0;
+	while (nBytes - offset >= 3) {
+		found = RingFindSync(s, pos + offset, nBytes - offset);
+		if (found < 0 || nBytes - offset - found < 3)
+			return -1;
+		offset += found;
+		RingCopy(s, pos + offset, fh, 3);
+		if (fh[0] == firstFH[0] && fh[1] == firstFH[1] && (fh[2] & 0xfc) == (firstFH[2] & 0xfc))
+			return offset - ((firstFH[2] >> 1) & 0x01);
+		offset++;
+	}
+
+	return -1;
+}
+
+static void RingDrop(MP3StreamInfo *s, int nBytes)
+{
+	s->readPos += nBytes;
+}
+
+/* drop bytes that are not part of a frame while searching for sync */
+static void RingSkip(MP3StreamInfo *s, int nBytes)
+{
+	s->readPos += nBytes;
+	s->skipped += nBytes;
+	s->mp3DecInfo->errStats.nSkippedBytes += nBytes;
+}
+
+/* ring size actually used for a requested size */
+static int RingSizeFor(int ringSize)
+{
+	int size;
+
+	if (ringSize <= 0)
+		ringSize = MP3STREAM_DEF_RING_SIZE;
+	for (size = MP3STREAM_MIN_RING_SIZE; size < ringSize; size <<= 1)
+		;
+
+	return size;
+}
+
+#define STREAM_INFO_SIZE	(((int)sizeof(MP3StreamInfo) + MP3_ARENA_ALIGN - 1) & ~(MP3_ARENA_ALIGN - 1))
+
+/**************************************************************************************
+ * Function:    MP3InitStream
+ *
+ * Description: allocate a decoder and an input ring
+ *
+ * Inputs:      size of the input ring in bytes (rounded up to a power of 2, at least
+ *                MP3STREAM_MIN_RING_SIZE), 0 for MP3STREAM_DEF_RING_SIZE
+ *
+ * Outputs:     none
+ *
+ * Return:      handle to stream instance, 0 if malloc fails
+ **************************************************************************************/
+HMP3Stream MP3InitStream(int ringSize)
+{
+	MP3StreamInfo *s;
+	int size = RingSizeFor(ringSize);
+
+	s = (MP3StreamInfo *)malloc(sizeof(MP3StreamInfo));
+	if (!s)
+		return 0;
+	memset(s, 0, sizeof(MP3StreamInfo));
+
+	s->ring = (unsigned char *)malloc(size);
+	s->mp3DecInfo = (MP3DecInfo *)MP3InitDecoder();
+	if (!s->ring || !s->mp3DecInfo) {
+		MP3FreeStream(s);
+		return 0;
+	}
+	s->ringSize = size;
+	s->ringMask = size - 1;
+
+	return (HMP3Stream)s;
+}
+
+/**************************************************************************************
+ * Function:    MP3GetStreamArenaSize
+ *
+ * Description: size of the memory block MP3InitStreamArena needs
+ *
+ * Inputs:      size of the input ring as for MP3InitStream
+ *              MP3_ARENA_xxx flags for the decoder
+ *
+ * Outputs:     none
+ *
+ * Return:      size in bytes
+ **************************************************************************************/
+int MP3GetStreamArenaSize(int ringSize, int flags)
+{
+	return STREAM_INFO_SIZE + MP3GetDecoderArenaSize(flags) + RingSizeFor(ringSize);
+}
+
+/**************************************************************************************
+ * Function:    MP3InitStreamArena
+ *
+ * Description: set up a stream, its decoder and its input ring inside caller memory,
+ *                without any malloc
+ *
+ * Inputs:      pointer to the memory block, aligned to MP3_ARENA_ALIGN bytes
+ *              size of the block in bytes, at least MP3GetStreamArenaSize(ringSize, flags)
+ *              size of the input ring as for MP3InitStream
+ *              MP3_ARENA_xxx flags for the decoder
+ *
+ * Outputs:     none
+ *
+ * Return:      handle to stream instance, 0 if the block is too small or misaligned
+ *
+ * Notes:       layout is stream state, decoder (MP3InitDecoderArena), ring
+ *              MP3FreeStream is optional and never frees the block, use MP3StreamReset
+ *                to start the next track in the same block
+ **************************************************************************************/
+HMP3Stream MP3InitStreamArena(void *arena, int arenaSize, int ringSize, int flags)
+{
+	MP3StreamInfo *s = (MP3StreamInfo *)arena;
+	int size = RingSizeFor(ringSize);
+	int decSize = MP3GetDecoderArenaSize(flags);
+
+	if (!s || ((unsigned long)s & (MP3_ARENA_ALIGN - 1)) || arenaSize < MP3GetStreamArenaSize(ringSize, flags))
+		return 0;
+
+	memset(s, 0, sizeof(MP3StreamInfo));
+	s->mp3DecInfo = (MP3DecInfo *)MP3InitDecoderArena((unsigned char *)arena + STREAM_INFO_SIZE, decSize, flags);
+	if (!s->mp3DecInfo)
+		return 0;
+	s->ring = (unsigned char *)arena + STREAM_INFO_SIZE + decSize;
+	s->ringSize = size;
+	s->ringMask = size - 1;
+	s->inArena = 1;
+
+	return (HMP3Stream)s;
+}
+
+/**************************************************************************************
+ * Function:    MP3FreeStream
+ *
+ * Description: free the decoder and input ring allocated by MP3InitStream
+ *
+ * Inputs:      stream handle (may be 0)
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ *
+ * Notes:       does nothing for a stream in caller memory (MP3InitStreamArena)
+ **************************************************************************************/
+void MP3FreeStream(HMP3Stream hMP3Stream)
+{
+	MP3StreamInfo *s = (MP3StreamInfo *)hMP3Stream;
+
+	if (!s || s->inArena)
+		return;
+
+	MP3FreeDecoder(s->mp3DecInfo);
+	if (s->ring)
+		free(s->ring);
+	free(s);
+}
+
+/**************************************************************************************
+ * Function:    MP3StreamReset
+ *
+ * Description: drop all buffered input and return the decoder to its initial state,
+ *                e.g. before playing the next track with the same stream
+ *
+ * Inputs:      stream handle
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ *
+ * Notes:       the read callback is kept, the next stream is checked for an ID3v2 tag
+ **************************************************************************************/
+void MP3StreamReset(HMP3Stream hMP3Stream)
+{
+	MP3StreamInfo *s = (MP3StreamInfo *)hMP3Stream;
+	MP3DecInfo *mp3DecInfo;
+
+	if (!s)
+		return;
+
+	s->readPos = s->writePos = 0;
+	s->eof = 0;
+	s->id3Checked = 0;
+	s->skipBytes = 0;
+	s->locked = 0;
+	s->primeFrames = 0;
+	s->started = 0;
+	s->skipped = 0;
+	s->lostFrames = 0;
+
+	/* same state as a freshly allocated decoder (see AllocateBuffers) */
+	mp3DecInfo = s->mp3DecInfo;
+	memset(mp3DecInfo->FrameHeaderPS, 0, sizeof(FrameHeader));
+	memset(mp3DecInfo->SideInfoPS, 0, sizeof(SideInfo));
+	memset(mp3DecInfo->ScaleFactorInfoPS, 0, sizeof(ScaleFactorInfo));
+	memset(mp3DecInfo->HuffmanInfoPS, 0, sizeof(HuffmanInfo));
+	memset(mp3DecInfo->DequantInfoPS, 0, sizeof(DequantInfo));
+	memset(mp3DecInfo->IMDCTInfoPS, 0, sizeof(IMDCTInfo));
+	memset(mp3DecInfo->SubbandInfoPS, 0, sizeof(SubbandInfo));
+	mp3DecInfo->freeBitrateFlag = 0;
+	mp3DecInfo->freeBitrateSlots = 0;
+	mp3DecInfo->bitrate = 0;
+	mp3DecInfo->mainDataBegin = 0;
+	mp3DecInfo->mainDataBytes = 0;
+	mp3DecInfo->mainWrite = 0;
+	if (mp3DecInfo->ConcealInfoPS)
+		((ConcealInfo *)mp3DecInfo->ConcealInfoPS)->valid = 0;
+}
+
+/**************************************************************************************
+ * Function:    MP3StreamFlush
+ *
+ * Description: drop all buffered input and the bit reservoir after the caller has moved
+ *                the input to another position of the same stream (seek)
+ *
+ * Inputs:      stream handle
+ *              number of frames to decode and drop before output resumes (0 for none)
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ *
+ * Notes:       the frames before the seek target refill the bit reservoir and the
+ *                IMDCT/polyphase overlap, priming them makes the target frame decode
+ *                exactly as in a continuous decode (see MP3IndexSeek)
+ *              no ID3v2 tag is expected at the new position, free format frame size
+ *                and the read callback are kept
+ **************************************************************************************/
+void MP3StreamFlush(HMP3Stream hMP3Stream, int primeFrames)
+{
+	MP3StreamInfo *s = (MP3StreamInfo *)hMP3Stream;
+	MP3DecInfo *mp3DecInfo;
+
+	if (!s)
+		return;
+
+	s->readPos = s->writePos = 0;
+	s->eof = 0;
+	s->id3Checked = 1;
+	s->skipBytes = 0;
+	s->locked = 0;
+	s->primeFrames = MAX(primeFrames, 0);
+	s->started = 0;
+	s->skipped = 0;
+	s->lostFrames = 0;
+
+	/* clear the overlap like a fresh decoder, so a seek to frame 0 also matches */
+	mp3DecInfo = s->mp3DecInfo;
+	memset(mp3DecInfo->IMDCTInfoPS, 0, sizeof(IMDCTInfo));
+	memset(mp3DecInfo->SubbandInfoPS, 0, sizeof(SubbandInfo));
+	mp3DecInfo->mainDataBegin = 0;
+	mp3DecInfo->mainDataBytes = 0;
+	if (mp3DecInfo->ConcealInfoPS)
+		((ConcealInfo *)mp3DecInfo->ConcealInfoPS)->valid = 0;
+}
+
+/**************************************************************************************
+ * Function:    MP3StreamSetResilientMode
+ *
+ * Description: switch concealment of damaged and lost frames on or off
+ *
+ * Inputs:      stream handle, 1 to enable, 0 to disable
+ *
+ * Outputs:     none
+ *
+ * Return:      error code, defined in mp3dec.h (see MP3SetResilientMode)
+ **************************************************************************************/
+int MP3StreamSetResilientMode(HMP3Stream hMP3Stream, int enable)
+{
+	MP3StreamInfo *s = (MP3StreamInfo *)hMP3Stream;
+	int err;
+
+	if (!s)
+		return ERR_MP3_NULL_POINTER;
+
+	err = MP3SetResilientMode(s->mp3DecInfo, enable);
+	s->resilient = (err == ERR_MP3_NONE && enable);
+	s->lostFrames = 0;
+
+	return err;
+}
+
+/**************************************************************************************
+ * Function:    MP3StreamSetKernels
+ *
+ * Description: choose the DSP kernel set of the stream's decoder (see MP3SetKernels)
+ *
+ * Inputs:      stream handle, kernel set (MP3_KERNELS_xxx)
+ *
+ * Outputs:     none
+ *
+ * Return:      error code, defined in mp3dec.h
+ **************************************************************************************/
+int MP3StreamSetKernels(HMP3Stream hMP3Stream, int kernels)
+{
+	MP3StreamInfo *s = (MP3StreamInfo *)hMP3Stream;
+
+	if (!s)
+		return ERR_MP3_NULL_POINTER;
+
+	return MP3SetKernels(s->mp3DecInfo, kernels);
+}
+
+/**************************************************************************************
+ * Function:    MP3StreamGetErrorStats
+ *
+ * Description: get the per-error counters of the stream (see MP3GetErrorStats)
+ *
+ * Inputs:      stream handle, pointer to MP3ErrorStats struct
+ *
+ * Outputs:     filled-in MP3ErrorStats struct
+ *
+ * Return:      none
+ *
+ * Notes:       the counters are kept across MP3StreamReset and MP3StreamFlush, clear
+ *                them with MP3StreamResetErrorStats
+ **************************************************************************************/
+void MP3StreamGetErrorStats(HMP3Stream hMP3Stream, MP3ErrorStats *mp3ErrorStats)
+{
+	MP3StreamInfo *s = (MP3StreamInfo *)hMP3Stream;
+
+	MP3GetErrorStats(s ? s->mp3DecInfo : 0, mp3ErrorStats);
+}
+
+void MP3StreamResetErrorStats(HMP3Stream hMP3Stream)
+{
+	MP3StreamInfo *s = (MP3StreamInfo *)hMP3Stream;
+
+	if (s)
+		MP3ResetErrorStats(s->mp3DecInfo);
+}
+
+/**************************************************************************************
+ * Function:    MP3StreamSetReader
+ *
+ * Description: switch the stream to pull mode
+ *
+ * Inputs:      stream handle
+ *              callback used by MP3StreamDecode to fill the ring when it runs dry
+ *              argument passed to the callback
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ **************************************************************************************/
+void MP3StreamSetReader(HMP3Stream hMP3Stream, MP3StreamReadFunc readFunc, void *readArg)
+{
+	MP3StreamInfo *s = (MP3StreamInfo *)hMP3Stream;
+
+	if (!s)
+		return;
+
+	s->readFunc = readFunc;
+	s->readArg = readArg;
+}
+
+/**************************************************************************************
+ * Function:    MP3StreamGetWriteBuffer
+ *
+ * Description: get the contiguous free space at the write position of the ring, so
+ *                callers can read input (fread, DMA, socket) directly into it
+ *
+ * Inputs:      stream handle
+ *              pointer to receive the write position
+ *
+ * Outputs:     *buf points into the ring
+ *
+ * Return:      number of bytes that may be written at *buf (0 if the ring is full),
+ *                commit them with MP3StreamCommitWrite
+ **************************************************************************************/
+int MP3StreamGetWriteBuffer(HMP3Stream hMP3Stream, unsigned char **buf)
+{
+	MP3StreamInfo *s = (MP3StreamInfo *)hMP3Stream;
+	int idx, n;
+
+	if (!s || !buf)
+		return 0;
+
+	idx = s->writePos & s->ringMask;
+	n = s->ringSize - (int)(s->writePos - s->readPos);
+	if (n > s->ringSize - idx)
+		n = s->ringSize - idx;
+	*buf = s->ring + idx;
+
+	return n;
+}
+
+/**************************************************************************************
+ * Function:    MP3StreamCommitWrite
+ *
+ * Description: make bytes written through MP3StreamGetWriteBuffer visible to the decoder
+ *
+ * Inputs:      stream handle, number of bytes written
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ **************************************************************************************/
+void MP3StreamCommitWrite(HMP3Stream hMP3Stream, int nBytes)
+{
+	MP3StreamInfo *s = (MP3StreamInfo *)hMP3Stream;
+
+	if (!s || nBytes <= 0)
+		return;
+
+	s->writePos += nBytes;
+}
+
+/**************************************************************************************
+ * Function:    MP3StreamWrite
+ *
+ * Description: copy input data into the ring
+ *
+ * Inputs:      stream handle, input data, number of bytes
+ *
+ * Outputs:     none
+ *
+ * Return:      number of bytes accepted (less than nBytes if the ring is full)
+ **************************************************************************************/
+int MP3StreamWrite(HMP3Stream hMP3Stream, const unsigned char *buf, int nBytes)
+{
+	unsigned char *dst;
+	int n, written = 0;
+
+	while (written < nBytes) {
+		n = MP3StreamGetWriteBuffer(hMP3Stream, &dst);
+		if (n <= 0)
+			break;
+		if (n > nBytes - written)
+			n = nBytes - written;
+		memcpy(dst, buf + written, n);
+		MP3StreamCommitWrite(hMP3Stream, n);
+		written += n;
+	}
+
+	return written;
+}
+
+/**************************************************************************************
+ * Function:    MP3StreamSetEOF
+ *
+ * Description: signal that no more input will be written (push mode)
+ *
+ * Inputs:      stream handle
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ **************************************************************************************/
+void MP3StreamSetEOF(HMP3Stream hMP3Stream)
+{
+	MP3StreamInfo *s = (MP3StreamInfo *)hMP3Stream;
+
+	if (s)
+		s->eof = 1;
+}
+
+/**************************************************************************************
+ * Function:    MP3StreamBytesBuffered
+ *
+ * Description: get the number of input bytes not yet consumed by the decoder
+ *
+ * Inputs:      stream handle
+ *
+ * Outputs:     none
+ *
+ * Return:      number of bytes in the ring
+ **************************************************************************************/
+int MP3StreamBytesBuffered(HMP3Stream hMP3Stream)
+{
+	MP3StreamInfo *s = (MP3StreamInfo *)hMP3Stream;
+
+	return s ? (int)(s->writePos - s->readPos) : 0;
+}
+
+/**************************************************************************************
+ * Function:    DecodeNextFrame
+ *
+ * Description: locate, validate and decode the next frame in the ring
+ *
+ * Inputs:      stream, pointer to outbuf
+ *
+ * Outputs:     PCM data in outbuf
+ *
+ * Return:      ERR_MP3_INDATA_UNDERFLOW if more input is needed (nothing consumed
+ *                past the current sync word), otherwise the result of decoding one frame
+ *
+ * Notes:       after losing sync (start of stream, junk, bad header) a frame is only
+ *                accepted once the header following it matches, which rejects
+ *                false sync words inside ID3 data or damaged frames
+ **************************************************************************************/
+static int DecodeNextFrame(MP3StreamInfo *s, short *outbuf)
+{
+	MP3DecInfo *mp3DecInfo = s->mp3DecInfo;
+	int avail, offset, fhBytes, siBytes, sideBytes, frameBytes, freeFrameBytes, len0;
+	unsigned int mainPos;
+	unsigned char next[3];
+	unsigned char *mainPtr;
+	MP3_PROFILE_BEGIN();
+
+	for (;;) {
+		avail = (int)(s->writePos - s->readPos);
+
+		/* ID3v2 tag at the start of the stream */
+		if (!s->id3Checked) {
+			if (avail < ID3V2_HEADER_BYTES && !s->eof)
+				return ERR_MP3_INDATA_UNDERFLOW;
+			s->id3Checked = 1;
+			if (avail >= ID3V2_HEADER_BYTES) {
+				RingCopy(s, s->readPos, s->hdr, ID3V2_HEADER_BYTES);
+				if (memcmp(s->hdr, "ID3", 3) == 0) {
+					s->skipBytes = ((s->hdr[6] & 0x7f) << 21) | ((s->hdr[7] & 0x7f) << 14) |
+						((s->hdr[8] & 0x7f) << 7) | (s->hdr[9] & 0x7f);
+					s->skipBytes += ID3V2_HEADER_BYTES * ((s->hdr[5] & 0x10) ? 2 : 1);	/* header + optional footer */
+				}
+			}
+		}
+		if (s->skipBytes > 0) {
+			offset = MIN(avail, s->skipBytes);
+			RingDrop(s, offset);
+			s->skipBytes -= offset;
+			if (s->skipBytes > 0)
+				return ERR_MP3_INDATA_UNDERFLOW;
+			continue;
+		}
+
+		/* find sync word, drop anything in front of it */
+		offset = RingFindSync(s, s->readPos, avail);
+		if (offset < 0) {
+			if (avail > 1) {
+				RingSkip(s, avail - 1);		/* last byte might be the first half of a sync word */
+				s->locked = 0;
+			}
+			return ERR_MP3_INDATA_UNDERFLOW;
+		}
+		if (offset > 0) {
+			RingSkip(s, offset);
+			avail -= offset;
+			s->locked = 0;
+		}
+
+		/* frame header, CRC and side info */
+		if (avail < 6)
+			return ERR_MP3_INDATA_UNDERFLOW;
+		RingCopy(s, s->readPos, s->hdr, MIN(avail, FRAME_HDR_MAX_BYTES));
+		fhBytes = UnpackFrameHeader(mp3DecInfo, s->hdr);
+		if (fhBytes < 0 || mp3DecInfo->layer != 3) {
+			RingSkip(s, 1);
+			s->locked = 0;
+			continue;
+		}
+		sideBytes = sideBytesTab[mp3DecInfo->version][mp3DecInfo->nChans == 1 ? 0 : 1];
+		if (avail < fhBytes + sideBytes)
+			return ERR_MP3_INDATA_UNDERFLOW;
+		siBytes = UnpackSideInfo(mp3DecInfo, s->hdr + fhBytes);
+		if (siBytes < 0) {
+			RingSkip(s, 1);
+			s->locked = 0;
+			continue;
+		}
+
+		/* free format, frame size is the distance to the next matching header */
+		if (mp3DecInfo->bitrate == 0 || mp3DecInfo->freeBitrateFlag) {
+			if (!mp3DecInfo->freeBitrateFlag) {
+				offset = RingFindFreeSync(s, s->readPos + fhBytes + siBytes, avail - fhBytes - siBytes, s->hdr);
+				if (offset < 0) {
+					if (s->eof || avail == s->ringSize) {
+						RingSkip(s, 1);
+						continue;
+					}
+					return ERR_MP3_INDATA_UNDERFLOW;
+				}
+				mp3DecInfo->freeBitrateFlag = 1;
+				mp3DecInfo->freeBitrateSlots = offset;
+				freeFrameBytes = mp3DecInfo->freeBitrateSlots + fhBytes + siBytes;
+				mp3DecInfo->bitrate = (freeFrameBytes * mp3DecInfo->samprate * 8) / (mp3DecInfo->nGrans * mp3DecInfo->nGranSamps);
+			}
+			mp3DecInfo->nSlots = mp3DecInfo->freeBitrateSlots + CheckPadBit(mp3DecInfo);
+		}
+
+		/* reservoir plus main data must fit in mainBuf */
+		if (mp3DecInfo->nSlots < 0 || mp3DecInfo->mainDataBegin + mp3DecInfo->nSlots > MAINBUF_SIZE) {
+			RingSkip(s, 1);
+			s->locked = 0;
+			continue;
+		}
+		frameBytes = fhBytes + siBytes + mp3DecInfo->nSlots;
+
+		/* until locked, require the next header to match (unless this is the last frame) */
+		if (!s->locked) {
+			if (avail < frameBytes + 3) {
+				if (!s->eof) {
+					if (frameBytes + 3 <= s->ringSize)
+						return ERR_MP3_INDATA_UNDERFLOW;
+					RingSkip(s, 1);		/* can never fit, not a real frame */
+					continue;
+				}
+			} else {
+				RingCopy(s, s->readPos + frameBytes, next, 3);
+				if (next[0] != s->hdr[0] || next[1] != s->hdr[1] || (next[2] & 0x0c) != (s->hdr[2] & 0x0c)) {
+					RingSkip(s, 1);
+					continue;
+				}
+				s->locked = 1;
+			}
+		}
+		if (avail < frameBytes)
+			return ERR_MP3_INDATA_UNDERFLOW;
+		break;
+	}
+
+	/* found sync again after dropping data in the middle of the stream */
+	if (s->skipped > 0) {
+		if (s->started) {
+			mp3DecInfo->errStats.nResyncs++;
+			if (s->resilient) {
+				/* whole frames missing: the reservoir no longer lines up, fill the gap in time */
+				s->lostFrames = MIN((s->skipped + frameBytes / 2) / frameBytes, MAX_LOST_FRAMES);
+				if (s->lostFrames > 0)
+					mp3DecInfo->mainDataBytes = 0;
+			}
+		}
+		s->skipped = 0;
+	}
+	if (s->lostFrames > 0) {
+		s->lostFrames--;
+		ClearBadFrame(mp3DecInfo, outbuf, 0);
+		return ERR_MP3_MAINDATA_UNDERFLOW;
+	}
+
+	/* append main data to the bit reservoir straight from the ring */
+	mainPos = (s->readPos + fhBytes + siBytes) & s->ringMask;
+	len0 = MIN(mp3DecInfo->nSlots, s->ringSize - (int)mainPos);
+	mainPtr = FillMainBuf(mp3DecInfo, s->ring + mainPos, len0, s->ring, mp3DecInfo->nSlots - len0);
+	RingDrop(s, frameBytes);
+	if (!mainPtr) {
+		ClearBadFrame(mp3DecInfo, outbuf, 0);
+		return ERR_MP3_MAINDATA_UNDERFLOW;
+	}
+	MP3_PROFILE_MARK(mp3DecInfo, MP3_STAGE_HEADER);
+
+	return DecodeMainData(mp3DecInfo, mainPtr, outbuf);
+}
+
+/**************************************************************************************
+ * Function:    MP3StreamDecode
+ *
+ * Description: decode the next frame of the stream
+ *
+ * Inputs:      stream handle
+ *              pointer to outbuf, big enough to hold one frame of decoded PCM samples
+ *                (MAX_NCHAN * MAX_NGRAN * MAX_NSAMP)
+ *              pointer to MP3FrameInfo struct
+ *
+ * Outputs:     PCM data in outbuf, interleaved LRLRLR... if stereo
+ *              filled-in MP3FrameInfo struct (outputSamps = number of samples in outbuf)
+ *
+ * Return:      ERR_MP3_NONE if a frame was decoded
+ *              ERR_MP3_INDATA_UNDERFLOW if more input must be pushed (push mode only)
+ *              ERR_MP3_END_OF_STREAM when the input is exhausted
+ *              other error codes (mp3dec.h) if the frame was damaged, outbuf then holds
+ *                outputSamps samples of silence and decoding may simply continue
+ *
+ * Notes:       frames that can't be decoded because the bit reservoir is still empty
+ *                (start of stream, after resync) are skipped silently, as are frames
+ *                primed after MP3StreamFlush
+ *              in resilient mode damaged frames return their error code with concealed
+ *                audio in outbuf, and once playback has started, frames missing from
+ *                a gap in the input or lacking their reservoir return
+ *                ERR_MP3_MAINDATA_UNDERFLOW with concealed audio, so timing is kept
+ **************************************************************************************/
+int MP3StreamDecode(HMP3Stream hMP3Stream, short *outbuf, MP3FrameInfo *mp3FrameInfo)
+{
+	MP3StreamInfo *s = (MP3StreamInfo *)hMP3Stream;
+	unsigned char *buf;
+	int err, n;
+
+	if (!s || !outbuf || !mp3FrameInfo)
+		return ERR_MP3_NULL_POINTER;
+
+	for (;;) {
+		err = DecodeNextFrame(s, outbuf);
+		if (err != ERR_MP3_INDATA_UNDERFLOW)
+			UpdateErrorStats(s->mp3DecInfo, err);
+		if (err == ERR_MP3_NONE)
+			s->started = 1;
+		if (err != ERR_MP3_INDATA_UNDERFLOW && s->primeFrames > 0) {
+			s->primeFrames--;
+			continue;
+		}
+		if (err == ERR_MP3_MAINDATA_UNDERFLOW && !(s->resilient && s->started))
+			continue;
+		if (err != ERR_MP3_INDATA_UNDERFLOW)
+			break;
+
+		if (s->eof)
+			return ERR_MP3_END_OF_STREAM;
+
+		n = MP3StreamGetWriteBuffer(s, &buf);
+		if (n == 0) {
+			/* ring full but no frame fits - can only be garbage, skip a byte and resync */
+			RingSkip(s, 1);
+			s->locked = 0;
+			continue;
+		}
+		if (!s->readFunc)
+			return ERR_MP3_INDATA_UNDERFLOW;
+
+		n = s->readFunc(s->readArg, buf, n);
+		if (n <= 0)
+			s->eof = 1;
+		else
+			MP3StreamCommitWrite(s, n);
+	}
+
+	MP3GetLastFrameInfo(s->mp3DecInfo, mp3FrameInfo);
+	return err;
+}
@@ -293,3 +293,132 @@ void PolyphaseStereo(short *pcm, int *vbuf, const int *coefBase)
 		pcm += 2;
 	}
 }
+
+/**************************************************************************************
+ * Function:    PolyphaseMonoBlocked
+ *
+ * Description: same as PolyphaseMono, with each output pair computed by one 8-tap loop
+ *
+ * Inputs:      see PolyphaseMono
+ *
+ * Outputs:     32 samples of one channel of decoded PCM data, bit-identical to PolyphaseMono
+ *
+ * Return:      none
+ *
+ * Notes:       the 4 multiplies per tap are independent, so the tap loop maps onto
+ *                4-lane (or wider) 32x32->64 multiply-accumulate
+ *              64-bit integer sums don't depend on the order of accumulation
+ **************************************************************************************/
+void PolyphaseMonoBlocked(short *pcm, int *vbuf, const int *coefBase)
+{
+	int i, k;
+	const int *coef;
+	int *vb1;
+	int vLo, vHi, c1, c2;
+	Word64 sum1L, sum2L, rndVal;
+
+	rndVal = (Word64)( 1 << (DEF_NFRACBITS - 1 + (32 - CSHIFT)) );
+
+	/* special case, output sample 0 */
+	coef = coefBase;
+	sum1L = rndVal;
+	for (k = 0; k < 8; k++) {
+		sum1L = MADD64(sum1L, vbuf[k],       coef[2*k+0]);
+		sum1L = MADD64(sum1L, vbuf[23-k], -coef[2*k+1]);
+	}
+	pcm[0] = ClipToShort((int)SAR64(sum1L, (32-CSHIFT)), DEF_NFRACBITS);
+
+	/* special case, output sample 16 */
+	coef = coefBase + 256;
+	vb1 = vbuf + 64*16;
+	sum1L = rndVal;
+	for (k = 0; k < 8; k++)
+		sum1L = MADD64(sum1L, vb1[k], coef[k]);
+	pcm[16] = ClipToShort((int)SAR64(sum1L, (32-CSHIFT)), DEF_NFRACBITS);
+
+	/* sum1L = samples 1, 2, 3, ... 15   sum2L = samples 31, 30, ... 17 */
+	coef = coefBase + 16;
+	vb1 = vbuf + 64;
+	for (i = 1; i < 16; i++) {
+		sum1L = sum2L = rndVal;
+		for (k = 0; k < 8; k++) {
+			c1 = coef[2*k+0];	c2 = coef[2*k+1];
+			vLo = vb1[k];		vHi = vb1[23-k];
+			sum1L = MADD64(sum1L, vLo,  c1);	sum2L = MADD64(sum2L, vLo,  c2);
+			sum1L = MADD64(sum1L, vHi, -c2);	sum2L = MADD64(sum2L, vHi,  c1);
+		}
+		coef += 16;
+		vb1 += 64;
+		pcm[i]    = ClipToShort((int)SAR64(sum1L, (32-CSHIFT)), DEF_NFRACBITS);
+		pcm[32-i] = ClipToShort((int)SAR64(sum2L, (32-CSHIFT)), DEF_NFRACBITS);
+	}
+}
+
+/**************************************************************************************
+ * Function:    PolyphaseStereoBlocked
+ *
+ * Description: same as PolyphaseStereo, with each output pair computed by one 8-tap loop
+ *
+ * Inputs:      see PolyphaseStereo
+ *
+ * Outputs:     32 samples of two channels of decoded PCM data, bit-identical to
+ *                PolyphaseStereo
+ *
+ * Return:      none
+ *
+ * Notes:       interleaves PCM samples LRLRLR...
+ *              left and right share the coefficient loads, 8 independent multiplies per tap
+ **************************************************************************************/
+void PolyphaseStereoBlocked(short *pcm, int *vbuf, const int *coefBase)
+{
+	int i, k;
+	const int *coef;
+	int *vb1;
+	int c1, c2;
+	Word64 sum1L, sum2L, sum1R, sum2R, rndVal;
+
+	rndVal = (Word64)( 1 << (DEF_NFRACBITS - 1 + (32 - CSHIFT)) );
+
+	/* special case, output sample 0 */
+	coef = coefBase;
+	sum1L = sum1R = rndVal;
+	for (k = 0; k < 8; k++) {
+		c1 = coef[2*k+0];	c2 = coef[2*k+1];
+		sum1L = MADD64(sum1L, vbuf[k],         c1);	sum1L = MADD64(sum1L, vbuf[23-k],    -c2);
+		sum1R = MADD64(sum1R, vbuf[32+k],      c1);	sum1R = MADD64(sum1R, vbuf[32+23-k], -c2);
+	}
+	pcm[0] = ClipToShort((int)SAR64(sum1L, (32-CSHIFT)), DEF_NFRACBITS);
+	pcm[1] = ClipToShort((int)SAR64(sum1R, (32-CSHIFT)), DEF_NFRACBITS);
+
+	/* special case, output sample 16 */
+	coef = coefBase + 256;
+	vb1 = vbuf + 64*16;
+	sum1L = sum1R = rndVal;
+	for (k = 0; k < 8; k++) {
+		sum1L = MADD64(sum1L, vb1[k],    coef[k]);
+		sum1R = MADD64(sum1R, vb1[32+k], coef[k]);
+	}
+	pcm[2*16 + 0] = ClipToShort((int)SAR64(sum1L, (32-CSHIFT)), DEF_NFRACBITS);
+	pcm[2*16 + 1] = ClipToShort((int)SAR64(sum1R, (32-CSHIFT)), DEF_NFRACBITS);
+
+	/* sum1L = samples 1, 2, 3, ... 15   sum2L = samples 31, 30, ... 17 */
+	coef = coefBase + 16;
+	vb1 = vbuf + 64;
+	for (i = 1; i < 16; i++) {
+		sum1L = sum2L = rndVal;
+		sum1R = sum2R = rndVal;
+		for (k = 0; k < 8; k++) {
+			c1 = coef[2*k+0];	c2 = coef[2*k+1];
+			sum1L = MADD64(sum1L, vb1[k],         c1);	sum2L = MADD64(sum2L, vb1[k],          c2);
+			sum1L = MADD64(sum1L, vb1[23-k],     -c2);	sum2L = MADD64(sum2L, vb1[23-k],       c1);
+			sum1R = MADD64(sum1R, vb1[32+k],      c1);	sum2R = MADD64(sum2R, vb1[32+k],       c2);
+			sum1R = MADD64(sum1R, vb1[32+23-k],  -c2);	sum2R = MADD64(sum2R, vb1[32+23-k],    c1);
+		}
+		coef += 16;
+		vb1 += 64;
+		pcm[2*i + 0]      = ClipToShort((int)SAR64(sum1L, (32-CSHIFT)), DEF_NFRACBITS);
+		pcm[2*i + 1]      = ClipToShort((int)SAR64(sum1R, (32-CSHIFT)), DEF_NFRACBITS);
+		pcm[2*(32-i) + 0] = ClipToShort((int)SAR64(sum2L, (32-CSHIFT)), DEF_NFRACBITS);
+		pcm[2*(32-i) + 1] = ClipToShort((int)SAR64(sum2R, (32-CSHIFT)), DEF_NFRACBITS);
+	}
+}
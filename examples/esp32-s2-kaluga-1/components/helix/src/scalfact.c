@@ -354,8 +354,7 @@ static void UnpackSFMPEG2(BitStreamInfo *bsi, SideInfoSub *sis, ScaleFactorInfoS
  **************************************************************************************/
 int UnpackScaleFactors(MP3DecInfo *mp3DecInfo, unsigned char *buf, int *bitOffset, int bitsAvail, int gr, int ch)
 {
-	int bitsUsed;
-	unsigned char *startBuf;
+	int bitsUsed, nBytes;
 	BitStreamInfo bitStreamInfo, *bsi;
 	FrameHeader *fh;
 	SideInfo *si;
@@ -369,9 +368,9 @@ int UnpackScaleFactors(MP3DecInfo *mp3DecInfo, unsigned char *buf, int *bitOffse
 	sfi = ((ScaleFactorInfo *)(mp3DecInfo->ScaleFactorInfoPS));
 
 	/* init GetBits reader */
-	startBuf = buf;
 	bsi = &bitStreamInfo;
 	SetBitstreamPointer(bsi, (bitsAvail + *bitOffset + 7) / 8, buf);
+	SetBitstreamWrap(bsi, mp3DecInfo->mainWrap);
 	if (*bitOffset)
 		GetBits(bsi, *bitOffset);
 
@@ -383,8 +382,8 @@ int UnpackScaleFactors(MP3DecInfo *mp3DecInfo, unsigned char *buf, int *bitOffse
 	mp3DecInfo->part23Length[gr][ch] = si->sis[gr][ch].part23Length;
 
 	bitsUsed = CalcBitsUsed(bsi, buf, *bitOffset);
-	buf += (bitsUsed + *bitOffset) >> 3;
+	nBytes = (bitsUsed + *bitOffset) >> 3;
 	*bitOffset = (bitsUsed + *bitOffset) & 0x07;
 
-	return (buf - startBuf);
+	return nBytes;
 }
@@ -12,10 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <sys/unistd.h>
 #include <sys/stat.h>
+#include <sys/param.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
@@ -26,7 +28,9 @@
 #include "esp_log.h"
 #include "es8311.h"
 #include "touch.h"
-#include "mp3dec.h"
+#include "mp3stream.h"
+#include "mp3index.h"
+#include "audio_resample.h"
 #include "driver/touch_pad.h"
 #include "board.h"
 
@@ -58,149 +62,499 @@ enum {
 int play_flag = AUDIO_STOP;
 int audio_play_index = 0;
 
-void aplay_mp3(const char *path)
+static volatile int s_seek_ms = -1;
+static volatile int s_position_ms = 0;
+static volatile int s_duration_ms = 0;
+static volatile int s_crossfade_ms = 0;
+
+#define APLAY_FRAME_SAMPLES     (MAX_NGRAN * MAX_NSAMP)             /*!< samples per channel of the largest frame */
+#define APLAY_OUTPUT_SAMPLES    (MAX_NCHAN * APLAY_FRAME_SAMPLES)
+#define APLAY_ARENA_FLAGS       (MP3_ARENA_RESILIENT)
+#define APLAY_INDEX_POINTS      (256)
+#define APLAY_BLOCK_NUM         (4)                                 /*!< PCM blocks between decode and I2S task, ~100 ms at 44.1 kHz */
+#define APLAY_SWITCH_FADE_MS    (10)                                /*!< shortest fade on next/last, avoids a click */
+#define APLAY_OUTPUT_CHANNELS   (2)
+#define APLAY_RESAMPLE_QUALITY  (AUDIO_RESAMPLE_QUALITY_HIGH)
+
+typedef struct {
+    FILE *file;
+    unsigned int pos;       /*!< file offset of the next read */
+    HMP3Index index;
+} aplay_source_t;
+
+/*!< one open track, the player has two so the next one is ready before the current one ends */
+typedef struct {
+    aplay_source_t src;
+    HMP3Stream stream;
+    short *output;          /*!< last decoded frame */
+    audio_resample_handle_t resample;   /*!< converts the track to SAMPLE_RATE stereo */
+    int list_index;         /*!< position in audio_list, -1 if not open */
+    int samprate;
+    int nchans;
+    int frame;              /*!< number of the next frame the stream outputs, counted from frame 0 of the file */
+    int frame_pos;          /*!< decoder output sample of output[0], counted from frame 0 of the file */
+    int offset;             /*!< next sample per channel of output to play */
+    int avail;              /*!< samples per channel of output left to play */
+    int trim_known;
+    int start_skip;         /*!< samples at the start that are encoder and decoder delay */
+    int end_pos;            /*!< decoder output sample where the track ends, -1 if not known yet */
+    int duration_ms;
+    bool eof;
+} aplay_track_t;
+
+/*!< block of PCM passed from the decode task to the I2S task, always SAMPLE_RATE stereo */
+typedef struct {
+    int samples;            /*!< per channel */
+    int position_ms;        /*!< play position of the first sample in its track */
+    int duration_ms;
+    short pcm[APLAY_OUTPUT_SAMPLES];
+} aplay_block_t;
+
+/*!< decoder memory, tracks and PCM blocks, allocated once and reused for every track */
+typedef struct {
+    aplay_track_t tracks[2];
+    void *arena_mem[2];
+    short *mix;             /*!< samples of the incoming track during a fade */
+    aplay_block_t *blocks;
+    QueueHandle_t free_blocks;
+    QueueHandle_t filled_blocks;
+} aplay_player_t;
+
+static int aplay_mp3_read(void *arg, unsigned char *buf, int nbytes)
 {
-    ESP_LOGI(TAG, "start to decode %s", path);
-    HMP3Decoder hMP3Decoder;
-    MP3FrameInfo mp3FrameInfo;
-    unsigned char *readBuf = malloc(MAINBUF_SIZE);
+    aplay_source_t *src = (aplay_source_t *)arg;
+    int n = fread(buf, 1, nbytes, src->file);
 
-    if (readBuf == NULL) {
-        ESP_LOGE(TAG, "readBuf malloc failed");
-        return;
+    if (n > 0) {
+        /*!< the index is built from the data played anyway, no extra file reads */
+        MP3IndexFeed(src->index, buf, n, src->pos);
+        src->pos += n;
     }
 
-    short *output = malloc(1153 * 4);
+    return n;
+}
+
+static int aplay_mp3_seek(aplay_source_t *src, HMP3Stream stream, unsigned char *scratch, int scratch_size, int position_ms)
+{
+    MP3SeekInfo seek;
+    MP3IndexInfo info;
 
-    if (output == NULL) {
-        free(readBuf);
-        ESP_LOGE(TAG, "outBuf malloc failed");
+    if (MP3IndexSeek(src->index, position_ms, &seek) != 0) {
+        return -1;
     }
 
-    hMP3Decoder = MP3InitDecoder();
+    /*!< target not played yet: scan the headers up to it, then the position is exact */
+    while (!seek.exact) {
+        MP3GetIndexInfo(src->index, &info);
 
-    if (hMP3Decoder == 0) {
-        free(readBuf);
-        free(output);
-        ESP_LOGE(TAG, "memory is not enough..");
+        if (info.complete || fseek(src->file, info.scanPos, SEEK_SET) != 0) {
+            break;
+        }
+
+        int n = fread(scratch, 1, scratch_size, src->file);
+
+        if (n <= 0) {
+            break;
+        }
+
+        MP3IndexFeed(src->index, scratch, n, info.scanPos);
+        MP3IndexSeek(src->index, position_ms, &seek);
     }
 
-    int samplerate = 0;
-    i2s_zero_dma_buffer(0);
-    FILE *mp3File = fopen(path, "rb");
+    if (fseek(src->file, seek.offset, SEEK_SET) != 0) {
+        return -1;
+    }
 
-    if (mp3File == NULL) {
-        MP3FreeDecoder(hMP3Decoder);
-        free(readBuf);
-        free(output);
-        ESP_LOGE(TAG, "open file failed");
+    src->pos = seek.offset;
+    /*!< the frames in front of the target refill the bit reservoir and are not played */
+    MP3StreamFlush(stream, seek.primeFrames);
+    ESP_LOGI(TAG, "seek to %d ms: frame %d at offset %u, %d frames primed", position_ms, seek.targetFrame, seek.offset, seek.primeFrames);
+
+    return seek.targetFrame;
+}
+
+static esp_err_t aplay_player_init(aplay_player_t *player)
+{
+    int arena_size = MP3GetStreamArenaSize(0, APLAY_ARENA_FLAGS);
+
+    memset(player, 0, sizeof(aplay_player_t));
+    player->mix = malloc(APLAY_OUTPUT_SAMPLES * sizeof(short));
+    player->blocks = malloc(APLAY_BLOCK_NUM * sizeof(aplay_block_t));
+    player->free_blocks = xQueueCreate(APLAY_BLOCK_NUM, sizeof(aplay_block_t *));
+    player->filled_blocks = xQueueCreate(APLAY_BLOCK_NUM, sizeof(aplay_block_t *));
+
+    if (player->mix == NULL || player->blocks == NULL || player->free_blocks == NULL || player->filled_blocks == NULL) {
+        return ESP_ERR_NO_MEM;
     }
 
-    char tag[10];
-    int tag_len = 0;
-    int read_bytes = fread(tag, 1, 10, mp3File);
-
-    if (read_bytes == 10) {
-        if (memcmp(tag, "ID3", 3) == 0) {
-            tag_len = ((tag[6] & 0x7F) << 21) | ((tag[7] & 0x7F) << 14) | ((tag[8] & 0x7F) << 7) | (tag[9] & 0x7F);
-            // ESP_LOGI(TAG,"tag_len: %d %x %x %x %x", tag_len,tag[6],tag[7],tag[8],tag[9]);
-            fseek(mp3File, tag_len - 10, SEEK_SET);
-        } else {
-            fseek(mp3File, 0, SEEK_SET);
+    for (int i = 0; i < 2; i++) {
+        aplay_track_t *track = &player->tracks[i];
+
+        /*!< malloc only guarantees 4 byte alignment here, over-allocate and align by hand */
+        player->arena_mem[i] = malloc(arena_size + MP3_ARENA_ALIGN - 1);
+        track->output = malloc(APLAY_OUTPUT_SAMPLES * sizeof(short));
+        /*!< without an index the tracks still play, only seeking and trimming are not possible */
+        track->src.index = MP3InitIndex(APLAY_INDEX_POINTS);
+        track->list_index = -1;
+        /*!< every track is converted to the rate the I2S bus and the codec were set up for, so they are never
+         *   reconfigured and tracks of any rate can be crossfaded */
+        track->resample = audio_resample_create(SAMPLE_RATE, APLAY_OUTPUT_CHANNELS, SAMPLE_RATE, APLAY_OUTPUT_CHANNELS,
+                                                APLAY_RESAMPLE_QUALITY);
+
+        if (player->arena_mem[i] == NULL || track->output == NULL || track->resample == NULL) {
+            return ESP_ERR_NO_MEM;
         }
+
+        void *arena = (void *)(((uintptr_t)player->arena_mem[i] + MP3_ARENA_ALIGN - 1) & ~(uintptr_t)(MP3_ARENA_ALIGN - 1));
+        track->stream = MP3InitStreamArena(arena, arena_size, 0, APLAY_ARENA_FLAGS);
+        /*!< damaged or missing frames are concealed from the last good one instead of breaking playback */
+        MP3StreamSetResilientMode(track->stream, 1);
     }
 
-    int bytesLeft = 0;
-    unsigned char *readPtr = readBuf;
-    play_flag = AUDIO_PLAY;
+    for (int i = 0; i < APLAY_BLOCK_NUM; i++) {
+        aplay_block_t *block = &player->blocks[i];
+        xQueueSend(player->free_blocks, &block, 0);
+    }
 
-    while (1) {
-        switch (play_flag) {
-            case AUDIO_STOP: {
-                while (!play_flag) {
-                    i2s_zero_dma_buffer(0);
-                    vTaskDelay(100 / portTICK_RATE_MS);
-                }
-            }
-            break;
+    ESP_LOGI(TAG, "mp3 player uses 2 x %d bytes of decoder memory", arena_size);
 
-            case AUDIO_PLAY: {
-            }
-            break;
+    return ESP_OK;
+}
 
-            case AUDIO_NEXT: {
-                if (audio_play_index < AUDIO_MAX_PLAY_LIST - 1) {
-                    audio_play_index++;
-                } else {
-                    audio_play_index = 0;
-                }
+static void aplay_track_close(aplay_track_t *track)
+{
+    if (track->src.file) {
+        MP3ErrorStats mp3ErrorStats;
+        MP3StreamGetErrorStats(track->stream, &mp3ErrorStats);
 
-                goto stop;
-            }
-            break;
+        if (mp3ErrorStats.nConcealed || mp3ErrorStats.nResyncs) {
+            ESP_LOGW(TAG, "%d good frames, %d concealed granules, %d resyncs, %d bytes skipped", mp3ErrorStats.nFrames,
+                     mp3ErrorStats.nConcealed, mp3ErrorStats.nResyncs, mp3ErrorStats.nSkippedBytes);
+        }
 
-            case AUDIO_LAST: {
-                if (audio_play_index > 0) {
-                    audio_play_index--;
-                } else {
-                    audio_play_index = AUDIO_MAX_PLAY_LIST - 1;
-                }
+        fclose(track->src.file);
+        track->src.file = NULL;
+    }
 
-                goto stop;
-            }
+    track->list_index = -1;
+}
+
+/*!< decode the next frame and work out which of its samples are part of the track, false at the end of the track */
+static bool aplay_track_decode(aplay_track_t *track)
+{
+    MP3FrameInfo mp3FrameInfo;
+    MP3IndexInfo mp3IndexInfo;
+
+    while (!track->eof) {
+        int errs = MP3StreamDecode(track->stream, track->output, &mp3FrameInfo);
+
+        if (errs == ERR_MP3_END_OF_STREAM) {
+            break;
+        } else if (errs == ERR_MP3_NULL_POINTER || errs == ERR_MP3_OUT_OF_MEMORY) {
+            ESP_LOGE(TAG, "MP3StreamDecode failed ,code is %d ", errs);
             break;
+        } else if (errs != ERR_MP3_NONE) {
+            /*!< output holds a concealed frame, keep playing to hold the timing */
+            ESP_LOGD(TAG, "frame %d damaged, code is %d", track->frame, errs);
+        }
+
+        int samples = mp3FrameInfo.outputSamps / mp3FrameInfo.nChans;
+
+        if (samples == 0) {
+            continue;
         }
 
-        if (bytesLeft < MAINBUF_SIZE) {
-            memmove(readBuf, readPtr, bytesLeft);
-            int br = fread(readBuf + bytesLeft, 1, MAINBUF_SIZE - bytesLeft, mp3File);
+        if (track->samprate != mp3FrameInfo.samprate || track->nchans != mp3FrameInfo.nChans) {
+            ESP_LOGI(TAG, "mp3file info---bitrate=%d,layer=%d,nChans=%d,samprate=%d,outputSamps=%d", mp3FrameInfo.bitrate, mp3FrameInfo.layer, mp3FrameInfo.nChans, mp3FrameInfo.samprate, mp3FrameInfo.outputSamps);
 
-            if ((br == 0) && (bytesLeft == 0)) {
+            if (audio_resample_set_input(track->resample, mp3FrameInfo.samprate, mp3FrameInfo.nChans) != 0) {
+                ESP_LOGE(TAG, "no sample rate converter for %d Hz", mp3FrameInfo.samprate);
                 break;
             }
+        }
 
-            bytesLeft = bytesLeft + br;
-            readPtr = readBuf;
+        track->samprate = mp3FrameInfo.samprate;
+        track->nchans = mp3FrameInfo.nChans;
+        MP3GetIndexInfo(track->src.index, &mp3IndexInfo);
+
+        /*!< the index has parsed the first frame by now, its LAME tag tells how much is encoder delay and padding */
+        if (!track->trim_known) {
+            track->trim_known = 1;
+            track->start_skip = mp3IndexInfo.gapless ? mp3IndexInfo.startSkip : 0;
+            track->end_pos = mp3IndexInfo.gapless ? mp3IndexInfo.startSkip + mp3IndexInfo.nSamples : -1;
+            ESP_LOGI(TAG, "duration %d ms%s, %d samples encoder delay, %d samples padding", mp3IndexInfo.durationMs,
+                     mp3IndexInfo.exact ? "" : " (estimated)", mp3IndexInfo.encDelay, mp3IndexInfo.encPadding);
         }
 
-        int offset = MP3FindSyncWord(readPtr, bytesLeft);
+        /*!< without a LAME tag the end is known once the index has the exact frame count */
+        if (track->end_pos < 0 && mp3IndexInfo.exact) {
+            track->end_pos = (mp3IndexInfo.firstAudioFrame + mp3IndexInfo.nFrames) * samples;
+        }
 
-        if (offset < 0) {
-            ESP_LOGE(TAG, "MP3FindSyncWord not find");
-            bytesLeft = 0;
-            continue;
-        } else {
-            readPtr += offset;                    /*!< data start point */
-            bytesLeft -= offset;                 /*!< in buffer */
-            int errs = MP3Decode(hMP3Decoder, &readPtr, &bytesLeft, output, 0);
+        track->duration_ms = mp3IndexInfo.gapless ? (int)((long long)mp3IndexInfo.nSamples * 1000 / track->samprate) : mp3IndexInfo.durationMs;
+        track->frame_pos = track->frame * samples;
+        track->frame++;
+
+        int start = MAX(track->start_skip - track->frame_pos, 0);
+        int end = track->end_pos < 0 ? samples : MIN(track->end_pos - track->frame_pos, samples);
+
+        if (start < end) {
+            track->offset = start;
+            track->avail = end - start;
+            return true;
+        }
+
+        if (track->end_pos >= 0 && track->frame_pos >= track->end_pos) {
+            break;      /*!< padding only from here on */
+        }
+    }
+
+    track->eof = true;
+    track->avail = 0;
+    return false;
+}
+
+/*!< open a track and decode its first frame, so it starts without delay */
+static bool aplay_track_open(aplay_track_t *track, int list_index)
+{
+    const char *path = audio_list[list_index];
+    struct stat st;
+
+    ESP_LOGI(TAG, "start to decode %s", path);
+    aplay_track_close(track);
+    track->list_index = list_index;
+    track->samprate = 0;
+    track->nchans = 0;
+    track->frame = 0;
+    track->frame_pos = 0;
+    track->offset = 0;
+    track->avail = 0;
+    track->trim_known = 0;
+    track->start_skip = 0;
+    track->end_pos = -1;
+    track->duration_ms = 0;
+    track->eof = true;
+    audio_resample_reset(track->resample);
+    track->src.file = fopen(path, "rb");
+
+    if (track->src.file == NULL) {
+        /*!< stays at its end, so playback moves on to the track after it */
+        ESP_LOGE(TAG, "open file failed");
+        return false;
+    }
+
+    /*!< same memory as the last track, so changing tracks neither allocates nor fragments the heap */
+    MP3StreamReset(track->stream);
+    MP3StreamResetErrorStats(track->stream);
+    MP3IndexReset(track->src.index);
+    track->src.pos = 0;
+
+    if (stat(path, &st) == 0) {
+        MP3IndexSetFileSize(track->src.index, st.st_size);
+    }
+
+    /*!< the stream reads the file straight into its ring buffer, skips ID3v2 tags and resyncs by itself */
+    MP3StreamSetReader(track->stream, aplay_mp3_read, &track->src);
+    track->eof = false;
+
+    return aplay_track_decode(track);
+}
+
+static void aplay_track_seek(aplay_track_t *track, int position_ms)
+{
+    /*!< output doubles as scratch buffer for scanning ahead, its samples are dropped anyway */
+    int target = aplay_mp3_seek(&track->src, track->stream, (unsigned char *)track->output, APLAY_OUTPUT_SAMPLES * sizeof(short),
+                                position_ms);
+
+    if (target >= 0) {
+        track->frame = target;
+        track->avail = 0;
+        track->eof = false;
+        audio_resample_reset(track->resample);
+    }
+}
+
+/*!< output samples per channel of the track still to play, -1 if not known */
+static int aplay_track_remaining(aplay_track_t *track)
+{
+    if (track->eof || track->samprate == 0) {
+        return 0;
+    }
+
+    if (track->end_pos < 0) {
+        return -1;
+    }
+
+    return (int)((long long)MAX(track->end_pos - track->frame_pos - track->offset, 0) * SAMPLE_RATE / track->samprate);
+}
+
+static int aplay_track_position_ms(aplay_track_t *track)
+{
+    int pos = MAX(track->frame_pos + track->offset - track->start_skip, 0);
+
+    return track->samprate ? (int)((long long)pos * 1000 / track->samprate) : 0;
+}
 
-            if (errs != 0) {
-                ESP_LOGE(TAG, "MP3Decode failed ,code is %d ", errs);
+/*!< convert up to samples per channel of the track into dst, stops early only at the end of the track */
+static int aplay_track_pull(aplay_track_t *track, short *dst, int samples)
+{
+    int done = 0;
+
+    while (done < samples) {
+        if (track->avail == 0 && !aplay_track_decode(track)) {
+            /*!< the converter still holds the last few samples of the track */
+            int n = audio_resample_flush(track->resample, dst + done * APLAY_OUTPUT_CHANNELS, samples - done);
+
+            if (n == 0) {
                 break;
             }
 
-            MP3GetLastFrameInfo(hMP3Decoder, &mp3FrameInfo);
+            done += n;
+            continue;
+        }
+
+        int used = 0;
+        done += audio_resample_process(track->resample, track->output + track->offset * track->nchans, track->avail, &used,
+                                       dst + done * APLAY_OUTPUT_CHANNELS, samples - done);
+        track->offset += used;
+        track->avail -= used;
+    }
+
+    return done;
+}
+
+/*!< fade from the outgoing samples in pcm to the incoming ones in mix, gain in Q15 so long fades can't overflow */
+static void aplay_crossfade(short *pcm, const short *mix, int samples, int nchans, int fade_pos, int fade_len)
+{
+    for (int i = 0; i < samples; i++) {
+        int gain = (int)(((long long)(fade_pos + i) << 15) / fade_len);
+
+        for (int c = 0; c < nchans; c++) {
+            int k = i * nchans + c;
+            pcm[k] = (short)((pcm[k] * (32768 - gain) + mix[k] * gain) >> 15);
+        }
+    }
+}
+
+static void audio_decode_task(void *arg)
+{
+    aplay_player_t *player = (aplay_player_t *)arg;
+    aplay_track_t *cur = &player->tracks[0];
+    aplay_track_t *next = &player->tracks[1];
+    int fade_len = 0;       /*!< samples per channel of the running crossfade, 0 if none */
+    int fade_pos = 0;
+
+    aplay_track_open(cur, audio_play_index);
+    play_flag = AUDIO_PLAY;
+
+    while (1) {
+        aplay_block_t *block;
+        xQueueReceive(player->free_blocks, &block, portMAX_DELAY);
+
+        /*!< next/last: fade over to the requested track, the one after the current is already open */
+        if ((play_flag == AUDIO_NEXT || play_flag == AUDIO_LAST) && fade_len == 0) {
+            int index = play_flag == AUDIO_NEXT ? (cur->list_index + 1) % AUDIO_MAX_PLAY_LIST
+                        : (cur->list_index + AUDIO_MAX_PLAY_LIST - 1) % AUDIO_MAX_PLAY_LIST;
+            play_flag = AUDIO_PLAY;
 
-            if (samplerate != mp3FrameInfo.samprate) {
-                samplerate = mp3FrameInfo.samprate;
-                i2s_set_clk(0, samplerate, 16, mp3FrameInfo.nChans);
-                ESP_LOGI(TAG, "mp3file info---bitrate=%d,layer=%d,nChans=%d,samprate=%d,outputSamps=%d", mp3FrameInfo.bitrate, mp3FrameInfo.layer, mp3FrameInfo.nChans, mp3FrameInfo.samprate, mp3FrameInfo.outputSamps);
+            if (next->list_index != index) {
+                aplay_track_open(next, index);
             }
 
-            size_t bytes_write = 0;
-            i2s_write(0, (const char *) output, mp3FrameInfo.outputSamps * 2, &bytes_write, 100 / portTICK_RATE_MS);
-            // rmt_write_items(0,(const char*)output,mp3FrameInfo.outputSamps*2, 1000 / portTICK_RATE_MS);
+            int fade_ms = MAX(s_crossfade_ms, APLAY_SWITCH_FADE_MS);
+            fade_len = SAMPLE_RATE * fade_ms / 1000;
+            fade_pos = 0;
+        }
+
+        int seek_ms = s_seek_ms;
+
+        if (seek_ms >= 0 && fade_len == 0) {
+            s_seek_ms = -1;
+            aplay_track_seek(cur, seek_ms);
+        }
+
+        /*!< prepare the following track while this one plays, so the switch costs no decode time */
+        if (next->list_index < 0 && fade_len == 0) {
+            aplay_track_open(next, (cur->list_index + 1) % AUDIO_MAX_PLAY_LIST);
+        }
+
+        /*!< towards the natural end, start the crossfade so that it ends with the last sample */
+        int remaining = aplay_track_remaining(cur);
+        int crossfade_len = SAMPLE_RATE * s_crossfade_ms / 1000;
+
+        if (fade_len == 0 && crossfade_len > 0 && remaining >= 0 && remaining <= crossfade_len && next->avail > 0) {
+            fade_len = MAX(remaining, 1);
+            fade_pos = 0;
         }
+
+        /*!< both tracks are at the output format, so any two can be mixed */
+        bool mixing = fade_len > 0;
+        int want = mixing ? MIN(APLAY_FRAME_SAMPLES, fade_len - fade_pos) : APLAY_FRAME_SAMPLES;
+
+        block->position_ms = aplay_track_position_ms(cur);
+        block->duration_ms = cur->duration_ms;
+        block->samples = aplay_track_pull(cur, block->pcm, want);
+
+        if (mixing) {
+            int got = aplay_track_pull(next, player->mix, want);
+
+            /*!< the outgoing track may end within the fade, it is silent from there on */
+            memset(block->pcm + block->samples * APLAY_OUTPUT_CHANNELS, 0, (want - block->samples) * APLAY_OUTPUT_CHANNELS * sizeof(short));
+            aplay_crossfade(block->pcm, player->mix, got, APLAY_OUTPUT_CHANNELS, fade_pos, fade_len);
+            block->samples = MAX(block->samples, got);
+            fade_pos = got < want ? fade_len : fade_pos + got;
+        }
+
+        /*!< fade done or track over: the next track takes over at the following sample */
+        if ((fade_len > 0 && fade_pos >= fade_len) || (fade_len == 0 && block->samples < want && cur->eof)) {
+            aplay_track_t *done = cur;
+            cur = next;
+            next = done;
+            aplay_track_close(next);
+            audio_play_index = cur->list_index;
+            fade_len = 0;
+            ESP_LOGI(TAG, "end mp3 decode ..");
+
+            if (block->samples == 0) {
+                block->position_ms = aplay_track_position_ms(cur);
+                block->duration_ms = cur->duration_ms;
+            }
+
+            /*!< gapless: the new track continues in the same block */
+            block->samples += aplay_track_pull(cur, block->pcm + block->samples * APLAY_OUTPUT_CHANNELS, APLAY_FRAME_SAMPLES - block->samples);
+        }
+
+        if (block->samples == 0) {
+            xQueueSend(player->free_blocks, &block, portMAX_DELAY);
+            vTaskDelay(100 / portTICK_RATE_MS);
+            continue;
+        }
+
+        xQueueSend(player->filled_blocks, &block, portMAX_DELAY);
     }
+}
 
-stop:
-    i2s_zero_dma_buffer(0);
-    MP3FreeDecoder(hMP3Decoder);
-    free(readBuf);
-    free(output);
-    fclose(mp3File);
+static void audio_i2s_task(void *arg)
+{
+    aplay_player_t *player = (aplay_player_t *)arg;
+
+    while (1) {
+        aplay_block_t *block;
+        xQueueReceive(player->filled_blocks, &block, portMAX_DELAY);
+
+        while (play_flag == AUDIO_STOP) {
+            i2s_zero_dma_buffer(0);
+            vTaskDelay(100 / portTICK_RATE_MS);
+        }
 
-    ESP_LOGI(TAG, "end mp3 decode ..");
+        s_position_ms = block->position_ms;
+        s_duration_ms = block->duration_ms;
+
+        size_t bytes_write = 0;
+        i2s_write(0, (const char *) block->pcm, block->samples * APLAY_OUTPUT_CHANNELS * sizeof(short), &bytes_write, portMAX_DELAY);
+        // rmt_write_items(0,(const char*)output,mp3FrameInfo.outputSamps*2, 1000 / portTICK_RATE_MS);
+        xQueueSend(player->free_blocks, &block, portMAX_DELAY);
+    }
 }
 
 static void audio_task(void *arg)
@@ -231,11 +585,18 @@ static void audio_task(void *arg)
 
     i2s_driver_install(I2S_NUM, &i2s_config, 0, NULL);
     i2s_set_pin(I2S_NUM, &pin_config);
+    i2s_zero_dma_buffer(0);
 
-    while (1) {
-        aplay_mp3(audio_list[audio_play_index]);
-        vTaskDelay(1000 / portTICK_RATE_MS);
+    static aplay_player_t player;
+
+    if (aplay_player_init(&player) != ESP_OK) {
+        ESP_LOGE(TAG, "memory is not enough..");
+        vTaskDelete(NULL);
     }
+
+    /*!< the writer only blocks on I2S, so decoding, file reads and track switches never stall the output */
+    xTaskCreate(audio_i2s_task, "audio_i2s_task", 2048, &player, 6, NULL);
+    audio_decode_task(&player);
 }
 
 
@@ -315,6 +676,26 @@ static void audio_control_task(void *arg)
 
 }
 
+void audio_seek(int position_ms)
+{
+    s_seek_ms = position_ms < 0 ? 0 : position_ms;
+}
+
+int audio_get_position(void)
+{
+    return s_position_ms;
+}
+
+int audio_get_duration(void)
+{
+    return s_duration_ms;
+}
+
+void audio_set_crossfade(int fade_ms)
+{
+    s_crossfade_ms = fade_ms < 0 ? 0 : fade_ms;
+}
+
 int audio_init(led_strip_t *strip)
 {
     es8311_init(SAMPLE_RATE);
@@ -0,0 +1,340 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Gapless playback of the player in audio.c.
+ *
+ * Every track of audio_list is decoded on its own with a plain stream, cut to the
+ * original audio given by its LAME tag and converted to 44.1 kHz stereo with a converter
+ * of its own. The encoder delay and padding of the tag must account for the decoder output
+ * to the sample.
+ *
+ * The decode task of audio.c then plays the list from the first track round to the first
+ * track again, against stand-in queues: the test takes the part of the I2S task and
+ * collects every block, only once all blocks are filled so each one sits in the queue
+ * while the next are decoded. The blocks must be the trimmed tracks, concatenated, to the
+ * sample: no silence of the encoder is left in, no sample of the music is cut, lost or
+ * doubled where the tracks change, including the change of sample rate.
+ *
+ * Usage:
+ *     gapless_test <folder of the spiffs files>
+ */
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static FILE *host_fopen(const char *path, const char *mode);
+static int host_stat(const char *path, struct stat *st);
+
+// audio_list names the files on the mounted partition, they are opened in the given folder instead
+#define fopen host_fopen
+#define stat(path, st) host_stat(path, st)
+#include "audio.c"
+#undef fopen
+#undef stat
+
+#define SPIFFS_PREFIX   "/spiffs/"
+#define REPLAY_MS       (1000)  /*!< first track played again after the last one */
+
+static int s_failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            s_failures++; \
+        } \
+    } while (0)
+
+static const char *s_folder;
+
+static const char *host_path(const char *path, char *buf, size_t size)
+{
+    if (strncmp(path, SPIFFS_PREFIX, strlen(SPIFFS_PREFIX)) == 0) {
+        snprintf(buf, size, "%s/%s", s_folder, path + strlen(SPIFFS_PREFIX));
+        return buf;
+    }
+    return path;
+}
+
+static FILE *host_fopen(const char *path, const char *mode)
+{
+    char buf[512];
+    return fopen(host_path(path, buf, sizeof(buf)), mode);
+}
+
+static int host_stat(const char *path, struct stat *st)
+{
+    char buf[512];
+    return stat(host_path(path, buf, sizeof(buf)), st);
+}
+
+/* Stereo PCM at SAMPLE_RATE, growing */
+typedef struct {
+    short *pcm;
+    int frames;
+    int room;
+} pcm_t;
+
+static void pcm_append(pcm_t *p, const short *pcm, int frames)
+{
+    if (p->frames + frames > p->room) {
+        p->room = (p->frames + frames) * 2;
+        p->pcm = realloc(p->pcm, (size_t)p->room * APLAY_OUTPUT_CHANNELS * sizeof(short));
+        if (p->pcm == NULL) {
+            printf("out of memory\n");
+            exit(1);
+        }
+    }
+    memcpy(p->pcm + p->frames * APLAY_OUTPUT_CHANNELS, pcm, (size_t)frames * APLAY_OUTPUT_CHANNELS * sizeof(short));
+    p->frames += frames;
+}
+
+typedef struct {
+    const unsigned char *data;
+    int size;
+    int pos;
+} mem_source_t;
+
+static int mem_read(void *arg, unsigned char *buf, int nbytes)
+{
+    mem_source_t *src = (mem_source_t *)arg;
+    int n = MIN(nbytes, src->size - src->pos);
+
+    memcpy(buf, src->data + src->pos, n);
+    src->pos += n;
+    return n;
+}
+
+/* A track decoded on its own, trimmed by its LAME tag and converted to SAMPLE_RATE stereo */
+static void decode_reference(const char *path, pcm_t *out)
+{
+    char buf[512];
+    FILE *f = fopen(host_path(path, buf, sizeof(buf)), "rb");
+    struct stat st;
+
+    if (f == NULL || stat(buf, &st) != 0) {
+        CHECK(0, "%s: cannot open", buf);
+        if (f) {
+            fclose(f);
+        }
+        return;
+    }
+
+    unsigned char *data = malloc(st.st_size);
+    mem_source_t src = { data, (int)fread(data, 1, st.st_size, f), 0 };
+    fclose(f);
+
+    MP3IndexInfo info;
+    HMP3Index index = MP3InitIndex(0);
+    MP3IndexSetFileSize(index, src.size);
+    MP3IndexFeed(index, data, src.size, 0);
+    MP3GetIndexInfo(index, &info);
+    MP3FreeIndex(index);
+
+    // Every sample the decoder outputs, frame 0 included
+    HMP3Stream stream = MP3InitStream(0);
+    short frame[APLAY_OUTPUT_SAMPLES];
+    short *pcm = NULL;
+    int samples = 0, frames = 0, nchans = 0, samprate = 0;
+    MP3FrameInfo fi;
+
+    MP3StreamSetReader(stream, mem_read, &src);
+    while (1) {
+        int err = MP3StreamDecode(stream, frame, &fi);
+        if (err == ERR_MP3_END_OF_STREAM) {
+            break;
+        }
+        CHECK(err == ERR_MP3_NONE, "%s: error %d in frame %d", path, err, frames);
+        if (err != ERR_MP3_NONE) {
+            break;
+        }
+        pcm = realloc(pcm, (size_t)(samples + fi.outputSamps / fi.nChans) * fi.nChans * sizeof(short));
+        memcpy(pcm + samples * fi.nChans, frame, fi.outputSamps * sizeof(short));
+        samples += fi.outputSamps / fi.nChans;
+        nchans = fi.nChans;
+        samprate = fi.samprate;
+        frames++;
+    }
+    MP3FreeStream(stream);
+    free(data);
+
+    // The tag must account for every sample: header frame, encoder delay, filterbank delay, audio, padding
+    CHECK(info.gapless, "%s: no LAME tag", path);
+    CHECK(frames == info.firstAudioFrame + info.nFrames, "%s: %d frames decoded, %d + %d in the index", path, frames,
+          info.firstAudioFrame, info.nFrames);
+    CHECK(info.startSkip == info.firstAudioFrame * info.samplesPerFrame + info.encDelay + MP3_DECODER_DELAY,
+          "%s: start skip %d", path, info.startSkip);
+    CHECK(samples == info.startSkip + info.nSamples + info.encPadding - MP3_DECODER_DELAY,
+          "%s: %d samples decoded, %d + %d + %d - %d from the tag", path, samples, info.startSkip, info.nSamples,
+          info.encPadding, MP3_DECODER_DELAY);
+
+    int start = info.gapless ? info.startSkip : 0;
+    int length = info.gapless ? MIN(info.nSamples, samples - start) : samples;
+    audio_resample_handle_t resample = audio_resample_create(samprate, nchans, SAMPLE_RATE, APLAY_OUTPUT_CHANNELS,
+                                                             APLAY_RESAMPLE_QUALITY);
+    int room = (int)((long long)length * SAMPLE_RATE / samprate) + 64;
+    short *conv = malloc((size_t)room * APLAY_OUTPUT_CHANNELS * sizeof(short));
+    int used = 0;
+    int n = audio_resample_process(resample, pcm + start * nchans, length, &used, conv, room);
+    int flushed;
+
+    while ((flushed = audio_resample_flush(resample, conv + n * APLAY_OUTPUT_CHANNELS, room - n)) > 0) {
+        n += flushed;
+    }
+    CHECK(used == length, "%s: converter took %d of %d samples", path, used, length);
+    CHECK(n == (int)(((long long)length * SAMPLE_RATE + samprate - 1) / samprate), "%s: %d samples converted from %d",
+          path, n, length);
+    pcm_append(out, conv, n);
+
+    printf("%-34s %5d Hz %d ch  delay %4d  padding %4d  skip %4d  %8d samples  %8d at 44.1 kHz\n", path + strlen(SPIFFS_PREFIX),
+           samprate, nchans, info.encDelay, info.encPadding, info.startSkip, length, n);
+
+    audio_resample_delete(resample);
+    free(conv);
+    free(pcm);
+}
+
+/* The queues of the player, the blocks are taken out as the I2S task would */
+struct host_queue {
+    unsigned char *items;
+    uint32_t length;
+    uint32_t item_size;
+    uint32_t head;
+    uint32_t count;
+};
+
+static aplay_player_t s_player;
+static pcm_t s_played;
+static int s_played_target;
+static jmp_buf s_done;
+
+QueueHandle_t xQueueCreate(uint32_t length, uint32_t item_size)
+{
+    QueueHandle_t queue = calloc(1, sizeof(struct host_queue));
+
+    if (queue) {
+        queue->items = malloc(length * item_size);
+        queue->length = length;
+        queue->item_size = item_size;
+    }
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    (void)ticks;
+    if (queue->count == queue->length) {
+        CHECK(0, "send to a full queue would block forever");
+        longjmp(s_done, 1);
+    }
+    memcpy(queue->items + (queue->head + queue->count) % queue->length * queue->item_size, item, queue->item_size);
+    queue->count++;
+    return pdTRUE;
+}
+
+static bool queue_take(QueueHandle_t queue, void *item)
+{
+    if (queue->count == 0) {
+        return false;
+    }
+    memcpy(item, queue->items + queue->head * queue->item_size, queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    return true;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    (void)ticks;
+    if (queue_take(queue, item)) {
+        return pdTRUE;
+    }
+
+    // Out of free blocks: play the filled ones and hand them back
+    aplay_block_t *block;
+    CHECK(queue == s_player.free_blocks && s_player.filled_blocks->count > 0, "receive would block forever");
+    if (queue != s_player.free_blocks) {
+        longjmp(s_done, 1);
+    }
+    while (queue_take(s_player.filled_blocks, &block)) {
+        CHECK(block->samples > 0 && block->samples <= APLAY_FRAME_SAMPLES, "block of %d samples", block->samples);
+        pcm_append(&s_played, block->pcm, block->samples);
+        memset(block->pcm, 0x55, sizeof(block->pcm));
+        xQueueSend(s_player.free_blocks, &block, portMAX_DELAY);
+    }
+    if (s_played.frames >= s_played_target) {
+        longjmp(s_done, 1);
+    }
+    return queue_take(queue, item) ? pdTRUE : pdFALSE;
+}
+
+/* Where a sample of the expected output is, for the report */
+static void locate(const int *ends, int frame, int *track, int *offset)
+{
+    *track = 0;
+    while (*track < AUDIO_MAX_PLAY_LIST && frame >= ends[*track]) {
+        (*track)++;
+    }
+    *offset = frame - (*track ? ends[*track - 1] : 0);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        printf("usage: %s <folder of the spiffs files>\n", argv[0]);
+        return 2;
+    }
+    s_folder = argv[1];
+
+    pcm_t expected = { 0 };
+    int ends[AUDIO_MAX_PLAY_LIST];
+
+    for (int i = 0; i < AUDIO_MAX_PLAY_LIST; i++) {
+        decode_reference(audio_list[i], &expected);
+        ends[i] = expected.frames;
+    }
+    // Round to the first track again
+    pcm_append(&expected, expected.pcm, MIN(ends[0], SAMPLE_RATE * REPLAY_MS / 1000));
+
+    if (aplay_player_init(&s_player) != ESP_OK) {
+        printf("FAIL: player init\n");
+        return 1;
+    }
+    audio_set_crossfade(0);
+    audio_play_index = 0;
+    s_played_target = expected.frames;
+    if (setjmp(s_done) == 0) {
+        audio_decode_task(&s_player);
+    }
+
+    int compared = MIN(s_played.frames, expected.frames);
+    int first = -1;
+    for (int i = 0; i < compared * APLAY_OUTPUT_CHANNELS; i++) {
+        if (s_played.pcm[i] != expected.pcm[i]) {
+            first = i / APLAY_OUTPUT_CHANNELS;
+            break;
+        }
+    }
+    CHECK(s_played.frames >= expected.frames, "played %d samples, expected %d", s_played.frames, expected.frames);
+    if (first >= 0) {
+        int track, offset;
+        locate(ends, first, &track, &offset);
+        CHECK(0, "played output differs at sample %d, sample %d of %strack %d", first, offset,
+              track < AUDIO_MAX_PLAY_LIST ? "" : "the replay of ", track % AUDIO_MAX_PLAY_LIST);
+    }
+    printf("played 0 > 1 > 2 > 0: %d samples, %s the tracks trimmed and concatenated\n", compared,
+           first < 0 ? "identical to" : "differ from");
+
+    free(expected.pcm);
+    free(s_played.pcm);
+    printf("%s\n", s_failures ? "FAIL" : "PASS");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,22 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host build: pins and pads of the Kaluga v1.3, never used */
+#pragma once
+
+#include "esp_err.h"
+
+#define I2S_SCLK                (18)
+#define I2S_LCLK                (17)
+#define I2S_DOUT                (12)
+#define I2S_DSIN                (34)
+
+#define TOUCH_BUTTON_PHOTO      (6)
+#define TOUCH_BUTTON_PLAY       (2)
+#define TOUCH_BUTTON_NETWORK    (11)
+#define TOUCH_BUTTON_RECORD     (5)
+#define TOUCH_BUTTON_VOLUP      (1)
+#define TOUCH_BUTTON_VOLDOWN    (3)
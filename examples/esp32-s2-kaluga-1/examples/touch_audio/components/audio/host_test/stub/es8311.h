@@ -0,0 +1,22 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host build: there is no codec, the test checks the PCM itself */
+#pragma once
+
+#include "esp_err.h"
+
+static inline esp_err_t es8311_init(int sample_fre)
+{
+    (void)sample_fre;
+    return ESP_OK;
+}
+
+static inline esp_err_t es8311_set_voice_volume(int volume)
+{
+    (void)volume;
+    return ESP_OK;
+}
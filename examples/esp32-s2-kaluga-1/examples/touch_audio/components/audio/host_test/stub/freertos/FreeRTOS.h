@@ -0,0 +1,20 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host build: tasks are never created, the decode task runs in the test itself */
+#pragma once
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+typedef void *TaskHandle_t;
+
+#define pdTRUE              (1)
+#define pdFALSE             (0)
+#define pdPASS              (1)
+#define portMAX_DELAY       (0xFFFFFFFF)
+#define portTICK_RATE_MS    (1)
@@ -0,0 +1,32 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host build: tasks are never created and delays return at once */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+static inline BaseType_t xTaskCreate(void (*task)(void *), const char *name, uint32_t stack, void *arg,
+                                     int priority, TaskHandle_t *handle)
+{
+    (void)task;
+    (void)name;
+    (void)stack;
+    (void)arg;
+    (void)priority;
+    (void)handle;
+    return pdPASS;
+}
+
+static inline void vTaskDelete(TaskHandle_t task)
+{
+    (void)task;
+}
+
+static inline void vTaskDelay(TickType_t ticks)
+{
+    (void)ticks;
+}
@@ -0,0 +1,21 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host build: never touched */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+static inline void touch_get_num(uint32_t *num)
+{
+    *num = 0;
+}
+
+static inline void touch_get_flag_status(bool *flag)
+{
+    *flag = false;
+}
@@ -28,6 +28,30 @@ extern "C" {
  */
 int audio_init(led_strip_t *strip);
 
+/**
+ * @brief Seek the track that is playing, takes effect before the next frame is decoded
+ *
+ * @param position_ms Play position from the start of the track
+ */
+void audio_seek(int position_ms);
+
+/**
+ * @brief Play position of the current track in ms
+ */
+int audio_get_position(void);
+
+/**
+ * @brief Duration of the current track in ms, 0 until the first frame is decoded
+ */
+int audio_get_duration(void);
+
+/**
+ * @brief Crossfade between consecutive tracks and on next/last, 0 (default) plays the tracks back to back without a gap
+ *
+ * @param fade_ms Length of the fade, tracks with different sample rates or channel counts are never mixed
+ */
+void audio_set_crossfade(int fade_ms);
+
 #ifdef __cplusplus
 }
 #endif
@@ -36,7 +36,7 @@ static esp_err_t audio_init(void)
     /*!<  if 2-channels, 24/32-bit each channel, total buffer is 360*8 = 2880 bytes */
     i2s_config_t i2s_config = {
         .mode = I2S_MODE_MASTER | I2S_MODE_TX | I2S_MODE_RX,                                  /*!<  Only TX */
-        .sample_rate = 16000,
+        .sample_rate = SAMPLE_RATE,                                            /*!< TTS output is converted to the codec rate */
         .bits_per_sample = 16,
         .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,                           /*!< 1-channels */
         .communication_format = I2S_COMM_FORMAT_I2S,
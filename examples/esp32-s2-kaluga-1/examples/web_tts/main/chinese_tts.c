@@ -12,6 +12,17 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 #include "chinese_tts.h"
+#include "esp_log.h"
+#include "audio_resample.h"
+
+static const char *TAG = "chinese_tts";
+
+#define TTS_SAMPLE_RATE     (16000)     /*!< esp_tts output, 16-bit mono */
+#define TTS_OUTPUT_RATE     (44100)     /*!< I2S and ES8311, SAMPLE_RATE in app_main.c */
+#define TTS_OUTPUT_FRAMES   (256)
+
+static audio_resample_handle_t s_resample = NULL;
+static int16_t s_output[TTS_OUTPUT_FRAMES];
 
 int iot_dac_audio_play(const uint8_t *data, int length, TickType_t ticks_to_wait)
 {
@@ -20,18 +31,50 @@ int iot_dac_audio_play(const uint8_t *data, int length, TickType_t ticks_to_wait
     return ESP_OK;
 }
 
+/*!< convert TTS samples to the output rate and play them, NULL flushes the end of the sentence */
+static void tts_play_resampled(const short *data, int samples)
+{
+    int pos = 0;
+    int produced;
+
+    if (data == NULL) {
+        while ((produced = audio_resample_flush(s_resample, s_output, TTS_OUTPUT_FRAMES)) > 0) {
+            iot_dac_audio_play((const uint8_t *)s_output, produced * sizeof(int16_t), portMAX_DELAY);
+        }
+
+        return;
+    }
+
+    while (pos < samples) {
+        int used = 0;
+        produced = audio_resample_process(s_resample, data + pos, samples - pos, &used, s_output, TTS_OUTPUT_FRAMES);
+        iot_dac_audio_play((const uint8_t *)s_output, produced * sizeof(int16_t), portMAX_DELAY);
+        pos += used;
+    }
+}
 
 void tts_output_chinese(esp_tts_handle_t *tts_handle,  char *data)
 {
+    /*!< the bus stays at the codec rate, so speech and music can share it without reconfiguring */
+    if (s_resample == NULL) {
+        s_resample = audio_resample_create(TTS_SAMPLE_RATE, 1, TTS_OUTPUT_RATE, 1, AUDIO_RESAMPLE_QUALITY_LOW);
+
+        if (s_resample == NULL) {
+            ESP_LOGE(TAG, "no memory for the sample rate converter");
+            return;
+        }
+    }
+
     if (esp_tts_parse_chinese(tts_handle, data)) {
         int len[1] = {0};
 
         do {
             short *data = esp_tts_stream_play(tts_handle, len, 4);
-            iot_dac_audio_play(data, len[0] * 2, portMAX_DELAY);
+            tts_play_resampled(data, len[0]);
             // printf("data:?%d \n", len[0]);
         } while (len[0] > 0);
 
+        tts_play_resampled(NULL, 0);
         i2s_zero_dma_buffer(0);
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,318 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Dirty region histories of the frame buffers in LVGL direct mode (bsp_dirty_history.c).
+ *
+ * - bsp_dirty_history_add() must cover every rectangle added, and bsp_dirty_history_subtract()
+ *   must give exactly the pixels of the history outside of the cut, checked pixel by pixel on
+ *   random rectangles.
+ * - Two frame buffers of the 800x480 panel are run through typical UI updates the way
+ *   flush_callback() in bsp_lvgl_port.c does: LVGL draws the dirty area into one, the history
+ *   of that one less the dirty area is copied from the other, then it is shown. Every frame
+ *   shown must equal what LVGL drew. Prints the pixels copied between the frame buffers per
+ *   frame, and the same for the previous scheme: the dirty area copied to the other frame
+ *   buffer after each frame, and the whole screen drawn again after a full screen frame.
+ *
+ * Usage:
+ *     dirty_history_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "bsp_dirty_history.h"
+
+#define PANEL_H_RES     800
+#define PANEL_V_RES     480
+#define PANEL_PIXELS    (PANEL_H_RES * PANEL_V_RES)
+#define INV_BUF_SIZE    32                      /* LV_INV_BUF_SIZE */
+#define SYNC_RECTS      (INV_BUF_SIZE * 4)      /* FLUSH_SYNC_RECTS of the port */
+
+static int s_failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            s_failures++; \
+        } \
+    } while (0)
+
+static bsp_dirty_rect_t random_rect(int w, int h, int max_size)
+{
+    bsp_dirty_rect_t r;
+    r.x1 = rand() % w;
+    r.y1 = rand() % h;
+    r.x2 = r.x1 + rand() % max_size;
+    r.y2 = r.y1 + rand() % max_size;
+    if (r.x2 >= w) {
+        r.x2 = w - 1;
+    }
+    if (r.y2 >= h) {
+        r.y2 = h - 1;
+    }
+    return r;
+}
+
+static void mark(uint8_t *map, int w, const bsp_dirty_rect_t *r, uint8_t bit)
+{
+    for (int y = r->y1; y <= r->y2; y++) {
+        for (int x = r->x1; x <= r->x2; x++) {
+            map[y * w + x] |= bit;
+        }
+    }
+}
+
+/* Random histories and cuts on a small screen, checked pixel by pixel */
+static void test_regions(void)
+{
+    enum { W = 64, H = 48 };
+    static uint8_t map[W * H];
+    bsp_dirty_history_t history;
+    bsp_dirty_rect_t cut[INV_BUF_SIZE];
+    bsp_dirty_rect_t out[SYNC_RECTS];
+
+    for (int iter = 0; iter < 2000; iter++) {
+        memset(map, 0, sizeof(map));
+        bsp_dirty_history_clear(&history);
+
+        /* 1: added, 2: in the history, 4: cut, 8: left by the subtraction */
+        int adds = 1 + rand() % 60;
+        for (int i = 0; i < adds; i++) {
+            bsp_dirty_rect_t r = random_rect(W, H, 1 + rand() % 24);
+            mark(map, W, &r, 1);
+            bsp_dirty_history_add(&history, &r);
+        }
+        CHECK(history.num <= BSP_DIRTY_HISTORY_RECTS, "history of %d rectangles", history.num);
+        for (int i = 0; i < history.num; i++) {
+            mark(map, W, &history.rects[i], 2);
+        }
+
+        int cut_num = rand() % 8;
+        for (int i = 0; i < cut_num; i++) {
+            cut[i] = random_rect(W, H, 1 + rand() % 32);
+            mark(map, W, &cut[i], 4);
+        }
+        int n = bsp_dirty_history_subtract(&history, cut, cut_num, out, SYNC_RECTS);
+        if (n < 0) {
+            continue;
+        }
+        for (int i = 0; i < n; i++) {
+            CHECK(out[i].x1 <= out[i].x2 && out[i].y1 <= out[i].y2, "empty rectangle left");
+            mark(map, W, &out[i], 8);
+        }
+
+        int lost = 0, wrong = 0;
+        for (int i = 0; i < W * H; i++) {
+            lost += (map[i] & 1) && !(map[i] & 2);
+            bool want = (map[i] & 2) && !(map[i] & 4);
+            wrong += want != !!(map[i] & 8);
+        }
+        CHECK(lost == 0, "iteration %d: %d pixels added are not in the history", iter, lost);
+        CHECK(wrong == 0, "iteration %d: %d pixels wrong after the subtraction", iter, wrong);
+    }
+
+    /* Too small an output is reported */
+    bsp_dirty_history_clear(&history);
+    bsp_dirty_rect_t full = { 0, 0, W - 1, H - 1 };
+    bsp_dirty_history_add(&history, &full);
+    cut[0] = (bsp_dirty_rect_t) { 10, 10, 20, 20 };
+    CHECK(bsp_dirty_history_subtract(&history, cut, 1, out, 3) == -1, "overflow not reported");
+    CHECK(bsp_dirty_history_subtract(&history, cut, 1, out, 4) == 4, "a hole is not 4 rectangles");
+}
+
+/* Frame buffers of the simulation hold the number of the frame which drew each pixel */
+typedef struct {
+    uint32_t *fb[2];
+    bsp_dirty_history_t history[2];
+    uint32_t *truth;            /* what LVGL has drawn so far */
+    int cur;                    /* frame buffer LVGL draws into */
+    uint32_t frame;
+    uint64_t copied;            /* pixels copied between frame buffers */
+    uint64_t copied_prev;       /* the same with the previous scheme */
+    uint64_t redrawn_prev;      /* pixels drawn again by LVGL with the previous scheme */
+    int fallbacks;
+    bool prev_full;
+} sim_t;
+
+static void sim_fill(uint32_t *buf, const bsp_dirty_rect_t *r, uint32_t value)
+{
+    for (int y = r->y1; y <= r->y2; y++) {
+        for (int x = r->x1; x <= r->x2; x++) {
+            buf[y * PANEL_H_RES + x] = value;
+        }
+    }
+}
+
+static void sim_copy(uint32_t *dst, const uint32_t *src, const bsp_dirty_rect_t *r)
+{
+    for (int y = r->y1; y <= r->y2; y++) {
+        memcpy(dst + y * PANEL_H_RES + r->x1, src + y * PANEL_H_RES + r->x1, (r->x2 - r->x1 + 1) * sizeof(uint32_t));
+    }
+}
+
+static uint32_t rect_pixels(const bsp_dirty_rect_t *r)
+{
+    return (uint32_t)(r->x2 - r->x1 + 1) * (r->y2 - r->y1 + 1);
+}
+
+/* One frame of direct mode, as flush_callback() */
+static void sim_frame(sim_t *sim, const bsp_dirty_rect_t *dirty, int dirty_num)
+{
+    static bsp_dirty_rect_t rects[SYNC_RECTS];
+    uint32_t *cur = sim->fb[sim->cur];
+    uint32_t *other = sim->fb[!sim->cur];
+    uint32_t dirty_pixels = 0;
+    bool full = false;
+
+    sim->frame++;
+    for (int i = 0; i < dirty_num; i++) {
+        sim_fill(cur, &dirty[i], sim->frame);
+        sim_fill(sim->truth, &dirty[i], sim->frame);
+        dirty_pixels += rect_pixels(&dirty[i]);
+        full |= rect_pixels(&dirty[i]) == PANEL_PIXELS;
+    }
+
+    int n = bsp_dirty_history_subtract(&sim->history[sim->cur], dirty, dirty_num, rects, SYNC_RECTS);
+    if (n < 0) {
+        /* LVGL draws the whole screen again */
+        memcpy(cur, sim->truth, PANEL_PIXELS * sizeof(uint32_t));
+        sim->fallbacks++;
+    } else {
+        for (int i = 0; i < n; i++) {
+            sim_copy(cur, other, &rects[i]);
+            sim->copied += rect_pixels(&rects[i]);
+        }
+    }
+    CHECK(memcmp(cur, sim->truth, PANEL_PIXELS * sizeof(uint32_t)) == 0, "frame %u shown differs from what LVGL drew", sim->frame);
+
+    bsp_dirty_history_clear(&sim->history[sim->cur]);
+    for (int i = 0; i < dirty_num; i++) {
+        bsp_dirty_history_add(&sim->history[!sim->cur], &dirty[i]);
+    }
+    sim->cur = !sim->cur;
+
+    /* flush_copy_probe(): part copy, skip after a full frame, or draw everything again after a full frame */
+    if (!sim->prev_full) {
+        sim->copied_prev += dirty_pixels;
+    } else if (!full) {
+        sim->redrawn_prev += PANEL_PIXELS;
+        sim->copied_prev += dirty_pixels;
+    }
+    sim->prev_full = full;
+}
+
+typedef void (*scenario_t)(sim_t *sim, int frame);
+
+static void scenario_spinner(sim_t *sim, int frame)
+{
+    (void)frame;
+    bsp_dirty_rect_t r = { 350, 190, 449, 289 };
+    sim_frame(sim, &r, 1);
+}
+
+static void scenario_sprite(sim_t *sim, int frame)
+{
+    int x = (frame * 6) % (PANEL_H_RES - 64);
+    bsp_dirty_rect_t r = { x, 200, x + 64 + 5, 263 };     /* old and new position, joined by LVGL */
+    sim_frame(sim, &r, 1);
+}
+
+static void scenario_list_clock(sim_t *sim, int frame)
+{
+    bsp_dirty_rect_t r[2] = {
+        { 0, 60, 399, 419 },        /* scrolling list */
+        { 700, 10, 779, 39 },       /* clock */
+    };
+    sim_frame(sim, r, (frame % 10) == 0 ? 2 : 1);
+}
+
+static void scenario_two_widgets(sim_t *sim, int frame)
+{
+    /* Two animations which update in turn */
+    bsp_dirty_rect_t r[2] = {
+        { 40, 40, 239, 239 },
+        { 500, 200, 699, 399 },
+    };
+    sim_frame(sim, &r[frame % 2], 1);
+}
+
+static void scenario_page_change(sim_t *sim, int frame)
+{
+    bsp_dirty_rect_t full = { 0, 0, PANEL_H_RES - 1, PANEL_V_RES - 1 };
+    bsp_dirty_rect_t button = { 300, 380, 499, 439 };
+    if ((frame % 20) == 0) {
+        sim_frame(sim, &full, 1);
+    } else {
+        sim_frame(sim, &button, 1);
+    }
+}
+
+static void scenario_random(sim_t *sim, int frame)
+{
+    (void)frame;
+    bsp_dirty_rect_t r[INV_BUF_SIZE];
+    int n = 1 + rand() % 12;
+    for (int i = 0; i < n; i++) {
+        r[i] = random_rect(PANEL_H_RES, PANEL_V_RES, 1 + rand() % 300);
+    }
+    sim_frame(sim, r, n);
+}
+
+static void run_scenario(const char *name, scenario_t scenario, int frames)
+{
+    sim_t sim = { 0 };
+    bsp_dirty_rect_t full = { 0, 0, PANEL_H_RES - 1, PANEL_V_RES - 1 };
+
+    sim.fb[0] = calloc(PANEL_PIXELS, sizeof(uint32_t));
+    sim.fb[1] = calloc(PANEL_PIXELS, sizeof(uint32_t));
+    sim.truth = calloc(PANEL_PIXELS, sizeof(uint32_t));
+    if (!sim.fb[0] || !sim.fb[1] || !sim.truth) {
+        printf("FAIL: out of memory\n");
+        s_failures++;
+        return;
+    }
+
+    /* The first frame of LVGL is the whole screen */
+    sim_frame(&sim, &full, 1);
+    sim.copied = sim.copied_prev = sim.redrawn_prev = 0;
+    for (int i = 1; i <= frames; i++) {
+        scenario(&sim, i);
+    }
+
+    printf("%-16s %10.0f %10.0f %10.0f %8.2fx %6d\n", name,
+           (double)sim.copied / frames, (double)sim.copied_prev / frames, (double)sim.redrawn_prev / frames,
+           sim.copied ? (double)(sim.copied_prev + sim.redrawn_prev) / sim.copied : 0.0, sim.fallbacks);
+
+    free(sim.fb[0]);
+    free(sim.fb[1]);
+    free(sim.truth);
+}
+
+int main(void)
+{
+    srand(1);
+    test_regions();
+
+    printf("pixels per frame    copied       prev  prev redraw   gain  fallbacks\n");
+    run_scenario("spinner", scenario_spinner, 200);
+    run_scenario("sprite", scenario_sprite, 200);
+    run_scenario("list + clock", scenario_list_clock, 200);
+    run_scenario("two widgets", scenario_two_widgets, 200);
+    run_scenario("page change", scenario_page_change, 200);
+    run_scenario("random", scenario_random, 200);
+
+    if (s_failures) {
+        printf("%d failure(s)\n", s_failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,284 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Frame buffer rotation of the LVGL port (bsp_rotate.c) against the per-pixel rotation it
+ * replaced, kept below as rotate_copy_pixel_ref().
+ *
+ * For 90, 180 and 270 degrees, on the 800x480 panel of the board:
+ * - the whole screen and random areas must rotate to the same pixels as the reference, and
+ *   nothing outside of the area may be written;
+ * - bsp_rotate_area() must give the rectangle the area lands in, so that copying that
+ *   rectangle between two frame buffers equals rotating the area again;
+ * - prints the speed of the whole screen, of a dirty area, and of the dirty area update of
+ *   both frame buffers in direct mode: rotated twice before, rotated once and copied now.
+ *
+ * The times are of the host. On the ESP32-S3 the frame buffers are in PSRAM behind a small
+ * cache, where the gap between reading along rows and writing along columns is larger.
+ *
+ * Usage:
+ *     rotate_bench [-n frames]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bsp_rotate.h"
+
+#define PANEL_H_RES     800
+#define PANEL_V_RES     480
+#define PANEL_PIXELS    (PANEL_H_RES * PANEL_V_RES)
+
+static int s_failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            s_failures++; \
+        } \
+    } while (0)
+
+/* bsp_lvgl_port.c before the tiled rotation, with lv_disp_rot_t as int */
+static void rotate_copy_pixel_ref(const uint16_t *from, uint16_t *to, uint16_t x_start, uint16_t y_start, uint16_t x_end, uint16_t y_end, uint16_t w, uint16_t h, int rotate)
+{
+    int from_index = 0;
+
+    int to_index = 0;
+    int to_index_const = 0;
+
+    switch (rotate) {
+    case 1:
+        to_index_const = (w - x_start - 1) * h;
+        for (int from_y = y_start; from_y < y_end + 1; from_y++) {
+            from_index = from_y * w + x_start;
+            to_index = to_index_const + from_y;
+            for (int from_x = x_start; from_x < x_end + 1; from_x++) {
+                *(to + to_index) = *(from + from_index);
+                from_index += 1;
+                to_index -= h;
+            }
+        }
+        break;
+    case 2:
+        to_index_const = h * w - x_start - 1;
+        for (int from_y = y_start; from_y < y_end + 1; from_y++) {
+            from_index = from_y * w + x_start;
+            to_index = to_index_const - from_y * w;
+            for (int from_x = x_start; from_x < x_end + 1; from_x++) {
+                *(to + to_index) = *(from + from_index);
+                from_index += 1;
+                to_index -= 1;
+            }
+        }
+        break;
+    case 3:
+        to_index_const = (x_start + 1) * h - 1;
+        for (int from_y = y_start; from_y < y_end + 1; from_y++) {
+            from_index = from_y * w + x_start;
+            to_index = to_index_const - from_y;
+            for (int from_x = x_start; from_x < x_end + 1; from_x++) {
+                *(to + to_index) = *(from + from_index);
+                from_index += 1;
+                to_index += h;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static uint16_t *s_src;
+static uint16_t *s_noise;
+static uint16_t *s_ref;
+static uint16_t *s_out;
+static uint16_t *s_sync;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void fill_noise(uint16_t *buf, int n)
+{
+    for (int i = 0; i < n; i++) {
+        buf[i] = rand() & 0xffff;
+    }
+}
+
+/* LVGL draws in the rotated orientation: w x h is the size of the source */
+static void lvgl_size(int rotate, uint16_t *w, uint16_t *h)
+{
+    *w = (rotate == BSP_ROTATE_180) ? PANEL_H_RES : PANEL_V_RES;
+    *h = (rotate == BSP_ROTATE_180) ? PANEL_V_RES : PANEL_H_RES;
+}
+
+/* Copy a rectangle between two frame buffers of the panel, as flush_dirty_sync() */
+static void copy_rect(uint16_t *dst, const uint16_t *src, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, int stride)
+{
+    for (int y = y1; y <= y2; y++) {
+        memcpy(dst + y * stride + x1, src + y * stride + x1, (x2 - x1 + 1) * sizeof(uint16_t));
+    }
+}
+
+static void check_area(int rotate, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
+{
+    uint16_t w, h;
+    lvgl_size(rotate, &w, &h);
+    int stride = (rotate == BSP_ROTATE_180) ? w : h;
+
+    memcpy(s_ref, s_noise, PANEL_PIXELS * sizeof(uint16_t));
+    memcpy(s_out, s_noise, PANEL_PIXELS * sizeof(uint16_t));
+    rotate_copy_pixel_ref(s_src, s_ref, x1, y1, x2, y2, w, h, rotate);
+    bsp_rotate_copy_pixel(s_src, s_out, x1, y1, x2, y2, w, h, rotate);
+    CHECK(memcmp(s_ref, s_out, PANEL_PIXELS * sizeof(uint16_t)) == 0,
+          "rotate %d, area (%d,%d)-(%d,%d): differs from the reference", rotate * 90, x1, y1, x2, y2);
+
+    uint16_t dx1 = x1, dy1 = y1, dx2 = x2, dy2 = y2;
+    bsp_rotate_area(&dx1, &dy1, &dx2, &dy2, w, h, rotate);
+    CHECK((dx2 - dx1 + 1) * (dy2 - dy1 + 1) == (x2 - x1 + 1) * (y2 - y1 + 1),
+          "rotate %d, area (%d,%d)-(%d,%d): rotated to (%d,%d)-(%d,%d) of another size", rotate * 90, x1, y1, x2, y2, dx1, dy1, dx2, dy2);
+    memcpy(s_sync, s_noise, PANEL_PIXELS * sizeof(uint16_t));
+    copy_rect(s_sync, s_ref, dx1, dy1, dx2, dy2, stride);
+    CHECK(memcmp(s_ref, s_sync, PANEL_PIXELS * sizeof(uint16_t)) == 0,
+          "rotate %d, area (%d,%d)-(%d,%d): rotated to (%d,%d)-(%d,%d), which misses pixels", rotate * 90, x1, y1, x2, y2, dx1, dy1, dx2, dy2);
+}
+
+static void check_rotate(int rotate)
+{
+    uint16_t w, h;
+    lvgl_size(rotate, &w, &h);
+
+    check_area(rotate, 0, 0, w - 1, h - 1);
+    check_area(rotate, 0, 0, 0, 0);
+    check_area(rotate, w - 1, h - 1, w - 1, h - 1);
+    check_area(rotate, 1, 1, w - 2, h - 2);
+    check_area(rotate, 0, 5, w - 1, 5);
+    check_area(rotate, 7, 0, 7, h - 1);
+    for (int i = 0; i < 200; i++) {
+        uint16_t x1 = rand() % w, x2 = rand() % w;
+        uint16_t y1 = rand() % h, y2 = rand() % h;
+        if (x1 > x2) {
+            uint16_t t = x1;
+            x1 = x2;
+            x2 = t;
+        }
+        if (y1 > y2) {
+            uint16_t t = y1;
+            y1 = y2;
+            y2 = t;
+        }
+        check_area(rotate, x1, y1, x2, y2);
+    }
+}
+
+/* Mpix/s of the reference and of bsp_rotate_copy_pixel() for an area, and of a dirty area update of two frame buffers */
+static void bench_area(int rotate, const char *name, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, int frames)
+{
+    uint16_t w, h;
+    lvgl_size(rotate, &w, &h);
+    int stride = (rotate == BSP_ROTATE_180) ? w : h;
+    double pixels = (double)(x2 - x1 + 1) * (y2 - y1 + 1) * frames;
+    uint16_t dx1 = x1, dy1 = y1, dx2 = x2, dy2 = y2;
+    bsp_rotate_area(&dx1, &dy1, &dx2, &dy2, w, h, rotate);
+
+    double t0 = now_s();
+    for (int i = 0; i < frames; i++) {
+        rotate_copy_pixel_ref(s_src, s_ref, x1, y1, x2, y2, w, h, rotate);
+    }
+    double t_ref = now_s() - t0;
+
+    t0 = now_s();
+    for (int i = 0; i < frames; i++) {
+        bsp_rotate_copy_pixel(s_src, s_out, x1, y1, x2, y2, w, h, rotate);
+    }
+    double t_new = now_s() - t0;
+
+    /* Both frame buffers: the reference rotated the area into each */
+    t0 = now_s();
+    for (int i = 0; i < frames; i++) {
+        rotate_copy_pixel_ref(s_src, s_ref, x1, y1, x2, y2, w, h, rotate);
+        rotate_copy_pixel_ref(s_src, s_sync, x1, y1, x2, y2, w, h, rotate);
+    }
+    double t_ref2 = now_s() - t0;
+
+    t0 = now_s();
+    for (int i = 0; i < frames; i++) {
+        bsp_rotate_copy_pixel(s_src, s_out, x1, y1, x2, y2, w, h, rotate);
+        copy_rect(s_sync, s_out, dx1, dy1, dx2, dy2, stride);
+    }
+    double t_new2 = now_s() - t0;
+
+    printf("%4d  %-22s %8.1f %8.1f %6.2fx   %8.1f %8.1f %6.2fx\n", rotate * 90, name,
+           pixels / t_ref / 1e6, pixels / t_new / 1e6, t_ref / t_new,
+           pixels / t_ref2 / 1e6, pixels / t_new2 / 1e6, t_ref2 / t_new2);
+}
+
+int main(int argc, char **argv)
+{
+    int frames = 50;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+        case 'n':
+            frames = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n frames]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (frames < 1) {
+        frames = 1;
+    }
+
+    s_src = malloc(PANEL_PIXELS * sizeof(uint16_t));
+    s_noise = malloc(PANEL_PIXELS * sizeof(uint16_t));
+    s_ref = malloc(PANEL_PIXELS * sizeof(uint16_t));
+    s_out = malloc(PANEL_PIXELS * sizeof(uint16_t));
+    s_sync = malloc(PANEL_PIXELS * sizeof(uint16_t));
+    if (!s_src || !s_noise || !s_ref || !s_out || !s_sync) {
+        printf("FAIL: out of memory\n");
+        return 1;
+    }
+    srand(1);
+    fill_noise(s_src, PANEL_PIXELS);
+    fill_noise(s_noise, PANEL_PIXELS);
+
+    for (int rotate = BSP_ROTATE_90; rotate <= BSP_ROTATE_270; rotate++) {
+        check_rotate(rotate);
+    }
+
+    printf("%d frames, Mpix/s        one frame buffer                  dirty area of both frame buffers\n", frames);
+    printf("rot   area                        ref    tiled  speedup        ref  rot+cpy  speedup\n");
+    for (int rotate = BSP_ROTATE_90; rotate <= BSP_ROTATE_270; rotate++) {
+        uint16_t w, h;
+        lvgl_size(rotate, &w, &h);
+        bench_area(rotate, "full screen", 0, 0, w - 1, h - 1, frames);
+        bench_area(rotate, "dirty 200x120", 61, 203, 260, 322, frames * 10);
+        bench_area(rotate, "dirty 37x19 (odd)", 3, 11, 39, 29, frames * 100);
+    }
+
+    free(s_src);
+    free(s_noise);
+    free(s_ref);
+    free(s_out);
+    free(s_sync);
+
+    if (s_failures) {
+        printf("%d failure(s)\n", s_failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BSP_DIRTY_HISTORY_RECTS     (32)    /*!< Rectangles kept by a history before the closest ones are merged */
+
+/**
+ * @brief Rectangle of a frame buffer, coordinates are inclusive as `lv_area_t`
+ */
+typedef struct {
+    int16_t x1;
+    int16_t y1;
+    int16_t x2;
+    int16_t y2;
+} bsp_dirty_rect_t;
+
+/**
+ * @brief Regions of the screen changed since a frame buffer was last shown
+ */
+typedef struct {
+    uint16_t num;
+    bsp_dirty_rect_t rects[BSP_DIRTY_HISTORY_RECTS];
+} bsp_dirty_history_t;
+
+/**
+ * @brief Forget all changes, the frame buffer is up to date
+ */
+void bsp_dirty_history_clear(bsp_dirty_history_t *history);
+
+/**
+ * @brief Add a changed rectangle
+ *
+ * @note Rectangles inside another one are dropped. When the history is full, the new rectangle is merged with the one
+ *       whose bounding box grows the least, so the history may cover more than what changed, never less.
+ */
+void bsp_dirty_history_add(bsp_dirty_history_t *history, const bsp_dirty_rect_t *rect);
+
+/**
+ * @brief Get the regions of a history which are not covered by some rectangles
+ *
+ * @param[in] history: History
+ * @param[in] cut: Rectangles to remove, e.g. the ones drawn again
+ * @param[in] cut_num: Number of rectangles in `cut`
+ * @param[out] out: Rectangles left, they do not overlap any of `cut`
+ * @param[in] out_max: Size of `out`
+ *
+ * @return
+ *      - Number of rectangles in `out`
+ *      - -1 if `out` is too small
+ */
+int bsp_dirty_history_subtract(const bsp_dirty_history_t *history, const bsp_dirty_rect_t *cut, int cut_num,
+                               bsp_dirty_rect_t *out, int out_max);
+
+#ifdef __cplusplus
+}
+#endif
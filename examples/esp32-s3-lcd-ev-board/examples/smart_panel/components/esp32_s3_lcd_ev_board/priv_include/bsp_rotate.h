@@ -0,0 +1,59 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Rotation of a frame buffer, same values as `lv_disp_rot_t` and `CONFIG_BSP_DISPLAY_LVGL_ROTATION_DEGREE`
+ */
+typedef enum {
+    BSP_ROTATE_0 = 0,
+    BSP_ROTATE_90,
+    BSP_ROTATE_180,
+    BSP_ROTATE_270,
+} bsp_rotate_t;
+
+/**
+ * @brief Rotate an area of a RGB565 frame buffer into another one
+ *
+ * @note The area is copied in tiles, so that both the pixels read and the pixels written stay in a few cache lines
+ *       even when the frame buffers are in PSRAM.
+ *
+ * @param[in] from: Source frame buffer, `w` x `h`
+ * @param[out] to: Destination frame buffer, `h` x `w` for 90 and 270 degrees, `w` x `h` for 180 degrees
+ * @param[in] x_start: First column of the area in the source
+ * @param[in] y_start: First row of the area in the source
+ * @param[in] x_end: Last column of the area in the source, inclusive
+ * @param[in] y_end: Last row of the area in the source, inclusive
+ * @param[in] w: Width of the source
+ * @param[in] h: Height of the source
+ * @param[in] rotate: Clockwise rotation
+ */
+void bsp_rotate_copy_pixel(const uint16_t *from, uint16_t *to, uint16_t x_start, uint16_t y_start, uint16_t x_end, uint16_t y_end,
+                           uint16_t w, uint16_t h, bsp_rotate_t rotate);
+
+/**
+ * @brief Get where an area of the source lands in the destination of `bsp_rotate_copy_pixel()`
+ *
+ * @param[in,out] x_start: First column, of the source on input, of the destination on output
+ * @param[in,out] y_start: First row
+ * @param[in,out] x_end: Last column, inclusive
+ * @param[in,out] y_end: Last row, inclusive
+ * @param[in] w: Width of the source
+ * @param[in] h: Height of the source
+ * @param[in] rotate: Clockwise rotation
+ */
+void bsp_rotate_area(uint16_t *x_start, uint16_t *y_start, uint16_t *x_end, uint16_t *y_end, uint16_t w, uint16_t h, bsp_rotate_t rotate);
+
+#ifdef __cplusplus
+}
+#endif
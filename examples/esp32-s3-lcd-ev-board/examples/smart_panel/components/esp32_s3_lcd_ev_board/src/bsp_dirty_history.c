@@ -0,0 +1,139 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bsp_dirty_history.h"
+
+#define MIN(a, b)   ((a) < (b) ? (a) : (b))
+#define MAX(a, b)   ((a) > (b) ? (a) : (b))
+
+static inline uint32_t rect_size(const bsp_dirty_rect_t *rect)
+{
+    return (uint32_t)(rect->x2 - rect->x1 + 1) * (rect->y2 - rect->y1 + 1);
+}
+
+static inline bool rect_is_in(const bsp_dirty_rect_t *in, const bsp_dirty_rect_t *holder)
+{
+    return in->x1 >= holder->x1 && in->y1 >= holder->y1 && in->x2 <= holder->x2 && in->y2 <= holder->y2;
+}
+
+static inline bool rect_is_on(const bsp_dirty_rect_t *a, const bsp_dirty_rect_t *b)
+{
+    return a->x1 <= b->x2 && b->x1 <= a->x2 && a->y1 <= b->y2 && b->y1 <= a->y2;
+}
+
+static inline void rect_join(bsp_dirty_rect_t *res, const bsp_dirty_rect_t *a, const bsp_dirty_rect_t *b)
+{
+    res->x1 = MIN(a->x1, b->x1);
+    res->y1 = MIN(a->y1, b->y1);
+    res->x2 = MAX(a->x2, b->x2);
+    res->y2 = MAX(a->y2, b->y2);
+}
+
+void bsp_dirty_history_clear(bsp_dirty_history_t *history)
+{
+    history->num = 0;
+}
+
+void bsp_dirty_history_add(bsp_dirty_history_t *history, const bsp_dirty_rect_t *rect)
+{
+    bsp_dirty_rect_t joined;
+    int i = 0;
+
+    while (i < history->num) {
+        if (rect_is_in(rect, &history->rects[i])) {
+            return;
+        }
+        if (rect_is_in(&history->rects[i], rect)) {
+            history->rects[i] = history->rects[--history->num];
+        } else {
+            i++;
+        }
+    }
+
+    if (history->num < BSP_DIRTY_HISTORY_RECTS) {
+        history->rects[history->num++] = *rect;
+        return;
+    }
+
+    /* Full, merge with the rectangle whose bounding box grows the least */
+    int best = 0;
+    uint32_t best_cost = UINT32_MAX;
+    for (i = 0; i < history->num; i++) {
+        rect_join(&joined, rect, &history->rects[i]);
+        uint32_t cost = rect_size(&joined) - rect_size(&history->rects[i]);
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = i;
+        }
+    }
+    rect_join(&joined, rect, &history->rects[best]);
+    history->rects[best] = history->rects[--history->num];
+    /* The bounding box may now hold other rectangles */
+    bsp_dirty_history_add(history, &joined);
+}
+
+/* Split `rect` around its intersection with `cut`: full width bands above and below, then left and right */
+static int rect_split(const bsp_dirty_rect_t *rect, const bsp_dirty_rect_t *cut, bsp_dirty_rect_t piece[4])
+{
+    int16_t y1 = MAX(rect->y1, cut->y1);
+    int16_t y2 = MIN(rect->y2, cut->y2);
+    int n = 0;
+
+    if (rect->y1 < y1) {
+        piece[n++] = (bsp_dirty_rect_t) { rect->x1, rect->y1, rect->x2, y1 - 1 };
+    }
+    if (rect->y2 > y2) {
+        piece[n++] = (bsp_dirty_rect_t) { rect->x1, y2 + 1, rect->x2, rect->y2 };
+    }
+    if (rect->x1 < cut->x1) {
+        piece[n++] = (bsp_dirty_rect_t) { rect->x1, y1, cut->x1 - 1, y2 };
+    }
+    if (rect->x2 > cut->x2) {
+        piece[n++] = (bsp_dirty_rect_t) { cut->x2 + 1, y1, rect->x2, y2 };
+    }
+    return n;
+}
+
+int bsp_dirty_history_subtract(const bsp_dirty_history_t *history, const bsp_dirty_rect_t *cut, int cut_num,
+                               bsp_dirty_rect_t *out, int out_max)
+{
+    bsp_dirty_rect_t piece[4];
+    int count = history->num;
+
+    if (count > out_max) {
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        out[i] = history->rects[i];
+    }
+
+    for (int c = 0; c < cut_num; c++) {
+        /* out[0, end) are checked against this cut, out[end, count) are pieces of it which don't overlap it */
+        int end = count;
+        int i = 0;
+        while (i < end) {
+            if (!rect_is_on(&out[i], &cut[c])) {
+                i++;
+                continue;
+            }
+            int n = rect_split(&out[i], &cut[c], piece);
+            out[i] = out[end - 1];
+            out[end - 1] = out[count - 1];
+            end--;
+            count--;
+            if (count + n > out_max) {
+                return -1;
+            }
+            for (int j = 0; j < n; j++) {
+                out[count++] = piece[j];
+            }
+        }
+    }
+    return count;
+}
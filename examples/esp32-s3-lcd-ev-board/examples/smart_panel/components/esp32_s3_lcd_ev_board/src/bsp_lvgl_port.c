@@ -17,6 +17,8 @@
 #include "bsp_err_check.h"
 #include "bsp/display.h"
 #include "bsp/esp32_s3_lcd_ev_board.h"
+#include "bsp_dirty_history.h"
+#include "bsp_rotate.h"
 
 static const char *TAG = "bsp_lvgl_port";
 static SemaphoreHandle_t lvgl_mux;                  // LVGL mutex
@@ -35,56 +37,6 @@ static void *get_next_frame_buffer(esp_lcd_panel_handle_t panel_handle)
     }
     return next_fb;
 }
-
-IRAM_ATTR static void rotate_copy_pixel(const uint16_t *from, uint16_t *to, uint16_t x_start, uint16_t y_start, uint16_t x_end, uint16_t y_end, uint16_t w, uint16_t h, lv_disp_rot_t rotate)
-{
-    int from_index = 0;
-
-    int to_bytes_per_line;
-    int to_index = 0;
-    int to_index_const = 0;
-
-    switch (rotate) {
-    case LV_DISP_ROT_90:
-        to_index_const = (w - x_start - 1) * h;
-        for (int from_y = y_start; from_y < y_end + 1; from_y++) {
-            from_index = from_y * w + x_start;
-            to_index = to_index_const + from_y;
-            for (int from_x = x_start; from_x < x_end + 1; from_x++) {
-                *(to + to_index) = *(from + from_index);
-                from_index += 1;
-                to_index -= h;
-            }
-        }
-        break;
-    case LV_DISP_ROT_180:
-        to_index_const = h * w - x_start - 1;
-        for (int from_y = y_start; from_y < y_end + 1; from_y++) {
-            from_index = from_y * w + x_start;
-            to_index = to_index_const - from_y * w;
-            for (int from_x = x_start; from_x < x_end + 1; from_x++) {
-                *(to + to_index) = *(from + from_index);
-                from_index += 1;
-                to_index -= 1;
-            }
-        }
-        break;
-    case LV_DISP_ROT_270:
-        to_index_const = (x_start + 1) * h - 1;
-        for (int from_y = y_start; from_y < y_end + 1; from_y++) {
-            from_index = from_y * w + x_start;
-            to_index = to_index_const - from_y;
-            for (int from_x = x_start; from_x < x_end + 1; from_x++) {
-                *(to + to_index) = *(from + from_index);
-                from_index += 1;
-                to_index += h;
-            }
-        }
-        break;
-    default:
-        break;
-    }
-}
 #endif /* CONFIG_BSP_DISPLAY_LVGL_ROTATION_DEGREE */
 
 #if CONFIG_BSP_DISPLAY_LVGL_AVOID_TEAR
@@ -107,64 +59,120 @@ static void flush_dirty_save(lv_port_dirty_area_t *dirty_area)
     }
 }
 
-typedef enum {
-    FLUSH_STATUS_PART,
-    FLUSH_STATUS_FULL
-} lv_port_flush_status_t;
+/**
+ * Each frame buffer keeps the regions of the screen which changed since it was last shown. Before a frame buffer
+ * is shown, only these regions are copied into it from the frame buffer on the screen, less the ones LVGL has just
+ * drawn. While an animation redraws the same area, nothing is copied at all.
+ */
+#define FLUSH_HISTORY_BUF_NUMS      (2)
+#define FLUSH_SYNC_RECTS            (LV_INV_BUF_SIZE * 4)
+
+typedef struct {
+    void *buf;                      // NULL until the frame buffer is first used
+    bsp_dirty_history_t history;    // Changed since `buf` was last shown
+} lv_port_buf_history_t;
+
+static lv_port_buf_history_t buf_history[FLUSH_HISTORY_BUF_NUMS];
+static bsp_dirty_rect_t sync_cut[LV_INV_BUF_SIZE];
+static bsp_dirty_rect_t sync_rects[FLUSH_SYNC_RECTS];
+
+static bsp_dirty_history_t *flush_history_get(void *buf)
+{
+    for (int i = 0; i < FLUSH_HISTORY_BUF_NUMS; i++) {
+        if (buf_history[i].buf == buf) {
+            return &buf_history[i].history;
+        }
+    }
+    /* Histories of the frame buffers not used yet have been kept up to date as well */
+    for (int i = 0; i < FLUSH_HISTORY_BUF_NUMS; i++) {
+        if (buf_history[i].buf == NULL) {
+            buf_history[i].buf = buf;
+            return &buf_history[i].history;
+        }
+    }
+    return NULL;
+}
 
-typedef enum {
-    FLUSH_PROBE_PART_COPY,
-    FLUSH_PROBE_SKIP_COPY,
-    FLUSH_PROBE_FULL_COPY,
-} lv_port_flush_probe_t;
+/**
+ * @brief Record a frame buffer as shown with the dirty area of its frame
+ *
+ */
+static void flush_history_update(void *shown_buf, lv_port_dirty_area_t *dirty_area)
+{
+    bsp_dirty_rect_t rect;
+    bsp_dirty_history_clear(flush_history_get(shown_buf));
+    for (int i = 0; i < FLUSH_HISTORY_BUF_NUMS; i++) {
+        if (buf_history[i].buf == shown_buf) {
+            continue;
+        }
+        for (int j = 0; j < dirty_area->inv_p; j++) {
+            if (dirty_area->inv_area_joined[j] == 0) {
+                rect = (bsp_dirty_rect_t) {
+                    dirty_area->inv_areas[j].x1, dirty_area->inv_areas[j].y1, dirty_area->inv_areas[j].x2, dirty_area->inv_areas[j].y2
+                };
+                bsp_dirty_history_add(&buf_history[i].history, &rect);
+            }
+        }
+    }
+}
 
 /**
- * @brief Probe dirty area to copy
+ * @brief Bring a frame buffer up to date from the one on the screen, except for the dirty area drawn into it
  *
  * @note This function is used to avoid tearing effect, and only work with LVGL direct-mode.
+ *       The frame buffers are in the orientation of the panel, the dirty area and the history in the one of LVGL.
+ *
+ * @return false if the regions to copy are too fragmented, nothing has been copied
  *
  */
-static lv_port_flush_probe_t flush_copy_probe(lv_disp_drv_t *drv)
+static bool flush_history_sync(void *dst, const void *src, lv_port_dirty_area_t *dirty_area)
 {
-    static lv_port_flush_status_t prev_status = FLUSH_PROBE_PART_COPY;
-    lv_port_flush_status_t cur_status;
-    uint8_t probe_result;
-    lv_disp_t *disp_refr = _lv_refr_get_disp_refreshing();
-
-    uint32_t flush_ver = 0;
-    uint32_t flush_hor = 0;
-    for (int i = 0; i < disp_refr->inv_p; i++) {
-        if (disp_refr->inv_area_joined[i] == 0) {
-            flush_ver = (disp_refr->inv_areas[i].y2 + 1 - disp_refr->inv_areas[i].y1);
-            flush_hor = (disp_refr->inv_areas[i].x2 + 1 - disp_refr->inv_areas[i].x1);
-            break;
+    const int fb_hor_res = (CONFIG_BSP_DISPLAY_LVGL_ROTATION_DEGREE % 2) ? LV_VER_RES : LV_HOR_RES;
+    bsp_dirty_history_t *history = flush_history_get(dst);
+    uint16_t x_start, x_end, y_start, y_end;
+    int cut_num = 0;
+    int rect_num;
+
+    if ((history == NULL) || (src == NULL)) {
+        return false;
+    }
+    if (history->num == 0) {
+        return true;
+    }
+    for (int i = 0; i < dirty_area->inv_p; i++) {
+        if (dirty_area->inv_area_joined[i] == 0) {
+            sync_cut[cut_num++] = (bsp_dirty_rect_t) {
+                dirty_area->inv_areas[i].x1, dirty_area->inv_areas[i].y1, dirty_area->inv_areas[i].x2, dirty_area->inv_areas[i].y2
+            };
         }
     }
-    /* Check if the current full screen refreshes */
-    cur_status = ((flush_ver == drv->ver_res) && (flush_hor == drv->hor_res)) ? (FLUSH_STATUS_FULL) : (FLUSH_STATUS_PART);
+    rect_num = bsp_dirty_history_subtract(history, sync_cut, cut_num, sync_rects, FLUSH_SYNC_RECTS);
+    if (rect_num < 0) {
+        return false;
+    }
 
-    if (prev_status == FLUSH_STATUS_FULL) {
-        if ((cur_status == FLUSH_STATUS_PART)) {
-            probe_result = FLUSH_PROBE_FULL_COPY;
-        } else {
-            probe_result = FLUSH_PROBE_SKIP_COPY;
+    for (int i = 0; i < rect_num; i++) {
+        x_start = sync_rects[i].x1;
+        x_end = sync_rects[i].x2;
+        y_start = sync_rects[i].y1;
+        y_end = sync_rects[i].y2;
+        bsp_rotate_area(&x_start, &y_start, &x_end, &y_end, LV_HOR_RES, LV_VER_RES, CONFIG_BSP_DISPLAY_LVGL_ROTATION_DEGREE);
+
+        size_t copy_bytes_per_line = (x_end - x_start + 1) * sizeof(lv_color_t);
+        size_t offset = (y_start * fb_hor_res + x_start) * sizeof(lv_color_t);
+        for (int y = y_start; y <= y_end; y++) {
+            memcpy((uint8_t *)dst + offset, (const uint8_t *)src + offset, copy_bytes_per_line);
+            offset += fb_hor_res * sizeof(lv_color_t);
         }
-    } else {
-        probe_result = FLUSH_PROBE_PART_COPY;
     }
-    prev_status = cur_status;
-
-    return probe_result;
+    return true;
 }
 
 #if CONFIG_BSP_DISPLAY_LVGL_ROTATION_DEGREE != 0
-static inline void *flush_get_next_buf(void *panel_handle)
-{
-    return get_next_frame_buffer(panel_handle);
-}
+static void *flush_shown_fb = NULL;
 
 /**
- * @brief Copy dirty area
+ * @brief Rotate and copy areas from LVGL's buffer into a frame buffer
  *
  * @note This function is used to avoid tearing effect, and only work with LVGL direct-mode.
  *
@@ -180,11 +188,27 @@ static void flush_dirty_copy(void *dst, void *src, lv_port_dirty_area_t *dirty_a
             y_start = dirty_area->inv_areas[i].y1;
             y_end = dirty_area->inv_areas[i].y2;
 
-            rotate_copy_pixel(src, dst, x_start, y_start, x_end, y_end, LV_HOR_RES, LV_VER_RES, CONFIG_BSP_DISPLAY_LVGL_ROTATION_DEGREE);
+            bsp_rotate_copy_pixel(src, dst, x_start, y_start, x_end, y_end, LV_HOR_RES, LV_VER_RES, CONFIG_BSP_DISPLAY_LVGL_ROTATION_DEGREE);
         }
     }
 }
 
+/**
+ * @brief Rotate and copy the whole history of a frame buffer from LVGL's buffer, which is always up to date
+ *
+ */
+static void flush_history_copy(void *dst, void *src)
+{
+    bsp_dirty_history_t *history = flush_history_get(dst);
+    if (history == NULL) {
+        return;
+    }
+    for (int i = 0; i < history->num; i++) {
+        bsp_rotate_copy_pixel(src, dst, history->rects[i].x1, history->rects[i].y1, history->rects[i].x2, history->rects[i].y2,
+                              LV_HOR_RES, LV_VER_RES, CONFIG_BSP_DISPLAY_LVGL_ROTATION_DEGREE);
+    }
+}
+
 static void flush_callback(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
 {
     esp_lcd_panel_handle_t panel_handle = (esp_lcd_panel_handle_t) drv->user_data;
@@ -193,64 +217,28 @@ static void flush_callback(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t
     const int offsety1 = area->y1;
     const int offsety2 = area->y2;
     void *next_fb = NULL;
-    lv_port_flush_probe_t probe_result = FLUSH_PROBE_PART_COPY;
 
     /* Action after last area refresh */
     if (lv_disp_flush_is_last(drv)) {
-        /* Check if the `full_refresh` flag has been triggered */
-        if (drv->full_refresh) {
-            /* Reset flag */
-            drv->full_refresh = 0;
-
-            // Roate and copy data from the whole screen LVGL's buffer to the next frame buffer
-            next_fb = flush_get_next_buf(panel_handle);
-            rotate_copy_pixel((uint16_t *)color_map, next_fb, offsetx1, offsety1, offsetx2, offsety2, LV_HOR_RES, LV_VER_RES, CONFIG_BSP_DISPLAY_LVGL_ROTATION_DEGREE);
-
-            /* Switch the current RGB frame buffer to `next_fb` */
-            esp_lcd_panel_draw_bitmap(panel_handle, offsetx1, offsety1, offsetx2 + 1, offsety2 + 1, next_fb);
-
-            /* Waiting for the current frame buffer to complete transmission */
-            ulTaskNotifyValueClear(NULL, ULONG_MAX);
-            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-
-            /* Synchronously update the dirty area for another frame buffer */
-            flush_dirty_copy(flush_get_next_buf(panel_handle), color_map, &dirty_area);
-            flush_get_next_buf(panel_handle);
-        } else {
-            /* Probe the copy method for the current dirty area */
-            probe_result = flush_copy_probe(drv);
-
-            if (probe_result == FLUSH_PROBE_FULL_COPY) {
-                /* Save current dirty area for next frame buffer */
-                flush_dirty_save(&dirty_area);
-
-                /* Set LVGL full-refresh flag and set flush ready in advance */
-                drv->full_refresh = 1;
-                lv_disp_flush_ready(drv);
-
-                /* Force to refresh whole screen, and will invoke `flush_callback` recursively */
-                lv_refr_now(_lv_refr_get_disp_refreshing());
-            } else {
-                /* Update current dirty area for next frame buffer */
-                next_fb = flush_get_next_buf(panel_handle);
-                flush_dirty_save(&dirty_area);
-                flush_dirty_copy(next_fb, color_map, &dirty_area);
+        /* Rotate and copy the dirty area from the LVGL's buffer to the next frame buffer */
+        next_fb = get_next_frame_buffer(panel_handle);
+        flush_dirty_save(&dirty_area);
+        flush_dirty_copy(next_fb, color_map, &dirty_area);
+
+        /* Bring the rest of the next frame buffer up to date from the current one, rotate it again if too fragmented */
+        if (!flush_history_sync(next_fb, flush_shown_fb, &dirty_area)) {
+            flush_history_copy(next_fb, color_map);
+        }
 
-                /* Switch the current RGB frame buffer to `next_fb` */
-                esp_lcd_panel_draw_bitmap(panel_handle, offsetx1, offsety1, offsetx2 + 1, offsety2 + 1, next_fb);
+        /* Switch the current RGB frame buffer to `next_fb` */
+        esp_lcd_panel_draw_bitmap(panel_handle, offsetx1, offsety1, offsetx2 + 1, offsety2 + 1, next_fb);
 
-                /* Waiting for the current frame buffer to complete transmission */
-                ulTaskNotifyValueClear(NULL, ULONG_MAX);
-                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        /* Waiting for the current frame buffer to complete transmission */
+        ulTaskNotifyValueClear(NULL, ULONG_MAX);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-                if (probe_result == FLUSH_PROBE_PART_COPY) {
-                    /* Synchronously update the dirty area for another frame buffer */
-                    flush_dirty_save(&dirty_area);
-                    flush_dirty_copy(flush_get_next_buf(panel_handle), color_map, &dirty_area);
-                    flush_get_next_buf(panel_handle);
-                }
-            }
-        }
+        flush_history_update(next_fb, &dirty_area);
+        flush_shown_fb = next_fb;
     }
 
     lv_disp_flush_ready(drv);
@@ -263,39 +251,6 @@ static inline void *flush_get_next_buf(void *buf)
     return (buf == draw_buf->buf1) ? draw_buf->buf2 : draw_buf->buf1;
 }
 
-/**
- * @brief Copy dirty area
- *
- * @note This function is used to avoid tearing effect, and only work with LVGL direct-mode.
- *
- */
-static void flush_dirty_copy(void *dst, void *src, lv_port_dirty_area_t *dirty_area)
-{
-    lv_coord_t x_start, x_end, y_start, y_end;
-    uint32_t copy_bytes_per_line;
-    uint32_t h_res = LV_HOR_RES;
-    uint32_t bytes_per_line = h_res * 2;
-    uint8_t *from, *to;
-    for (int i = 0; i < dirty_area->inv_p; i++) {
-        /* Refresh the unjoined areas*/
-        if (dirty_area->inv_area_joined[i] == 0) {
-            x_start = dirty_area->inv_areas[i].x1;
-            x_end = dirty_area->inv_areas[i].x2 + 1;
-            y_start = dirty_area->inv_areas[i].y1;
-            y_end = dirty_area->inv_areas[i].y2 + 1;
-
-            copy_bytes_per_line = (x_end - x_start) * 2;
-            from = src + (y_start * h_res + x_start) * 2;
-            to = dst + (y_start * h_res + x_start) * 2;
-            for (int y = y_start; y < y_end; y++) {
-                memcpy(to, from, copy_bytes_per_line);
-                from += bytes_per_line;
-                to += bytes_per_line;
-            }
-        }
-    }
-}
-
 static void flush_callback(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
 {
     esp_lcd_panel_handle_t panel_handle = (esp_lcd_panel_handle_t) drv->user_data;
@@ -304,7 +259,6 @@ static void flush_callback(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t
     const int offsety1 = area->y1;
     const int offsety2 = area->y2;
 
-    lv_port_flush_probe_t probe_result;
     /* Action after last area refresh */
     if (lv_disp_flush_is_last(drv)) {
         /* Check if the `full_refresh` flag has been triggered */
@@ -319,18 +273,14 @@ static void flush_callback(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t
             ulTaskNotifyValueClear(NULL, ULONG_MAX);
             ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-            /* Synchronously update the dirty area for another frame buffer */
-            flush_dirty_copy(flush_get_next_buf(color_map), color_map, &dirty_area);
+            /* The whole screen has been drawn, but only the saved dirty area has changed */
+            flush_history_update(color_map, &dirty_area);
             drv->draw_buf->buf_act = (color_map == drv->draw_buf->buf1) ? drv->draw_buf->buf2 : drv->draw_buf->buf1;
         } else {
-            /* Probe the copy method for the current dirty area */
-            probe_result = flush_copy_probe(drv);
-
-            if (probe_result == FLUSH_PROBE_FULL_COPY) {
-                /* Save current dirty area for next frame buffer */
-                flush_dirty_save(&dirty_area);
-
-                /* Set LVGL full-refresh flag and set flush ready in advance */
+            /* Bring the rest of `color_map` up to date from the frame buffer on the screen */
+            flush_dirty_save(&dirty_area);
+            if (!flush_history_sync(color_map, flush_get_next_buf(color_map), &dirty_area)) {
+                /* Too fragmented, set LVGL full-refresh flag and set flush ready in advance */
                 drv->full_refresh = 1;
                 lv_disp_flush_ready(drv);
 
@@ -344,11 +294,7 @@ static void flush_callback(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t
                 ulTaskNotifyValueClear(NULL, ULONG_MAX);
                 ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-                if (probe_result == FLUSH_PROBE_PART_COPY) {
-                    /* Synchronously update the dirty area for another frame buffer */
-                    flush_dirty_save(&dirty_area);
-                    flush_dirty_copy(flush_get_next_buf(color_map), color_map, &dirty_area);
-                }
+                flush_history_update(color_map, &dirty_area);
             }
         }
     }
@@ -397,7 +343,7 @@ void flush_callback(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color
     void *next_fb = get_next_frame_buffer(panel_handle);
 
     /* Rotate and copy dirty area from the current LVGL's buffer to the next RGB frame buffer */
-    rotate_copy_pixel((uint16_t *)color_map, next_fb, offsetx1, offsety1, offsetx2, offsety2, LV_HOR_RES, LV_VER_RES, CONFIG_BSP_DISPLAY_LVGL_ROTATION_DEGREE);
+    bsp_rotate_copy_pixel((uint16_t *)color_map, next_fb, offsetx1, offsety1, offsetx2, offsety2, LV_HOR_RES, LV_VER_RES, CONFIG_BSP_DISPLAY_LVGL_ROTATION_DEGREE);
 
     /* Switch the current RGB frame buffer to `next_fb` */
     esp_lcd_panel_draw_bitmap(panel_handle, offsetx1, offsety1, offsetx2 + 1, offsety2 + 1, next_fb);
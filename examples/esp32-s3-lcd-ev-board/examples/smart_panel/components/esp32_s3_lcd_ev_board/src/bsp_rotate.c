@@ -0,0 +1,107 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdint.h>
+
+#include "esp_attr.h"
+#include "bsp_rotate.h"
+
+/**
+ * Pixels are copied tile by tile: the rows of a tile are read from the source and the
+ * columns are written to the destination, so a tile touches 32 cache lines on each side
+ * instead of one line per pixel written. Inside a tile, a destination row is written
+ * two pixels at a time.
+ */
+#define ROTATE_TILE     (32)
+
+typedef uint32_t __attribute__((__may_alias__)) rotate_pair_t;
+
+/* to[i] = from[i * step], for a run of contiguous destination pixels */
+IRAM_ATTR static inline void rotate_run(const uint16_t *from, int step, uint16_t *to, int n)
+{
+    int i = 0;
+    if (((uintptr_t)to & 2) && n > 0) {
+        to[0] = from[0];
+        i = 1;
+    }
+    for (; i + 1 < n; i += 2) {
+        *(rotate_pair_t *)(to + i) = from[i * step] | ((uint32_t)from[(i + 1) * step] << 16);
+    }
+    if (i < n) {
+        to[i] = from[i * step];
+    }
+}
+
+IRAM_ATTR void bsp_rotate_copy_pixel(const uint16_t *from, uint16_t *to, uint16_t x_start, uint16_t y_start, uint16_t x_end, uint16_t y_end,
+                                     uint16_t w, uint16_t h, bsp_rotate_t rotate)
+{
+    switch (rotate) {
+    case BSP_ROTATE_90:
+        /* (x, y) goes to row w - 1 - x, column y, of a destination h wide */
+        for (int ty = y_start; ty <= y_end; ty += ROTATE_TILE) {
+            int n = (y_end + 1 - ty) < ROTATE_TILE ? (y_end + 1 - ty) : ROTATE_TILE;
+            for (int tx = x_start; tx <= x_end; tx += ROTATE_TILE) {
+                int tx_end = (tx + ROTATE_TILE - 1) < x_end ? (tx + ROTATE_TILE - 1) : x_end;
+                for (int x = tx; x <= tx_end; x++) {
+                    rotate_run(from + ty * w + x, w, to + (w - 1 - x) * h + ty, n);
+                }
+            }
+        }
+        break;
+    case BSP_ROTATE_180:
+        /* rows are reversed, both sides are read and written in sequence already */
+        for (int y = y_start; y <= y_end; y++) {
+            const uint16_t *src = from + y * w + x_end;
+            uint16_t *dst = to + (h - 1 - y) * w + (w - 1 - x_end);
+            for (int i = 0; i <= x_end - x_start; i++) {
+                dst[i] = src[-i];
+            }
+        }
+        break;
+    case BSP_ROTATE_270:
+        /* (x, y) goes to row x, column h - 1 - y, of a destination h wide */
+        for (int ty = y_start; ty <= y_end; ty += ROTATE_TILE) {
+            int ty_end = (ty + ROTATE_TILE - 1) < y_end ? (ty + ROTATE_TILE - 1) : y_end;
+            int n = ty_end + 1 - ty;
+            for (int tx = x_start; tx <= x_end; tx += ROTATE_TILE) {
+                int tx_end = (tx + ROTATE_TILE - 1) < x_end ? (tx + ROTATE_TILE - 1) : x_end;
+                for (int x = tx; x <= tx_end; x++) {
+                    rotate_run(from + ty_end * w + x, -w, to + x * h + (h - 1 - ty_end), n);
+                }
+            }
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void bsp_rotate_area(uint16_t *x_start, uint16_t *y_start, uint16_t *x_end, uint16_t *y_end, uint16_t w, uint16_t h, bsp_rotate_t rotate)
+{
+    uint16_t x1 = *x_start, y1 = *y_start, x2 = *x_end, y2 = *y_end;
+    switch (rotate) {
+    case BSP_ROTATE_90:
+        *x_start = y1;
+        *x_end = y2;
+        *y_start = w - 1 - x2;
+        *y_end = w - 1 - x1;
+        break;
+    case BSP_ROTATE_180:
+        *x_start = w - 1 - x2;
+        *x_end = w - 1 - x1;
+        *y_start = h - 1 - y2;
+        *y_end = h - 1 - y1;
+        break;
+    case BSP_ROTATE_270:
+        *x_start = h - 1 - y2;
+        *x_end = h - 1 - y1;
+        *y_start = x1;
+        *y_end = x2;
+        break;
+    default:
+        break;
+    }
+}
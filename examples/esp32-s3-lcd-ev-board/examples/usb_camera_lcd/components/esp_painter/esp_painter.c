@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: CC0-1.0
  */
 
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -13,6 +14,21 @@
 
 #include "esp_painter.h"
 
+/**
+ * Characters are drawn from a glyph cache: each glyph is expanded once to the pixel format
+ * of the panel for its font, color and background, and the characters of a line are
+ * copied side by side into a span buffer that is sent with one esp_lcd_panel_draw_bitmap.
+ * With a transparent background, only the runs of lit pixels of each line of the text
+ * are sent, one call per run.
+ */
+typedef struct {
+    const esp_painter_basic_font_t *font;
+    uint32_t color;
+    char c;
+    uint8_t *pixels;            /*!< font->width * font->height pixels, NULL if the slot is empty */
+    size_t size;                /*!< bytes allocated */
+} esp_painter_glyph_t;
+
 typedef struct {
     struct {
         uint32_t color;
@@ -28,11 +44,15 @@ typedef struct {
     uint8_t piexl_color_byte;
     const esp_painter_basic_font_t *default_font;
     esp_lcd_panel_handle_t lcd_panel;
+    esp_painter_glyph_t glyphs[CONFIG_ESP_PAINTER_GLYPH_CACHE_SIZE];
+    uint8_t *span;
+    size_t span_size;           /*!< bytes allocated */
 } esp_painter_t;
 
 static const char *TAG = "esp_painter";
 
-static esp_err_t draw_point(esp_painter_handle_t handle, uint16_t x, uint16_t y, uint32_t color);
+static esp_err_t draw_span(esp_painter_t *painter, uint16_t x, uint16_t y, const esp_painter_basic_font_t *font, uint32_t color,
+                           const char *text, int len);
 
 esp_err_t esp_painter_new(esp_painter_config_t *config, esp_painter_handle_t *handle)
 {
@@ -45,7 +65,7 @@ esp_err_t esp_painter_new(esp_painter_config_t *config, esp_painter_handle_t *ha
         ESP_ERR_INVALID_ARG, TAG, "Canvas color out of range"
     );
     ESP_RETURN_ON_FALSE(config->lcd_panel, ESP_ERR_INVALID_ARG, TAG, "Lcd panel must be inited");
-    esp_painter_t *painter = (esp_painter_t *)malloc(sizeof(esp_painter_t));
+    esp_painter_t *painter = (esp_painter_t *)calloc(1, sizeof(esp_painter_t));
     ESP_RETURN_ON_FALSE(painter, ESP_ERR_NO_MEM, TAG, "Malloc failed");
 
     painter->brush.color = config->brush.color;
@@ -63,6 +83,65 @@ esp_err_t esp_painter_new(esp_painter_config_t *config, esp_painter_handle_t *ha
     return ESP_OK;
 }
 
+esp_err_t esp_painter_del(esp_painter_handle_t handle)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG, "Invalid handle");
+    esp_painter_t *painter = (esp_painter_t *)handle;
+
+    for (int i = 0; i < CONFIG_ESP_PAINTER_GLYPH_CACHE_SIZE; i++) {
+        free(painter->glyphs[i].pixels);
+    }
+    free(painter->span);
+    free(painter);
+    return ESP_OK;
+}
+
+static inline void put_pixel(uint8_t *dst, uint32_t color, uint8_t bytes)
+{
+    /* the panel takes the color in the byte order of the CPU, little-endian */
+    for (int i = 0; i < bytes; i++) {
+        dst[i] = color >> (8 * i);
+    }
+}
+
+/* the glyph of a character in the pixel format of the panel, expanded on the first use, NULL if out of memory */
+static const uint8_t *glyph_get(esp_painter_t *painter, const esp_painter_basic_font_t *font, uint32_t color, char c)
+{
+    uint32_t hash = ((uint32_t)(uintptr_t)font >> 2) * 31 + (uint8_t)c;
+    hash = hash * 31 + color;
+    hash ^= hash >> 16;
+    esp_painter_glyph_t *glyph = &painter->glyphs[hash % CONFIG_ESP_PAINTER_GLYPH_CACHE_SIZE];
+
+    if (glyph->pixels && glyph->font == font && glyph->color == color && glyph->c == c) {
+        return glyph->pixels;
+    }
+
+    uint8_t bytes = painter->piexl_color_byte;
+    size_t size = font->width * font->height * bytes;
+    if (glyph->size < size) {
+        free(glyph->pixels);
+        glyph->pixels = malloc(size);
+        glyph->size = glyph->pixels ? size : 0;
+        if (!glyph->pixels) {
+            return NULL;
+        }
+    }
+
+    /* each line of the glyph takes whole bytes, MSB first */
+    uint16_t line_bytes = (font->width + 7) / 8;
+    const uint8_t *p_c = &font->bitmap[(c - ' ') * font->height * line_bytes];
+    uint8_t *out = glyph->pixels;
+    for (int j = 0; j < font->height; j++, p_c += line_bytes) {
+        for (int i = 0; i < font->width; i++, out += bytes) {
+            put_pixel(out, (p_c[i / 8] & (0x80 >> (i % 8))) ? color : painter->canvas.color, bytes);
+        }
+    }
+    glyph->font = font;
+    glyph->color = color;
+    glyph->c = c;
+    return glyph->pixels;
+}
+
 esp_err_t esp_painter_draw_char(esp_painter_handle_t handle, uint16_t x, uint16_t y, const esp_painter_basic_font_t *font, uint32_t color, char c)
 {
     ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG, "Invalid handle");
@@ -71,35 +150,10 @@ esp_err_t esp_painter_draw_char(esp_painter_handle_t handle, uint16_t x, uint16_
     font = (font) ? font : painter->default_font;
     ESP_RETURN_ON_FALSE(font->bitmap && font->width > 0 && font->height > 0, ESP_ERR_INVALID_ARG, TAG, "Font format error");
     ESP_RETURN_ON_FALSE(c >= ' ' && c <= '~', ESP_ERR_INVALID_ARG, TAG, "Invalid ASCII character");
-    x += painter->canvas.x_min;
-    y += painter->canvas.y_min;
-    ESP_RETURN_ON_FALSE(x <= painter->canvas.x_max && y <= painter->canvas.y_max, ESP_ERR_INVALID_ARG, TAG, "Invalid x(%d) or y(%d) (out of canvas)", x, y);
     color = (color == COLOR_BRUSH_DEFAULT) ? painter->brush.color : color;
     ESP_RETURN_ON_FALSE(color < BIT(painter->piexl_color_byte * 8), ESP_ERR_INVALID_ARG, TAG, "Brush color out of range");
 
-    uint16_t font_w = font->width;
-    uint16_t c_size = font->height * ((font->width + 7) / 8);
-    uint16_t c_offset = (c - ' ') * c_size;
-    const uint8_t *p_c = &font->bitmap[c_offset];
-    uint16_t x0 = x;
-    uint8_t temp;
-    for (int i = 0; i < c_size; i++) {
-        temp = p_c[i];
-        for (int j = 0; j < 8; j++) {
-            if (temp & 0x80) {
-                ESP_RETURN_ON_FALSE(y <= painter->canvas.y_max, ESP_ERR_INVALID_SIZE, TAG, "Y out of canvas");
-                ESP_RETURN_ON_ERROR(draw_point(handle, x, y, color), TAG, "Draw pixel error");
-            }
-            temp <<= 1;
-            x++;
-            if (x == x0 + font_w) {
-                x = x0;
-                y++;
-                break;
-            }
-        }
-    }
-    return ESP_OK;
+    return draw_span(painter, x, y, font, color, &c, 1);
 }
 
 esp_err_t esp_painter_draw_string(esp_painter_handle_t handle, uint16_t x, uint16_t y, const esp_painter_basic_font_t* font, uint32_t color, const char* text)
@@ -108,28 +162,47 @@ esp_err_t esp_painter_draw_string(esp_painter_handle_t handle, uint16_t x, uint1
     esp_painter_t *painter = (esp_painter_t *)handle;
     ESP_RETURN_ON_FALSE(font || painter->default_font, ESP_ERR_INVALID_ARG, TAG, "Invalid font");
     font = (font) ? font : painter->default_font;
+    ESP_RETURN_ON_FALSE(font->bitmap && font->width > 0 && font->height > 0, ESP_ERR_INVALID_ARG, TAG, "Font format error");
+    color = (color == COLOR_BRUSH_DEFAULT) ? painter->brush.color : color;
+    ESP_RETURN_ON_FALSE(color < BIT(painter->piexl_color_byte * 8), ESP_ERR_INVALID_ARG, TAG, "Brush color out of range");
 
     uint16_t font_w = font->width;
     uint16_t font_h = font->height;
     uint16_t x0 = x;
+    /* characters up to the end of a line are drawn together */
+    const char *run = text;
+    uint16_t run_x = x;
+    uint16_t run_y = y;
     while (*text != 0) {
         if (*text == '\n') {
+            ESP_RETURN_ON_ERROR(draw_span(painter, run_x, run_y, font, color, run, text - run), TAG, "Draw string failed");
             y += font_h;
             x = x0;
+            run = text + 1;
+            run_x = x + font_w;
+            run_y = y;
         } else {
-            ESP_RETURN_ON_FALSE(y + font_h - 1 <= painter->canvas.y_max, ESP_ERR_INVALID_SIZE, TAG, "Text out ouf canvas");
-            ESP_RETURN_ON_ERROR(esp_painter_draw_char(handle, x, y, font, color, *text), TAG, "Draw char failed");
+            if (*text < ' ' || *text > '~' || y + font_h - 1 > painter->canvas.y_max) {
+                /* what comes before is still drawn */
+                ESP_RETURN_ON_ERROR(draw_span(painter, run_x, run_y, font, color, run, text - run), TAG, "Draw string failed");
+                ESP_RETURN_ON_FALSE(y + font_h - 1 <= painter->canvas.y_max, ESP_ERR_INVALID_SIZE, TAG, "Text out ouf canvas");
+                ESP_LOGE(TAG, "Invalid ASCII character");
+                return ESP_ERR_INVALID_ARG;
+            }
         }
         x += font_w;
+        text++;
         if (x + font_w > painter->canvas.x_max - painter->canvas.x_min + 1) {
+            ESP_RETURN_ON_ERROR(draw_span(painter, run_x, run_y, font, color, run, text - run), TAG, "Draw string failed");
             y += font_h;
             x = x0;
+            run = text;
+            run_x = x;
+            run_y = y;
         }
-        text++;
     }
-    return ESP_OK;
+    return draw_span(painter, run_x, run_y, font, color, run, text - run);
 }
-
 esp_err_t esp_painter_draw_string_format(esp_painter_handle_t handle, uint16_t x, uint16_t y, const esp_painter_basic_font_t* font, uint32_t color, const char* fmt, ...)
 {
     char buffer[CONFIG_ESP_PAINTER_FORMAT_SIZE_MAX];
@@ -144,7 +217,71 @@ esp_err_t esp_painter_draw_string_format(esp_painter_handle_t handle, uint16_t x
     return ESP_OK;
 }
 
-static esp_err_t draw_point(esp_painter_handle_t handle, uint16_t x, uint16_t y, uint32_t color)
+static esp_err_t draw_span(esp_painter_t *painter, uint16_t x, uint16_t y, const esp_painter_basic_font_t *font, uint32_t color,
+                           const char *text, int len)
 {
-    return esp_lcd_panel_draw_bitmap((esp_lcd_panel_handle_t)((esp_painter_t *)handle)->lcd_panel, x, y, x + 1, y + 1, &color);
+    if (len <= 0) {
+        return ESP_OK;
+    }
+    x += painter->canvas.x_min;
+    y += painter->canvas.y_min;
+    ESP_RETURN_ON_FALSE(x <= painter->canvas.x_max && y <= painter->canvas.y_max, ESP_ERR_INVALID_ARG, TAG, "Invalid x(%d) or y(%d) (out of canvas)", x, y);
+    /* the lines below the canvas are not drawn, then reported */
+    int h = y + font->height - 1 <= painter->canvas.y_max ? font->height : painter->canvas.y_max - y + 1;
+
+    uint8_t bytes = painter->piexl_color_byte;
+    uint16_t font_w = font->width;
+    int w = len * font_w;
+    if (x + w - 1 > painter->canvas.x_max) {
+        w = painter->canvas.x_max - x + 1;
+    }
+    size_t line_size = len * font_w * bytes;
+    size_t size = painter->canvas.is_trans_background ? line_size : line_size * font->height;
+    if (painter->span_size < size) {
+        free(painter->span);
+        painter->span = malloc(size);
+        painter->span_size = painter->span ? size : 0;
+        ESP_RETURN_ON_FALSE(painter->span, ESP_ERR_NO_MEM, TAG, "Malloc failed");
+    }
+
+    if (painter->canvas.is_trans_background) {
+        /* the span holds one line of the brush color, sent for each run of lit pixels */
+        for (int i = 0; i < len * font_w; i++) {
+            put_pixel(painter->span + i * bytes, color, bytes);
+        }
+        uint16_t line_bytes = (font_w + 7) / 8;
+        for (int j = 0; j < h; j++) {
+            int run_start = -1;
+            for (int i = 0; i <= w; i++) {
+                bool lit = false;
+                if (i < w) {
+                    const uint8_t *p_c = &font->bitmap[((text[i / font_w] - ' ') * font->height + j) * line_bytes];
+                    lit = p_c[(i % font_w) / 8] & (0x80 >> ((i % font_w) % 8));
+                }
+                if (lit && run_start < 0) {
+                    run_start = i;
+                } else if (!lit && run_start >= 0) {
+                    ESP_RETURN_ON_ERROR(esp_lcd_panel_draw_bitmap(painter->lcd_panel, x + run_start, y + j, x + i, y + j + 1, painter->span),
+                                        TAG, "Draw bitmap error");
+                    run_start = -1;
+                }
+            }
+        }
+    } else {
+        /* glyphs side by side, then one transfer for the whole line, clipped to the canvas */
+        for (int k = 0; k < len; k++) {
+            const uint8_t *glyph = glyph_get(painter, font, color, text[k]);
+            ESP_RETURN_ON_FALSE(glyph, ESP_ERR_NO_MEM, TAG, "Malloc failed");
+            int glyph_w = w - k * font_w < font_w ? w - k * font_w : font_w;
+            if (glyph_w <= 0) {
+                break;
+            }
+            for (int j = 0; j < h; j++) {
+                memcpy(painter->span + (j * w + k * font_w) * bytes, glyph + j * font_w * bytes, glyph_w * bytes);
+            }
+        }
+        ESP_RETURN_ON_ERROR(esp_lcd_panel_draw_bitmap(painter->lcd_panel, x, y, x + w, y + h, painter->span), TAG, "Draw bitmap error");
+    }
+    ESP_RETURN_ON_FALSE(h == font->height, ESP_ERR_INVALID_SIZE, TAG, "Y out of canvas");
+    return ESP_OK;
 }
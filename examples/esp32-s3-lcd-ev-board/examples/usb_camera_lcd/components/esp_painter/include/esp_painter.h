@@ -70,6 +70,16 @@ typedef struct {
 
 esp_err_t esp_painter_new(esp_painter_config_t *config, esp_painter_handle_t *handle);
 
+/**
+ * @brief Free a painter and its cached glyphs
+ */
+esp_err_t esp_painter_del(esp_painter_handle_t handle);
+
+/*
+ * Text is drawn on the canvas color, one esp_lcd_panel_draw_bitmap per line. With a
+ * COLOR_CANVAS_TRANS_BG canvas, only the lit pixels are drawn, one call per run of pixels.
+ */
+
 esp_err_t esp_painter_draw_char(esp_painter_handle_t handle, uint16_t x, uint16_t y, const esp_painter_basic_font_t *font, uint32_t color, char c);
 
 esp_err_t esp_painter_draw_string(esp_painter_handle_t handle, uint16_t x, uint16_t y, const esp_painter_basic_font_t* font, uint32_t color, const char* text);
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: CC0-1.0
  */
 
+#include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
@@ -11,6 +12,7 @@
 #include "esp_event.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "esp_heap_caps.h"
 #include "esp_lcd_panel_ops.h"
 #include "esp_lcd_panel_rgb.h"
 #include "esp_jpeg_dec.h"
@@ -31,11 +33,40 @@
 #include "app_wifi.h"
 #include "app_httpd.h"
 #include "esp_camera.h"
+#endif
+
+/* JPEG frames in flight: one decoding, one sent over Wi-Fi, one being received */
+#define EXAMPLE_CAMERA_FRAME_NUMS          (3)
+#define EXAMPLE_DECODE_TASK_PRIORITY       (5)
+#define EXAMPLE_DECODE_TASK_STACK_SIZE     (4 * 1024)
+#define EXAMPLE_DECODE_TASK_CORE           (1)
 
-static SemaphoreHandle_t sem_usb_done = NULL;
-static SemaphoreHandle_t sem_xfer_done = NULL;
-static camera_fb_t s_fb = {0};
-static bool xfer_connect = false;
+/**
+ * A JPEG frame of the camera. The USB callback only copies the frame into a free one and publishes it,
+ * the decoder task and the HTTP server take the latest published frame when they are ready for one.
+ * Frames nobody took in time are dropped, so a slow consumer never holds up the USB or the others.
+ */
+typedef struct {
+#if ENABLE_UVC_WIFI_XFER
+    camera_fb_t fb;             // Handed to the HTTP server, must be the first member
+#endif
+    uint8_t *buf;
+    size_t len;
+    uint16_t width;
+    uint16_t height;
+    uint32_t sequence;
+    uint8_t ref;                // Number of slots and consumers holding the frame
+} camera_frame_t;
+
+static camera_frame_t camera_frames[EXAMPLE_CAMERA_FRAME_NUMS];
+static camera_frame_t *lcd_next_frame = NULL;           // Latest frame for the decoder task
+static portMUX_TYPE camera_frame_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t decode_task_handle = NULL;
+static uint32_t camera_frame_drops = 0;
+
+#if ENABLE_UVC_WIFI_XFER
+static camera_frame_t *xfer_next_frame = NULL;          // Latest frame for the HTTP server
+static SemaphoreHandle_t sem_xfer_frame = NULL;
 #endif
 
 static esp_painter_handle_t painter = NULL;
@@ -48,6 +79,7 @@ static const char *TAG = "example_usb_camera_lcd";
 extern esp_lcd_panel_handle_t bsp_lcd_init(void *arg);
 
 static void camera_frame_cb(uvc_frame_t *frame, void *ptr);
+static void camera_decode_task(void *arg);
 
 void app_main(void)
 {
@@ -73,6 +105,7 @@ void app_main(void)
             .y = 0,
             .width = uvc_frame_w,
             .height = uvc_frame_h,
+            .color = COLOR_CANVAS_TRANS_BG,
         },
         .default_font = &esp_painter_basic_font_24,
         .piexl_color_byte = 2,
@@ -80,10 +113,18 @@ void app_main(void)
     };
     ESP_ERROR_CHECK(esp_painter_new(&painter_config, &painter));
 
+    /* Malloc JPEG frames shared by the decoder and the HTTP server */
+    for (int i = 0; i < EXAMPLE_CAMERA_FRAME_NUMS; i++) {
+        camera_frames[i].buf = (uint8_t *)heap_caps_malloc(EXAMPLE_UVC_XFER_BUFFER_SIZE, MALLOC_CAP_SPIRAM);
+        assert(camera_frames[i].buf != NULL);
+    }
+    BaseType_t ret = xTaskCreatePinnedToCore(camera_decode_task, "camera_decode", EXAMPLE_DECODE_TASK_STACK_SIZE, NULL,
+                                             EXAMPLE_DECODE_TASK_PRIORITY, &decode_task_handle, EXAMPLE_DECODE_TASK_CORE);
+    assert(ret == pdPASS);
+
 #if ENABLE_UVC_WIFI_XFER
-    sem_usb_done = xSemaphoreCreateBinary();
-    sem_xfer_done = xSemaphoreCreateBinary();
-    assert(sem_usb_done && sem_xfer_done);
+    sem_xfer_frame = xSemaphoreCreateBinary();
+    assert(sem_xfer_frame);
     app_wifi_main();
     app_httpd_main();
 #endif
@@ -140,71 +181,188 @@ void app_main(void)
 #endif
 }
 
+
+/* Must be called with `camera_frame_lock` held */
+static void camera_frame_release_locked(camera_frame_t *frame)
+{
+    if (frame && frame->ref) {
+        frame->ref--;
+    }
+}
+
+static void camera_frame_release(camera_frame_t *frame)
+{
+    taskENTER_CRITICAL(&camera_frame_lock);
+    camera_frame_release_locked(frame);
+    taskEXIT_CRITICAL(&camera_frame_lock);
+}
+
+/* Take the latest frame of a slot, NULL if there is no new one */
+static camera_frame_t *camera_frame_take(camera_frame_t **slot)
+{
+    taskENTER_CRITICAL(&camera_frame_lock);
+    camera_frame_t *frame = *slot;
+    *slot = NULL;
+    taskEXIT_CRITICAL(&camera_frame_lock);
+    return frame;
+}
+
+/* Get a frame to receive into, dropping the published frames nobody took yet if all are in use */
+static camera_frame_t *camera_frame_get_free(void)
+{
+    camera_frame_t *frame = NULL;
+
+    taskENTER_CRITICAL(&camera_frame_lock);
+    for (int retry = 0; retry < 2 && frame == NULL; retry++) {
+        for (int i = 0; i < EXAMPLE_CAMERA_FRAME_NUMS; i++) {
+            if (camera_frames[i].ref == 0) {
+                frame = &camera_frames[i];
+                break;
+            }
+        }
+        if (frame == NULL) {
+            camera_frame_release_locked(lcd_next_frame);
+            lcd_next_frame = NULL;
+#if ENABLE_UVC_WIFI_XFER
+            camera_frame_release_locked(xfer_next_frame);
+            xfer_next_frame = NULL;
+#endif
+            camera_frame_drops++;
+        }
+    }
+    if (frame) {
+        frame->ref = 1;
+    }
+    taskEXIT_CRITICAL(&camera_frame_lock);
+    return frame;
+}
+
+/* Publish a received frame to the decoder and the HTTP server, replacing the frames they did not take in time */
+static void camera_frame_publish(camera_frame_t *frame)
+{
+    taskENTER_CRITICAL(&camera_frame_lock);
+    if (lcd_next_frame) {
+        camera_frame_release_locked(lcd_next_frame);
+        camera_frame_drops++;
+    }
+    lcd_next_frame = frame;
+#if ENABLE_UVC_WIFI_XFER
+    camera_frame_release_locked(xfer_next_frame);
+    xfer_next_frame = frame;
+    frame->ref++;
+#endif
+    taskEXIT_CRITICAL(&camera_frame_lock);
+
+    xTaskNotifyGive(decode_task_handle);
+#if ENABLE_UVC_WIFI_XFER
+    xSemaphoreGive(sem_xfer_frame);
+#endif
+}
+
 #if ENABLE_UVC_WIFI_XFER
 camera_fb_t* esp_camera_fb_get()
 {
-    xSemaphoreTake(sem_usb_done, portMAX_DELAY);
-    return &s_fb;
+    camera_frame_t *frame = NULL;
+    while (frame == NULL) {
+        xSemaphoreTake(sem_xfer_frame, portMAX_DELAY);
+        frame = camera_frame_take(&xfer_next_frame);
+    }
+    return &frame->fb;
 }
 
 void esp_camera_fb_return(camera_fb_t * fb)
 {
-    xfer_connect = true;
-    xSemaphoreGive(sem_xfer_done);
-    return;
+    camera_frame_release((camera_frame_t *)fb);
 }
 #endif
 
-static int esp_jpeg_decoder_one_picture(uint8_t *input_buf, int len, uint8_t *output_buf)
+/**
+ * The decoder, its io and header info are created once and used for every frame,
+ * `jpeg_dec_parse_header()` sets it up for each new picture.
+ */
+static jpeg_dec_handle_t *jpeg_dec = NULL;
+static jpeg_dec_io_t jpeg_io;
+static jpeg_dec_header_info_t jpeg_out_info;
+
+static esp_err_t esp_jpeg_decoder_init(void)
 {
-    esp_err_t ret = ESP_OK;
-    // Generate default configuration
     jpeg_dec_config_t config = DEFAULT_JPEG_DEC_CONFIG();
-
-    // Empty handle to jpeg_decoder
-    jpeg_dec_handle_t jpeg_dec = NULL;
-
-    // Create jpeg_dec
     jpeg_dec = jpeg_dec_open(&config);
-
-    // Create io_callback handle
-    jpeg_dec_io_t *jpeg_io = calloc(1, sizeof(jpeg_dec_io_t));
-    if (jpeg_io == NULL) {
-        return ESP_FAIL;
+    if (jpeg_dec == NULL) {
+        ESP_LOGE(TAG, "Create jpeg decoder failed");
+        return ESP_ERR_NO_MEM;
     }
+    return ESP_OK;
+}
+
+static int esp_jpeg_decoder_one_picture(uint8_t *input_buf, int len, uint8_t *output_buf, size_t output_size)
+{
+    int ret = 0;
 
-    // Create out_info handle
-    jpeg_dec_header_info_t *out_info = calloc(1, sizeof(jpeg_dec_header_info_t));
-    if (out_info == NULL) {
-        return ESP_FAIL;
-    }
     // Set input buffer and buffer len to io_callback
-    jpeg_io->inbuf = input_buf;
-    jpeg_io->inbuf_len = len;
+    memset(&jpeg_io, 0, sizeof(jpeg_io));
+    jpeg_io.inbuf = input_buf;
+    jpeg_io.inbuf_len = len;
 
     // Parse jpeg picture header and get picture for user and decoder
-    ret = jpeg_dec_parse_header(jpeg_dec, jpeg_io, out_info);
+    ret = jpeg_dec_parse_header(jpeg_dec, &jpeg_io, &jpeg_out_info);
     if (ret < 0) {
-        goto _exit;
+        return ret;
+    }
+    if ((size_t)jpeg_out_info.width * jpeg_out_info.height * 2 > output_size) {
+        ESP_LOGW(TAG, "Picture of %dx%d is larger than the frame buffer", jpeg_out_info.width, jpeg_out_info.height);
+        return JPEG_ERR_PAR;
     }
 
-    jpeg_io->outbuf = output_buf;
-    int inbuf_consumed = jpeg_io->inbuf_len - jpeg_io->inbuf_remain;
-    jpeg_io->inbuf = input_buf + inbuf_consumed;
-    jpeg_io->inbuf_len = jpeg_io->inbuf_remain;
+    jpeg_io.outbuf = output_buf;
+    int inbuf_consumed = jpeg_io.inbuf_len - jpeg_io.inbuf_remain;
+    jpeg_io.inbuf = input_buf + inbuf_consumed;
+    jpeg_io.inbuf_len = jpeg_io.inbuf_remain;
 
     // Start decode jpeg raw data
-    ret = jpeg_dec_process(jpeg_dec, jpeg_io);
-    if (ret < 0) {
-        goto _exit;
-    }
+    return jpeg_dec_process(jpeg_dec, &jpeg_io);
+}
+
+static void camera_decode_task(void *arg)
+{
+    const size_t lcd_frame_size = BSP_LCD_H_RES * BSP_LCD_V_RES * 2;
+    int frame_count = 0;
+    int64_t count_start_time = 0;
+    int fps = 0;
 
-_exit:
-    // Decoder deinitialize
-    jpeg_dec_close(jpeg_dec);
-    free(out_info);
-    free(jpeg_io);
-    return ret;
+    ESP_ERROR_CHECK(esp_jpeg_decoder_init());
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        camera_frame_t *frame = camera_frame_take(&lcd_next_frame);
+        if (frame == NULL) {
+            continue;
+        }
+
+        int ret = esp_jpeg_decoder_one_picture(frame->buf, frame->len, lcd_frame_buf[draw_buf_index], lcd_frame_size);
+        uint16_t width = frame->width;
+        uint16_t height = frame->height;
+        camera_frame_release(frame);
+        if (ret < 0) {
+            ESP_LOGW(TAG, "Decode frame failed (%d)", ret);
+            continue;
+        }
+
+        esp_lcd_panel_draw_bitmap(lcd_panel, 0, 0, width, height, lcd_frame_buf[draw_buf_index]);
+        // Switch to next frame buffer for next drawing
+        draw_buf_index = (draw_buf_index + 1) == CONFIG_BSP_LCD_RGB_BUFFER_NUMS ? 0 : (draw_buf_index + 1);
+        esp_painter_draw_string_format(painter, 0, 0, NULL, COLOR_BRUSH_DEFAULT, "FPS: %d", fps);
+
+        if (count_start_time == 0) {
+            count_start_time = esp_timer_get_time();
+        }
+        if (++frame_count == 20) {
+            frame_count = 0;
+            fps = 20 * 1000000 / (esp_timer_get_time() - count_start_time);
+            count_start_time = esp_timer_get_time();
+            ESP_LOGD(TAG, "lcd fps: %d, frames dropped: %"PRIu32, fps, camera_frame_drops);
+        }
+    }
 }
 
 static void camera_frame_cb(uvc_frame_t *frame, void *ptr)
@@ -212,46 +370,34 @@ static void camera_frame_cb(uvc_frame_t *frame, void *ptr)
     ESP_LOGD(TAG, "uvc callback! frame_format = %d, seq = %"PRIu32", width = %"PRIu32", height = %"PRIu32", length = %u, ptr = %d",
             frame->frame_format, frame->sequence, frame->width, frame->height, frame->data_bytes, (int) ptr);
 
-    static int frame_count = 0;
-    static int64_t count_start_time = 0;
-    static int fps = 0;
-
     switch (frame->frame_format) {
-        case UVC_FRAME_FORMAT_MJPEG:
-#if ENABLE_UVC_WIFI_XFER
-            s_fb.buf = frame->data;
-            s_fb.len = frame->data_bytes;
-            s_fb.width = frame->width;
-            s_fb.height = frame->height;
-            s_fb.format = PIXFORMAT_JPEG;
-            s_fb.timestamp.tv_sec = frame->sequence;
-            xSemaphoreGive(sem_usb_done);
-#endif
-            esp_jpeg_decoder_one_picture((uint8_t *)frame->data, frame->data_bytes, lcd_frame_buf[draw_buf_index]);
-            esp_lcd_panel_draw_bitmap(lcd_panel, 0, 0, frame->width, frame->height, lcd_frame_buf[draw_buf_index]);
-            // Switch to next frame buffer for next drawing
-            draw_buf_index = (draw_buf_index + 1) == CONFIG_BSP_LCD_RGB_BUFFER_NUMS ? 0 : (draw_buf_index + 1);
-            esp_painter_draw_string_format(painter, 0, 0, NULL, COLOR_BRUSH_DEFAULT, "FPS: %d", fps);
-#if ENABLE_UVC_WIFI_XFER
-            if (xfer_connect) {
-                if (xSemaphoreTake(sem_xfer_done, pdMS_TO_TICKS(1000)) == pdFALSE) {
-                    // Xfer is disconnected if timeout, so we don't have to wait next time
-                    xfer_connect = false;
-                }
-            }
-#endif
-
-            if (count_start_time == 0) {
-                count_start_time = esp_timer_get_time();
+        case UVC_FRAME_FORMAT_MJPEG: {
+            if (frame->data_bytes > EXAMPLE_UVC_XFER_BUFFER_SIZE) {
+                ESP_LOGW(TAG, "Frame of %u bytes is too large", frame->data_bytes);
+                break;
             }
-            if (++frame_count == 20) {
-                frame_count = 0;
-                fps = 20 * 1000000 / (esp_timer_get_time() - count_start_time);
-                count_start_time = esp_timer_get_time();
-                ESP_LOGD(TAG, "camera fps: %d", fps);
+            /* Copy the frame out, `frame->data` is reused for the next one as soon as the callback returns */
+            camera_frame_t *cam_frame = camera_frame_get_free();
+            if (cam_frame == NULL) {
+                break;
             }
-            vTaskDelay(pdMS_TO_TICKS(1));
+            memcpy(cam_frame->buf, frame->data, frame->data_bytes);
+            cam_frame->len = frame->data_bytes;
+            cam_frame->width = frame->width;
+            cam_frame->height = frame->height;
+            cam_frame->sequence = frame->sequence;
+#if ENABLE_UVC_WIFI_XFER
+            cam_frame->fb.buf = cam_frame->buf;
+            cam_frame->fb.len = cam_frame->len;
+            cam_frame->fb.width = frame->width;
+            cam_frame->fb.height = frame->height;
+            cam_frame->fb.format = PIXFORMAT_JPEG;
+            cam_frame->fb.timestamp.tv_sec = frame->sequence;
+            cam_frame->fb.timestamp.tv_usec = 0;
+#endif
+            camera_frame_publish(cam_frame);
             break;
+        }
         default:
             ESP_LOGW(TAG, "Format not supported");
             assert(0);
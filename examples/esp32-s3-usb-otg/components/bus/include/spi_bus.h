@@ -38,6 +38,8 @@ typedef struct {
     gpio_num_t cs_io_num; /*!< GPIO pin to select this device (CS), or -1 if not used*/
     uint8_t mode; /*!< modes (0,1,2,3) that correspond to the four possible clocking configurations*/
     int clock_speed_hz; /*!< spi clock speed, divisors of 80MHz, in Hz. See ``SPI_MASTER_FREQ_*`*/
+    int queue_size; /*!< queued transactions the device can hold, 0 for the default of 3*/
+    transaction_cb_t post_cb; /*!< called in the ISR after each transaction, NULL if not used*/
 }spi_device_config_t;
 
 #ifdef __cplusplus
@@ -128,6 +130,35 @@ esp_err_t spi_bus_transfer_bytes(spi_bus_device_handle_t dev_handle, const uint8
  */
 esp_err_t spi_bus_transmit_begin(spi_bus_device_handle_t dev_handle, spi_transaction_t *p_trans);
 
+/**
+ * @brief Queue a transaction, the device sends it while the caller goes on
+ *        @note
+ *        The result of every queued transaction must be fetched with ``spi_bus_transmit_result``,
+ *        and all of them before a polling transfer is sent to the same device.
+ *
+ * @param dev_handle handle for device operation.
+ * @param p_trans Description of transaction to execute, must stay valid until its result is fetched
+ * @param ticks_to_wait Ticks to wait while the queue is full
+ * @return esp_err_t
+ *     - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *     - ESP_ERR_TIMEOUT       if the queue stays full
+ *     - ESP_OK                on success
+ */
+esp_err_t spi_bus_transmit_queue(spi_bus_device_handle_t dev_handle, spi_transaction_t *p_trans, TickType_t ticks_to_wait);
+
+/**
+ * @brief Wait for the oldest queued transaction to complete
+ *
+ * @param dev_handle handle for device operation.
+ * @param p_trans Set to the transaction that completed
+ * @param ticks_to_wait Ticks to wait for it
+ * @return esp_err_t
+ *     - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *     - ESP_ERR_TIMEOUT       if it did not complete in time
+ *     - ESP_OK                on success
+ */
+esp_err_t spi_bus_transmit_result(spi_bus_device_handle_t dev_handle, spi_transaction_t **p_trans, TickType_t ticks_to_wait);
+
 /**
  * @brief Transfer one 16-bit value with the device. using msb by default.
  * For example 0x1234, 0x12 will send first then 0x34.
@@ -116,7 +116,8 @@ spi_bus_device_handle_t spi_bus_device_create(spi_bus_device_handle_t bus_handle
         .mode = device_conf->mode,
         .spics_io_num = device_conf->cs_io_num,
         .cs_ena_posttrans = 3,      //Keep the CS low 3 cycles after transaction, to stop slave from missing the last bit when CS has less propagation delay than CLK
-        .queue_size = 3
+        .queue_size = device_conf->queue_size > 0 ? device_conf->queue_size : 3,
+        .post_cb = device_conf->post_cb,
     };
     esp_err_t ret = spi_bus_add_device(spi_bus->host_id, &devcfg, &spi_dev->handle);
     SPI_BUS_CHECK_GOTO(ESP_OK == ret, "add spi device failed", cleanup_device);
@@ -210,6 +211,25 @@ esp_err_t spi_bus_transmit_begin(spi_bus_device_handle_t dev_handle, spi_transac
     return _spi_device_polling_transmit(dev_handle, p_trans);
 }
 
+esp_err_t spi_bus_transmit_queue(spi_bus_device_handle_t dev_handle, spi_transaction_t *p_trans, TickType_t ticks_to_wait)
+{
+    SPI_BUS_CHECK(NULL != dev_handle && NULL != p_trans, "Pointer error", ESP_ERR_INVALID_ARG);
+    _spi_device_t *spi_dev = (_spi_device_t *)(dev_handle);
+    esp_err_t ret;
+    SPI_DEVICE_MUTEX_TAKE(spi_dev, ESP_FAIL);
+    ret = spi_device_queue_trans(spi_dev->handle, p_trans, ticks_to_wait);
+    SPI_DEVICE_MUTEX_GIVE(spi_dev, ESP_FAIL);
+    return ret;
+}
+
+esp_err_t spi_bus_transmit_result(spi_bus_device_handle_t dev_handle, spi_transaction_t **p_trans, TickType_t ticks_to_wait)
+{
+    SPI_BUS_CHECK(NULL != dev_handle && NULL != p_trans, "Pointer error", ESP_ERR_INVALID_ARG);
+    _spi_device_t *spi_dev = (_spi_device_t *)(dev_handle);
+    /* no mutex, only the task that queued the transactions waits for them */
+    return spi_device_get_trans_result(spi_dev->handle, p_trans, ticks_to_wait);
+}
+
 esp_err_t spi_bus_transfer_reg16(spi_bus_device_handle_t dev_handle, uint16_t data_out, uint16_t *data_in)
 {
     esp_err_t ret;
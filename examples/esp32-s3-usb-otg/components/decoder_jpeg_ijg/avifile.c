@@ -1,204 +1,837 @@
 #include "esp_log.h"
+#include "esp_heap_caps.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
 #include "avifile.h"
 
 static const char *TAG = "avifile";
 
-AVI_TypeDef AVI_file;
-
 #define MAKE_FOURCC(a, b, c, d) ((uint32_t)(d)<<24 | (uint32_t)(c)<<16 | (uint32_t)(b)<<8 | (uint32_t)(a))
-#define READ_WORD(a) ((uint32_t)*(a)<<24 | (uint32_t)*(a)<<16 | (uint32_t)*(a)<<8 | (uint32_t)*(a))
+
+#define idx1_ID     MAKE_FOURCC('i', 'd', 'x', '1')
+#define indx_ID     MAKE_FOURCC('i', 'n', 'd', 'x')
+#define AVIX_ID     MAKE_FOURCC('A', 'V', 'I', 'X')
+
+#define AVIIF_KEYFRAME          0x10        /*!< idx1 flag */
+#define AVI_INDEX_OF_INDEXES    0x00        /*!< OpenDML bIndexType */
+#define AVI_INDEX_OF_CHUNKS     0x01
+
+#define ENTRY_KEYFRAME          0x80000000U /*!< flags kept in the top bits of the entry size */
+#define ENTRY_AUDIO             0x40000000U
+#define ENTRY_SIZE_MASK         0x3FFFFFFFU
+
+#define AVI_MAX_RIFFS           8           /*!< RIFF AVI plus AVIX extensions, 1 GB each */
+#define AVI_MAX_CHUNK_SIZE      (4 * 1024 * 1024)
+#define AVI_MAX_BLOCKS          16          /*!< reads held in the pool at once */
+#define AVI_MAX_BATCH_FRAMES    32          /*!< chunks fetched by one read */
+#define AVI_MAX_GAP             4096        /*!< other chunks up to this size are read through instead of seeked over */
 
 static uint32_t _REV(uint32_t value){
-    return (value & 0x000000FFU) << 24 | (value & 0x0000FF00U) << 8 | 
-        (value & 0x00FF0000U) >> 8 | (value & 0xFF000000U) >> 24; 
+    return (value & 0x000000FFU) << 24 | (value & 0x0000FF00U) << 8 |
+        (value & 0x00FF0000U) >> 8 | (value & 0xFF000000U) >> 24;
 }
 
-static int search_fourcc(uint32_t fourcc, const uint8_t *buffer, uint32_t length)
+/* payload of one chunk of a played stream */
+typedef struct {
+    uint32_t offset;            /*!< file offset of the data, behind the chunk header */
+    uint32_t size;              /*!< data size | ENTRY_xxx flags */
+} avi_entry_t;
+
+/* one read into the pool, holding one or more consecutive chunks */
+typedef struct {
+    uint32_t pool_off;
+    uint32_t pool_len;
+    uint32_t file_off;          /*!< file offset of pool[pool_off] */
+    uint32_t first;             /*!< entries first .. first + count - 1 */
+    uint32_t count;
+    int refs;                   /*!< frames handed out and not released */
+    bool done;                  /*!< no more frames will be handed out of it */
+    bool used;
+} avi_block_t;
+
+struct avi_demux {
+    FILE *file;
+    uint32_t file_size;
+    avi_demux_info_t info;
+    bool audio;
+
+    uint32_t video_scale;       /*!< video frame duration is scale / rate seconds */
+    uint32_t video_rate;
+    uint32_t audio_bytes_per_sec;
+    uint32_t video_indx;        /*!< OpenDML super index data of the played streams, 0 if none */
+    uint32_t video_indx_size;
+    uint32_t audio_indx;
+    uint32_t audio_indx_size;
+    uint32_t movi_start[AVI_MAX_RIFFS]; /*!< offset of the 'movi' FourCC of each RIFF */
+    uint32_t movi_end[AVI_MAX_RIFFS];
+    int movi_count;
+
+    avi_entry_t *entries;       /*!< played chunks in file order */
+    uint32_t entry_count;
+    uint32_t entry_max;
+    uint32_t *video;            /*!< entry of every video frame */
+
+    uint32_t cursor;            /*!< next entry of avi_demux_read */
+    uint32_t cursor_video;      /*!< video frames before the cursor */
+    uint32_t cursor_audio;      /*!< audio chunks before the cursor */
+    uint64_t cursor_audio_bytes;
+    int seq_block;              /*!< block the cursor is in, -1 if none */
+
+    uint8_t *pool;
+    uint32_t pool_size;
+    uint32_t batch_size;        /*!< largest read, small enough that a held block never blocks the next chunk */
+    avi_block_t blocks[AVI_MAX_BLOCKS];
+};
+
+static inline uint16_t get_le16(const uint8_t *p)
 {
-    uint32_t i, j;
-    uint32_t *pdata;
-    j = length - 4;
-    for (i = 0; i < j; i++) {
-        pdata = (uint32_t*)(buffer+i);
-        if (fourcc == *pdata)
-        {
-            return i;
-        }
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static inline uint32_t get_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static inline uint64_t get_le64(const uint8_t *p)
+{
+    return (uint64_t)get_le32(p) | (uint64_t)get_le32(p + 4) << 32;
+}
+
+static bool read_at(avi_demux_handle_t h, uint32_t offset, void *buffer, size_t length)
+{
+    if ((uint64_t)offset + length > h->file_size || fseek(h->file, offset, SEEK_SET) != 0) {
+        return false;
     }
-    return -1;
+    return fread(buffer, 1, length, h->file) == length;
 }
 
-static int Strl_Parser(const uint8_t *buffer, uint32_t length, uint32_t *list_length)
+/* stream number of a chunk id like "01wb", -1 if it is not a stream chunk */
+static int chunk_stream(uint32_t ckid)
 {
-    /**
-     * TODO: how to deal with the list is not complete in the buffer 
-     */
-    const uint8_t *pdata = buffer;
-    // strl(stream list), include "strh" and "strf"
-    AVI_LIST_HEAD *strl = (AVI_LIST_HEAD*)pdata;
-    if (strl->List != LIST_ID || strl->FourCC != strl_ID) {
+    uint8_t c0 = ckid & 0xff, c1 = (ckid >> 8) & 0xff;
+    if (c0 < '0' || c0 > '9' || c1 < '0' || c1 > '9') {
         return -1;
     }
-    pdata += sizeof(AVI_LIST_HEAD);
-    *list_length = strl->size + 8; //return the entire size of list
-
-    // strh
-    AVI_STRH_CHUNK *strh = (AVI_STRH_CHUNK*)pdata;
-    if (strh->FourCC != strh_ID || strh->size+8 != sizeof(AVI_STRH_CHUNK)) {
-        return -5;
-    }
-#ifdef DEBUGINFO
-    printf("-----strh info------\r\n");
-    printf("fourcc_type:0x%x\r\n", strh->fourcc_type);
-    printf("fourcc_codec:0x%x\r\n", strh->fourcc_codec);
-    printf("flags:%d\r\n", strh->flags);
-    printf("Priority:%d\r\n", strh->priority);
-    printf("Language:%d\r\n", strh->language);
-    printf("InitFrames:%d\r\n", strh->init_frames);
-    printf("Scale:%d\r\n", strh->scale);
-    printf("Rate:%d\r\n", strh->rate);
-    printf("Start:%d\r\n", strh->start);
-    printf("Length:%d\r\n", strh->length);
-    printf("RefBufSize:%d\r\n", strh->suggest_buff_size);
-    printf("Quality:%d\r\n", strh->quality);
-    printf("SampleSize:%d\r\n", strh->sample_size);
-    printf("FrameLeft:%d\r\n", strh->rcFrame.left);
-    printf("FrameTop:%d\r\n", strh->rcFrame.top);
-    printf("FrameRight:%d\r\n", strh->rcFrame.right);
-    printf("FrameBottom:%d\r\n\n", strh->rcFrame.bottom);
-#endif
-    pdata += sizeof(AVI_STRH_CHUNK);
-
-    if(vids_ID == strh->fourcc_type) {
-        ESP_LOGI(TAG, "Find a video stream");
-        if (mjpg_ID != strh->fourcc_codec) {
-            ESP_LOGE(TAG, "only support mjpeg decoder, but needed is 0x%x", strh->fourcc_codec);
-            return -1;
-        }
-        AVI_VIDS_STRF_CHUNK *strf = (AVI_VIDS_STRF_CHUNK*)pdata;
-        if (strf->FourCC != strf_ID || strf->size+8 != sizeof(AVI_VIDS_STRF_CHUNK)) {
-            return -5;
-        }
-#ifdef DEBUGINFO
-        printf("-----video strf info------\r\n");
-        printf("本结构体大小:%d\r\n", strf->size1);
-        printf("图像宽:%d\r\n", strf->width);
-        printf("图像高:%d\r\n", strf->height);
-        printf("平面数:%d\r\n", strf->planes);
-        printf("像素位数:%d\r\n", strf->bitcount);
-        printf("压缩类型:0x%x\r\n", strf->fourcc_compression);
-        printf("图像大小:%d\r\n", strf->image_size);
-        printf("水平分辨率:%d\r\n", strf->x_pixels_per_meter);
-        printf("垂直分辨率:%d\r\n", strf->y_pixels_per_meter);
-        printf("使用调色板颜色数:%d\r\n", strf->num_colors);
-        printf("重要颜色:%d\r\n\n", strf->imp_colors);
-#endif
-        AVI_file.vids_fps = strh->rate / strh->scale;
-        AVI_file.vids_width = strf->width;
-        AVI_file.vids_height = strf->height;
-        pdata += sizeof(AVI_VIDS_STRF_CHUNK);
-
-    } else if(auds_ID == strh->fourcc_type) {
-        ESP_LOGI(TAG, "Find a audio stream");
-        AVI_AUDS_STRF_CHUNK *strf = (AVI_AUDS_STRF_CHUNK*)pdata;
-        if (strf->FourCC != strf_ID || (strf->size+8 != sizeof(AVI_AUDS_STRF_CHUNK) && strf->size+10 != sizeof(AVI_AUDS_STRF_CHUNK))) {
-            ESP_LOGE(TAG, "FourCC=0x%x|%x, size=%d|%d", strf->FourCC, strf_ID, strf->size, sizeof(AVI_AUDS_STRF_CHUNK));
-            return -5;
-        }
-#ifdef DEBUGINFO
-        printf("-----audio strf info------\r\n");
-        printf("strf数据块信息(音频流):");
-        printf("格式标志:%d\r\n", strf->format_tag);
-        printf("声道数:%d\r\n", strf->channels);
-        printf("采样率:%d\r\n", strf->samples_per_sec);
-        printf("波特率:%d\r\n", strf->avg_bytes_per_sec);
-        printf("块对齐:%d\r\n", strf->block_align);
-        printf("采样位宽:%d\r\n\n", strf->bits_per_sample);
-#endif
-        AVI_file.auds_channels = strf->channels;
-        AVI_file.auds_sample_rate = strf->samples_per_sec;
-        AVI_file.auds_bits = strf->bits_per_sample;
-        pdata += sizeof(AVI_AUDS_STRF_CHUNK);
+    return (c0 - '0') * 10 + (c1 - '0');
+}
 
+/* ENTRY_xxx type flags of a chunk of a played stream, -1 for chunks that are not played */
+static int chunk_type(avi_demux_handle_t h, uint32_t ckid)
+{
+    int stream = chunk_stream(ckid);
+    uint8_t c2 = (ckid >> 16) & 0xff;
+
+    if (stream < 0) {
+        return -1;
+    }
+    if (stream == h->info.video_stream && c2 == 'd') {
+        return 0;
+    }
+    if (h->audio && stream == h->info.audio_stream && c2 == 'w') {
+        return ENTRY_AUDIO;
+    }
+    return -1;
+}
+
+static esp_err_t index_push(avi_demux_handle_t h, uint32_t offset, uint32_t size, uint32_t flags)
+{
+    if (size > AVI_MAX_CHUNK_SIZE || (uint64_t)offset + size > h->file_size) {
+        ESP_LOGW(TAG, "skip chunk at %" PRIu32 ", size %" PRIu32, offset, size);
+        return ESP_OK;
+    }
+    if (h->entry_count == h->entry_max) {
+        uint32_t max = h->entry_max ? h->entry_max * 2 : 256;
+        avi_entry_t *entries = realloc(h->entries, max * sizeof(avi_entry_t));
+        if (NULL == entries) {
+            return ESP_ERR_NO_MEM;
+        }
+        h->entries = entries;
+        h->entry_max = max;
+    }
+    h->entries[h->entry_count].offset = offset;
+    h->entries[h->entry_count].size = size | flags;
+    h->entry_count++;
+    return ESP_OK;
+}
+
+static bool is_mjpeg(uint32_t fourcc)
+{
+    /* the case of the handler varies between muxers */
+    return (fourcc | 0x20202020) == MAKE_FOURCC('m', 'j', 'p', 'g');
+}
+
+static esp_err_t parse_strl(avi_demux_handle_t h, int stream, uint32_t pos, uint32_t end)
+{
+    uint8_t strh[56] = {0};
+    uint8_t strf[40] = {0};
+    uint32_t strh_size = 0, strf_size = 0, indx = 0, indx_size = 0;
+
+    while (pos + 8 <= end) {
+        uint8_t head[8];
+        if (!read_at(h, pos, head, sizeof(head))) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        uint32_t id = get_le32(head), size = get_le32(head + 4);
+        if (size > end - pos - 8) {
+            ESP_LOGW(TAG, "stream %d: chunk at %" PRIu32 " overruns its list", stream, pos);
+            break;
+        }
+        if (id == strh_ID) {
+            strh_size = size < sizeof(strh) ? size : sizeof(strh);
+            if (!read_at(h, pos + 8, strh, strh_size)) {
+                return ESP_ERR_INVALID_RESPONSE;
+            }
+        } else if (id == strf_ID) {
+            strf_size = size < sizeof(strf) ? size : sizeof(strf);
+            if (!read_at(h, pos + 8, strf, strf_size)) {
+                return ESP_ERR_INVALID_RESPONSE;
+            }
+        } else if (id == indx_ID) {
+            indx = pos + 8;
+            indx_size = size;
+        }
+        pos += 8 + size + (size & 1);
+    }
+
+    if (strh_size < 40) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    uint32_t type = get_le32(strh);
+
+    if (type == vids_ID && h->info.video_stream < 0) {
+        if (!is_mjpeg(get_le32(strh + 4)) && !(strf_size >= 20 && is_mjpeg(get_le32(strf + 16)))) {
+            ESP_LOGW(TAG, "stream %d: only support mjpeg decoder, but needed is 0x%" PRIx32, stream, get_le32(strh + 4));
+            return ESP_OK;
+        }
+        h->info.video_stream = stream;
+        h->video_scale = get_le32(strh + 20);
+        h->video_rate = get_le32(strh + 24);
+        if (strf_size >= 12) {
+            h->info.width = get_le32(strf + 4);
+            h->info.height = get_le32(strf + 8);
+        }
+        h->video_indx = indx;
+        h->video_indx_size = indx_size;
+        ESP_LOGI(TAG, "stream %d: mjpeg video %" PRIu32 "x%" PRIu32, stream, h->info.width, h->info.height);
+    } else if (type == auds_ID && h->info.audio_stream < 0 && strf_size >= 16) {
+        h->info.audio_stream = stream;
+        h->info.audio_channels = get_le16(strf + 2);
+        h->info.audio_sample_rate = get_le32(strf + 4);
+        h->audio_bytes_per_sec = get_le32(strf + 8);
+        h->info.audio_bits = get_le16(strf + 14);
+        h->audio_indx = indx;
+        h->audio_indx_size = indx_size;
+        ESP_LOGI(TAG, "stream %d: audio %" PRIu32 " Hz, %u channels, %u bits", stream, h->info.audio_sample_rate,
+                 h->info.audio_channels, h->info.audio_bits);
     } else {
-        ESP_LOGW(TAG, "Unsupport stream 0x%x", strh->fourcc_type);
+        ESP_LOGW(TAG, "stream %d: skip 0x%" PRIx32, stream, type);
     }
-    return 0;
+    return ESP_OK;
 }
 
-int AVI_Parser(const uint8_t *buffer, uint32_t length)
+static esp_err_t parse_hdrl(avi_demux_handle_t h, uint32_t pos, uint32_t end)
 {
-    const uint8_t *pdata = buffer;
-    AVI_LIST_HEAD *riff = (AVI_LIST_HEAD*)pdata;
-    if (riff->List != RIFF_ID || riff->FourCC != AVI_ID) {
-        return -1;
+    int stream = 0;
+
+    while (pos + 8 <= end) {
+        uint8_t head[12];
+        if (!read_at(h, pos, head, sizeof(head))) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        uint32_t id = get_le32(head), size = get_le32(head + 4);
+        if (size > end - pos - 8) {
+            ESP_LOGW(TAG, "hdrl: chunk at %" PRIu32 " overruns the list", pos);
+            break;
+        }
+        if (id == avih_ID && size >= 40) {
+            uint8_t avih[40];
+            if (!read_at(h, pos + 8, avih, sizeof(avih))) {
+                return ESP_ERR_INVALID_RESPONSE;
+            }
+            h->info.us_per_frame = get_le32(avih);
+            h->info.width = get_le32(avih + 32);
+            h->info.height = get_le32(avih + 36);
+        } else if (id == LIST_ID && get_le32(head + 8) == strl_ID) {
+            esp_err_t ret = parse_strl(h, stream++, pos + 12, pos + 8 + size);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+        pos += 8 + size + (size & 1);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t load_idx1(avi_demux_handle_t h, uint32_t pos, uint32_t size)
+{
+    uint8_t buf[16 * 32];
+    uint32_t base = 0;
+    bool base_known = false;
+
+    for (uint32_t done = 0; done + 16 <= size;) {
+        uint32_t n = size - done < sizeof(buf) ? (size - done) & ~15U : sizeof(buf);
+        if (!read_at(h, pos + done, buf, n)) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        done += n;
+
+        for (const uint8_t *e = buf; e < buf + n; e += 16) {
+            uint32_t ckid = get_le32(e);
+            int type = chunk_type(h, ckid);
+            if (type < 0) {
+                continue;
+            }
+            /* offsets are relative to the 'movi' FourCC, some muxers write file offsets instead */
+            if (!base_known) {
+                uint8_t id[4];
+                base = h->movi_start[0];
+                if (!read_at(h, base + get_le32(e + 8), id, 4) || get_le32(id) != ckid) {
+                    if (read_at(h, get_le32(e + 8), id, 4) && get_le32(id) == ckid) {
+                        base = 0;
+                    }
+                }
+                base_known = true;
+            }
+            uint32_t flags = type | ((get_le32(e + 4) & AVIIF_KEYFRAME) ? ENTRY_KEYFRAME : 0);
+            uint64_t offset = (uint64_t)base + get_le32(e + 8) + 8;
+            if (offset >= h->file_size) {
+                ESP_LOGW(TAG, "skip idx1 entry at %" PRIu32, get_le32(e + 8));
+                continue;
+            }
+            esp_err_t ret = index_push(h, (uint32_t)offset, get_le32(e + 12), flags);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+/* entries of one stream from its OpenDML super index, appended in file order */
+static esp_err_t load_odml(avi_demux_handle_t h, uint32_t indx, uint32_t indx_size, uint32_t type)
+{
+    uint8_t head[24];
+
+    if (indx_size < sizeof(head) || !read_at(h, indx, head, sizeof(head)) || get_le16(head) != 4
+            || head[3] != AVI_INDEX_OF_INDEXES) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    uint32_t count = get_le32(head + 4);
+    if (sizeof(head) + (uint64_t)count * 16 > indx_size) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t super[16];
+        uint8_t ix[32];
+        if (!read_at(h, indx + sizeof(head) + i * 16, super, sizeof(super))) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        uint64_t ix_pos = get_le64(super);
+        /* standard index chunk: ix## header, then wLongsPerEntry .. dwReserved */
+        if (ix_pos >= h->file_size || !read_at(h, (uint32_t)ix_pos, ix, sizeof(ix)) || get_le16(ix + 8) != 2
+                || ix[11] != AVI_INDEX_OF_CHUNKS) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        uint32_t entries = get_le32(ix + 12);
+        uint64_t base = get_le64(ix + 20);
+        uint32_t pos = (uint32_t)ix_pos + sizeof(ix);
+        if ((uint64_t)entries * 8 + sizeof(ix) > get_le32(ix + 4) + 8) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+
+        uint8_t buf[8 * 64];
+        for (uint32_t done = 0; done < entries;) {
+            uint32_t n = entries - done < 64 ? entries - done : 64;
+            if (!read_at(h, pos + done * 8, buf, n * 8)) {
+                return ESP_ERR_INVALID_RESPONSE;
+            }
+            for (uint32_t k = 0; k < n; k++) {
+                uint64_t offset = base + get_le32(buf + k * 8);
+                uint32_t size = get_le32(buf + k * 8 + 4);
+                /* bit 31 marks delta frames */
+                uint32_t flags = type | ((size & 0x80000000U) ? 0 : ENTRY_KEYFRAME);
+                if (offset >= h->file_size) {
+                    continue;
+                }
+                esp_err_t ret = index_push(h, (uint32_t)offset, size & 0x7FFFFFFFU, flags);
+                if (ret != ESP_OK) {
+                    return ret;
+                }
+            }
+            done += n;
+        }
+    }
+    return ESP_OK;
+}
+
+/* files without an index: walk the chunk headers of every movi list */
+static esp_err_t scan_movi(avi_demux_handle_t h)
+{
+    for (int r = 0; r < h->movi_count; r++) {
+        uint32_t pos = h->movi_start[r] + 4;
+
+        while (pos + 8 <= h->movi_end[r]) {
+            uint8_t head[8];
+            if (!read_at(h, pos, head, sizeof(head))) {
+                break;
+            }
+            uint32_t id = get_le32(head), size = get_le32(head + 4);
+            if (id == LIST_ID) {
+                pos += 12;      /*!< 'rec ' groups, their chunks follow */
+                continue;
+            }
+            if (size > h->movi_end[r] - pos - 8) {
+                break;          /*!< truncated file, or a broken chunk header */
+            }
+            int type = chunk_type(h, id);
+            if (type >= 0) {
+                esp_err_t ret = index_push(h, pos + 8, size, type | ENTRY_KEYFRAME);
+                if (ret != ESP_OK) {
+                    return ret;
+                }
+            }
+            pos += 8 + size + (size & 1);
+        }
     }
-    AVI_file.RIFFchunksize = riff->size; //RIFF数据块长度
-    pdata += sizeof(AVI_LIST_HEAD);
-
-    AVI_LIST_HEAD *list = (AVI_LIST_HEAD*)pdata;
-    if (list->List != LIST_ID || list->FourCC != hdrl_ID) {
-        return -3;
-    }
-    AVI_file.LISTchunksize = list->size; //LIST数据块长度
-    pdata += sizeof(AVI_LIST_HEAD);
-
-    // avih chunk
-    AVI_AVIH_CHUNK *avih = (AVI_AVIH_CHUNK*)pdata;
-    if (avih->FourCC != avih_ID || avih->size+8 != sizeof(AVI_AVIH_CHUNK)) {
-        return -5;
-    }
-    AVI_file.avihsize = avih->size; //avih数据块长度
-#ifdef DEBUGINFO
-    printf("-----avih info------\r\n");
-    printf("us_per_frame:%d\r\n", avih->us_per_frame);
-    printf("max_bytes_per_sec:%d\r\n", avih->max_bytes_per_sec);
-    printf("padding:%d\r\n", avih->padding);
-    printf("flags:%d\r\n", avih->flags);
-    printf("total_frames:%d\r\n", avih->total_frames);
-    printf("init_frames:%d\r\n", avih->init_frames);
-    printf("streams:%d\r\n", avih->streams);
-    printf("suggest_buff_size:%d\r\n", avih->suggest_buff_size);
-    printf("Width:%d\r\n", avih->width);
-    printf("Height:%d\r\n\n", avih->height);
-#endif
-    if ((avih->width > 800) || (avih->height > 480)) {
-        ESP_LOGE(TAG, "The size of video is too large");
-        return -6;    //视频尺寸不支持
-    }
-    pdata += sizeof(AVI_AVIH_CHUNK);
-
-    // process all streams in turn
-    for (size_t i = 0; i < avih->streams; i++) {
-        uint32_t strl_size=0;
-        int ret = Strl_Parser(pdata, length-(pdata-buffer), &strl_size);
-        if (0 > ret) {
-            ESP_LOGE(TAG, "strl of stream%d prase failed", i);
+    return ESP_OK;
+}
+
+static int entry_compare(const void *a, const void *b)
+{
+    uint32_t x = ((const avi_entry_t *)a)->offset, y = ((const avi_entry_t *)b)->offset;
+    return x < y ? -1 : x > y;
+}
+
+static esp_err_t load_index(avi_demux_handle_t h, uint32_t idx1, uint32_t idx1_size)
+{
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+    if (h->video_indx) {
+        ret = load_odml(h, h->video_indx, h->video_indx_size, 0);
+        if (ret == ESP_OK && h->audio && h->audio_indx) {
+            ret = load_odml(h, h->audio_indx, h->audio_indx_size, ENTRY_AUDIO);
+        }
+        if (ret == ESP_OK) {
+            /* the streams come one after the other, interleave them back into file order */
+            qsort(h->entries, h->entry_count, sizeof(avi_entry_t), entry_compare);
+            h->info.index_type = AVI_INDEX_ODML;
+            return ESP_OK;
+        }
+        ESP_LOGW(TAG, "bad OpenDML index (%d)", ret);
+        h->entry_count = 0;
+    }
+    if (idx1) {
+        ret = load_idx1(h, idx1, idx1_size);
+        if (ret == ESP_OK) {
+            h->info.index_type = AVI_INDEX_IDX1;
+            return ESP_OK;
+        }
+        ESP_LOGW(TAG, "bad idx1 (%d)", ret);
+        h->entry_count = 0;
+    }
+    ESP_LOGW(TAG, "no index, scan the file");
+    h->info.index_type = AVI_INDEX_NONE;
+    return scan_movi(h);
+}
+
+static esp_err_t parse_file(avi_demux_handle_t h)
+{
+    uint32_t idx1 = 0, idx1_size = 0;
+    uint32_t riff = 0;
+
+    /* RIFF AVI, followed by RIFF AVIX in OpenDML files */
+    while (riff + 12 <= h->file_size && h->movi_count < AVI_MAX_RIFFS) {
+        uint8_t head[12];
+        if (!read_at(h, riff, head, sizeof(head)) || get_le32(head) != RIFF_ID
+                || get_le32(head + 8) != (riff ? AVIX_ID : AVI_ID)) {
+            if (riff == 0) {
+                return ESP_ERR_INVALID_RESPONSE;
+            }
             break;
-            /**
-             * TODO: how to deal this error? maybe we should search for the next strl.
-             */
         }
-        pdata += strl_size;
+        uint32_t end = riff + 8 + get_le32(head + 4);
+        end = end > h->file_size || end < riff ? h->file_size : end;
+
+        for (uint32_t pos = riff + 12; pos + 8 <= end;) {
+            if (!read_at(h, pos, head, sizeof(head))) {
+                break;
+            }
+            uint32_t id = get_le32(head), size = get_le32(head + 4);
+            uint32_t chunk_end = size > end - pos - 8 ? end : pos + 8 + size;
+            if (id == LIST_ID && get_le32(head + 8) == hdrl_ID && riff == 0) {
+                esp_err_t ret = parse_hdrl(h, pos + 12, chunk_end);
+                if (ret != ESP_OK) {
+                    return ret;
+                }
+            } else if (id == LIST_ID && get_le32(head + 8) == movi_ID && h->movi_count < AVI_MAX_RIFFS) {
+                h->movi_start[h->movi_count] = pos + 8;
+                h->movi_end[h->movi_count] = chunk_end;
+                h->movi_count++;
+            } else if (id == idx1_ID && riff == 0) {
+                idx1 = pos + 8;
+                idx1_size = size;
+            }
+            if (size > end - pos - 8) {
+                break;          /*!< truncated file, the movi list was kept up to its end */
+            }
+            pos += 8 + size + (size & 1);
+        }
+        riff = end + (end & 1);
+    }
+
+    if (h->info.video_stream < 0) {
+        ESP_LOGE(TAG, "no mjpeg video stream");
+        return ESP_ERR_NOT_SUPPORTED;
     }
-    int movi_offset = search_fourcc(MAKE_FOURCC('m', 'o', 'v', 'i'), pdata, length-(pdata-buffer));
-    if (0 > movi_offset) {
+    if (0 == h->movi_count) {
         ESP_LOGE(TAG, "can't find \"movi\" list");
-        return -7;
+        return ESP_ERR_INVALID_RESPONSE;
     }
-    AVI_file.movi_start = movi_offset + 4  + pdata - buffer;
-    pdata += movi_offset - 8; // back to the list head
-    AVI_LIST_HEAD *movi = (AVI_LIST_HEAD*)pdata;
-    if (movi->List != LIST_ID || movi->FourCC != movi_ID) {
-        return -8;
+    if (h->video_scale && h->video_rate) {
+        h->info.us_per_frame = (uint32_t)((uint64_t)h->video_scale * 1000000 / h->video_rate);
+    } else if (h->info.us_per_frame) {
+        h->video_scale = h->info.us_per_frame;
+        h->video_rate = 1000000;
+    } else {
+        return ESP_ERR_INVALID_RESPONSE;
     }
-    AVI_file.movi_size = movi->size; //LIST数据块长度
-    pdata += sizeof(AVI_LIST_HEAD);
-    ESP_LOGI(TAG, "movi pos:%d, size:%d", AVI_file.movi_start, AVI_file.movi_size);
-    
-    return 0;
+    return load_index(h, idx1, idx1_size);
 }
 
+esp_err_t avi_demux_open(const char *filename, const avi_demux_config_t *config, avi_demux_handle_t *ret_handle)
+{
+    avi_demux_handle_t h = calloc(1, sizeof(struct avi_demux));
+    esp_err_t ret;
 
+    if (NULL == h) {
+        return ESP_ERR_NO_MEM;
+    }
+    h->info.video_stream = -1;
+    h->info.audio_stream = -1;
+    h->audio = config ? config->audio : false;
+    h->seq_block = -1;
+
+    h->file = fopen(filename, "rb");
+    if (NULL == h->file) {
+        ESP_LOGE(TAG, "Cannot open %s", filename);
+        free(h);
+        return ESP_ERR_NOT_FOUND;
+    }
+    /* chunks are read straight into the pool, stdio buffering would only add a copy */
+    setvbuf(h->file, NULL, _IONBF, 0);
+    if (fseek(h->file, 0, SEEK_END) == 0) {
+        long size = ftell(h->file);
+        h->file_size = size > 0 ? (uint32_t)size : 0;
+    }
+
+    ret = parse_file(h);
+    if (ret != ESP_OK) {
+        goto err;
+    }
+
+    /* video frame numbers to entries, and flags from indexes that have none */
+    uint32_t frames = 0, keyframes = 0;
+    for (uint32_t i = 0; i < h->entry_count; i++) {
+        uint32_t size = h->entries[i].size & ENTRY_SIZE_MASK;
+        h->info.max_chunk_size = size > h->info.max_chunk_size ? size : h->info.max_chunk_size;
+        if (!(h->entries[i].size & ENTRY_AUDIO)) {
+            frames++;
+            keyframes += (h->entries[i].size & ENTRY_KEYFRAME) ? 1 : 0;
+        }
+    }
+    if (0 == frames) {
+        ESP_LOGE(TAG, "no video frames");
+        ret = ESP_ERR_INVALID_RESPONSE;
+        goto err;
+    }
+    h->video = malloc(frames * sizeof(uint32_t));
+    if (NULL == h->video) {
+        ret = ESP_ERR_NO_MEM;
+        goto err;
+    }
+    for (uint32_t i = 0, n = 0; i < h->entry_count; i++) {
+        if (!(h->entries[i].size & ENTRY_AUDIO)) {
+            if (0 == keyframes) {
+                h->entries[i].size |= ENTRY_KEYFRAME;
+            }
+            h->video[n++] = i;
+        }
+    }
+    h->info.total_frames = frames;
+    if (!h->audio) {
+        h->info.audio_stream = -1;
+    }
+
+    size_t pool_size = config && config->pool_size ? config->pool_size : AVI_DEMUX_DEFAULT_POOL_SIZE;
+    /* wherever a held frame sits in the pool, one side of it still fits the largest chunk */
+    if (pool_size < 3 * (size_t)h->info.max_chunk_size + 8) {
+        pool_size = 3 * (size_t)h->info.max_chunk_size + 8;
+    }
+    h->pool_size = (pool_size + 3) & ~3U;
+    h->batch_size = h->pool_size - 2 * h->info.max_chunk_size - 8;
+    h->batch_size = h->batch_size < h->pool_size / 2 ? h->batch_size : h->pool_size / 2;
+    h->pool = heap_caps_malloc(h->pool_size, config && config->pool_caps ? config->pool_caps : MALLOC_CAP_8BIT);
+    if (NULL == h->pool) {
+        ESP_LOGE(TAG, "Cannot alloc %" PRIu32 " bytes for the read-ahead pool", h->pool_size);
+        ret = ESP_ERR_NO_MEM;
+        goto err;
+    }
+
+    ESP_LOGI(TAG, "%" PRIu32 " frames, %" PRIu32 " us per frame, %" PRIu32 " index entries (%s), largest chunk %" PRIu32 ", pool %" PRIu32,
+             frames, h->info.us_per_frame, h->entry_count,
+             h->info.index_type == AVI_INDEX_ODML ? "OpenDML" : (h->info.index_type == AVI_INDEX_IDX1 ? "idx1" : "scanned"),
+             h->info.max_chunk_size, h->pool_size);
+    *ret_handle = h;
+    return ESP_OK;
+
+err:
+    avi_demux_close(h);
+    return ret;
+}
+
+void avi_demux_close(avi_demux_handle_t handle)
+{
+    if (NULL == handle) {
+        return;
+    }
+    if (handle->file) {
+        fclose(handle->file);
+    }
+    free(handle->entries);
+    free(handle->video);
+    heap_caps_free(handle->pool);
+    free(handle);
+}
+
+void avi_demux_get_info(avi_demux_handle_t handle, avi_demux_info_t *info)
+{
+    *info = handle->info;
+}
+
+/* free the blocks nobody needs any more, frames are released in any order */
+static void pool_reclaim(avi_demux_handle_t h)
+{
+    for (int n = 0; n < AVI_MAX_BLOCKS; n++) {
+        if (h->blocks[n].used && h->blocks[n].done && 0 == h->blocks[n].refs) {
+            h->blocks[n].used = false;
+        }
+    }
+}
+
+/* pool offset of the first gap between the blocks of at least len bytes, -1 if there is none */
+static int pool_find(avi_demux_handle_t h, uint32_t len)
+{
+    const avi_block_t *sorted[AVI_MAX_BLOCKS];
+    int count = 0;
+
+    for (int n = 0; n < AVI_MAX_BLOCKS; n++) {
+        if (!h->blocks[n].used) {
+            continue;
+        }
+        int i = count++;
+        for (; i > 0 && sorted[i - 1]->pool_off > h->blocks[n].pool_off; i--) {
+            sorted[i] = sorted[i - 1];
+        }
+        sorted[i] = &h->blocks[n];
+    }
+    if (count == AVI_MAX_BLOCKS) {
+        return -1;
+    }
+
+    uint32_t start = 0;
+    for (int i = 0; i < count; i++) {
+        if (start + len <= sorted[i]->pool_off) {
+            return start;
+        }
+        start = (sorted[i]->pool_off + sorted[i]->pool_len + 3) & ~3U;
+    }
+    return start + len <= h->pool_size ? (int)start : -1;
+}
+
+static int block_find(avi_demux_handle_t h, uint32_t entry)
+{
+    for (int n = 0; n < AVI_MAX_BLOCKS; n++) {
+        avi_block_t *b = &h->blocks[n];
+        if (b->used && entry >= b->first && entry < b->first + b->count) {
+            return n;
+        }
+    }
+    return -1;
+}
+
+/* read entry first, and with batch the chunks right behind it, into a new block */
+static esp_err_t block_fill(avi_demux_handle_t h, uint32_t first, bool batch, int *ret_block)
+{
+    const avi_entry_t *e = &h->entries[first];
+    uint32_t start = e->offset;
+    uint32_t end = start + (e->size & ENTRY_SIZE_MASK);
+    uint32_t count = 1;
+    int off;
+
+    pool_reclaim(h);
+    off = pool_find(h, end - start);
+    if (off < 0 && h->seq_block >= 0 && 0 == h->blocks[h->seq_block].refs) {
+        /* give up what is read ahead for avi_demux_read, it is read again when needed */
+        h->blocks[h->seq_block].done = true;
+        h->seq_block = -1;
+        pool_reclaim(h);
+        off = pool_find(h, end - start);
+    }
+    if (off < 0) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    while (batch && count < AVI_MAX_BATCH_FRAMES && first + count < h->entry_count) {
+        const avi_entry_t *next = &h->entries[first + count];
+        uint32_t next_end = next->offset + (next->size & ENTRY_SIZE_MASK);
+        if (next->offset < end || next->offset - end > AVI_MAX_GAP || next_end - start > h->batch_size) {
+            break;
+        }
+        int next_off = pool_find(h, next_end - start);
+        if (next_off < 0) {
+            break;
+        }
+        off = next_off;
+        end = next_end;
+        count++;
+    }
+
+    if (!read_at(h, start, h->pool + off, end - start)) {
+        ESP_LOGE(TAG, "read %" PRIu32 " bytes at %" PRIu32 " failed", end - start, start);
+        return ESP_FAIL;
+    }
+
+    int n = 0;
+    while (h->blocks[n].used) {
+        n++;
+    }
+    avi_block_t *b = &h->blocks[n];
+    b->pool_off = off;
+    b->pool_len = end - start;
+    b->file_off = start;
+    b->first = first;
+    b->count = count;
+    b->refs = 0;
+    b->done = !batch;
+    b->used = true;
+    *ret_block = n;
+    return ESP_OK;
+}
+
+static void frame_from_block(avi_demux_handle_t h, int n, uint32_t entry, avi_frame_t *frame)
+{
+    const avi_entry_t *e = &h->entries[entry];
+    avi_block_t *b = &h->blocks[n];
+
+    frame->data = h->pool + b->pool_off + (e->offset - b->file_off);
+    frame->size = e->size & ENTRY_SIZE_MASK;
+    frame->keyframe = (e->size & ENTRY_KEYFRAME) != 0;
+    frame->type = (e->size & ENTRY_AUDIO) ? AVI_FRAME_AUDIO : AVI_FRAME_VIDEO;
+    frame->block = n;
+    b->refs++;
+}
+
+static int64_t video_pts(avi_demux_handle_t h, uint32_t frame_index)
+{
+    return (int64_t)frame_index * h->video_scale * 1000000 / h->video_rate;
+}
+
+esp_err_t avi_demux_read(avi_demux_handle_t handle, avi_frame_t *frame)
+{
+    avi_demux_handle_t h = handle;
+    uint32_t entry = h->cursor;
+
+    if (entry >= h->entry_count) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (h->seq_block < 0) {
+        esp_err_t ret = block_fill(h, entry, true, &h->seq_block);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    avi_block_t *b = &h->blocks[h->seq_block];
+    frame_from_block(h, h->seq_block, entry, frame);
+    if (frame->type == AVI_FRAME_VIDEO) {
+        frame->index = h->cursor_video++;
+        frame->pts_us = video_pts(h, frame->index);
+    } else {
+        frame->index = h->cursor_audio++;
+        frame->pts_us = h->audio_bytes_per_sec ? (int64_t)(h->cursor_audio_bytes * 1000000 / h->audio_bytes_per_sec) : 0;
+        h->cursor_audio_bytes += frame->size;
+    }
+
+    /* read ahead happens once the block is used up */
+    h->cursor++;
+    if (h->cursor == b->first + b->count) {
+        b->done = true;
+        h->seq_block = -1;
+    }
+    return ESP_OK;
+}
+
+esp_err_t avi_demux_read_video(avi_demux_handle_t handle, uint32_t frame_index, avi_frame_t *frame)
+{
+    avi_demux_handle_t h = handle;
+
+    if (frame_index >= h->info.total_frames) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    uint32_t entry = h->video[frame_index];
+    /* already read ahead: share it */
+    int n = block_find(h, entry);
+    if (n < 0) {
+        esp_err_t ret = block_fill(h, entry, false, &n);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    frame_from_block(h, n, entry, frame);
+    frame->index = frame_index;
+    frame->pts_us = video_pts(h, frame_index);
+    return ESP_OK;
+}
+
+esp_err_t avi_demux_seek(avi_demux_handle_t handle, uint32_t frame_index)
+{
+    avi_demux_handle_t h = handle;
+
+    if (frame_index >= h->info.total_frames) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    while (frame_index > 0 && !(h->entries[h->video[frame_index]].size & ENTRY_KEYFRAME)) {
+        frame_index--;
+    }
+
+    if (h->seq_block >= 0) {
+        h->blocks[h->seq_block].done = true;
+        h->seq_block = -1;
+    }
+    pool_reclaim(h);
+
+    h->cursor = h->video[frame_index];
+    h->cursor_video = frame_index;
+    h->cursor_audio = 0;
+    h->cursor_audio_bytes = 0;
+    for (uint32_t i = 0; i < h->cursor; i++) {
+        if (h->entries[i].size & ENTRY_AUDIO) {
+            h->cursor_audio++;
+            h->cursor_audio_bytes += h->entries[i].size & ENTRY_SIZE_MASK;
+        }
+    }
+    return ESP_OK;
+}
+
+void avi_demux_release(avi_demux_handle_t handle, avi_frame_t *frame)
+{
+    if (frame->block >= 0) {
+        handle->blocks[frame->block].refs--;
+        frame->block = -1;
+        pool_reclaim(handle);
+    }
+}
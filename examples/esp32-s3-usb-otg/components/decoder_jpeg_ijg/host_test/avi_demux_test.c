@@ -0,0 +1,739 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Test for the AVI demuxer (avifile.h) on files it writes itself.
+ *
+ * Each file has an MJPEG video stream and an audio stream, interleaved in movi, and one
+ * of the indexes: idx1 with offsets relative to movi, idx1 with file offsets, an OpenDML
+ * super index with a standard index per RIFF over a RIFF AVIX extension, or none. Every
+ * payload carries its stream and number, so the demuxer must hand out each chunk whole,
+ * in file order, with the key frame flags of the index.
+ *
+ * Broken files must be opened or refused, never hang or read outside the file:
+ *   - chunks whose size runs past their list or the file (0xFFFFFFF8 and alike), in strl,
+ *     hdrl, the RIFF and movi
+ *   - the file cut at every length
+ *   - idx1 entries pointing past the end of the file, an idx1 longer than the file
+ *   - an OpenDML super index pointing nowhere, which falls back to idx1
+ *   - random bytes of a good file changed
+ * A case that does not return in a few seconds fails the test.
+ *
+ * Usage:
+ *     avi_demux_test [dir]      dir for the files, /tmp by default
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "avifile.h"
+
+#define FRAMES              40
+#define KEY_INTERVAL        5
+#define US_PER_FRAME        40000       /*!< 25 fps, scale 1 rate 25 */
+#define AUDIO_RATE          8000        /*!< mono 8 bit, bytes per second */
+#define TIMEOUT_S           5
+
+typedef enum {
+    INDEX_NONE,
+    INDEX_IDX1,
+    INDEX_IDX1_ABS,                     /*!< file offsets instead of movi relative ones */
+    INDEX_ODML,                         /*!< super index, two RIFFs, and an idx1 over the first */
+} index_kind_t;
+
+typedef enum {
+    JUNK_NONE,
+    JUNK_STRL,                          /*!< last chunk of the video strl */
+    JUNK_HDRL,                          /*!< last chunk of hdrl */
+    JUNK_MOVI,                          /*!< last chunk of the last movi */
+    JUNK_RIFF,                          /*!< last chunk of the first RIFF */
+} junk_where_t;
+
+typedef struct {
+    index_kind_t index;
+    bool audio;
+    junk_where_t junk;
+    uint32_t junk_size;                 /*!< size in the header of that chunk, which has no data */
+    bool bad_idx1_entry;                /*!< one more idx1 entry, far beyond the end of the file */
+    bool bad_super_index;               /*!< the super index points past the end of the file */
+} avi_spec_t;
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t cap;
+} avi_buf_t;
+
+/* one chunk written to movi, for the indexes */
+typedef struct {
+    char id[5];
+    uint32_t pos;                       /*!< file offset of the chunk header */
+    uint32_t size;
+    bool key;
+    int riff;
+} avi_chunk_t;
+
+static int s_failures;
+static const char *s_case;
+static char s_path[256];
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s: ", s_case); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        s_failures++; \
+    } \
+} while (0)
+
+static void on_timeout(int sig)
+{
+    (void)sig;
+    static const char msg[] = "FAIL: a case did not return, the demuxer hangs\n";
+    ssize_t ret = write(STDOUT_FILENO, msg, sizeof(msg) - 1);
+    (void)ret;
+    _exit(1);
+}
+
+static void put(avi_buf_t *b, const void *p, size_t n)
+{
+    if (b->len + n > b->cap) {
+        b->cap = (b->len + n) * 2;
+        b->data = realloc(b->data, b->cap);
+        if (NULL == b->data) {
+            abort();
+        }
+    }
+    memcpy(b->data + b->len, p, n);
+    b->len += n;
+}
+
+static void set32(avi_buf_t *b, size_t at, uint32_t v)
+{
+    uint8_t p[4] = {v, v >> 8, v >> 16, v >> 24};
+    memcpy(b->data + at, p, 4);
+}
+
+static void put32(avi_buf_t *b, uint32_t v)
+{
+    uint8_t p[4] = {v, v >> 8, v >> 16, v >> 24};
+    put(b, p, 4);
+}
+
+static void put16(avi_buf_t *b, uint16_t v)
+{
+    uint8_t p[2] = {v, v >> 8};
+    put(b, p, 2);
+}
+
+static void put_fourcc(avi_buf_t *b, const char *id)
+{
+    put(b, id, 4);
+}
+
+/* a chunk or list header, returns where its size goes */
+static size_t begin(avi_buf_t *b, const char *id, const char *type)
+{
+    put_fourcc(b, id);
+    size_t at = b->len;
+    put32(b, 0);
+    if (type) {
+        put_fourcc(b, type);
+    }
+    return at;
+}
+
+static void end(avi_buf_t *b, size_t at)
+{
+    set32(b, at, b->len - at - 4);
+    if (b->len & 1) {
+        put(b, "", 1);
+    }
+}
+
+static void put_junk_header(avi_buf_t *b, uint32_t size)
+{
+    put_fourcc(b, "JUNK");
+    put32(b, size);
+}
+
+/* video frame n: SOI, then 'v' and n, then bytes following from n */
+static uint32_t payload_size(char kind, uint32_t n)
+{
+    return kind == 'v' ? 60 + (n * 37) % 700 : 32 + (n * 13) % 96;
+}
+
+static uint8_t payload_byte(char kind, uint32_t n, uint32_t k)
+{
+    return (uint8_t)(n * 31 + k * 7 + (kind == 'v' ? 0 : 0x55));
+}
+
+static void put_payload(avi_buf_t *b, char kind, uint32_t n)
+{
+    uint32_t size = payload_size(kind, n);
+    uint8_t head[5] = {0xFF, 0xD8, (uint8_t)kind, (uint8_t)n, (uint8_t)(n >> 8)};
+    put(b, head, sizeof(head));
+    for (uint32_t k = sizeof(head); k < size; k++) {
+        uint8_t v = payload_byte(kind, n, k);
+        put(b, &v, 1);
+    }
+}
+
+/* the payload must be the one it names, whole */
+static bool payload_ok(const avi_frame_t *frame, char kind, uint32_t *n)
+{
+    const uint8_t *d = frame->data;
+    if (frame->size < 5 || d[0] != 0xFF || d[1] != 0xD8 || d[2] != kind) {
+        return false;
+    }
+    *n = d[3] | d[4] << 8;
+    if (frame->size != payload_size(kind, *n)) {
+        return false;
+    }
+    for (uint32_t k = 5; k < frame->size; k++) {
+        if (d[k] != payload_byte(kind, *n, k)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void put_strl(avi_buf_t *b, bool video, int frames, const avi_spec_t *spec, size_t *indx)
+{
+    size_t strl = begin(b, "LIST", "strl");
+
+    size_t at = begin(b, "strh", NULL);
+    put_fourcc(b, video ? "vids" : "auds");
+    put_fourcc(b, video ? "MJPG" : "\0\0\0\0");
+    put32(b, 0);                        /*!< flags */
+    put32(b, 0);                        /*!< priority, language */
+    put32(b, 0);                        /*!< initial frames */
+    put32(b, 1);                        /*!< scale */
+    put32(b, video ? 25 : AUDIO_RATE);  /*!< rate */
+    put32(b, 0);                        /*!< start */
+    put32(b, frames);                   /*!< length */
+    put32(b, 0);                        /*!< suggested buffer size */
+    put32(b, 0xFFFFFFFF);               /*!< quality */
+    put32(b, video ? 0 : 1);            /*!< sample size */
+    put32(b, 0);                        /*!< frame rectangle */
+    put32(b, 0);
+    end(b, at);
+
+    at = begin(b, "strf", NULL);
+    if (video) {
+        put32(b, 40);
+        put32(b, 320);
+        put32(b, 240);
+        put16(b, 1);
+        put16(b, 24);
+        put_fourcc(b, "MJPG");
+        put32(b, 320 * 240 * 3);
+        put32(b, 0);
+        put32(b, 0);
+        put32(b, 0);
+        put32(b, 0);
+    } else {
+        put16(b, 1);                    /*!< PCM */
+        put16(b, 1);
+        put32(b, AUDIO_RATE);
+        put32(b, AUDIO_RATE);
+        put16(b, 1);
+        put16(b, 8);
+        put16(b, 0);
+    }
+    end(b, at);
+
+    if (spec->index == INDEX_ODML) {
+        /* super index of two entries, the offsets of the ix## chunks are filled in later */
+        at = begin(b, "indx", NULL);
+        *indx = b->len;
+        put16(b, 4);
+        put(b, "\0", 1);
+        put(b, "\0", 1);                /*!< AVI_INDEX_OF_INDEXES */
+        put32(b, 2);
+        put_fourcc(b, video ? "00dc" : "01wb");
+        put32(b, 0);
+        put32(b, 0);
+        put32(b, 0);
+        for (int i = 0; i < 2; i++) {
+            put32(b, 0);
+            put32(b, 0);
+            put32(b, 0);
+            put32(b, 0);
+        }
+        end(b, at);
+    }
+    if (video && spec->junk == JUNK_STRL) {
+        put_junk_header(b, spec->junk_size);
+    }
+    end(b, strl);
+}
+
+/* standard index of the chunks of one stream in one RIFF */
+static void put_ix(avi_buf_t *b, const char *stream, const avi_chunk_t *chunks, int count, int riff, uint32_t base)
+{
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        n += chunks[i].riff == riff && memcmp(chunks[i].id, stream, 4) == 0;
+    }
+    char id[5] = {'i', 'x', stream[0], stream[1], 0};
+    size_t at = begin(b, id, NULL);
+    put16(b, 2);
+    put(b, "\0", 1);
+    put(b, "\1", 1);                    /*!< AVI_INDEX_OF_CHUNKS */
+    put32(b, n);
+    put_fourcc(b, stream);
+    put32(b, base);
+    put32(b, 0);
+    put32(b, 0);
+    for (int i = 0; i < count; i++) {
+        if (chunks[i].riff == riff && memcmp(chunks[i].id, stream, 4) == 0) {
+            put32(b, chunks[i].pos + 8 - base);
+            put32(b, chunks[i].size | (chunks[i].key ? 0 : 0x80000000U));
+        }
+    }
+    end(b, at);
+}
+
+/* movi of the chunks from..to, with the standard indexes at its end for OpenDML */
+static void put_movi(avi_buf_t *b, const avi_spec_t *spec, avi_chunk_t *chunks, int *count, int riff,
+                     int from, int to, bool last, uint32_t ix_pos[2])
+{
+    size_t movi = begin(b, "LIST", "movi");
+    uint32_t base = b->len;
+
+    for (int n = from; n < to; n++) {
+        avi_chunk_t *c = &chunks[(*count)++];
+        memcpy(c->id, "00dc", 5);
+        c->pos = b->len;
+        c->size = payload_size('v', n);
+        c->key = n % KEY_INTERVAL == 0;
+        c->riff = riff;
+        size_t at = begin(b, c->id, NULL);
+        put_payload(b, 'v', n);
+        end(b, at);
+
+        if (spec->audio && n % 2 == 0) {
+            c = &chunks[(*count)++];
+            memcpy(c->id, "01wb", 5);
+            c->pos = b->len;
+            c->size = payload_size('a', n / 2);
+            c->key = true;
+            c->riff = riff;
+            at = begin(b, c->id, NULL);
+            put_payload(b, 'a', n / 2);
+            end(b, at);
+        }
+    }
+    if (spec->index == INDEX_ODML) {
+        ix_pos[0] = b->len;
+        put_ix(b, "00dc", chunks, *count, riff, base);
+        ix_pos[1] = b->len;
+        put_ix(b, "01wb", chunks, *count, riff, base);
+    }
+    if (last && spec->junk == JUNK_MOVI) {
+        put_junk_header(b, spec->junk_size);
+    }
+    end(b, movi);
+}
+
+static void put_idx1(avi_buf_t *b, const avi_spec_t *spec, const avi_chunk_t *chunks, int count, uint32_t movi)
+{
+    size_t at = begin(b, "idx1", NULL);
+    for (int i = 0; i < count; i++) {
+        if (chunks[i].riff != 0) {
+            continue;
+        }
+        put_fourcc(b, chunks[i].id);
+        put32(b, chunks[i].key ? 0x10 : 0);
+        put32(b, spec->index == INDEX_IDX1_ABS ? chunks[i].pos : chunks[i].pos - movi);
+        put32(b, chunks[i].size);
+    }
+    if (spec->bad_idx1_entry) {
+        put_fourcc(b, "00dc");
+        put32(b, 0x10);
+        put32(b, 0xFFFFFF00U);
+        put32(b, 100);
+    }
+    end(b, at);
+}
+
+/* frames in the first RIFF of an OpenDML file */
+#define ODML_SPLIT          (FRAMES / 2 + 3)
+
+static avi_buf_t build(const avi_spec_t *spec)
+{
+    avi_buf_t b = {0};
+    avi_chunk_t chunks[FRAMES * 2];
+    int count = 0;
+    size_t indx[2] = {0};
+    uint32_t ix_pos[2][2] = {{0}};
+    int split = spec->index == INDEX_ODML ? ODML_SPLIT : FRAMES;
+
+    size_t riff = begin(&b, "RIFF", "AVI ");
+    size_t hdrl = begin(&b, "LIST", "hdrl");
+    size_t at = begin(&b, "avih", NULL);
+    put32(&b, US_PER_FRAME);
+    for (int i = 0; i < 7; i++) {
+        put32(&b, i == 3 ? FRAMES : 0);
+    }
+    put32(&b, 320);
+    put32(&b, 240);
+    for (int i = 0; i < 4; i++) {
+        put32(&b, 0);
+    }
+    end(&b, at);
+    put_strl(&b, true, FRAMES, spec, &indx[0]);
+    if (spec->audio) {
+        put_strl(&b, false, FRAMES / 2, spec, &indx[1]);
+    }
+    if (spec->junk == JUNK_HDRL) {
+        put_junk_header(&b, spec->junk_size);
+    }
+    end(&b, hdrl);
+
+    uint32_t movi = b.len + 8;
+    put_movi(&b, spec, chunks, &count, 0, 0, split, split == FRAMES, ix_pos[0]);
+    if (spec->index != INDEX_NONE) {
+        put_idx1(&b, spec, chunks, count, movi);
+    }
+    if (spec->junk == JUNK_RIFF) {
+        put_junk_header(&b, spec->junk_size);
+    }
+    end(&b, riff);
+
+    if (spec->index == INDEX_ODML) {
+        riff = begin(&b, "RIFF", "AVIX");
+        put_movi(&b, spec, chunks, &count, 1, split, FRAMES, true, ix_pos[1]);
+        end(&b, riff);
+
+        for (int s = 0; s < (spec->audio ? 2 : 1); s++) {
+            for (int r = 0; r < 2; r++) {
+                size_t e = indx[s] + 24 + r * 16;
+                set32(&b, e, spec->bad_super_index ? 0x7FFFFF00U : ix_pos[r][s]);
+                set32(&b, e + 4, 0);
+                set32(&b, e + 8, 32 + 8 * FRAMES);
+                set32(&b, e + 12, 0);
+            }
+        }
+    }
+    return b;
+}
+
+static bool save(const uint8_t *data, size_t len)
+{
+    FILE *f = fopen(s_path, "wb");
+    if (NULL == f) {
+        printf("cannot write %s\n", s_path);
+        return false;
+    }
+    bool ok = fwrite(data, 1, len, f) == len;
+    return fclose(f) == 0 && ok;
+}
+
+typedef enum {
+    CHECK_ANY,                          /*!< changed files: any data, as long as it is in the pool */
+    CHECK_PAYLOAD,                      /*!< payloads whole, chunks may be missing */
+    CHECK_ALL,                          /*!< exactly the chunks written */
+} check_level_t;
+
+/* sum of the payload, touches every byte of the frame */
+static uint32_t touch(const avi_frame_t *frame)
+{
+    uint32_t sum = 0;
+    for (uint32_t k = 0; k < frame->size; k++) {
+        sum += frame->data[k];
+    }
+    return sum;
+}
+
+/*
+ * Read the whole file with avi_demux_read, holding a few frames and releasing them out of
+ * order.
+ */
+static void read_all(avi_demux_handle_t h, const avi_spec_t *spec, check_level_t level, uint32_t expect_frames)
+{
+    bool strict = level == CHECK_ALL;
+    avi_frame_t held[3];
+    int nheld = 0;
+    uint32_t video = 0, audio = 0;
+    avi_frame_t frame;
+    esp_err_t ret;
+
+    while ((ret = avi_demux_read(h, &frame)) == ESP_OK) {
+        uint32_t n;
+        if (level == CHECK_ANY) {
+            static volatile uint32_t sink;
+            sink += touch(&frame);
+        } else if (frame.type == AVI_FRAME_VIDEO) {
+            CHECK(payload_ok(&frame, 'v', &n), "video frame %u: wrong payload", frame.index);
+            if (strict) {
+                CHECK(n == video && frame.index == video, "video frame %u is frame %u", video, n);
+                CHECK(frame.keyframe == (n % KEY_INTERVAL == 0 || spec->index == INDEX_NONE),
+                      "video frame %u: key frame flag %d", n, frame.keyframe);
+                CHECK(frame.pts_us == (int64_t)n * US_PER_FRAME, "video frame %u: pts %lld", n, (long long)frame.pts_us);
+            }
+        } else {
+            CHECK(spec->audio, "audio chunk in a file without audio");
+            CHECK(payload_ok(&frame, 'a', &n), "audio chunk %u: wrong payload", frame.index);
+            CHECK(!strict || n == audio, "audio chunk %u is chunk %u", audio, n);
+        }
+        video += frame.type == AVI_FRAME_VIDEO;
+        audio += frame.type == AVI_FRAME_AUDIO;
+        if (nheld == 3) {
+            avi_demux_release(h, &held[1]);
+            held[1] = held[0];
+            held[0] = held[2];
+            nheld = 2;
+        }
+        held[nheld++] = frame;
+    }
+    while (nheld > 0) {
+        avi_demux_release(h, &held[--nheld]);
+    }
+    CHECK(ret == ESP_ERR_NOT_FOUND, "read ended with %d", ret);
+    if (strict) {
+        CHECK(video == expect_frames, "%u video frames, expected %u", video, expect_frames);
+        CHECK(!spec->audio || audio == (expect_frames + 1) / 2, "%u audio chunks, expected %u", audio, (expect_frames + 1) / 2);
+    }
+}
+
+static void random_access(avi_demux_handle_t h, const avi_spec_t *spec, uint32_t frames)
+{
+    static const uint32_t order[] = {7, 0, 39, 12, 12, 3, 25, 38, 1, 24};
+    avi_frame_t frame, keep;
+    uint32_t n;
+
+    for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+        if (order[i] >= frames) {
+            continue;
+        }
+        CHECK(avi_demux_read_video(h, order[i], &frame) == ESP_OK, "read_video %u failed", order[i]);
+        CHECK(payload_ok(&frame, 'v', &n) && n == order[i], "read_video %u: wrong payload", order[i]);
+        if (i == 0) {
+            keep = frame;
+        } else {
+            avi_demux_release(h, &frame);
+        }
+    }
+    CHECK(avi_demux_read_video(h, frames, &frame) == ESP_ERR_NOT_FOUND, "read_video past the end");
+    avi_demux_release(h, &keep);
+
+    /* seek goes back to the key frame, then reads on in order; without an index every frame is one */
+    uint32_t key = spec->index == INDEX_NONE ? 13 : 13 / KEY_INTERVAL * KEY_INTERVAL;
+    CHECK(avi_demux_seek(h, 13) == ESP_OK, "seek failed");
+    CHECK(avi_demux_read(h, &frame) == ESP_OK && frame.type == AVI_FRAME_VIDEO, "read after seek failed");
+    CHECK(payload_ok(&frame, 'v', &n) && n == key && frame.index == key, "seek to 13 read frame %u", n);
+    avi_demux_release(h, &frame);
+    CHECK(avi_demux_seek(h, frames) == ESP_ERR_INVALID_ARG, "seek past the end");
+}
+
+/* a good file, read completely */
+static void test_good(const char *name, const avi_spec_t *spec)
+{
+    avi_buf_t b = build(spec);
+    avi_demux_config_t config = {.audio = spec->audio};
+    avi_demux_handle_t h = NULL;
+    avi_demux_info_t info;
+    avi_index_type_t type = spec->index == INDEX_NONE ? AVI_INDEX_NONE :
+                            (spec->index == INDEX_ODML ? AVI_INDEX_ODML : AVI_INDEX_IDX1);
+    int before = s_failures;
+
+    s_case = name;
+    alarm(TIMEOUT_S);
+    if (save(b.data, b.len) && avi_demux_open(s_path, &config, &h) == ESP_OK) {
+        avi_demux_get_info(h, &info);
+        CHECK(info.width == 320 && info.height == 240, "size %ux%u", info.width, info.height);
+        CHECK(info.us_per_frame == US_PER_FRAME, "%u us per frame", info.us_per_frame);
+        CHECK(info.total_frames == FRAMES, "%u frames", info.total_frames);
+        CHECK(info.video_stream == 0, "video stream %d", info.video_stream);
+        CHECK(info.audio_stream == (spec->audio ? 1 : -1), "audio stream %d", info.audio_stream);
+        CHECK(!spec->audio || (info.audio_sample_rate == AUDIO_RATE && info.audio_channels == 1 && info.audio_bits == 8),
+              "audio %u Hz %u channels %u bits", info.audio_sample_rate, info.audio_channels, info.audio_bits);
+        CHECK(info.index_type == type, "index type %d, expected %d", info.index_type, type);
+        read_all(h, spec, CHECK_ALL, FRAMES);
+        random_access(h, spec, FRAMES);
+        avi_demux_close(h);
+    } else {
+        CHECK(false, "open failed");
+    }
+    alarm(0);
+    free(b.data);
+    printf("%-40s %s\n", name, s_failures > before ? "FAIL" : "PASS");
+}
+
+/* a broken file: open must return, what it opens must read without errors */
+static esp_err_t try_open(const uint8_t *data, size_t len, bool audio, check_level_t level, uint32_t *frames,
+                          avi_index_type_t *type)
+{
+    avi_demux_config_t config = {.audio = audio};
+    avi_demux_handle_t h = NULL;
+    avi_spec_t any = {.audio = audio};
+
+    alarm(TIMEOUT_S);
+    if (!save(data, len)) {
+        return ESP_FAIL;
+    }
+    esp_err_t ret = avi_demux_open(s_path, &config, &h);
+    if (ret == ESP_OK) {
+        avi_demux_info_t info;
+        avi_demux_get_info(h, &info);
+        read_all(h, &any, level, 0);
+        *frames = info.total_frames;
+        *type = info.index_type;
+        avi_demux_close(h);
+    }
+    alarm(0);
+    return ret;
+}
+
+static void test_oversized(void)
+{
+    static const uint32_t sizes[] = {0xFFFFFFF8U, 0xFFFFFFF7U, 0xFFFFFFFFU, 0xFFFFFFF0U, 0x7FFFFFFFU, 0x1000};
+    static const struct {
+        junk_where_t where;
+        const char *name;
+        index_kind_t index;
+    } places[] = {
+        {JUNK_STRL, "strl", INDEX_IDX1},
+        {JUNK_HDRL, "hdrl", INDEX_IDX1},
+        {JUNK_RIFF, "RIFF", INDEX_IDX1},
+        {JUNK_MOVI, "movi", INDEX_NONE},
+        {JUNK_MOVI, "movi of the AVIX", INDEX_ODML},
+    };
+    char name[64];
+    int before = s_failures;
+
+    for (size_t p = 0; p < sizeof(places) / sizeof(places[0]); p++) {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            avi_spec_t spec = {.index = places[p].index, .audio = true, .junk = places[p].where, .junk_size = sizes[s]};
+            avi_buf_t b = build(&spec);
+            uint32_t frames = 0;
+            avi_index_type_t type;
+
+            snprintf(name, sizeof(name), "chunk of 0x%08X at the end of %s", sizes[s], places[p].name);
+            s_case = name;
+            /* the chunk runs out of its list and of the file, the rest must still play */
+            esp_err_t ret = try_open(b.data, b.len, true, CHECK_PAYLOAD, &frames, &type);
+            CHECK(ret == ESP_OK, "open returned %d", ret);
+            CHECK(ret != ESP_OK || frames == FRAMES, "%u frames", frames);
+            free(b.data);
+        }
+    }
+    printf("%-40s %s\n", "oversized chunks", s_failures > before ? "FAIL" : "PASS");
+}
+
+static void test_truncated(const char *name, const avi_spec_t *spec)
+{
+    avi_buf_t b = build(spec);
+    int before = s_failures;
+    int opened = 0, lengths = 0;
+
+    s_case = name;
+    for (size_t len = 0; len < b.len; len += len < 512 ? 1 : 11) {
+        uint32_t frames = 0;
+        avi_index_type_t type;
+        if (try_open(b.data, len, spec->audio, CHECK_PAYLOAD, &frames, &type) == ESP_OK) {
+            CHECK(frames <= FRAMES, "cut at %zu: %u frames", len, frames);
+            opened++;
+        }
+        lengths++;
+    }
+    free(b.data);
+    printf("%-40s %s (%d of %d lengths open)\n", name, s_failures > before ? "FAIL" : "PASS", opened, lengths);
+}
+
+static void test_bad_index(void)
+{
+    int before = s_failures;
+    uint32_t frames = 0;
+    avi_index_type_t type = AVI_INDEX_NONE;
+
+    /* an entry past the end of the file is dropped, the others stay */
+    avi_spec_t spec = {.index = INDEX_IDX1, .audio = true, .bad_idx1_entry = true};
+    avi_buf_t b = build(&spec);
+    s_case = "idx1 entry past the end";
+    CHECK(try_open(b.data, b.len, true, CHECK_PAYLOAD, &frames, &type) == ESP_OK, "open failed");
+    CHECK(frames == FRAMES && type == AVI_INDEX_IDX1, "%u frames, index type %d", frames, type);
+    free(b.data);
+
+    /* idx1 longer than the file: the file is scanned instead */
+    spec.bad_idx1_entry = false;
+    b = build(&spec);
+    s_case = "idx1 longer than the file";
+    size_t idx1 = b.len - 8 - FRAMES * 16 - FRAMES / 2 * 16;
+    CHECK(memcmp(b.data + idx1, "idx1", 4) == 0, "idx1 not found");
+    set32(&b, idx1 + 4, 0x7FFFFFF0U);
+    CHECK(try_open(b.data, b.len, true, CHECK_PAYLOAD, &frames, &type) == ESP_OK, "open failed");
+    CHECK(frames == FRAMES && type == AVI_INDEX_NONE, "%u frames, index type %d", frames, type);
+    free(b.data);
+
+    /* super index pointing nowhere: idx1 covers the first RIFF */
+    spec = (avi_spec_t) {.index = INDEX_ODML, .audio = true, .bad_super_index = true};
+    b = build(&spec);
+    s_case = "bad OpenDML super index";
+    CHECK(try_open(b.data, b.len, true, CHECK_PAYLOAD, &frames, &type) == ESP_OK, "open failed");
+    CHECK(frames == ODML_SPLIT && type == AVI_INDEX_IDX1, "%u frames, index type %d", frames, type);
+    free(b.data);
+
+    printf("%-40s %s\n", "bad indexes", s_failures > before ? "FAIL" : "PASS");
+}
+
+/* bytes of the headers and indexes changed at random, many times */
+static void test_mutations(const avi_spec_t *spec, const char *name, int rounds)
+{
+    avi_buf_t b = build(spec);
+    uint8_t *copy = malloc(b.len);
+    uint32_t seed = 12345;
+    int before = s_failures, opened = 0;
+
+    s_case = name;
+    for (int i = 0; i < rounds; i++) {
+        memcpy(copy, b.data, b.len);
+        int changes = 1 + i % 4;
+        for (int k = 0; k < changes; k++) {
+            seed = seed * 1103515245u + 12345u;
+            /* mostly the headers and the size fields, where the walkers are */
+            size_t pos = (seed >> 8) % (i % 2 ? b.len : 512);
+            seed = seed * 1103515245u + 12345u;
+            copy[pos] = (seed >> 16) & 1 ? (uint8_t)(seed >> 8) : 0xFF;
+        }
+        uint32_t frames = 0;
+        avi_index_type_t type;
+        opened += try_open(copy, b.len, spec->audio, CHECK_ANY, &frames, &type) == ESP_OK;
+    }
+    free(copy);
+    free(b.data);
+    printf("%-40s %s (%d of %d open)\n", name, s_failures > before ? "FAIL" : "PASS", opened, rounds);
+}
+
+int main(int argc, char **argv)
+{
+    snprintf(s_path, sizeof(s_path), "%s/avi_demux_test.avi", argc > 1 ? argv[1] : "/tmp");
+    signal(SIGALRM, on_timeout);
+
+    test_good("idx1, video only", &(avi_spec_t) {.index = INDEX_IDX1});
+    test_good("idx1 with audio", &(avi_spec_t) {.index = INDEX_IDX1, .audio = true});
+    test_good("idx1 with file offsets", &(avi_spec_t) {.index = INDEX_IDX1_ABS, .audio = true});
+    test_good("no index", &(avi_spec_t) {.index = INDEX_NONE, .audio = true});
+    test_good("OpenDML, RIFF AVIX", &(avi_spec_t) {.index = INDEX_ODML, .audio = true});
+    test_good("OpenDML, video only", &(avi_spec_t) {.index = INDEX_ODML});
+
+    test_oversized();
+    test_bad_index();
+    test_truncated("truncated, idx1", &(avi_spec_t) {.index = INDEX_IDX1, .audio = true});
+    test_truncated("truncated, no index", &(avi_spec_t) {.index = INDEX_NONE, .audio = true});
+    test_truncated("truncated, OpenDML", &(avi_spec_t) {.index = INDEX_ODML, .audio = true});
+    test_mutations(&(avi_spec_t) {.index = INDEX_IDX1, .audio = true}, "random changes, idx1", 1000);
+    test_mutations(&(avi_spec_t) {.index = INDEX_ODML, .audio = true}, "random changes, OpenDML", 1000);
+
+    remove(s_path);
+    printf("%s\n", s_failures ? "FAIL" : "PASS");
+    return s_failures ? 1 : 0;
+}
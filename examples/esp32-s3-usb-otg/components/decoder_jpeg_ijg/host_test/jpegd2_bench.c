@@ -0,0 +1,492 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Bit exactness and decode time of the MJPEG decoder (jpegd2.h) against plain libjpeg.
+ *
+ * Frames are encoded with the compressor of the same jpeg-9a tree: 4:4:4, 4:2:2, 4:4:0,
+ * 4:2:0 and grayscale, which take the fused raw-data path to RGB565, and 4:1:1 and RGB
+ * JPEGs, which go through the library's color conversion. Each in baseline and
+ * progressive, with and without restart markers, at sizes that end in partial MCUs.
+ * An abbreviated frame without tables follows a full one, as in MJPEG streams.
+ *
+ * Every frame is decoded at 1/1, 1/2, 1/4 and 1/8 and with JPEGD2_SCALE_FIT on several
+ * lcd sizes, into bands of several heights and one or two outbuffers. The lcd picture
+ * must be bit for bit the one libjpeg gives with the same IDCT and upsampling settings
+ * (JDCT_IFAST, no fancy upsampling, RGB output truncated to RGB565), cropped to the lcd,
+ * and the bands must cover it from top to bottom in the outbuffers in turn. FIT must
+ * pick the largest scale that fits, or 1/8.
+ *
+ * Then the time per frame of jpegd2 is printed next to the one of libjpeg's RGB output
+ * converted to RGB565 line by line, the path mjpegdraw used before. Host times only
+ * compare the two, the target is slower.
+ *
+ * Usage:
+ *     jpegd2_bench [-n runs] [file.jpg ...]     -n decodes per timed frame, files are checked too
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "jpegd2.h"
+
+#define SENTINEL        0xDEAD
+#define MAX_BUFFERS     2
+
+typedef struct {
+    const char *name;
+    int h_samp;                 /*!< of luma, chroma is 1x1 */
+    int v_samp;
+    J_COLOR_SPACE space;        /*!< of the JPEG */
+} sampling_t;
+
+static const sampling_t s_samplings[] = {
+    {"4:4:4", 1, 1, JCS_YCbCr},
+    {"4:2:2", 2, 1, JCS_YCbCr},
+    {"4:4:0", 1, 2, JCS_YCbCr},
+    {"4:2:0", 2, 2, JCS_YCbCr},
+    {"gray", 1, 1, JCS_GRAYSCALE},
+    {"4:1:1", 4, 1, JCS_YCbCr},
+    {"RGB", 1, 1, JCS_RGB},
+};
+
+typedef struct {
+    uint8_t *data;
+    unsigned long size;
+} jpeg_buf_t;
+
+static int s_failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL "); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        s_failures++; \
+    } \
+} while (0)
+
+/* gradients, bars and noise, so that chroma changes fast and colors clip */
+static void make_picture(uint8_t *rgb, int width, int height, int seed)
+{
+    uint32_t noise = 0x12345678u + seed;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint8_t *p = rgb + 3 * ((size_t)y * width + x);
+            noise = noise * 1103515245u + 12345u;
+            int n = (int)((noise >> 16) & 31) - 16;
+            int bar = ((x + seed * 3) / 7 + y / 11) % 5;
+            p[0] = (uint8_t)(bar == 0 ? 255 : (x * 255 / width + n) & 0xFF);
+            p[1] = (uint8_t)(bar == 1 ? 0 : (y * 255 / height + seed * 16 - n) & 0xFF);
+            p[2] = (uint8_t)(bar == 2 ? 255 - p[0] : ((x + y) * 3 + n) & 0xFF);
+        }
+    }
+}
+
+static void encode(const uint8_t *rgb, int width, int height, const sampling_t *s, bool progressive, int restart,
+                   j_compress_ptr cinfo, bool tables, jpeg_buf_t *out)
+{
+    out->data = NULL;
+    out->size = 0;
+    jpeg_mem_dest(cinfo, &out->data, &out->size);
+    cinfo->image_width = width;
+    cinfo->image_height = height;
+    cinfo->input_components = 3;
+    cinfo->in_color_space = JCS_RGB;
+    jpeg_set_defaults(cinfo);
+    jpeg_set_colorspace(cinfo, s->space);
+    jpeg_set_quality(cinfo, 85, TRUE);
+    if (s->space == JCS_YCbCr) {
+        cinfo->comp_info[0].h_samp_factor = s->h_samp;
+        cinfo->comp_info[0].v_samp_factor = s->v_samp;
+    }
+    if (progressive) {
+        jpeg_simple_progression(cinfo);
+    }
+    cinfo->restart_interval = restart;
+    /* MJPEG frames often leave the tables out, the decoder keeps the last ones */
+    jpeg_suppress_tables(cinfo, !tables);
+    jpeg_start_compress(cinfo, FALSE);
+    while (cinfo->next_scanline < cinfo->image_height) {
+        JSAMPROW row = (JSAMPROW)(rgb + (size_t)cinfo->next_scanline * width * 3);
+        jpeg_write_scanlines(cinfo, &row, 1);
+    }
+    jpeg_finish_compress(cinfo);
+}
+
+static inline uint16_t to_rgb565(const JSAMPLE *p, int components)
+{
+    int r = p[0], g = components == 3 ? p[1] : p[0], b = components == 3 ? p[2] : p[0];
+    return (uint16_t)((r & 0xF8) << 8 | (g & 0xFC) << 3 | b >> 3);
+}
+
+/*
+ * Reference: libjpeg with the settings of jpegd2, RGB or gray scanlines to RGB565. The
+ * decompressor is kept, like the tables of an MJPEG stream.
+ */
+static uint16_t *decode_reference(j_decompress_ptr cinfo, const jpeg_buf_t *jpeg, int denom, uint32_t *width,
+                                  uint32_t *height)
+{
+    jpeg_mem_src(cinfo, jpeg->data, jpeg->size);
+    jpeg_read_header(cinfo, TRUE);
+    cinfo->dct_method = JDCT_IFAST;
+    cinfo->do_fancy_upsampling = FALSE;
+    cinfo->scale_num = 1;
+    cinfo->scale_denom = denom;
+    if (cinfo->num_components != 1) {
+        cinfo->out_color_space = JCS_RGB;
+    }
+    jpeg_start_decompress(cinfo);
+
+    uint16_t *picture = malloc((size_t)cinfo->output_width * cinfo->output_height * sizeof(uint16_t));
+    JSAMPARRAY line = (*cinfo->mem->alloc_sarray)((j_common_ptr)cinfo, JPOOL_IMAGE,
+                      cinfo->output_width * cinfo->output_components, 1);
+    while (cinfo->output_scanline < cinfo->output_height) {
+        uint16_t *out = picture + (size_t)cinfo->output_scanline * cinfo->output_width;
+        jpeg_read_scanlines(cinfo, line, 1);
+        for (JDIMENSION x = 0; x < cinfo->output_width; x++) {
+            out[x] = to_rgb565(line[0] + x * cinfo->output_components, cinfo->output_components);
+        }
+    }
+    *width = cinfo->output_width;
+    *height = cinfo->output_height;
+    jpeg_finish_decompress(cinfo);
+    return picture;
+}
+
+/* the lcd the bands are written to */
+typedef struct {
+    uint16_t *pixels;
+    size_t width;
+    size_t height;
+    uint8_t *const *buffers;
+    size_t count;
+    size_t band_bytes;
+    uint32_t next_y;
+    uint32_t bands;
+    uint32_t band_width;        /*!< expected */
+    bool bad;
+} lcd_t;
+
+static bool lcd_band_cb(void *user_ctx, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *data)
+{
+    lcd_t *lcd = user_ctx;
+
+    /* top to bottom, full width, in the outbuffers in turn */
+    if (x != 0 || y != lcd->next_y || w != lcd->band_width || 0 == h || y + h > lcd->height ||
+            (size_t)w * h * 2 > lcd->band_bytes || (uint8_t *)data != lcd->buffers[lcd->bands % lcd->count]) {
+        lcd->bad = true;
+        return true;
+    }
+    for (uint16_t r = 0; r < h; r++) {
+        memcpy(lcd->pixels + (size_t)(y + r) * lcd->width, data + (size_t)r * w, (size_t)w * 2);
+    }
+    lcd->next_y = y + h;
+    lcd->bands++;
+    return true;
+}
+
+static bool null_band_cb(void *user_ctx, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *data)
+{
+    (void)user_ctx;
+    (void)x;
+    (void)y;
+    (void)w;
+    (void)h;
+    (void)data;
+    return true;
+}
+
+static int fit_denom(uint32_t width, uint32_t height, size_t lcd_width, size_t lcd_height)
+{
+    for (int denom = 1; denom < 8; denom *= 2) {
+        if ((width + denom - 1) / denom <= lcd_width && (height + denom - 1) / denom <= lcd_height) {
+            return denom;
+        }
+    }
+    return 8;
+}
+
+typedef struct {
+    size_t lcd_width;
+    size_t lcd_height;
+    size_t out_width;           /*!< outbuffer, 0 for the lcd width */
+    size_t out_height;
+    size_t count;
+} output_t;
+
+static const output_t s_outputs[] = {
+    {320, 240, 0, 16, 2},
+    {320, 240, 0, 7, 1},        /*!< odd band height */
+    {240, 320, 100, 50, 2},     /*!< outbuffer narrower than the picture */
+    {160, 120, 0, 1, 1},        /*!< one line per band */
+    {40, 30, 0, 30, 2},
+    {8, 6, 0, 4, 1},            /*!< smaller than even 1/8, cropped */
+};
+
+/* one frame at one scale on one output: jpegd2 must draw exactly what libjpeg decodes */
+static int check_frame(const char *what, jpegd2_handle_t dec, j_decompress_ptr ref, const jpeg_buf_t *jpeg,
+                       jpegd2_scale_t scale, const output_t *o, uint32_t image_width, uint32_t image_height)
+{
+    static const int denoms[] = {0, 1, 2, 4, 8};
+    int denom = scale == JPEGD2_SCALE_FIT ? fit_denom(image_width, image_height, o->lcd_width, o->lcd_height) :
+                denoms[scale];
+    uint32_t ref_width, ref_height, width, height;
+    uint16_t *expect = decode_reference(ref, jpeg, denom, &ref_width, &ref_height);
+    int before = s_failures;
+
+    size_t out_width = o->out_width ? o->out_width : o->lcd_width;
+    uint8_t *buffers[MAX_BUFFERS];
+    for (size_t i = 0; i < o->count; i++) {
+        buffers[i] = malloc(out_width * o->out_height * 2);
+    }
+    lcd_t lcd = {
+        .pixels = malloc(o->lcd_width * o->lcd_height * 2),
+        .width = o->lcd_width,
+        .height = o->lcd_height,
+        .buffers = buffers,
+        .count = o->count,
+        .band_bytes = out_width * o->out_height * 2,
+        .band_width = ref_width < o->lcd_width ? ref_width : o->lcd_width,
+    };
+    for (size_t i = 0; i < o->lcd_width * o->lcd_height; i++) {
+        lcd.pixels[i] = SENTINEL;
+    }
+
+    bool ok = jpegd2_decode(dec, jpeg->data, jpeg->size, buffers, o->count, out_width, o->out_height, lcd_band_cb,
+                            &lcd, o->lcd_width, o->lcd_height);
+    CHECK(ok, "%s: decode failed", what);
+    jpegd2_get_output_size(dec, &width, &height);
+    CHECK(width == ref_width && height == ref_height, "%s: %ux%u, libjpeg %ux%u", what, width, height, ref_width,
+          ref_height);
+
+    uint32_t draw_height = ref_height < o->lcd_height ? ref_height : o->lcd_height;
+    CHECK(!lcd.bad && lcd.next_y == draw_height, "%s: bands out of order, %u of %u lines", what, lcd.next_y,
+          draw_height);
+    int diffs = 0;
+    for (size_t y = 0; y < o->lcd_height; y++) {
+        for (size_t x = 0; x < o->lcd_width; x++) {
+            bool inside = x < lcd.band_width && y < draw_height;
+            uint16_t want = inside ? expect[y * ref_width + x] : SENTINEL;
+            if (lcd.pixels[y * o->lcd_width + x] != want && diffs++ == 0) {
+                printf("FAIL %s: pixel (%zu,%zu) is %04x, libjpeg %04x\n", what, x, y,
+                       lcd.pixels[y * o->lcd_width + x], want);
+            }
+        }
+    }
+    if (diffs) {
+        printf("FAIL %s: %d pixels differ\n", what, diffs);
+        s_failures++;
+    }
+
+    free(lcd.pixels);
+    for (size_t i = 0; i < o->count; i++) {
+        free(buffers[i]);
+    }
+    free(expect);
+    return s_failures > before;
+}
+
+/* every scale on every output, returns the number of failed combinations */
+static int check_all(const char *name, j_decompress_ptr ref, const jpeg_buf_t *jpeg, uint32_t width, uint32_t height)
+{
+    static const char *scale_names[] = {"fit", "1/1", "1/2", "1/4", "1/8"};
+    char what[160];
+    int failed = 0;
+
+    for (int s = JPEGD2_SCALE_FIT; s <= JPEGD2_SCALE_1_8; s++) {
+        for (size_t o = 0; o < sizeof(s_outputs) / sizeof(s_outputs[0]); o++) {
+            snprintf(what, sizeof(what), "%s, %s on %zux%zu, bands of %zu lines in %zu", name, scale_names[s],
+                     s_outputs[o].lcd_width, s_outputs[o].lcd_height, s_outputs[o].out_height, s_outputs[o].count);
+            jpegd2_handle_t dec = jpegd2_create(s);
+            failed += check_frame(what, dec, ref, jpeg, s, &s_outputs[o], width, height);
+            jpegd2_delete(dec);
+        }
+    }
+    return failed;
+}
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* ms per frame of jpegd2 and of the libjpeg RGB path, scaled to fit a 320x240 lcd */
+static void bench(const char *name, const jpeg_buf_t *jpeg, int runs)
+{
+    static uint8_t band[320 * 16 * 2];
+    uint8_t *const buffers[1] = {band};
+    jpegd2_handle_t dec = jpegd2_create(JPEGD2_SCALE_FIT);
+    struct jpeg_decompress_struct ref;
+    struct jpeg_error_mgr jerr;
+    uint32_t width, height;
+
+    ref.err = jpeg_std_error(&jerr);
+    jpeg_create_decompress(&ref);
+    jpeg_mem_src(&ref, jpeg->data, jpeg->size);
+    jpeg_read_header(&ref, TRUE);
+    int denom = fit_denom(ref.image_width, ref.image_height, 320, 240);
+    jpeg_abort_decompress(&ref);
+
+    double t0 = now_ms();
+    for (int i = 0; i < runs; i++) {
+        jpegd2_decode(dec, jpeg->data, jpeg->size, buffers, 1, 320, 16, null_band_cb, NULL, 320, 240);
+    }
+    double t1 = now_ms();
+    for (int i = 0; i < runs; i++) {
+        free(decode_reference(&ref, jpeg, denom, &width, &height));
+    }
+    double t2 = now_ms();
+
+    double fused = (t1 - t0) / runs, lib = (t2 - t1) / runs;
+    printf("%-34s %8.3f %8.3f %6.2fx\n", name, fused, lib, lib / fused);
+    jpeg_destroy_decompress(&ref);
+    jpegd2_delete(dec);
+}
+
+static bool load_file(const char *path, jpeg_buf_t *out)
+{
+    FILE *f = fopen(path, "rb");
+    if (NULL == f) {
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    out->size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    out->data = malloc(out->size);
+    bool ok = fread(out->data, 1, out->size, f) == out->size;
+    fclose(f);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    static const struct {
+        int width;
+        int height;
+    } sizes[] = {{320, 240}, {401, 303}, {57, 33}};
+    int runs = 50;
+    int first_file = 1;
+    struct jpeg_compress_struct enc;
+    struct jpeg_decompress_struct ref;
+    struct jpeg_error_mgr enc_err, ref_err;
+    char name[96];
+
+    if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+        runs = atoi(argv[2]);
+        first_file = 3;
+    }
+    enc.err = jpeg_std_error(&enc_err);
+    jpeg_create_compress(&enc);
+    ref.err = jpeg_std_error(&ref_err);
+    jpeg_create_decompress(&ref);
+
+    /* sampling x baseline/progressive/restarts x size */
+    for (size_t s = 0; s < sizeof(s_samplings) / sizeof(s_samplings[0]); s++) {
+        for (int mode = 0; mode < 3; mode++) {
+            int failed = 0;
+            for (size_t z = 0; z < sizeof(sizes) / sizeof(sizes[0]); z++) {
+                int w = sizes[z].width, h = sizes[z].height;
+                uint8_t *rgb = malloc((size_t)w * h * 3);
+                jpeg_buf_t jpeg;
+
+                make_picture(rgb, w, h, (int)(s * 3 + mode));
+                encode(rgb, w, h, &s_samplings[s], mode == 1, mode == 2 ? 3 : 0, &enc, true, &jpeg);
+                snprintf(name, sizeof(name), "%s %s %dx%d", s_samplings[s].name,
+                         mode == 1 ? "progressive" : (mode == 2 ? "restarts" : "baseline"), w, h);
+                failed += check_all(name, &ref, &jpeg, w, h);
+                free(jpeg.data);
+                free(rgb);
+            }
+            printf("%-34s %s\n", name, failed ? "FAIL" : "PASS");
+        }
+    }
+
+    /* an MJPEG stream: the first frame carries the tables, the next ones do not */
+    {
+        const int w = 320, h = 240;
+        uint8_t *rgb = malloc((size_t)w * h * 3);
+        jpeg_buf_t full, abbreviated;
+        int failed = 0;
+
+        make_picture(rgb, w, h, 1);
+        encode(rgb, w, h, &s_samplings[3], false, 0, &enc, true, &full);
+        make_picture(rgb, w, h, 2);
+        encode(rgb, w, h, &s_samplings[3], false, 0, &enc, false, &abbreviated);
+        CHECK(abbreviated.size < full.size, "the abbreviated frame still has its tables");
+        for (int s = JPEGD2_SCALE_FIT; s <= JPEGD2_SCALE_1_8; s++) {
+            jpegd2_handle_t dec = jpegd2_create(s);
+            failed += check_frame("MJPEG first frame", dec, &ref, &full, s, &s_outputs[0], w, h);
+            failed += check_frame("MJPEG frame without tables", dec, &ref, &abbreviated, s, &s_outputs[0], w, h);
+            /* a broken frame is refused, the decoder goes on with the next one */
+            static const uint8_t junk[] = {0xFF, 0xD8, 0xFF, 0xC0, 0x00, 0x02, 0x47, 0x11};
+            uint8_t *const buffers[1] = {rgb};
+            CHECK(!jpegd2_decode(dec, junk, sizeof(junk), buffers, 1, 320, 16, null_band_cb, NULL, 320, 240),
+                  "a broken frame was decoded");
+            failed += check_frame("MJPEG frame after a broken one", dec, &ref, &abbreviated, s, &s_outputs[0], w, h);
+            jpegd2_delete(dec);
+        }
+        printf("%-34s %s\n", "MJPEG tables kept between frames", failed ? "FAIL" : "PASS");
+        free(full.data);
+        free(abbreviated.data);
+        free(rgb);
+    }
+
+    /* files from the command line */
+    for (int i = first_file; i < argc; i++) {
+        jpeg_buf_t jpeg;
+        if (!load_file(argv[i], &jpeg)) {
+            CHECK(false, "cannot read %s", argv[i]);
+            continue;
+        }
+        jpeg_mem_src(&ref, jpeg.data, jpeg.size);
+        jpeg_read_header(&ref, TRUE);
+        uint32_t w = ref.image_width, h = ref.image_height;
+        jpeg_abort_decompress(&ref);
+        printf("%-34s %s\n", argv[i], check_all(argv[i], &ref, &jpeg, w, h) ? "FAIL" : "PASS");
+        free(jpeg.data);
+    }
+
+    /* decode time */
+    printf("\n%-34s %8s %8s %7s\n", "ms per frame, 320x240 lcd", "jpegd2", "libjpeg", "");
+    static const struct {
+        int sampling;
+        bool progressive;
+        int width;
+        int height;
+    } timed[] = {
+        {3, false, 320, 240},
+        {1, false, 320, 240},
+        {0, false, 320, 240},
+        {4, false, 320, 240},
+        {3, true, 320, 240},
+        {3, false, 640, 480},
+        {3, false, 1280, 720},
+        {5, false, 320, 240},
+    };
+    for (size_t t = 0; t < sizeof(timed) / sizeof(timed[0]); t++) {
+        int w = timed[t].width, h = timed[t].height;
+        uint8_t *rgb = malloc((size_t)w * h * 3);
+        jpeg_buf_t jpeg;
+
+        make_picture(rgb, w, h, 5);
+        encode(rgb, w, h, &s_samplings[timed[t].sampling], timed[t].progressive, 0, &enc, true, &jpeg);
+        snprintf(name, sizeof(name), "%s%s %dx%d", s_samplings[timed[t].sampling].name,
+                 timed[t].progressive ? " progressive" : "", w, h);
+        bench(name, &jpeg, runs);
+        free(jpeg.data);
+        free(rgb);
+    }
+
+    jpeg_destroy_compress(&enc);
+    jpeg_destroy_decompress(&ref);
+    printf("%s\n", s_failures ? "FAIL" : "PASS");
+    return s_failures ? 1 : 0;
+}
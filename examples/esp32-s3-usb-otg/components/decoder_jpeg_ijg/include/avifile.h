@@ -1,8 +1,16 @@
 #ifndef __AVIFILE_H
 #define __AVIFILE_H
 
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
 #include "avi_def.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 //#define DEBUGINFO	//信息打印开关
 
 /** big_endian */
@@ -33,111 +41,123 @@
 #define vids_ID     _REV(0x76696473)
 #define auds_ID     _REV(0x61756473)
 
-
-typedef struct
-{	
-    uint32_t  RIFFchunksize;
-    uint32_t  LISTchunksize;
-    uint32_t  avihsize;
-    uint32_t  strlsize;
-    uint32_t  strhsize;
-
-    uint32_t movi_start; //数据块的起始位置
-    uint32_t movi_size;
-
-    uint16_t vids_fps;
-    uint16_t vids_width;
-    uint16_t vids_height;
-
-    uint16_t auds_channels;
-    uint16_t auds_sample_rate;
-    uint16_t auds_bits;
-
-}AVI_TypeDef;
-
-// typedef struct
-// {	
-// 	uint32_t  SecPerFrame;	//显示每帧的时间
-// 	uint32_t  MaxByteSec; 	//最大数据传输率
-// 	uint32_t  ChunkBase; 	//块长度为此值的倍数，通常为2048
-// 	uint32_t  SpecProp;	  //AVI文件的特殊属性
-// 	uint32_t  TotalFrame;	//文件总帧数
-// 	uint32_t  InitFrames;  //开始播放前的初始化帧数
-// 	uint32_t  Streams;		  //包含的数据流种类
-// 	uint32_t  RefBufSize;  //建议使用的缓冲区大小，通常为存储一帧图像与同步音频数据之和
-// 	uint32_t  Width;		    //图像宽
-// 	uint32_t  Height;		  //图像高
-// 	uint32_t  Reserved;	  //保留
-// }avih_TypeDef;
-
-// typedef struct
-// {	
-// 	uint8_t StreamType[4];//数据流种类，vids(0x73646976):视频,auds:音频
-// 	uint8_t Handler[4];	  //数据解压缩的驱动程序代号
-// 	uint32_t   StreamFlag;   //数据流属性
-// 	uint32_t    Priority;	    //此数据流播放的优先级
-// 	uint32_t    Language;	    //音频的语言代号
-// 	uint32_t   InitFrames;   //开始播放前的初始化帧数
-// 	uint32_t   Scale;		    //视频每帧的大小或音频的采样率
-// 	uint32_t   Rate; 		    //Scale/Rate=每秒采样数
-// 	uint32_t   Start;		    //数据流开始播放的位置，单位为Scale
-// 	uint32_t   Length;		    //数据流的数据量，单位为Scale
-//  	uint32_t   RefBufSize;   //建议使用的缓冲区大小
-//   uint32_t   Quality;		  //解压缩质量参数，值越大，质量越好
-// 	uint32_t   SampleSize;	  //音频的样本大小
-// 	struct{				
-// 	  short int  Left;
-// 		short int  Top;
-// 		short int  Right;
-// 		short int  Bottom;
-// 	}Frame;				        //视频帧所占的矩形 
-// }strh_TypeDef;
-
-// typedef struct tagBMPHEADER
-// {
-//   uint32_t  	Size;		      //本结构所占用字节数
-// 	long   	Width;		    //图像宽
-// 	long   	Height;		    //图像高
-// 	uint32_t   	Planes;		    //平面数，必须为1
-// 	uint32_t   	BitCount;	    //像素位数
-// 	uint8_t  	Compression[4];	//压缩类型，MJPEG
-// 	uint32_t  	SizeImage;	  //图像大小
-// 	long   	XpixPerMeter; //水平分辨率
-// 	long   	YpixPerMeter; //垂直分辨率
-// 	uint32_t  	ClrUsed;		  //实际使用了调色板中的颜色数,压缩格式中不使用
-// 	uint32_t  	ClrImportant; //重要的颜色
-// }BMPHEADER;             //该结构占用40字节
-
-// typedef struct tagRGBQUAD 
-// {
-// 	uint8_t  rgbBlue;	      //蓝色的亮度(值范围为0-255)
-// 	uint8_t  rgbGreen;       //绿色的亮度(值范围为0-255)
-// 	uint8_t  rgbRed; 	      //红色的亮度(值范围为0-255)
-// 	uint8_t  rgbReserved;    //保留，必须为0
-// }RGBQUAD;               //颜色表
-
-// typedef struct tagBITMAPINFO 
-// {
-// 	BMPHEADER  bmiHeader;  //位图信息头
-// 	RGBQUAD    bmColors[1];//颜色表
-// }BITMAPINFO;  
-
-// typedef struct 
-// {
-//   uint32_t  FormatTag;
-// 	uint32_t  Channels;	  //声道数
-// 	uint32_t SampleRate; //采样率
-// 	uint32_t BaudRate;   //波特率
-// 	uint32_t  BlockAlign; //数据块对齐标志
-// 	uint32_t  Size;       //该结构大小
-// }WAVEFORMAT;
-
-#define	 MAKEWORD(ptr)	(uint32_t)(((uint32_t)*((uint8_t*)(ptr))<<8)|(uint32_t)*(uint8_t*)((ptr)+1))
-#define  MAKEuint32_t(ptr)	(uint32_t)(((uint32_t)*(uint8_t*)(ptr)|(((uint32_t)*(uint8_t*)(ptr+1))<<8)|\
-                        (((uint32_t)*(uint8_t*)(ptr+2))<<16)|(((uint32_t)*(uint8_t*)(ptr+3))<<24))) 
-
-
-int AVI_Parser(const uint8_t *buffer, uint32_t length);
-
+/**
+ * Streaming AVI demuxer.
+ *
+ * The chunk index of the file (OpenDML `indx`/`ix##`, else `idx1`, else a scan of the
+ * chunk headers in `movi`) is loaded once at open, so every video frame can be reached
+ * directly. Stream numbers are taken from the stream headers: the first MJPEG video
+ * stream and the first audio stream are played, whatever their number.
+ *
+ * Chunks are read ahead into one pool: consecutive chunks are fetched with a single
+ * read, and frames point into the pool instead of being copied. A frame stays valid
+ * until it is released, frames can be released in any order.
+ */
+
+typedef struct avi_demux *avi_demux_handle_t;
+
+typedef enum {
+    AVI_INDEX_NONE = 0,         /*!< no index in the file, built by scanning movi */
+    AVI_INDEX_IDX1,             /*!< AVI 1.0 idx1 */
+    AVI_INDEX_ODML,             /*!< OpenDML super index, also covers the AVIX extensions beyond 1 GB */
+} avi_index_type_t;
+
+typedef enum {
+    AVI_FRAME_VIDEO = 0,
+    AVI_FRAME_AUDIO,
+} avi_frame_type_t;
+
+typedef struct {
+    size_t pool_size;           /*!< read-ahead pool in bytes, 0 for AVI_DEMUX_DEFAULT_POOL_SIZE, always at least three of the largest chunk */
+    uint32_t pool_caps;         /*!< heap capabilities of the pool, 0 for MALLOC_CAP_8BIT */
+    bool audio;                 /*!< also read the audio stream */
+} avi_demux_config_t;
+
+#define AVI_DEMUX_DEFAULT_POOL_SIZE (64 * 1024)
+
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    uint32_t us_per_frame;
+    uint32_t total_frames;      /*!< video frames in the index */
+    int video_stream;           /*!< stream number, e.g. 0 for "00dc" */
+    int audio_stream;           /*!< -1 if there is no audio stream */
+    uint16_t audio_channels;
+    uint32_t audio_sample_rate;
+    uint16_t audio_bits;
+    avi_index_type_t index_type;
+    uint32_t max_chunk_size;
+} avi_demux_info_t;
+
+typedef struct {
+    avi_frame_type_t type;
+    const uint8_t *data;        /*!< payload in the pool, valid until avi_demux_release */
+    uint32_t size;
+    uint32_t index;             /*!< video frame number or audio chunk number */
+    int64_t pts_us;             /*!< presentation time from the start of the file */
+    bool keyframe;
+    int block;                  /*!< internal, pool block holding the data */
+} avi_frame_t;
+
+/**
+ * @brief Open an AVI file and load its index
+ *
+ * @param filename File to play
+ * @param config Pool and stream options, NULL for the defaults (video only)
+ * @param ret_handle Demuxer handle
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_NOT_FOUND Cannot open the file
+ *     - ESP_ERR_NOT_SUPPORTED No MJPEG video stream or a frame larger than supported
+ *     - ESP_ERR_INVALID_RESPONSE The file is not a valid AVI file
+ *     - ESP_ERR_NO_MEM Not enough memory for the index or the pool
+ */
+esp_err_t avi_demux_open(const char *filename, const avi_demux_config_t *config, avi_demux_handle_t *ret_handle);
+
+/**
+ * @brief Close the file and free the index and the pool, all frames must be released
+ */
+void avi_demux_close(avi_demux_handle_t handle);
+
+void avi_demux_get_info(avi_demux_handle_t handle, avi_demux_info_t *info);
+
+/**
+ * @brief Get the next frame in file order, video and audio interleaved
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_NOT_FOUND End of the file
+ *     - ESP_ERR_NO_MEM The pool is full of unreleased frames
+ *     - ESP_FAIL Read error
+ */
+esp_err_t avi_demux_read(avi_demux_handle_t handle, avi_frame_t *frame);
+
+/**
+ * @brief Get one video frame by number without moving the read position, for trick-play
+ *
+ * @return same as avi_demux_read, ESP_ERR_NOT_FOUND if the frame does not exist
+ */
+esp_err_t avi_demux_read_video(avi_demux_handle_t handle, uint32_t frame_index, avi_frame_t *frame);
+
+/**
+ * @brief Continue avi_demux_read at the last key frame at or before a video frame
+ *
+ * Frames read ahead beyond the position are dropped, frames held by the caller stay valid.
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG frame_index beyond the last frame
+ */
+esp_err_t avi_demux_seek(avi_demux_handle_t handle, uint32_t frame_index);
+
+/**
+ * @brief Return the memory of a frame to the pool
+ */
+void avi_demux_release(avi_demux_handle_t handle, avi_frame_t *frame);
+
+#ifdef __cplusplus
+}
 #endif
 
+#endif
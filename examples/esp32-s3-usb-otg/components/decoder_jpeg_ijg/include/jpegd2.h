@@ -17,6 +17,56 @@ void mjpegdraw(uint8_t *mjpegbuffer, const uint32_t size, uint8_t *outbuffer,
                 const size_t outbuffer_width, const size_t outbuffer_height,
                 lcd_write_cb lcd_cb, const size_t lcd_width, const size_t lcd_height);
 
+/**
+ * Reentrant MJPEG decoder, keeps its IJG decompressor from frame to frame.
+ */
+typedef struct jpegd2_decoder *jpegd2_handle_t;
+
+typedef enum {
+    JPEGD2_SCALE_FIT = 0,   /*!< largest of 1/1, 1/2, 1/4 and 1/8 that fits the lcd, cropped if even 1/8 does not */
+    JPEGD2_SCALE_1_1,       /*!< full size, cropped to the lcd */
+    JPEGD2_SCALE_1_2,
+    JPEGD2_SCALE_1_4,
+    JPEGD2_SCALE_1_8,
+} jpegd2_scale_t;
+
+/**
+ * @brief Called with every decoded band, the band buffer is not written again until
+ *        the callback returns and the other outbuffers were used
+ */
+typedef bool (*jpegd2_band_cb)(void *user_ctx, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *data);
+
+/**
+ * @brief Create a decoder
+ *
+ * @param scale Scaling of the frames, done by the IDCT
+ *
+ * @return Decoder, NULL if out of memory
+ */
+jpegd2_handle_t jpegd2_create(jpegd2_scale_t scale);
+
+void jpegd2_delete(jpegd2_handle_t handle);
+
+/**
+ * @brief Decode one frame and write it to the lcd band by band
+ *
+ * The bands are decoded into outbuffers[0], outbuffers[1], ... in turn, so band_cb may
+ * hand a band to another task and return at once if there is more than one outbuffer.
+ * A band is outbuffer_height lines, or less if the lines of the frame are narrower than
+ * outbuffer_width. The frame is cropped to lcd_width x lcd_height.
+ *
+ * @return false if the frame is not a valid JPEG image or the outbuffers are too small
+ */
+bool jpegd2_decode(jpegd2_handle_t handle, const uint8_t *jpeg, uint32_t size,
+                   uint8_t *const outbuffers[], size_t outbuffer_count,
+                   size_t outbuffer_width, size_t outbuffer_height,
+                   jpegd2_band_cb band_cb, void *user_ctx, size_t lcd_width, size_t lcd_height);
+
+/**
+ * @brief Size of the last decoded frame after scaling, before cropping
+ */
+void jpegd2_get_output_size(jpegd2_handle_t handle, uint32_t *width, uint32_t *height);
+
 #ifdef __cplusplus 
 }
 #endif
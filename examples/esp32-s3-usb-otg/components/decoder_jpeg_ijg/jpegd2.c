@@ -21,22 +21,28 @@
 
 #include <setjmp.h>
 
-/******************** JPEG DECOMPRESSION SAMPLE INTERFACE *******************/
-
-/* This half of the example shows how to read data from the JPEG decompressor.
- * It's a bit more refined than the above, in that we show:
- *   (a) how to modify the JPEG library's standard error-reporting behavior;
- *   (b) how to allocate workspace using the library's memory manager.
+/*
+ * MJPEG decoder on top of the IJG library.
  *
- * Just to make this example a little different from the first one, we'll
- * assume that we do not intend to put the whole image into an in-memory
- * buffer, but to send it line-by-line someplace else.  We need a one-
- * scanline-high JSAMPLE array as a work buffer, and we will let the JPEG
- * memory manager allocate it for us.  This approach is actually quite useful
- * because we don't need to remember to deallocate the buffer separately: it
- * will go away automatically when the JPEG object is cleaned up.
+ * One jpeg_decompress_struct is kept per decoder and reused for every frame, so the
+ * library state, the source manager and the Huffman/quantization tables survive
+ * between frames (MJPEG streams often leave the Huffman tables out of later frames).
+ *
+ * YCbCr frames with 4:4:4, 4:2:2, 4:4:0 or 4:2:0 sampling and grayscale frames are
+ * read as raw component data, one iMCU row at a time, and converted straight into
+ * the band buffer: upsampling and the conversion to RGB565 are done in one pass, the
+ * chroma terms of a sample are computed once for all the pixels sharing it. Other
+ * frames go through the library's RGB output, several scanlines per call.
  */
 
+#define JPEGD2_RAW_ROWS         16          /*!< rows of one component in an iMCU row, for the raw path */
+#define JPEGD2_RAW_COMPONENTS   3
+
+#ifdef CONFIG_COLOR_SPACE_RGB_888
+#define JPEGD2_BYTES_PER_PIXEL  3
+#else
+#define JPEGD2_BYTES_PER_PIXEL  2
+#endif
 
 /*
  * ERROR HANDLING:
@@ -68,8 +74,37 @@ struct my_error_mgr {
 
 typedef struct my_error_mgr *my_error_ptr;
 
-static uint8_t  *jpegbuf;
-static uint32_t jbufsize;
+/* source manager reading one frame from memory */
+typedef struct {
+    struct jpeg_source_mgr pub;
+    JOCTET eoi[2];              /*!< fed to the library if the frame is cut short */
+} jpegd2_source_t;
+
+struct jpegd2_decoder {
+    struct jpeg_decompress_struct cinfo;
+    struct my_error_mgr jerr;
+    jpegd2_source_t src;
+    jpegd2_scale_t scale;
+    JSAMPLE *planes;            /*!< raw component data of one iMCU row */
+    size_t planes_size;
+    JSAMPROW rows[JPEGD2_RAW_COMPONENTS][JPEGD2_RAW_ROWS];
+    JSAMPARRAY comp_rows[JPEGD2_RAW_COMPONENTS];
+    uint32_t output_width;
+    uint32_t output_height;
+};
+
+/* the band buffers filled in turn and handed to the callback */
+typedef struct {
+    uint8_t *const *buffers;
+    size_t count;
+    size_t index;
+    uint32_t width;             /*!< pixels per row */
+    uint32_t rows_per_band;
+    uint32_t rows;              /*!< rows in the current band */
+    uint32_t y;                 /*!< lcd row of the current band */
+    jpegd2_band_cb cb;
+    void *user_ctx;
+} jpegd2_band_t;
 
 /*
  * Here's the routine that will replace the standard error_exit method:
@@ -95,44 +130,34 @@ static void init_source(j_decompress_ptr cinfo)
     //不需要做任何事情.
     return;
 }
-//填充输入缓冲区,一次性读取整帧数据
+
+//整帧数据在内存中, 再次要数据说明帧不完整, 填充结束符
 static boolean fill_input_buffer(j_decompress_ptr cinfo)
 {
-    if (jbufsize == 0) { //结束了
-        printf("jd read off\r\n");
-        //填充结束符
-        jpegbuf[0] = (uint8_t) 0xFF;
-        jpegbuf[1] = (uint8_t) JPEG_EOI;
-        cinfo->src->next_input_byte = jpegbuf;
-        cinfo->src->bytes_in_buffer = 2;
-    } else {
-        cinfo->src->next_input_byte = jpegbuf;
-        cinfo->src->bytes_in_buffer = jbufsize;
-        jbufsize -= jbufsize;
-    }
+    jpegd2_source_t *src = (jpegd2_source_t *)cinfo->src;
 
+    WARNMS(cinfo, JWRN_JPEG_EOF);
+    src->eoi[0] = (JOCTET) 0xFF;
+    src->eoi[1] = (JOCTET) JPEG_EOI;
+    src->pub.next_input_byte = src->eoi;
+    src->pub.bytes_in_buffer = 2;
     return TRUE;
 }
 
-//在文件里面,跳过num_bytes个数据
+//跳过num_bytes个数据
 static void skip_input_data(j_decompress_ptr cinfo, long num_bytes)
 {
-    /* Just a dumb implementation for now.  Could use fseek() except
-    * it doesn't work on pipes.  Not clear that being smart is worth
-    * any trouble anyway --- large skips are infrequent.
-    */
-    if (num_bytes > 0) {
-        while (num_bytes > (long) cinfo->src->bytes_in_buffer) {
-            num_bytes -= (long)cinfo->src->bytes_in_buffer;
-            (void)cinfo->src->fill_input_buffer(cinfo);
-            /* note we assume that fill_input_buffer will never
-            * return FALSE, so suspension need not be handled.
-            */
-        }
+    struct jpeg_source_mgr *src = cinfo->src;
 
-        cinfo->src->next_input_byte += (size_t) num_bytes;
-        cinfo->src->bytes_in_buffer -= (size_t) num_bytes;
+    if (num_bytes <= 0) {
+        return;
+    }
+    if ((size_t) num_bytes > src->bytes_in_buffer) {
+        (void) src->fill_input_buffer(cinfo);
+        return;
     }
+    src->next_input_byte += (size_t) num_bytes;
+    src->bytes_in_buffer -= (size_t) num_bytes;
 }
 
 //在解码结束后,被jpeg_finish_decompress函数调用
@@ -142,163 +167,410 @@ static void term_source(j_decompress_ptr cinfo)
     return;
 }
 
-//初始化jpeg解码数据源
-static void jpeg_filerw_src_init(j_decompress_ptr cinfo)
+static inline int clamp_sample(int v)
 {
-    if (cinfo->src == NULL) {   /* first time for this JPEG object? */
-        cinfo->src = (struct jpeg_source_mgr *)
-                     (*cinfo->mem->alloc_small)((j_common_ptr) cinfo, JPOOL_PERMANENT,
-                                                sizeof(struct jpeg_source_mgr));
-    }
-
-    cinfo->src->init_source = init_source;
-    cinfo->src->fill_input_buffer = fill_input_buffer;
-    cinfo->src->skip_input_data = skip_input_data;
-    cinfo->src->resync_to_restart = jpeg_resync_to_restart; /* use default method */
-    cinfo->src->term_source = term_source;
-    cinfo->src->bytes_in_buffer = 0; /* forces fill_input_buffer on first read */
-    cinfo->src->next_input_byte = NULL; /* until buffer loaded */
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
 }
 
-/*
- * Sample routine for JPEG decompression.  We assume that the source file name
- * is passed in.  We want to return 1 on success, 0 on error.
- */
-void mjpegdraw(uint8_t *mjpegbuffer, const uint32_t size, uint8_t *outbuffer,
-                const size_t outbuffer_width, const size_t outbuffer_height,
-                lcd_write_cb lcd_cb, const size_t lcd_width, const size_t lcd_height)
+static inline uint16_t rgb565(int y, int r, int g, int b)
 {
-    /* This struct contains the JPEG decompression parameters and pointers to
-     * working space (which is allocated as needed by the JPEG library).
-     */
-    struct jpeg_decompress_struct cinfo;
-    /* We use our private extension JPEG error handler.
-     * Note that this struct must live as long as the main JPEG parameter
-     * struct, to avoid dangling-pointer problems.
-     */
-    struct my_error_mgr jerr;
-    /* More stuff */
-    JSAMPARRAY buffer;		/* Output row buffer */
-    int row_stride;		/* physical row width in output buffer */
+    return (uint16_t)((clamp_sample(y + r) & 0xF8) << 8 | (clamp_sample(y + g) & 0xFC) << 3 | clamp_sample(y + b) >> 3);
+}
 
-    /* In this example we want to open the input file before doing anything else,
-     * so that the setjmp() error recovery below can assume the file is open.
-     * VERY IMPORTANT: use "b" option to fopen() if you are on a machine that
-     * requires it in order to read binary files.
-     */
-    jpegbuf = mjpegbuffer;
-    jbufsize = size;
+/* JFIF YCbCr to RGB in 16 bit fixed point, as in jdcolor.c */
+#define YCC_FIX(x)      ((int32_t)((x) * 65536.0 + 0.5))
+#define YCC_HALF        ((int32_t)1 << 15)
 
-    /* Step 1: allocate and initialize JPEG decompression object */
+#define YCC_TERMS(cb, cr, r, g, b) do {                                                    \
+        int _cb = (int)(cb) - 128, _cr = (int)(cr) - 128;                                  \
+        (r) = (YCC_FIX(1.40200) * _cr + YCC_HALF) >> 16;                                   \
+        (g) = (-YCC_FIX(0.344136286) * _cb - YCC_FIX(0.714136286) * _cr + YCC_HALF) >> 16; \
+        (b) = (YCC_FIX(1.77200) * _cb + YCC_HALF) >> 16;                                   \
+    } while (0)
 
-    /* We set up the normal JPEG error routines, then override error_exit. */
-    cinfo.err = jpeg_std_error(&jerr.pub);
-    jerr.pub.error_exit = my_error_exit;
+/* full resolution chroma */
+static void ycc_rgb565_h1(uint16_t *restrict out, const JSAMPLE *restrict y, const JSAMPLE *restrict cb,
+                          const JSAMPLE *restrict cr, uint32_t width)
+{
+    for (uint32_t x = 0; x < width; x++) {
+        int r, g, b;
+        YCC_TERMS(cb[x], cr[x], r, g, b);
+        out[x] = rgb565(y[x], r, g, b);
+    }
+}
 
-    /* Establish the setjmp return context for my_error_exit to use. */
-    if (setjmp(jerr.setjmp_buffer)) {
-        /* If we get here, the JPEG code has signaled an error.
-         * We need to clean up the JPEG object, close the input file, and return.
-         */
-        //jpeg_abort_decompress(&cinfo);
-        jpeg_destroy_decompress(&cinfo);
-        return;
+/* chroma subsampled 2:1 horizontally, each chroma sample is shared by two pixels */
+static void ycc_rgb565_h2(uint16_t *restrict out, const JSAMPLE *restrict y, const JSAMPLE *restrict cb,
+                          const JSAMPLE *restrict cr, uint32_t width)
+{
+    uint32_t x;
+    for (x = 0; x + 1 < width; x += 2) {
+        int r, g, b;
+        YCC_TERMS(cb[x >> 1], cr[x >> 1], r, g, b);
+        out[x] = rgb565(y[x], r, g, b);
+        out[x + 1] = rgb565(y[x + 1], r, g, b);
+    }
+    if (x < width) {
+        int r, g, b;
+        YCC_TERMS(cb[x >> 1], cr[x >> 1], r, g, b);
+        out[x] = rgb565(y[x], r, g, b);
+    }
+}
+
+/* chroma subsampled 2:1 both ways, two rows at once so each chroma sample is shared by four pixels */
+static void ycc_rgb565_h2v2(uint16_t *restrict out0, uint16_t *restrict out1, const JSAMPLE *restrict y0,
+                            const JSAMPLE *restrict y1, const JSAMPLE *restrict cb, const JSAMPLE *restrict cr,
+                            uint32_t width)
+{
+    uint32_t x;
+    for (x = 0; x + 1 < width; x += 2) {
+        int r, g, b;
+        YCC_TERMS(cb[x >> 1], cr[x >> 1], r, g, b);
+        out0[x] = rgb565(y0[x], r, g, b);
+        out0[x + 1] = rgb565(y0[x + 1], r, g, b);
+        out1[x] = rgb565(y1[x], r, g, b);
+        out1[x + 1] = rgb565(y1[x + 1], r, g, b);
+    }
+    if (x < width) {
+        int r, g, b;
+        YCC_TERMS(cb[x >> 1], cr[x >> 1], r, g, b);
+        out0[x] = rgb565(y0[x], r, g, b);
+        out1[x] = rgb565(y1[x], r, g, b);
+    }
+}
+
+static void gray_rgb565(uint16_t *restrict out, const JSAMPLE *restrict y, uint32_t width)
+{
+    for (uint32_t x = 0; x < width; x++) {
+        out[x] = rgb565(y[x], 0, 0, 0);
+    }
+}
+
+static void rgb_rgb565(uint16_t *restrict out, const JSAMPLE *restrict rgb, uint32_t width)
+{
+    for (uint32_t x = 0; x < width; x++) {
+        out[x] = (uint16_t)((rgb[3 * x] & 0xF8) << 8 | (rgb[3 * x + 1] & 0xFC) << 3 | rgb[3 * x + 2] >> 3);
+    }
+}
+
+/* next row of the current band */
+static inline uint8_t *band_row(jpegd2_band_t *band, uint32_t n)
+{
+    return band->buffers[band->index] + (size_t)(band->rows + n) * band->width * JPEGD2_BYTES_PER_PIXEL;
+}
+
+/* count rows written, the band goes to the callback once it is full or at the last row */
+static void band_commit(jpegd2_band_t *band, uint32_t rows, bool last)
+{
+    band->rows += rows;
+    if (band->rows == band->rows_per_band || (last && band->rows)) {
+        band->cb(band->user_ctx, 0, band->y, band->width, band->rows, (uint16_t *)band->buffers[band->index]);
+        band->y += band->rows;
+        band->rows = 0;
+        band->index = (band->index + 1) % band->count;
+    }
+}
+
+/* the raw path handles grayscale and YCbCr with chroma at most 2:1 subsampled after IDCT scaling */
+static bool raw_supported(j_decompress_ptr cinfo)
+{
+#ifdef CONFIG_COLOR_SPACE_RGB_888
+    return false;
+#else
+    if (1 == cinfo->num_components) {
+        return JCS_GRAYSCALE == cinfo->jpeg_color_space;
+    }
+    if (3 != cinfo->num_components || JCS_YCbCr != cinfo->jpeg_color_space || JCT_NONE != cinfo->color_transform) {
+        return false;
+    }
+    jpeg_component_info *luma = &cinfo->comp_info[0];
+    if (luma->h_samp_factor != cinfo->max_h_samp_factor || luma->v_samp_factor != cinfo->max_v_samp_factor ||
+            luma->h_samp_factor > 2 || luma->v_samp_factor > 2) {
+        return false;
+    }
+    for (int ci = 1; ci < 3; ci++) {
+        if (1 != cinfo->comp_info[ci].h_samp_factor || 1 != cinfo->comp_info[ci].v_samp_factor) {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
+
+/* set up the component rows for jpeg_read_raw_data, in memory kept between frames */
+static bool raw_setup(jpegd2_handle_t h, uint32_t *fh, uint32_t *fv)
+{
+    j_decompress_ptr cinfo = &h->cinfo;
+    size_t total = 0;
+    size_t widths[JPEGD2_RAW_COMPONENTS];
+    int rows[JPEGD2_RAW_COMPONENTS];
+
+    for (int ci = 0; ci < cinfo->num_components; ci++) {
+        jpeg_component_info *comp = &cinfo->comp_info[ci];
+        /* whole MCUs are written, also past the right edge */
+        widths[ci] = (size_t)(comp->width_in_blocks + comp->h_samp_factor) * comp->DCT_h_scaled_size;
+        rows[ci] = comp->v_samp_factor * comp->DCT_v_scaled_size;
+        if (rows[ci] > JPEGD2_RAW_ROWS) {
+            return false;
+        }
+        total += widths[ci] * rows[ci];
+    }
+
+    *fh = *fv = 1;
+    if (3 == cinfo->num_components) {
+        /* chroma may already be upsampled by the IDCT, the rest is done while converting */
+        jpeg_component_info *luma = &cinfo->comp_info[0], *chroma = &cinfo->comp_info[1];
+        uint32_t h_num = luma->h_samp_factor * luma->DCT_h_scaled_size, h_den = chroma->DCT_h_scaled_size;
+        uint32_t v_num = luma->v_samp_factor * luma->DCT_v_scaled_size, v_den = chroma->DCT_v_scaled_size;
+        if ((h_num != h_den && h_num != 2 * h_den) || (v_num != v_den && v_num != 2 * v_den) ||
+                cinfo->comp_info[2].DCT_h_scaled_size != chroma->DCT_h_scaled_size ||
+                cinfo->comp_info[2].DCT_v_scaled_size != chroma->DCT_v_scaled_size) {
+            return false;
+        }
+        *fh = h_num / h_den;
+        *fv = v_num / v_den;
+    }
+
+    if (total > h->planes_size) {
+        JSAMPLE *planes = realloc(h->planes, total);
+        if (NULL == planes) {
+            return false;
+        }
+        h->planes = planes;
+        h->planes_size = total;
+    }
+    JSAMPLE *p = h->planes;
+    for (int ci = 0; ci < cinfo->num_components; ci++) {
+        for (int r = 0; r < rows[ci]; r++) {
+            h->rows[ci][r] = p;
+            p += widths[ci];
+        }
+        h->comp_rows[ci] = h->rows[ci];
     }
+    return true;
+}
 
-    /* Now we can initialize the JPEG decompression object. */
-    jpeg_create_decompress(&cinfo);
-
-    /* Step 2: specify data source (eg, a file) */
-
-    jpeg_filerw_src_init(&cinfo); ;
-
-    /* Step 3: read file parameters with jpeg_read_header() */
-
-    (void) jpeg_read_header(&cinfo, TRUE);
-    /* We can ignore the return value from jpeg_read_header since
-     *   (a) suspension is not possible with the stdio data source, and
-     *   (b) we passed TRUE to reject a tables-only JPEG file as an error.
-     * See libjpeg.txt for more info.
-     */
-
-    /* Step 4: set parameters for decompression */
-
-    /* In this example, we don't need to change any of the defaults set by
-     * jpeg_read_header(), so we do nothing here.
-     */
-    cinfo.dct_method = JDCT_IFAST;
-    cinfo.do_fancy_upsampling = 0;
-    cinfo.out_color_space = JCS_RGB;
-    /* Step 5: Start decompressor */
-
-    (void) jpeg_start_decompress(&cinfo);
-    /* We can ignore the return value since suspension is not possible
-     * with the stdio data source.
-     */
-
-    /* We may need to do some setup of our own at this point before reading
-     * the data.  After jpeg_start_decompress() we have the correct scaled
-     * output image dimensions available, as well as the output colormap
-     * if we asked for color quantization.
-     * In this example, we need to make an output work buffer of the right size.
-     */
-    /* JSAMPLEs per row in output buffer */
-    row_stride = cinfo.output_width * cinfo.output_components;
-    /* Make a one-row-high sample array that will go away when done with image */
-    buffer = (*cinfo.mem->alloc_sarray)
-             ((j_common_ptr) &cinfo, JPOOL_IMAGE, row_stride, 1);
-    /* Step 6: while (scan lines remain to be read) */
-    /*           jpeg_read_scanlines(...); */
-
-    /* Here we use the library's state variable cinfo.output_scanline as the
-     * loop counter, so that we don't have to keep track ourselves.
-     *///printf("w=%d, h=%d\n", cinfo.output_width, cinfo.output_height);
-    static uint32_t outbuffer_index = 0;
-    uint32_t index = 0;
-
-    size_t display_height = cinfo.output_height<lcd_height?cinfo.output_height:lcd_height;
-    size_t display_width = cinfo.output_width<lcd_width?cinfo.output_width:lcd_width;
-
-    while (cinfo.output_scanline < display_height) {
-        /* jpeg_read_scanlines expects an array of pointers to scanlines.
-         * Here the array is only one element long, but you could ask for
-         * more than one scanline at a time if that's more convenient.
-         */
-
-#ifdef CONFIG_COLOR_SPACE_RGB_565
-        (void) jpeg_read_scanlines(&cinfo, buffer, 1);
-        /* Assume put_scanline_someplace wants a pointer and sample count. */
-        uint8_t *color_trans_head = buffer[0];
-        uint16_t *out = (uint16_t *)outbuffer;
-        for (index = 0; index < display_width; index++) {
-            uint16_t c = ((*color_trans_head) >> 3) << 11 | ((*(color_trans_head + 1)) >> 2) << 5 | (*(color_trans_head + 2)) >> 3;
-            out[outbuffer_index+index] = c; //big endian
-            color_trans_head += 3;
+/* decode straight from the component data, one iMCU row per call */
+static void decode_raw(jpegd2_handle_t h, jpegd2_band_t *band, uint32_t height, uint32_t fh, uint32_t fv)
+{
+    j_decompress_ptr cinfo = &h->cinfo;
+    const uint32_t lines = cinfo->max_v_samp_factor * cinfo->min_DCT_v_scaled_size;
+    JSAMPARRAY y = h->comp_rows[0], cb = h->comp_rows[1], cr = h->comp_rows[2];
+
+    while (cinfo->output_scanline < height) {
+        uint32_t y0 = cinfo->output_scanline;
+        (void) jpeg_read_raw_data(cinfo, h->comp_rows, lines);
+        uint32_t n = height - y0 < lines ? height - y0 : lines;
+
+        for (uint32_t r = 0; r < n;) {
+            if (1 == cinfo->num_components) {
+                gray_rgb565((uint16_t *)band_row(band, 0), y[r], band->width);
+                r++;
+                band_commit(band, 1, y0 + r == height);
+            } else if (2 == fv && 2 == fh && r + 1 < n && band->rows_per_band > 1) {
+                /* rows per band are even, the pair is always in the same band */
+                ycc_rgb565_h2v2((uint16_t *)band_row(band, 0), (uint16_t *)band_row(band, 1), y[r], y[r + 1],
+                                cb[r >> 1], cr[r >> 1], band->width);
+                r += 2;
+                band_commit(band, 2, y0 + r == height);
+            } else {
+                if (2 == fh) {
+                    ycc_rgb565_h2((uint16_t *)band_row(band, 0), y[r], cb[r / fv], cr[r / fv], band->width);
+                } else {
+                    ycc_rgb565_h1((uint16_t *)band_row(band, 0), y[r], cb[r / fv], cr[r / fv], band->width);
+                }
+                r++;
+                band_commit(band, 1, y0 + r == height);
+            }
         }
-#elif CONFIG_COLOR_SPACE_RGB_888
-        //TODO:display size
-        JSAMPARRAY outbuffer_head = outbuffer + 3 * outbuffer_index;
-        (void) jpeg_read_scanlines(&cinfo, outbuffer_head, 1);
-        index = cinfo.output_width;
+    }
+}
+
+/* decode through the library's color conversion, several scanlines per call */
+static void decode_scanlines(jpegd2_handle_t h, jpegd2_band_t *band, uint32_t height)
+{
+    j_decompress_ptr cinfo = &h->cinfo;
+    const int max_lines = cinfo->rec_outbuf_height;
+    JSAMPARRAY buffer = (*cinfo->mem->alloc_sarray)
+                        ((j_common_ptr) cinfo, JPOOL_IMAGE, cinfo->output_width * cinfo->output_components, max_lines);
+
+    while (cinfo->output_scanline < height) {
+        JDIMENSION n = jpeg_read_scanlines(cinfo, buffer, max_lines);
+        for (JDIMENSION r = 0; r < n && cinfo->output_scanline - n + r < height; r++) {
+            uint8_t *out = band_row(band, 0);
+#ifdef CONFIG_COLOR_SPACE_RGB_888
+            memcpy(out, buffer[r], band->width * 3);
+#else
+            if (1 == cinfo->output_components) {
+                gray_rgb565((uint16_t *)out, buffer[r], band->width);
+            } else {
+                rgb_rgb565((uint16_t *)out, buffer[r], band->width);
+            }
 #endif
-        outbuffer_index += index;
+            band_commit(band, 1, cinfo->output_scanline - n + r + 1 == height);
+        }
+    }
+}
+
+static int scale_denom(jpegd2_scale_t scale, uint32_t width, uint32_t height, size_t lcd_width, size_t lcd_height)
+{
+    switch (scale) {
+    case JPEGD2_SCALE_1_1:
+        return 1;
+    case JPEGD2_SCALE_1_2:
+        return 2;
+    case JPEGD2_SCALE_1_4:
+        return 4;
+    case JPEGD2_SCALE_1_8:
+        return 8;
+    default:
+        break;
+    }
+    /* the largest picture that fits, cropped if even 1/8 does not */
+    int denom = 1;
+    while (denom < 8 && ((width + denom - 1) / denom > lcd_width || (height + denom - 1) / denom > lcd_height)) {
+        denom *= 2;
+    }
+    return denom;
+}
+
+jpegd2_handle_t jpegd2_create(jpegd2_scale_t scale)
+{
+    jpegd2_handle_t h = calloc(1, sizeof(struct jpegd2_decoder));
+    if (NULL == h) {
+        return NULL;
+    }
 
-        if(!(cinfo.output_scanline % outbuffer_height) || outbuffer_index >= (outbuffer_height*outbuffer_width)){
-            lcd_cb(0, cinfo.output_scanline-outbuffer_height, outbuffer_width, outbuffer_height, outbuffer);
-            outbuffer_index = 0;
+    /* We set up the normal JPEG error routines, then override error_exit. */
+    h->cinfo.err = jpeg_std_error(&h->jerr.pub);
+    h->jerr.pub.error_exit = my_error_exit;
+    if (setjmp(h->jerr.setjmp_buffer)) {
+        jpeg_destroy_decompress(&h->cinfo);
+        free(h);
+        return NULL;
+    }
+    jpeg_create_decompress(&h->cinfo);
+
+    h->src.pub.init_source = init_source;
+    h->src.pub.fill_input_buffer = fill_input_buffer;
+    h->src.pub.skip_input_data = skip_input_data;
+    h->src.pub.resync_to_restart = jpeg_resync_to_restart; /* use default method */
+    h->src.pub.term_source = term_source;
+    h->cinfo.src = &h->src.pub;
+    h->scale = scale;
+    return h;
+}
+
+void jpegd2_delete(jpegd2_handle_t handle)
+{
+    if (NULL == handle) {
+        return;
+    }
+    jpeg_destroy_decompress(&handle->cinfo);
+    free(handle->planes);
+    free(handle);
+}
+
+bool jpegd2_decode(jpegd2_handle_t handle, const uint8_t *jpeg, uint32_t size,
+                   uint8_t *const outbuffers[], size_t outbuffer_count,
+                   size_t outbuffer_width, size_t outbuffer_height,
+                   jpegd2_band_cb band_cb, void *user_ctx, size_t lcd_width, size_t lcd_height)
+{
+    jpegd2_handle_t h = handle;
+    j_decompress_ptr cinfo = &h->cinfo;
+    uint32_t fh = 1, fv = 1;
+    bool raw;
+
+    /* Establish the setjmp return context for my_error_exit to use. */
+    if (setjmp(h->jerr.setjmp_buffer)) {
+        /* keep the object, and the tables it holds, for the next frame */
+        jpeg_abort_decompress(cinfo);
+        return false;
+    }
+
+    h->src.pub.next_input_byte = jpeg;
+    h->src.pub.bytes_in_buffer = size;
+    (void) jpeg_read_header(cinfo, TRUE);
+
+    cinfo->dct_method = JDCT_IFAST;
+    cinfo->do_fancy_upsampling = FALSE;
+    cinfo->scale_num = 1;
+    cinfo->scale_denom = scale_denom(h->scale, cinfo->image_width, cinfo->image_height, lcd_width, lcd_height);
+    raw = raw_supported(cinfo);
+    cinfo->raw_data_out = raw;
+    if (!raw && 1 != cinfo->num_components) {
+        cinfo->out_color_space = JCS_RGB;
+    }
+    jpeg_calc_output_dimensions(cinfo);
+    if (raw && !raw_setup(h, &fh, &fv)) {
+        cinfo->raw_data_out = raw = FALSE;
+        if (1 != cinfo->num_components) {
+            cinfo->out_color_space = JCS_RGB;
         }
+    }
+    (void) jpeg_start_decompress(cinfo);
+    h->output_width = cinfo->output_width;
+    h->output_height = cinfo->output_height;
+
+    jpegd2_band_t band = {
+        .buffers = outbuffers,
+        .count = outbuffer_count,
+        .width = cinfo->output_width < lcd_width ? cinfo->output_width : lcd_width,
+        .cb = band_cb,
+        .user_ctx = user_ctx,
+    };
+    uint32_t height = cinfo->output_height < lcd_height ? cinfo->output_height : lcd_height;
+    band.rows_per_band = band.width ? outbuffer_width * outbuffer_height / band.width : 0;
+    if (band.rows_per_band > outbuffer_height) {
+        band.rows_per_band = outbuffer_height;
+    }
+    if (raw && 2 == fv && band.rows_per_band > 1) {
+        band.rows_per_band &= ~1U;      /*!< bands of one line take the rows one by one */
+    }
+    if (0 == band.rows_per_band) {
+        jpeg_abort_decompress(cinfo);
+        return false;
+    }
 
+    if (raw) {
+        decode_raw(h, &band, height, fh, fv);
+    } else {
+        decode_scanlines(h, &band, height);
     }
 
+    /* lines below the lcd are not decoded */
+    if (cinfo->output_scanline < cinfo->output_height) {
+        jpeg_abort_decompress(cinfo);
+    } else {
+        (void) jpeg_finish_decompress(cinfo);
+    }
+    return true;
+}
 
-    /* Step 7: Finish decompression */
-    (void) jpeg_finish_decompress(&cinfo);
-    /* We can ignore the return value since suspension is not possible
-     * with the stdio data source.
-     */
+void jpegd2_get_output_size(jpegd2_handle_t handle, uint32_t *width, uint32_t *height)
+{
+    *width = handle->output_width;
+    *height = handle->output_height;
+}
 
-    /* Step 8: Release JPEG decompression object */
+/* mjpegdraw draws at full size cropped to the lcd, each call with a decoder of its own */
+static bool mjpegdraw_band_cb(void *user_ctx, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *data)
+{
+    lcd_write_cb lcd_cb = (lcd_write_cb)user_ctx;
+    return lcd_cb(x, y, w, h, data);
+}
 
-    /* This is an important step since it will release a good deal of memory. */
-    jpeg_destroy_decompress(&cinfo);
+void mjpegdraw(uint8_t *mjpegbuffer, const uint32_t size, uint8_t *outbuffer,
+                const size_t outbuffer_width, const size_t outbuffer_height,
+                lcd_write_cb lcd_cb, const size_t lcd_width, const size_t lcd_height)
+{
+    uint8_t *const outbuffers[1] = { outbuffer };
+    jpegd2_handle_t decoder = jpegd2_create(JPEGD2_SCALE_1_1);
+
+    if (NULL == decoder) {
+        return;
+    }
+    (void) jpegd2_decode(decoder, mjpegbuffer, size, outbuffers, 1, outbuffer_width, outbuffer_height,
+                         mjpegdraw_band_cb, (void *)lcd_cb, lcd_width, lcd_height);
+    jpegd2_delete(decoder);
 }
@@ -1,9 +1,14 @@
 #include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "esp_err.h"
+#include "esp_timer.h"
 
 #include "avifile.h"
 #include "vidoplayer.h"
@@ -21,17 +26,90 @@ static const char *TAG = "avi player";
         return (ret);                                                                   \
         }
 
-/**
- * TODO: how to recognize each stream id
+/*
+ * Playback runs in three stages that overlap: the calling task reads the file, a decode
+ * task decodes the JPEG frames band by band, and a flush task writes the bands to the
+ * LCD while the next band is decoded into the other band buffer.
  */
-#define  T_vids  _REV(0x30306463)
-#define  T_auds  _REV(0x30317762)
+#define PLAY_FRAME_QUEUE_LEN    2               /*!< video frames read ahead of the decoder */
+#define PLAY_FRAMES_HELD        (PLAY_FRAME_QUEUE_LEN + 2)  /*!< queued, decoding and read */
+#define PLAY_BAND_BUFFERS       2
+#define PLAY_DECODE_STACK       (6 * 1024)
+#define PLAY_FLUSH_STACK        (3 * 1024)
 
-extern AVI_TypeDef AVI_file;
+#ifdef CONFIG_COLOR_SPACE_RGB_888
+#define PLAY_BYTES_PER_PIXEL    3
+#else
+#define PLAY_BYTES_PER_PIXEL    2
+#endif
+
+typedef struct {
+    uint32_t count;
+    int64_t total_us;
+    int64_t min_us;
+    int64_t max_us;
+} play_latency_t;
+
+typedef struct {
+    avi_frame_t frame;
+    int64_t read_time;          /*!< when it was read, for the time spent in the queue */
+    bool end;
+} play_frame_msg_t;
+
+typedef struct {
+    uint16_t *data;             /*!< NULL at the end of the playback */
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+} play_band_msg_t;
+
+typedef struct {
+    avi_demux_info_t info;
+    QueueHandle_t frame_queue;  /*!< read -> decode */
+    QueueHandle_t release_queue;/*!< decode -> read, the demuxer is only used by the reading task */
+    QueueHandle_t band_queue;   /*!< decode -> flush */
+    SemaphoreHandle_t band_free;/*!< band buffers the decoder may fill */
+    SemaphoreHandle_t done;     /*!< the flush task has written the last band */
+    jpegd2_handle_t decoder;
+    uint8_t *band_buffers[PLAY_BAND_BUFFERS];
+    int band_count;
+    int band_next;              /*!< buffer of the next band */
+    size_t band_width;
+    size_t band_height;
+    lcd_write_cb lcd_cb;
+    size_t lcd_width;
+    size_t lcd_height;
+    int64_t clock_start;        /*!< esp_timer time of pts 0, -1 before the first frame */
+    int64_t band_wait_us;       /*!< time the current frame waited for a band buffer */
 
-static uint32_t _REV(uint32_t value){
-    return (value & 0x000000FFU) << 24 | (value & 0x0000FF00U) << 8 | 
-        (value & 0x00FF0000U) >> 8 | (value & 0xFF000000U) >> 24; 
+    play_latency_t read;        /*!< avi_demux_read */
+    play_latency_t queue;       /*!< frame read until its decoding starts */
+    play_latency_t decode;      /*!< without waiting for band buffers */
+    play_latency_t band_wait;
+    play_latency_t flush;       /*!< per band */
+    uint32_t frames_shown;
+    uint32_t frames_dropped;
+} avi_play_ctx_t;
+
+static void latency_add(play_latency_t *l, int64_t us)
+{
+    if (0 == l->count || us < l->min_us) {
+        l->min_us = us;
+    }
+    if (us > l->max_us) {
+        l->max_us = us;
+    }
+    l->total_us += us;
+    l->count++;
+}
+
+static void latency_log(const char *name, const play_latency_t *l)
+{
+    if (l->count) {
+        ESP_LOGI(TAG, "%-9s %6" PRIu32 " x  avg %6" PRId64 " us  min %6" PRId64 " us  max %6" PRId64 " us", name, l->count,
+                 l->total_us / l->count, l->min_us, l->max_us);
+    }
 }
 
 #ifdef CONFIG_AVI_AUDIO
@@ -53,106 +131,289 @@ static void audio_init(void)
 }
 #endif
 
-static uint32_t read_frame(FILE *file, uint8_t *buffer, uint32_t length, uint32_t *fourcc)
+/* called by the decoder for every band: hand it to the flush task and wait for the next buffer */
+static bool play_band_cb(void *user_ctx, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *data)
+{
+    avi_play_ctx_t *ctx = (avi_play_ctx_t *)user_ctx;
+    play_band_msg_t band = { .data = data, .x = x, .y = y, .w = w, .h = h };
+
+    xQueueSend(ctx->band_queue, &band, portMAX_DELAY);
+    int64_t start = esp_timer_get_time();
+    xSemaphoreTake(ctx->band_free, portMAX_DELAY);
+    int64_t wait = esp_timer_get_time() - start;
+    ctx->band_wait_us += wait;
+    latency_add(&ctx->band_wait, wait);
+    ctx->band_next = (ctx->band_next + 1) % ctx->band_count;
+    return true;
+}
+
+static void play_flush_task(void *arg)
+{
+    avi_play_ctx_t *ctx = (avi_play_ctx_t *)arg;
+    play_band_msg_t band;
+
+    while (1) {
+        xQueueReceive(ctx->band_queue, &band, portMAX_DELAY);
+        if (NULL == band.data) {
+            break;
+        }
+        int64_t start = esp_timer_get_time();
+        ctx->lcd_cb(band.x, band.y, band.w, band.h, band.data);
+        latency_add(&ctx->flush, esp_timer_get_time() - start);
+        xSemaphoreGive(ctx->band_free);
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+/* wait until the frame is due, false if it is more than a frame late and is to be dropped */
+static bool play_pace(avi_play_ctx_t *ctx, const avi_frame_t *frame)
 {
-    AVI_CHUNK_HEAD head;
-    fread(&head, sizeof(AVI_CHUNK_HEAD), 1, file);
-    if (head.FourCC) {
-        /* code */
+    int64_t now = esp_timer_get_time();
+
+    if (ctx->clock_start < 0) {
+        ctx->clock_start = now - frame->pts_us;
+        return true;
     }
-    *fourcc = head.FourCC;
-    if (head.size % 2) {
-        head.size++;    //奇数加1
+    int64_t due = ctx->clock_start + frame->pts_us;
+    if (now > due + ctx->info.us_per_frame) {
+        return false;
     }
-    if (length < head.size) {
-        ESP_LOGE(TAG, "frame size too large");
-        return 0;
+    if (due > now) {
+        TickType_t ticks = (due - now) / 1000 / portTICK_PERIOD_MS;
+        if (ticks) {
+            vTaskDelay(ticks);
+        }
     }
+    return true;
+}
+
+static void play_decode_task(void *arg)
+{
+    avi_play_ctx_t *ctx = (avi_play_ctx_t *)arg;
+    play_frame_msg_t msg;
 
-    fread(buffer, head.size, 1, file);
-    return head.size;
+    while (1) {
+        xQueueReceive(ctx->frame_queue, &msg, portMAX_DELAY);
+        if (msg.end) {
+            break;
+        }
+        latency_add(&ctx->queue, esp_timer_get_time() - msg.read_time);
+
+        /* a chunk of size 0 repeats the previous frame */
+        if (msg.frame.size) {
+            if (play_pace(ctx, &msg.frame)) {
+                uint8_t *order[PLAY_BAND_BUFFERS];
+                for (int i = 0; i < ctx->band_count; i++) {
+                    order[i] = ctx->band_buffers[(ctx->band_next + i) % ctx->band_count];
+                }
+                ctx->band_wait_us = 0;
+                int64_t start = esp_timer_get_time();
+                if (!jpegd2_decode(ctx->decoder, msg.frame.data, msg.frame.size, order, ctx->band_count,
+                                   ctx->band_width, ctx->band_height, play_band_cb, ctx, ctx->lcd_width, ctx->lcd_height)) {
+                    ESP_LOGW(TAG, "frame %" PRIu32 " is broken", msg.frame.index);
+                }
+                latency_add(&ctx->decode, esp_timer_get_time() - start - ctx->band_wait_us);
+                ctx->frames_shown++;
+            } else {
+                ESP_LOGD(TAG, "drop frame %" PRIu32, msg.frame.index);
+                ctx->frames_dropped++;
+            }
+        }
+        xQueueSend(ctx->release_queue, &msg.frame, portMAX_DELAY);
+    }
+
+    play_band_msg_t end = { .data = NULL };
+    xQueueSend(ctx->band_queue, &end, portMAX_DELAY);
+    vTaskDelete(NULL);
+}
+
+/* give the frames the decoder is done with back to the demuxer */
+static int play_release(avi_play_ctx_t *ctx, avi_demux_handle_t demux, TickType_t wait)
+{
+    avi_frame_t frame;
+    int count = 0;
+
+    while (xQueueReceive(ctx->release_queue, &frame, wait)) {
+        avi_demux_release(demux, &frame);
+        count++;
+        wait = 0;
+    }
+    return count;
+}
+
+static void play_ctx_free(avi_play_ctx_t *ctx)
+{
+    if (ctx->frame_queue) {
+        vQueueDelete(ctx->frame_queue);
+    }
+    if (ctx->release_queue) {
+        vQueueDelete(ctx->release_queue);
+    }
+    if (ctx->band_queue) {
+        vQueueDelete(ctx->band_queue);
+    }
+    if (ctx->band_free) {
+        vSemaphoreDelete(ctx->band_free);
+    }
+    if (ctx->done) {
+        vSemaphoreDelete(ctx->done);
+    }
+    jpegd2_delete(ctx->decoder);
+    /* band_buffers[0] belongs to the caller */
+    for (int i = 1; i < ctx->band_count; i++) {
+        heap_caps_free(ctx->band_buffers[i]);
+    }
+    free(ctx);
 }
 
 void avi_play(const char *filename, uint8_t *outbuffer,
                 const size_t outbuffer_width, const size_t outbuffer_height,
                 lcd_write_cb lcd_cb, const size_t lcd_width, const size_t lcd_height)
 {
-    FILE *avi_file;
-    int ret;
-    size_t  BytesRD;
-    uint32_t  Strsize;
-    uint32_t  Strtype;
-    uint8_t *pbuffer;
-    uint32_t buffer_size = 22*1024;
-
-    avi_file = fopen(filename, "rb");
-    if (avi_file == NULL) {
-        ESP_LOGE(TAG, "Cannot open %s", filename);
+    avi_demux_handle_t demux = NULL;
+    avi_demux_config_t config = {
+        .pool_size = 0,
+        .pool_caps = 0,
+#ifdef CONFIG_AVI_AUDIO
+        .audio = true,
+#else
+        .audio = false,
+#endif
+    };
+
+    avi_play_ctx_t *ctx = calloc(1, sizeof(avi_play_ctx_t));
+    if (NULL == ctx) {
+        ESP_LOGE(TAG, "no memory for the player");
         return;
     }
 
-    pbuffer = malloc(buffer_size);
-    if (pbuffer == NULL) {
-        ESP_LOGE(TAG, "Cannot alloc memory for palyer");
-        fclose(avi_file);
+    esp_err_t ret = avi_demux_open(filename, &config, &demux);
+    if (ESP_OK != ret) {
+        ESP_LOGE(TAG, "parse failed (%s)", esp_err_to_name(ret));
+        free(ctx);
         return;
     }
-
-    BytesRD = fread(pbuffer, 20480, 1, avi_file);
-    ret = AVI_Parser(pbuffer, BytesRD);
-    if (0 > ret) {
-        ESP_LOGE(TAG, "parse failed (%d)", ret);
+    avi_demux_get_info(demux, &ctx->info);
+    if ((ctx->info.width > 800) || (ctx->info.height > 480)) {
+        ESP_LOGE(TAG, "The size of video is too large");
+        avi_demux_close(demux);
+        free(ctx);
         return;
     }
 
-#ifdef CONFIG_AVI_AUDIO
-    audio_init();
-    pwm_audio_set_param(AVI_file.auds_sample_rate, AVI_file.auds_bits, AVI_file.auds_channels);
-    pwm_audio_start();
-#endif
+    ctx->band_width = outbuffer_width;
+    ctx->band_height = outbuffer_height;
+    ctx->lcd_cb = lcd_cb;
+    ctx->lcd_width = lcd_width;
+    ctx->lcd_height = lcd_height;
+    ctx->clock_start = -1;
+    ctx->band_buffers[0] = outbuffer;
+    ctx->band_count = 1;
+    for (int i = 1; i < PLAY_BAND_BUFFERS; i++) {
+        /* without a second buffer decode and flush just take turns */
+        ctx->band_buffers[i] = heap_caps_malloc(outbuffer_width * outbuffer_height * PLAY_BYTES_PER_PIXEL, MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+        if (NULL == ctx->band_buffers[i]) {
+            ESP_LOGW(TAG, "no memory for band buffer %d, decode and flush will not overlap", i);
+            break;
+        }
+        ctx->band_count++;
+    }
+    ctx->frame_queue = xQueueCreate(PLAY_FRAME_QUEUE_LEN, sizeof(play_frame_msg_t));
+    ctx->release_queue = xQueueCreate(PLAY_FRAMES_HELD, sizeof(avi_frame_t));
+    ctx->band_queue = xQueueCreate(PLAY_BAND_BUFFERS, sizeof(play_band_msg_t));
+    ctx->band_free = xSemaphoreCreateCounting(ctx->band_count, ctx->band_count - 1);
+    ctx->done = xSemaphoreCreateBinary();
+    ctx->decoder = jpegd2_create(JPEGD2_SCALE_FIT);
+    if (!ctx->frame_queue || !ctx->release_queue || !ctx->band_queue || !ctx->band_free || !ctx->done || !ctx->decoder) {
+        ESP_LOGE(TAG, "no memory for the playback queues and the decoder");
+        avi_demux_close(demux);
+        play_ctx_free(ctx);
+        return;
+    }
 
-    uint16_t img_width = AVI_file.vids_width;
-    uint16_t img_height = AVI_file.vids_height;
-    uint8_t *img_rgb888 = heap_caps_malloc(img_width*img_height*2, MALLOC_CAP_8BIT|MALLOC_CAP_INTERNAL);
-    if (NULL == img_rgb888){
-        ESP_LOGE(TAG, "malloc for rgb888 failed");
-        goto EXIT;
+    /* the LCD is fed first, the decoder runs beside the reading task */
+    UBaseType_t prio = uxTaskPriorityGet(NULL);
+    if (pdPASS != xTaskCreate(play_flush_task, "avi_flush", PLAY_FLUSH_STACK, ctx, prio + 1, NULL)) {
+        ESP_LOGE(TAG, "create flush task failed");
+        avi_demux_close(demux);
+        play_ctx_free(ctx);
+        return;
+    }
+    if (pdPASS != xTaskCreate(play_decode_task, "avi_decode", PLAY_DECODE_STACK, ctx, prio, NULL)) {
+        ESP_LOGE(TAG, "create decode task failed");
+        play_band_msg_t end = { .data = NULL };
+        xQueueSend(ctx->band_queue, &end, portMAX_DELAY);
+        xSemaphoreTake(ctx->done, portMAX_DELAY);
+        avi_demux_close(demux);
+        play_ctx_free(ctx);
+        return;
     }
 
-    fseek(avi_file, AVI_file.movi_start, SEEK_SET); // 偏移到movi list
-    Strsize = read_frame(avi_file, pbuffer, buffer_size, &Strtype);
-    BytesRD = Strsize+8;
+#ifdef CONFIG_AVI_AUDIO
+    if (ctx->info.audio_stream >= 0) {
+        audio_init();
+        pwm_audio_set_param(ctx->info.audio_sample_rate, ctx->info.audio_bits, ctx->info.audio_channels);
+        pwm_audio_start();
+    }
+#endif
 
+    int64_t play_start = esp_timer_get_time();
+    int held = 0;               /*!< video frames handed to the decoder and not released */
     while (1) { //播放循环
-        if (BytesRD >= AVI_file.movi_size) {
+        held -= play_release(ctx, demux, held >= PLAY_FRAMES_HELD - 1 ? portMAX_DELAY : 0);
+
+        play_frame_msg_t msg = { .end = false };
+        int64_t start = esp_timer_get_time();
+        ret = avi_demux_read(demux, &msg.frame);
+        if (ESP_ERR_NO_MEM == ret && held > 0) {
+            /* the pool is full of frames the decoder still has */
+            held -= play_release(ctx, demux, portMAX_DELAY);
+            continue;
+        } else if (ESP_ERR_NOT_FOUND == ret) {
             ESP_LOGI(TAG, "paly end");
             break;
+        } else if (ESP_OK != ret) {
+            ESP_LOGE(TAG, "read frame failed (%s)", esp_err_to_name(ret));
+            break;
         }
-        if (Strtype == T_vids) { //显示帧
-            int64_t fr_end = esp_timer_get_time();
-            mjpegdraw(pbuffer, Strsize, outbuffer, outbuffer_width, outbuffer_height, lcd_cb, lcd_width, lcd_height);
-            ESP_LOGI(TAG, "jpg decode %ums", (uint32_t)((esp_timer_get_time() - fr_end) / 1000));fr_end = esp_timer_get_time();
-            // ESP_LOGI(TAG, "draw %ums", (uint32_t)((esp_timer_get_time() - fr_end) / 1000));fr_end = esp_timer_get_time();
-
-        }//显示帧
-        else if (Strtype == T_auds) { //音频输出
+        latency_add(&ctx->read, esp_timer_get_time() - start);
+        ESP_LOGD(TAG, "type=%d, size=%" PRIu32, msg.frame.type, msg.frame.size);
+
+        if (AVI_FRAME_VIDEO == msg.frame.type) { //显示帧
+            msg.read_time = esp_timer_get_time();
+            xQueueSend(ctx->frame_queue, &msg, portMAX_DELAY);
+            held++;
+        } else { //音频输出
 #ifdef CONFIG_AVI_AUDIO
             size_t cnt;
-            pwm_audio_write((uint8_t *)pbuffer, Strsize, &cnt, 500 / portTICK_PERIOD_MS);
+            pwm_audio_write((uint8_t *)msg.frame.data, msg.frame.size, &cnt, 500 / portTICK_PERIOD_MS);
 #endif
-        } else {
-            ESP_LOGE(TAG, "unknow frame");
-            break;
+            avi_demux_release(demux, &msg.frame);
         }
-        Strsize = read_frame(avi_file, pbuffer, buffer_size, &Strtype); //读入整帧
-        ESP_LOGD(TAG, "type=%x, size=%d", Strtype, Strsize);
-        BytesRD += Strsize+8;
     }
-EXIT:
+
+    /* the decoder finishes the queued frames, then the flush task the last bands */
+    play_frame_msg_t end = { .end = true };
+    xQueueSend(ctx->frame_queue, &end, portMAX_DELAY);
+    xSemaphoreTake(ctx->done, portMAX_DELAY);
+    play_release(ctx, demux, 0);
+    int64_t play_time = esp_timer_get_time() - play_start;
+
 #ifdef CONFIG_AVI_AUDIO
-pwm_audio_deinit();
+    if (ctx->info.audio_stream >= 0) {
+        pwm_audio_deinit();
+    }
 #endif
-free(img_rgb888);
-free(pbuffer);
-fclose(avi_file);
+    avi_demux_close(demux);
+
+    ESP_LOGI(TAG, "%" PRIu32 " frames shown, %" PRIu32 " dropped late, %.1f fps", ctx->frames_shown, ctx->frames_dropped,
+             play_time > 0 ? ctx->frames_shown * 1000000.0 / play_time : 0.0);
+    latency_log("read", &ctx->read);
+    latency_log("queue", &ctx->queue);
+    latency_log("decode", &ctx->decode);
+    latency_log("band wait", &ctx->band_wait);
+    latency_log("flush", &ctx->flush);
+
+    play_ctx_free(ctx);
 }
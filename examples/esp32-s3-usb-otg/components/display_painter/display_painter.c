@@ -18,6 +18,7 @@
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "esp_log.h"
+#include "esp_heap_caps.h"
 #include "screen_driver.h"
 #include "display_painter.h"
 #include "display_printf.h"
@@ -29,6 +30,11 @@ static const char *TAG = "basic painter";
         return ;                                                           \
     }
 
+#define PAINTER_CHECK_RET(a, str, ret)  if(!(a)) {                      \
+        ESP_LOGE(TAG,"%s:%d (%s):%s", __FILE__, __LINE__, __FUNCTION__, str);   \
+        return (ret);                                                      \
+    }
+
 typedef struct {
     uint16_t point_color;
     uint16_t back_color;
@@ -49,8 +55,53 @@ static uint16_t g_screen_height;
 static SemaphoreHandle_t s_log_mutex = NULL;
 static font_t s_font;
 
+/**
+ * Batch rendering: once a canvas is allocated (by painter_batch_begin), every primitive
+ * is drawn into the canvas, and the areas it changed are recorded as dirty rectangles.
+ * They are sent to the screen when the outermost batch ends, one draw_bitmap per
+ * rectangle (a few if the rectangle is narrower than the screen and larger than the
+ * flush buffer). Primitives called outside a batch are a batch of their own.
+ */
+#define PAINTER_DIRTY_MAX           8       /*!< dirty rectangles kept, more are merged */
+#define PAINTER_FLUSH_LINES         16      /*!< lines of the buffer used to send rectangles narrower than the screen */
+
+typedef struct {
+    int16_t x0;
+    int16_t y0;
+    int16_t x1;                     /*!< inclusive */
+    int16_t y1;
+} painter_rect_t;
+
+static uint16_t *s_canvas = NULL;   /*!< copy of the whole screen */
+static uint16_t *s_flush_buf = NULL;
+static int s_batch_depth = 0;
+static painter_rect_t s_dirty[PAINTER_DIRTY_MAX];
+static int s_dirty_count = 0;
+
+/**
+ * Glyph cache: characters expanded to RGB565 for a font, a color and a background color,
+ * looked up by a hash of the four (one entry per slot, a new glyph replaces the old one).
+ * Strings are assembled from the cached glyphs into a span buffer and sent one line at a time.
+ */
+#define PAINTER_GLYPH_CACHE_SIZE    32      /*!< cached glyphs, must be a power of 2 */
+
+typedef struct {
+    const font_t *font;
+    char ascii_char;
+    uint16_t color;
+    uint16_t back_color;
+    uint16_t *pixels;               /*!< font->Width * font->Height, NULL if the slot is empty */
+    size_t size;                    /*!< pixels allocated */
+} painter_glyph_t;
+
+static painter_glyph_t s_glyphs[PAINTER_GLYPH_CACHE_SIZE];
+static uint16_t *s_span_buf = NULL;
+static size_t s_span_size = 0;      /*!< pixels allocated */
+
 esp_err_t painter_init(scr_driver_t *driver)
 {
+    painter_batch_release();
+    painter_glyph_cache_clear();
     g_lcd = *driver;
     scr_info_t info;
     g_lcd.get_info(&info);
@@ -80,9 +131,224 @@ uint16_t painter_get_back_color(void)
     return g_back_color;
 }
 
+static inline int rect_area(const painter_rect_t *r)
+{
+    return (r->x1 - r->x0 + 1) * (r->y1 - r->y0 + 1);
+}
+
+/* pixels covered by both rectangles */
+static inline int rect_overlap(const painter_rect_t *a, const painter_rect_t *b)
+{
+    int w = (a->x1 < b->x1 ? a->x1 : b->x1) - (a->x0 > b->x0 ? a->x0 : b->x0) + 1;
+    int h = (a->y1 < b->y1 ? a->y1 : b->y1) - (a->y0 > b->y0 ? a->y0 : b->y0) + 1;
+    return w > 0 && h > 0 ? w * h : 0;
+}
+
+static inline painter_rect_t rect_union(const painter_rect_t *a, const painter_rect_t *b)
+{
+    painter_rect_t u = {
+        .x0 = a->x0 < b->x0 ? a->x0 : b->x0,
+        .y0 = a->y0 < b->y0 ? a->y0 : b->y0,
+        .x1 = a->x1 > b->x1 ? a->x1 : b->x1,
+        .y1 = a->y1 > b->y1 ? a->y1 : b->y1,
+    };
+    return u;
+}
+
+/* clip a rectangle to the screen, false if nothing is left */
+static bool rect_clip(int *x0, int *y0, int *x1, int *y1)
+{
+    if (*x0 < 0) {
+        *x0 = 0;
+    }
+    if (*y0 < 0) {
+        *y0 = 0;
+    }
+    if (*x1 >= g_screen_width) {
+        *x1 = g_screen_width - 1;
+    }
+    if (*y1 >= g_screen_height) {
+        *y1 = g_screen_height - 1;
+    }
+    return *x0 <= *x1 && *y0 <= *y1;
+}
+
+/* record a changed area, merged with the dirty rectangles it overlaps as long as that costs no extra pixels */
+static void dirty_add(int x0, int y0, int x1, int y1)
+{
+    if (!rect_clip(&x0, &y0, &x1, &y1)) {
+        return;
+    }
+    painter_rect_t r = { x0, y0, x1, y1 };
+
+    for (int i = 0; i < s_dirty_count;) {
+        painter_rect_t u = rect_union(&s_dirty[i], &r);
+        if (rect_area(&u) <= rect_area(&s_dirty[i]) + rect_area(&r) - rect_overlap(&s_dirty[i], &r)) {
+            /* take it out and try the union against the others */
+            r = u;
+            s_dirty[i] = s_dirty[--s_dirty_count];
+            i = 0;
+            continue;
+        }
+        i++;
+    }
+    if (s_dirty_count < PAINTER_DIRTY_MAX) {
+        s_dirty[s_dirty_count++] = r;
+        return;
+    }
+    /* full: merge the two rectangles (the new one included) whose union adds the fewest pixels */
+    int best_i = 0, best_j = PAINTER_DIRTY_MAX, best_waste = INT32_MAX;
+    for (int i = 0; i < PAINTER_DIRTY_MAX; i++) {
+        for (int j = i + 1; j <= PAINTER_DIRTY_MAX; j++) {
+            const painter_rect_t *b = j < PAINTER_DIRTY_MAX ? &s_dirty[j] : &r;
+            painter_rect_t u = rect_union(&s_dirty[i], b);
+            int waste = rect_area(&u) - rect_area(&s_dirty[i]) - rect_area(b) + rect_overlap(&s_dirty[i], b);
+            if (waste < best_waste) {
+                best_waste = waste;
+                best_i = i;
+                best_j = j;
+            }
+        }
+    }
+    if (best_j < PAINTER_DIRTY_MAX) {
+        s_dirty[best_i] = rect_union(&s_dirty[best_i], &s_dirty[best_j]);
+        s_dirty[best_j] = r;
+    } else {
+        s_dirty[best_i] = rect_union(&s_dirty[best_i], &r);
+    }
+}
+
+static void canvas_flush(void)
+{
+    for (int i = 0; i < s_dirty_count; i++) {
+        const painter_rect_t *r = &s_dirty[i];
+        int w = r->x1 - r->x0 + 1;
+
+        if (w == g_screen_width) {
+            /* whole lines are contiguous in the canvas */
+            g_lcd.draw_bitmap(0, r->y0, w, r->y1 - r->y0 + 1, s_canvas + r->y0 * g_screen_width);
+            continue;
+        }
+        int lines = g_screen_width * PAINTER_FLUSH_LINES / w;
+        for (int y = r->y0; y <= r->y1; y += lines) {
+            int h = r->y1 - y + 1 < lines ? r->y1 - y + 1 : lines;
+            for (int j = 0; j < h; j++) {
+                memcpy(s_flush_buf + j * w, s_canvas + (y + j) * g_screen_width + r->x0, w * sizeof(uint16_t));
+            }
+            g_lcd.draw_bitmap(r->x0, y, w, h, s_flush_buf);
+        }
+    }
+    s_dirty_count = 0;
+}
+
+/* a primitive drawn outside a batch is a batch of its own, false if there is no canvas */
+static bool batch_enter(void)
+{
+    if (NULL == s_canvas) {
+        return false;
+    }
+    s_batch_depth++;
+    return true;
+}
+
+static void batch_leave(void)
+{
+    if (0 == --s_batch_depth) {
+        canvas_flush();
+    }
+}
+
+static inline void canvas_pixel(int x, int y, uint16_t color)
+{
+    if ((unsigned)x < g_screen_width && (unsigned)y < g_screen_height) {
+        s_canvas[y * g_screen_width + x] = color;
+        dirty_add(x, y, x, y);
+    }
+}
+
+static void canvas_fill(int x0, int y0, int x1, int y1, uint16_t color)
+{
+    if (!rect_clip(&x0, &y0, &x1, &y1)) {
+        return;
+    }
+    for (int y = y0; y <= y1; y++) {
+        uint16_t *p = s_canvas + y * g_screen_width;
+        for (int x = x0; x <= x1; x++) {
+            p[x] = color;
+        }
+    }
+    dirty_add(x0, y0, x1, y1);
+}
+
+static void canvas_bitmap(int x, int y, int w, int h, uint16_t *bitmap)
+{
+    int x0 = x, y0 = y, x1 = x + w - 1, y1 = y + h - 1;
+
+    if (!rect_clip(&x0, &y0, &x1, &y1)) {
+        return;
+    }
+    for (int j = y0; j <= y1; j++) {
+        memcpy(s_canvas + j * g_screen_width + x0, bitmap + (j - y) * w + (x0 - x), (x1 - x0 + 1) * sizeof(uint16_t));
+    }
+    dirty_add(x0, y0, x1, y1);
+}
+
+esp_err_t painter_batch_begin(void)
+{
+    PAINTER_CHECK_RET(NULL != g_lcd.init, "paint not initial", ESP_FAIL);
+    if (NULL == s_canvas) {
+        size_t size = g_screen_width * g_screen_height * sizeof(uint16_t);
+        s_canvas = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+        if (NULL == s_canvas) {
+            s_canvas = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+        }
+        s_flush_buf = heap_caps_malloc(g_screen_width * PAINTER_FLUSH_LINES * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+        if (NULL == s_canvas || NULL == s_flush_buf) {
+            heap_caps_free(s_canvas);
+            heap_caps_free(s_flush_buf);
+            s_canvas = s_flush_buf = NULL;
+            ESP_LOGE(TAG, "no memory for a %ux%u canvas", g_screen_width, g_screen_height);
+            return ESP_ERR_NO_MEM;
+        }
+        for (size_t i = 0; i < g_screen_width * g_screen_height; i++) {
+            s_canvas[i] = g_back_color;
+        }
+        s_dirty_count = 0;
+        s_batch_depth = 0;
+    }
+    s_batch_depth++;
+    return ESP_OK;
+}
+
+esp_err_t painter_batch_end(void)
+{
+    PAINTER_CHECK_RET(NULL != s_canvas && s_batch_depth > 0, "no batch to end", ESP_ERR_INVALID_STATE);
+    batch_leave();
+    return ESP_OK;
+}
+
+void painter_batch_release(void)
+{
+    if (NULL == s_canvas) {
+        return;
+    }
+    canvas_flush();
+    heap_caps_free(s_canvas);
+    heap_caps_free(s_flush_buf);
+    s_canvas = s_flush_buf = NULL;
+    s_batch_depth = 0;
+}
+
 void painter_clear(uint16_t color)
 {
     PAINTER_CHECK(NULL != g_lcd.init, "paint not initial");
+    if (batch_enter()) {
+        /* one rectangle for the whole screen, sent with a single draw_bitmap */
+        s_dirty_count = 0;
+        canvas_fill(0, 0, g_screen_width - 1, g_screen_height - 1, color);
+        batch_leave();
+        return;
+    }
     scr_info_t info;
     g_lcd.get_info(&info);
     uint16_t *buffer = malloc(info.width * sizeof(uint16_t));
@@ -99,39 +365,109 @@ void painter_clear(uint16_t color)
     free(buffer);
 }
 
+void painter_glyph_cache_clear(void)
+{
+    for (int i = 0; i < PAINTER_GLYPH_CACHE_SIZE; i++) {
+        free(s_glyphs[i].pixels);
+    }
+    memset(s_glyphs, 0, sizeof(s_glyphs));
+    free(s_span_buf);
+    s_span_buf = NULL;
+    s_span_size = 0;
+}
+
+/* the glyph of a character in RGB565, expanded on the first use, NULL if out of memory */
+static const uint16_t *glyph_get(const font_t *font, char ascii_char, uint16_t color, uint16_t back_color)
+{
+    uint32_t hash = ((uint32_t)(uintptr_t)font >> 2) * 31 + (uint8_t)ascii_char;
+    hash = hash * 31 + color;
+    hash = hash * 31 + back_color;
+    hash ^= hash >> 16;
+    painter_glyph_t *glyph = &s_glyphs[hash & (PAINTER_GLYPH_CACHE_SIZE - 1)];
+
+    if (NULL != glyph->pixels && glyph->font == font && glyph->ascii_char == ascii_char
+            && glyph->color == color && glyph->back_color == back_color) {
+        return glyph->pixels;
+    }
+
+    size_t size = font->Width * font->Height;
+    if (glyph->size < size) {
+        free(glyph->pixels);
+        glyph->pixels = malloc(size * sizeof(uint16_t));
+        glyph->size = NULL != glyph->pixels ? size : 0;
+        if (NULL == glyph->pixels) {
+            return NULL;
+        }
+    }
+
+    /* each line of the glyph takes whole bytes, MSB first */
+    int line_bytes = (font->Width + 7) / 8;
+    const uint8_t *ptr = &font->table[(ascii_char - ' ') * font->Height * line_bytes];
+    uint16_t *out = glyph->pixels;
+    for (int j = 0; j < font->Height; j++, ptr += line_bytes) {
+        for (int i = 0; i < font->Width; i++) {
+            *out++ = (ptr[i / 8] & (0x80 >> (i % 8))) ? color : back_color;
+        }
+    }
+    glyph->font = font;
+    glyph->ascii_char = ascii_char;
+    glyph->color = color;
+    glyph->back_color = back_color;
+    return glyph->pixels;
+}
+
 void painter_draw_char(int x, int y, char ascii_char, const font_t *font, uint16_t color)
 {
     PAINTER_CHECK(ascii_char >= ' ', "ACSII code invalid");
     PAINTER_CHECK(NULL != font, "Font pointer invalid");
-    int i, j;
-    uint16_t char_size = font->Height * (font->Width / 8 + (font->Width % 8 ? 1 : 0));
-    unsigned int char_offset = (ascii_char - ' ') * char_size;
-    const unsigned char *ptr = &font->table[char_offset];
-    uint16_t buf[18 * 25];
-    PAINTER_CHECK(font->Height * font->Width * sizeof(uint16_t) <= sizeof(buf), "Font size is too large");
     painter_set_point_color(color);
-    int ox = 0;
-    int oy = 0;
+    const uint16_t *buf = glyph_get(font, ascii_char, g_point_color, g_back_color);
+    PAINTER_CHECK(NULL != buf, "no memory for the glyph");
 
-    for (i = 0; i < font->Width * font->Height; i++) {
-        buf[i] = g_back_color;
+    if (batch_enter()) {
+        canvas_bitmap(x, y, font->Width, font->Height, (uint16_t *)buf);
+        batch_leave();
+        return;
     }
-    for (j = 0; j < char_size; j++) {
-        uint8_t temp = ptr[j];
-        for (i = 0; i < 8; i++) {
-            if (temp & 0x80) {
-                buf[ox + (font->Width * oy)] = g_point_color;
-            }
-            temp <<= 1;
-            ox++;
-            if (ox == font->Width) {
-                ox = 0;
-                oy++;
-                break;
+    g_lcd.draw_bitmap(x, y, font->Width, font->Height, (uint16_t *)buf);         // Draw NxN char
+}
+
+/* send characters that follow each other on one line as one bitmap */
+static void span_draw(bool batch, int x, int y, const char *text, int len, const font_t *font, uint16_t color)
+{
+    int w = len * font->Width;
+    size_t size = w * font->Height;
+
+    if (s_span_size < size) {
+        free(s_span_buf);
+        s_span_buf = malloc(size * sizeof(uint16_t));
+        s_span_size = NULL != s_span_buf ? size : 0;
+    }
+    if (NULL == s_span_buf) {
+        /* no memory for the line, character by character */
+        for (int i = 0; i < len; i++) {
+            painter_draw_char(x + i * font->Width, y, text[i], font, color);
+        }
+        return;
+    }
+    for (int i = 0; i < len; i++) {
+        const uint16_t *glyph = glyph_get(font, text[i], color, g_back_color);
+        uint16_t *dst = s_span_buf + i * font->Width;
+        for (int j = 0; j < font->Height; j++, dst += w) {
+            if (NULL == glyph) {
+                for (int k = 0; k < font->Width; k++) {
+                    dst[k] = g_back_color;
+                }
+                continue;
             }
+            memcpy(dst, glyph + j * font->Width, font->Width * sizeof(uint16_t));
         }
     }
-    g_lcd.draw_bitmap(x, y, font->Width, font->Height, buf);         // Draw NxN char
+    if (batch) {
+        canvas_bitmap(x, y, w, font->Height, s_span_buf);
+    } else {
+        g_lcd.draw_bitmap(x, y, w, font->Height, s_span_buf);
+    }
 }
 
 void painter_draw_string(int x, int y, const char *text, const font_t *font, uint16_t color)
@@ -143,6 +479,12 @@ void painter_draw_string(int x, int y, const char *text, const font_t *font, uin
     uint16_t y0 = y;
     scr_info_t info;
     g_lcd.get_info(&info);
+    bool batch = batch_enter();
+    painter_set_point_color(color);
+
+    /* characters wholly on the screen are collected into runs, one run per line */
+    const char *run = NULL;
+    int run_x = 0, run_y = 0, run_len = 0;
 
     while (*p_text != 0) {
         if (x > (x0 + info.width - font->Width)) {
@@ -155,12 +497,34 @@ void painter_draw_string(int x, int y, const char *text, const font_t *font, uin
         if (*p_text == '\n') {
             y += font->Height;
             x = x0;
+        } else if (*p_text < ' ') {
+            ESP_LOGE(TAG, "ACSII code invalid");
+        } else if (run_len > 0 && y == run_y && x == run_x + run_len * font->Width
+                   && x + font->Width <= g_screen_width) {
+            run_len++;
         } else {
-            painter_draw_char(x, y, *p_text, font, color);
+            if (run_len > 0) {
+                span_draw(batch, run_x, run_y, run, run_len, font, color);
+                run_len = 0;
+            }
+            if (x >= 0 && y >= 0 && x + font->Width <= g_screen_width && y + font->Height <= g_screen_height) {
+                run = p_text;
+                run_x = x;
+                run_y = y;
+                run_len = 1;
+            } else {
+                painter_draw_char(x, y, *p_text, font, color);
+            }
         }
         x += font->Width;
         p_text++;
     }
+    if (run_len > 0) {
+        span_draw(batch, run_x, run_y, run, run_len, font, color);
+    }
+    if (batch) {
+        batch_leave();
+    }
 }
 
 void painter_draw_num(int x, int y, uint32_t num, uint8_t len, const font_t *font, uint16_t color)
@@ -168,26 +532,46 @@ void painter_draw_num(int x, int y, uint32_t num, uint8_t len, const font_t *fon
     PAINTER_CHECK(len < 10, "The length of the number is too long");
     PAINTER_CHECK(NULL != font, "Font pointer invalid");
     char buf[10] = {0};
-    int8_t num_len;
+    size_t num_len;
 
     itoa(num, buf, 10);
     num_len = strlen(buf);
     x += (font->Width * (len - 1));
+    bool batch = batch_enter();
+    painter_set_point_color(color);
 
-    for (size_t i = 0; i < len; i++) {
-        if (i < num_len) {
-            painter_draw_char(x, y, buf[i], font, color);
-        } else {
-            painter_draw_char(x, y, '0', font, color);
+    if (len > 0 && x - font->Width * (len - 1) >= 0 && x + font->Width <= g_screen_width
+            && y >= 0 && y + font->Height <= g_screen_height) {
+        /* the same characters from left to right, sent as one bitmap */
+        char text[10];
+        for (size_t i = 0; i < len; i++) {
+            text[len - 1 - i] = i < num_len ? buf[i] : '0';
         }
+        span_draw(batch, x - font->Width * (len - 1), y, text, len, font, color);
+    } else {
+        for (size_t i = 0; i < len; i++) {
+            if (i < num_len) {
+                painter_draw_char(x, y, buf[i], font, color);
+            } else {
+                painter_draw_char(x, y, '0', font, color);
+            }
 
-        x -= font->Width;
+            x -= font->Width;
+        }
+    }
+    if (batch) {
+        batch_leave();
     }
 }
 
 void painter_draw_image(int x, int y, int width, int height, uint16_t *img)
 {
     PAINTER_CHECK(NULL != img, "Image pointer invalid");
+    if (batch_enter()) {
+        canvas_bitmap(x, y, width, height, img);
+        batch_leave();
+        return;
+    }
     g_lcd.draw_bitmap(x, y, width, height, img);
 }
 
@@ -195,6 +579,12 @@ void painter_draw_horizontal_line(int x, int y, int line_length, uint16_t color)
 {
     int i;
 
+    if (batch_enter()) {
+        canvas_fill(x, y, x + line_length - 1, y, color);
+        batch_leave();
+        return;
+    }
+
     for (i = x; i < x + line_length; i++) {
         g_lcd.draw_pixel(i, y, color);
     }
@@ -204,6 +594,12 @@ void painter_draw_vertical_line(int x, int y, int line_length, uint16_t color)
 {
     int i;
 
+    if (batch_enter()) {
+        canvas_fill(x, y, x, y + line_length - 1, color);
+        batch_leave();
+        return;
+    }
+
     for (i = y; i < y + line_length; i++) {
         g_lcd.draw_pixel(x, i, color);
     }
@@ -243,8 +639,13 @@ void painter_draw_line(int x1, int y1, int x2, int y2, uint16_t color)
         distance = delta_y;
     }
 
+    bool batch = batch_enter();
     for (t = 0; t <= distance + 1; t++) {
-        g_lcd.draw_pixel(uRow, uCol, color);
+        if (batch) {
+            canvas_pixel(uRow, uCol, color);
+        } else {
+            g_lcd.draw_pixel(uRow, uCol, color);
+        }
         xerr += delta_x ;
         yerr += delta_y ;
 
@@ -258,6 +659,9 @@ void painter_draw_line(int x1, int y1, int x2, int y2, uint16_t color)
             uCol += incy;
         }
     }
+    if (batch) {
+        batch_leave();
+    }
 }
 
 void painter_draw_rectangle(int x0, int y0, int x1, int y1, uint16_t color)
@@ -268,10 +672,14 @@ void painter_draw_rectangle(int x0, int y0, int x1, int y1, uint16_t color)
     min_y = y1 > y0 ? y0 : y1;
     max_y = y1 > y0 ? y1 : y0;
 
+    bool batch = batch_enter();
     painter_draw_horizontal_line(min_x, min_y, max_x - min_x + 1, color);
     painter_draw_horizontal_line(min_x, max_y, max_x - min_x + 1, color);
     painter_draw_vertical_line(min_x, min_y, max_y - min_y + 1, color);
     painter_draw_vertical_line(max_x, min_y, max_y - min_y + 1, color);
+    if (batch) {
+        batch_leave();
+    }
 }
 
 void painter_draw_filled_rectangle(int x0, int y0, int x1, int y1, uint16_t color)
@@ -283,11 +691,25 @@ void painter_draw_filled_rectangle(int x0, int y0, int x1, int y1, uint16_t colo
     min_y = y1 > y0 ? y0 : y1;
     max_y = y1 > y0 ? y1 : y0;
 
+    if (batch_enter()) {
+        canvas_fill(min_x, min_y, max_x, max_y, color);
+        batch_leave();
+        return;
+    }
     for (i = min_x; i <= max_x; i++) {
         painter_draw_vertical_line(i, min_y, max_y - min_y + 1, color);
     }
 }
 
+static inline void circle_pixel(bool batch, int x, int y, uint16_t color)
+{
+    if (batch) {
+        canvas_pixel(x, y, color);
+    } else {
+        g_lcd.draw_pixel(x, y, color);
+    }
+}
+
 void painter_draw_circle(int x, int y, int radius, uint16_t color)
 {
     /* Bresenham algorithm */
@@ -295,12 +717,13 @@ void painter_draw_circle(int x, int y, int radius, uint16_t color)
     int y_pos = 0;
     int err = 2 - 2 * radius;
     int e2;
+    bool batch = batch_enter();
 
     do {
-        g_lcd.draw_pixel(x - x_pos, y + y_pos, color);
-        g_lcd.draw_pixel(x + x_pos, y + y_pos, color);
-        g_lcd.draw_pixel(x + x_pos, y - y_pos, color);
-        g_lcd.draw_pixel(x - x_pos, y - y_pos, color);
+        circle_pixel(batch, x - x_pos, y + y_pos, color);
+        circle_pixel(batch, x + x_pos, y + y_pos, color);
+        circle_pixel(batch, x + x_pos, y - y_pos, color);
+        circle_pixel(batch, x - x_pos, y - y_pos, color);
         e2 = err;
 
         if (e2 <= y_pos) {
@@ -315,6 +738,9 @@ void painter_draw_circle(int x, int y, int radius, uint16_t color)
             err += ++x_pos * 2 + 1;
         }
     } while (x_pos <= 0);
+    if (batch) {
+        batch_leave();
+    }
 }
 
 void painter_draw_filled_circle(int x, int y, int radius, uint16_t color)
@@ -324,12 +750,13 @@ void painter_draw_filled_circle(int x, int y, int radius, uint16_t color)
     int y_pos = 0;
     int err = 2 - 2 * radius;
     int e2;
+    bool batch = batch_enter();
 
     do {
-        g_lcd.draw_pixel(x - x_pos, y + y_pos, color);
-        g_lcd.draw_pixel(x + x_pos, y + y_pos, color);
-        g_lcd.draw_pixel(x + x_pos, y - y_pos, color);
-        g_lcd.draw_pixel(x - x_pos, y - y_pos, color);
+        circle_pixel(batch, x - x_pos, y + y_pos, color);
+        circle_pixel(batch, x + x_pos, y + y_pos, color);
+        circle_pixel(batch, x + x_pos, y - y_pos, color);
+        circle_pixel(batch, x - x_pos, y - y_pos, color);
         painter_draw_horizontal_line(x + x_pos, y + y_pos, 2 * (-x_pos) + 1, color);
         painter_draw_horizontal_line(x + x_pos, y - y_pos, 2 * (-x_pos) + 1, color);
         e2 = err;
@@ -346,6 +773,9 @@ void painter_draw_filled_circle(int x, int y, int radius, uint16_t color)
             err += ++x_pos * 2 + 1;
         }
     } while (x_pos <= 0);
+    if (batch) {
+        batch_leave();
+    }
 }
 
 static int s_height_current = 0; //current line on screen
@@ -464,6 +894,7 @@ void display_printf_line(const char *tag, uint16_t line, uint16_t color, const c
 void painter_draw_qr_code_v10(esp_qrcode_handle_t qrcode)
 {
     esp_qrcode_print_console(qrcode);
+    bool batch = batch_enter();
     painter_clear(COLOR_BLACK);
     int size = esp_qrcode_get_size(qrcode);
     int border_x = 2;
@@ -491,7 +922,14 @@ void painter_draw_qr_code_v10(esp_qrcode_handle_t qrcode)
             if (esp_qrcode_get_module(qrcode, x, y)) {
                 buf = buf_white;
             }
-            g_lcd.draw_bitmap((x + border_x) * block_width, (y + border_y) * block_height, block_width, block_height, buf); 
+            if (batch) {
+                canvas_bitmap((x + border_x) * block_width, (y + border_y) * block_height, block_width, block_height, buf);
+            } else {
+                g_lcd.draw_bitmap((x + border_x) * block_width, (y + border_y) * block_height, block_width, block_height, buf);
+            }
         }
     }
+    if (batch) {
+        batch_leave();
+    }
 }
\ No newline at end of file
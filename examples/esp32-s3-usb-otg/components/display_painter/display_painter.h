@@ -71,6 +71,47 @@ uint16_t painter_get_back_color(void);
  */
 void painter_clear(uint16_t color);
 
+/**
+ * @brief Start a batch of drawing
+ *
+ * The first call allocates an off-screen copy of the screen (width * height * 2 bytes,
+ * in PSRAM if there is some) filled with the background color. From then on every
+ * primitive draws into this copy, and the changed areas are sent to the screen as a few
+ * rectangles when the outermost batch ends, instead of one bus transfer per pixel or
+ * line. Primitives called outside a batch are flushed on their own. Batches can be nested.
+ *
+ * @note Anything drawn on the screen without the painter is overwritten when its area is
+ *       flushed again. The copy is kept until painter_batch_release.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_FAIL Painter not initialized
+ *      - ESP_ERR_NO_MEM Not enough memory for the copy of the screen
+ */
+esp_err_t painter_batch_begin(void);
+
+/**
+ * @brief End a batch of drawing, the outermost batch sends the changed areas to the screen
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_STATE No batch started
+ */
+esp_err_t painter_batch_end(void);
+
+/**
+ * @brief Send what is pending and free the copy of the screen, primitives then draw directly again
+ */
+void painter_batch_release(void);
+
+/**
+ * @brief Free the cached glyphs
+ *
+ * Characters are kept expanded to RGB565 for the fonts and colors last used, in a few KB
+ * of heap, so text that is drawn again is not expanded again.
+ */
+void painter_glyph_cache_clear(void);
+
 /**
  * @brief Draw a character on screen
  * 
@@ -84,6 +125,8 @@ void painter_draw_char(int x, int y, char ascii_char, const font_t* font, uint16
 
 /**
  * @brief Draw a string on screen
+ *
+ * The characters of each line are sent to the screen as one bitmap.
  * 
  * @param x Starting point in X direction
  * @param y Starting point in Y direction
@@ -126,6 +126,32 @@ esp_err_t lcd_ili9341_draw_pixel(uint16_t x, uint16_t y, uint16_t color);
  */
 esp_err_t lcd_ili9341_draw_bitmap(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *bitmap);
 
+/**
+ * @brief Fill the pixels on LCD screen with bitmap, without waiting for the transfer
+ * 
+ * @param x Starting point in X direction
+ * @param y Starting point in Y direction
+ * @param w width of image in bitmap array
+ * @param h height of image in bitmap array
+ * @param bitmap pointer to bitmap array, must stay valid until done_cb is called
+ * @param done_cb Called when the bitmap has been sent, NULL if not used
+ * @param user_ctx Argument of done_cb
+ * 
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_FAIL Failed
+ */
+esp_err_t lcd_ili9341_draw_bitmap_async(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *bitmap, scr_interface_done_cb_t done_cb, void *user_ctx);
+
+/**
+ * @brief Wait until the bitmaps drawn with lcd_ili9341_draw_bitmap_async have been sent
+ * 
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_FAIL Failed
+ */
+esp_err_t lcd_ili9341_draw_wait(void);
+
 
 #ifdef __cplusplus
 }
@@ -63,6 +63,8 @@ scr_driver_t lcd_ili9486_default_driver = {
     .write_ram_data = lcd_ili9486_write_ram_data,
     .draw_pixel = lcd_ili9486_draw_pixel,
     .draw_bitmap = lcd_ili9486_draw_bitmap,
+    .draw_bitmap_async = lcd_ili9486_draw_bitmap_async,
+    .draw_wait = lcd_ili9486_draw_wait,
     .get_info = lcd_ili9486_get_info,
 };
 
@@ -250,6 +252,16 @@ esp_err_t lcd_ili9486_draw_bitmap(uint16_t x, uint16_t y, uint16_t w, uint16_t h
     return ESP_OK;
 }
 
+esp_err_t lcd_ili9486_draw_bitmap_async(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *bitmap, scr_interface_done_cb_t done_cb, void *user_ctx)
+{
+    return scr_utility_draw_bitmap_async(&g_lcd_handle, lcd_ili9486_set_window, x, y, w, h, bitmap, done_cb, user_ctx);
+}
+
+esp_err_t lcd_ili9486_draw_wait(void)
+{
+    return scr_utility_draw_wait(&g_lcd_handle);
+}
+
 
 static void lcd_ili9486_init_reg(void)
 {
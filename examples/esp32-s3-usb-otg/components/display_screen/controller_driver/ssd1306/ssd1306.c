@@ -91,6 +91,14 @@ static const char *TAG = "lcd ssd1306";
 
 static scr_handle_t g_lcd_handle;
 
+/**
+ * Copy of the GRAM, one row per page and one unit per column. Setting a window takes 8
+ * commands, 26 bytes on I2C with the header of the data transfer, so unchanged columns up to that
+ * are sent rather than opening another window.
+ */
+#define SSD1306_WINDOW_COST                    26
+static scr_shadow_t g_gram;
+
 /**
  * This header file is only used to redefine the function to facilitate the call.
  * It can only be placed in this position, not in the head of the file.
@@ -107,6 +115,8 @@ scr_driver_t lcd_ssd1306_default_driver = {
     .write_ram_data = lcd_ssd1306_write_ram_data,
     .draw_pixel = lcd_ssd1306_draw_pixel,
     .draw_bitmap = lcd_ssd1306_draw_bitmap,
+    .draw_bitmap_async = lcd_ssd1306_draw_bitmap_async,
+    .draw_wait = lcd_ssd1306_draw_wait,
     .get_info = lcd_ssd1306_get_info,
 };
 
@@ -159,11 +169,16 @@ esp_err_t lcd_ssd1306_init(const scr_controller_config_t *lcd_conf)
     LCD_WRITE_CMD(0xAF); //--turn on oled panel
 
     lcd_ssd1306_set_rotate(lcd_conf->rotate);
+
+    if (ESP_OK != scr_shadow_init(&g_gram, SSD1306_PAGES, SSD1306_COLUMNS, 1, SSD1306_WINDOW_COST)) {
+        ESP_LOGW(TAG, "No copy of the GRAM, every bitmap is sent in full");
+    }
     return ESP_OK;
 }
 
 esp_err_t lcd_ssd1306_deinit(void)
 {
+    scr_shadow_deinit(&g_gram);
     memset(&g_lcd_handle, 0, sizeof(scr_handle_t));
     return ESP_OK;
 }
@@ -220,6 +235,8 @@ esp_err_t lcd_ssd1306_set_rotate(scr_dir_t dir)
         break;
     }
     LCD_CHECK(ESP_OK == ret, "Set screen rotate failed", ESP_FAIL);
+    /* columns are mapped again from the next write on */
+    scr_shadow_invalidate(&g_gram);
     g_lcd_handle.dir = dir;
     return ESP_OK;
 }
@@ -236,7 +253,7 @@ esp_err_t lcd_ssd1306_set_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t
     ret |= LCD_WRITE_CMD(0); /**< Set to Horizontal Addressing Mode */
     ret |= LCD_WRITE_CMD(SSD1306_CMD_SET_COLUMN_RANGE);
     ret |= LCD_WRITE_CMD(x0);
-    ret |= LCD_WRITE_CMD(x1 - 1);
+    ret |= LCD_WRITE_CMD(x1);
     ret |= LCD_WRITE_CMD(SSD1306_CMD_SET_PAGE_RANGE);
     ret |= LCD_WRITE_CMD(row1);
     ret |= LCD_WRITE_CMD(row2 - 1);
@@ -256,13 +273,31 @@ esp_err_t lcd_ssd1306_draw_pixel(uint16_t x, uint16_t y, uint16_t color)
     return ESP_ERR_NOT_SUPPORTED;
 }
 
+static esp_err_t lcd_ssd1306_send_gram(uint16_t unit0, uint16_t row0, uint16_t unit1, uint16_t row1, const uint8_t *data, uint32_t length)
+{
+    esp_err_t ret = lcd_ssd1306_set_window(unit0, row0 * 8, unit1, row1 * 8 + 7);
+    if (ESP_OK != ret) {
+        return ESP_FAIL;
+    }
+    return LCD_WRITE(data, length);
+}
+
 esp_err_t lcd_ssd1306_draw_bitmap(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *bitmap)
 {
     LCD_CHECK((x + w <= g_lcd_handle.width) && (y + h <= g_lcd_handle.height), "The set coordinates exceed the screen size", ESP_ERR_INVALID_ARG);
     esp_err_t ret = ESP_OK;
+    LCD_CHECK((0 == (y % 8)) && (0 == (h % 8)), "y and h should be multiples of 8", ESP_ERR_INVALID_ARG);
     uint8_t *p = (uint8_t *)bitmap;
 
     LCD_IFACE_ACQUIRE();
+    if (NULL != g_gram.gram) {
+        /* only the columns of each page that differ from the panel */
+        ret = scr_shadow_update(&g_gram, x, y / 8, w, h / 8, p, lcd_ssd1306_send_gram);
+        LCD_IFACE_RELEASE();
+        LCD_CHECK(ESP_OK == ret, "Draw bitmap failed", ESP_FAIL);
+        return ESP_OK;
+    }
+
     ret = lcd_ssd1306_set_window(x, y, x + w - 1, y + h - 1);
     if (ESP_OK != ret) {
         return ESP_FAIL;
@@ -274,6 +309,21 @@ esp_err_t lcd_ssd1306_draw_bitmap(uint16_t x, uint16_t y, uint16_t w, uint16_t h
     return ESP_OK;
 }
 
+esp_err_t lcd_ssd1306_draw_bitmap_async(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *bitmap, scr_interface_done_cb_t done_cb, void *user_ctx)
+{
+    /* pages of 1-bit pixels, the changes are small enough to be sent before returning */
+    esp_err_t ret = lcd_ssd1306_draw_bitmap(x, y, w, h, (uint16_t *)bitmap);
+    if (ESP_OK == ret && done_cb) {
+        done_cb(user_ctx);
+    }
+    return ret;
+}
+
+esp_err_t lcd_ssd1306_draw_wait(void)
+{
+    return ESP_OK;
+}
+
 esp_err_t lcd_ssd1306_display_on(void)
 {
     esp_err_t ret;
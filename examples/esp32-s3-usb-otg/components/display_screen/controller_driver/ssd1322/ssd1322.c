@@ -68,6 +68,15 @@ static const char *TAG = "lcd ssd1322";
 
 static scr_handle_t g_lcd_handle;
 
+/**
+ * Copy of the GRAM, one row per line and one unit per column address, i.e. 4 pixels in
+ * 2 bytes. Setting a window takes 3 commands and 4 data bytes, 23 bytes on I2C with the
+ * data transfer header, so unchanged columns up to that are sent rather than opening another
+ * window.
+ */
+#define SSD1322_WINDOW_COST                    23
+static scr_shadow_t g_gram;
+
 /**
  * This header file is only used to redefine the function to facilitate the call.
  * It can only be placed in this position, not in the head of the file.
@@ -84,6 +93,8 @@ scr_driver_t lcd_ssd1322_default_driver = {
     .write_ram_data = lcd_ssd1322_write_ram_data,
     .draw_pixel = lcd_ssd1322_draw_pixel,
     .draw_bitmap = lcd_ssd1322_draw_bitmap,
+    .draw_bitmap_async = lcd_ssd1322_draw_bitmap_async,
+    .draw_wait = lcd_ssd1322_draw_wait,
     .get_info = lcd_ssd1322_get_info,
 };
 
@@ -168,11 +179,16 @@ esp_err_t lcd_ssd1322_init(const scr_controller_config_t *lcd_conf)
     LCD_WRITE_CMD(SSD1322_DISPLAYON);   //Sleep Out
 
     lcd_ssd1322_set_rotate(lcd_conf->rotate);
+
+    if (ESP_OK != scr_shadow_init(&g_gram, g_lcd_handle.height, g_lcd_handle.width / 4, 2, SSD1322_WINDOW_COST)) {
+        ESP_LOGW(TAG, "No copy of the GRAM, every bitmap is sent in full");
+    }
     return ESP_OK;
 }
 
 esp_err_t lcd_ssd1322_deinit(void)
 {
+    scr_shadow_deinit(&g_gram);
     memset(&g_lcd_handle, 0, sizeof(scr_handle_t));
     return ESP_OK;
 }
@@ -229,6 +245,8 @@ esp_err_t lcd_ssd1322_set_rotate(scr_dir_t dir)
     ret |= LCD_WRITE_DATA(reg_data);
     ret |= LCD_WRITE_DATA(0x11);
     LCD_CHECK(ESP_OK == ret, "Set screen rotate failed", ESP_FAIL);
+    /* the remap applies to the next writes */
+    scr_shadow_invalidate(&g_gram);
     g_lcd_handle.dir = dir;
     return ESP_OK;
 }
@@ -264,12 +282,29 @@ esp_err_t lcd_ssd1322_draw_pixel(uint16_t x, uint16_t y, uint16_t color)
     return ESP_ERR_NOT_SUPPORTED;
 }
 
+static esp_err_t lcd_ssd1322_send_gram(uint16_t unit0, uint16_t row0, uint16_t unit1, uint16_t row1, const uint8_t *data, uint32_t length)
+{
+    esp_err_t ret = lcd_ssd1322_set_window(unit0 * 4, row0, unit1 * 4 + 3, row1);
+    if (ESP_OK != ret) {
+        return ESP_FAIL;
+    }
+    return LCD_WRITE(data, length);
+}
+
 esp_err_t lcd_ssd1322_draw_bitmap(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *bitmap)
 {
     LCD_CHECK((x + w <= g_lcd_handle.width) && (y + h <= g_lcd_handle.height), "The set coordinates exceed the screen size", ESP_ERR_INVALID_ARG);
     esp_err_t ret = ESP_OK;
+    LCD_CHECK((0 == (x % 4)) && (0 == (w % 4)), "x and w should be multiples of 4", ESP_ERR_INVALID_ARG);
     uint8_t *p = (uint8_t *)bitmap;
 
+    if (NULL != g_gram.gram) {
+        /* only the column addresses of each line that differ from the panel */
+        ret = scr_shadow_update(&g_gram, x / 4, y, w / 4, h, p, lcd_ssd1322_send_gram);
+        LCD_CHECK(ESP_OK == ret, "Draw bitmap failed", ESP_FAIL);
+        return ESP_OK;
+    }
+
     ret = lcd_ssd1322_set_window(x, y, x + w - 1, y + h - 1);
     if (ESP_OK != ret) {
         return ESP_FAIL;
@@ -279,6 +314,21 @@ esp_err_t lcd_ssd1322_draw_bitmap(uint16_t x, uint16_t y, uint16_t w, uint16_t h
     return ESP_OK;
 }
 
+esp_err_t lcd_ssd1322_draw_bitmap_async(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *bitmap, scr_interface_done_cb_t done_cb, void *user_ctx)
+{
+    /* 4-bit gray pixels, the changes are small enough to be sent before returning */
+    esp_err_t ret = lcd_ssd1322_draw_bitmap(x, y, w, h, (uint16_t *)bitmap);
+    if (ESP_OK == ret && done_cb) {
+        done_cb(user_ctx);
+    }
+    return ret;
+}
+
+esp_err_t lcd_ssd1322_draw_wait(void)
+{
+    return ESP_OK;
+}
+
 esp_err_t lcd_ssd1322_set_contrast(uint8_t contrast)
 {
     esp_err_t ret;
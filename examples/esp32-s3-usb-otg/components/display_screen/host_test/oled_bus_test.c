@@ -0,0 +1,316 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Bytes on the bus of the monochrome and gray OLED drivers for typical UI updates.
+ *
+ * The drivers run on the virtual I2C interface (virtual_iface.h), which counts what a real
+ * bus carries: every command or single data byte is one transaction of address, control
+ * byte and value, a block write is address, control byte and the data. Behind it, the model
+ * of the controller keeps its own GRAM, which must equal the frame the UI drew after every
+ * update. Each step prints the bytes the driver sent and the bytes of the same update
+ * sent in full, as the drivers did before they kept a copy of the GRAM. On I2C that byte
+ * count is the frame rate.
+ *
+ * Usage:
+ *     oled_bus_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "screen_driver.h"
+#include "virtual_iface.h"
+
+#define I2C_CMD_BYTES       3           /*!< address, control byte, command */
+#define I2C_WRITE_BYTES     2           /*!< address, control byte, then the data */
+
+static scr_interface_driver_t *s_iface;
+
+static scr_interface_driver_t *iface_create(virtual_panel_t panel, int width, int height)
+{
+    virtual_iface_config_t cfg = {
+        .type = SCREEN_IFACE_I2C,
+        .clk_hz = 400000,
+        .panel = panel,
+        .width = width,
+        .height = height,
+    };
+    s_iface = virtual_iface_create(&cfg);
+    return s_iface;
+}
+
+static const uint8_t *iface_gram(uint32_t *stride)
+{
+    return virtual_iface_gram(s_iface, stride);
+}
+
+/* bytes on the bus since the last call, the model must have decoded all of them */
+static uint32_t iface_bytes(const char *what)
+{
+    virtual_iface_stats_t stats;
+    virtual_iface_get_stats(s_iface, &stats);
+    virtual_iface_reset_stats(s_iface);
+    if (stats.errors) {
+        printf("%-34s %u writes outside the window\n", what, stats.errors);
+    }
+    return stats.errors ? UINT32_MAX : stats.bytes;
+}
+
+/* ---------------------------------------------------------------- 1-bit pages, SSD1306 and SSD1307 */
+
+#define W1306   128
+#define H1306   64
+static uint8_t s_fb[H1306 / 8][W1306];
+static int s_h;                         /*!< 64 for SSD1306, 40 for SSD1307 */
+
+static void fb_set(int x, int y, int on)
+{
+    if (on) {
+        s_fb[y / 8][x] |= 1 << (y % 8);
+    } else {
+        s_fb[y / 8][x] &= ~(1 << (y % 8));
+    }
+}
+
+static void fb_rect(int x, int y, int w, int h, int on)
+{
+    for (int j = y; j < y + h; j++) {
+        for (int i = x; i < x + w; i++) {
+            fb_set(i, j, on);
+        }
+    }
+}
+
+/* a 5x7 blob per digit, different for each value, enough to change a few columns */
+static void fb_digit(int x, int y, int d)
+{
+    fb_rect(x, y, 6, 8, 0);
+    for (int i = 0; i < 5; i++) {
+        for (int j = 0; j < 7; j++) {
+            fb_set(x + i, y + j, ((d * 7 + i * 3 + j) % 5) < 2);
+        }
+    }
+}
+
+static void fb_text(int x, int y, const char *s)
+{
+    for (; *s; s++, x += 6) {
+        fb_digit(x, y, *s);
+    }
+}
+
+static int check_1306(const char *what)
+{
+    uint32_t stride;
+    const uint8_t *gram = iface_gram(&stride);
+    for (int p = 0; p < s_h / 8; p++) {
+        if (memcmp(&gram[p * stride], s_fb[p], W1306)) {
+            printf("%-34s panel differs from the frame on page %d\n", what, p);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int report(const char *what, uint32_t bytes, uint32_t full)
+{
+    printf("%-34s %6u bytes  (full update %6u, %5.1f%%)\n", what, bytes, full, full ? 100.0 * bytes / full : 0.0);
+    return bytes > full;
+}
+
+/* flush the whole frame, as a UI with a full-screen buffer does */
+static int step_frame(scr_driver_t *lcd, const char *what)
+{
+    virtual_iface_reset_stats(s_iface);
+    if (ESP_OK != lcd->draw_bitmap(0, 0, W1306, s_h, (uint16_t *)s_fb)) {
+        printf("%-34s draw_bitmap failed\n", what);
+        return 1;
+    }
+    int fail = check_1306(what);
+    /* 8 window commands, then the frame */
+    return fail + report(what, iface_bytes(what), 8 * I2C_CMD_BYTES + I2C_WRITE_BYTES + W1306 * s_h / 8);
+}
+
+/* flush one widget, pages x..x+w-1, y..y+h-1 of the frame */
+static int step_area(scr_driver_t *lcd, const char *what, int x, int y, int w, int h)
+{
+    uint8_t *area = malloc(w * h / 8);
+    for (int p = 0; p < h / 8; p++) {
+        memcpy(area + p * w, &s_fb[y / 8 + p][x], w);
+    }
+    virtual_iface_reset_stats(s_iface);
+    esp_err_t ret = lcd->draw_bitmap(x, y, w, h, (uint16_t *)area);
+    free(area);
+    if (ESP_OK != ret) {
+        printf("%-34s draw_bitmap failed\n", what);
+        return 1;
+    }
+    int fail = check_1306(what);
+    return fail + report(what, iface_bytes(what), 8 * I2C_CMD_BYTES + I2C_WRITE_BYTES + w * h / 8);
+}
+
+static int test_ssd130x(scr_controller_t controller, const char *name, int height)
+{
+    int fail = 0;
+    scr_driver_t lcd;
+    scr_controller_config_t cfg = {
+        .interface_drv = iface_create(VIRTUAL_PANEL_SSD1306, W1306, height),
+        .pin_num_rst = -1,
+        .pin_num_bckl = -1,
+        .width = W1306,
+        .height = height,
+        .rotate = SCR_DIR_LRTB,
+    };
+    s_h = height;
+    if (ESP_OK != scr_find_driver(controller, &lcd) || ESP_OK != lcd.init(&cfg)) {
+        printf("%s init failed\n", name);
+        return 1;
+    }
+
+    printf("%s 128x%d on I2C\n", name, height);
+    /* status bar, clock, a progress bar and a line of text */
+    memset(s_fb, 0, sizeof(s_fb));
+    fb_rect(0, 9, W1306, 1, 1);
+    fb_text(2, 0, "12:00");
+    fb_rect(100, 0, 24, 7, 1);
+    fb_rect(4, 24, 120, 8, 1);
+    fb_rect(5, 25, 118, 6, 0);
+    fb_text(4, 16, "temp 21.5C");
+    fail += step_frame(&lcd, "first frame");
+    fail += step_frame(&lcd, "same frame again");
+
+    fb_digit(2 + 4 * 6, 0, '1');
+    fail += step_frame(&lcd, "clock, last digit");
+    fb_text(2, 0, "12:10");
+    fail += step_frame(&lcd, "clock, two digits");
+
+    fb_rect(5, 25, 10, 6, 1);
+    fail += step_frame(&lcd, "progress bar +10 px");
+
+    fb_rect(100, 0, 24, 7, 0);
+    fb_rect(100, 0, 12, 7, 1);
+    fb_text(4, 16, "temp 21.6C");
+    fail += step_frame(&lcd, "battery icon and text");
+
+    fb_text(4, 16, "temp 21.7C");
+    fail += step_area(&lcd, "text widget only", 0, 16, W1306, 8);
+    fail += step_area(&lcd, "text widget, unchanged", 0, 16, W1306, 8);
+
+    /* a line scrolled by one pixel changes every column of its page */
+    for (int i = 0; i < 20; i++) {
+        fb_digit(4 + i * 6, 32, 'a' + i);
+    }
+    fail += step_frame(&lcd, "ticker line");
+    for (int x = 0; x < W1306 - 1; x++) {
+        s_fb[4][x] = s_fb[4][x + 1];
+    }
+    fail += step_frame(&lcd, "ticker scrolled 1 px");
+
+    for (int p = 0; p < s_h / 8; p++) {
+        for (int x = 0; x < W1306; x++) {
+            s_fb[p][x] ^= 0xff;
+        }
+    }
+    fail += step_frame(&lcd, "whole screen inverted");
+
+    /* after a rotation nothing of the panel is known */
+    lcd.set_direction(SCR_DIR_LRTB);
+    virtual_iface_reset_stats(s_iface);
+    lcd.draw_bitmap(0, 0, W1306, s_h, (uint16_t *)s_fb);
+    if (iface_bytes("frame after set_direction") < W1306 * s_h / 8) {
+        printf("frame after set_direction not sent in full\n");
+        fail++;
+    }
+    fail += check_1306("frame after set_direction");
+
+    lcd.deinit();
+    virtual_iface_delete(s_iface);
+    return fail;
+}
+
+/* ---------------------------------------------------------------- 4-bit gray */
+
+#define W1322   256
+#define H1322   64
+static uint8_t s_gray[H1322][W1322 / 2];
+
+static int check_1322(const char *what)
+{
+    uint32_t stride;
+    const uint8_t *gram = iface_gram(&stride);
+    for (int y = 0; y < H1322; y++) {
+        if (memcmp(&gram[y * stride], s_gray[y], W1322 / 2)) {
+            printf("%-34s panel differs from the frame on line %d\n", what, y);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int step_gray(scr_driver_t *lcd, const char *what)
+{
+    virtual_iface_reset_stats(s_iface);
+    if (ESP_OK != lcd->draw_bitmap(0, 0, W1322, H1322, (uint16_t *)s_gray)) {
+        printf("%-34s draw_bitmap failed\n", what);
+        return 1;
+    }
+    int fail = check_1322(what);
+    /* 3 commands and 4 arguments, then the frame */
+    return fail + report(what, iface_bytes(what), 7 * I2C_CMD_BYTES + I2C_WRITE_BYTES + W1322 * H1322 / 2);
+}
+
+static int test_ssd1322(void)
+{
+    int fail = 0;
+    scr_driver_t lcd;
+    scr_controller_config_t cfg = {
+        .interface_drv = iface_create(VIRTUAL_PANEL_SSD1322, W1322, H1322),
+        .pin_num_rst = -1,
+        .pin_num_bckl = -1,
+        .width = W1322,
+        .height = H1322,
+        .rotate = SCR_DIR_LRTB,
+    };
+    if (ESP_OK != scr_find_driver(SCREEN_CONTROLLER_SSD1322, &lcd) || ESP_OK != lcd.init(&cfg)) {
+        printf("ssd1322 init failed\n");
+        return 1;
+    }
+
+    printf("SSD1322 256x64 on I2C\n");
+    for (int y = 0; y < H1322; y++) {
+        for (int x = 0; x < W1322 / 2; x++) {
+            s_gray[y][x] = (y < 16) ? 0x11 * (x % 16) : 0;
+        }
+    }
+    fail += step_gray(&lcd, "first frame");
+    fail += step_gray(&lcd, "same frame again");
+    for (int y = 30; y < 40; y++) {
+        for (int x = 20; x < 28; x++) {
+            s_gray[y][x] = 0xf0 | (y & 0xf);
+        }
+    }
+    fail += step_gray(&lcd, "a 16x10 glyph");
+    for (int y = 20; y < 28; y++) {
+        s_gray[y][4] = 0xff;
+        s_gray[y][120] = 0xff;
+    }
+    fail += step_gray(&lcd, "two marks far apart");
+
+    lcd.deinit();
+    virtual_iface_delete(s_iface);
+    return fail;
+}
+
+int main(void)
+{
+    int fail = test_ssd130x(SCREEN_CONTROLLER_SSD1306, "SSD1306", 64);
+    fail += test_ssd130x(SCREEN_CONTROLLER_SSD1307, "SSD1307", 40);
+    fail += test_ssd1322();
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail ? 1 : 0;
+}
@@ -0,0 +1,436 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Bytes on the wire and estimated time of the screen drivers and the painter, without a screen.
+ *
+ * Every controller driver runs on the virtual interface (virtual_iface.h) with the bus and
+ * clock it is usually wired to: init, a full frame, a 32x32 bitmap and a pixel. The frame
+ * is read back from the model of the GRAM and must be the bitmap that was drawn. Then each
+ * painter primitive is drawn on an ST7789 240x240 on SPI, once directly and once in a
+ * batch (painter_batch_begin/end), and a test screen drawn both ways must end up the same
+ * in the GRAM.
+ *
+ * Times are the bus time plus a fixed overhead per transaction, see virtual_iface.c. They
+ * compare drivers and primitives; the target can be slower when the CPU is the bottleneck.
+ *
+ * Usage:
+ *     screen_bench [-o dir]      -o saves the GRAM of every test as dir/<name>.ppm
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "screen_driver.h"
+#include "display_painter.h"
+#include "virtual_iface.h"
+
+typedef struct {
+    const char *name;
+    scr_controller_t controller;
+    scr_interface_type_t bus;
+    uint32_t clk_hz;
+    uint8_t bus_width;
+    virtual_panel_t panel;
+    uint16_t width;                     /*!< screen */
+    uint16_t height;
+    uint16_t gram_width;                /*!< controller */
+    uint16_t gram_height;
+    uint8_t bpp;
+} bench_panel_t;
+
+static const bench_panel_t s_panels[] = {
+    {"ILI9341", SCREEN_CONTROLLER_ILI9341, SCREEN_IFACE_SPI,  40000000,  8, VIRTUAL_PANEL_MIPI,    240, 320, 240, 320, 16},
+    {"ST7789",  SCREEN_CONTROLLER_ST7789,  SCREEN_IFACE_SPI,  40000000,  8, VIRTUAL_PANEL_MIPI,    240, 240, 240, 320, 16},
+    {"ST7796",  SCREEN_CONTROLLER_ST7796,  SCREEN_IFACE_SPI,  40000000,  8, VIRTUAL_PANEL_MIPI,    320, 480, 320, 480, 16},
+    {"SSD1351", SCREEN_CONTROLLER_SSD1351, SCREEN_IFACE_SPI,  20000000,  8, VIRTUAL_PANEL_SSD1351, 128, 128, 128, 128, 16},
+    {"ILI9486", SCREEN_CONTROLLER_ILI9486, SCREEN_IFACE_8080, 20000000, 16, VIRTUAL_PANEL_MIPI,    320, 480, 320, 480, 16},
+    {"ILI9806", SCREEN_CONTROLLER_ILI9806, SCREEN_IFACE_8080, 20000000, 16, VIRTUAL_PANEL_MIPI,    480, 854, 480, 854, 16},
+    {"NT35510", SCREEN_CONTROLLER_NT35510, SCREEN_IFACE_8080, 20000000, 16, VIRTUAL_PANEL_MIPI,    480, 800, 480, 800, 16},
+    {"RM68120", SCREEN_CONTROLLER_RM68120, SCREEN_IFACE_8080, 20000000, 16, VIRTUAL_PANEL_MIPI,    480, 800, 480, 800, 16},
+    {"SSD1306", SCREEN_CONTROLLER_SSD1306, SCREEN_IFACE_I2C,    400000,  8, VIRTUAL_PANEL_SSD1306, 128,  64, 128,  64,  1},
+    {"SSD1307", SCREEN_CONTROLLER_SSD1307, SCREEN_IFACE_I2C,    400000,  8, VIRTUAL_PANEL_SSD1306, 128,  40, 128,  40,  1},
+    {"SSD1322", SCREEN_CONTROLLER_SSD1322, SCREEN_IFACE_SPI,  10000000,  8, VIRTUAL_PANEL_SSD1322, 256,  64, 256,  64,  4},
+};
+
+static const char *s_ppm_dir;
+
+static const char *bus_name(const bench_panel_t *p)
+{
+    static char name[16];
+    switch (p->bus) {
+    case SCREEN_IFACE_I2C:
+        return "I2C";
+    case SCREEN_IFACE_8080:
+        snprintf(name, sizeof(name), "8080/%u", p->bus_width);
+        return name;
+    default:
+        return "SPI";
+    }
+}
+
+static scr_interface_driver_t *panel_iface(const bench_panel_t *p)
+{
+    virtual_iface_config_t cfg = {
+        .type = p->bus,
+        .clk_hz = p->clk_hz,
+        .bus_width = p->bus_width,
+        .swap_data = true,
+        .panel = p->panel,
+        .width = p->gram_width,
+        .height = p->gram_height,
+    };
+    return virtual_iface_create(&cfg);
+}
+
+static virtual_iface_stats_t take_stats(scr_interface_driver_t *iface)
+{
+    virtual_iface_stats_t stats;
+    virtual_iface_get_stats(iface, &stats);
+    virtual_iface_reset_stats(iface);
+    return stats;
+}
+
+static void dump(scr_interface_driver_t *iface, const char *name)
+{
+    if (NULL == s_ppm_dir) {
+        return;
+    }
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s.ppm", s_ppm_dir, name);
+    if (ESP_OK != virtual_iface_dump_ppm(iface, path)) {
+        printf("cannot write %s\n", path);
+    }
+}
+
+/* ---------------------------------------------------------------- controllers */
+
+/* the bitmap in the format of the controller, rows of GRAM as the model keeps them */
+static uint8_t *frame_pattern(const bench_panel_t *p, uint32_t *size)
+{
+    *size = p->width * p->height * p->bpp / 8;
+    uint8_t *frame = malloc(*size);
+    if (16 == p->bpp) {
+        uint16_t *px = (uint16_t *)frame;
+        for (int y = 0; y < p->height; y++) {
+            for (int x = 0; x < p->width; x++) {
+                px[y * p->width + x] = ((x * 32 / p->width) << 11) | ((y * 64 / p->height) << 5) | ((x ^ y) & 0x1f);
+            }
+        }
+    } else {
+        for (uint32_t i = 0; i < *size; i++) {
+            frame[i] = i * 37 + (i >> 7);
+        }
+    }
+    return frame;
+}
+
+static int frame_check(const bench_panel_t *p, scr_interface_driver_t *iface, const uint8_t *frame)
+{
+    uint32_t stride;
+    const uint8_t *gram = virtual_iface_gram(iface, &stride);
+    uint32_t line = p->width * (16 == p->bpp ? 2 : 1) / (4 == p->bpp ? 2 : 1);
+    int rows = 1 == p->bpp ? p->height / 8 : p->height;
+    for (int r = 0; r < rows; r++) {
+        if (memcmp(gram + r * stride, frame + r * line, line)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void print_cost(const virtual_iface_stats_t *s)
+{
+    printf(" %8llu %9.3f", (unsigned long long)s->bytes, s->time_ns / 1e6);
+}
+
+static int bench_controllers(void)
+{
+    int fail = 0;
+    printf("%-8s %-7s %5s %9s | %18s | %18s %6s | %18s | %18s\n", "", "bus", "MHz", "size",
+           "init bytes     ms", "frame bytes    ms", "fps", "32x32 bytes    ms", "pixel bytes    ms");
+    for (size_t i = 0; i < sizeof(s_panels) / sizeof(s_panels[0]); i++) {
+        const bench_panel_t *p = &s_panels[i];
+        scr_interface_driver_t *iface = panel_iface(p);
+        scr_driver_t lcd;
+        scr_controller_config_t cfg = {
+            .interface_drv = iface,
+            .pin_num_rst = -1,
+            .pin_num_bckl = -1,
+            .width = p->width,
+            .height = p->height,
+            .rotate = SCR_DIR_LRTB,
+        };
+        if (NULL == iface || ESP_OK != scr_find_driver(p->controller, &lcd) || ESP_OK != lcd.init(&cfg)) {
+            printf("%-8s init failed\n", p->name);
+            fail++;
+            virtual_iface_delete(iface);
+            continue;
+        }
+        char size[16];
+        snprintf(size, sizeof(size), "%ux%u", p->width, p->height);
+        printf("%-8s %-7s %5.1f %9s |", p->name, bus_name(p), p->clk_hz / 1e6, size);
+        virtual_iface_stats_t init = take_stats(iface);
+        print_cost(&init);
+        printf(" |");
+
+        uint32_t frame_size;
+        uint8_t *frame = frame_pattern(p, &frame_size);
+        esp_err_t ret = lcd.draw_bitmap(0, 0, p->width, p->height, (uint16_t *)frame);
+        virtual_iface_stats_t full = take_stats(iface);
+        print_cost(&full);
+        printf(" %6.1f |", 1e9 / full.time_ns);
+        if (ESP_OK != ret || full.errors || frame_check(p, iface, frame)) {
+            printf(" GRAM differs from the frame\n");
+            fail++;
+        }
+        dump(iface, p->name);
+
+        /* a changed 32x32 area, aligned for the pages and column addresses of the OLEDs */
+        uint32_t area_size = 32 * 32 * p->bpp / 8;
+        uint8_t *area = malloc(area_size);
+        memset(area, 0x5a, area_size);
+        ret = lcd.draw_bitmap(32, 8, 32, 32, (uint16_t *)area);
+        virtual_iface_stats_t small = take_stats(iface);
+        print_cost(&small);
+        printf(" |");
+        free(area);
+
+        if (16 == p->bpp) {
+            ret = lcd.draw_pixel(p->width / 2, p->height / 2, COLOR_RED);
+            virtual_iface_stats_t pixel = take_stats(iface);
+            print_cost(&pixel);
+            fail += (ESP_OK != ret || pixel.errors) ? 1 : 0;
+        } else {
+            printf(" %18s", "-");
+        }
+        printf("\n");
+        fail += (ESP_OK != ret || small.errors) ? 1 : 0;
+
+        free(frame);
+        lcd.deinit();
+        virtual_iface_delete(iface);
+    }
+    return fail;
+}
+
+/* ---------------------------------------------------------------- painter */
+
+static void prim_clear(void)
+{
+    painter_clear(COLOR_NAVY);
+}
+
+static void prim_char(void)
+{
+    painter_draw_char(10, 10, 'A', &Font16, COLOR_WHITE);
+}
+
+static void prim_string(void)
+{
+    painter_draw_string(0, 40, "Hello, ESP32-S3 USB OTG", &Font16, COLOR_YELLOW);
+}
+
+static void prim_num(void)
+{
+    painter_draw_num(10, 60, 12345, 5, &Font24, COLOR_GREEN);
+}
+
+static void prim_hline(void)
+{
+    painter_draw_horizontal_line(0, 100, 240, COLOR_RED);
+}
+
+static void prim_vline(void)
+{
+    painter_draw_vertical_line(120, 0, 240, COLOR_RED);
+}
+
+static void prim_line(void)
+{
+    painter_draw_line(0, 0, 239, 239, COLOR_CYAN);
+}
+
+static void prim_rectangle(void)
+{
+    painter_draw_rectangle(20, 120, 120, 180, COLOR_ORANGE);
+}
+
+static void prim_filled_rectangle(void)
+{
+    painter_draw_filled_rectangle(130, 120, 230, 180, COLOR_MAGENTA);
+}
+
+static void prim_circle(void)
+{
+    painter_draw_circle(60, 200, 30, COLOR_WHITE);
+}
+
+static void prim_filled_circle(void)
+{
+    painter_draw_filled_circle(180, 200, 30, COLOR_GREENYELLOW);
+}
+
+static void prim_image(void)
+{
+    static uint16_t img[64 * 64];
+    for (int i = 0; i < 64 * 64; i++) {
+        img[i] = (i * 97) & 0xffff;
+    }
+    painter_draw_image(160, 20, 64, 64, img);
+}
+
+typedef struct {
+    const char *name;
+    void (*draw)(void);
+} bench_primitive_t;
+
+static const bench_primitive_t s_primitives[] = {
+    {"clear", prim_clear},
+    {"char Font16", prim_char},
+    {"string Font16, 23 chars", prim_string},
+    {"num Font24, 5 digits", prim_num},
+    {"horizontal line 240", prim_hline},
+    {"vertical line 240", prim_vline},
+    {"diagonal line 240", prim_line},
+    {"rectangle 100x60", prim_rectangle},
+    {"filled rectangle 100x60", prim_filled_rectangle},
+    {"circle r30", prim_circle},
+    {"filled circle r30", prim_filled_circle},
+    {"image 64x64", prim_image},
+};
+
+#define PRIMITIVES  (sizeof(s_primitives) / sizeof(s_primitives[0]))
+
+static scr_interface_driver_t *painter_open(const bench_panel_t *p, scr_driver_t *lcd)
+{
+    scr_interface_driver_t *iface = panel_iface(p);
+    scr_controller_config_t cfg = {
+        .interface_drv = iface,
+        .pin_num_rst = -1,
+        .pin_num_bckl = -1,
+        .width = p->width,
+        .height = p->height,
+        .rotate = SCR_DIR_LRTB,
+    };
+    if (NULL == iface || ESP_OK != scr_find_driver(p->controller, lcd) || ESP_OK != lcd->init(&cfg)) {
+        virtual_iface_delete(iface);
+        return NULL;
+    }
+    painter_init(lcd);
+    painter_set_back_color(COLOR_BLACK);
+    return iface;
+}
+
+static void painter_close(scr_driver_t *lcd, scr_interface_driver_t *iface)
+{
+    painter_batch_release();
+    painter_glyph_cache_clear();
+    lcd->deinit();
+    virtual_iface_delete(iface);
+}
+
+/* each primitive on its own, on a cleared screen */
+static void bench_primitives(const bench_panel_t *p, bool batch, virtual_iface_stats_t *out)
+{
+    scr_driver_t lcd;
+    scr_interface_driver_t *iface = painter_open(p, &lcd);
+    for (size_t i = 0; i < PRIMITIVES; i++) {
+        painter_clear(COLOR_BLACK);
+        if (batch) {
+            /* the first batch allocates the canvas, it is kept for the following ones */
+            painter_batch_begin();
+            painter_batch_end();
+        }
+        take_stats(iface);
+        if (batch) {
+            painter_batch_begin();
+        }
+        s_primitives[i].draw();
+        if (batch) {
+            painter_batch_end();
+        }
+        out[i] = take_stats(iface);
+    }
+    painter_close(&lcd, iface);
+}
+
+/* all primitives on one screen, the GRAM is returned in gram */
+static int painter_screen(const bench_panel_t *p, bool batch, uint8_t *gram, size_t size, virtual_iface_stats_t *stats)
+{
+    scr_driver_t lcd;
+    scr_interface_driver_t *iface = painter_open(p, &lcd);
+    if (NULL == iface) {
+        return 1;
+    }
+    take_stats(iface);
+    if (batch) {
+        painter_batch_begin();
+    }
+    for (size_t i = 0; i < PRIMITIVES; i++) {
+        s_primitives[i].draw();
+    }
+    if (batch) {
+        painter_batch_end();
+    }
+    *stats = take_stats(iface);
+    memcpy(gram, virtual_iface_gram(iface, NULL), size);
+    dump(iface, batch ? "painter_batch" : "painter_direct");
+    painter_close(&lcd, iface);
+    return stats->errors ? 1 : 0;
+}
+
+static int bench_painter(void)
+{
+    const bench_panel_t *p = &s_panels[1];
+    virtual_iface_stats_t direct[PRIMITIVES], batch[PRIMITIVES];
+    int fail = 0;
+
+    printf("\npainter on %s %ux%u, %s %.0f MHz\n", p->name, p->width, p->height, bus_name(p), p->clk_hz / 1e6);
+    bench_primitives(p, false, direct);
+    bench_primitives(p, true, batch);
+    printf("%-24s | %27s | %27s\n", "", "direct", "batch");
+    printf("%-24s | %8s %8s %9s | %8s %8s %9s\n", "", "bytes", "trans", "ms", "bytes", "trans", "ms");
+    for (size_t i = 0; i < PRIMITIVES; i++) {
+        printf("%-24s | %8llu %8u %9.3f | %8llu %8u %9.3f\n", s_primitives[i].name,
+               (unsigned long long)direct[i].bytes, direct[i].transactions, direct[i].time_ns / 1e6,
+               (unsigned long long)batch[i].bytes, batch[i].transactions, batch[i].time_ns / 1e6);
+        fail += (direct[i].errors || batch[i].errors) ? 1 : 0;
+    }
+
+    size_t size = p->gram_width * p->gram_height * 2;
+    uint8_t *gram_direct = malloc(size);
+    uint8_t *gram_batch = malloc(size);
+    virtual_iface_stats_t sd, sb;
+    fail += painter_screen(p, false, gram_direct, size, &sd);
+    fail += painter_screen(p, true, gram_batch, size, &sb);
+    /* only the screen, the rest of the GRAM keeps its noise */
+    if (memcmp(gram_direct, gram_batch, p->width * p->height * 2)) {
+        printf("the screen drawn in a batch differs from the one drawn directly\n");
+        fail++;
+    }
+    printf("%-24s | %8llu %8u %9.3f | %8llu %8u %9.3f\n", "all of the above",
+           (unsigned long long)sd.bytes, sd.transactions, sd.time_ns / 1e6,
+           (unsigned long long)sb.bytes, sb.transactions, sb.time_ns / 1e6);
+    free(gram_direct);
+    free(gram_batch);
+    return fail;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 3 && 0 == strcmp(argv[1], "-o")) {
+        s_ppm_dir = argv[2];
+    } else if (argc != 1) {
+        printf("usage: %s [-o dir]\n", argv[0]);
+        return 2;
+    }
+    int fail = bench_controllers();
+    fail += bench_painter();
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail ? 1 : 0;
+}
@@ -0,0 +1,28 @@
+/* Host build: reset and backlight pins are not driven */
+#pragma once
+#include "esp_err.h"
+
+typedef int gpio_num_t;
+typedef int gpio_mode_t;
+
+#define GPIO_MODE_OUTPUT                1
+#define GPIO_IS_VALID_OUTPUT_GPIO(n)    ((n) >= 0)
+
+static inline void gpio_pad_select_gpio(int gpio_num)
+{
+    (void)gpio_num;
+}
+
+static inline esp_err_t gpio_set_direction(int gpio_num, gpio_mode_t mode)
+{
+    (void)gpio_num;
+    (void)mode;
+    return ESP_OK;
+}
+
+static inline esp_err_t gpio_set_level(int gpio_num, uint32_t level)
+{
+    (void)gpio_num;
+    (void)level;
+    return ESP_OK;
+}
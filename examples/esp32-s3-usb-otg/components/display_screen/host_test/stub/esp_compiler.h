@@ -0,0 +1,5 @@
+/* Host build: branch hints */
+#pragma once
+
+#define likely(x)      __builtin_expect(!!(x), 1)
+#define unlikely(x)    __builtin_expect(!!(x), 0)
@@ -0,0 +1,12 @@
+/* Host build: ticks are milliseconds */
+#pragma once
+#include <stdint.h>
+#include "esp_compiler.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define portMAX_DELAY       0xffffffffu
+#define portTICK_RATE_MS    1
+#define portTICK_PERIOD_MS  1
+#define pdMS_TO_TICKS(ms)   (ms)
@@ -0,0 +1,27 @@
+/* Host build: one task, a mutex is always free */
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+typedef void *SemaphoreHandle_t;
+
+#define pdTRUE      1
+#define pdFALSE     0
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    static int s_mutex;
+    return &s_mutex;
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks)
+{
+    (void)mutex;
+    (void)ticks;
+    return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex)
+{
+    (void)mutex;
+    return pdTRUE;
+}
@@ -0,0 +1,8 @@
+/* Host build: delays of the reset sequences are skipped */
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+static inline void vTaskDelay(TickType_t ticks)
+{
+    (void)ticks;
+}
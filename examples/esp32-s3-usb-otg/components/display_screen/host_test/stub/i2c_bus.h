@@ -0,0 +1,4 @@
+/* Host build: the handle types of the bus drivers, the test provides the interface */
+#pragma once
+
+typedef void *i2c_bus_handle_t;
@@ -0,0 +1,4 @@
+/* Host build: the handle types of the bus drivers, the test provides the interface */
+#pragma once
+
+typedef void *i2s_lcd_handle_t;
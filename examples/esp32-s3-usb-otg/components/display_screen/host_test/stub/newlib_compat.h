@@ -0,0 +1,10 @@
+/* Host build: the newlib extensions the painter uses, included before its sources */
+#pragma once
+#include <stdio.h>
+
+static inline char *itoa(int value, char *str, int base)
+{
+    (void)base;
+    sprintf(str, "%d", value);
+    return str;
+}
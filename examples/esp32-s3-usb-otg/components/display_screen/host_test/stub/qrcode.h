@@ -0,0 +1,36 @@
+/* Host build: the part of the qrcode component the painter uses, no QR code is generated */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef const uint8_t *esp_qrcode_handle_t;
+
+typedef enum {
+    ESP_QRCODE_ECC_LOW,
+    ESP_QRCODE_ECC_MED,
+    ESP_QRCODE_ECC_QUART,
+    ESP_QRCODE_ECC_HIGH,
+} esp_qrcode_ecc_level_t;
+
+typedef struct {
+    void (*display_func)(esp_qrcode_handle_t qrcode);
+    int max_qrcode_version;
+    int qrcode_ecc_level;
+} esp_qrcode_config_t;
+
+static inline void esp_qrcode_print_console(esp_qrcode_handle_t qrcode)
+{
+    (void)qrcode;
+}
+
+static inline int esp_qrcode_get_size(esp_qrcode_handle_t qrcode)
+{
+    (void)qrcode;
+    return 21;
+}
+
+static inline bool esp_qrcode_get_module(esp_qrcode_handle_t qrcode, int x, int y)
+{
+    (void)qrcode;
+    return x >= 0 && y >= 0 && x < 21 && y < 21 && ((x * 7 + y * 3) % 5) < 2;
+}
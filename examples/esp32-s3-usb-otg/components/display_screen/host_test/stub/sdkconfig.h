@@ -0,0 +1,2 @@
+/* Host build: no target options */
+#pragma once
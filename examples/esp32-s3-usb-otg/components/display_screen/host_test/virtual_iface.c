@@ -0,0 +1,424 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "virtual_iface.h"
+
+/* rough figures for the IDF drivers, measure them on the target for real numbers */
+#define SPI_OVERHEAD_NS     10000       /*!< spi_device_transmit of one transaction */
+#define I2C_OVERHEAD_NS     40000       /*!< i2c_master_cmd_begin of one transaction */
+#define I80_OVERHEAD_NS     2000        /*!< one cycle or one DMA transfer of the I2S LCD driver */
+
+#define I2C_HEADER_BYTES    2           /*!< slave address, control byte */
+
+typedef struct {
+    scr_interface_driver_t drv;         /*!< first, the drivers pass it as the handle */
+    virtual_iface_config_t cfg;
+    virtual_iface_stats_t stats;
+    uint8_t *gram;
+    uint32_t stride;                    /*!< bytes per row */
+    uint16_t units;                     /*!< units per row: pixels, or bytes for the 1-bit and 4-bit panels */
+    uint16_t rows;                      /*!< rows: lines, or pages for SSD1306 */
+    uint16_t cmd;                       /*!< last command */
+    uint8_t args;                       /*!< arguments of cmd received */
+    uint8_t arg[4];
+    int c0, c1, r0, r1;                 /*!< window in units and rows */
+    int col, row;                       /*!< where the next unit goes */
+    bool ram_write;                     /*!< data goes to the GRAM */
+    int half;                           /*!< first byte of a pixel split over two writes, -1 if none */
+} virtual_iface_t;
+
+static inline virtual_iface_t *to_virtual(void *handle)
+{
+    return (virtual_iface_t *)handle;
+}
+
+/* ---------------------------------------------------------------- bus */
+
+static void bus_count(virtual_iface_t *v, uint32_t length, bool is_block)
+{
+    const virtual_iface_config_t *cfg = &v->cfg;
+    uint64_t bytes, bus_ns;
+    switch (cfg->type) {
+    case SCREEN_IFACE_I2C:
+        /* address, control byte, then the byte or the block; 9 clocks per byte and a start and a stop */
+        bytes = I2C_HEADER_BYTES + length;
+        bus_ns = (bytes * 9 + 2) * 1000000000ull / cfg->clk_hz;
+        v->stats.time_ns += cfg->overhead_ns ? cfg->overhead_ns : I2C_OVERHEAD_NS;
+        break;
+    case SCREEN_IFACE_8080: {
+        /* a command or a parameter is one cycle, a block fills the data lines */
+        uint32_t lane_bytes = cfg->bus_width / 8;
+        uint64_t cycles = is_block ? (length + lane_bytes - 1) / lane_bytes : 1;
+        bytes = cycles * lane_bytes;
+        bus_ns = cycles * 1000000000ull / cfg->clk_hz;
+        v->stats.time_ns += cfg->overhead_ns ? cfg->overhead_ns : I80_OVERHEAD_NS;
+        break;
+    }
+    case SCREEN_IFACE_SPI:
+    default:
+        /* a command or a parameter is one byte, D/C is a separate line */
+        bytes = length;
+        bus_ns = bytes * 8 * 1000000000ull / cfg->clk_hz;
+        v->stats.time_ns += cfg->overhead_ns ? cfg->overhead_ns : SPI_OVERHEAD_NS;
+        break;
+    }
+    v->stats.bytes += bytes;
+    v->stats.time_ns += bus_ns;
+    v->stats.transactions++;
+}
+
+/* ---------------------------------------------------------------- GRAM models */
+
+static void window_start(virtual_iface_t *v)
+{
+    v->col = v->c0;
+    v->row = v->r0;
+    v->half = -1;
+    if (v->c0 > v->c1 || v->r0 > v->r1 || v->c1 >= v->units || v->r1 >= v->rows) {
+        v->stats.errors++;
+    }
+}
+
+/* one unit of data, written where the window is and then the window moves on */
+static void gram_put(virtual_iface_t *v, const uint8_t *unit, int unit_bytes)
+{
+    if (v->col < v->units && v->row < v->rows) {
+        memcpy(v->gram + v->row * v->stride + v->col * unit_bytes, unit, unit_bytes);
+    } else {
+        v->stats.errors++;
+    }
+    if (++v->col > v->c1) {
+        v->col = v->c0;
+        if (++v->row > v->r1) {
+            v->row = v->r0;
+        }
+    }
+}
+
+/* a byte of memory data as it is on the wire */
+static void gram_byte(virtual_iface_t *v, uint8_t b, bool host_order)
+{
+    if (!v->ram_write) {
+        v->stats.errors++;
+        return;
+    }
+    if (VIRTUAL_PANEL_SSD1306 == v->cfg.panel || VIRTUAL_PANEL_SSD1322 == v->cfg.panel) {
+        gram_put(v, &b, 1);
+        return;
+    }
+    if (v->half < 0) {
+        v->half = b;
+        return;
+    }
+    /* RGB565 is sent high byte first, the swapping drivers take it in host order */
+    uint16_t pixel = host_order ? (v->half | b << 8) : (v->half << 8 | b);
+    v->half = -1;
+    gram_put(v, (const uint8_t *)&pixel, 2);
+}
+
+static void mipi_arg(virtual_iface_t *v, uint8_t dcs, uint8_t index, uint8_t value)
+{
+    if (index >= 4) {
+        return;
+    }
+    v->arg[index] = value;
+    if (3 != index) {
+        return;
+    }
+    int a = v->arg[0] << 8 | v->arg[1];
+    int b = v->arg[2] << 8 | v->arg[3];
+    if (0x2A == dcs) {
+        v->c0 = a;
+        v->c1 = b;
+    } else if (0x2B == dcs) {
+        v->r0 = a;
+        v->r1 = b;
+    }
+}
+
+/* commands of the SSD1306 with their arguments, which are sent as commands too */
+static int ssd1306_args(uint8_t cmd)
+{
+    switch (cmd) {
+    case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3: case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+        return 1;
+    case 0x21: case 0x22: case 0xA3:
+        return 2;
+    case 0x29: case 0x2A:
+        return 5;
+    case 0x26: case 0x27:
+        return 6;
+    default:
+        return 0;
+    }
+}
+
+static void ssd1306_cmd(virtual_iface_t *v, uint8_t value)
+{
+    if (v->args < ssd1306_args(v->cmd)) {
+        v->arg[v->args++] = value;
+        if (2 == v->args && (0x21 == v->cmd || 0x22 == v->cmd)) {
+            if (0x21 == v->cmd) {
+                v->c0 = v->arg[0];
+                v->c1 = v->arg[1];
+            } else {
+                v->r0 = v->arg[0];
+                v->r1 = v->arg[1];
+            }
+            window_start(v);
+        }
+        return;
+    }
+    v->cmd = value;
+    v->args = 0;
+}
+
+static esp_err_t virtual_write_cmd(void *handle, uint16_t cmd)
+{
+    virtual_iface_t *v = to_virtual(handle);
+    bus_count(v, 1, false);
+    v->stats.commands++;
+
+    switch (v->cfg.panel) {
+    case VIRTUAL_PANEL_SSD1306:
+        ssd1306_cmd(v, cmd & 0xff);
+        return ESP_OK;
+    case VIRTUAL_PANEL_MIPI: {
+        /* NT35510 and RM68120 take one register per parameter, 0x2A00 to 0x2A03 */
+        uint8_t dcs = cmd > 0xff ? cmd >> 8 : cmd;
+        v->cmd = cmd;
+        v->args = 0;
+        v->ram_write = (0x2C == dcs || 0x3C == dcs);
+        if (0x2C == dcs) {
+            window_start(v);
+        }
+        return ESP_OK;
+    }
+    default:
+        v->cmd = cmd & 0xff;
+        v->args = 0;
+        v->ram_write = (0x5C == v->cmd);
+        if (v->ram_write) {
+            window_start(v);
+        }
+        return ESP_OK;
+    }
+}
+
+static esp_err_t virtual_write_data(void *handle, uint16_t data)
+{
+    virtual_iface_t *v = to_virtual(handle);
+    bus_count(v, 1, false);
+
+    if (v->ram_write) {
+        gram_byte(v, data & 0xff, false);
+        return ESP_OK;
+    }
+    switch (v->cfg.panel) {
+    case VIRTUAL_PANEL_MIPI:
+        if (v->cmd > 0xff) {
+            mipi_arg(v, v->cmd >> 8, v->cmd & 0xff, data & 0xff);
+        } else {
+            mipi_arg(v, v->cmd, v->args++, data & 0xff);
+        }
+        break;
+    case VIRTUAL_PANEL_SSD1351:
+    case VIRTUAL_PANEL_SSD1322:
+        if ((0x15 == v->cmd || 0x75 == v->cmd) && v->args < 2) {
+            v->arg[v->args++] = data & 0xff;
+            if (2 == v->args) {
+                int a = v->arg[0], b = v->arg[1];
+                if (0x75 == v->cmd) {
+                    v->r0 = a;
+                    v->r1 = b;
+                } else if (VIRTUAL_PANEL_SSD1322 == v->cfg.panel) {
+                    /* a column address is 4 pixels in 2 bytes, the panel starts at 0x1c */
+                    v->c0 = (a - 0x1c) * 2;
+                    v->c1 = (b - 0x1c) * 2 + 1;
+                } else {
+                    v->c0 = a;
+                    v->c1 = b;
+                }
+            }
+        }
+        break;
+    default:
+        break;
+    }
+    return ESP_OK;
+}
+
+static void virtual_block(virtual_iface_t *v, const uint8_t *data, uint32_t length, bool host_order)
+{
+    bus_count(v, length, true);
+    for (uint32_t i = 0; i < length; i++) {
+        gram_byte(v, data[i], host_order);
+    }
+}
+
+static esp_err_t virtual_write(void *handle, const uint8_t *data, uint32_t length)
+{
+    virtual_iface_t *v = to_virtual(handle);
+    virtual_block(v, data, length, v->cfg.swap_data);
+    return ESP_OK;
+}
+
+static esp_err_t virtual_write_async(void *handle, const uint8_t *data, uint32_t length, uint32_t flags, scr_interface_done_cb_t done_cb, void *user_ctx)
+{
+    virtual_iface_t *v = to_virtual(handle);
+    virtual_block(v, data, length, v->cfg.swap_data && !(flags & SCR_IFACE_WRITE_PRESWAPPED));
+    if (done_cb) {
+        done_cb(user_ctx);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t virtual_write_wait(void *handle)
+{
+    return ESP_OK;
+}
+
+static esp_err_t virtual_read(void *handle, uint8_t *data, uint32_t length)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static esp_err_t virtual_bus(void *handle)
+{
+    return ESP_OK;
+}
+
+/* ---------------------------------------------------------------- API */
+
+scr_interface_driver_t *virtual_iface_create(const virtual_iface_config_t *config)
+{
+    virtual_iface_t *v = calloc(1, sizeof(virtual_iface_t));
+    if (NULL == v) {
+        return NULL;
+    }
+    v->cfg = *config;
+    if (0 == v->cfg.bus_width) {
+        v->cfg.bus_width = 8;
+    }
+    switch (config->panel) {
+    case VIRTUAL_PANEL_SSD1306:
+        v->units = config->width;
+        v->rows = config->height / 8;
+        v->stride = v->units;
+        break;
+    case VIRTUAL_PANEL_SSD1322:
+        v->units = config->width / 2;
+        v->rows = config->height;
+        v->stride = v->units;
+        break;
+    default:
+        v->units = config->width;
+        v->rows = config->height;
+        v->stride = v->units * 2;
+        break;
+    }
+    v->gram = malloc(v->stride * v->rows);
+    if (NULL == v->gram) {
+        free(v);
+        return NULL;
+    }
+    /* the same noise every run */
+    uint32_t seed = 0x12345678;
+    for (uint32_t i = 0; i < v->stride * v->rows; i++) {
+        seed = seed * 1664525 + 1013904223;
+        v->gram[i] = seed >> 24;
+    }
+    v->c1 = v->units - 1;
+    v->r1 = v->rows - 1;
+    v->half = -1;
+    /* the SSD1306 takes every data byte as memory data */
+    v->ram_write = (VIRTUAL_PANEL_SSD1306 == config->panel);
+
+    v->drv.type = config->type;
+    v->drv.write_cmd = virtual_write_cmd;
+    v->drv.write_data = virtual_write_data;
+    v->drv.write = virtual_write;
+    v->drv.write_async = virtual_write_async;
+    v->drv.write_wait = virtual_write_wait;
+    v->drv.read = virtual_read;
+    v->drv.bus_acquire = virtual_bus;
+    v->drv.bus_release = virtual_bus;
+    return &v->drv;
+}
+
+void virtual_iface_delete(scr_interface_driver_t *iface)
+{
+    virtual_iface_t *v = to_virtual(iface);
+    if (v) {
+        free(v->gram);
+        free(v);
+    }
+}
+
+void virtual_iface_get_stats(const scr_interface_driver_t *iface, virtual_iface_stats_t *stats)
+{
+    *stats = ((const virtual_iface_t *)iface)->stats;
+}
+
+void virtual_iface_reset_stats(scr_interface_driver_t *iface)
+{
+    memset(&to_virtual(iface)->stats, 0, sizeof(virtual_iface_stats_t));
+}
+
+const uint8_t *virtual_iface_gram(const scr_interface_driver_t *iface, uint32_t *stride)
+{
+    const virtual_iface_t *v = (const virtual_iface_t *)iface;
+    if (stride) {
+        *stride = v->stride;
+    }
+    return v->gram;
+}
+
+uint32_t virtual_iface_get_pixel(const scr_interface_driver_t *iface, int x, int y)
+{
+    const virtual_iface_t *v = (const virtual_iface_t *)iface;
+    switch (v->cfg.panel) {
+    case VIRTUAL_PANEL_SSD1306:
+        return (v->gram[(y / 8) * v->stride + x] >> (y % 8)) & 1 ? 0xffffff : 0;
+    case VIRTUAL_PANEL_SSD1322: {
+        /* the first pixel of a byte is the high nibble */
+        uint8_t b = v->gram[y * v->stride + x / 2];
+        uint32_t g = ((x & 1) ? (b & 0x0f) : (b >> 4)) * 0x11;
+        return g << 16 | g << 8 | g;
+    }
+    default: {
+        uint16_t c;
+        memcpy(&c, v->gram + y * v->stride + x * 2, 2);
+        uint32_t r = (c >> 11) & 0x1f, g = (c >> 5) & 0x3f, b = c & 0x1f;
+        r = r << 3 | r >> 2;
+        g = g << 2 | g >> 4;
+        b = b << 3 | b >> 2;
+        return r << 16 | g << 8 | b;
+    }
+    }
+}
+
+esp_err_t virtual_iface_dump_ppm(const scr_interface_driver_t *iface, const char *path)
+{
+    const virtual_iface_t *v = (const virtual_iface_t *)iface;
+    FILE *f = fopen(path, "wb");
+    if (NULL == f) {
+        return ESP_FAIL;
+    }
+    fprintf(f, "P6\n%u %u\n255\n", v->cfg.width, v->cfg.height);
+    for (int y = 0; y < v->cfg.height; y++) {
+        for (int x = 0; x < v->cfg.width; x++) {
+            uint32_t c = virtual_iface_get_pixel(iface, x, y);
+            uint8_t rgb[3] = {c >> 16, c >> 8, c};
+            fwrite(rgb, 1, 3, f);
+        }
+    }
+    return fclose(f) ? ESP_FAIL : ESP_OK;
+}
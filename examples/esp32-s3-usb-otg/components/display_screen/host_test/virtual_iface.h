@@ -0,0 +1,88 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * A scr_interface_driver_t for the host: what the controller drivers send goes into a
+ * model of the controller's GRAM instead of a bus, and is counted as the bus would carry
+ * it. The GRAM can be read back or saved as a PPM image.
+ *
+ * The models decode the window and memory write commands only. Rotation (MADCTL, segment
+ * remap) is not applied, so the GRAM is in the controller's own addressing.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "scr_interface_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    VIRTUAL_PANEL_MIPI,         /*!< 0x2A columns, 0x2B rows, 0x2C write, RGB565. Also the 16-bit registers of NT35510 and RM68120 (0x2A00..0x2A03) */
+    VIRTUAL_PANEL_SSD1351,      /*!< 0x15 columns, 0x75 rows, 0x5C write, RGB565 */
+    VIRTUAL_PANEL_SSD1306,      /*!< 0x21 columns, 0x22 pages, sent as commands, 1-bit pages. Also SSD1307 */
+    VIRTUAL_PANEL_SSD1322,      /*!< 0x15 column addresses from 0x1c, 0x75 rows, 0x5C write, 4-bit gray */
+} virtual_panel_t;
+
+typedef struct {
+    scr_interface_type_t type;  /*!< bus to count and time */
+    uint32_t clk_hz;            /*!< SPI SCLK, I2C SCL or 8080 WR frequency */
+    uint8_t bus_width;          /*!< 8080 data lines, 8 or 16 */
+    bool swap_data;             /*!< as swap_data of the SPI and 8080 drivers: block data is RGB565 in host order */
+    uint32_t overhead_ns;       /*!< CPU and driver time per transaction, 0 for the default of the bus */
+    virtual_panel_t panel;
+    uint16_t width;             /*!< GRAM size in pixels */
+    uint16_t height;
+} virtual_iface_config_t;
+
+typedef struct {
+    uint64_t bytes;             /*!< bytes on the wire: with I2C addresses and control bytes, whole 8080 bus cycles */
+    uint32_t transactions;      /*!< commands, single data and block writes */
+    uint32_t commands;
+    uint64_t time_ns;           /*!< time on the bus plus the overhead of every transaction */
+    uint32_t errors;            /*!< data outside the GRAM, or windows the model could not decode */
+} virtual_iface_stats_t;
+
+/**
+ * @brief Create a virtual interface, the GRAM starts with noise as a panel at power on
+ *
+ * @return The interface, NULL if out of memory
+ */
+scr_interface_driver_t *virtual_iface_create(const virtual_iface_config_t *config);
+
+void virtual_iface_delete(scr_interface_driver_t *iface);
+
+void virtual_iface_get_stats(const scr_interface_driver_t *iface, virtual_iface_stats_t *stats);
+
+void virtual_iface_reset_stats(scr_interface_driver_t *iface);
+
+/**
+ * @brief Raw GRAM: RGB565 pixels in host order, SSD1306 pages of 128 columns, or SSD1322 bytes of 2 pixels
+ *
+ * @param stride Bytes per row (per page for SSD1306)
+ */
+const uint8_t *virtual_iface_gram(const scr_interface_driver_t *iface, uint32_t *stride);
+
+/**
+ * @brief Color of a pixel of the GRAM as 0xRRGGBB
+ */
+uint32_t virtual_iface_get_pixel(const scr_interface_driver_t *iface, int x, int y);
+
+/**
+ * @brief Save the GRAM as a binary PPM (P6) image
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_FAIL The file could not be written
+ */
+esp_err_t virtual_iface_dump_ppm(const scr_interface_driver_t *iface, const char *path);
+
+#ifdef __cplusplus
+}
+#endif
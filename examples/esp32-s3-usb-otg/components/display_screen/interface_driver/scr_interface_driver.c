@@ -64,6 +64,24 @@ static esp_err_t _i2s_lcd_write(void *handle, const uint8_t *data, uint32_t leng
 #endif
 }
 
+static esp_err_t _i2s_lcd_write_async(void *handle, const uint8_t *data, uint32_t length, uint32_t flags, scr_interface_done_cb_t done_cb, void *user_ctx)
+{
+    /* the i2s driver swaps as configured and waits for the end of the transfer */
+    if (flags & SCR_IFACE_WRITE_PRESWAPPED) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    esp_err_t ret = _i2s_lcd_write(handle, data, length);
+    if (ESP_OK == ret && done_cb) {
+        done_cb(user_ctx);
+    }
+    return ret;
+}
+
+static esp_err_t _i2s_lcd_write_wait(void *handle)
+{
+    return ESP_OK;
+}
+
 static esp_err_t _i2s_lcd_read(void *handle, uint8_t *data, uint32_t length)
 {
     return ESP_ERR_NOT_SUPPORTED;
@@ -153,6 +171,20 @@ static esp_err_t i2c_lcd_write(void *handle, const uint8_t *data, uint32_t lengt
     return ESP_OK;
 }
 
+static esp_err_t i2c_lcd_write_async(void *handle, const uint8_t *data, uint32_t length, uint32_t flags, scr_interface_done_cb_t done_cb, void *user_ctx)
+{
+    esp_err_t ret = i2c_lcd_write(handle, data, length);
+    if (ESP_OK == ret && done_cb) {
+        done_cb(user_ctx);
+    }
+    return ret;
+}
+
+static esp_err_t i2c_lcd_write_wait(void *handle)
+{
+    return ESP_OK;
+}
+
 static esp_err_t i2c_lcd_read(void *handle, uint8_t *data, uint32_t length)
 {
     ESP_LOGW(TAG, "lcd i2c unsupport read");
@@ -173,13 +205,41 @@ static esp_err_t i2c_lcd_release(void *handle)
 #define LCD_CMD_LEV   (0)
 #define LCD_DATA_LEV  (1)
 
+/**
+ * Block writes are queued, up to SPI_LCD_QUEUE_SIZE transactions in flight. Data that has
+ * to be swapped is swapped chunk by chunk into two DMA buffers in turn, one is filled while
+ * the other is sent, so the data of the caller is never modified.
+ */
+#define SPI_LCD_QUEUE_SIZE   (3)
+#define SPI_LCD_BOUNCE_SIZE  (4096)     /*!< bytes of each of the two swap buffers */
+
+typedef struct {
+    spi_transaction_t trans;
+    scr_interface_done_cb_t done_cb;    /*!< only set on the last transaction of a write */
+    void *user_ctx;
+} spi_lcd_trans_t;
+
 typedef struct {
     spi_bus_device_handle_t spi_wr_dev;
     int8_t pin_num_dc;
     uint8_t swap_data;
+    uint8_t *bounce[2];
+    uint8_t bounce_next;
+    spi_lcd_trans_t trans[SPI_LCD_QUEUE_SIZE];
+    uint8_t trans_next;                 /*!< descriptors are used in turn */
+    uint8_t in_flight;                  /*!< queued transactions whose result is not fetched yet */
     scr_interface_driver_t interface_drv;
 } interface_spi_handle_t;
 
+static void IRAM_ATTR spi_lcd_post_cb(spi_transaction_t *trans)
+{
+    /* polling transactions of commands have no user */
+    spi_lcd_trans_t *lcd_trans = trans->user;
+    if (lcd_trans && lcd_trans->done_cb) {
+        lcd_trans->done_cb(lcd_trans->user_ctx);
+    }
+}
+
 static esp_err_t spi_lcd_driver_init(const scr_interface_spi_config_t *cfg, interface_spi_handle_t *out_interface_spi)
 {
     LCD_IFACE_CHECK(GPIO_IS_VALID_OUTPUT_GPIO(cfg->pin_num_cs), "gpio cs invalid", ESP_ERR_INVALID_ARG);
@@ -188,23 +248,108 @@ static esp_err_t spi_lcd_driver_init(const scr_interface_spi_config_t *cfg, inte
     //Initialize non-SPI GPIOs
     gpio_pad_select_gpio(cfg->pin_num_dc);
     gpio_set_direction(cfg->pin_num_dc, GPIO_MODE_OUTPUT);
+    memset(out_interface_spi, 0, sizeof(interface_spi_handle_t));
     out_interface_spi->pin_num_dc = cfg->pin_num_dc;
     out_interface_spi->swap_data = cfg->swap_data;
 
+    if (cfg->swap_data) {
+        for (int i = 0; i < 2; i++) {
+            out_interface_spi->bounce[i] = heap_caps_malloc(SPI_LCD_BOUNCE_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+            if (NULL == out_interface_spi->bounce[i]) {
+                heap_caps_free(out_interface_spi->bounce[0]);
+                LCD_IFACE_CHECK(0, "memory of swap buffer is not enough", ESP_ERR_NO_MEM);
+            }
+        }
+    }
+
     spi_device_config_t devcfg = {
         .clock_speed_hz = cfg->clk_freq,     //Clock out frequency
         .mode = 0,                           //SPI mode 0
         .cs_io_num = cfg->pin_num_cs,        //CS pin
+        .queue_size = SPI_LCD_QUEUE_SIZE,
+        .post_cb = spi_lcd_post_cb,
     };
     out_interface_spi->spi_wr_dev = spi_bus_device_create(cfg->spi_bus, &devcfg);
-    LCD_IFACE_CHECK(NULL != out_interface_spi->spi_wr_dev, "spi device initialize failed", ESP_FAIL);
+    if (NULL == out_interface_spi->spi_wr_dev) {
+        heap_caps_free(out_interface_spi->bounce[0]);
+        heap_caps_free(out_interface_spi->bounce[1]);
+        LCD_IFACE_CHECK(0, "spi device initialize failed", ESP_FAIL);
+    }
+
+    return ESP_OK;
+}
+
+/* fetch the results of queued transactions until at most `keep` are in flight */
+static esp_err_t spi_lcd_retire(interface_spi_handle_t *interface_spi, int keep)
+{
+    while (interface_spi->in_flight > keep) {
+        spi_transaction_t *trans;
+        esp_err_t ret = spi_bus_transmit_result(interface_spi->spi_wr_dev, &trans, portMAX_DELAY);
+        LCD_IFACE_CHECK(ESP_OK == ret, "Get transaction result failed", ret);
+        interface_spi->in_flight--;
+    }
+    return ESP_OK;
+}
 
+static esp_err_t spi_lcd_queue(interface_spi_handle_t *interface_spi, const uint8_t *data, uint32_t length,
+                               scr_interface_done_cb_t done_cb, void *user_ctx)
+{
+    /* the descriptor used SPI_LCD_QUEUE_SIZE writes ago must be free again */
+    esp_err_t ret = spi_lcd_retire(interface_spi, SPI_LCD_QUEUE_SIZE - 1);
+    if (ESP_OK != ret) {
+        return ret;
+    }
+    spi_lcd_trans_t *lcd_trans = &interface_spi->trans[interface_spi->trans_next];
+    interface_spi->trans_next = (interface_spi->trans_next + 1) % SPI_LCD_QUEUE_SIZE;
+    memset(&lcd_trans->trans, 0, sizeof(spi_transaction_t));
+    lcd_trans->trans.length = length * 8;
+    lcd_trans->trans.tx_buffer = data;
+    lcd_trans->trans.user = lcd_trans;
+    lcd_trans->done_cb = done_cb;
+    lcd_trans->user_ctx = user_ctx;
+    ret = spi_bus_transmit_queue(interface_spi->spi_wr_dev, &lcd_trans->trans, portMAX_DELAY);
+    LCD_IFACE_CHECK(ESP_OK == ret, "Queue data failed", ret);
+    interface_spi->in_flight++;
+    return ESP_OK;
+}
+
+/* swap the bytes of 16-bit data into the bounce buffers while the previous chunk is sent */
+static esp_err_t spi_lcd_queue_swapped(interface_spi_handle_t *interface_spi, const uint8_t *data, uint32_t length,
+                                       scr_interface_done_cb_t done_cb, void *user_ctx)
+{
+    while (length > 0) {
+        uint32_t chunk = length < SPI_LCD_BOUNCE_SIZE ? length : SPI_LCD_BOUNCE_SIZE;
+        /* only the chunk in the other buffer may still be in flight */
+        esp_err_t ret = spi_lcd_retire(interface_spi, 1);
+        if (ESP_OK != ret) {
+            return ret;
+        }
+        uint8_t *out = interface_spi->bounce[interface_spi->bounce_next];
+        interface_spi->bounce_next ^= 1;
+        uint32_t i;
+        for (i = 0; i + 1 < chunk; i += 2) {
+            out[i] = data[i + 1];
+            out[i + 1] = data[i];
+        }
+        if (i < chunk) {
+            out[i] = data[i];
+        }
+        data += chunk;
+        length -= chunk;
+        ret = spi_lcd_queue(interface_spi, out, chunk, length ? NULL : done_cb, user_ctx);
+        if (ESP_OK != ret) {
+            return ret;
+        }
+    }
     return ESP_OK;
 }
 
 static esp_err_t spi_lcd_driver_deinit(interface_spi_handle_t *interface_spi)
 {
+    spi_lcd_retire(interface_spi, 0);
     spi_bus_device_delete(&interface_spi->spi_wr_dev);
+    heap_caps_free(interface_spi->bounce[0]);
+    heap_caps_free(interface_spi->bounce[1]);
     return ESP_OK;
 }
 
@@ -227,7 +372,8 @@ static esp_err_t _lcd_spi_rw(spi_bus_device_handle_t spi, const uint8_t *output,
 static esp_err_t spi_lcd_driver_write_cmd(void *handle, uint16_t value)
 {
     interface_spi_handle_t *interface_spi = __containerof(handle, interface_spi_handle_t, interface_drv);
-    esp_err_t ret;
+    esp_err_t ret = spi_lcd_retire(interface_spi, 0);
+    LCD_IFACE_CHECK(ESP_OK == ret, "Wait for pending data failed", ESP_FAIL);
     gpio_set_level(interface_spi->pin_num_dc, LCD_CMD_LEV);
     uint8_t data = value;
     ret = _lcd_spi_rw(interface_spi->spi_wr_dev, &data, NULL, 1);
@@ -239,7 +385,8 @@ static esp_err_t spi_lcd_driver_write_cmd(void *handle, uint16_t value)
 static esp_err_t spi_lcd_driver_write_data(void *handle, uint16_t value)
 {
     interface_spi_handle_t *interface_spi = __containerof(handle, interface_spi_handle_t, interface_drv);
-    esp_err_t ret;
+    esp_err_t ret = spi_lcd_retire(interface_spi, 0);
+    LCD_IFACE_CHECK(ESP_OK == ret, "Wait for pending data failed", ESP_FAIL);
     uint8_t data = value;
     ret = _lcd_spi_rw(interface_spi->spi_wr_dev, &data, NULL, 1);
     LCD_IFACE_CHECK(ESP_OK == ret, "Send cmd failed", ESP_FAIL);
@@ -249,43 +396,47 @@ static esp_err_t spi_lcd_driver_write_data(void *handle, uint16_t value)
 static esp_err_t spi_lcd_driver_read(void *handle, uint8_t *data, uint32_t length)
 {
     interface_spi_handle_t *interface_spi = __containerof(handle, interface_spi_handle_t, interface_drv);
-    esp_err_t ret;
+    esp_err_t ret = spi_lcd_retire(interface_spi, 0);
+    LCD_IFACE_CHECK(ESP_OK == ret, "Wait for pending data failed", ESP_FAIL);
     ret = _lcd_spi_rw(interface_spi->spi_wr_dev, NULL, data, length);
     LCD_IFACE_CHECK(ESP_OK == ret, "Read data failed", ESP_FAIL);
     return ESP_OK;
 }
 
-static esp_err_t spi_lcd_driver_write(void *handle, const uint8_t *data, uint32_t length)
+static esp_err_t spi_lcd_driver_write_async(void *handle, const uint8_t *data, uint32_t length, uint32_t flags,
+        scr_interface_done_cb_t done_cb, void *user_ctx)
 {
     interface_spi_handle_t *interface_spi = __containerof(handle, interface_spi_handle_t, interface_drv);
+    LCD_IFACE_CHECK(0 != length, "Length should not be 0", ESP_ERR_INVALID_ARG);
     esp_err_t ret;
 
-    /**< Swap the high and low byte of the data */
-    uint32_t l = length / 2;
-    uint16_t t;
-    if (interface_spi->swap_data) {
-        uint16_t *p = (uint16_t *)data;
-        for (size_t i = 0; i < l; i++) {
-            t = *p;
-            *p = t >> 8 | t << 8;
-            p++;
-        }
+    if (interface_spi->swap_data && !(flags & SCR_IFACE_WRITE_PRESWAPPED)) {
+        ret = spi_lcd_queue_swapped(interface_spi, data, length, done_cb, user_ctx);
+    } else {
+        /* sent from the buffer of the caller */
+        ret = spi_lcd_queue(interface_spi, data, length, done_cb, user_ctx);
     }
-    ret = _lcd_spi_rw(interface_spi->spi_wr_dev, data, NULL, length);
-
-    /**
-     * @brief swap data to restore the order of data
-     *
-     * TODO: how to avoid swap data here
-     *
-     */
+    LCD_IFACE_CHECK(ESP_OK == ret, "Write data failed", ESP_FAIL);
+    return ESP_OK;
+}
+
+static esp_err_t spi_lcd_driver_write_wait(void *handle)
+{
+    interface_spi_handle_t *interface_spi = __containerof(handle, interface_spi_handle_t, interface_drv);
+    return spi_lcd_retire(interface_spi, 0);
+}
+
+static esp_err_t spi_lcd_driver_write(void *handle, const uint8_t *data, uint32_t length)
+{
+    interface_spi_handle_t *interface_spi = __containerof(handle, interface_spi_handle_t, interface_drv);
+    esp_err_t ret;
+
     if (interface_spi->swap_data) {
-        uint16_t *_p = (uint16_t *)data;
-        for (size_t i = 0; i < l; i++) {
-            t = *_p;
-            *_p = t >> 8 | t << 8;
-            _p++;
-        }
+        ret = spi_lcd_queue_swapped(interface_spi, data, length, NULL, NULL);
+        ret |= spi_lcd_retire(interface_spi, 0);
+    } else {
+        ret = spi_lcd_retire(interface_spi, 0);
+        ret |= _lcd_spi_rw(interface_spi->spi_wr_dev, data, NULL, length);
     }
     LCD_IFACE_CHECK(ESP_OK == ret, "Write data failed", ESP_FAIL);
     return ESP_OK;
@@ -313,6 +464,8 @@ esp_err_t scr_interface_create(scr_interface_type_t type, void *config, scr_inte
         interface_i2s->interface_drv.write_cmd   = _i2s_lcd_write_cmd;
         interface_i2s->interface_drv.write_data  = _i2s_lcd_write_data;
         interface_i2s->interface_drv.write       = _i2s_lcd_write;
+        interface_i2s->interface_drv.write_async = _i2s_lcd_write_async;
+        interface_i2s->interface_drv.write_wait  = _i2s_lcd_write_wait;
         interface_i2s->interface_drv.read        = _i2s_lcd_read;
         interface_i2s->interface_drv.bus_acquire = _i2s_lcd_acquire;
         interface_i2s->interface_drv.bus_release = _i2s_lcd_release;
@@ -336,6 +489,8 @@ esp_err_t scr_interface_create(scr_interface_type_t type, void *config, scr_inte
         interface_spi->interface_drv.write_cmd   = spi_lcd_driver_write_cmd;
         interface_spi->interface_drv.write_data  = spi_lcd_driver_write_data;
         interface_spi->interface_drv.write       = spi_lcd_driver_write;
+        interface_spi->interface_drv.write_async = spi_lcd_driver_write_async;
+        interface_spi->interface_drv.write_wait  = spi_lcd_driver_write_wait;
         interface_spi->interface_drv.read        = spi_lcd_driver_read;
         interface_spi->interface_drv.bus_acquire = spi_lcd_driver_acquire;
         interface_spi->interface_drv.bus_release = spi_lcd_driver_release;
@@ -357,6 +512,8 @@ esp_err_t scr_interface_create(scr_interface_type_t type, void *config, scr_inte
         interface_i2c->interface_drv.write_cmd   = i2c_lcd_write_cmd;
         interface_i2c->interface_drv.write_data  = i2c_lcd_write_data;
         interface_i2c->interface_drv.write       = i2c_lcd_write;
+        interface_i2c->interface_drv.write_async = i2c_lcd_write_async;
+        interface_i2c->interface_drv.write_wait  = i2c_lcd_write_wait;
         interface_i2c->interface_drv.read        = i2c_lcd_read;
         interface_i2c->interface_drv.bus_acquire = i2c_lcd_acquire;
         interface_i2c->interface_drv.bus_release = i2c_lcd_release;
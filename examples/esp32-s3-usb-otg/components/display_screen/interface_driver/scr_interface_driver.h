@@ -56,6 +56,13 @@ typedef enum {
     SCREEN_IFACE_SPI,            /*!< SPI interface */
 } scr_interface_type_t;
 
+#define SCR_IFACE_WRITE_PRESWAPPED  (1 << 0)   /*!< write_async flag: 16-bit data already in bus order, sent as it is even with swap_data */
+
+/**
+ * @brief Called when an asynchronous write is done, may be called from an ISR
+ */
+typedef void (*scr_interface_done_cb_t)(void *user_ctx);
+
 /**
  * @brief Define common function for screen interface driver
  * 
@@ -64,7 +71,14 @@ typedef struct {
     scr_interface_type_t type;                                                  /*!< Interface bus type, see scr_interface_type_t struct */
     esp_err_t (*write_cmd)(void *handle, uint16_t cmd);                         /*!< Function to write a command */
     esp_err_t (*write_data)(void *handle, uint16_t data);                       /*!< Function to write a data */
-    esp_err_t (*write)(void *handle, const uint8_t *data, uint32_t length);     /*!< Function to write a block data */
+    esp_err_t (*write)(void *handle, const uint8_t *data, uint32_t length);     /*!< Function to write a block data, the data is not modified */
+    /**
+     * Function to start writing a block data and return while it is sent. The data must stay
+     * valid until done_cb is called, unless the interface has to swap it (it is then copied
+     * before the function returns). Commands and other writes wait for the pending ones.
+     */
+    esp_err_t (*write_async)(void *handle, const uint8_t *data, uint32_t length, uint32_t flags, scr_interface_done_cb_t done_cb, void *user_ctx);
+    esp_err_t (*write_wait)(void *handle);                                      /*!< Function to wait until all asynchronous writes are sent */
     esp_err_t (*read)(void *handle, uint8_t *data, uint32_t length);            /*!< Function to read a block data */
     esp_err_t (*bus_acquire)(void *handle);                                     /*!< Function to acquire interface bus */
     esp_err_t (*bus_release)(void *handle);                                     /*!< Function to release interface bus */
@@ -266,6 +266,41 @@ typedef struct {
     */
     esp_err_t (*draw_bitmap)(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *bitmap);
 
+    /**
+    * @brief Fill the pixels on LCD screen with bitmap, without waiting for the transfer
+    *
+    * The transfer is queued on the interface and the function returns, so the next bitmap can
+    * be prepared while this one is on the bus. A bitmap starting on the row right below the
+    * previous one, with the same x and width, continues the window of the previous one and
+    * needs no window commands. Commands and other draws wait for the queued bitmaps first.
+    *
+    * @param x Starting point in X direction
+    * @param y Starting point in Y direction
+    * @param w width of image in bitmap array
+    * @param h height of image in bitmap array
+    * @param bitmap pointer to bitmap array, must stay valid and unchanged until done_cb is called
+    * @param done_cb Called when the bitmap has been sent, may be called from an ISR. NULL if not used
+    * @param user_ctx Argument of done_cb
+    *
+    * @note Screens whose controller or interface cannot queue transfers draw the bitmap
+    *       before returning and then call done_cb.
+    *
+    * @return
+    *      - ESP_OK on success
+    *      - ESP_ERR_INVALID_ARG The bitmap is not inside the screen
+    *      - ESP_FAIL Failed
+    */
+    esp_err_t (*draw_bitmap_async)(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *bitmap, scr_interface_done_cb_t done_cb, void *user_ctx);
+
+    /**
+    * @brief Wait until all bitmaps queued by draw_bitmap_async have been sent
+    *
+    * @return
+    *      - ESP_OK on success
+    *      - ESP_FAIL Failed
+    */
+    esp_err_t (*draw_wait)(void);
+
     /**
     * @brief Get screen information
     *
@@ -20,7 +20,8 @@ extern "C" {
 #endif
 
 /**< Define the function of interface instance */
-#define LCD_WRITE_CMD(cmd)      g_lcd_handle.interface_drv->write_cmd(g_lcd_handle.interface_drv, (cmd))
+/**< A command ends the window left open by draw_bitmap_async */
+#define LCD_WRITE_CMD(cmd)      (g_lcd_handle.window_open = false, g_lcd_handle.interface_drv->write_cmd(g_lcd_handle.interface_drv, (cmd)))
 #define LCD_WRITE_DATA(data)    g_lcd_handle.interface_drv->write_data(g_lcd_handle.interface_drv, (data))
 #define LCD_WRITE(data, length) g_lcd_handle.interface_drv->write(g_lcd_handle.interface_drv, (data), (length))
 #define LCD_READ(data, length)  g_lcd_handle.interface_drv->read(g_lcd_handle.interface_drv, (data), (length))
@@ -13,11 +13,18 @@
 // limitations under the License.
 
 #include "stdint.h"
+#include <string.h>
 #include "esp_log.h"
+#include "esp_heap_caps.h"
 #include "screen_utility.h"
 
 static const char *TAG = "screen utility";
 
+#define SCR_UTILITY_CHECK(a, str, ret)  if(!(a)) {                           \
+        ESP_LOGE(TAG,"%s:%d (%s):%s", __FILE__, __LINE__, __FUNCTION__, str);   \
+        return (ret);                                                           \
+    }
+
 void scr_utility_apply_offset(const scr_handle_t *lcd_handle, uint16_t res_hor, uint16_t res_ver, uint16_t *x0, uint16_t *y0, uint16_t *x1, uint16_t *y1)
 {
     scr_dir_t dir = lcd_handle->dir;
@@ -68,3 +75,201 @@ void scr_utility_apply_offset(const scr_handle_t *lcd_handle, uint16_t res_hor,
     *y1 += yoffset;
 }
 
+esp_err_t scr_utility_draw_bitmap_async(scr_handle_t *lcd_handle, scr_set_window_t set_window,
+                                        uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *bitmap,
+                                        scr_interface_done_cb_t done_cb, void *user_ctx)
+{
+    SCR_UTILITY_CHECK(NULL != bitmap, "bitmap pointer invalid", ESP_ERR_INVALID_ARG);
+    SCR_UTILITY_CHECK(0 != w && 0 != h && x + w <= lcd_handle->width && y + h <= lcd_handle->height,
+                      "The bitmap exceeds the screen size", ESP_ERR_INVALID_ARG);
+    scr_interface_driver_t *iface = lcd_handle->interface_drv;
+    esp_err_t ret = ESP_OK;
+
+    iface->bus_acquire(iface);
+    if (!(lcd_handle->window_open && x == lcd_handle->window_x && w == lcd_handle->window_w &&
+            y == lcd_handle->window_next_y)) {
+        ret = set_window(x, y, x + w - 1, lcd_handle->height - 1);
+        lcd_handle->window_open = (ESP_OK == ret);
+        lcd_handle->window_x = x;
+        lcd_handle->window_w = w;
+    }
+    if (ESP_OK == ret) {
+        if (NULL != iface->write_async) {
+            ret = iface->write_async(iface, (const uint8_t *)bitmap, 2 * w * h, 0, done_cb, user_ctx);
+        } else {
+            ret = iface->write(iface, (const uint8_t *)bitmap, 2 * w * h);
+            if (ESP_OK == ret && done_cb) {
+                done_cb(user_ctx);
+            }
+        }
+    }
+    iface->bus_release(iface);
+    if (ESP_OK != ret) {
+        /* the position in the window is not known anymore */
+        lcd_handle->window_open = false;
+        SCR_UTILITY_CHECK(0, "lcd write ram data failed", ESP_FAIL);
+    }
+    lcd_handle->window_next_y = y + h;
+    return ESP_OK;
+}
+
+esp_err_t scr_utility_draw_wait(scr_handle_t *lcd_handle)
+{
+    scr_interface_driver_t *iface = lcd_handle->interface_drv;
+    if (NULL == iface->write_wait) {
+        return ESP_OK;
+    }
+    return iface->write_wait(iface);
+}
+
+esp_err_t scr_shadow_init(scr_shadow_t *shadow, uint16_t rows, uint16_t units, uint8_t unit_bytes, uint16_t window_cost)
+{
+    uint32_t size = rows * units * unit_bytes;
+    memset(shadow, 0, sizeof(scr_shadow_t));
+    shadow->gram = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    shadow->tx = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    shadow->known = heap_caps_calloc(1, (rows * units + 7) / 8, MALLOC_CAP_8BIT);
+    if (NULL == shadow->gram || NULL == shadow->tx || NULL == shadow->known) {
+        scr_shadow_deinit(shadow);
+        SCR_UTILITY_CHECK(0, "memory of gram copy is not enough", ESP_ERR_NO_MEM);
+    }
+    shadow->rows = rows;
+    shadow->units = units;
+    shadow->unit_bytes = unit_bytes;
+    shadow->window_cost = window_cost;
+    return ESP_OK;
+}
+
+void scr_shadow_deinit(scr_shadow_t *shadow)
+{
+    heap_caps_free(shadow->gram);
+    heap_caps_free(shadow->tx);
+    heap_caps_free(shadow->known);
+    memset(shadow, 0, sizeof(scr_shadow_t));
+}
+
+void scr_shadow_invalidate(scr_shadow_t *shadow)
+{
+    if (shadow->known) {
+        memset(shadow->known, 0, (shadow->rows * shadow->units + 7) / 8);
+    }
+}
+
+#define SCR_SHADOW_RUNS     8   /*!< changed runs kept per row, more are joined */
+#define SCR_SHADOW_PENDING  4   /*!< windows growing down at the same time */
+
+typedef struct {
+    uint16_t u0, u1;
+    uint16_t r0, r1;
+} scr_shadow_rect_t;
+
+static esp_err_t scr_shadow_send_rect(scr_shadow_t *shadow, const scr_shadow_rect_t *rect, scr_shadow_send_t send)
+{
+    uint32_t line = (rect->u1 - rect->u0 + 1) * shadow->unit_bytes;
+    const uint8_t *data = shadow->gram + (rect->r0 * shadow->units + rect->u0) * shadow->unit_bytes;
+    if (rect->r0 != rect->r1 && line != shadow->units * shadow->unit_bytes) {
+        /* the rows of a window narrower than the panel are not next to each other in the copy */
+        for (uint16_t r = rect->r0; r <= rect->r1; r++) {
+            memcpy(shadow->tx + (r - rect->r0) * line, shadow->gram + (r * shadow->units + rect->u0) * shadow->unit_bytes, line);
+        }
+        data = shadow->tx;
+    }
+    return send(rect->u0, rect->r0, rect->u1, rect->r1, data, line * (rect->r1 - rect->r0 + 1));
+}
+
+esp_err_t scr_shadow_update(scr_shadow_t *shadow, uint16_t unit0, uint16_t row0, uint16_t units, uint16_t rows,
+                            const uint8_t *data, scr_shadow_send_t send)
+{
+    SCR_UTILITY_CHECK(unit0 + units <= shadow->units && row0 + rows <= shadow->rows, "Rectangle exceeds the gram", ESP_ERR_INVALID_ARG);
+    const uint8_t ub = shadow->unit_bytes;
+    const uint32_t gap_units = shadow->window_cost / ub;
+    scr_shadow_rect_t pending[SCR_SHADOW_PENDING];
+    scr_shadow_rect_t runs[SCR_SHADOW_RUNS];
+    int n_pending = 0;
+    esp_err_t ret = ESP_OK;
+
+    for (uint16_t r = row0; r < row0 + rows && ESP_OK == ret; r++) {
+        const uint8_t *src = data + (r - row0) * units * ub;
+        uint8_t *dst = shadow->gram + (r * shadow->units + unit0) * ub;
+        uint32_t bit = r * shadow->units + unit0;
+
+        /* runs of changed units, short unchanged gaps are cheaper to send than a new window */
+        int n_runs = 0;
+        for (uint16_t i = 0; i < units; i++) {
+            uint32_t b = bit + i;
+            if ((shadow->known[b >> 3] & (1 << (b & 7))) && 0 == memcmp(src + i * ub, dst + i * ub, ub)) {
+                continue;
+            }
+            if (n_runs && (i - runs[n_runs - 1].u1 - 1 <= gap_units || SCR_SHADOW_RUNS == n_runs)) {
+                runs[n_runs - 1].u1 = i;
+            } else {
+                runs[n_runs].u0 = runs[n_runs].u1 = i;
+                runs[n_runs].r0 = runs[n_runs].r1 = r;
+                n_runs++;
+            }
+        }
+        for (int k = 0; k < n_runs; k++) {
+            runs[k].u0 += unit0;
+            runs[k].u1 += unit0;
+        }
+
+        /* every unit of the row is sent below if it differs, so all of them are known afterwards */
+        memcpy(dst, src, units * ub);
+        for (uint16_t i = 0; i < units; i++) {
+            shadow->known[(bit + i) >> 3] |= 1 << ((bit + i) & 7);
+        }
+
+        /* grow the windows of the row above when the bytes sent in addition cost less than a window */
+        for (int k = 0; k < n_runs && ESP_OK == ret; k++) {
+            scr_shadow_rect_t *run = &runs[k];
+            int merged = 0;
+            for (int p = 0; p < n_pending; p++) {
+                scr_shadow_rect_t *rect = &pending[p];
+                if (rect->r1 + 1 != r) {
+                    continue;
+                }
+                uint32_t u0 = rect->u0 < run->u0 ? rect->u0 : run->u0;
+                uint32_t u1 = rect->u1 > run->u1 ? rect->u1 : run->u1;
+                uint32_t h = rect->r1 - rect->r0 + 1;
+                uint32_t area = (u1 - u0 + 1) * (h + 1);
+                uint32_t apart = (rect->u1 - rect->u0 + 1) * h + (run->u1 - run->u0 + 1);
+                if ((area - apart) * ub <= shadow->window_cost) {
+                    rect->u0 = u0;
+                    rect->u1 = u1;
+                    rect->r1 = r;
+                    merged = 1;
+                    break;
+                }
+            }
+            if (merged) {
+                continue;
+            }
+            if (SCR_SHADOW_PENDING == n_pending) {
+                /* no room, the oldest window is sent as it is */
+                ret = scr_shadow_send_rect(shadow, &pending[0], send);
+                memmove(&pending[0], &pending[1], (SCR_SHADOW_PENDING - 1) * sizeof(scr_shadow_rect_t));
+                n_pending--;
+            }
+            pending[n_pending++] = *run;
+        }
+
+        /* windows that did not grow into this row are complete */
+        for (int p = 0; p < n_pending && ESP_OK == ret;) {
+            if (pending[p].r1 != r) {
+                ret = scr_shadow_send_rect(shadow, &pending[p], send);
+                pending[p] = pending[--n_pending];
+            } else {
+                p++;
+            }
+        }
+    }
+    for (int p = 0; p < n_pending && ESP_OK == ret; p++) {
+        ret = scr_shadow_send_rect(shadow, &pending[p], send);
+    }
+    if (ESP_OK != ret) {
+        /* what reached the panel is not known */
+        scr_shadow_invalidate(shadow);
+        SCR_UTILITY_CHECK(0, "Send gram failed", ESP_FAIL);
+    }
+    return ESP_OK;
+}
@@ -34,10 +34,89 @@ typedef struct {
     uint16_t offset_hor;
     uint16_t offset_ver;
     scr_dir_t dir;
+    bool window_open;        /*!< the window set by draw_bitmap_async is still receiving data */
+    uint16_t window_x;       /*!< column of the open window */
+    uint16_t window_w;       /*!< width of the open window */
+    uint16_t window_next_y;  /*!< row the next pixel of the open window goes to */
 } scr_handle_t;
 
+typedef esp_err_t (*scr_set_window_t)(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
+
+/**
+ * @brief Copy of the GRAM of a controller whose windows are set in whole bytes,
+ *        such as the pages of 1-bit OLEDs
+ *
+ * A row is a page (8 lines) of a 1-bit controller or a line of a gray one, a unit is the
+ * smallest column step of a window. Only the units that differ from what the panel holds
+ * are sent, grouped into as few windows as pays off.
+ */
+typedef struct {
+    uint8_t *gram;           /*!< what the panel holds, rows * units * unit_bytes */
+    uint8_t *known;          /*!< one bit per unit, set once the unit has been written to the panel */
+    uint8_t *tx;             /*!< a window of several rows being sent */
+    uint16_t rows;
+    uint16_t units;
+    uint8_t unit_bytes;      /*!< bytes of one unit in one row */
+    uint16_t window_cost;    /*!< bytes on the bus to open a window, unchanged bytes up to this are sent rather than opening another */
+} scr_shadow_t;
+
+/**
+ * @brief Set a window of units and rows and write its data, the data is row by row
+ */
+typedef esp_err_t (*scr_shadow_send_t)(uint16_t unit0, uint16_t row0, uint16_t unit1, uint16_t row1, const uint8_t *data, uint32_t length);
+
 void scr_utility_apply_offset(const scr_handle_t *lcd_handle, uint16_t res_hor, uint16_t res_ver, uint16_t *x0, uint16_t *y0, uint16_t *x1, uint16_t *y1);
 
+/**
+ * @brief Queue a RGB565 bitmap on the interface, for the draw_bitmap_async of controllers
+ *        whose set_window ends with the memory write command
+ *
+ * The window is set down to the last row of the screen, so that a following bitmap on the
+ * next rows with the same x and width only has to send its pixels. Any command sent with
+ * LCD_WRITE_CMD closes the window.
+ */
+esp_err_t scr_utility_draw_bitmap_async(scr_handle_t *lcd_handle, scr_set_window_t set_window,
+                                        uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *bitmap,
+                                        scr_interface_done_cb_t done_cb, void *user_ctx);
+
+/**
+ * @brief Wait for the bitmaps queued by scr_utility_draw_bitmap_async
+ */
+esp_err_t scr_utility_draw_wait(scr_handle_t *lcd_handle);
+
+/**
+ * @brief Allocate the copy of the GRAM, nothing of the panel is known until it has been written
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_NO_MEM Not enough memory
+ */
+esp_err_t scr_shadow_init(scr_shadow_t *shadow, uint16_t rows, uint16_t units, uint8_t unit_bytes, uint16_t window_cost);
+
+void scr_shadow_deinit(scr_shadow_t *shadow);
+
+/**
+ * @brief Forget what the panel holds, the next update of each area is sent in full
+ */
+void scr_shadow_invalidate(scr_shadow_t *shadow);
+
+/**
+ * @brief Send the changes of a rectangle of the panel
+ *
+ * @param unit0 First unit of the rectangle
+ * @param row0 First row of the rectangle
+ * @param units Width of the rectangle
+ * @param rows Height of the rectangle
+ * @param data New content, row by row, as the controller takes it
+ * @param send Sends one window to the panel
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_FAIL Sending failed, the whole copy is invalidated
+ */
+esp_err_t scr_shadow_update(scr_shadow_t *shadow, uint16_t unit0, uint16_t row0, uint16_t units, uint16_t rows,
+                            const uint8_t *data, scr_shadow_send_t send);
+
 #ifdef __cplusplus
 }
 #endif
@@ -309,6 +309,58 @@ static void lcd_speed_test(scr_driver_t *lcd)
     heap_caps_free(pixels);
 }
 
+static volatile uint32_t s_async_done[2];
+
+static void lcd_async_done(void *user_ctx)
+{
+    s_async_done[(uint32_t)user_ctx]++;
+}
+
+static void lcd_async_test(scr_driver_t *lcd)
+{
+    scr_info_t lcd_info;
+    TEST_ASSERT(ESP_OK == lcd->get_info(&lcd_info));
+
+    /* two stripe buffers in turn, one is filled while the other is on the bus */
+    const uint32_t rows = 16;
+    uint16_t *stripes[2];
+    for (int i = 0; i < 2; i++) {
+        stripes[i] = heap_caps_malloc(lcd_info.width * rows * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        TEST_ASSERT_NOT_NULL(stripes[i]);
+    }
+
+    const uint16_t color_table[] = {COLOR_RED, COLOR_GREEN, COLOR_BLUE, COLOR_YELLOW};
+    uint32_t times = 32, queued[2] = {0};
+    s_async_done[0] = s_async_done[1] = 0;
+
+    uint64_t s = esp_timer_get_time();
+    for (int i = 0; i < times; i++) {
+        for (uint32_t y = 0; y < lcd_info.height; y += rows) {
+            uint32_t b = (y / rows) & 1;
+            uint32_t h = lcd_info.height - y < rows ? lcd_info.height - y : rows;
+            while (s_async_done[b] != queued[b]) {
+                vTaskDelay(1);
+            }
+            for (int j = 0; j < lcd_info.width * h; j++) {
+                stripes[b][j] = color_table[(i + b) % 4];
+            }
+            TEST_ASSERT(ESP_OK == lcd->draw_bitmap_async(0, y, lcd_info.width, h, stripes[b], lcd_async_done, (void *)b));
+            queued[b]++;
+        }
+    }
+    TEST_ASSERT(ESP_OK == lcd->draw_wait());
+    uint64_t t = esp_timer_get_time() - s;
+    TEST_ASSERT_EQUAL_UINT32(queued[0], s_async_done[0]);
+    TEST_ASSERT_EQUAL_UINT32(queued[1], s_async_done[1]);
+    ESP_LOGI(TAG, "%s async stripes: %.2fMS per frame", lcd_info.name, (float)t / 1000.f / times);
+
+    /* a synchronous draw after queued ones */
+    screen_clear(lcd, COLOR_WHITE);
+
+    heap_caps_free(stripes[0]);
+    heap_caps_free(stripes[1]);
+}
+
 static scr_interface_driver_t *get_8080_iface(void)
 {
     i2s_lcd_config_t i2s_lcd_cfg = {
@@ -348,6 +400,7 @@ static void lcd_colorful_test_all(scr_driver_t *lcd)
     lcd_rotate_pixel_test(lcd);
     lcd_rotate_bitmap_test(lcd);
     lcd_speed_test(lcd);
+    lcd_async_test(lcd);
 }
 
 TEST_CASE("Screen ILI9806 8080 test", "[screen][iot]")